@@ -0,0 +1,409 @@
+/****************************************************************************
+ * apps/aiobench/aiobench_main.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sched.h>
+#include <time.h>
+#include <aio.h>
+#include <errno.h>
+
+#include <nuttx/arch.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_EXAMPLES_AIOBENCH_PATH
+#  define CONFIG_EXAMPLES_AIOBENCH_PATH "/mnt/aiobench.dat"
+#endif
+
+#ifndef CONFIG_EXAMPLES_AIOBENCH_ROUNDS
+#  define CONFIG_EXAMPLES_AIOBENCH_ROUNDS 2000
+#endif
+
+#define ROUNDS      CONFIG_EXAMPLES_AIOBENCH_ROUNDS
+
+/* The file is read as NREQUESTS requests of REQSIZE bytes */
+
+#define NREQUESTS   64
+#define REQSIZE     512
+#define FILESIZE    (NREQUESTS * REQSIZE)
+
+/* The number of entries in the completion ring (a power of two) */
+
+#define RINGSIZE    128
+
+/* The priority of the benchmark while it polls the completion ring.  It
+ * must be below that of the low priority work queue that performs the
+ * batch.
+ */
+
+#define POLLPRIORITY 10
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+enum aiobench_method_e
+{
+  AIOBENCH_AIOREAD = 0,          /* aio_read() per request */
+  AIOBENCH_LISTIO,               /* lio_listio(), in reverse order */
+  AIOBENCH_SCATTER,              /* lio_listio(), scattered buffers */
+  AIOBENCH_RING,                 /* aio_submit() and a completion ring */
+  AIOBENCH_NMETHODS
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static FAR const char *g_methodname[AIOBENCH_NMETHODS] =
+{
+  "aio_read+aio_suspend",
+  "lio_listio",
+  "lio_listio scattered",
+  "aio_submit+ring"
+};
+
+static uint8_t g_buffer[2 * FILESIZE];
+static struct aiocb g_aiocb[NREQUESTS];
+static FAR struct aiocb *g_list[NREQUESTS];
+static FAR struct aiocb *g_entries[RINGSIZE];
+static struct aio_ring_s g_ring;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: aiobench_gettime and aiobench_getfreq
+ *
+ * Description:
+ *   Return a free-running time stamp and its frequency.  Use the high
+ *   resolution counter if there is one:  The system timer may not advance
+ *   while the benchmark keeps the CPU busy (as in the simulation).
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_TIMESTATS
+#  define aiobench_gettime() up_perf_gettime()
+#  define aiobench_getfreq() up_perf_getfreq()
+#else
+static uint32_t aiobench_gettime(void)
+{
+  struct timespec ts;
+
+  (void)clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+#  define aiobench_getfreq() 1000000
+#endif
+
+/****************************************************************************
+ * Name: aiobench_pattern
+ ****************************************************************************/
+
+static inline uint8_t aiobench_pattern(int offset)
+{
+  return (uint8_t)(offset * 7 + 3);
+}
+
+/****************************************************************************
+ * Name: aiobench_setup
+ *
+ * Description:
+ *   Prepare one read request for each REQSIZE bytes of the file.  The
+ *   buffer of request 'i' is at 'i * stride' in g_buffer.  If 'reverse' is
+ *   true, the requests are listed from the end of the file to the start.
+ *
+ ****************************************************************************/
+
+static void aiobench_setup(int fd, int opcode, int stride, bool reverse)
+{
+  FAR struct aiocb *aiocbp;
+  int i;
+
+  for (i = 0; i < NREQUESTS; i++)
+    {
+      aiocbp = &g_aiocb[i];
+      memset(aiocbp, 0, sizeof(struct aiocb));
+
+      aiocbp->aio_fildes                = fd;
+      aiocbp->aio_buf                   = &g_buffer[i * stride];
+      aiocbp->aio_nbytes                = REQSIZE;
+      aiocbp->aio_offset                = i * REQSIZE;
+      aiocbp->aio_lio_opcode            = opcode;
+      aiocbp->aio_sigevent.sigev_notify = SIGEV_NONE;
+
+      g_list[reverse ? NREQUESTS - 1 - i : i] = aiocbp;
+    }
+}
+
+/****************************************************************************
+ * Name: aiobench_verify
+ *
+ * Description:
+ *   Return the number of requests that failed or that did not read the
+ *   expected data.
+ *
+ ****************************************************************************/
+
+static int aiobench_verify(int stride)
+{
+  int nbad = 0;
+  int i;
+  int j;
+
+  for (i = 0; i < NREQUESTS; i++)
+    {
+      if (aio_return(&g_aiocb[i]) != REQSIZE)
+        {
+          nbad++;
+          continue;
+        }
+
+      for (j = 0; j < REQSIZE; j++)
+        {
+          if (g_buffer[i * stride + j] != aiobench_pattern(i * REQSIZE + j))
+            {
+              nbad++;
+              break;
+            }
+        }
+    }
+
+  return nbad;
+}
+
+/****************************************************************************
+ * Name: aiobench_waitall
+ ****************************************************************************/
+
+static void aiobench_waitall(void)
+{
+  FAR const struct aiocb *list[1];
+  int i;
+
+  for (i = 0; i < NREQUESTS; i++)
+    {
+      list[0] = &g_aiocb[i];
+      while (aio_error(&g_aiocb[i]) == EINPROGRESS)
+        {
+          (void)aio_suspend(list, 1, NULL);
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: aiobench_round
+ *
+ * Description:
+ *   Read the whole file once with the selected method.  Return the number
+ *   of bad requests if 'verify' is true, zero if it is not, or a negated
+ *   errno value if the requests could not be submitted.
+ *
+ ****************************************************************************/
+
+static int aiobench_round(int fd, enum aiobench_method_e method,
+                          bool verify)
+{
+  int stride = method == AIOBENCH_SCATTER ? 2 * REQSIZE : REQSIZE;
+  int ncompleted;
+  int i;
+
+  memset(g_buffer, 0, sizeof(g_buffer));
+  aiobench_setup(fd, LIO_READ, stride, method == AIOBENCH_LISTIO);
+
+  switch (method)
+    {
+      case AIOBENCH_AIOREAD:
+        for (i = 0; i < NREQUESTS; i++)
+          {
+            if (aio_read(&g_aiocb[i]) < 0)
+              {
+                return -errno;
+              }
+          }
+
+        aiobench_waitall();
+        break;
+
+      case AIOBENCH_LISTIO:
+      case AIOBENCH_SCATTER:
+        if (lio_listio(LIO_WAIT, g_list, NREQUESTS, NULL) < 0)
+          {
+            return -errno;
+          }
+        break;
+
+      case AIOBENCH_RING:
+        if (aio_submit(g_list, NREQUESTS, &g_ring) != NREQUESTS)
+          {
+            return -errno;
+          }
+
+        for (ncompleted = 0; ncompleted < NREQUESTS; )
+          {
+            while (g_ring.tail != g_ring.head)
+              {
+                g_ring.tail++;
+                ncompleted++;
+              }
+          }
+        break;
+
+      default:
+        return -EINVAL;
+    }
+
+  return verify ? aiobench_verify(stride) : 0;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * aiobench_main
+ ****************************************************************************/
+
+#ifdef CONFIG_BUILD_KERNEL
+int main(int argc, FAR char *argv[])
+#else
+int aiobench_main(int argc, char *argv[])
+#endif
+{
+  FAR const char *path = CONFIG_EXAMPLES_AIOBENCH_PATH;
+  struct sched_param oldparam;
+  struct sched_param param;
+  enum aiobench_method_e method;
+  uint64_t elapsed;
+  uint32_t start;
+  int nbad = 0;
+  int ret;
+  int fd;
+  int i;
+
+  if (argc > 1)
+    {
+      path = argv[1];
+    }
+
+  fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    {
+      printf("ERROR: Failed to open %s: %d\n", path, errno);
+      return EXIT_FAILURE;
+    }
+
+  for (i = 0; i < FILESIZE; i++)
+    {
+      g_buffer[i] = aiobench_pattern(i);
+    }
+
+  if (write(fd, g_buffer, FILESIZE) != FILESIZE)
+    {
+      printf("ERROR: Failed to write %s: %d\n", path, errno);
+      goto errout_with_fd;
+    }
+
+  g_ring.entries = g_entries;
+  g_ring.mask    = RINGSIZE - 1;
+
+  (void)sched_getparam(0, &oldparam);
+
+  printf("%s: %d rounds of %d x %d byte reads\n",
+         path, ROUNDS, NREQUESTS, REQSIZE);
+
+  for (method = 0; method < AIOBENCH_NMETHODS; method++)
+    {
+      /* Polling the ring must not keep the worker from running */
+
+      if (method == AIOBENCH_RING)
+        {
+          param.sched_priority = POLLPRIORITY;
+          (void)sched_setparam(0, &param);
+        }
+
+      start = aiobench_gettime();
+      for (i = 0; i < ROUNDS; i++)
+        {
+          ret = aiobench_round(fd, method, i == 0 || i == ROUNDS - 1);
+          if (ret != 0)
+            {
+              printf("ERROR: %s round %d: %d\n",
+                     g_methodname[method], i, ret);
+              nbad++;
+              break;
+            }
+        }
+
+      elapsed = (uint64_t)(uint32_t)(aiobench_gettime() - start) * 1000 /
+                aiobench_getfreq();
+
+      (void)sched_setparam(0, &oldparam);
+
+      printf("  %-22s %8lu msec\n", g_methodname[method],
+             (unsigned long)elapsed);
+    }
+
+  if (g_ring.overflow > 0)
+    {
+      printf("ERROR: %lu completions lost\n",
+             (unsigned long)g_ring.overflow);
+      nbad++;
+    }
+
+  (void)close(fd);
+  return nbad > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+
+errout_with_fd:
+  (void)close(fd);
+  return EXIT_FAILURE;
+}
@@ -0,0 +1,476 @@
+/****************************************************************************
+ * apps/ftlbench/ftlbench_main.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <errno.h>
+
+#include <nuttx/arch.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/fs/ioctl.h>
+#include <nuttx/mtd/mtd.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_EXAMPLES_FTLBENCH_NEBLOCKS
+#  define CONFIG_EXAMPLES_FTLBENCH_NEBLOCKS 256
+#endif
+
+#ifndef CONFIG_EXAMPLES_FTLBENCH_NWRITES
+#  define CONFIG_EXAMPLES_FTLBENCH_NWRITES 40000
+#endif
+
+#define NEBLOCKS   CONFIG_EXAMPLES_FTLBENCH_NEBLOCKS
+#define NWRITES    CONFIG_EXAMPLES_FTLBENCH_NWRITES
+#define FLASHSIZE  (NEBLOCKS * CONFIG_RAMMTD_ERASESIZE)
+#define SECTORSIZE CONFIG_RAMMTD_BLOCKSIZE
+
+/* The number of sectors written after the benchmark and then flushed to
+ * FLASH before the FTL is re-initialized.
+ */
+
+#define NFLUSHED   8
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static int ftlbench_erase(FAR struct mtd_dev_s *dev, off_t startblock,
+                          size_t nblocks);
+static ssize_t ftlbench_bread(FAR struct mtd_dev_s *dev, off_t startblock,
+                              size_t nblocks, FAR uint8_t *buf);
+static ssize_t ftlbench_bwrite(FAR struct mtd_dev_s *dev, off_t startblock,
+                               size_t nblocks, FAR const uint8_t *buf);
+static ssize_t ftlbench_read(FAR struct mtd_dev_s *dev, off_t offset,
+                             size_t nbytes, FAR uint8_t *buffer);
+static int ftlbench_ioctl(FAR struct mtd_dev_s *dev, int cmd,
+                          unsigned long arg);
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* The RAM MTD device and a wrapper around it that counts the operations */
+
+static FAR struct mtd_dev_s *g_rammtd;
+static struct mtd_dev_s g_counting;
+
+static unsigned long g_nwritten;   /* Pages written */
+static unsigned long g_nread;      /* Pages read */
+static unsigned long g_nerased;    /* Blocks erased */
+static unsigned int g_erasecount[NEBLOCKS];
+
+/* The number of times each sector has been written */
+
+static FAR uint32_t *g_generation;
+
+static uint8_t g_buffer[SECTORSIZE];
+static uint8_t g_expected[SECTORSIZE];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static int ftlbench_erase(FAR struct mtd_dev_s *dev, off_t startblock,
+                          size_t nblocks)
+{
+  size_t i;
+
+  for (i = 0; i < nblocks; i++)
+    {
+      g_erasecount[startblock + i]++;
+    }
+
+  g_nerased += nblocks;
+  return MTD_ERASE(g_rammtd, startblock, nblocks);
+}
+
+static ssize_t ftlbench_bread(FAR struct mtd_dev_s *dev, off_t startblock,
+                              size_t nblocks, FAR uint8_t *buf)
+{
+  g_nread += nblocks;
+  return MTD_BREAD(g_rammtd, startblock, nblocks, buf);
+}
+
+static ssize_t ftlbench_bwrite(FAR struct mtd_dev_s *dev, off_t startblock,
+                               size_t nblocks, FAR const uint8_t *buf)
+{
+  g_nwritten += nblocks;
+  return MTD_BWRITE(g_rammtd, startblock, nblocks, buf);
+}
+
+static ssize_t ftlbench_read(FAR struct mtd_dev_s *dev, off_t offset,
+                             size_t nbytes, FAR uint8_t *buffer)
+{
+  return MTD_READ(g_rammtd, offset, nbytes, buffer);
+}
+
+static int ftlbench_ioctl(FAR struct mtd_dev_s *dev, int cmd,
+                          unsigned long arg)
+{
+  return MTD_IOCTL(g_rammtd, cmd, arg);
+}
+
+/****************************************************************************
+ * Name: ftlbench_gettime and ftlbench_getfreq
+ *
+ * Description:
+ *   Return a free-running time stamp and its frequency.  Use the high
+ *   resolution counter if there is one:  The system timer may not advance
+ *   while the benchmark keeps the CPU busy (as in the simulation).
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_TIMESTATS
+#  define ftlbench_gettime() up_perf_gettime()
+#  define ftlbench_getfreq() up_perf_getfreq()
+#else
+static uint32_t ftlbench_gettime(void)
+{
+  struct timespec ts;
+
+  (void)clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+#  define ftlbench_getfreq() 1000000
+#endif
+
+/****************************************************************************
+ * Name: ftlbench_fill
+ *
+ * Description:
+ *   Fill a buffer with a pattern that is unique to the sector and to the
+ *   number of times that it has been written.
+ *
+ ****************************************************************************/
+
+static void ftlbench_fill(FAR uint8_t *buffer, uint32_t sector)
+{
+  FAR uint32_t *ptr = (FAR uint32_t *)buffer;
+  uint32_t seed = sector * 2654435761u ^ g_generation[sector];
+  int i;
+
+  for (i = 0; i < SECTORSIZE / 4; i++)
+    {
+      ptr[i] = seed ^ i;
+    }
+}
+
+/****************************************************************************
+ * Name: ftlbench_write
+ ****************************************************************************/
+
+static int ftlbench_write(FAR struct inode *inode, uint32_t sector)
+{
+  ssize_t nwritten;
+
+  ftlbench_fill(g_buffer, sector);
+  nwritten = inode->u.i_bops->write(inode, g_buffer, sector, 1);
+  if (nwritten != 1)
+    {
+      printf("ERROR: Write of sector %lu failed: %ld\n",
+             (unsigned long)sector, (long)nwritten);
+      return nwritten < 0 ? (int)nwritten : -EIO;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: ftlbench_verify
+ *
+ * Description:
+ *   Read back all sectors and return the number that do not hold the data
+ *   last written to them.
+ *
+ ****************************************************************************/
+
+static int ftlbench_verify(FAR struct inode *inode, uint32_t nsectors)
+{
+  uint32_t sector;
+  int nbad = 0;
+
+  for (sector = 0; sector < nsectors; sector++)
+    {
+      ftlbench_fill(g_expected, sector);
+      if (inode->u.i_bops->read(inode, g_buffer, sector, 1) != 1 ||
+          memcmp(g_buffer, g_expected, SECTORSIZE) != 0)
+        {
+          if (nbad++ < 5)
+            {
+              printf("ERROR: Sector %lu does not match\n",
+                     (unsigned long)sector);
+            }
+        }
+    }
+
+  return nbad;
+}
+
+/****************************************************************************
+ * Name: ftlbench_open
+ *
+ * Description:
+ *   Create an FTL on top of the counting MTD wrapper and open it.
+ *
+ ****************************************************************************/
+
+static int ftlbench_open(int minor, FAR struct inode **inode)
+{
+  char devname[16];
+  int ret;
+
+  ret = ftl_initialize(minor, &g_counting);
+  if (ret < 0)
+    {
+      printf("ERROR: ftl_initialize failed: %d\n", ret);
+      return ret;
+    }
+
+  snprintf(devname, 16, "/dev/mtdblock%d", minor);
+  ret = open_blockdriver(devname, 0, inode);
+  if (ret < 0)
+    {
+      printf("ERROR: open_blockdriver(%s) failed: %d\n", devname, ret);
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * ftlbench_main
+ ****************************************************************************/
+
+#ifdef CONFIG_BUILD_KERNEL
+int main(int argc, FAR char *argv[])
+#else
+int ftlbench_main(int argc, char *argv[])
+#endif
+{
+  FAR struct inode *inode;
+  FAR uint8_t *flash;
+  struct geometry geo;
+  unsigned long elapsed;
+  uint32_t start;
+  unsigned int minerase;
+  unsigned int maxerase;
+  uint32_t nsectors;
+  uint32_t sector;
+  uint32_t seed;
+  int nbad;
+  int ret;
+  int i;
+
+  flash = (FAR uint8_t *)malloc(FLASHSIZE);
+  if (flash == NULL)
+    {
+      printf("ERROR: Failed to allocate %d bytes of FLASH\n", FLASHSIZE);
+      return EXIT_FAILURE;
+    }
+
+  g_rammtd = rammtd_initialize(flash, FLASHSIZE);
+  if (g_rammtd == NULL)
+    {
+      printf("ERROR: rammtd_initialize failed\n");
+      goto errout_with_flash;
+    }
+
+  (void)MTD_ERASE(g_rammtd, 0, NEBLOCKS);
+
+  g_counting.erase  = ftlbench_erase;
+  g_counting.bread  = ftlbench_bread;
+  g_counting.bwrite = ftlbench_bwrite;
+  g_counting.read   = ftlbench_read;
+  g_counting.ioctl  = ftlbench_ioctl;
+
+  ret = ftlbench_open(0, &inode);
+  if (ret < 0)
+    {
+      goto errout_with_flash;
+    }
+
+  ret = inode->u.i_bops->geometry(inode, &geo);
+  if (ret < 0)
+    {
+      printf("ERROR: geometry failed: %d\n", ret);
+      goto errout_with_inode;
+    }
+
+  nsectors     = geo.geo_nsectors;
+  g_generation = (FAR uint32_t *)zalloc(nsectors * sizeof(uint32_t));
+  if (g_generation == NULL)
+    {
+      printf("ERROR: Failed to allocate the generation map\n");
+      goto errout_with_inode;
+    }
+
+  printf("%lu sectors of %d bytes (%lu%% of the FLASH)\n",
+         (unsigned long)nsectors, SECTORSIZE,
+         (unsigned long)nsectors * 100 / (FLASHSIZE / SECTORSIZE));
+
+  /* Fill the device so that every write below overwrites live data */
+
+  for (sector = 0; sector < nsectors; sector++)
+    {
+      if (ftlbench_write(inode, sector) < 0)
+        {
+          goto errout_with_generation;
+        }
+    }
+
+  /* Random single-sector writes */
+
+  g_nwritten = 0;
+  g_nread    = 0;
+  g_nerased  = 0;
+  memset(g_erasecount, 0, sizeof(g_erasecount));
+
+  seed  = 1;
+  start = ftlbench_gettime();
+
+  for (i = 0; i < NWRITES; i++)
+    {
+      seed   = seed * 1103515245 + 12345;
+      sector = (seed >> 8) % nsectors;
+
+      g_generation[sector]++;
+      if (ftlbench_write(inode, sector) < 0)
+        {
+          goto errout_with_generation;
+        }
+    }
+
+  elapsed = (uint64_t)(uint32_t)(ftlbench_gettime() - start) * 1000 /
+            ftlbench_getfreq();
+  if (elapsed == 0)
+    {
+      elapsed = 1;
+    }
+
+  minerase = UINT_MAX;
+  maxerase = 0;
+
+  for (i = 0; i < NEBLOCKS; i++)
+    {
+      if (g_erasecount[i] < minerase)
+        {
+          minerase = g_erasecount[i];
+        }
+
+      if (g_erasecount[i] > maxerase)
+        {
+          maxerase = g_erasecount[i];
+        }
+    }
+
+  printf("%d writes in %lu msec: %lu writes/sec\n",
+         NWRITES, elapsed, (unsigned long)NWRITES * 1000 / elapsed);
+  printf("Write amplification: %lu.%02lu\n",
+         g_nwritten / NWRITES, (g_nwritten * 100 / NWRITES) % 100);
+  printf("Erases per write:    %lu.%03lu\n",
+         g_nerased / NWRITES, (g_nerased * 1000 / NWRITES) % 1000);
+  printf("Pages read:          %lu\n", g_nread);
+  printf("Erase count:         %u..%u\n", minerase, maxerase);
+
+  nbad = ftlbench_verify(inode, nsectors);
+  printf("Verify: %d bad sectors\n", nbad);
+
+  /* Write a few more sectors and flush them.  Then re-initialize the FTL
+   * from FLASH without closing this instance, as if power was lost.
+   */
+
+  for (i = 0; i < NFLUSHED; i++)
+    {
+      sector = i * (nsectors / NFLUSHED);
+      g_generation[sector]++;
+      if (ftlbench_write(inode, sector) < 0)
+        {
+          goto errout_with_generation;
+        }
+    }
+
+  ret = inode->u.i_bops->ioctl(inode, BIOC_FLUSH, 0);
+  if (ret < 0 && ret != -ENOTTY)
+    {
+      printf("ERROR: BIOC_FLUSH failed: %d\n", ret);
+      goto errout_with_generation;
+    }
+
+  ret = ftlbench_open(1, &inode);
+  if (ret < 0)
+    {
+      goto errout_with_generation;
+    }
+
+  ret = ftlbench_verify(inode, nsectors);
+  printf("Verify after re-initialization: %d bad sectors\n", ret);
+  nbad += ret;
+
+  (void)close_blockdriver(inode);
+  free(g_generation);
+
+  /* The FLASH stays allocated:  The FTL instances still refer to it */
+
+  return nbad > 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+
+errout_with_generation:
+  free(g_generation);
+
+errout_with_inode:
+  (void)close_blockdriver(inode);
+  return EXIT_FAILURE;
+
+errout_with_flash:
+  free(flash);
+  return EXIT_FAILURE;
+}
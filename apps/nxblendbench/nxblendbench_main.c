@@ -0,0 +1,644 @@
+/****************************************************************************
+ * apps/nxblendbench/nxblendbench_main.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <sys/boardctl.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+
+#include <nuttx/arch.h>
+#include <nuttx/nx/nxglib.h>
+#include <nuttx/nx/nx.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* A window of anti-aliased 8x12 glyphs */
+
+#define GLYPH_WIDTH    8
+#define GLYPH_HEIGHT   12
+#define NCOLUMNS       36
+#define NROWS          18
+#define NGLYPHS        (NCOLUMNS * NROWS)
+#define WINDOW_WIDTH   (NCOLUMNS * GLYPH_WIDTH)
+#define WINDOW_HEIGHT  (NROWS * GLYPH_HEIGHT)
+
+/* A translucent overlay */
+
+#define OVERLAY_X      40
+#define OVERLAY_Y      40
+#define OVERLAY_WIDTH  200
+#define OVERLAY_HEIGHT 120
+#define OVERLAY_ALPHA  96
+
+/* The background and text colors (RGB565) */
+
+#define BACKGROUND     0x18e3
+#define FOREGROUND     0xffff
+
+/* Repetitions of the slow (per-pixel) and the fast paths */
+
+#define SLOW_REPS      20
+#define FAST_REPS      200
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static void nxblendbench_redraw(NXWINDOW hwnd,
+                                FAR const struct nxgl_rect_s *rect,
+                                bool more, FAR void *arg);
+static void nxblendbench_position(NXWINDOW hwnd,
+                                  FAR const struct nxgl_size_s *size,
+                                  FAR const struct nxgl_point_s *pos,
+                                  FAR const struct nxgl_rect_s *bounds,
+                                  FAR void *arg);
+static void nxblendbench_blocked(NXWINDOW hwnd, FAR void *arg1,
+                                 FAR void *arg2);
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const struct nx_callback_s g_nxblendbench_cb =
+{
+  nxblendbench_redraw,   /* redraw */
+  nxblendbench_position  /* position */
+#ifdef CONFIG_NX_XYINPUT
+  , NULL                 /* mousein */
+#endif
+#ifdef CONFIG_NX_KBD
+  , NULL                 /* kbdin */
+#endif
+  , nxblendbench_blocked /* blocked */
+};
+
+static NXHANDLE g_hnx;
+
+static uint8_t  g_glyph[GLYPH_HEIGHT][GLYPH_WIDTH];
+static uint16_t g_overlay[OVERLAY_HEIGHT][OVERLAY_WIDTH];
+
+/* Snapshots of the window taken after the slow and the fast paths */
+
+static uint16_t g_slow[WINDOW_HEIGHT][WINDOW_WIDTH];
+static uint16_t g_fast[WINDOW_HEIGHT][WINDOW_WIDTH];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static void nxblendbench_redraw(NXWINDOW hwnd,
+                                FAR const struct nxgl_rect_s *rect,
+                                bool more, FAR void *arg)
+{
+}
+
+static void nxblendbench_position(NXWINDOW hwnd,
+                                  FAR const struct nxgl_size_s *size,
+                                  FAR const struct nxgl_point_s *pos,
+                                  FAR const struct nxgl_rect_s *bounds,
+                                  FAR void *arg)
+{
+}
+
+static void nxblendbench_blocked(NXWINDOW hwnd, FAR void *arg1,
+                                 FAR void *arg2)
+{
+}
+
+/****************************************************************************
+ * Name: nxblendbench_listener
+ ****************************************************************************/
+
+static FAR void *nxblendbench_listener(FAR void *arg)
+{
+  for (; ; )
+    {
+      (void)nx_eventhandler(g_hnx);
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: nxblendbench_gettime and nxblendbench_getfreq
+ *
+ * Description:
+ *   Return a free-running time stamp and its frequency.  Use the high
+ *   resolution counter if there is one:  The system timer may not advance
+ *   while the benchmark keeps the CPU busy (as in the simulation).
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_TIMESTATS
+#  define nxblendbench_gettime() up_perf_gettime()
+#  define nxblendbench_getfreq() up_perf_getfreq()
+#else
+static uint32_t nxblendbench_gettime(void)
+{
+  struct timespec ts;
+
+  (void)clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+#  define nxblendbench_getfreq() 1000000
+#endif
+
+/****************************************************************************
+ * Name: nxblendbench_usec
+ *
+ * Description:
+ *   Return the microseconds elapsed since 'start'.
+ *
+ ****************************************************************************/
+
+static unsigned long nxblendbench_usec(uint32_t start)
+{
+  unsigned long usec;
+
+  usec = (uint64_t)(uint32_t)(nxblendbench_gettime() - start) * 1000000 /
+         nxblendbench_getfreq();
+  return usec > 0 ? usec : 1;
+}
+
+/****************************************************************************
+ * Name: nxblendbench_blend
+ *
+ * Description:
+ *   Blend two RGB565 pixels with exact rounding, as an application without
+ *   nx_blendbitmap() and nx_fillmask() would.
+ *
+ ****************************************************************************/
+
+static uint16_t nxblendbench_blend(uint16_t dest, uint16_t src,
+                                   unsigned int alpha)
+{
+  unsigned int r;
+  unsigned int g;
+  unsigned int b;
+
+  r = ((src >> 11) * alpha + (dest >> 11) * (255 - alpha) + 127) / 255;
+  g = (((src >> 5) & 63) * alpha + ((dest >> 5) & 63) * (255 - alpha) +
+       127) / 255;
+  b = ((src & 31) * alpha + (dest & 31) * (255 - alpha) + 127) / 255;
+
+  return (r << 11) | (g << 5) | b;
+}
+
+/****************************************************************************
+ * Name: nxblendbench_maxdiff
+ *
+ * Description:
+ *   Return the largest difference of any color field between the two
+ *   snapshots.
+ *
+ ****************************************************************************/
+
+static int nxblendbench_maxdiff(void)
+{
+  uint16_t a;
+  uint16_t b;
+  int maxdiff = 0;
+  int diff;
+  int x;
+  int y;
+
+  for (y = 0; y < WINDOW_HEIGHT; y++)
+    {
+      for (x = 0; x < WINDOW_WIDTH; x++)
+        {
+          a    = g_slow[y][x];
+          b    = g_fast[y][x];
+
+          diff = abs((a >> 11) - (b >> 11));
+          maxdiff = diff > maxdiff ? diff : maxdiff;
+
+          diff = abs(((a >> 5) & 63) - ((b >> 5) & 63));
+          maxdiff = diff > maxdiff ? diff : maxdiff;
+
+          diff = abs((a & 31) - (b & 31));
+          maxdiff = diff > maxdiff ? diff : maxdiff;
+        }
+    }
+
+  return maxdiff;
+}
+
+/****************************************************************************
+ * Name: nxblendbench_snapshot
+ *
+ * Description:
+ *   Read back the window.  This also waits until the server has completed
+ *   all earlier drawing requests.
+ *
+ ****************************************************************************/
+
+static void nxblendbench_snapshot(NXWINDOW hwnd, FAR uint16_t *buffer)
+{
+  struct nxgl_rect_s rect;
+
+  rect.pt1.x = 0;
+  rect.pt1.y = 0;
+  rect.pt2.x = WINDOW_WIDTH - 1;
+  rect.pt2.y = WINDOW_HEIGHT - 1;
+
+  (void)nx_getrectangle(hwnd, &rect, 0, (FAR uint8_t *)buffer,
+                        WINDOW_WIDTH * sizeof(uint16_t));
+}
+
+/****************************************************************************
+ * Name: nxblendbench_clear
+ ****************************************************************************/
+
+static void nxblendbench_clear(NXWINDOW hwnd)
+{
+  nxgl_mxpixel_t color[CONFIG_NX_NPLANES];
+  struct nxgl_rect_s rect;
+
+  rect.pt1.x = 0;
+  rect.pt1.y = 0;
+  rect.pt2.x = WINDOW_WIDTH - 1;
+  rect.pt2.y = WINDOW_HEIGHT - 1;
+  color[0]   = BACKGROUND;
+
+  (void)nx_fill(hwnd, &rect, color);
+}
+
+/****************************************************************************
+ * Name: nxblendbench_textpixels
+ *
+ * Description:
+ *   Draw a screen of glyphs one pixel at a time.
+ *
+ ****************************************************************************/
+
+static void nxblendbench_textpixels(NXWINDOW hwnd)
+{
+  nxgl_mxpixel_t color[CONFIG_NX_NPLANES];
+  struct nxgl_point_s pos;
+  int i;
+  int x;
+  int y;
+
+  for (i = 0; i < NGLYPHS; i++)
+    {
+      for (y = 0; y < GLYPH_HEIGHT; y++)
+        {
+          for (x = 0; x < GLYPH_WIDTH; x++)
+            {
+              if (g_glyph[y][x] != 0)
+                {
+                  pos.x    = (i % NCOLUMNS) * GLYPH_WIDTH + x;
+                  pos.y    = (i / NCOLUMNS) * GLYPH_HEIGHT + y;
+                  color[0] = nxblendbench_blend(BACKGROUND, FOREGROUND,
+                                                g_glyph[y][x]);
+                  (void)nx_setpixel(hwnd, &pos, color);
+                }
+            }
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: nxblendbench_textmask
+ *
+ * Description:
+ *   Draw a screen of glyphs with nx_fillmask().
+ *
+ ****************************************************************************/
+
+static void nxblendbench_textmask(NXWINDOW hwnd)
+{
+  nxgl_mxpixel_t color[CONFIG_NX_NPLANES];
+  struct nxgl_rect_s rect;
+  int i;
+
+  color[0] = FOREGROUND;
+
+  for (i = 0; i < NGLYPHS; i++)
+    {
+      rect.pt1.x = (i % NCOLUMNS) * GLYPH_WIDTH;
+      rect.pt1.y = (i / NCOLUMNS) * GLYPH_HEIGHT;
+      rect.pt2.x = rect.pt1.x + GLYPH_WIDTH - 1;
+      rect.pt2.y = rect.pt1.y + GLYPH_HEIGHT - 1;
+
+      (void)nx_fillmask(hwnd, &rect, &g_glyph[0][0], &rect.pt1,
+                        GLYPH_WIDTH, color);
+    }
+}
+
+/****************************************************************************
+ * Name: nxblendbench_overlaypixels
+ *
+ * Description:
+ *   Read the area under the overlay, blend it and write it back one pixel
+ *   at a time.
+ *
+ ****************************************************************************/
+
+static void nxblendbench_overlaypixels(NXWINDOW hwnd)
+{
+  nxgl_mxpixel_t color[CONFIG_NX_NPLANES];
+  struct nxgl_point_s pos;
+  struct nxgl_rect_s rect;
+  FAR uint16_t *under = &g_fast[0][0];
+  int x;
+  int y;
+
+  rect.pt1.x = OVERLAY_X;
+  rect.pt1.y = OVERLAY_Y;
+  rect.pt2.x = OVERLAY_X + OVERLAY_WIDTH - 1;
+  rect.pt2.y = OVERLAY_Y + OVERLAY_HEIGHT - 1;
+
+  (void)nx_getrectangle(hwnd, &rect, 0, (FAR uint8_t *)under,
+                        OVERLAY_WIDTH * sizeof(uint16_t));
+
+  for (y = 0; y < OVERLAY_HEIGHT; y++)
+    {
+      for (x = 0; x < OVERLAY_WIDTH; x++)
+        {
+          pos.x    = OVERLAY_X + x;
+          pos.y    = OVERLAY_Y + y;
+          color[0] = nxblendbench_blend(under[y * OVERLAY_WIDTH + x],
+                                        g_overlay[y][x], OVERLAY_ALPHA);
+          (void)nx_setpixel(hwnd, &pos, color);
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: nxblendbench_overlayblend
+ ****************************************************************************/
+
+static void nxblendbench_overlayblend(NXWINDOW hwnd)
+{
+  FAR const void *src[CONFIG_NX_NPLANES];
+  struct nxgl_rect_s rect;
+
+  rect.pt1.x = OVERLAY_X;
+  rect.pt1.y = OVERLAY_Y;
+  rect.pt2.x = OVERLAY_X + OVERLAY_WIDTH - 1;
+  rect.pt2.y = OVERLAY_Y + OVERLAY_HEIGHT - 1;
+  src[0]     = g_overlay;
+
+  (void)nx_blendbitmap(hwnd, &rect, src, &rect.pt1,
+                       OVERLAY_WIDTH * sizeof(uint16_t), OVERLAY_ALPHA);
+}
+
+/****************************************************************************
+ * Name: nxblendbench_initialize
+ *
+ * Description:
+ *   Create an anti-aliased ring glyph and a gradient overlay.
+ *
+ ****************************************************************************/
+
+static void nxblendbench_initialize(void)
+{
+  int dx;
+  int dy;
+  int d2;
+  int x;
+  int y;
+
+  for (y = 0; y < GLYPH_HEIGHT; y++)
+    {
+      for (x = 0; x < GLYPH_WIDTH; x++)
+        {
+          dx = 2 * x + 1 - GLYPH_WIDTH;
+          dy = (2 * y + 1 - GLYPH_HEIGHT) * 2 / 3;
+          d2 = dx * dx + dy * dy;
+
+          if (d2 < 9 || d2 > 60)
+            {
+              g_glyph[y][x] = 0;
+            }
+          else if (d2 < 16)
+            {
+              g_glyph[y][x] = (d2 - 9) * 255 / 7;
+            }
+          else if (d2 < 40)
+            {
+              g_glyph[y][x] = 255;
+            }
+          else
+            {
+              g_glyph[y][x] = (60 - d2) * 255 / 20;
+            }
+        }
+    }
+
+  for (y = 0; y < OVERLAY_HEIGHT; y++)
+    {
+      for (x = 0; x < OVERLAY_WIDTH; x++)
+        {
+          g_overlay[y][x] = ((x * 31 / OVERLAY_WIDTH) << 11) |
+                            ((y * 63 / OVERLAY_HEIGHT) << 5) |
+                            ((x + y) & 31);
+        }
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * nxblendbench_main
+ ****************************************************************************/
+
+#ifdef CONFIG_BUILD_KERNEL
+int main(int argc, FAR char *argv[])
+#else
+int nxblendbench_main(int argc, char *argv[])
+#endif
+{
+  struct nxgl_point_s pos;
+  struct nxgl_size_s size;
+  unsigned long slow;
+  unsigned long fast;
+  NXWINDOW hwnd;
+  pthread_t thread;
+  uint32_t start;
+  int maxdiff;
+  int ret;
+  int i;
+
+  ret = boardctl(BOARDIOC_NX_START, 0);
+  if (ret < 0)
+    {
+      printf("ERROR: Failed to start the NX server: %d\n", errno);
+      return EXIT_FAILURE;
+    }
+
+  g_hnx = nx_connect();
+  if (g_hnx == NULL)
+    {
+      printf("ERROR: nx_connect failed: %d\n", errno);
+      return EXIT_FAILURE;
+    }
+
+  /* Wait for the connection to be acknowledged.  Then let a separate
+   * thread handle the server events.
+   */
+
+  (void)nx_eventhandler(g_hnx);
+
+  ret = pthread_create(&thread, NULL, nxblendbench_listener, NULL);
+  if (ret != 0)
+    {
+      printf("ERROR: pthread_create failed: %d\n", ret);
+      goto errout_with_nx;
+    }
+
+  hwnd = nx_openwindow(g_hnx, &g_nxblendbench_cb, NULL);
+  if (hwnd == NULL)
+    {
+      printf("ERROR: nx_openwindow failed: %d\n", errno);
+      goto errout_with_listener;
+    }
+
+  size.w = WINDOW_WIDTH;
+  size.h = WINDOW_HEIGHT;
+  pos.x  = 0;
+  pos.y  = 0;
+
+  (void)nx_setsize(hwnd, &size);
+  (void)nx_setposition(hwnd, &pos);
+
+  nxblendbench_initialize();
+
+  /* Anti-aliased text */
+
+  start = nxblendbench_gettime();
+  for (i = 0; i < SLOW_REPS; i++)
+    {
+      nxblendbench_clear(hwnd);
+      nxblendbench_textpixels(hwnd);
+    }
+
+  nxblendbench_snapshot(hwnd, &g_slow[0][0]);
+  slow = nxblendbench_usec(start);
+
+  start = nxblendbench_gettime();
+  for (i = 0; i < FAST_REPS; i++)
+    {
+      nxblendbench_clear(hwnd);
+      nxblendbench_textmask(hwnd);
+    }
+
+  nxblendbench_snapshot(hwnd, &g_fast[0][0]);
+  fast = nxblendbench_usec(start);
+
+  printf("Text, %dx%d glyphs (max. difference %d):\n",
+         GLYPH_WIDTH, GLYPH_HEIGHT, nxblendbench_maxdiff());
+  printf("  nx_setpixel: %10lu glyphs/sec\n",
+         (unsigned long)((uint64_t)SLOW_REPS * NGLYPHS * 1000000 / slow));
+  printf("  nx_fillmask: %10lu glyphs/sec\n",
+         (unsigned long)((uint64_t)FAST_REPS * NGLYPHS * 1000000 / fast));
+
+  /* A translucent overlay over the text.  The slow path reads back the
+   * window, so it is run the same number of times on both.
+   */
+
+  nxblendbench_clear(hwnd);
+  nxblendbench_textmask(hwnd);
+
+  start = nxblendbench_gettime();
+  for (i = 0; i < SLOW_REPS; i++)
+    {
+      nxblendbench_overlaypixels(hwnd);
+    }
+
+  nxblendbench_snapshot(hwnd, &g_slow[0][0]);
+  slow = nxblendbench_usec(start);
+
+  nxblendbench_clear(hwnd);
+  nxblendbench_textmask(hwnd);
+
+  for (i = 0; i < SLOW_REPS; i++)
+    {
+      nxblendbench_overlayblend(hwnd);
+    }
+
+  nxblendbench_snapshot(hwnd, &g_fast[0][0]);
+  maxdiff = nxblendbench_maxdiff();
+
+  start = nxblendbench_gettime();
+  for (i = 0; i < FAST_REPS; i++)
+    {
+      nxblendbench_overlayblend(hwnd);
+    }
+
+  nxblendbench_snapshot(hwnd, &g_fast[0][0]);
+  fast = nxblendbench_usec(start);
+
+  printf("Overlay, %dx%d alpha %d (max. difference %d):\n",
+         OVERLAY_WIDTH, OVERLAY_HEIGHT, OVERLAY_ALPHA, maxdiff);
+  printf("  nx_setpixel:    %10lu pixels/sec\n",
+         (unsigned long)((uint64_t)SLOW_REPS * OVERLAY_WIDTH *
+                         OVERLAY_HEIGHT * 1000000 / slow));
+  printf("  nx_blendbitmap: %10lu pixels/sec\n",
+         (unsigned long)((uint64_t)FAST_REPS * OVERLAY_WIDTH *
+                         OVERLAY_HEIGHT * 1000000 / fast));
+
+  (void)pthread_cancel(thread);
+  (void)pthread_join(thread, NULL);
+
+  (void)nx_closewindow(hwnd);
+  nx_disconnect(g_hnx);
+  return EXIT_SUCCESS;
+
+errout_with_listener:
+  (void)pthread_cancel(thread);
+  (void)pthread_join(thread, NULL);
+
+errout_with_nx:
+  nx_disconnect(g_hnx);
+  return EXIT_FAILURE;
+}
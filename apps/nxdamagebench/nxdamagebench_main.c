@@ -0,0 +1,522 @@
+/****************************************************************************
+ * apps/nxdamagebench/nxdamagebench_main.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <sys/boardctl.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <errno.h>
+
+#include <nuttx/nx/nxglib.h>
+#include <nuttx/nx/nx.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_EXAMPLES_NXDAMAGEBENCH_CALLUSEC
+#  define CONFIG_EXAMPLES_NXDAMAGEBENCH_CALLUSEC 30
+#endif
+
+#ifndef CONFIG_EXAMPLES_NXDAMAGEBENCH_PIXELNSEC
+#  define CONFIG_EXAMPLES_NXDAMAGEBENCH_PIXELNSEC 800
+#endif
+
+/* Time allowed for pending damage to be flushed after each scene */
+
+#ifdef CONFIG_NX_UPDATE_DAMAGE
+#  define SETTLE_MSEC   (2 * CONFIG_NX_UPDATE_DAMAGE_MSEC + 50)
+#else
+#  define SETTLE_MSEC   50
+#endif
+
+/* Four overlapping windows */
+
+#define NWINDOWS        4
+#define WINDOW_WIDTH    150
+#define WINDOW_HEIGHT   100
+
+/* Terminal text in the top window: 8x12 glyph cells */
+
+#define GLYPH_WIDTH     8
+#define GLYPH_HEIGHT    12
+#define NCOLUMNS        18
+#define NROWS           8
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static void nxdamagebench_redraw(NXWINDOW hwnd,
+                                 FAR const struct nxgl_rect_s *rect,
+                                 bool more, FAR void *arg);
+static void nxdamagebench_position(NXWINDOW hwnd,
+                                   FAR const struct nxgl_size_s *size,
+                                   FAR const struct nxgl_point_s *pos,
+                                   FAR const struct nxgl_rect_s *bounds,
+                                   FAR void *arg);
+static void nxdamagebench_blocked(NXWINDOW hwnd, FAR void *arg1,
+                                  FAR void *arg2);
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const struct nx_callback_s g_nxdamagebench_cb =
+{
+  nxdamagebench_redraw,   /* redraw */
+  nxdamagebench_position  /* position */
+#ifdef CONFIG_NX_XYINPUT
+  , NULL                  /* mousein */
+#endif
+#ifdef CONFIG_NX_KBD
+  , NULL                  /* kbdin */
+#endif
+  , nxdamagebench_blocked /* blocked */
+};
+
+static NXHANDLE g_hnx;
+static NXWINDOW g_hwnd[NWINDOWS];
+
+/* Counts of the update notifications from the NX server */
+
+static volatile unsigned long g_ncalls;
+static volatile unsigned long g_npixels;
+static volatile unsigned long g_nmoves;
+
+/* The counts at the start of the current scene */
+
+static unsigned long g_startcalls;
+static unsigned long g_startpixels;
+static unsigned long g_startmoves;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static void nxdamagebench_redraw(NXWINDOW hwnd,
+                                 FAR const struct nxgl_rect_s *rect,
+                                 bool more, FAR void *arg)
+{
+  nxgl_mxpixel_t color[CONFIG_NX_NPLANES];
+
+  color[0] = 0x1111 * ((int)(intptr_t)arg + 1);
+  (void)nx_fill(hwnd, rect, color);
+}
+
+static void nxdamagebench_position(NXWINDOW hwnd,
+                                   FAR const struct nxgl_size_s *size,
+                                   FAR const struct nxgl_point_s *pos,
+                                   FAR const struct nxgl_rect_s *bounds,
+                                   FAR void *arg)
+{
+}
+
+static void nxdamagebench_blocked(NXWINDOW hwnd, FAR void *arg1,
+                                  FAR void *arg2)
+{
+}
+
+/****************************************************************************
+ * Name: nxdamagebench_listener
+ ****************************************************************************/
+
+static FAR void *nxdamagebench_listener(FAR void *arg)
+{
+  for (; ; )
+    {
+      (void)nx_eventhandler(g_hnx);
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: nxdamagebench_fill
+ ****************************************************************************/
+
+static void nxdamagebench_fill(NXWINDOW hwnd, int x1, int y1, int x2,
+                               int y2, nxgl_mxpixel_t value)
+{
+  nxgl_mxpixel_t color[CONFIG_NX_NPLANES];
+  struct nxgl_rect_s rect;
+
+  rect.pt1.x = x1;
+  rect.pt1.y = y1;
+  rect.pt2.x = x2;
+  rect.pt2.y = y2;
+  color[0]   = value;
+
+  (void)nx_fill(hwnd, &rect, color);
+}
+
+/****************************************************************************
+ * Name: nxdamagebench_report
+ *
+ * Description:
+ *   Wait until the NX server has completed the drawing of the scene and
+ *   has flushed any pending damage.  Then report the notifications.
+ *
+ ****************************************************************************/
+
+static void nxdamagebench_report(FAR const char *name)
+{
+  unsigned long ncalls;
+  unsigned long npixels;
+  unsigned long nmoves;
+  struct nxgl_rect_s rect;
+  uint8_t pixel[4];
+
+  /* Reading back a pixel waits for the earlier requests */
+
+  rect.pt1.x = 0;
+  rect.pt1.y = 0;
+  rect.pt2.x = 0;
+  rect.pt2.y = 0;
+
+  (void)nx_getrectangle(g_hwnd[0], &rect, 0, pixel, sizeof(pixel));
+  usleep(SETTLE_MSEC * 1000);
+
+  ncalls  = g_ncalls - g_startcalls;
+  npixels = g_npixels - g_startpixels;
+  nmoves  = g_nmoves - g_startmoves;
+
+  printf("  %-8s %6lu calls %8lu pixels %4lu moves %8lu usec\n",
+         name, ncalls, npixels, nmoves,
+         (unsigned long)(ncalls * CONFIG_EXAMPLES_NXDAMAGEBENCH_CALLUSEC +
+                         (uint64_t)npixels *
+                         CONFIG_EXAMPLES_NXDAMAGEBENCH_PIXELNSEC / 1000));
+
+  g_startcalls  = g_ncalls;
+  g_startpixels = g_npixels;
+  g_startmoves  = g_nmoves;
+}
+
+/****************************************************************************
+ * Name: nxdamagebench_windows
+ *
+ * Description:
+ *   Open four overlapping windows.  Each is drawn by its redraw callback.
+ *
+ ****************************************************************************/
+
+static int nxdamagebench_windows(void)
+{
+  struct nxgl_point_s pos;
+  struct nxgl_size_s size;
+  int i;
+
+  for (i = 0; i < NWINDOWS; i++)
+    {
+      g_hwnd[i] = nx_openwindow(g_hnx, &g_nxdamagebench_cb,
+                                (FAR void *)(intptr_t)i);
+      if (g_hwnd[i] == NULL)
+        {
+          printf("ERROR: nx_openwindow failed: %d\n", errno);
+          return -errno;
+        }
+
+      size.w = WINDOW_WIDTH;
+      size.h = WINDOW_HEIGHT;
+      pos.x  = 10 + 50 * i;
+      pos.y  = 10 + 35 * i;
+
+      (void)nx_setsize(g_hwnd[i], &size);
+      (void)nx_setposition(g_hwnd[i], &pos);
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: nxdamagebench_text
+ *
+ * Description:
+ *   Draw 'npages' screens of terminal text as fast as possible.  Each glyph
+ *   is a background cell with a foreground stroke.
+ *
+ ****************************************************************************/
+
+static void nxdamagebench_text(int npages)
+{
+  int x;
+  int y;
+  int i;
+
+  for (; npages > 0; npages--)
+    {
+      for (i = 0; i < NCOLUMNS * NROWS; i++)
+        {
+          x = (i % NCOLUMNS) * GLYPH_WIDTH;
+          y = (i / NCOLUMNS) * GLYPH_HEIGHT;
+
+          nxdamagebench_fill(g_hwnd[3], x, y, x + GLYPH_WIDTH - 1,
+                             y + GLYPH_HEIGHT - 1, 0x0000);
+          nxdamagebench_fill(g_hwnd[3], x + 2, y + 2, x + GLYPH_WIDTH - 3,
+                             y + GLYPH_HEIGHT - 5, 0xffff);
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: nxdamagebench_paced
+ *
+ * Description:
+ *   Draw one screen of text, one line every 20 msec, as a terminal that
+ *   receives slow output would.
+ *
+ ****************************************************************************/
+
+static void nxdamagebench_paced(void)
+{
+  int x;
+  int y;
+  int i;
+
+  for (i = 0; i < NCOLUMNS * NROWS; i++)
+    {
+      x = (i % NCOLUMNS) * GLYPH_WIDTH;
+      y = (i / NCOLUMNS) * GLYPH_HEIGHT;
+
+      nxdamagebench_fill(g_hwnd[3], x, y, x + GLYPH_WIDTH - 1,
+                         y + GLYPH_HEIGHT - 1, 0x1234);
+
+      if ((i % NCOLUMNS) == NCOLUMNS - 1)
+        {
+          usleep(20 * 1000);
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: nxdamagebench_widgets
+ *
+ * Description:
+ *   Advance a progress bar one column at a time and set scattered pixels
+ *   in another window.
+ *
+ ****************************************************************************/
+
+static void nxdamagebench_widgets(void)
+{
+  nxgl_mxpixel_t color[CONFIG_NX_NPLANES];
+  struct nxgl_point_s pos;
+  int i;
+
+  for (i = 0; i < 140; i++)
+    {
+      nxdamagebench_fill(g_hwnd[3], 5 + i, 80, 5 + i, 90, 0xf800);
+    }
+
+  for (i = 0; i < 400; i++)
+    {
+      pos.x    = (i * 37) % 140;
+      pos.y    = (i * 11) % 70;
+      color[0] = i;
+
+      (void)nx_setpixel(g_hwnd[2], &pos, color);
+    }
+}
+
+/****************************************************************************
+ * Name: nxdamagebench_drag
+ *
+ * Description:
+ *   Drag a window across the others, updating its title bar as it moves.
+ *   Then raise two windows.
+ *
+ ****************************************************************************/
+
+static void nxdamagebench_drag(void)
+{
+  struct nxgl_point_s pos;
+  int i;
+
+  for (i = 0; i < 20; i++)
+    {
+      pos.x = 60 + 3 * i;
+      pos.y = 45 + 2 * i;
+
+      (void)nx_setposition(g_hwnd[1], &pos);
+      nxdamagebench_fill(g_hwnd[1], 0, 0, 20, 10, i);
+      usleep(10 * 1000);
+    }
+
+  (void)nx_raise(g_hwnd[0]);
+  (void)nx_raise(g_hwnd[1]);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nx_notify_rectangle and nx_notify_move
+ *
+ * Description:
+ *   The update callouts from the NX server.  They only count the updates.
+ *
+ ****************************************************************************/
+
+void nx_notify_rectangle(FAR NX_PLANEINFOTYPE *pinfo,
+                         FAR const struct nxgl_rect_s *rect)
+{
+  g_ncalls++;
+  g_npixels += (unsigned long)(rect->pt2.x - rect->pt1.x + 1) *
+               (rect->pt2.y - rect->pt1.y + 1);
+}
+
+#ifdef CONFIG_NX_UPDATE_MOVE
+void nx_notify_move(FAR NX_PLANEINFOTYPE *pinfo,
+                    FAR const struct nxgl_rect_s *rect,
+                    FAR const struct nxgl_point_s *offset)
+{
+  g_nmoves++;
+}
+#endif
+
+/****************************************************************************
+ * nxdamagebench_main
+ ****************************************************************************/
+
+#ifdef CONFIG_BUILD_KERNEL
+int main(int argc, FAR char *argv[])
+#else
+int nxdamagebench_main(int argc, char *argv[])
+#endif
+{
+  pthread_t thread;
+  int ret;
+  int i;
+
+  ret = boardctl(BOARDIOC_NX_START, 0);
+  if (ret < 0)
+    {
+      printf("ERROR: Failed to start the NX server: %d\n", errno);
+      return EXIT_FAILURE;
+    }
+
+  g_hnx = nx_connect();
+  if (g_hnx == NULL)
+    {
+      printf("ERROR: nx_connect failed: %d\n", errno);
+      return EXIT_FAILURE;
+    }
+
+  /* Wait for the connection to be acknowledged.  Then let a separate
+   * thread handle the server events.
+   */
+
+  (void)nx_eventhandler(g_hnx);
+
+  ret = pthread_create(&thread, NULL, nxdamagebench_listener, NULL);
+  if (ret != 0)
+    {
+      printf("ERROR: pthread_create failed: %d\n", ret);
+      goto errout_with_nx;
+    }
+
+  /* Don't count the initial background */
+
+  usleep(SETTLE_MSEC * 1000);
+  g_startcalls  = g_ncalls;
+  g_startpixels = g_npixels;
+  g_startmoves  = g_nmoves;
+
+#ifdef CONFIG_NX_UPDATE_DAMAGE
+  printf("Damage tracking, %d rectangles, %d msec:\n",
+         CONFIG_NX_UPDATE_DAMAGE_NRECTS, CONFIG_NX_UPDATE_DAMAGE_MSEC);
+#else
+  printf("No damage tracking:\n");
+#endif
+
+  ret = nxdamagebench_windows();
+  if (ret < 0)
+    {
+      goto errout_with_windows;
+    }
+
+  nxdamagebench_report("windows");
+
+  nxdamagebench_text(3);
+  nxdamagebench_report("text");
+
+  nxdamagebench_paced();
+  nxdamagebench_report("paced");
+
+  nxdamagebench_widgets();
+  nxdamagebench_report("widgets");
+
+  nxdamagebench_drag();
+  nxdamagebench_report("drag");
+
+  for (i = 0; i < NWINDOWS; i++)
+    {
+      (void)nx_closewindow(g_hwnd[i]);
+    }
+
+  (void)pthread_cancel(thread);
+  (void)pthread_join(thread, NULL);
+
+  nx_disconnect(g_hnx);
+  return EXIT_SUCCESS;
+
+errout_with_windows:
+  for (i = 0; i < NWINDOWS; i++)
+    {
+      if (g_hwnd[i] != NULL)
+        {
+          (void)nx_closewindow(g_hwnd[i]);
+        }
+    }
+
+  (void)pthread_cancel(thread);
+  (void)pthread_join(thread, NULL);
+
+errout_with_nx:
+  nx_disconnect(g_hnx);
+  return EXIT_FAILURE;
+}
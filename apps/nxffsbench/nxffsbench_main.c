@@ -0,0 +1,537 @@
+/****************************************************************************
+ * apps/nxffsbench/nxffsbench_main.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <sys/ioctl.h>
+#include <sys/mount.h>
+#include <sys/stat.h>
+#include <sys/statfs.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <time.h>
+#include <errno.h>
+
+#include <nuttx/arch.h>
+#include <nuttx/fs/ioctl.h>
+#include <nuttx/fs/nxffs.h>
+#include <nuttx/mtd/mtd.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_EXAMPLES_NXFFSBENCH_NEBLOCKS
+#  define CONFIG_EXAMPLES_NXFFSBENCH_NEBLOCKS 512
+#endif
+
+#ifndef CONFIG_EXAMPLES_NXFFSBENCH_NFILES
+#  define CONFIG_EXAMPLES_NXFFSBENCH_NFILES 3000
+#endif
+
+#define NEBLOCKS   CONFIG_EXAMPLES_NXFFSBENCH_NEBLOCKS
+#define NFILES     CONFIG_EXAMPLES_NXFFSBENCH_NFILES
+#define FLASHSIZE  (NEBLOCKS * CONFIG_RAMMTD_ERASESIZE)
+
+#define MOUNTPT    "/mnt/nxffs"
+#define FILESIZE   32
+#define NAMESIZE   32
+
+/* The number of names that are looked up but do not exist */
+
+#define NMISSING   500
+
+/* Every UNLINKSTEP'th file is deleted and every REWRITESTEP'th file is
+ * written again.
+ */
+
+#define UNLINKSTEP  3
+#define REWRITESTEP 30
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* The number of times each file has been written and whether it exists */
+
+static uint8_t g_generation[NFILES];
+static bool g_deleted[NFILES];
+
+static uint8_t g_buffer[FILESIZE];
+static uint8_t g_expected[FILESIZE];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxffsbench_gettime and nxffsbench_getfreq
+ *
+ * Description:
+ *   Return a free-running time stamp and its frequency.  Use the high
+ *   resolution counter if there is one:  The system timer may not advance
+ *   while the benchmark keeps the CPU busy (as in the simulation).
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_TIMESTATS
+#  define nxffsbench_gettime() up_perf_gettime()
+#  define nxffsbench_getfreq() up_perf_getfreq()
+#else
+static uint32_t nxffsbench_gettime(void)
+{
+  struct timespec ts;
+
+  (void)clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+#  define nxffsbench_getfreq() 1000000
+#endif
+
+/****************************************************************************
+ * Name: nxffsbench_report
+ *
+ * Description:
+ *   Print the time elapsed since 'start' for 'nops' operations.
+ *
+ ****************************************************************************/
+
+static void nxffsbench_report(FAR const char *what, int nops, uint32_t start)
+{
+  unsigned long usec;
+
+  usec = (uint64_t)(uint32_t)(nxffsbench_gettime() - start) * 1000000 /
+         nxffsbench_getfreq();
+
+  printf("  %-22s %5d %7lu.%lu msec\n",
+         what, nops, usec / 1000, (usec / 100) % 10);
+}
+
+/****************************************************************************
+ * Name: nxffsbench_name
+ ****************************************************************************/
+
+static void nxffsbench_name(FAR char *name, FAR const char *prefix, int i)
+{
+  snprintf(name, NAMESIZE, "%s/%s%05d.dat", MOUNTPT, prefix, i);
+}
+
+/****************************************************************************
+ * Name: nxffsbench_fill
+ *
+ * Description:
+ *   Fill a buffer with a pattern that is unique to the file and to the
+ *   number of times that it has been written.
+ *
+ ****************************************************************************/
+
+static void nxffsbench_fill(FAR uint8_t *buffer, int i)
+{
+  uint8_t seed = (uint8_t)(i * 31 + g_generation[i] * 101);
+  int j;
+
+  for (j = 0; j < FILESIZE; j++)
+    {
+      buffer[j] = seed + j;
+    }
+}
+
+/****************************************************************************
+ * Name: nxffsbench_write
+ ****************************************************************************/
+
+static int nxffsbench_write(int i)
+{
+  char name[NAMESIZE];
+  ssize_t nwritten;
+  int fd;
+
+  nxffsbench_name(name, "log", i);
+  fd = open(name, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  if (fd < 0)
+    {
+      printf("ERROR: open(%s) for writing failed: %d\n", name, errno);
+      return -1;
+    }
+
+  nxffsbench_fill(g_buffer, i);
+  nwritten = write(fd, g_buffer, FILESIZE);
+  if (close(fd) < 0 || nwritten != FILESIZE)
+    {
+      printf("ERROR: Write of %s failed: %d\n", name, errno);
+      return -1;
+    }
+
+  g_deleted[i] = false;
+  return 0;
+}
+
+/****************************************************************************
+ * Name: nxffsbench_mount
+ *
+ * Description:
+ *   Initialize the NXFFS volume from the FLASH contents and mount it.  The
+ *   volume must not be mounted.
+ *
+ ****************************************************************************/
+
+static int nxffsbench_mount(FAR struct mtd_dev_s *mtd)
+{
+  int ret;
+
+  ret = nxffs_initialize(mtd);
+  if (ret < 0)
+    {
+      printf("ERROR: nxffs_initialize failed: %d\n", ret);
+      return ret;
+    }
+
+  ret = mount(NULL, MOUNTPT, "nxffs", 0, NULL);
+  if (ret < 0)
+    {
+      printf("ERROR: mount failed: %d\n", errno);
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: nxffsbench_verify
+ *
+ * Description:
+ *   Read back all files and return the number that do not hold the data
+ *   last written to them, or that were deleted but can still be opened.
+ *   The file count reported by statfs() is checked too.
+ *
+ ****************************************************************************/
+
+static int nxffsbench_verify(FAR const char *when)
+{
+  char name[NAMESIZE];
+#ifdef CONFIG_NXFFS_INDEX
+  struct statfs buf;
+  int nfiles = 0;
+#endif
+  int nbad = 0;
+  int fd;
+  int i;
+
+  for (i = 0; i < NFILES; i++)
+    {
+      nxffsbench_name(name, "log", i);
+      fd = open(name, O_RDONLY);
+
+      if (g_deleted[i])
+        {
+          if (fd >= 0 || errno != ENOENT)
+            {
+              if (nbad++ < 5)
+                {
+                  printf("ERROR: Deleted file %s can be opened\n", name);
+                }
+            }
+
+          if (fd >= 0)
+            {
+              (void)close(fd);
+            }
+
+          continue;
+        }
+
+#ifdef CONFIG_NXFFS_INDEX
+      nfiles++;
+#endif
+
+      nxffsbench_fill(g_expected, i);
+      if (fd < 0 || read(fd, g_buffer, FILESIZE) != FILESIZE ||
+          memcmp(g_buffer, g_expected, FILESIZE) != 0)
+        {
+          if (nbad++ < 5)
+            {
+              printf("ERROR: File %s does not match\n", name);
+            }
+        }
+
+      if (fd >= 0)
+        {
+          (void)close(fd);
+        }
+    }
+
+#ifdef CONFIG_NXFFS_INDEX
+  if (statfs(MOUNTPT, &buf) < 0 || buf.f_files != nfiles)
+    {
+      printf("ERROR: statfs() reports %ld files, expected %d\n",
+             (long)buf.f_files, nfiles);
+      nbad++;
+    }
+#endif
+
+  printf("Verify %s: %d errors\n", when, nbad);
+  return nbad;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * nxffsbench_main
+ ****************************************************************************/
+
+#ifdef CONFIG_BUILD_KERNEL
+int main(int argc, FAR char *argv[])
+#else
+int nxffsbench_main(int argc, char *argv[])
+#endif
+{
+  FAR struct mtd_dev_s *mtd;
+  FAR uint8_t *flash;
+  char name[NAMESIZE];
+  struct stat st;
+  uint32_t start;
+  int nbad = 0;
+  int nops;
+  int ret;
+  int fd;
+  int i;
+
+  flash = (FAR uint8_t *)malloc(FLASHSIZE);
+  if (flash == NULL)
+    {
+      printf("ERROR: Failed to allocate %d bytes of FLASH\n", FLASHSIZE);
+      return EXIT_FAILURE;
+    }
+
+  mtd = rammtd_initialize(flash, FLASHSIZE);
+  if (mtd == NULL)
+    {
+      printf("ERROR: rammtd_initialize failed\n");
+      free(flash);
+      return EXIT_FAILURE;
+    }
+
+  (void)MTD_ERASE(mtd, 0, NEBLOCKS);
+
+  if (nxffsbench_mount(mtd) < 0)
+    {
+      goto errout;
+    }
+
+#ifdef CONFIG_NXFFS_INDEX
+  printf("%d files of %d bytes, with the inode index\n", NFILES, FILESIZE);
+#else
+  printf("%d files of %d bytes, without the inode index\n", NFILES, FILESIZE);
+#endif
+
+  /* Create the files */
+
+  start = nxffsbench_gettime();
+  for (i = 0; i < NFILES; i++)
+    {
+      if (nxffsbench_write(i) < 0)
+        {
+          goto errout_with_mount;
+        }
+    }
+
+  nxffsbench_report("create", NFILES, start);
+
+  /* Mount the volume again.  This builds the inode index, if enabled. */
+
+  if (umount(MOUNTPT) < 0)
+    {
+      printf("ERROR: umount failed: %d\n", errno);
+      goto errout;
+    }
+
+  start = nxffsbench_gettime();
+  if (nxffsbench_mount(mtd) < 0)
+    {
+      goto errout;
+    }
+
+  nxffsbench_report("mount", 1, start);
+
+  /* Look up the files in an order unrelated to their position on FLASH */
+
+  start = nxffsbench_gettime();
+  for (i = 0; i < NFILES; i++)
+    {
+      nxffsbench_name(name, "log", (i * 7919) % NFILES);
+      fd = open(name, O_RDONLY);
+      if (fd < 0)
+        {
+          nbad++;
+          continue;
+        }
+
+      (void)close(fd);
+    }
+
+  nxffsbench_report("open+close", NFILES, start);
+
+  start = nxffsbench_gettime();
+  for (i = 0; i < NFILES; i++)
+    {
+      nxffsbench_name(name, "log", (i * 7919) % NFILES);
+      if (stat(name, &st) < 0 || st.st_size != FILESIZE)
+        {
+          nbad++;
+        }
+    }
+
+  nxffsbench_report("stat", NFILES, start);
+
+  start = nxffsbench_gettime();
+  for (i = 0; i < NMISSING; i++)
+    {
+      nxffsbench_name(name, "none", i);
+      if (stat(name, &st) == 0 || errno != ENOENT)
+        {
+          nbad++;
+        }
+    }
+
+  nxffsbench_report("stat, missing names", NMISSING, start);
+
+  if (nbad > 0)
+    {
+      printf("ERROR: %d look-ups failed\n", nbad);
+    }
+
+  /* Delete some files */
+
+  start = nxffsbench_gettime();
+  for (i = 0, nops = 0; i < NFILES; i += UNLINKSTEP, nops++)
+    {
+      nxffsbench_name(name, "log", i);
+      if (unlink(name) < 0)
+        {
+          printf("ERROR: unlink(%s) failed: %d\n", name, errno);
+          nbad++;
+        }
+
+      g_deleted[i] = true;
+    }
+
+  nxffsbench_report("unlink", nops, start);
+  nbad += nxffsbench_verify("after unlink");
+
+  /* Write some of the remaining files again.  This replaces their inodes. */
+
+  for (i = 1; i < NFILES; i += REWRITESTEP)
+    {
+      g_generation[i]++;
+      if (nxffsbench_write(i) < 0)
+        {
+          goto errout_with_mount;
+        }
+    }
+
+  nbad += nxffsbench_verify("after rewrite");
+
+  /* Pack the volume.  This moves the inodes on FLASH. */
+
+  nxffsbench_name(name, "log", 1);
+  fd = open(name, O_RDONLY);
+  if (fd < 0)
+    {
+      printf("ERROR: open(%s) failed: %d\n", name, errno);
+      goto errout_with_mount;
+    }
+
+  start = nxffsbench_gettime();
+  ret   = ioctl(fd, FIOC_OPTIMIZE, 0);
+  (void)close(fd);
+
+  if (ret < 0)
+    {
+      printf("ERROR: FIOC_OPTIMIZE failed: %d\n", errno);
+      goto errout_with_mount;
+    }
+
+  nxffsbench_report("pack", 1, start);
+  nbad += nxffsbench_verify("after pack");
+
+  /* Mount the volume again and check that the files found on FLASH are
+   * the same.
+   */
+
+  if (umount(MOUNTPT) < 0)
+    {
+      printf("ERROR: umount failed: %d\n", errno);
+      goto errout;
+    }
+
+  if (nxffsbench_mount(mtd) < 0)
+    {
+      goto errout;
+    }
+
+  nbad += nxffsbench_verify("after remount");
+  (void)umount(MOUNTPT);
+
+  /* The FLASH stays allocated:  The NXFFS volume still refers to it */
+
+  if (nbad > 0)
+    {
+      return EXIT_FAILURE;
+    }
+
+  printf("  data verified\n");
+  return EXIT_SUCCESS;
+
+errout_with_mount:
+  (void)umount(MOUNTPT);
+
+  /* The FLASH cannot be freed once the RAM MTD device refers to it */
+
+errout:
+  return EXIT_FAILURE;
+}
@@ -0,0 +1,301 @@
+/****************************************************************************
+ * apps/nxfontbench/nxfontbench_main.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <time.h>
+#include <errno.h>
+
+#include <nuttx/arch.h>
+#include <nuttx/nx/nxglib.h>
+#include <nuttx/nx/nxfonts.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_EXAMPLES_NXFONTBENCH_NCHARS
+#  define CONFIG_EXAMPLES_NXFONTBENCH_NCHARS 200000
+#endif
+
+#define NCHARS       CONFIG_EXAMPLES_NXFONTBENCH_NCHARS
+
+/* The text is the printable ASCII characters, repeated */
+
+#define FIRST_CHAR   0x20
+#define NPRINTABLE   95
+
+/* Characters per line composed with nxf_cache_renderrun() */
+
+#define LINE_CHARS   40
+
+/* Glyphs cached in the hit and in the miss tests */
+
+#define HIT_GLYPHS   128
+#define MISS_GLYPHS  16
+
+#define FGCOLOR      0xffff
+#define BGCOLOR      0x0000
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxfontbench_gettime and nxfontbench_getfreq
+ *
+ * Description:
+ *   Return a free-running time stamp and its frequency.  Use the high
+ *   resolution counter if there is one:  The system timer may not advance
+ *   while the benchmark keeps the CPU busy (as in the simulation).
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_TIMESTATS
+#  define nxfontbench_gettime() up_perf_gettime()
+#  define nxfontbench_getfreq() up_perf_getfreq()
+#else
+static uint32_t nxfontbench_gettime(void)
+{
+  struct timespec ts;
+
+  (void)clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+#  define nxfontbench_getfreq() 1000000
+#endif
+
+/****************************************************************************
+ * Name: nxfontbench_report
+ *
+ * Description:
+ *   Print the rate of 'nchars' characters processed since 'start'.
+ *
+ ****************************************************************************/
+
+static void nxfontbench_report(FAR const char *what, uint32_t start,
+                               unsigned long nchars)
+{
+  uint64_t elapsed;
+
+  elapsed = (uint64_t)(uint32_t)(nxfontbench_gettime() - start) * 1000000 /
+            nxfontbench_getfreq();
+  if (elapsed == 0)
+    {
+      elapsed = 1;
+    }
+
+  printf("  %-22s %10lu chars/sec\n", what,
+         (unsigned long)(nchars * 1000000 / elapsed));
+}
+
+/****************************************************************************
+ * Name: nxfontbench_lookups
+ *
+ * Description:
+ *   Look up the glyphs of NCHARS characters one at a time, as text is
+ *   drawn character by character.
+ *
+ ****************************************************************************/
+
+static int nxfontbench_lookups(FAR const char *what, int maxglyphs)
+{
+  FAR const struct nxfonts_glyph_s *glyph;
+  FCACHE fcache;
+  uint32_t start;
+  int i;
+
+  fcache = nxf_cache_connect(FONTID_DEFAULT, FGCOLOR, BGCOLOR, 16,
+                             maxglyphs);
+  if (fcache == NULL)
+    {
+      printf("ERROR: nxf_cache_connect failed: %d\n", errno);
+      return -ENOMEM;
+    }
+
+  start = nxfontbench_gettime();
+  for (i = 0; i < NCHARS; i++)
+    {
+      glyph = nxf_cache_getglyph(fcache, FIRST_CHAR + i % NPRINTABLE);
+      if (glyph == NULL && i % NPRINTABLE != 0)
+        {
+          printf("ERROR: No glyph for %02x\n", FIRST_CHAR + i % NPRINTABLE);
+          nxf_cache_disconnect(fcache);
+          return -ENOENT;
+        }
+    }
+
+  nxfontbench_report(what, start, NCHARS);
+  nxf_cache_disconnect(fcache);
+  return OK;
+}
+
+/****************************************************************************
+ * Name: nxfontbench_runs
+ *
+ * Description:
+ *   Compose NCHARS characters into lines of LINE_CHARS characters with
+ *   nxf_cache_renderrun(), as NxTerm does with CONFIG_NXTERM_TEXTRUNS.
+ *
+ ****************************************************************************/
+
+static int nxfontbench_runs(void)
+{
+  FAR const struct nx_font_s *font;
+  nxf_code_t codes[LINE_CHARS];
+  FAR uint8_t *line;
+  FCACHE fcache;
+  unsigned int stride;
+  unsigned long nchars;
+  uint32_t start;
+  int ret;
+  int i;
+
+  fcache = nxf_cache_connect(FONTID_DEFAULT, FGCOLOR, BGCOLOR, 16,
+                             HIT_GLYPHS);
+  if (fcache == NULL)
+    {
+      printf("ERROR: nxf_cache_connect failed: %d\n", errno);
+      return -ENOMEM;
+    }
+
+  font   = nxf_getfontset(nxf_cache_getfonthandle(fcache));
+  stride = LINE_CHARS * font->mxwidth * sizeof(uint16_t);
+  line   = (FAR uint8_t *)malloc(stride * font->mxheight);
+  if (line == NULL)
+    {
+      printf("ERROR: Failed to allocate the line buffer\n");
+      ret = -ENOMEM;
+      goto errout_with_fcache;
+    }
+
+  start = nxfontbench_gettime();
+  for (nchars = 0; nchars < NCHARS; nchars += LINE_CHARS)
+    {
+      for (i = 0; i < LINE_CHARS; i++)
+        {
+          codes[i] = FIRST_CHAR + (nchars + i) % NPRINTABLE;
+        }
+
+      ret = nxf_cache_renderrun(fcache, line, font->mxheight, stride, 0,
+                                codes, LINE_CHARS, font->spwidth);
+      if (ret < 0)
+        {
+          printf("ERROR: nxf_cache_renderrun failed: %d\n", ret);
+          goto errout_with_line;
+        }
+    }
+
+  nxfontbench_report("nxf_cache_renderrun", start, nchars);
+  ret = OK;
+
+errout_with_line:
+  free(line);
+
+errout_with_fcache:
+  nxf_cache_disconnect(fcache);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: nxfontbench_widecodes
+ *
+ * Description:
+ *   Verify that a code beyond 16 bits does not find the glyph of the code
+ *   with the same lower bits.
+ *
+ ****************************************************************************/
+
+static int nxfontbench_widecodes(void)
+{
+  FCACHE fcache;
+  int ret = OK;
+
+  fcache = nxf_cache_connect(FONTID_DEFAULT, FGCOLOR, BGCOLOR, 16,
+                             HIT_GLYPHS);
+  if (fcache == NULL)
+    {
+      printf("ERROR: nxf_cache_connect failed: %d\n", errno);
+      return -ENOMEM;
+    }
+
+  if (nxf_cache_getglyph(fcache, 'A') == NULL ||
+      nxf_cache_getglyph(fcache, 0x10000 + 'A') != NULL ||
+      nxf_cache_getglyph(fcache, 0x1f600) != NULL)
+    {
+      printf("ERROR: Wide codes alias 16-bit codes\n");
+      ret = -EINVAL;
+    }
+
+  nxf_cache_disconnect(fcache);
+  return ret;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * nxfontbench_main
+ ****************************************************************************/
+
+#ifdef CONFIG_BUILD_KERNEL
+int main(int argc, FAR char *argv[])
+#else
+int nxfontbench_main(int argc, char *argv[])
+#endif
+{
+  printf("Font cache, %d characters, 16 bpp:\n", NCHARS);
+
+  if (nxfontbench_lookups("nxf_cache_getglyph", HIT_GLYPHS) < 0 ||
+      nxfontbench_lookups("nxf_cache_getglyph miss", MISS_GLYPHS) < 0 ||
+      nxfontbench_runs() < 0 ||
+      nxfontbench_widecodes() < 0)
+    {
+      return EXIT_FAILURE;
+    }
+
+  printf("Wide codes: OK\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,670 @@
+/****************************************************************************
+ * apps/nxglibbench/nxglibbench_main.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+#include <nuttx/arch.h>
+#include <nuttx/video/fb.h>
+#include <nuttx/nx/nxglib.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_EXAMPLES_NXGLIBBENCH_NREPS
+#  define CONFIG_EXAMPLES_NXGLIBBENCH_NREPS 50
+#endif
+
+#define NREPS          CONFIG_EXAMPLES_NXGLIBBENCH_NREPS
+
+/* Each operation is timed this many times and the fastest run is reported,
+ * so that preemption by the timer or by the host does not skew the result.
+ */
+
+#define NTRIALS        5
+
+/* The size of the framebuffer in memory */
+
+#define WIDTH          320
+#define HEIGHT         240
+
+/* Small fills, as for glyph backgrounds */
+
+#define SMALL_WIDTH    10
+#define SMALL_HEIGHT   16
+
+/* The copied image and its position in the source and in the framebuffer */
+
+#define BLIT_WIDTH     200
+#define BLIT_HEIGHT    150
+#define BLIT_SRCX      3
+#define BLIT_SRCY      5
+#define BLIT_DESTX     37
+#define BLIT_DESTY     41
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* One operation on the framebuffer */
+
+enum nxglibbench_op_e
+{
+  NXGLIBBENCH_FILL = 0,        /* Fill the whole framebuffer */
+  NXGLIBBENCH_SMALLFILL,       /* Fill small rectangles */
+  NXGLIBBENCH_BLIT,            /* Copy an image into the framebuffer */
+  NXGLIBBENCH_SCROLLUP,        /* Move the framebuffer up one row */
+  NXGLIBBENCH_SCROLLRIGHT,     /* Move the framebuffer right one pixel */
+  NXGLIBBENCH_NOPS
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const uint8_t g_bpp[] =
+{
+#ifndef CONFIG_NX_DISABLE_8BPP
+  8,
+#endif
+#ifndef CONFIG_NX_DISABLE_16BPP
+  16,
+#endif
+#ifndef CONFIG_NX_DISABLE_24BPP
+  24,
+#endif
+#ifndef CONFIG_NX_DISABLE_32BPP
+  32,
+#endif
+};
+
+#define NBPP (sizeof(g_bpp) / sizeof(uint8_t))
+
+static FAR const char *g_opname[NXGLIBBENCH_NOPS] =
+{
+  "fill 320x240",
+  "fill 10x16",
+  "copy 200x150",
+  "scroll up",
+  "scroll right"
+};
+
+static uint32_t g_seed;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxglibbench_gettime and nxglibbench_getfreq
+ *
+ * Description:
+ *   Return a free-running time stamp and its frequency.  Use the high
+ *   resolution counter if there is one:  The system timer may not advance
+ *   while the benchmark keeps the CPU busy (as in the simulation).
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_TIMESTATS
+#  define nxglibbench_gettime() up_perf_gettime()
+#  define nxglibbench_getfreq() up_perf_getfreq()
+#else
+static uint32_t nxglibbench_gettime(void)
+{
+  struct timespec ts;
+
+  (void)clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+#  define nxglibbench_getfreq() 1000000
+#endif
+
+/****************************************************************************
+ * Name: nxglibbench_usec
+ *
+ * Description:
+ *   Return the microseconds elapsed since 'start'.
+ *
+ ****************************************************************************/
+
+static unsigned long nxglibbench_usec(uint32_t start)
+{
+  unsigned long usec;
+
+  usec = (uint64_t)(uint32_t)(nxglibbench_gettime() - start) * 1000000 /
+         nxglibbench_getfreq();
+  return usec > 0 ? usec : 1;
+}
+
+/****************************************************************************
+ * Name: nxglibbench_random
+ ****************************************************************************/
+
+static uint32_t nxglibbench_random(void)
+{
+  g_seed = g_seed * 1103515245 + 12345;
+  return g_seed >> 8;
+}
+
+/****************************************************************************
+ * Name: nxglibbench_randomize
+ *
+ * Description:
+ *   Fill a buffer with random bytes.
+ *
+ ****************************************************************************/
+
+static void nxglibbench_randomize(FAR uint8_t *buffer, size_t size)
+{
+  for (; size > 0; size--)
+    {
+      *buffer++ = (uint8_t)nxglibbench_random();
+    }
+}
+
+/****************************************************************************
+ * Name: nxglibbench_setrect
+ ****************************************************************************/
+
+static void nxglibbench_setrect(FAR struct nxgl_rect_s *rect, int x, int y,
+                                int width, int height)
+{
+  rect->pt1.x = x;
+  rect->pt1.y = y;
+  rect->pt2.x = x + width - 1;
+  rect->pt2.y = y + height - 1;
+}
+
+/****************************************************************************
+ * Name: nxglibbench_fill, nxglibbench_copy and nxglibbench_move
+ *
+ * Description:
+ *   Call the library function for the color depth of the framebuffer.
+ *
+ ****************************************************************************/
+
+static void nxglibbench_fill(FAR struct fb_planeinfo_s *pinfo,
+                             FAR const struct nxgl_rect_s *rect,
+                             uint32_t color)
+{
+  switch (pinfo->bpp)
+    {
+#ifndef CONFIG_NX_DISABLE_8BPP
+      case 8:
+        nxgl_fillrectangle_8bpp(pinfo, rect, (uint8_t)color);
+        break;
+#endif
+#ifndef CONFIG_NX_DISABLE_16BPP
+      case 16:
+        nxgl_fillrectangle_16bpp(pinfo, rect, (uint16_t)color);
+        break;
+#endif
+#ifndef CONFIG_NX_DISABLE_24BPP
+      case 24:
+        nxgl_fillrectangle_24bpp(pinfo, rect, color & 0xffffff);
+        break;
+#endif
+#ifndef CONFIG_NX_DISABLE_32BPP
+      case 32:
+        nxgl_fillrectangle_32bpp(pinfo, rect, color);
+        break;
+#endif
+      default:
+        break;
+    }
+}
+
+static void nxglibbench_copy(FAR struct fb_planeinfo_s *pinfo,
+                             FAR const struct nxgl_rect_s *dest,
+                             FAR const void *src,
+                             FAR const struct nxgl_point_s *origin,
+                             unsigned int srcstride)
+{
+  switch (pinfo->bpp)
+    {
+#ifndef CONFIG_NX_DISABLE_8BPP
+      case 8:
+        nxgl_copyrectangle_8bpp(pinfo, dest, src, origin, srcstride);
+        break;
+#endif
+#ifndef CONFIG_NX_DISABLE_16BPP
+      case 16:
+        nxgl_copyrectangle_16bpp(pinfo, dest, src, origin, srcstride);
+        break;
+#endif
+#ifndef CONFIG_NX_DISABLE_24BPP
+      case 24:
+        nxgl_copyrectangle_24bpp(pinfo, dest, src, origin, srcstride);
+        break;
+#endif
+#ifndef CONFIG_NX_DISABLE_32BPP
+      case 32:
+        nxgl_copyrectangle_32bpp(pinfo, dest, src, origin, srcstride);
+        break;
+#endif
+      default:
+        break;
+    }
+}
+
+static void nxglibbench_move(FAR struct fb_planeinfo_s *pinfo,
+                             FAR const struct nxgl_rect_s *rect,
+                             FAR struct nxgl_point_s *offset)
+{
+  switch (pinfo->bpp)
+    {
+#ifndef CONFIG_NX_DISABLE_8BPP
+      case 8:
+        nxgl_moverectangle_8bpp(pinfo, rect, offset);
+        break;
+#endif
+#ifndef CONFIG_NX_DISABLE_16BPP
+      case 16:
+        nxgl_moverectangle_16bpp(pinfo, rect, offset);
+        break;
+#endif
+#ifndef CONFIG_NX_DISABLE_24BPP
+      case 24:
+        nxgl_moverectangle_24bpp(pinfo, rect, offset);
+        break;
+#endif
+#ifndef CONFIG_NX_DISABLE_32BPP
+      case 32:
+        nxgl_moverectangle_32bpp(pinfo, rect, offset);
+        break;
+#endif
+      default:
+        break;
+    }
+}
+
+/****************************************************************************
+ * Name: nxglibbench_reffill
+ *
+ * Description:
+ *   Fill a rectangle one pixel at a time.  16- and 32-bit pixels are in
+ *   native byte order; 24-bit pixels are packed, least significant byte
+ *   first.
+ *
+ ****************************************************************************/
+
+static void nxglibbench_reffill(FAR struct fb_planeinfo_s *pinfo,
+                                FAR const struct nxgl_rect_s *rect,
+                                uint32_t color)
+{
+  unsigned int bytespp = pinfo->bpp >> 3;
+  FAR uint8_t *dest;
+  uint16_t color16 = (uint16_t)color;
+  uint8_t pixel[4];
+  int x;
+  int y;
+
+  switch (bytespp)
+    {
+      case 1:
+        pixel[0] = (uint8_t)color;
+        break;
+
+      case 2:
+        memcpy(pixel, &color16, 2);
+        break;
+
+      case 3:
+        pixel[0] = (uint8_t)color;
+        pixel[1] = (uint8_t)(color >> 8);
+        pixel[2] = (uint8_t)(color >> 16);
+        break;
+
+      default:
+        memcpy(pixel, &color, 4);
+        break;
+    }
+
+  for (y = rect->pt1.y; y <= rect->pt2.y; y++)
+    {
+      dest = (FAR uint8_t *)pinfo->fbmem + y * pinfo->stride +
+             rect->pt1.x * bytespp;
+
+      for (x = rect->pt1.x; x <= rect->pt2.x; x++)
+        {
+          memcpy(dest, pixel, bytespp);
+          dest += bytespp;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: nxglibbench_refmove
+ *
+ * Description:
+ *   Copy a rectangle of 'src' to 'dest' one pixel at a time.  The source
+ *   and the destination may be the same framebuffer, so the source is
+ *   first copied to 'tmp'.
+ *
+ ****************************************************************************/
+
+static void nxglibbench_refmove(FAR struct fb_planeinfo_s *pinfo,
+                                FAR const uint8_t *src,
+                                unsigned int srcstride, int srcx, int srcy,
+                                int destx, int desty, int width, int height,
+                                FAR uint8_t *tmp)
+{
+  unsigned int bytespp = pinfo->bpp >> 3;
+  FAR uint8_t *dest;
+  int x;
+  int y;
+
+  for (y = 0; y < height; y++)
+    {
+      for (x = 0; x < width; x++)
+        {
+          memcpy(&tmp[(y * width + x) * bytespp],
+                 &src[(srcy + y) * srcstride + (srcx + x) * bytespp],
+                 bytespp);
+        }
+    }
+
+  for (y = 0; y < height; y++)
+    {
+      dest = (FAR uint8_t *)pinfo->fbmem + (desty + y) * pinfo->stride +
+             destx * bytespp;
+
+      for (x = 0; x < width; x++)
+        {
+          memcpy(dest, &tmp[(y * width + x) * bytespp], bytespp);
+          dest += bytespp;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: nxglibbench_run
+ *
+ * Description:
+ *   Do one operation 'nreps' times, with the library functions or with the
+ *   per-pixel reference.
+ *
+ * Returned Value:
+ *   The number of pixels written.
+ *
+ ****************************************************************************/
+
+static unsigned long nxglibbench_run(FAR struct fb_planeinfo_s *pinfo,
+                                     enum nxglibbench_op_e op, int nreps,
+                                     bool reference, FAR const uint8_t *src,
+                                     FAR uint8_t *tmp)
+{
+  struct nxgl_rect_s rect;
+  struct nxgl_point_s pos;
+  unsigned long npixels = 0;
+  int i;
+
+  for (i = 0; i < nreps; i++)
+    {
+      switch (op)
+        {
+          case NXGLIBBENCH_FILL:
+            nxglibbench_setrect(&rect, 0, 0, WIDTH, HEIGHT);
+            if (reference)
+              {
+                nxglibbench_reffill(pinfo, &rect, 0x5a3c96 + i);
+              }
+            else
+              {
+                nxglibbench_fill(pinfo, &rect, 0x5a3c96 + i);
+              }
+
+            npixels += WIDTH * HEIGHT;
+            break;
+
+          case NXGLIBBENCH_SMALLFILL:
+
+            /* Step through the framebuffer so that every alignment occurs */
+
+            nxglibbench_setrect(&rect,
+                                (i * 7) % (WIDTH - SMALL_WIDTH),
+                                (i * 13) % (HEIGHT - SMALL_HEIGHT),
+                                SMALL_WIDTH, SMALL_HEIGHT);
+            if (reference)
+              {
+                nxglibbench_reffill(pinfo, &rect, 0x123456 * i);
+              }
+            else
+              {
+                nxglibbench_fill(pinfo, &rect, 0x123456 * i);
+              }
+
+            npixels += SMALL_WIDTH * SMALL_HEIGHT;
+            break;
+
+          case NXGLIBBENCH_BLIT:
+            nxglibbench_setrect(&rect, BLIT_DESTX, BLIT_DESTY, BLIT_WIDTH,
+                                BLIT_HEIGHT);
+            if (reference)
+              {
+                nxglibbench_refmove(pinfo, src, pinfo->stride, BLIT_SRCX,
+                                    BLIT_SRCY, BLIT_DESTX, BLIT_DESTY,
+                                    BLIT_WIDTH, BLIT_HEIGHT, tmp);
+              }
+            else
+              {
+                pos.x = BLIT_DESTX - BLIT_SRCX;
+                pos.y = BLIT_DESTY - BLIT_SRCY;
+                nxglibbench_copy(pinfo, &rect, src, &pos, pinfo->stride);
+              }
+
+            npixels += BLIT_WIDTH * BLIT_HEIGHT;
+            break;
+
+          case NXGLIBBENCH_SCROLLUP:
+            if (reference)
+              {
+                nxglibbench_refmove(pinfo, pinfo->fbmem, pinfo->stride, 0,
+                                    1, 0, 0, WIDTH, HEIGHT - 1, tmp);
+              }
+            else
+              {
+                nxglibbench_setrect(&rect, 0, 1, WIDTH, HEIGHT - 1);
+                pos.x = 0;
+                pos.y = 0;
+                nxglibbench_move(pinfo, &rect, &pos);
+              }
+
+            npixels += WIDTH * (HEIGHT - 1);
+            break;
+
+          case NXGLIBBENCH_SCROLLRIGHT:
+            if (reference)
+              {
+                nxglibbench_refmove(pinfo, pinfo->fbmem, pinfo->stride, 0,
+                                    0, 1, 0, WIDTH - 1, HEIGHT, tmp);
+              }
+            else
+              {
+                nxglibbench_setrect(&rect, 0, 0, WIDTH - 1, HEIGHT);
+                pos.x = 1;
+                pos.y = 0;
+                nxglibbench_move(pinfo, &rect, &pos);
+              }
+
+            npixels += (WIDTH - 1) * HEIGHT;
+            break;
+
+          default:
+            break;
+        }
+    }
+
+  return npixels;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * nxglibbench_main
+ ****************************************************************************/
+
+#ifdef CONFIG_BUILD_KERNEL
+int main(int argc, FAR char *argv[])
+#else
+int nxglibbench_main(int argc, char *argv[])
+#endif
+{
+  struct fb_planeinfo_s pinfo;
+  struct fb_planeinfo_s refinfo;
+  FAR uint8_t *fb;
+  FAR uint8_t *ref;
+  FAR uint8_t *src;
+  FAR uint8_t *tmp;
+  unsigned long npixels;
+  unsigned long usec;
+  unsigned long best;
+  uint32_t start;
+  size_t fbsize;
+  int nerrors = 0;
+  bool ok;
+  int nreps;
+  int op;
+  int i;
+  int j;
+
+  /* Allocate buffers for the largest pixels */
+
+  fbsize = WIDTH * HEIGHT * 4;
+  fb     = (FAR uint8_t *)malloc(fbsize);
+  ref    = (FAR uint8_t *)malloc(fbsize);
+  src    = (FAR uint8_t *)malloc(fbsize);
+  tmp    = (FAR uint8_t *)malloc(fbsize);
+
+  if (fb == NULL || ref == NULL || src == NULL || tmp == NULL)
+    {
+      printf("ERROR: Failed to allocate %lu byte buffers\n",
+             (unsigned long)fbsize);
+      goto errout;
+    }
+
+  printf("Framebuffer %dx%d, best of %d x %d repetitions (Mpixels/sec):\n",
+         WIDTH, HEIGHT, NTRIALS, NREPS);
+
+  for (i = 0; i < NBPP; i++)
+    {
+      memset(&pinfo, 0, sizeof(pinfo));
+      pinfo.fbmem  = fb;
+      pinfo.stride = WIDTH * (g_bpp[i] >> 3);
+      pinfo.fblen  = pinfo.stride * HEIGHT;
+      pinfo.bpp    = g_bpp[i];
+
+      refinfo       = pinfo;
+      refinfo.fbmem = ref;
+
+      printf("  %2d bpp:\n", g_bpp[i]);
+
+      for (op = 0; op < NXGLIBBENCH_NOPS; op++)
+        {
+          nreps = op == NXGLIBBENCH_SMALLFILL ? 100 * NREPS : NREPS;
+
+          /* Check the result against the per-pixel reference */
+
+          g_seed = 12345;
+          nxglibbench_randomize(fb, pinfo.fblen);
+          nxglibbench_randomize(src, pinfo.fblen);
+          memcpy(ref, fb, pinfo.fblen);
+
+          (void)nxglibbench_run(&pinfo, op, nreps, false, src, tmp);
+          (void)nxglibbench_run(&refinfo, op, nreps, true, src, tmp);
+
+          ok = memcmp(fb, ref, pinfo.fblen) == 0;
+          if (!ok)
+            {
+              nerrors++;
+            }
+
+          /* Then time it */
+
+          for (j = 0, best = ULONG_MAX; j < NTRIALS; j++)
+            {
+              start   = nxglibbench_gettime();
+              npixels = nxglibbench_run(&pinfo, op, nreps, false, src, tmp);
+              usec    = nxglibbench_usec(start);
+
+              if (usec < best)
+                {
+                  best = usec;
+                }
+            }
+
+          printf("    %-14s %8lu.%lu%s\n", g_opname[op], npixels / best,
+                 (npixels * 10 / best) % 10, ok ? "" : "  (wrong result)");
+        }
+    }
+
+  free(fb);
+  free(ref);
+  free(src);
+  free(tmp);
+
+  if (nerrors > 0)
+    {
+      printf("ERROR: %d operations gave wrong results\n", nerrors);
+      return EXIT_FAILURE;
+    }
+
+  printf("  data verified\n");
+  return EXIT_SUCCESS;
+
+errout:
+  free(fb);
+  free(ref);
+  free(src);
+  free(tmp);
+  return EXIT_FAILURE;
+}
@@ -0,0 +1,446 @@
+/****************************************************************************
+ * apps/pipebench/pipebench_main.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+#include <errno.h>
+
+#include <nuttx/arch.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_EXAMPLES_PIPEBENCH_NBYTES
+#  define CONFIG_EXAMPLES_PIPEBENCH_NBYTES 262144
+#endif
+
+#ifndef CONFIG_EXAMPLES_PIPEBENCH_NROUNDTRIPS
+#  define CONFIG_EXAMPLES_PIPEBENCH_NROUNDTRIPS 2000
+#endif
+
+#ifndef CONFIG_EXAMPLES_PIPEBENCH_STACKSIZE
+#  define CONFIG_EXAMPLES_PIPEBENCH_STACKSIZE 2048
+#endif
+
+#define NBYTES      CONFIG_EXAMPLES_PIPEBENCH_NBYTES
+#define NROUNDTRIPS CONFIG_EXAMPLES_PIPEBENCH_NROUNDTRIPS
+
+/* The largest transfer size.  It is larger than the default pipe buffer so
+ * that the writer has to wait for the reader part way through a write.
+ */
+
+#define MAXXFER     4096
+#define NXFERSIZES  4
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* The transfer sizes used by both the producer and the consumer */
+
+static const size_t g_xfersize[NXFERSIZES] =
+{
+  1, 64, 512, MAXXFER
+};
+
+static uint8_t g_wrbuffer[MAXXFER];
+static uint8_t g_rdbuffer[MAXXFER];
+
+/* The transfer size and pipe descriptors used by the current test */
+
+static size_t g_size;
+static int g_fd[4];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: pipebench_gettime and pipebench_getfreq
+ *
+ * Description:
+ *   Return a free-running time stamp and its frequency.  Use the high
+ *   resolution counter if there is one:  The system timer may not advance
+ *   while the benchmark keeps the CPU busy (as in the simulation).
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_TIMESTATS
+#  define pipebench_gettime() up_perf_gettime()
+#  define pipebench_getfreq() up_perf_getfreq()
+#else
+static uint32_t pipebench_gettime(void)
+{
+  struct timespec ts;
+
+  (void)clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+#  define pipebench_getfreq() 1000000
+#endif
+
+/****************************************************************************
+ * Name: pipebench_usec
+ ****************************************************************************/
+
+static unsigned long pipebench_usec(uint32_t start)
+{
+  return (unsigned long)((uint64_t)(uint32_t)(pipebench_gettime() - start) *
+                         1000000 / pipebench_getfreq());
+}
+
+/****************************************************************************
+ * Name: pipebench_pattern
+ ****************************************************************************/
+
+static inline uint8_t pipebench_pattern(size_t offset)
+{
+  /* 251 is prime so that the pattern does not repeat with the pipe buffer */
+
+  return (uint8_t)(offset % 251);
+}
+
+/****************************************************************************
+ * Name: pipebench_producer
+ *
+ * Description:
+ *   Write NBYTES of the test pattern to the pipe, g_size bytes at a time.
+ *
+ ****************************************************************************/
+
+static FAR void *pipebench_producer(FAR void *arg)
+{
+  size_t offset;
+  size_t nwritten;
+  size_t i;
+  ssize_t nbytes;
+
+  for (offset = 0; offset < NBYTES; offset += g_size)
+    {
+      for (i = 0; i < g_size; i++)
+        {
+          g_wrbuffer[i] = pipebench_pattern(offset + i);
+        }
+
+      for (nwritten = 0; nwritten < g_size; nwritten += nbytes)
+        {
+          nbytes = write(g_fd[1], &g_wrbuffer[nwritten], g_size - nwritten);
+          if (nbytes <= 0)
+            {
+              printf("ERROR: write failed: %d\n", errno);
+              return NULL;
+            }
+        }
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: pipebench_echo
+ *
+ * Description:
+ *   Return each byte received on the first pipe through the second pipe
+ *   until the first pipe is closed.
+ *
+ ****************************************************************************/
+
+static FAR void *pipebench_echo(FAR void *arg)
+{
+  uint8_t ch;
+
+  while (read(g_fd[0], &ch, 1) == 1)
+    {
+      if (write(g_fd[3], &ch, 1) != 1)
+        {
+          printf("ERROR: echo write failed: %d\n", errno);
+          break;
+        }
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: pipebench_start
+ ****************************************************************************/
+
+static int pipebench_start(FAR pthread_t *thread,
+                           pthread_startroutine_t entry)
+{
+  pthread_attr_t attr;
+  int ret;
+
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, CONFIG_EXAMPLES_PIPEBENCH_STACKSIZE);
+  ret = pthread_create(thread, &attr, entry, NULL);
+  if (ret != 0)
+    {
+      printf("ERROR: pthread_create failed: %d\n", ret);
+      return -ret;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: pipebench_stream
+ *
+ * Description:
+ *   Stream NBYTES from a producer thread through a pipe and read them back
+ *   'size' bytes at a time.
+ *
+ * Returned Value:
+ *   The number of bad bytes received; a negated errno value on a failure.
+ *
+ ****************************************************************************/
+
+static int pipebench_stream(size_t size, FAR unsigned long *usec)
+{
+  pthread_t producer;
+  size_t offset = 0;
+  size_t i;
+  ssize_t nbytes;
+  uint32_t start;
+  int nbad = 0;
+  int ret;
+
+  if (pipe(g_fd) < 0)
+    {
+      printf("ERROR: pipe failed: %d\n", errno);
+      return -errno;
+    }
+
+  g_size = size;
+  start  = pipebench_gettime();
+
+  ret = pipebench_start(&producer, pipebench_producer);
+  if (ret < 0)
+    {
+      goto errout_with_pipe;
+    }
+
+  while (offset < NBYTES)
+    {
+      nbytes = read(g_fd[0], g_rdbuffer, size);
+      if (nbytes <= 0)
+        {
+          printf("ERROR: read failed at %lu: %d\n",
+                 (unsigned long)offset, errno);
+          ret = -EIO;
+          break;
+        }
+
+      for (i = 0; i < (size_t)nbytes; i++)
+        {
+          if (g_rdbuffer[i] != pipebench_pattern(offset + i))
+            {
+              nbad++;
+            }
+        }
+
+      offset += nbytes;
+    }
+
+  /* Close the read end first so that the producer cannot be left waiting
+   * for room in the pipe if the read failed.
+   */
+
+  (void)close(g_fd[0]);
+  (void)pthread_join(producer, NULL);
+  (void)close(g_fd[1]);
+
+  *usec = pipebench_usec(start);
+  return ret < 0 ? ret : nbad;
+
+errout_with_pipe:
+  (void)close(g_fd[0]);
+  (void)close(g_fd[1]);
+  return ret;
+}
+
+/****************************************************************************
+ * Name: pipebench_roundtrip
+ *
+ * Description:
+ *   Send one byte at a time to an echo thread and wait for it to come back.
+ *
+ * Returned Value:
+ *   The number of bad bytes received; a negated errno value on a failure.
+ *
+ ****************************************************************************/
+
+static int pipebench_roundtrip(FAR unsigned long *usec)
+{
+  pthread_t echo;
+  uint32_t start;
+  uint8_t ch;
+  int nbad = 0;
+  int ret;
+  int i;
+
+  if (pipe(&g_fd[0]) < 0)
+    {
+      printf("ERROR: pipe failed: %d\n", errno);
+      return -errno;
+    }
+
+  if (pipe(&g_fd[2]) < 0)
+    {
+      printf("ERROR: pipe failed: %d\n", errno);
+      ret = -errno;
+      goto errout_with_pipe;
+    }
+
+  ret = pipebench_start(&echo, pipebench_echo);
+  if (ret < 0)
+    {
+      goto errout_with_pipes;
+    }
+
+  start = pipebench_gettime();
+  for (i = 0; i < NROUNDTRIPS; i++)
+    {
+      ch = pipebench_pattern(i);
+      if (write(g_fd[1], &ch, 1) != 1 || read(g_fd[2], &ch, 1) != 1)
+        {
+          printf("ERROR: round trip %d failed: %d\n", i, errno);
+          ret = -EIO;
+          break;
+        }
+
+      if (ch != pipebench_pattern(i))
+        {
+          nbad++;
+        }
+    }
+
+  *usec = pipebench_usec(start);
+
+  /* Closing the write end of the first pipe stops the echo thread */
+
+  (void)close(g_fd[1]);
+  g_fd[1] = -1;
+  (void)pthread_join(echo, NULL);
+
+errout_with_pipes:
+  (void)close(g_fd[2]);
+  (void)close(g_fd[3]);
+
+errout_with_pipe:
+  (void)close(g_fd[0]);
+  if (g_fd[1] >= 0)
+    {
+      (void)close(g_fd[1]);
+    }
+
+  return ret < 0 ? ret : nbad;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * pipebench_main
+ ****************************************************************************/
+
+#ifdef CONFIG_BUILD_KERNEL
+int main(int argc, FAR char *argv[])
+#else
+int pipebench_main(int argc, char *argv[])
+#endif
+{
+  unsigned long usec = 0;
+  int nfailed = 0;
+  int nbad = 0;
+  int ret;
+  int i;
+
+  printf("Streaming %d bytes from a producer to a consumer thread:\n",
+         NBYTES);
+
+  for (i = 0; i < NXFERSIZES; i++)
+    {
+      ret = pipebench_stream(g_xfersize[i], &usec);
+      if (ret < 0)
+        {
+          nfailed++;
+          continue;
+        }
+
+      nbad += ret;
+      printf("  %4lu byte transfers %8lu usec %6lu KiB/sec\n",
+             (unsigned long)g_xfersize[i], usec,
+             usec > 0 ? (unsigned long)((uint64_t)NBYTES * 1000000 /
+                                        1024 / usec) : 0);
+    }
+
+  ret = pipebench_roundtrip(&usec);
+  if (ret < 0)
+    {
+      nfailed++;
+    }
+  else
+    {
+      nbad += ret;
+      printf("%d one byte round trips: %lu usec, %lu nsec each\n",
+             NROUNDTRIPS, usec,
+             (unsigned long)((uint64_t)usec * 1000 / NROUNDTRIPS));
+    }
+
+  if (nfailed > 0 || nbad > 0)
+    {
+      printf("ERROR: %d tests failed, %d bad bytes\n", nfailed, nbad);
+      return EXIT_FAILURE;
+    }
+
+  printf("  data verified\n");
+  return EXIT_SUCCESS;
+}
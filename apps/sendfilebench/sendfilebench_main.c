@@ -0,0 +1,546 @@
+/****************************************************************************
+ * apps/sendfilebench/sendfilebench_main.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/mount.h>
+#include <sys/socket.h>
+#include <sys/sendfile.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
+#include <errno.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include <nuttx/arch.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_EXAMPLES_SENDFILEBENCH_MOUNTPT
+#  define CONFIG_EXAMPLES_SENDFILEBENCH_MOUNTPT "/tmp"
+#endif
+
+#ifndef CONFIG_EXAMPLES_SENDFILEBENCH_PORT
+#  define CONFIG_EXAMPLES_SENDFILEBENCH_PORT 8080
+#endif
+
+#ifndef CONFIG_EXAMPLES_SENDFILEBENCH_FILESIZE
+#  define CONFIG_EXAMPLES_SENDFILEBENCH_FILESIZE 16384
+#endif
+
+#ifndef CONFIG_EXAMPLES_SENDFILEBENCH_NREQUESTS
+#  define CONFIG_EXAMPLES_SENDFILEBENCH_NREQUESTS 50
+#endif
+
+#define MOUNTPT     CONFIG_EXAMPLES_SENDFILEBENCH_MOUNTPT
+#define PORT        CONFIG_EXAMPLES_SENDFILEBENCH_PORT
+#define FILESIZE    CONFIG_EXAMPLES_SENDFILEBENCH_FILESIZE
+#define NREQUESTS   CONFIG_EXAMPLES_SENDFILEBENCH_NREQUESTS
+
+#define FILENAME    MOUNTPT "/index.html"
+#define IOSIZE      1024
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* The ways in which the server sends the file */
+
+enum sendfilebench_mode_e
+{
+  SENDFILEBENCH_COPY = 0,     /* read() into a buffer, then send() */
+  SENDFILEBENCH_SENDFILE,     /* sendfile() */
+  SENDFILEBENCH_MAPPED,       /* sendfile() of a file that has been mapped */
+  SENDFILEBENCH_NMODES
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const char *g_modename[SENDFILEBENCH_NMODES] =
+{
+  "read/send",
+  "sendfile",
+  "sendfile, mapped"
+};
+
+/* A simple (HTTP/0.9) request.  The response is the file alone, without a
+ * status line or header.
+ */
+
+static const char g_request[] = "GET /index.html\r\n";
+
+/* The server waits for the listening socket to be ready before the client
+ * connects and then serves NREQUESTS requests in each mode, in turn.
+ */
+
+static sem_t g_ready;
+static int g_nbad;
+
+static uint8_t g_srvbuffer[IOSIZE];
+static uint8_t g_clibuffer[IOSIZE];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sendfilebench_gettime and sendfilebench_getfreq
+ *
+ * Description:
+ *   Return a free-running time stamp and its frequency.  Use the high
+ *   resolution counter if there is one:  The system timer may not advance
+ *   while the benchmark keeps the CPU busy (as in the simulation).
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_TIMESTATS
+#  define sendfilebench_gettime() up_perf_gettime()
+#  define sendfilebench_getfreq() up_perf_getfreq()
+#else
+static uint32_t sendfilebench_gettime(void)
+{
+  struct timespec ts;
+
+  (void)clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+#  define sendfilebench_getfreq() 1000000
+#endif
+
+/****************************************************************************
+ * Name: sendfilebench_msec
+ ****************************************************************************/
+
+static unsigned long sendfilebench_msec(uint32_t start)
+{
+  return (unsigned long)((uint64_t)(uint32_t)(sendfilebench_gettime() -
+                                              start) *
+                         1000 / sendfilebench_getfreq());
+}
+
+/****************************************************************************
+ * Name: sendfilebench_pattern
+ ****************************************************************************/
+
+static inline uint8_t sendfilebench_pattern(off_t offset)
+{
+  return (uint8_t)(offset * 7 + 3);
+}
+
+/****************************************************************************
+ * Name: sendfilebench_create
+ *
+ * Description:
+ *   Create the file that is served.
+ *
+ ****************************************************************************/
+
+static int sendfilebench_create(void)
+{
+  off_t offset;
+  size_t nbytes;
+  size_t i;
+  int fd;
+
+  fd = open(FILENAME, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+  if (fd < 0)
+    {
+      printf("ERROR: Failed to open %s: %d\n", FILENAME, errno);
+      return -1;
+    }
+
+  for (offset = 0; offset < FILESIZE; offset += nbytes)
+    {
+      nbytes = FILESIZE - offset < IOSIZE ? FILESIZE - offset : IOSIZE;
+      for (i = 0; i < nbytes; i++)
+        {
+          g_clibuffer[i] = sendfilebench_pattern(offset + i);
+        }
+
+      if (write(fd, g_clibuffer, nbytes) != nbytes)
+        {
+          printf("ERROR: Failed to write %s: %d\n", FILENAME, errno);
+          (void)close(fd);
+          return -1;
+        }
+    }
+
+  (void)close(fd);
+  return 0;
+}
+
+/****************************************************************************
+ * Name: sendfilebench_respond
+ *
+ * Description:
+ *   Read one request from the connection and send the file in the response.
+ *
+ ****************************************************************************/
+
+static int sendfilebench_respond(int sd, int mode)
+{
+  size_t nrecvd;
+  ssize_t nbytes;
+  off_t offset;
+  int fd;
+
+  /* Read the request */
+
+  for (nrecvd = 0; nrecvd < sizeof(g_request) - 1; nrecvd += nbytes)
+    {
+      nbytes = recv(sd, &g_srvbuffer[nrecvd],
+                    sizeof(g_request) - 1 - nrecvd, 0);
+      if (nbytes <= 0)
+        {
+          return -1;
+        }
+    }
+
+  /* A web server opens the file for each request */
+
+  fd = open(FILENAME, O_RDONLY);
+  if (fd < 0)
+    {
+      return -1;
+    }
+
+  if (mode == SENDFILEBENCH_COPY)
+    {
+      for (offset = 0; offset < FILESIZE; offset += nbytes)
+        {
+          nbytes = read(fd, g_srvbuffer, IOSIZE);
+          if (nbytes <= 0 || send(sd, g_srvbuffer, nbytes, 0) != nbytes)
+            {
+              goto errout_with_fd;
+            }
+        }
+    }
+  else
+    {
+      offset = 0;
+      while (offset < FILESIZE)
+        {
+          nbytes = sendfile(sd, fd, &offset, FILESIZE - offset);
+          if (nbytes <= 0)
+            {
+              goto errout_with_fd;
+            }
+        }
+    }
+
+  (void)close(fd);
+  return 0;
+
+errout_with_fd:
+  (void)close(fd);
+  return -1;
+}
+
+/****************************************************************************
+ * Name: sendfilebench_server
+ *
+ * Description:
+ *   Accept NREQUESTS connections in each mode and respond to the request
+ *   made on each.
+ *
+ ****************************************************************************/
+
+static pthread_addr_t sendfilebench_server(pthread_addr_t arg)
+{
+  struct sockaddr_in addr;
+  socklen_t addrlen;
+  int listensd;
+  int sd;
+  int mode;
+  int i;
+
+  listensd = socket(PF_INET, SOCK_STREAM, 0);
+  if (listensd < 0)
+    {
+      printf("ERROR: socket failed: %d\n", errno);
+      goto errout;
+    }
+
+  addr.sin_family      = AF_INET;
+  addr.sin_port        = HTONS(PORT);
+  addr.sin_addr.s_addr = HTONL(INADDR_LOOPBACK);
+
+  if (bind(listensd, (FAR struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+      listen(listensd, 1) < 0)
+    {
+      printf("ERROR: bind/listen failed: %d\n", errno);
+      goto errout_with_listensd;
+    }
+
+  sem_post(&g_ready);
+
+  for (mode = 0; mode < SENDFILEBENCH_NMODES; mode++)
+    {
+      for (i = 0; i < NREQUESTS; i++)
+        {
+          addrlen = sizeof(addr);
+          sd = accept(listensd, (FAR struct sockaddr *)&addr, &addrlen);
+          if (sd < 0)
+            {
+              printf("ERROR: accept failed: %d\n", errno);
+              goto errout_with_listensd;
+            }
+
+          if (sendfilebench_respond(sd, mode) < 0)
+            {
+              g_nbad++;
+            }
+
+          (void)close(sd);
+        }
+    }
+
+  (void)close(listensd);
+  return NULL;
+
+errout_with_listensd:
+  (void)close(listensd);
+errout:
+  g_nbad++;
+  sem_post(&g_ready);
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: sendfilebench_get
+ *
+ * Description:
+ *   Connect to the server, request the file and verify the response.
+ *   Return the number of bad bytes or -1 if the request failed.
+ *
+ ****************************************************************************/
+
+static int sendfilebench_get(void)
+{
+  struct sockaddr_in addr;
+  ssize_t nbytes;
+  off_t offset;
+  int nbad = 0;
+  int sd;
+  int i;
+
+  sd = socket(PF_INET, SOCK_STREAM, 0);
+  if (sd < 0)
+    {
+      return -1;
+    }
+
+  addr.sin_family      = AF_INET;
+  addr.sin_port        = HTONS(PORT);
+  addr.sin_addr.s_addr = HTONL(INADDR_LOOPBACK);
+
+  if (connect(sd, (FAR struct sockaddr *)&addr, sizeof(addr)) < 0 ||
+      send(sd, g_request, sizeof(g_request) - 1, 0) !=
+        sizeof(g_request) - 1)
+    {
+      goto errout_with_sd;
+    }
+
+  /* Verify the file until the server closes the connection */
+
+  offset = 0;
+  do
+    {
+      nbytes = recv(sd, g_clibuffer, sizeof(g_clibuffer), 0);
+      for (i = 0; i < nbytes; i++, offset++)
+        {
+          if (g_clibuffer[i] != sendfilebench_pattern(offset))
+            {
+              nbad++;
+            }
+        }
+    }
+  while (nbytes > 0);
+
+  if (nbytes < 0 || offset != FILESIZE)
+    {
+      goto errout_with_sd;
+    }
+
+  (void)close(sd);
+  return nbad;
+
+errout_with_sd:
+  (void)close(sd);
+  return -1;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sendfilebench_main
+ ****************************************************************************/
+
+#ifdef CONFIG_BUILD_KERNEL
+int main(int argc, FAR char *argv[])
+#else
+int sendfilebench_main(int argc, char *argv[])
+#endif
+{
+  pthread_attr_t attr;
+  pthread_t server;
+  FAR void *map = MAP_FAILED;
+  uint32_t start;
+  int nfailed = 0;
+  int nbad = 0;
+  int mode;
+  int fd;
+  int ret;
+  int i;
+
+  /* Mount TMPFS unless it is already mounted */
+
+  ret = mount(NULL, MOUNTPT, "tmpfs", 0, NULL);
+  if (ret < 0 && errno != EEXIST && errno != EBUSY)
+    {
+      printf("ERROR: Failed to mount TMPFS at %s: %d\n", MOUNTPT, errno);
+      return EXIT_FAILURE;
+    }
+
+  if (sendfilebench_create() < 0)
+    {
+      return EXIT_FAILURE;
+    }
+
+  /* Start the server and wait until it is listening */
+
+  g_nbad = 0;
+  sem_init(&g_ready, 0, 0);
+
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, CONFIG_EXAMPLES_SENDFILEBENCH_STACKSIZE);
+  ret = pthread_create(&server, &attr, sendfilebench_server, NULL);
+  if (ret != 0)
+    {
+      printf("ERROR: pthread_create failed: %d\n", ret);
+      goto errout_with_file;
+    }
+
+  (void)sem_wait(&g_ready);
+
+  printf("%d requests for a %d byte file:\n", NREQUESTS, FILESIZE);
+
+  for (mode = 0; mode < SENDFILEBENCH_NMODES; mode++)
+    {
+      /* Map the file so that TMPFS holds it in one contiguous image.  The
+       * server then sends it directly from that image.
+       */
+
+      if (mode == SENDFILEBENCH_MAPPED)
+        {
+          fd = open(FILENAME, O_RDONLY);
+          if (fd >= 0)
+            {
+              map = mmap(NULL, FILESIZE, PROT_READ, MAP_SHARED | MAP_FILE,
+                         fd, 0);
+              (void)close(fd);
+            }
+
+          if (map == MAP_FAILED)
+            {
+              printf("ERROR: mmap failed: %d\n", errno);
+            }
+        }
+
+      start = sendfilebench_gettime();
+      for (i = 0; i < NREQUESTS; i++)
+        {
+          ret = sendfilebench_get();
+          if (ret < 0)
+            {
+              nfailed++;
+            }
+          else
+            {
+              nbad += ret;
+            }
+        }
+
+      printf("  %-16s %lu msec\n", g_modename[mode],
+             sendfilebench_msec(start));
+    }
+
+  pthread_join(server, NULL);
+
+  if (map != MAP_FAILED)
+    {
+      munmap(map, FILESIZE);
+    }
+
+  (void)unlink(FILENAME);
+  sem_destroy(&g_ready);
+
+  if (nfailed != 0 || g_nbad != 0 || nbad != 0)
+    {
+      printf("ERROR: %d requests failed, %d failed to respond, "
+             "%d bad bytes\n", nfailed, g_nbad, nbad);
+      return EXIT_FAILURE;
+    }
+
+  printf("  data verified\n");
+  return EXIT_SUCCESS;
+
+errout_with_file:
+  (void)unlink(FILENAME);
+  sem_destroy(&g_ready);
+  return EXIT_FAILURE;
+}
@@ -0,0 +1,415 @@
+/****************************************************************************
+ * apps/tmpfsbench/tmpfsbench_main.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <sys/mman.h>
+#include <sys/mount.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <time.h>
+#include <errno.h>
+
+#include <nuttx/arch.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_EXAMPLES_TMPFSBENCH_MOUNTPT
+#  define CONFIG_EXAMPLES_TMPFSBENCH_MOUNTPT "/tmp"
+#endif
+
+#ifndef CONFIG_EXAMPLES_TMPFSBENCH_FILESIZE
+#  define CONFIG_EXAMPLES_TMPFSBENCH_FILESIZE 262144
+#endif
+
+#define MOUNTPT     CONFIG_EXAMPLES_TMPFSBENCH_MOUNTPT
+#define FILESIZE    CONFIG_EXAMPLES_TMPFSBENCH_FILESIZE
+
+/* The files are appended to in turn, RECSIZE bytes at a time, and read
+ * back NREADS times, READSIZE bytes at a time.
+ */
+
+#define NFILES      4
+#define RECSIZE     100
+#define NREADS      20
+#define READSIZE    1024
+
+/* The file used by the mmap() test starts at MAPSIZE bytes and is then
+ * grown to MAPGROW times that size.
+ */
+
+#define MAPSIZE     1024
+#define MAPGROW     64
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static uint8_t g_buffer[READSIZE];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: tmpfsbench_gettime and tmpfsbench_getfreq
+ *
+ * Description:
+ *   Return a free-running time stamp and its frequency.  Use the high
+ *   resolution counter if there is one:  The system timer may not advance
+ *   while the benchmark keeps the CPU busy (as in the simulation).
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_TIMESTATS
+#  define tmpfsbench_gettime() up_perf_gettime()
+#  define tmpfsbench_getfreq() up_perf_getfreq()
+#else
+static uint32_t tmpfsbench_gettime(void)
+{
+  struct timespec ts;
+
+  (void)clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+#  define tmpfsbench_getfreq() 1000000
+#endif
+
+/****************************************************************************
+ * Name: tmpfsbench_msec
+ ****************************************************************************/
+
+static unsigned long tmpfsbench_msec(uint32_t start)
+{
+  return (unsigned long)((uint64_t)(uint32_t)(tmpfsbench_gettime() - start) *
+                         1000 / tmpfsbench_getfreq());
+}
+
+/****************************************************************************
+ * Name: tmpfsbench_pattern
+ ****************************************************************************/
+
+static inline uint8_t tmpfsbench_pattern(int file, off_t offset)
+{
+  return (uint8_t)(offset * 7 + file * 13 + 3);
+}
+
+/****************************************************************************
+ * Name: tmpfsbench_fill
+ ****************************************************************************/
+
+static void tmpfsbench_fill(FAR uint8_t *buffer, int file, off_t offset,
+                            size_t nbytes)
+{
+  size_t i;
+
+  for (i = 0; i < nbytes; i++)
+    {
+      buffer[i] = tmpfsbench_pattern(file, offset + i);
+    }
+}
+
+/****************************************************************************
+ * Name: tmpfsbench_check
+ *
+ * Description:
+ *   Return the number of bytes that do not match the pattern.
+ *
+ ****************************************************************************/
+
+static int tmpfsbench_check(FAR const uint8_t *buffer, int file,
+                            off_t offset, size_t nbytes)
+{
+  size_t i;
+  int nbad = 0;
+
+  for (i = 0; i < nbytes; i++)
+    {
+      if (buffer[i] != tmpfsbench_pattern(file, offset + i))
+        {
+          nbad++;
+        }
+    }
+
+  return nbad;
+}
+
+/****************************************************************************
+ * Name: tmpfsbench_append
+ *
+ * Description:
+ *   Append to NFILES files in turn, RECSIZE bytes at a time, then read all
+ *   of the files back NREADS times.
+ *
+ ****************************************************************************/
+
+static int tmpfsbench_append(void)
+{
+  char path[32];
+  int fd[NFILES];
+  uint32_t start;
+  off_t offset;
+  ssize_t nread;
+  size_t nbytes;
+  int nbad = 0;
+  int i;
+  int j;
+
+  for (i = 0; i < NFILES; i++)
+    {
+      snprintf(path, sizeof(path), "%s/bench%d", MOUNTPT, i);
+      fd[i] = open(path, O_RDWR | O_CREAT | O_TRUNC, 0666);
+      if (fd[i] < 0)
+        {
+          printf("ERROR: Failed to open %s: %d\n", path, errno);
+          while (--i >= 0)
+            {
+              (void)close(fd[i]);
+            }
+
+          return -1;
+        }
+    }
+
+  start = tmpfsbench_gettime();
+  for (offset = 0; offset < FILESIZE; offset += RECSIZE)
+    {
+      nbytes = FILESIZE - offset < RECSIZE ? FILESIZE - offset : RECSIZE;
+      for (i = 0; i < NFILES; i++)
+        {
+          tmpfsbench_fill(g_buffer, i, offset, nbytes);
+          if (write(fd[i], g_buffer, nbytes) != nbytes)
+            {
+              nbad++;
+            }
+        }
+    }
+
+  printf("  append %d x %d bytes in %d byte records: %lu msec\n",
+         NFILES, FILESIZE, RECSIZE, tmpfsbench_msec(start));
+
+  start = tmpfsbench_gettime();
+  for (j = 0; j < NREADS; j++)
+    {
+      for (i = 0; i < NFILES; i++)
+        {
+          (void)lseek(fd[i], 0, SEEK_SET);
+          for (offset = 0; offset < FILESIZE; offset += nread)
+            {
+              nread = read(fd[i], g_buffer, READSIZE);
+              if (nread <= 0)
+                {
+                  nbad++;
+                  break;
+                }
+
+              /* Verify the first and the last pass */
+
+              if (j == 0 || j == NREADS - 1)
+                {
+                  nbad += tmpfsbench_check(g_buffer, i, offset, nread);
+                }
+            }
+        }
+    }
+
+  printf("  read back %d times: %lu msec\n", NREADS,
+         tmpfsbench_msec(start));
+
+  for (i = 0; i < NFILES; i++)
+    {
+      (void)close(fd[i]);
+      snprintf(path, sizeof(path), "%s/bench%d", MOUNTPT, i);
+      (void)unlink(path);
+    }
+
+  return nbad;
+}
+
+/****************************************************************************
+ * Name: tmpfsbench_mmap
+ *
+ * Description:
+ *   Map a file, grow it well beyond its mapped image and map it again.  The
+ *   first mapping must still hold the data of the file as it was mapped.
+ *   Heap memory is allocated and overwritten in between, so that the test
+ *   also fails if the first image has been freed.
+ *
+ ****************************************************************************/
+
+static int tmpfsbench_mmap(void)
+{
+  char path[32];
+  FAR uint8_t *map1;
+  FAR uint8_t *map2;
+  FAR uint8_t *scratch;
+  off_t offset;
+  int nbad = 0;
+  int fd;
+  int i;
+
+  snprintf(path, sizeof(path), "%s/mmap", MOUNTPT);
+  fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0666);
+  if (fd < 0)
+    {
+      printf("ERROR: Failed to open %s: %d\n", path, errno);
+      return -1;
+    }
+
+  tmpfsbench_fill(g_buffer, 0, 0, MAPSIZE);
+  if (write(fd, g_buffer, MAPSIZE) != MAPSIZE)
+    {
+      nbad++;
+    }
+
+  map1 = (FAR uint8_t *)mmap(NULL, MAPSIZE, PROT_READ, MAP_SHARED | MAP_FILE,
+                             fd, 0);
+  if (map1 == MAP_FAILED)
+    {
+      printf("ERROR: mmap failed: %d\n", errno);
+      goto errout_with_fd;
+    }
+
+  nbad += tmpfsbench_check(map1, 0, 0, MAPSIZE);
+
+  /* Grow the file past the image and map it again */
+
+  for (i = 1; i < MAPGROW; i++)
+    {
+      tmpfsbench_fill(g_buffer, 0, i * MAPSIZE, MAPSIZE);
+      if (write(fd, g_buffer, MAPSIZE) != MAPSIZE)
+        {
+          nbad++;
+        }
+    }
+
+  map2 = (FAR uint8_t *)mmap(NULL, MAPGROW * MAPSIZE, PROT_READ,
+                             MAP_SHARED | MAP_FILE, fd, 0);
+  if (map2 == MAP_FAILED)
+    {
+      printf("ERROR: mmap failed: %d\n", errno);
+      goto errout_with_map1;
+    }
+
+  /* Reuse any memory that has been freed */
+
+  scratch = (FAR uint8_t *)malloc(MAPGROW * MAPSIZE);
+  if (scratch != NULL)
+    {
+      memset(scratch, 0xaa, MAPGROW * MAPSIZE);
+    }
+
+  for (offset = 0; offset < MAPGROW * MAPSIZE; offset += MAPSIZE)
+    {
+      nbad += tmpfsbench_check(&map2[offset], 0, offset, MAPSIZE);
+    }
+
+  nbad += tmpfsbench_check(map1, 0, 0, MAPSIZE);
+
+  printf("  mmap %d bytes, grow to %d bytes and mmap again: %s\n",
+         MAPSIZE, MAPGROW * MAPSIZE,
+         map1 != map2 ? "image moved" : "image in place");
+
+  free(scratch);
+  munmap(map2, MAPGROW * MAPSIZE);
+  munmap(map1, MAPSIZE);
+  (void)close(fd);
+  (void)unlink(path);
+  return nbad;
+
+errout_with_map1:
+  munmap(map1, MAPSIZE);
+errout_with_fd:
+  (void)close(fd);
+  (void)unlink(path);
+  return -1;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: tmpfsbench_main
+ ****************************************************************************/
+
+#ifdef CONFIG_BUILD_KERNEL
+int main(int argc, FAR char *argv[])
+#else
+int tmpfsbench_main(int argc, char *argv[])
+#endif
+{
+  int nbad;
+  int ret;
+
+  /* Mount TMPFS unless it is already mounted */
+
+  ret = mount(NULL, MOUNTPT, "tmpfs", 0, NULL);
+  if (ret < 0 && errno != EEXIST && errno != EBUSY)
+    {
+      printf("ERROR: Failed to mount TMPFS at %s: %d\n", MOUNTPT, errno);
+      return EXIT_FAILURE;
+    }
+
+  printf("%s:\n", MOUNTPT);
+
+  nbad = tmpfsbench_append();
+  if (nbad >= 0)
+    {
+      ret = tmpfsbench_mmap();
+      nbad = ret < 0 ? ret : nbad + ret;
+    }
+
+  if (nbad != 0)
+    {
+      printf("ERROR: %d bad bytes\n", nbad);
+      return EXIT_FAILURE;
+    }
+
+  printf("  data verified\n");
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,1909 @@
+/****************************************************************************
+ * apps/vncbench/vncbench_main.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <time.h>
+#include <errno.h>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+
+#include <nuttx/arch.h>
+#include <nuttx/nx/nxglib.h>
+#include <nuttx/nx/nx.h>
+#include <nuttx/video/fb.h>
+#include <nuttx/video/rfb.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_EXAMPLES_VNCBENCH_NFRAMES
+#  define CONFIG_EXAMPLES_VNCBENCH_NFRAMES 24
+#endif
+
+#ifndef CONFIG_EXAMPLES_VNCBENCH_STACKSIZE
+#  define CONFIG_EXAMPLES_VNCBENCH_STACKSIZE 2048
+#endif
+
+#define NFRAMES       CONFIG_EXAMPLES_VNCBENCH_NFRAMES
+#define WIDTH         CONFIG_VNCSERVER_SCREENWIDTH
+#define HEIGHT        CONFIG_VNCSERVER_SCREENHEIGHT
+
+/* The VNC server for display 0 listens on this port */
+
+#define VNC_PORT      5900
+
+/* Time allowed for each frame to arrive, in seconds */
+
+#define FRAME_TIMEOUT 10
+
+/* The client pixel format is 32 bits per pixel, little endian, 8 bits per
+ * color component.  ZRLE sends such pixels in three bytes.
+ */
+
+#define BYTESPP       4
+#define ZRLE_BYTESPP  3
+
+/* An RGB565 pixel value */
+
+#define RGB(r,g,b)    ((uint16_t)((((r) >> 3) << 11) | (((g) >> 2) << 5) | \
+                                  ((b) >> 3)))
+
+/* ZRLE: The size of the zlib history window, the tile size and the largest
+ * amount of decompressed data for one rectangle (raw tiles plus room for
+ * palettes).
+ */
+
+#define ZRLE_WINDOW   32768
+#define ZRLE_TILESIZE 64
+#define ZRLE_NTILES   (((WIDTH + ZRLE_TILESIZE - 1) / ZRLE_TILESIZE) * \
+                       ((HEIGHT + ZRLE_TILESIZE - 1) / ZRLE_TILESIZE))
+#define ZRLE_OUTSIZE  (ZRLE_BYTESPP * WIDTH * HEIGHT + \
+                       ZRLE_NTILES * (1 + 127 * ZRLE_BYTESPP))
+
+/* Hextile tile size */
+
+#define HEXTILE_SIZE  16
+
+/* CopyRect is used only if the server supports it and NX reports moves */
+
+#if defined(CONFIG_VNCSERVER_COPYRECT) && defined(CONFIG_NX_UPDATE_MOVE)
+#  define HAVE_COPYRECT 1
+#endif
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* One set of encodings:  The encoding that is requested and whether
+ * CopyRect is requested as well.
+ */
+
+struct vncbench_session_s
+{
+  FAR const char *name;
+  int32_t encoding;
+  bool copyrect;
+};
+
+/* One scene:  A function that draws one frame and the number of frames */
+
+struct vncbench_scene_s
+{
+  FAR const char *name;
+  CODE void (*draw)(int frame);
+  int nframes;
+};
+
+/* The state of the built-in decompressor for ZRLE */
+
+struct vncbench_inflate_s
+{
+  FAR const uint8_t *in;      /* Compressed data */
+  size_t inlen;               /* Length of the compressed data */
+  size_t inpos;               /* Next byte of compressed data */
+  uint32_t bitbuf;            /* Bits not yet used */
+  int nbits;                  /* Number of bits in bitbuf */
+  size_t outpos;              /* Next byte of decompressed data */
+  bool error;                 /* True: Bad or unsupported data */
+};
+
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static void vncbench_scroll(int frame);
+static void vncbench_widgets(int frame);
+static void vncbench_photo(int frame);
+static void vncbench_redraw(int frame);
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const struct vncbench_session_s g_sessions[] =
+{
+  { "raw",               RFB_ENCODING_RAW,     false },
+#ifdef CONFIG_VNCSERVER_HEXTILE
+  { "hextile",           RFB_ENCODING_HEXTILE, false },
+#endif
+#ifdef CONFIG_VNCSERVER_ZRLE
+  { "zrle",              RFB_ENCODING_ZRLE,    false },
+#endif
+#ifdef HAVE_COPYRECT
+  { "raw + copyrect",     RFB_ENCODING_RAW,     true  },
+#ifdef CONFIG_VNCSERVER_HEXTILE
+  { "hextile + copyrect", RFB_ENCODING_HEXTILE, true  },
+#endif
+#ifdef CONFIG_VNCSERVER_ZRLE
+  { "zrle + copyrect",    RFB_ENCODING_ZRLE,    true  },
+#endif
+#endif
+};
+
+#define NSESSIONS (sizeof(g_sessions) / sizeof(struct vncbench_session_s))
+
+static const struct vncbench_scene_s g_scenes[] =
+{
+  { "scroll",  vncbench_scroll,  NFRAMES     },
+  { "widgets", vncbench_widgets, NFRAMES     },
+  { "photo",   vncbench_photo,   NFRAMES / 2 },
+  { "redraw",  vncbench_redraw,  NFRAMES / 2 }
+};
+
+#define NSCENES (sizeof(g_scenes) / sizeof(struct vncbench_scene_s))
+
+/* Length and extra bits of the deflate length and distance codes */
+
+static const uint16_t g_lenbase[29] =
+{
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59,
+  67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+static const uint8_t g_lenextra[29] =
+{
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4,
+  5, 5, 5, 5, 0
+};
+
+static const uint16_t g_distbase[30] =
+{
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513,
+  769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577
+};
+
+static const uint8_t g_distextra[30] =
+{
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10,
+  11, 11, 12, 12, 13, 13
+};
+
+/* The framebuffer of the display */
+
+static struct fb_planeinfo_s g_pinfo;
+static uint32_t g_seed;
+
+/* The client connection and its copy of the display (RGB565) */
+
+static int g_sd;
+static uint16_t g_client[HEIGHT][WIDTH];
+static uint8_t g_buffer[WIDTH * BYTESPP];
+
+/* The client thread and the main thread share these under g_lock */
+
+static pthread_mutex_t g_lock;
+static sem_t g_match;          /* Posted when a frame is complete */
+static bool g_waiting;         /* True: g_match is waited for */
+static bool g_stop;            /* True: The client should disconnect */
+static bool g_failed;          /* True: The client has failed */
+static int32_t g_encoding;     /* Encoding of the last update (not CopyRect) */
+static uint32_t g_nbytes;      /* Bytes received */
+
+#ifdef CONFIG_VNCSERVER_ZRLE
+/* ZRLE:  Compressed data and the decompressed data after the history */
+
+static FAR uint8_t *g_zin;
+static size_t g_zinsize;
+static FAR uint8_t *g_zout;
+static size_t g_zhist;
+static bool g_zheader;
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: vncbench_gettime and vncbench_getfreq
+ *
+ * Description:
+ *   Return a free-running time stamp and its frequency.  Use the high
+ *   resolution counter if there is one:  The system timer may not advance
+ *   while the benchmark keeps the CPU busy (as in the simulation).
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_TIMESTATS
+#  define vncbench_gettime() up_perf_gettime()
+#  define vncbench_getfreq() up_perf_getfreq()
+#else
+static uint32_t vncbench_gettime(void)
+{
+  struct timespec ts;
+
+  (void)clock_gettime(CLOCK_REALTIME, &ts);
+  return ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+#  define vncbench_getfreq() 1000000
+#endif
+
+/****************************************************************************
+ * Name: vncbench_usec
+ ****************************************************************************/
+
+static unsigned long vncbench_usec(uint32_t start)
+{
+  return (unsigned long)((uint64_t)(uint32_t)(vncbench_gettime() - start) *
+                         1000000 / vncbench_getfreq());
+}
+
+/****************************************************************************
+ * Name: vncbench_random
+ ****************************************************************************/
+
+static uint32_t vncbench_random(void)
+{
+  g_seed = g_seed * 1103515245 + 12345;
+  return g_seed >> 8;
+}
+
+/****************************************************************************
+ * Name: vncbench_pixel
+ *
+ * Description:
+ *   Return the framebuffer pixel at (x,y).
+ *
+ ****************************************************************************/
+
+static inline FAR uint16_t *vncbench_pixel(int x, int y)
+{
+  return (FAR uint16_t *)((FAR uint8_t *)g_pinfo.fbmem + y * g_pinfo.stride) +
+         x;
+}
+
+/****************************************************************************
+ * Name: vncbench_notify
+ ****************************************************************************/
+
+static void vncbench_notify(int x1, int y1, int x2, int y2)
+{
+  struct nxgl_rect_s rect;
+
+  rect.pt1.x = x1;
+  rect.pt1.y = y1;
+  rect.pt2.x = x2;
+  rect.pt2.y = y2;
+  nx_notify_rectangle(&g_pinfo, &rect);
+}
+
+/****************************************************************************
+ * Name: vncbench_fill
+ ****************************************************************************/
+
+static void vncbench_fill(int x1, int y1, int x2, int y2, uint16_t color)
+{
+  FAR uint16_t *dest;
+  int x;
+  int y;
+
+  for (y = y1; y <= y2; y++)
+    {
+      dest = vncbench_pixel(x1, y);
+      for (x = x1; x <= x2; x++)
+        {
+          *dest++ = color;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: vncbench_text
+ *
+ * Description:
+ *   Draw a line of 'n' random 6x10 glyphs with some blanks between them.
+ *
+ ****************************************************************************/
+
+static void vncbench_text(int x0, int y0, int n, uint16_t color)
+{
+  uint32_t bits;
+  int i;
+  int x;
+  int y;
+
+  for (i = 0; i < n; i++, x0 += 6)
+    {
+      if ((vncbench_random() & 7) == 0)
+        {
+          continue;
+        }
+
+      bits = vncbench_random() ^ (vncbench_random() << 12);
+      for (y = 1; y < 9; y++)
+        {
+          for (x = 1; x < 5; x++)
+            {
+              if ((bits & 1) != 0)
+                {
+                  *vncbench_pixel(x0 + x, y0 + y) = color;
+                }
+
+              bits >>= 1;
+              if (bits == 0)
+                {
+                  bits = vncbench_random();
+                }
+            }
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: vncbench_scroll
+ *
+ * Description:
+ *   Scroll a terminal up by one line of text and draw a new last line.
+ *
+ ****************************************************************************/
+
+static void vncbench_scroll(int frame)
+{
+#ifdef CONFIG_NX_UPDATE_MOVE
+  struct nxgl_rect_s rect;
+  struct nxgl_point_s offset;
+#endif
+  int y;
+
+  for (y = 0; y < HEIGHT - 10; y++)
+    {
+      memcpy(vncbench_pixel(0, y), vncbench_pixel(0, y + 10),
+             WIDTH * sizeof(uint16_t));
+    }
+
+#ifdef CONFIG_NX_UPDATE_MOVE
+  rect.pt1.x  = 0;
+  rect.pt1.y  = 10;
+  rect.pt2.x  = WIDTH - 1;
+  rect.pt2.y  = HEIGHT - 1;
+  offset.x    = 0;
+  offset.y    = 0;
+  nx_notify_move(&g_pinfo, &rect, &offset);
+#else
+  vncbench_notify(0, 0, WIDTH - 1, HEIGHT - 11);
+#endif
+
+  vncbench_fill(0, HEIGHT - 10, WIDTH - 1, HEIGHT - 1, RGB(16, 16, 48));
+  vncbench_text(4, HEIGHT - 10, 20 + vncbench_random() % 32,
+                (frame & 1) ? RGB(220, 220, 220) : RGB(120, 250, 120));
+  vncbench_notify(0, HEIGHT - 10, WIDTH - 1, HEIGHT - 1);
+}
+
+/****************************************************************************
+ * Name: vncbench_widgets
+ *
+ * Description:
+ *   Redraw six buttons, a progress bar and a clock.
+ *
+ ****************************************************************************/
+
+static void vncbench_widgets(int frame)
+{
+  uint16_t face;
+  int bar;
+  int x;
+  int y;
+  int i;
+
+  for (i = 0; i < 6; i++)
+    {
+      x    = 8 + (i % 3) * 104;
+      y    = 40 + (i / 3) * 40;
+      face = ((frame + i) % 3 == 0) ? RGB(90, 140, 220) : RGB(200, 200, 200);
+
+      vncbench_fill(x, y, x + 95, y + 29, RGB(60, 60, 60));
+      vncbench_fill(x + 1, y + 1, x + 94, y + 28, face);
+      vncbench_text(x + 10, y + 10, 12, RGB(0, 0, 0));
+      vncbench_notify(x, y, x + 95, y + 29);
+    }
+
+  bar = 8 + (frame * 5) % 300;
+  vncbench_fill(8, 150, bar, 165, RGB(40, 200, 80));
+  vncbench_fill(bar + 1, 150, 308, 165, RGB(230, 230, 230));
+  vncbench_notify(8, 150, 308, 165);
+
+  vncbench_fill(240, 4, 315, 16, RGB(30, 30, 90));
+  vncbench_text(242, 5, 12, RGB(255, 255, 255));
+  vncbench_notify(240, 4, 315, 16);
+}
+
+/****************************************************************************
+ * Name: vncbench_photo
+ *
+ * Description:
+ *   Redraw a 160x120 image of gradients with noise.
+ *
+ ****************************************************************************/
+
+static void vncbench_photo(int frame)
+{
+  int x;
+  int y;
+
+  for (y = 60; y < 180; y++)
+    {
+      for (x = 80; x < 240; x++)
+        {
+          *vncbench_pixel(x, y) =
+            RGB((x * 2 + frame * 3) & 0xff, (y * 2 + frame) & 0xff,
+                (x + y + (vncbench_random() & 15)) & 0xff);
+        }
+    }
+
+  vncbench_notify(80, 60, 239, 179);
+}
+
+/****************************************************************************
+ * Name: vncbench_redraw
+ *
+ * Description:
+ *   Redraw the whole display:  A background with three windows of text.
+ *
+ ****************************************************************************/
+
+static void vncbench_redraw(int frame)
+{
+  int x;
+  int y;
+  int i;
+
+  vncbench_fill(0, 0, WIDTH - 1, HEIGHT - 1, RGB(0, 90, 110));
+
+  for (i = 0; i < 3; i++)
+    {
+      x = 10 + i * 60 + (frame * 3) % 40;
+      y = 20 + i * 50;
+
+      vncbench_fill(x, y, x + 139, y + 89, RGB(250, 250, 250));
+      vncbench_fill(x, y, x + 139, y + 11, RGB(40, 70, 160));
+      vncbench_text(x + 4, y + 1, 10, RGB(255, 255, 255));
+      vncbench_text(x + 4, y + 20, 20, RGB(0, 0, 0));
+      vncbench_text(x + 4, y + 40, 20, RGB(0, 0, 0));
+      vncbench_text(x + 4, y + 60, 20, RGB(0, 0, 0));
+    }
+
+  vncbench_notify(0, 0, WIDTH - 1, HEIGHT - 1);
+}
+
+/****************************************************************************
+ * Name: vncbench_recv
+ *
+ * Description:
+ *   Receive exactly 'len' bytes from the server.
+ *
+ ****************************************************************************/
+
+static int vncbench_recv(FAR void *buffer, size_t len)
+{
+  FAR uint8_t *ptr = (FAR uint8_t *)buffer;
+  ssize_t nrecvd;
+
+  while (len > 0)
+    {
+      nrecvd = recv(g_sd, ptr, len, 0);
+      if (nrecvd <= 0)
+        {
+          return nrecvd < 0 ? -errno : -ECONNRESET;
+        }
+
+      ptr      += nrecvd;
+      len      -= nrecvd;
+      g_nbytes += nrecvd;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: vncbench_rgb
+ *
+ * Description:
+ *   Convert a client pixel (little endian, red in bits 16-23) to RGB565.
+ *
+ ****************************************************************************/
+
+static inline uint16_t vncbench_rgb(FAR const uint8_t *src)
+{
+  return RGB(src[2], src[1], src[0]);
+}
+
+/****************************************************************************
+ * Name: vncbench_outside
+ ****************************************************************************/
+
+static bool vncbench_outside(int x, int y, int w, int h)
+{
+  return x + w > WIDTH || y + h > HEIGHT;
+}
+
+/****************************************************************************
+ * Name: vncbench_fillclient
+ ****************************************************************************/
+
+static void vncbench_fillclient(int x, int y, int w, int h, uint16_t color)
+{
+  int i;
+  int j;
+
+  for (j = y; j < y + h; j++)
+    {
+      for (i = x; i < x + w; i++)
+        {
+          g_client[j][i] = color;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: vncbench_raw
+ ****************************************************************************/
+
+static int vncbench_raw(int x, int y, int w, int h)
+{
+  int ret;
+  int i;
+  int j;
+
+  for (j = y; j < y + h; j++)
+    {
+      ret = vncbench_recv(g_buffer, w * BYTESPP);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      for (i = 0; i < w; i++)
+        {
+          g_client[j][x + i] = vncbench_rgb(&g_buffer[i * BYTESPP]);
+        }
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: vncbench_copyrect
+ ****************************************************************************/
+
+#ifdef HAVE_COPYRECT
+static int vncbench_copyrect(int x, int y, int w, int h)
+{
+  uint8_t pos[4];
+  int srcx;
+  int srcy;
+  int ret;
+  int j;
+
+  ret = vncbench_recv(pos, 4);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  srcx = rfb_getbe16(&pos[0]);
+  srcy = rfb_getbe16(&pos[2]);
+  if (vncbench_outside(srcx, srcy, w, h))
+    {
+      return -EPROTO;
+    }
+
+  /* Copy in the direction that does not overwrite the source */
+
+  if (srcy < y)
+    {
+      for (j = h - 1; j >= 0; j--)
+        {
+          memmove(&g_client[y + j][x], &g_client[srcy + j][srcx],
+                  w * sizeof(uint16_t));
+        }
+    }
+  else
+    {
+      for (j = 0; j < h; j++)
+        {
+          memmove(&g_client[y + j][x], &g_client[srcy + j][srcx],
+                  w * sizeof(uint16_t));
+        }
+    }
+
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: vncbench_hextile
+ ****************************************************************************/
+
+#ifdef CONFIG_VNCSERVER_HEXTILE
+static int vncbench_hextile(int x, int y, int w, int h)
+{
+  uint16_t bg = 0;
+  uint16_t fg = 0;
+  uint8_t subencoding;
+  uint8_t subrect[BYTESPP + 2];
+  uint8_t nsubrects;
+  int tx;
+  int ty;
+  int tw;
+  int th;
+  int ret;
+  int i;
+
+  for (ty = y; ty < y + h; ty += HEXTILE_SIZE)
+    {
+      th = y + h - ty < HEXTILE_SIZE ? y + h - ty : HEXTILE_SIZE;
+
+      for (tx = x; tx < x + w; tx += HEXTILE_SIZE)
+        {
+          tw = x + w - tx < HEXTILE_SIZE ? x + w - tx : HEXTILE_SIZE;
+
+          ret = vncbench_recv(&subencoding, 1);
+          if (ret < 0)
+            {
+              return ret;
+            }
+
+          if ((subencoding & RFB_SUBENCODING_RAW) != 0)
+            {
+              ret = vncbench_raw(tx, ty, tw, th);
+              if (ret < 0)
+                {
+                  return ret;
+                }
+
+              continue;
+            }
+
+          if ((subencoding & RFB_SUBENCODING_BACK) != 0)
+            {
+              ret = vncbench_recv(g_buffer, BYTESPP);
+              if (ret < 0)
+                {
+                  return ret;
+                }
+
+              bg = vncbench_rgb(g_buffer);
+            }
+
+          if ((subencoding & RFB_SUBENCODING_FORE) != 0)
+            {
+              ret = vncbench_recv(g_buffer, BYTESPP);
+              if (ret < 0)
+                {
+                  return ret;
+                }
+
+              fg = vncbench_rgb(g_buffer);
+            }
+
+          vncbench_fillclient(tx, ty, tw, th, bg);
+
+          if ((subencoding & RFB_SUBENCODING_ANY) == 0)
+            {
+              continue;
+            }
+
+          ret = vncbench_recv(&nsubrects, 1);
+          if (ret < 0)
+            {
+              return ret;
+            }
+
+          for (i = 0; i < nsubrects; i++)
+            {
+              FAR uint8_t *xy = subrect;
+
+              if ((subencoding & RFB_SUBENCODING_COLORED) != 0)
+                {
+                  ret = vncbench_recv(subrect, BYTESPP + 2);
+                  fg  = vncbench_rgb(subrect);
+                  xy  = &subrect[BYTESPP];
+                }
+              else
+                {
+                  ret = vncbench_recv(subrect, 2);
+                }
+
+              if (ret < 0)
+                {
+                  return ret;
+                }
+
+              if ((xy[0] >> 4) + (xy[1] >> 4) + 1 > tw ||
+                  (xy[0] & 15) + (xy[1] & 15) + 1 > th)
+                {
+                  return -EPROTO;
+                }
+
+              vncbench_fillclient(tx + (xy[0] >> 4), ty + (xy[0] & 15),
+                                  (xy[1] >> 4) + 1, (xy[1] & 15) + 1, fg);
+            }
+        }
+    }
+
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: vncbench_getbits
+ ****************************************************************************/
+
+#ifdef CONFIG_VNCSERVER_ZRLE
+static uint32_t vncbench_getbits(FAR struct vncbench_inflate_s *inf,
+                                 int nbits)
+{
+  uint32_t value;
+
+  while (inf->nbits < nbits)
+    {
+      if (inf->inpos >= inf->inlen)
+        {
+          inf->error = true;
+          return 0;
+        }
+
+      inf->bitbuf |= (uint32_t)inf->in[inf->inpos++] << inf->nbits;
+      inf->nbits  += 8;
+    }
+
+  value         = inf->bitbuf & ((1 << nbits) - 1);
+  inf->bitbuf >>= nbits;
+  inf->nbits   -= nbits;
+  return value;
+}
+
+/****************************************************************************
+ * Name: vncbench_getcode
+ *
+ * Description:
+ *   Return the next literal/length symbol of a block that uses the fixed
+ *   Huffman codes.  Huffman codes are packed starting with their most
+ *   significant bit.
+ *
+ ****************************************************************************/
+
+static int vncbench_getcode(FAR struct vncbench_inflate_s *inf)
+{
+  uint32_t code = 0;
+  int len;
+
+  for (len = 1; len <= 9 && !inf->error; len++)
+    {
+      code = (code << 1) | vncbench_getbits(inf, 1);
+
+      if (len == 7 && code <= 0x17)
+        {
+          return 256 + code;
+        }
+      else if (len == 8 && code >= 0x30 && code <= 0xbf)
+        {
+          return code - 0x30;
+        }
+      else if (len == 8 && code >= 0xc0 && code <= 0xc7)
+        {
+          return 280 + code - 0xc0;
+        }
+      else if (len == 9 && code >= 0x190)
+        {
+          return 144 + code - 0x190;
+        }
+    }
+
+  inf->error = true;
+  return 256;
+}
+
+/****************************************************************************
+ * Name: vncbench_inflate
+ *
+ * Description:
+ *   Decompress the data of one ZRLE rectangle to g_zout after the history.
+ *   The server compresses with stored blocks and blocks with the fixed
+ *   Huffman codes only, and ends the data of each rectangle with a sync
+ *   flush.  Dynamic Huffman codes are not supported.
+ *
+ * Returned Value:
+ *   The number of bytes of decompressed data; a negated errno value on a
+ *   failure.
+ *
+ ****************************************************************************/
+
+static ssize_t vncbench_inflate(FAR const uint8_t *in, size_t inlen)
+{
+  struct vncbench_inflate_s inf;
+  FAR uint8_t *out = &g_zout[g_zhist];
+  size_t len;
+  size_t dist;
+  int type;
+  int sym;
+
+  memset(&inf, 0, sizeof(inf));
+  inf.in    = in;
+  inf.inlen = inlen;
+
+  /* The zlib header precedes the first data of the connection */
+
+  if (!g_zheader)
+    {
+      if (inlen < 2 || (in[0] & 0x0f) != 8)
+        {
+          return -EPROTO;
+        }
+
+      inf.inpos = 2;
+      g_zheader = true;
+    }
+
+  while (inf.inpos < inf.inlen && !inf.error)
+    {
+      (void)vncbench_getbits(&inf, 1);  /* BFINAL */
+      type = vncbench_getbits(&inf, 2);
+
+      if (type == 0)
+        {
+          /* A stored block starts at the next byte boundary */
+
+          inf.bitbuf = 0;
+          inf.nbits  = 0;
+
+          if (inf.inpos + 4 > inf.inlen)
+            {
+              return -EPROTO;
+            }
+
+          len = in[inf.inpos] | (in[inf.inpos + 1] << 8);
+          if ((len ^ (in[inf.inpos + 2] | (in[inf.inpos + 3] << 8))) !=
+              0xffff)
+            {
+              return -EPROTO;
+            }
+
+          inf.inpos += 4;
+          if (inf.inpos + len > inf.inlen || inf.outpos + len > ZRLE_OUTSIZE)
+            {
+              return -EPROTO;
+            }
+
+          memcpy(&out[inf.outpos], &in[inf.inpos], len);
+          inf.inpos  += len;
+          inf.outpos += len;
+        }
+      else if (type == 1)
+        {
+          for (; ; )
+            {
+              sym = vncbench_getcode(&inf);
+              if (sym < 256)
+                {
+                  if (inf.outpos >= ZRLE_OUTSIZE)
+                    {
+                      return -EPROTO;
+                    }
+
+                  out[inf.outpos++] = sym;
+                  continue;
+                }
+              else if (sym == 256 || sym > 285)
+                {
+                  break;
+                }
+
+              len  = g_lenbase[sym - 257] +
+                     vncbench_getbits(&inf, g_lenextra[sym - 257]);
+
+              /* The 5-bit distance codes are also packed most significant
+               * bit first.
+               */
+
+              sym  = vncbench_getbits(&inf, 1) << 4;
+              sym |= vncbench_getbits(&inf, 1) << 3;
+              sym |= vncbench_getbits(&inf, 1) << 2;
+              sym |= vncbench_getbits(&inf, 1) << 1;
+              sym |= vncbench_getbits(&inf, 1);
+              if (sym >= 30)
+                {
+                  return -EPROTO;
+                }
+
+              dist = g_distbase[sym] +
+                     vncbench_getbits(&inf, g_distextra[sym]);
+
+              if (inf.error || dist > g_zhist + inf.outpos ||
+                  inf.outpos + len > ZRLE_OUTSIZE)
+                {
+                  return -EPROTO;
+                }
+
+              /* The source may overlap the destination */
+
+              for (; len > 0; len--, inf.outpos++)
+                {
+                  out[inf.outpos] = out[(ssize_t)inf.outpos - (ssize_t)dist];
+                }
+            }
+        }
+      else
+        {
+          return -ENOSYS;
+        }
+    }
+
+  if (inf.error)
+    {
+      return -EPROTO;
+    }
+
+  return inf.outpos;
+}
+
+/****************************************************************************
+ * Name: vncbench_runlength
+ ****************************************************************************/
+
+static int vncbench_runlength(FAR const uint8_t **src, FAR const uint8_t *end)
+{
+  int len = 1;
+
+  while (*src < end)
+    {
+      len += **src;
+      if (*(*src)++ != 255)
+        {
+          return len;
+        }
+    }
+
+  return -1;
+}
+
+/****************************************************************************
+ * Name: vncbench_zrletile
+ *
+ * Description:
+ *   Decode one ZRLE tile.
+ *
+ * Returned Value:
+ *   A pointer to the data following the tile or NULL if the tile is bad.
+ *
+ ****************************************************************************/
+
+static FAR const uint8_t *vncbench_zrletile(FAR const uint8_t *src,
+                                            FAR const uint8_t *end,
+                                            int tx, int ty, int tw, int th)
+{
+  uint16_t palette[127];
+  uint8_t subencoding;
+  int npalette = 0;
+  int bits;
+  int run;
+  int ndx;
+  int i;
+  int j;
+
+  if (src >= end)
+    {
+      return NULL;
+    }
+
+  subencoding = *src++;
+  if (subencoding == RFB_ZRLE_RAW)
+    {
+      if (end - src < tw * th * ZRLE_BYTESPP)
+        {
+          return NULL;
+        }
+
+      for (j = ty; j < ty + th; j++)
+        {
+          for (i = tx; i < tx + tw; i++, src += ZRLE_BYTESPP)
+            {
+              g_client[j][i] = vncbench_rgb(src);
+            }
+        }
+
+      return src;
+    }
+
+  /* Read the palette, if any */
+
+  if (subencoding <= RFB_ZRLE_PACKED15)
+    {
+      npalette = subencoding;
+    }
+  else if (subencoding > RFB_ZRLE_PALRLE(1))
+    {
+      npalette = subencoding - RFB_ZRLE_RLE;
+    }
+  else if (subencoding != RFB_ZRLE_RLE)
+    {
+      return NULL;
+    }
+
+  if (end - src < npalette * ZRLE_BYTESPP)
+    {
+      return NULL;
+    }
+
+  for (i = 0; i < npalette; i++, src += ZRLE_BYTESPP)
+    {
+      palette[i] = vncbench_rgb(src);
+    }
+
+  if (subencoding == RFB_ZRLE_SOLID)
+    {
+      vncbench_fillclient(tx, ty, tw, th, palette[0]);
+      return src;
+    }
+
+  if (subencoding <= RFB_ZRLE_PACKED15)
+    {
+      /* Packed palette indices, each row starting on a byte boundary */
+
+      bits = npalette == 2 ? 1 : npalette <= 4 ? 2 : 4;
+      for (j = ty; j < ty + th; j++)
+        {
+          if (end - src < (tw * bits + 7) / 8)
+            {
+              return NULL;
+            }
+
+          for (i = 0; i < tw; i++)
+            {
+              ndx = (src[(i * bits) / 8] >> (8 - bits - (i * bits) % 8)) &
+                    ((1 << bits) - 1);
+              if (ndx >= npalette)
+                {
+                  return NULL;
+                }
+
+              g_client[j][tx + i] = palette[ndx];
+            }
+
+          src += (tw * bits + 7) / 8;
+        }
+
+      return src;
+    }
+
+  /* Plain or palette RLE */
+
+  for (i = 0; i < tw * th; )
+    {
+      uint16_t color;
+
+      if (subencoding == RFB_ZRLE_RLE)
+        {
+          if (end - src < ZRLE_BYTESPP)
+            {
+              return NULL;
+            }
+
+          color = vncbench_rgb(src);
+          src  += ZRLE_BYTESPP;
+          run   = vncbench_runlength(&src, end);
+        }
+      else
+        {
+          if (src >= end || (*src & 0x7f) >= npalette)
+            {
+              return NULL;
+            }
+
+          color = palette[*src & 0x7f];
+          run   = (*src++ & 0x80) != 0 ? vncbench_runlength(&src, end) : 1;
+        }
+
+      if (run < 0 || i + run > tw * th)
+        {
+          return NULL;
+        }
+
+      for (; run > 0; run--, i++)
+        {
+          g_client[ty + i / tw][tx + i % tw] = color;
+        }
+    }
+
+  return src;
+}
+
+/****************************************************************************
+ * Name: vncbench_zrle
+ ****************************************************************************/
+
+static int vncbench_zrle(int x, int y, int w, int h)
+{
+  FAR const uint8_t *src;
+  FAR const uint8_t *end;
+  uint8_t hdr[4];
+  uint32_t len;
+  ssize_t outlen;
+  int tx;
+  int ty;
+  int ret;
+
+  ret = vncbench_recv(hdr, 4);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  len = rfb_getbe32(hdr);
+  if (len > g_zinsize)
+    {
+      free(g_zin);
+      g_zinsize = 0;
+
+      g_zin = (FAR uint8_t *)malloc(len);
+      if (g_zin == NULL)
+        {
+          return -ENOMEM;
+        }
+
+      g_zinsize = len;
+    }
+
+  ret = vncbench_recv(g_zin, len);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  outlen = vncbench_inflate(g_zin, len);
+  if (outlen < 0)
+    {
+      return outlen;
+    }
+
+  src = &g_zout[g_zhist];
+  end = src + outlen;
+
+  for (ty = y; ty < y + h && src != NULL; ty += ZRLE_TILESIZE)
+    {
+      for (tx = x; tx < x + w && src != NULL; tx += ZRLE_TILESIZE)
+        {
+          src = vncbench_zrletile(src, end, tx, ty,
+                                  x + w - tx < ZRLE_TILESIZE ?
+                                    x + w - tx : ZRLE_TILESIZE,
+                                  y + h - ty < ZRLE_TILESIZE ?
+                                    y + h - ty : ZRLE_TILESIZE);
+        }
+    }
+
+  if (src != end)
+    {
+      return -EPROTO;
+    }
+
+  /* Keep the last ZRLE_WINDOW bytes as the history for the next rectangle */
+
+  g_zhist += outlen;
+  if (g_zhist > ZRLE_WINDOW)
+    {
+      memmove(g_zout, &g_zout[g_zhist - ZRLE_WINDOW], ZRLE_WINDOW);
+      g_zhist = ZRLE_WINDOW;
+    }
+
+  return OK;
+}
+#endif /* CONFIG_VNCSERVER_ZRLE */
+
+/****************************************************************************
+ * Name: vncbench_update
+ *
+ * Description:
+ *   Receive the rest of one FramebufferUpdate message and apply it to the
+ *   client copy of the display.
+ *
+ ****************************************************************************/
+
+static int vncbench_update(void)
+{
+  uint8_t hdr[12];
+  int32_t encoding;
+  int nrects;
+  int x;
+  int y;
+  int w;
+  int h;
+  int ret;
+
+  ret = vncbench_recv(hdr, 3);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  nrects = rfb_getbe16(&hdr[1]);
+  while (nrects-- > 0)
+    {
+      ret = vncbench_recv(hdr, 12);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      x        = rfb_getbe16(&hdr[0]);
+      y        = rfb_getbe16(&hdr[2]);
+      w        = rfb_getbe16(&hdr[4]);
+      h        = rfb_getbe16(&hdr[6]);
+      encoding = (int32_t)rfb_getbe32(&hdr[8]);
+
+      if (vncbench_outside(x, y, w, h))
+        {
+          return -EPROTO;
+        }
+
+      switch (encoding)
+        {
+          case RFB_ENCODING_RAW:
+            ret = vncbench_raw(x, y, w, h);
+            break;
+
+#ifdef HAVE_COPYRECT
+          case RFB_ENCODING_COPYRECT:
+            ret = vncbench_copyrect(x, y, w, h);
+            break;
+#endif
+
+#ifdef CONFIG_VNCSERVER_HEXTILE
+          case RFB_ENCODING_HEXTILE:
+            ret = vncbench_hextile(x, y, w, h);
+            break;
+#endif
+
+#ifdef CONFIG_VNCSERVER_ZRLE
+          case RFB_ENCODING_ZRLE:
+            ret = vncbench_zrle(x, y, w, h);
+            break;
+#endif
+
+          default:
+            ret = -ENOSYS;
+            break;
+        }
+
+      if (ret < 0)
+        {
+          printf("ERROR: Bad rectangle, encoding %ld: %d\n",
+                 (long)encoding, ret);
+          return ret;
+        }
+
+      if (encoding != RFB_ENCODING_COPYRECT)
+        {
+          g_encoding = encoding;
+        }
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: vncbench_matches
+ *
+ * Description:
+ *   Return true if the client copy of the display matches the framebuffer.
+ *   The caller must hold g_lock.
+ *
+ ****************************************************************************/
+
+static bool vncbench_matches(void)
+{
+  int y;
+
+  for (y = 0; y < HEIGHT; y++)
+    {
+      if (memcmp(g_client[y], vncbench_pixel(0, y),
+                 WIDTH * sizeof(uint16_t)) != 0)
+        {
+          return false;
+        }
+    }
+
+  return true;
+}
+
+/****************************************************************************
+ * Name: vncbench_setencodings
+ *
+ * Description:
+ *   Send a SetEncodings message.  The server may use the earlier encodings
+ *   for a while after this.
+ *
+ ****************************************************************************/
+
+static int vncbench_setencodings(FAR const struct vncbench_session_s *session)
+{
+  uint8_t msg[12];
+  ssize_t len = 4;
+
+  memset(msg, 0, sizeof(msg));
+  msg[0] = RFB_SETENCODINGS_MSG;
+
+  if (session->copyrect)
+    {
+      rfb_putbe32(&msg[len], RFB_ENCODING_COPYRECT);
+      len += 4;
+    }
+
+  rfb_putbe32(&msg[len], session->encoding);
+  len += 4;
+  rfb_putbe16(&msg[2], (len - 4) / 4);
+
+  return send(g_sd, msg, len, 0) == len ? OK : -EIO;
+}
+
+/****************************************************************************
+ * Name: vncbench_connect
+ *
+ * Description:
+ *   Connect to the VNC server and negotiate the pixel format and the
+ *   encodings.
+ *
+ ****************************************************************************/
+
+static int vncbench_connect(FAR const struct vncbench_session_s *session)
+{
+  struct sockaddr_in addr;
+  uint8_t msg[24];
+  uint32_t len;
+  int retries;
+  int ret;
+
+  addr.sin_family      = AF_INET;
+  addr.sin_port        = HTONS(VNC_PORT);
+  addr.sin_addr.s_addr = HTONL(INADDR_LOOPBACK);
+
+  /* The server may not be listening yet */
+
+  for (retries = 0; ; retries++)
+    {
+      g_sd = socket(PF_INET, SOCK_STREAM, 0);
+      if (g_sd < 0)
+        {
+          printf("ERROR: socket failed: %d\n", errno);
+          return -errno;
+        }
+
+      if (connect(g_sd, (FAR struct sockaddr *)&addr, sizeof(addr)) == 0)
+        {
+          break;
+        }
+
+      ret = -errno;
+      (void)close(g_sd);
+      if (retries >= 50)
+        {
+          printf("ERROR: connect failed: %d\n", ret);
+          return ret;
+        }
+
+      usleep(100 * 1000);
+    }
+
+  /* Echo the protocol version.  Version 3.3 has the server choose the
+   * security type.  Later versions let the client choose it.
+   */
+
+  ret = vncbench_recv(msg, 12);
+  if (ret < 0 || send(g_sd, msg, 12, 0) != 12)
+    {
+      goto errout;
+    }
+
+  if (memcmp(msg, RFB_PROTOCOL_VERSION_3p3, 12) == 0)
+    {
+      ret = vncbench_recv(msg, 4);
+      if (ret < 0 || rfb_getbe32(msg) != RFB_SECTYPE_NONE)
+        {
+          goto errout;
+        }
+    }
+  else
+    {
+      ret = vncbench_recv(msg, 1);
+      if (ret < 0 || msg[0] == 0 || msg[0] > sizeof(msg))
+        {
+          goto errout;
+        }
+
+      ret = vncbench_recv(msg, msg[0]);
+      msg[0] = RFB_SECTYPE_NONE;
+      if (ret < 0 || send(g_sd, msg, 1, 0) != 1)
+        {
+          goto errout;
+        }
+
+      ret = vncbench_recv(msg, 4);
+      if (ret < 0 || rfb_getbe32(msg) != RFB_SECTYPE_SUCCESS)
+        {
+          goto errout;
+        }
+    }
+
+  /* ClientInit and ServerInit.  Skip the desktop name. */
+
+  msg[0] = RFB_FLAG_SHARED;
+  if (send(g_sd, msg, 1, 0) != 1 || vncbench_recv(msg, 24) < 0)
+    {
+      goto errout;
+    }
+
+  for (len = rfb_getbe32(&msg[20]); len > 0; len--)
+    {
+      if (vncbench_recv(msg, 1) < 0)
+        {
+          goto errout;
+        }
+    }
+
+  /* SetPixelFormat:  32 bits per pixel, depth 24, little endian, true
+   * color, 8 bits of red, green and blue at bits 16, 8 and 0.
+   */
+
+  memset(msg, 0, 20);
+  msg[0]  = RFB_SETPIXELFMT_MSG;
+  msg[4]  = 32;
+  msg[5]  = 24;
+  msg[7]  = 1;
+  rfb_putbe16(&msg[8], 255);
+  rfb_putbe16(&msg[10], 255);
+  rfb_putbe16(&msg[12], 255);
+  msg[14] = 16;
+  msg[15] = 8;
+
+  if (send(g_sd, msg, 20, 0) != 20)
+    {
+      goto errout;
+    }
+
+  /* SetEncodings.  Nothing else may follow until the server has completed
+   * the negotiation:  It receives the encodings with a single recv().
+   */
+
+  if (vncbench_setencodings(session) < 0)
+    {
+      goto errout;
+    }
+
+  return OK;
+
+errout:
+  printf("ERROR: Negotiation with the server failed\n");
+  (void)close(g_sd);
+  return -EPROTO;
+}
+
+/****************************************************************************
+ * Name: vncbench_client
+ *
+ * Description:
+ *   Connect and then apply all updates until told to stop.  After each
+ *   update, check if the frame that the main thread waits for is complete.
+ *
+ ****************************************************************************/
+
+static FAR void *vncbench_client(FAR void *arg)
+{
+  FAR const struct vncbench_session_s *session =
+    (FAR const struct vncbench_session_s *)arg;
+  uint8_t msgtype;
+  bool stop = false;
+  int ret;
+
+  ret = vncbench_connect(session);
+  if (ret < 0)
+    {
+      goto errout;
+    }
+
+  while (!stop)
+    {
+      ret = vncbench_recv(&msgtype, 1);
+      if (ret < 0 || msgtype != RFB_FBUPDATE_MSG)
+        {
+          printf("ERROR: Bad message from the server: %d\n",
+                 ret < 0 ? ret : msgtype);
+          break;
+        }
+
+      pthread_mutex_lock(&g_lock);
+      ret = vncbench_update();
+      if (ret < 0)
+        {
+          pthread_mutex_unlock(&g_lock);
+          break;
+        }
+
+      if (g_waiting && vncbench_matches())
+        {
+          g_waiting = false;
+          sem_post(&g_match);
+        }
+
+      stop = g_stop;
+      pthread_mutex_unlock(&g_lock);
+    }
+
+  (void)close(g_sd);
+
+errout:
+  pthread_mutex_lock(&g_lock);
+  if (!stop)
+    {
+      g_failed = true;
+      if (g_waiting)
+        {
+          g_waiting = false;
+          sem_post(&g_match);
+        }
+    }
+
+  pthread_mutex_unlock(&g_lock);
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: vncbench_wait
+ *
+ * Description:
+ *   Wait until the client copy of the display matches the framebuffer.
+ *
+ ****************************************************************************/
+
+static int vncbench_wait(void)
+{
+  struct timespec abstime;
+  int ret;
+
+  pthread_mutex_lock(&g_lock);
+  if (g_failed)
+    {
+      pthread_mutex_unlock(&g_lock);
+      return -ECONNRESET;
+    }
+
+  if (vncbench_matches())
+    {
+      pthread_mutex_unlock(&g_lock);
+      return OK;
+    }
+
+  g_waiting = true;
+  pthread_mutex_unlock(&g_lock);
+
+  (void)clock_gettime(CLOCK_REALTIME, &abstime);
+  abstime.tv_sec += FRAME_TIMEOUT;
+
+  while ((ret = sem_timedwait(&g_match, &abstime)) < 0 && errno == EINTR);
+
+  /* The client may post just after the timeout */
+
+  pthread_mutex_lock(&g_lock);
+  if (ret < 0 && !g_waiting)
+    {
+      (void)sem_wait(&g_match);
+      ret = OK;
+    }
+
+  g_waiting = false;
+  if (ret == OK && g_failed)
+    {
+      ret = -ECONNRESET;
+    }
+
+  pthread_mutex_unlock(&g_lock);
+
+  if (ret < 0)
+    {
+      printf("ERROR: The frame did not arrive: %d\n",
+             ret == ERROR ? -errno : ret);
+      return ret == ERROR ? -errno : ret;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: vncbench_sync
+ *
+ * Description:
+ *   Draw full screen frames until one arrives in the requested encoding.
+ *
+ ****************************************************************************/
+
+static int vncbench_sync(FAR const struct vncbench_session_s *session)
+{
+  int32_t encoding;
+  int ret;
+  int i;
+
+  for (i = 0; i < 10; i++)
+    {
+      vncbench_fill(0, 0, WIDTH - 1, HEIGHT - 1,
+                    (i & 1) != 0 ? RGB(255, 255, 255) : RGB(0, 0, 0));
+      vncbench_notify(0, 0, WIDTH - 1, HEIGHT - 1);
+
+      ret = vncbench_wait();
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      pthread_mutex_lock(&g_lock);
+      encoding = g_encoding;
+      pthread_mutex_unlock(&g_lock);
+
+      if (encoding == session->encoding)
+        {
+          return OK;
+        }
+    }
+
+  printf("ERROR: The server did not change the encoding\n");
+  return -ETIMEDOUT;
+}
+
+/****************************************************************************
+ * Name: vncbench_session
+ *
+ * Description:
+ *   Change to one set of encodings and draw all scenes.
+ *
+ ****************************************************************************/
+
+static int vncbench_session(FAR const struct vncbench_session_s *session)
+{
+  unsigned long usec;
+  uint32_t nbytes;
+  uint32_t start;
+  int scene;
+  int frame;
+  int ret;
+
+  ret = vncbench_setencodings(session);
+  if (ret < 0)
+    {
+      goto errout;
+    }
+
+  ret = vncbench_sync(session);
+  if (ret < 0)
+    {
+      goto errout;
+    }
+
+  /* Every session draws the same frames, starting from the same display */
+
+  g_seed = 12345;
+  vncbench_fill(0, 0, WIDTH - 1, HEIGHT - 1, RGB(16, 16, 48));
+  vncbench_fill(40, 40, 119, 119, RGB(200, 40, 40));
+  vncbench_fill(200, 120, 279, 199, RGB(40, 200, 40));
+  vncbench_notify(0, 0, WIDTH - 1, HEIGHT - 1);
+
+  ret = vncbench_wait();
+  if (ret < 0)
+    {
+      goto errout;
+    }
+
+  printf("%s:\n", session->name);
+
+  for (scene = 0; scene < NSCENES; scene++)
+    {
+      pthread_mutex_lock(&g_lock);
+      nbytes = g_nbytes;
+      pthread_mutex_unlock(&g_lock);
+
+      start = vncbench_gettime();
+
+      for (frame = 0; frame < g_scenes[scene].nframes; frame++)
+        {
+          g_scenes[scene].draw(frame);
+          ret = vncbench_wait();
+          if (ret < 0)
+            {
+              goto errout;
+            }
+        }
+
+      usec = vncbench_usec(start);
+
+      /* The frames are complete, but let any redundant updates arrive */
+
+      usleep(100 * 1000);
+
+      pthread_mutex_lock(&g_lock);
+      nbytes = g_nbytes - nbytes;
+      pthread_mutex_unlock(&g_lock);
+
+      printf("  %-8s %8lu bytes/frame %8lu.%lu frames/sec\n",
+             g_scenes[scene].name,
+             (unsigned long)(nbytes / g_scenes[scene].nframes),
+             (unsigned long)((uint64_t)g_scenes[scene].nframes * 1000000 /
+                             (usec + 1)),
+             (unsigned long)((uint64_t)g_scenes[scene].nframes * 10000000 /
+                             (usec + 1) % 10));
+    }
+
+  return OK;
+
+errout:
+  printf("ERROR: %s failed: %d\n", session->name, ret);
+  return ret;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * vncbench_main
+ ****************************************************************************/
+
+#ifdef CONFIG_BUILD_KERNEL
+int main(int argc, FAR char *argv[])
+#else
+int vncbench_main(int argc, char *argv[])
+#endif
+{
+  FAR struct fb_vtable_s *vtable;
+  pthread_attr_t attr;
+  pthread_t client;
+  int ret;
+  int i;
+
+#ifdef CONFIG_VNCSERVER_ZRLE
+  g_zout = (FAR uint8_t *)malloc(ZRLE_WINDOW + ZRLE_OUTSIZE);
+  if (g_zout == NULL)
+    {
+      printf("ERROR: Failed to allocate the ZRLE buffer\n");
+      return EXIT_FAILURE;
+    }
+#endif
+
+  pthread_mutex_init(&g_lock, NULL);
+  sem_init(&g_match, 0, 0);
+  g_encoding = -1;
+
+  /* Start the client.  Then start the server, if necessary, and wait for
+   * the client to connect.
+   */
+
+  pthread_attr_init(&attr);
+  pthread_attr_setstacksize(&attr, CONFIG_EXAMPLES_VNCBENCH_STACKSIZE);
+  ret = pthread_create(&client, &attr, vncbench_client,
+                       (FAR void *)&g_sessions[0]);
+  if (ret != 0)
+    {
+      printf("ERROR: pthread_create failed: %d\n", ret);
+      return EXIT_FAILURE;
+    }
+
+  ret = up_fbinitialize(0);
+  if (ret < 0)
+    {
+      printf("ERROR: up_fbinitialize failed: %d\n", ret);
+      goto errout_with_client;
+    }
+
+  vtable = up_fbgetvplane(0, 0);
+  if (vtable == NULL || vtable->getplaneinfo(vtable, 0, &g_pinfo) < 0)
+    {
+      printf("ERROR: Failed to get the framebuffer\n");
+      ret = -ENODEV;
+      goto errout_with_client;
+    }
+
+  printf("%d frames per scene on a %dx%d display:\n", NFRAMES, WIDTH, HEIGHT);
+
+  for (i = 0; i < NSESSIONS; i++)
+    {
+      ret = vncbench_session(&g_sessions[i]);
+      if (ret < 0)
+        {
+          break;
+        }
+    }
+
+errout_with_client:
+
+  /* Have the client disconnect after one more update */
+
+  pthread_mutex_lock(&g_lock);
+  g_stop = true;
+  pthread_mutex_unlock(&g_lock);
+
+  if (g_pinfo.fbmem != NULL)
+    {
+      vncbench_fill(0, 0, 7, 7, RGB(255, 0, 0));
+      vncbench_notify(0, 0, 7, 7);
+    }
+
+  (void)pthread_join(client, NULL);
+
+#ifdef CONFIG_VNCSERVER_ZRLE
+  free(g_zin);
+  free(g_zout);
+#endif
+
+  if (ret < 0 || g_failed)
+    {
+      return EXIT_FAILURE;
+    }
+
+  printf("  data verified\n");
+  return EXIT_SUCCESS;
+}
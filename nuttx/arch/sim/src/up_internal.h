@@ -329,18 +329,41 @@ FAR struct ioexpander_dev_s *sim_ioexpander_initialize(void);
 
 /* up_tapdev.c ************************************************************/
 
-#if defined(CONFIG_NET_ETHERNET) && !defined(__CYGWIN__)
+#if defined(CONFIG_NET_ETHERNET) && !defined(__CYGWIN__) && \
+   !defined(CONFIG_SIM_NET_WIRE)
 void tapdev_init(void);
 unsigned int tapdev_read(unsigned char *buf, unsigned int buflen);
+void tapdev_wait(void);
 void tapdev_send(unsigned char *buf, unsigned int buflen);
 void tapdev_ifup(in_addr_t ifaddr);
 void tapdev_ifdown(void);
 
-#  define netdev_init()           tapdev_init()
-#  define netdev_read(buf,buflen) tapdev_read(buf,buflen)
-#  define netdev_send(buf,buflen) tapdev_send(buf,buflen)
-#  define netdev_ifup(ifaddr)     tapdev_ifup(ifaddr)
-#  define netdev_ifdown()         tapdev_ifdown()
+#  define netdev_init(i)            tapdev_init()
+#  define netdev_read(i,buf,buflen) tapdev_read(buf,buflen)
+#  define netdev_wait()             tapdev_wait()
+#  define netdev_send(i,buf,buflen) tapdev_send(buf,buflen)
+#  define netdev_flush()            {}
+#  define netdev_ifup(i,ifaddr)     tapdev_ifup(ifaddr)
+#  define netdev_ifdown(i)          tapdev_ifdown()
+#endif
+
+/* up_netwire.c ***********************************************************/
+
+#if defined(CONFIG_NET_ETHERNET) && defined(CONFIG_SIM_NET_WIRE)
+void netwire_init(int devidx);
+unsigned int netwire_read(int devidx, unsigned char *buf,
+                          unsigned int buflen);
+void netwire_wait(void);
+void netwire_send(int devidx, unsigned char *buf, unsigned int buflen);
+void netwire_flush(void);
+
+#  define netdev_init(i)            netwire_init(i)
+#  define netdev_read(i,buf,buflen) netwire_read(i,buf,buflen)
+#  define netdev_wait()             netwire_wait()
+#  define netdev_send(i,buf,buflen) netwire_send(i,buf,buflen)
+#  define netdev_flush()            netwire_flush()
+#  define netdev_ifup(i,ifaddr)     {}
+#  define netdev_ifdown(i)          {}
 #endif
 
 /* up_wpcap.c *************************************************************/
@@ -350,18 +373,20 @@ void wpcap_init(void);
 unsigned int wpcap_read(unsigned char *buf, unsigned int buflen);
 void wpcap_send(unsigned char *buf, unsigned int buflen);
 
-#  define netdev_init()           wpcap_init()
-#  define netdev_read(buf,buflen) wpcap_read(buf,buflen)
-#  define netdev_send(buf,buflen) wpcap_send(buf,buflen)
-#  define netdev_ifup(ifaddr)     {}
-#  define netdev_ifdown()         {}
+#  define netdev_init(i)            wpcap_init()
+#  define netdev_read(i,buf,buflen) wpcap_read(buf,buflen)
+#  define netdev_wait()             {}
+#  define netdev_send(i,buf,buflen) wpcap_send(buf,buflen)
+#  define netdev_flush()            {}
+#  define netdev_ifup(i,ifaddr)     {}
+#  define netdev_ifdown(i)          {}
 #endif
 
 /* up_netdriver.c *********************************************************/
 
 #ifdef CONFIG_NET_ETHERNET
 int netdriver_init(void);
-int netdriver_setmacaddr(unsigned char *macaddr);
+int netdriver_setmacaddr(int devidx, unsigned char *macaddr);
 void netdriver_loop(void);
 #endif
 
@@ -48,6 +48,7 @@
 
 #include <stdint.h>
 #include <stdbool.h>
+#include <stdlib.h>
 #include <string.h>
 #include <sched.h>
 #include <nuttx/net/net.h>
@@ -66,7 +67,23 @@
  * Pre-processor Definitions
  ****************************************************************************/
 
-#define BUF ((struct eth_hdr_s *)g_sim_dev.d_buf)
+#if CONFIG_SIM_NETDEV_NINTERFACES > 1 && !defined(CONFIG_NETDEV_MULTINIC)
+#  error "Multiple interfaces require CONFIG_NETDEV_MULTINIC"
+#endif
+
+#define BUF(d) ((struct eth_hdr_s *)(d)->d_buf)
+
+/* The index of a device is its position in g_sim_dev[] */
+
+#define SIM_DEVIDX(d) ((int)((d) - g_sim_dev))
+
+/* Link emulation */
+
+#if CONFIG_SIM_NETDEV_LOSS > 0 || CONFIG_SIM_NETDEV_DELAY > 0
+#  define SIM_LINK_EMULATION 1
+#else
+#  define sim_send(d,buf,buflen) netdev_send(SIM_DEVIDX(d),buf,buflen)
+#endif
 
 /****************************************************************************
  * Private Types
@@ -78,19 +95,44 @@ struct timer
   uint32_t start;
 };
 
+#if CONFIG_SIM_NETDEV_DELAY > 0
+/* A frame held back by the transmit delay emulation */
+
+struct sim_delayed_s
+{
+  uint32_t due;                     /* Time when the frame is sent (msec) */
+  uint16_t len;                     /* Length of the frame */
+  uint8_t  devidx;                  /* Index of the sending device */
+  uint8_t  buf[MAX_NET_DEV_MTU];    /* The frame */
+};
+#endif
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
 
 static struct timer g_periodic_timer;
 
-/* A single packet buffer is used */
+/* A single packet buffer is used for each device */
 
-static uint8_t g_pktbuf[MAX_NET_DEV_MTU + CONFIG_NET_GUARDSIZE];
+static uint8_t g_pktbuf[CONFIG_SIM_NETDEV_NINTERFACES]
+                       [MAX_NET_DEV_MTU + CONFIG_NET_GUARDSIZE];
 
 /* Ethernet peripheral state */
 
-static struct net_driver_s g_sim_dev;
+static struct net_driver_s g_sim_dev[CONFIG_SIM_NETDEV_NINTERFACES];
+
+/* New TX data is available and the network should be polled */
+
+static bool g_txavail[CONFIG_SIM_NETDEV_NINTERFACES];
+
+#if CONFIG_SIM_NETDEV_DELAY > 0
+/* Delayed transmit frames, in order of their due times */
+
+static struct sim_delayed_s g_delayq[CONFIG_SIM_NETDEV_DELAYQ];
+static unsigned int g_delayhead;    /* Index of the oldest frame */
+static unsigned int g_delaycount;   /* Number of frames held */
+#endif
 
 /****************************************************************************
  * Private Functions
@@ -121,13 +163,77 @@ static inline int up_comparemac(uint8_t *paddr1, struct ether_addr *paddr2)
 }
 #endif
 
+#if CONFIG_SIM_NETDEV_LOSS > 0
+static bool sim_lost(void)
+{
+  return (rand() % 1000) < CONFIG_SIM_NETDEV_LOSS;
+}
+#else
+#  define sim_lost() (false)
+#endif
+
+#ifdef SIM_LINK_EMULATION
+static void sim_send(FAR struct net_driver_s *dev, uint8_t *buf,
+                     unsigned int buflen)
+{
+#if CONFIG_SIM_NETDEV_DELAY > 0
+  FAR struct sim_delayed_s *frame;
+#endif
+
+  if (sim_lost())
+    {
+      ninfo("Dropped TX frame: %u bytes\n", buflen);
+      return;
+    }
+
+#if CONFIG_SIM_NETDEV_DELAY > 0
+  if (g_delaycount >= CONFIG_SIM_NETDEV_DELAYQ ||
+      buflen > MAX_NET_DEV_MTU)
+    {
+      ninfo("Delay queue full: %u bytes\n", buflen);
+      return;
+    }
+
+  frame = &g_delayq[(g_delayhead + g_delaycount) % CONFIG_SIM_NETDEV_DELAYQ];
+  frame->due    = up_getwalltime() + CONFIG_SIM_NETDEV_DELAY;
+  frame->len    = buflen;
+  frame->devidx = SIM_DEVIDX(dev);
+  memcpy(frame->buf, buf, buflen);
+  g_delaycount++;
+#else
+  netdev_send(SIM_DEVIDX(dev), buf, buflen);
+#endif
+}
+#endif
+
+#if CONFIG_SIM_NETDEV_DELAY > 0
+static void sim_delayflush(void)
+{
+  uint32_t now = up_getwalltime();
+
+  while (g_delaycount > 0)
+    {
+      FAR struct sim_delayed_s *frame = &g_delayq[g_delayhead];
+
+      if ((int32_t)(now - frame->due) < 0)
+        {
+          break;
+        }
+
+      netdev_send(frame->devidx, frame->buf, frame->len);
+      g_delayhead = (g_delayhead + 1) % CONFIG_SIM_NETDEV_DELAYQ;
+      g_delaycount--;
+    }
+}
+#endif
+
 static int sim_txpoll(struct net_driver_s *dev)
 {
   /* If the polling resulted in data that should be sent out on the network,
    * the field d_len is set to a value > 0.
    */
 
-  if (g_sim_dev.d_len > 0)
+  if (dev->d_len > 0)
     {
       /* Look up the destination MAC address and add it to the Ethernet
        * header.
@@ -135,10 +241,10 @@ static int sim_txpoll(struct net_driver_s *dev)
 
 #ifdef CONFIG_NET_IPv4
 #ifdef CONFIG_NET_IPv6
-      if (IFF_IS_IPv4(&g_sim_dev))
+      if (IFF_IS_IPv4(dev->d_flags))
 #endif
         {
-          arp_out(&g_sim_dev);
+          arp_out(dev);
         }
 #endif /* CONFIG_NET_IPv4 */
 
@@ -147,13 +253,13 @@ static int sim_txpoll(struct net_driver_s *dev)
       else
 #endif
         {
-          neighbor_out(&g_sim_dev);
+          neighbor_out(dev);
         }
 #endif /* CONFIG_NET_IPv6 */
 
       /* Send the packet */
 
-      netdev_send(g_sim_dev.d_buf, g_sim_dev.d_len);
+      sim_send(dev, dev->d_buf, dev->d_len);
     }
 
   /* If zero is returned, the polling will continue until all connections have
@@ -163,205 +269,300 @@ static int sim_txpoll(struct net_driver_s *dev)
   return 0;
 }
 
-/****************************************************************************
- * Public Functions
- ****************************************************************************/
-
-void netdriver_loop(void)
+static int sim_txavail(struct net_driver_s *dev)
 {
-  FAR struct eth_hdr_s *eth;
+  /* Just note the request.  The poll is done on the next pass through
+   * netdriver_loop().
+   */
 
-  /* netdev_read will return 0 on a timeout event and >0 on a data received event */
+  g_txavail[SIM_DEVIDX(dev)] = true;
+  return OK;
+}
 
-  g_sim_dev.d_len = netdev_read((FAR unsigned char *)g_sim_dev.d_buf,
-                                CONFIG_NET_ETH_MTU);
+static void sim_receive(FAR struct net_driver_s *dev)
+{
+  FAR struct eth_hdr_s *eth = BUF(dev);
+  int is_ours;
 
-  /* Disable preemption through to the following so that it behaves a little more
-   * like an interrupt (otherwise, the following logic gets pre-empted an behaves
-   * oddly.
-   */
+  /* Check for valid Ethernet header with destination == our MAC address */
 
-  sched_lock();
-  if (g_sim_dev.d_len > 0)
+  if (dev->d_len <= ETH_HDRLEN)
     {
-      /* Data received event.  Check for valid Ethernet header with destination == our
-       * MAC address
-       */
-
-      eth = BUF;
-      if (g_sim_dev.d_len > ETH_HDRLEN)
-        {
-         int is_ours;
+      return;
+    }
 
-         /* Figure out if this ethernet frame is addressed to us.  This affects
-           * what we're willing to receive.   Note that in promiscuous mode, the
-           * up_comparemac will always return 0.
-           */
+  /* Figure out if this ethernet frame is addressed to us.  This affects
+   * what we're willing to receive.   Note that in promiscuous mode, the
+   * up_comparemac will always return 0.
+   */
 
-         is_ours = (up_comparemac(eth->dest, &g_sim_dev.d_mac.ether) == 0);
+  is_ours = (up_comparemac(eth->dest, &dev->d_mac.ether) == 0);
 
 #ifdef CONFIG_NET_PKT
-          /* When packet sockets are enabled, feed the frame into the packet
-           * tap.
-           */
+  /* When packet sockets are enabled, feed the frame into the packet
+   * tap.
+   */
 
-          if (is_ours)
-            {
-              pkt_input(&g_sim_dev);
-            }
+  if (is_ours)
+    {
+      pkt_input(dev);
+    }
 #endif /* CONFIG_NET_PKT */
 
-          /* We only accept IP packets of the configured type and ARP packets */
+  /* We only accept IP packets of the configured type and ARP packets */
 
 #ifdef CONFIG_NET_IPv4
-          if (eth->type == HTONS(ETHTYPE_IP) && is_ours)
-            {
-              ninfo("IPv4 frame\n");
+  if (eth->type == HTONS(ETHTYPE_IP) && is_ours)
+    {
+      ninfo("IPv4 frame\n");
 
-              /* Handle ARP on input then give the IPv4 packet to the network
-               * layer
-               */
+      /* Handle ARP on input then give the IPv4 packet to the network
+       * layer
+       */
 
-              arp_ipin(&g_sim_dev);
-              ipv4_input(&g_sim_dev);
+      arp_ipin(dev);
+      ipv4_input(dev);
 
-              /* If the above function invocation resulted in data that
-               * should be sent out on the network, the global variable
-               * d_len is set to a value > 0.
-               */
+      /* If the above function invocation resulted in data that
+       * should be sent out on the network, the field d_len is set to
+       * a value > 0.
+       */
 
-              if (g_sim_dev.d_len > 0)
-                {
-                  /* Update the Ethernet header with the correct MAC address */
+      if (dev->d_len > 0)
+        {
+          /* Update the Ethernet header with the correct MAC address */
 
 #ifdef CONFIG_NET_IPv6
-                  if (IFF_IS_IPv4(g_sim_dev.d_flags))
+          if (IFF_IS_IPv4(dev->d_flags))
 #endif
-                    {
-                      arp_out(&g_sim_dev);
-                    }
+            {
+              arp_out(dev);
+            }
 #ifdef CONFIG_NET_IPv6
-                  else
-                    {
-                      neighbor_out(&g_sim_dev);
-                    }
+          else
+            {
+              neighbor_out(dev);
+            }
 #endif
 
-                  /* And send the packet */
+          /* And send the packet */
 
-                  netdev_send(g_sim_dev.d_buf, g_sim_dev.d_len);
-                }
-            }
-          else
+          sim_send(dev, dev->d_buf, dev->d_len);
+        }
+    }
+  else
 #endif /* CONFIG_NET_IPv4 */
 #ifdef CONFIG_NET_IPv6
-          if (eth->type == HTONS(ETHTYPE_IP6) && is_ours)
-            {
-              ninfo("Iv6 frame\n");
+  if (eth->type == HTONS(ETHTYPE_IP6) && is_ours)
+    {
+      ninfo("Iv6 frame\n");
 
-              /* Give the IPv6 packet to the network layer */
+      /* Give the IPv6 packet to the network layer */
 
-              ipv6_input(&g_sim_dev);
+      ipv6_input(dev);
 
-              /* If the above function invocation resulted in data that
-               * should be sent out on the network, the global variable
-               * d_len is set to a value > 0.
-               */
+      /* If the above function invocation resulted in data that
+       * should be sent out on the network, the field d_len is set to
+       * a value > 0.
+       */
 
-              if (g_sim_dev.d_len > 0)
-               {
-                  /* Update the Ethernet header with the correct MAC address */
+      if (dev->d_len > 0)
+       {
+          /* Update the Ethernet header with the correct MAC address */
 
 #ifdef CONFIG_NET_IPv4
-                  if (IFF_IS_IPv4(g_sim_dev.d_flags))
-                    {
-                      arp_out(&g_sim_dev);
-                    }
-                  else
+          if (IFF_IS_IPv4(dev->d_flags))
+            {
+              arp_out(dev);
+            }
+          else
 #endif
 #ifdef CONFIG_NET_IPv6
-                    {
-                      neighbor_out(&g_sim_dev);
-                    }
+            {
+              neighbor_out(dev);
+            }
 #endif /* CONFIG_NET_IPv6 */
 
-                  /* And send the packet */
+          /* And send the packet */
 
-                  netdev_send(g_sim_dev.d_buf, g_sim_dev.d_len);
-                }
-            }
-          else
+          sim_send(dev, dev->d_buf, dev->d_len);
+        }
+    }
+  else
 #endif/* CONFIG_NET_IPv6 */
 #ifdef CONFIG_NET_ARP
-          if (eth->type == htons(ETHTYPE_ARP))
+  if (eth->type == htons(ETHTYPE_ARP))
+    {
+      arp_arpin(dev);
+
+      /* If the above function invocation resulted in data that
+       * should be sent out on the network, the field d_len is set to
+       * a value > 0.
+       */
+
+      if (dev->d_len > 0)
+        {
+          sim_send(dev, dev->d_buf, dev->d_len);
+        }
+    }
+  else
+#endif
+   {
+     nwarn("WARNING: Unsupported Ethernet type %u\n", eth->type);
+   }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+void netdriver_loop(void)
+{
+  FAR struct net_driver_s *dev;
+  unsigned int nframes;
+  unsigned int nreceived = 0;
+  int devidx;
+
+  /* Disable preemption through to the following so that it behaves a little more
+   * like an interrupt (otherwise, the following logic gets pre-empted an behaves
+   * oddly.
+   */
+
+  sched_lock();
+
+  for (devidx = 0; devidx < CONFIG_SIM_NETDEV_NINTERFACES; devidx++)
+    {
+      dev = &g_sim_dev[devidx];
+
+      /* Handle up to a batch of received frames.  netdev_read() returns 0
+       * when no frame is waiting.
+       */
+
+      for (nframes = 0; nframes < CONFIG_SIM_NETDEV_BATCH; nframes++)
+        {
+          dev->d_len = netdev_read(devidx, (FAR unsigned char *)dev->d_buf,
+                                   CONFIG_NET_ETH_MTU);
+          if (dev->d_len == 0)
             {
-              arp_arpin(&g_sim_dev);
+              break;
+            }
+
+          nreceived++;
 
-              /* If the above function invocation resulted in data that
-               * should be sent out on the network, the global variable
-               * d_len is set to a value > 0.
-               */
+          /* Emulate loss on the receive side of the link */
 
-              if (g_sim_dev.d_len > 0)
-                {
-                  netdev_send(g_sim_dev.d_buf, g_sim_dev.d_len);
-                }
+          if (sim_lost())
+            {
+              ninfo("Dropped RX frame: %u bytes\n", dev->d_len);
+              continue;
             }
-          else
-#endif
-           {
-             nwarn("WARNING: Unsupported Ethernet type %u\n", eth->type)
-           }
+
+          sim_receive(dev);
         }
     }
 
-  /* Otherwise, it must be a timeout event */
+#if CONFIG_SIM_NETDEV_DELAY > 0
+  /* Pass any delayed frames that are now due to the host */
+
+  sim_delayflush();
 
-  else if (timer_expired(&g_periodic_timer))
+#endif
+  /* Run the periodic timer of each device */
+
+  if (timer_expired(&g_periodic_timer))
     {
       timer_reset(&g_periodic_timer);
-      devif_timer(&g_sim_dev, sim_txpoll);
+      for (devidx = 0; devidx < CONFIG_SIM_NETDEV_NINTERFACES; devidx++)
+        {
+          devif_timer(&g_sim_dev[devidx], sim_txpoll);
+        }
+    }
+
+  /* Poll for new TX data if the network has asked for that, either while
+   * handling the frames received above or from a send since the last pass.
+   */
+
+  for (devidx = 0; devidx < CONFIG_SIM_NETDEV_NINTERFACES; devidx++)
+    {
+      if (g_txavail[devidx])
+        {
+          g_txavail[devidx] = false;
+          devif_poll(&g_sim_dev[devidx], sim_txpoll);
+        }
     }
 
+  /* Pass the frames sent during this pass to the host */
+
+  netdev_flush();
   sched_unlock();
+
+  /* If no frame was waiting, wait briefly for one.  This also paces the
+   * IDLE loop.
+   */
+
+  if (nreceived == 0)
+    {
+      netdev_wait();
+    }
 }
 
 int netdriver_ifup(struct net_driver_s *dev)
 {
-  netdev_ifup(dev->d_ipaddr);
+  netdev_ifup(SIM_DEVIDX(dev), dev->d_ipaddr);
   return OK;
 }
 
 int netdriver_ifdown(struct net_driver_s *dev)
 {
-  netdev_ifdown();
+  netdev_ifdown(SIM_DEVIDX(dev));
   return OK;
 }
 
 int netdriver_init(void)
 {
+  FAR struct net_driver_s *dev;
+  int devidx;
+
   /* Internal initalization */
 
   timer_set(&g_periodic_timer, 500);
-  netdev_init();
 
-  /* Set callbacks */
+  for (devidx = 0; devidx < CONFIG_SIM_NETDEV_NINTERFACES; devidx++)
+    {
+      dev = &g_sim_dev[devidx];
+      netdev_init(devidx);
+
+      /* Set callbacks */
+
+      dev->d_buf     = g_pktbuf[devidx];   /* Single packet buffer */
+      dev->d_ifup    = netdriver_ifup;
+      dev->d_ifdown  = netdriver_ifdown;
+      dev->d_txavail = sim_txavail;
+
+#ifdef CONFIG_NET_TCP_GSO
+      /* Each packet passed to sim_txpoll() is written to the host (or held
+       * by the link emulation) before it returns, so any number of them can
+       * be accepted from a single poll.
+       */
 
-  g_sim_dev.d_buf    = g_pktbuf;         /* Single packet buffer */
-  g_sim_dev.d_ifup   = netdriver_ifup;
-  g_sim_dev.d_ifdown = netdriver_ifdown;
+      dev->d_features = NETDEV_GSO;
+#endif
 
-  /* Register the device with the OS so that socket IOCTLs can be performed */
+      /* Register the device with the OS so that socket IOCTLs can be
+       * performed
+       */
+
+      (void)netdev_register(dev, NET_LL_ETHERNET);
+    }
 
-  (void)netdev_register(&g_sim_dev, NET_LL_ETHERNET);
   return OK;
 }
 
-int netdriver_setmacaddr(unsigned char *macaddr)
+int netdriver_setmacaddr(int devidx, unsigned char *macaddr)
 {
-  (void)memcpy(g_sim_dev.d_mac.ether.ether_addr_octet, macaddr, IFHWADDRLEN);
+  (void)memcpy(g_sim_dev[devidx].d_mac.ether.ether_addr_octet, macaddr,
+               IFHWADDRLEN);
   return 0;
 }
 
 #endif /* CONFIG_NET_ETHERNET */
-
@@ -0,0 +1,449 @@
+/****************************************************************************
+ * arch/sim/src/up_netwire.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/* The "wire" connects an Ethernet interface of the simulation to the
+ * interface with the same number in another simulation running on the same
+ * host.  Each wire is a UNIX domain SOCK_SEQPACKET connection, so no root
+ * privileges and no TAP device are needed and each frame remains a
+ * separate message.  The two ends find each other by a name in the Linux
+ * abstract socket namespace:  The first simulation to start listens on the
+ * name and the second one connects to it.  Frames are received and sent in
+ * batches with recvmmsg() and sendmmsg().
+ */
+
+#ifndef __CYGWIN__
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#define _GNU_SOURCE 1
+
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/select.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifndef CONFIG_SIM_NET_WIRE_NAME
+#  define CONFIG_SIM_NET_WIRE_NAME "nuttx-wire"
+#endif
+
+#ifndef NETDEV_BUFSIZE
+#  define NETDEV_BUFSIZE 1514
+#endif
+
+/* The environment variable that overrides the configured wire name, so
+ * that several pairs of simulations can run at the same time.
+ */
+
+#define NETWIRE_ENVNAME   "NUTTX_SIM_WIRE"
+
+/* Socket buffer size.  Large enough to hold several batches. */
+
+#define NETWIRE_SOCKBUF   (512 * 1024)
+
+/* Interval between attempts to (re-)connect an unconnected wire (msec) */
+
+#define NETWIRE_RETRY     100
+
+/* Syslog priority (must match definitions in nuttx/include/syslog.h) */
+
+#define LOG_INFO          1  /* Informational message */
+#define LOG_ERR           4  /* Error conditions */
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct netwire_s
+{
+  int                lfd;            /* Listening socket or -1 */
+  int                fd;             /* Connected socket or -1 */
+  unsigned long      retry;          /* Time of the last connect attempt */
+  struct sockaddr_un addr;           /* Abstract name of the wire */
+  socklen_t          addrlen;        /* Length of the name */
+
+  /* Frames received by the last recvmmsg() and not yet read */
+
+  unsigned int       rxhead;         /* Index of the next frame to read */
+  unsigned int       rxcount;        /* Number of frames received */
+  struct mmsghdr     rxmsg[CONFIG_SIM_NETDEV_BATCH];
+  struct iovec       rxiov[CONFIG_SIM_NETDEV_BATCH];
+  unsigned char      rxbuf[CONFIG_SIM_NETDEV_BATCH][NETDEV_BUFSIZE];
+
+  /* Frames sent and waiting for the next sendmmsg() */
+
+  unsigned int       txcount;        /* Number of frames queued */
+  struct mmsghdr     txmsg[CONFIG_SIM_NETDEV_BATCH];
+  struct iovec       txiov[CONFIG_SIM_NETDEV_BATCH];
+  unsigned char      txbuf[CONFIG_SIM_NETDEV_BATCH][NETDEV_BUFSIZE];
+};
+
+/****************************************************************************
+ * NuttX Domain Public Function Prototypes
+ ****************************************************************************/
+
+int syslog(int priority, const char *format, ...);
+int netdriver_setmacaddr(int devidx, unsigned char *macaddr);
+unsigned long up_getwalltime(void);
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static struct netwire_s g_wire[CONFIG_SIM_NETDEV_NINTERFACES];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static void netwire_setsockopts(int fd)
+{
+  int size = NETWIRE_SOCKBUF;
+
+  (void)fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+  (void)setsockopt(fd, SOL_SOCKET, SO_SNDBUF, &size, sizeof(size));
+  (void)setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &size, sizeof(size));
+}
+
+static void netwire_disconnect(struct netwire_s *wire)
+{
+  if (wire->fd >= 0)
+    {
+      syslog(LOG_INFO, "NETWIRE: %s disconnected\n", &wire->addr.sun_path[1]);
+      close(wire->fd);
+      wire->fd = -1;
+    }
+
+  wire->rxcount = 0;
+  wire->txcount = 0;
+}
+
+/* Connect to the other end of the wire if it is listening.  Otherwise,
+ * listen for it.
+ */
+
+static void netwire_connect(struct netwire_s *wire)
+{
+  unsigned long now;
+  int fd;
+
+  if (wire->fd >= 0)
+    {
+      return;
+    }
+
+  if (wire->lfd < 0)
+    {
+      now = up_getwalltime();
+      if (now - wire->retry < NETWIRE_RETRY)
+        {
+          return;
+        }
+
+      wire->retry = now;
+
+      fd = socket(AF_UNIX, SOCK_SEQPACKET, 0);
+      if (fd < 0)
+        {
+          return;
+        }
+
+      if (connect(fd, (struct sockaddr *)&wire->addr, wire->addrlen) == 0)
+        {
+          syslog(LOG_INFO, "NETWIRE: Connected to %s\n",
+                 &wire->addr.sun_path[1]);
+          netwire_setsockopts(fd);
+          wire->fd = fd;
+          return;
+        }
+
+      if (bind(fd, (struct sockaddr *)&wire->addr, wire->addrlen) < 0 ||
+          listen(fd, 1) < 0)
+        {
+          /* The other end may have bound the name at the same time.  Try
+           * to connect again later.
+           */
+
+          close(fd);
+          return;
+        }
+
+      (void)fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+      wire->lfd = fd;
+    }
+
+  fd = accept(wire->lfd, NULL, NULL);
+  if (fd >= 0)
+    {
+      syslog(LOG_INFO, "NETWIRE: Accepted %s\n", &wire->addr.sun_path[1]);
+      netwire_setsockopts(fd);
+      wire->fd = fd;
+    }
+}
+
+static void netwire_flushone(struct netwire_s *wire)
+{
+  int ret;
+
+  if (wire->txcount == 0)
+    {
+      return;
+    }
+
+  if (wire->fd >= 0)
+    {
+      ret = sendmmsg(wire->fd, wire->txmsg, wire->txcount,
+                     MSG_DONTWAIT | MSG_NOSIGNAL);
+      if (ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+          netwire_disconnect(wire);
+        }
+
+      /* Frames that did not fit in the socket buffer are dropped, like
+       * frames sent into a full transmit FIFO.
+       */
+    }
+
+  wire->txcount = 0;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+void netwire_init(int devidx)
+{
+  struct netwire_s *wire = &g_wire[devidx];
+  unsigned char mac[6];
+  const char *name;
+  unsigned int i;
+
+  wire->lfd = -1;
+  wire->fd  = -1;
+
+  name = getenv(NETWIRE_ENVNAME);
+  if (name == NULL)
+    {
+      name = CONFIG_SIM_NET_WIRE_NAME;
+    }
+
+  /* The name is in the abstract namespace (it begins with a NUL), so it
+   * needs no file and disappears when the simulation exits.
+   */
+
+  memset(&wire->addr, 0, sizeof(wire->addr));
+  wire->addr.sun_family = AF_UNIX;
+  snprintf(&wire->addr.sun_path[1], sizeof(wire->addr.sun_path) - 1,
+           "%s.%d", name, devidx);
+  wire->addrlen = offsetof(struct sockaddr_un, sun_path) + 1 +
+                  strlen(&wire->addr.sun_path[1]);
+
+  for (i = 0; i < CONFIG_SIM_NETDEV_BATCH; i++)
+    {
+      wire->rxiov[i].iov_base           = wire->rxbuf[i];
+      wire->rxiov[i].iov_len            = NETDEV_BUFSIZE;
+      wire->rxmsg[i].msg_hdr.msg_iov    = &wire->rxiov[i];
+      wire->rxmsg[i].msg_hdr.msg_iovlen = 1;
+
+      wire->txiov[i].iov_base           = wire->txbuf[i];
+      wire->txmsg[i].msg_hdr.msg_iov    = &wire->txiov[i];
+      wire->txmsg[i].msg_hdr.msg_iovlen = 1;
+    }
+
+  wire->retry = up_getwalltime() - NETWIRE_RETRY;
+  netwire_connect(wire);
+
+  /* Assign a random, locally administered MAC address.  The process ID is
+   * mixed in so that simulations started at the same time differ.
+   */
+
+  srand(time(NULL) ^ (getpid() << 8) ^ devidx);
+  mac[0] = 0x42;
+  for (i = 1; i < 6; i++)
+    {
+      mac[i] = rand() % 256;
+    }
+
+  (void)netdriver_setmacaddr(devidx, mac);
+}
+
+unsigned int netwire_read(int devidx, unsigned char *buf,
+                          unsigned int buflen)
+{
+  struct netwire_s *wire = &g_wire[devidx];
+  unsigned int len;
+  int ret;
+
+  if (wire->fd < 0)
+    {
+      netwire_connect(wire);
+      if (wire->fd < 0)
+        {
+          return 0;
+        }
+    }
+
+  /* Receive the next batch of frames when the last one has been read */
+
+  if (wire->rxhead >= wire->rxcount)
+    {
+      wire->rxhead  = 0;
+      wire->rxcount = 0;
+
+      ret = recvmmsg(wire->fd, wire->rxmsg, CONFIG_SIM_NETDEV_BATCH,
+                     MSG_DONTWAIT, NULL);
+      if (ret < 0)
+        {
+          if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+              netwire_disconnect(wire);
+            }
+
+          return 0;
+        }
+
+      /* A zero length message means that the other end closed the wire */
+
+      if (ret == 0 || wire->rxmsg[0].msg_len == 0)
+        {
+          netwire_disconnect(wire);
+          return 0;
+        }
+
+      wire->rxcount = ret;
+    }
+
+  len = wire->rxmsg[wire->rxhead].msg_len;
+  if (len == 0)
+    {
+      /* The wire was closed after the preceding frames */
+
+      netwire_disconnect(wire);
+      return 0;
+    }
+
+  if (len > buflen)
+    {
+      len = buflen;
+    }
+
+  memcpy(buf, wire->rxbuf[wire->rxhead], len);
+  wire->rxhead++;
+  return len;
+}
+
+void netwire_send(int devidx, unsigned char *buf, unsigned int buflen)
+{
+  struct netwire_s *wire = &g_wire[devidx];
+
+  if (wire->fd < 0 || buflen > NETDEV_BUFSIZE)
+    {
+      return;
+    }
+
+  if (wire->txcount >= CONFIG_SIM_NETDEV_BATCH)
+    {
+      netwire_flushone(wire);
+    }
+
+  memcpy(wire->txbuf[wire->txcount], buf, buflen);
+  wire->txiov[wire->txcount].iov_len = buflen;
+  wire->txcount++;
+}
+
+void netwire_flush(void)
+{
+  int i;
+
+  for (i = 0; i < CONFIG_SIM_NETDEV_NINTERFACES; i++)
+    {
+      netwire_flushone(&g_wire[i]);
+    }
+}
+
+void netwire_wait(void)
+{
+  struct timeval tv;
+  fd_set fdset;
+  int maxfd = -1;
+  int i;
+
+  FD_ZERO(&fdset);
+
+  for (i = 0; i < CONFIG_SIM_NETDEV_NINTERFACES; i++)
+    {
+      struct netwire_s *wire = &g_wire[i];
+
+      if (wire->rxhead < wire->rxcount)
+        {
+          return;
+        }
+
+      if (wire->fd >= 0)
+        {
+          FD_SET(wire->fd, &fdset);
+          maxfd = wire->fd > maxfd ? wire->fd : maxfd;
+        }
+      else if (wire->lfd >= 0)
+        {
+          FD_SET(wire->lfd, &fdset);
+          maxfd = wire->lfd > maxfd ? wire->lfd : maxfd;
+        }
+    }
+
+  /* Wait for a frame (or a connection) as tapdev_wait() does */
+
+  tv.tv_sec  = 0;
+  tv.tv_usec = 1000;
+
+  (void)select(maxfd + 1, &fdset, NULL, NULL, &tv);
+}
+
+#endif /* !__CYGWIN__ */
@@ -101,7 +101,7 @@ struct sel_arg_struct
  ****************************************************************************/
 
 int syslog(int priority, const char *format, ...);
-int netdriver_setmacaddr(unsigned char *macaddr);
+int netdriver_setmacaddr(int devidx, unsigned char *macaddr);
 
 /****************************************************************************
  * Private Data
@@ -166,7 +166,7 @@ static int up_setmacaddr(void)
   mac[5] = rand() % 256;
   mac[6] = 0;
 
-  ret = netdriver_setmacaddr(mac);
+  ret = netdriver_setmacaddr(0, mac);
   return ret;
 }
 
@@ -253,10 +253,10 @@ unsigned int tapdev_read(unsigned char *buf, unsigned int buflen)
       return 0;
     }
 
-  /* Wait for data on the tap device (or a timeout) */
+  /* Check for data on the tap device without waiting */
 
   tv.tv_sec  = 0;
-  tv.tv_usec = 1000;
+  tv.tv_usec = 0;
 
   FD_ZERO(&fdset);
   FD_SET(gtapdevfd, &fdset);
@@ -278,6 +278,27 @@ unsigned int tapdev_read(unsigned char *buf, unsigned int buflen)
   return ret;
 }
 
+void tapdev_wait(void)
+{
+  fd_set                fdset;
+  struct timeval        tv;
+
+  if (gtapdevfd < 0)
+    {
+      return;
+    }
+
+  /* Wait for data on the tap device (or a timeout) */
+
+  tv.tv_sec  = 0;
+  tv.tv_usec = 1000;
+
+  FD_ZERO(&fdset);
+  FD_SET(gtapdevfd, &fdset);
+
+  (void)select(gtapdevfd + 1, &fdset, NULL, NULL, &tv);
+}
+
 void tapdev_send(unsigned char *buf, unsigned int buflen)
 {
   int ret;
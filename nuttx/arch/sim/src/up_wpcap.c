@@ -58,7 +58,7 @@
 #include <netinet/in.h>
 
 
-extern int netdriver_setmacaddr(unsigned char *macaddr);
+extern int netdriver_setmacaddr(int devidx, unsigned char *macaddr);
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -233,7 +233,7 @@ static void set_ethaddr(struct in_addr addr)
                  adapters->PhysicalAddress[2], adapters->PhysicalAddress[3],
                  adapters->PhysicalAddress[4], adapters->PhysicalAddress[5]);
 
-                 (void)netdriver_setmacaddr(adapters->PhysicalAddress);
+                 (void)netdriver_setmacaddr(0, adapters->PhysicalAddress);
               break;
             }
         }
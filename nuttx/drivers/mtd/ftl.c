@@ -46,10 +46,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <semaphore.h>
+#include <assert.h>
 #include <debug.h>
 #include <errno.h>
+#include <crc32.h>
 
 #include <nuttx/kmalloc.h>
+#include <nuttx/wqueue.h>
 #include <nuttx/fs/fs.h>
 #include <nuttx/fs/ioctl.h>
 #include <nuttx/mtd/mtd.h>
@@ -63,10 +67,87 @@
 #  define FTL_HAVE_RWBUFFER 1
 #endif
 
+#ifdef CONFIG_FTL_LOGSTRUCTURED
+#  ifndef CONFIG_FTL_LOG_OVERPROVISION
+#    define CONFIG_FTL_LOG_OVERPROVISION 7
+#  endif
+
+#  ifndef CONFIG_FTL_LOG_GCTHRESHOLD
+#    define CONFIG_FTL_LOG_GCTHRESHOLD 4
+#  endif
+
+#  ifndef CONFIG_FTL_LOG_WLTHRESHOLD
+#    define CONFIG_FTL_LOG_WLTHRESHOLD 64
+#  endif
+
+/* The minimum number of erase blocks not exported as logical sectors.  It
+ * guarantees that garbage collection can always find a victim with stale
+ * pages.
+ */
+
+#  define FTL_LOG_MINRESERVE 2
+
+/* Foreground garbage collection starts when no more than this number of
+ * free erase blocks remain.  The last free block is kept for the copies
+ * made by the garbage collector itself.
+ */
+
+#  define FTL_LOG_GCRESERVE  1
+
+/* Marks an unmapped logical sector or a physical page that does not hold
+ * a current logical sector.
+ */
+
+#  define FTL_LOG_UNMAPPED   0xffffffff
+
+/* Identifies a valid block summary */
+
+#  define FTL_LOG_MAGIC      0x4c54464e  /* "NFTL" */
+
+/* Erase block states */
+
+#  define FTL_BLK_FREE       0  /* Erased (or to be erased) and unused */
+#  define FTL_BLK_OPEN       1  /* The head block being written */
+#  define FTL_BLK_CLOSED     2  /* Full and summarized */
+#  define FTL_BLK_DEAD       3  /* Reclaimed, erased when the head closes */
+
+/* Size of a block summary describing 'n' data pages */
+
+#  define SIZEOF_FTL_LOGSUMMARY_S(n) \
+     (sizeof(struct ftl_logsummary_s) + ((n) - 1) * sizeof(uint32_t))
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
 
+#ifdef CONFIG_FTL_LOGSTRUCTURED
+/* The state of one erase block in the log-structured mode */
+
+struct ftl_logblock_s
+{
+  uint32_t seq;                  /* Sequence number assigned when opened */
+  uint32_t erasecount;           /* Number of times the block was erased */
+  uint16_t nvalid;               /* Number of pages holding current sectors */
+  uint8_t  state;                /* See FTL_BLK_* definitions */
+  bool     dirty;                /* True: Must be erased before it is used */
+};
+
+/* The summary written to the last page(s) of an erase block when it is
+ * closed.  It is the only metadata on the FLASH:  The logical-to-physical
+ * map is rebuilt from the summaries when the device is initialized.
+ */
+
+struct ftl_logsummary_s
+{
+  uint32_t magic;                /* FTL_LOG_MAGIC */
+  uint32_t crc;                  /* CRC32 of the rest of the summary */
+  uint32_t seq;                  /* Sequence number of the block */
+  uint32_t erasecount;           /* Erase count of the block */
+  uint32_t lba[1];               /* Logical sector held in each data page */
+};
+#endif
+
 struct ftl_struct_s
 {
   FAR struct mtd_dev_s *mtd;     /* Contained MTD interface */
@@ -78,6 +159,26 @@ struct ftl_struct_s
 #ifdef CONFIG_FS_WRITABLE
   FAR uint8_t          *eblock;  /* One, in-memory erase block */
 #endif
+#ifdef CONFIG_FTL_LOGSTRUCTURED
+  sem_t                 exclsem; /* Serializes the log and the collector */
+  FAR uint32_t         *l2p;     /* Logical sector to physical page map */
+  FAR uint32_t         *p2l;     /* Physical page to logical sector map */
+  FAR struct ftl_logblock_s *blocks;    /* State of each erase block */
+  FAR struct ftl_logsummary_s *summary; /* Buffer for one block summary */
+  uint32_t              nsectors; /* Number of logical sectors exported */
+  uint32_t              seq;     /* Sequence number of the next block */
+  uint32_t              maxerase; /* Highest erase count of any block */
+  uint32_t              nfree;   /* Number of free erase blocks */
+  uint32_t              ndead;   /* Number of reclaimed blocks */
+  uint32_t              head;    /* The erase block being written */
+  uint16_t              headpage; /* Next page to write in the head block */
+  uint16_t              ndata;   /* Data pages per erase block */
+  uint16_t              nsumm;   /* Summary pages per erase block */
+  bool                  headopen; /* True: The head block is open */
+#ifdef CONFIG_FTL_LOG_BGGC
+  struct work_s         gcwork;  /* Background garbage collection */
+#endif
+#endif
 };
 
 /****************************************************************************
@@ -98,6 +199,10 @@ static ssize_t ftl_write(FAR struct inode *inode, const unsigned char *buffer,
 #endif
 static int     ftl_geometry(FAR struct inode *inode, struct geometry *geometry);
 static int     ftl_ioctl(FAR struct inode *inode, int cmd, unsigned long arg);
+#ifdef CONFIG_FTL_LOGSTRUCTURED
+static int     ftl_log_write(FAR struct ftl_struct_s *dev, uint32_t lba,
+                 FAR const uint8_t *buffer, size_t nsectors, bool gc);
+#endif
 
 /****************************************************************************
  * Private Data
@@ -124,6 +229,724 @@ static const struct block_operations g_bops =
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: ftl_log_lock and ftl_log_unlock
+ *
+ * Description: Get/release exclusive access to the log
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FTL_LOGSTRUCTURED
+static void ftl_log_lock(FAR struct ftl_struct_s *dev)
+{
+  /* Take the semaphore (perhaps waiting) */
+
+  while (sem_wait(&dev->exclsem) != 0)
+    {
+      /* The only case that an error should occur here is if the wait was
+       * awakened by a signal.
+       */
+
+      ASSERT(errno == EINTR);
+    }
+}
+
+#define ftl_log_unlock(dev) (void)sem_post(&(dev)->exclsem)
+#endif
+
+/****************************************************************************
+ * Name: ftl_log_erase
+ *
+ * Description: Erase one erase block and return it to the free pool
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FTL_LOGSTRUCTURED
+static int ftl_log_erase(FAR struct ftl_struct_s *dev, uint32_t eblock)
+{
+  FAR struct ftl_logblock_s *blk = &dev->blocks[eblock];
+  int ret;
+
+  ret = MTD_ERASE(dev->mtd, eblock, 1);
+  if (ret < 0)
+    {
+      ferr("ERROR: Erase block=%d failed: %d\n", eblock, ret);
+      return ret;
+    }
+
+  blk->erasecount++;
+  blk->dirty  = false;
+  blk->nvalid = 0;
+
+  if (blk->erasecount > dev->maxerase)
+    {
+      dev->maxerase = blk->erasecount;
+    }
+
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: ftl_log_invalidate
+ *
+ * Description:
+ *   A physical page no longer holds the current copy of its logical sector.
+ *   A closed erase block without any current sector is reclaimed:  It will
+ *   be erased once the head block (that now holds those sectors) has been
+ *   closed.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FTL_LOGSTRUCTURED
+static void ftl_log_invalidate(FAR struct ftl_struct_s *dev, uint32_t page)
+{
+  FAR struct ftl_logblock_s *blk = &dev->blocks[page / dev->blkper];
+
+  DEBUGASSERT(blk->nvalid > 0);
+
+  dev->p2l[page] = FTL_LOG_UNMAPPED;
+  if (--blk->nvalid == 0 && blk->state == FTL_BLK_CLOSED)
+    {
+      blk->state = FTL_BLK_DEAD;
+      dev->ndead++;
+    }
+}
+#endif
+
+/****************************************************************************
+ * Name: ftl_log_closehead
+ *
+ * Description:
+ *   Write the summary of the head block, making the sectors written to it
+ *   persistent.  Then erase the blocks whose sectors were superseded by
+ *   the ones in the head block.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FTL_LOGSTRUCTURED
+static int ftl_log_closehead(FAR struct ftl_struct_s *dev)
+{
+  FAR struct ftl_logsummary_s *summary = dev->summary;
+  FAR struct ftl_logblock_s *blk;
+  uint32_t first;
+  uint32_t eblock;
+  size_t nxfrd;
+  int i;
+  int ret;
+
+  DEBUGASSERT(dev->headopen);
+
+  blk   = &dev->blocks[dev->head];
+  first = dev->head * dev->blkper;
+
+  memset(summary, 0xff, dev->nsumm * dev->geo.blocksize);
+  summary->magic      = FTL_LOG_MAGIC;
+  summary->seq        = blk->seq;
+  summary->erasecount = blk->erasecount;
+
+  for (i = 0; i < dev->ndata; i++)
+    {
+      summary->lba[i] = dev->p2l[first + i];
+    }
+
+  summary->crc = crc32((FAR const uint8_t *)&summary->seq,
+                       SIZEOF_FTL_LOGSUMMARY_S(dev->ndata) - 8);
+
+  nxfrd = MTD_BWRITE(dev->mtd, first + dev->ndata, dev->nsumm,
+                     (FAR const uint8_t *)summary);
+  if (nxfrd != dev->nsumm)
+    {
+      ferr("ERROR: Write summary of block %d failed: %d\n",
+           dev->head, nxfrd);
+      return -EIO;
+    }
+
+  dev->headopen = false;
+  if (blk->nvalid > 0)
+    {
+      blk->state = FTL_BLK_CLOSED;
+    }
+  else
+    {
+      blk->state = FTL_BLK_DEAD;
+      dev->ndead++;
+    }
+
+  /* The sectors of the reclaimed blocks are now safely elsewhere */
+
+  for (eblock = 0; dev->ndead > 0 && eblock < dev->geo.neraseblocks;
+       eblock++)
+    {
+      blk = &dev->blocks[eblock];
+      if (blk->state == FTL_BLK_DEAD)
+        {
+          ret = ftl_log_erase(dev, eblock);
+          if (ret < 0)
+            {
+              return ret;
+            }
+
+          blk->state = FTL_BLK_FREE;
+          dev->ndead--;
+          dev->nfree++;
+        }
+    }
+
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: ftl_log_openhead
+ *
+ * Description:
+ *   Start writing to the free erase block with the lowest erase count.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FTL_LOGSTRUCTURED
+static int ftl_log_openhead(FAR struct ftl_struct_s *dev)
+{
+  FAR struct ftl_logblock_s *blk;
+  uint32_t best = FTL_LOG_UNMAPPED;
+  uint32_t eblock;
+  int ret;
+
+  DEBUGASSERT(!dev->headopen);
+
+  for (eblock = 0; eblock < dev->geo.neraseblocks; eblock++)
+    {
+      blk = &dev->blocks[eblock];
+      if (blk->state == FTL_BLK_FREE &&
+          (best == FTL_LOG_UNMAPPED ||
+           blk->erasecount < dev->blocks[best].erasecount))
+        {
+          best = eblock;
+        }
+    }
+
+  if (best == FTL_LOG_UNMAPPED)
+    {
+      ferr("ERROR: No free erase block\n");
+      return -ENOSPC;
+    }
+
+  blk = &dev->blocks[best];
+  if (blk->dirty)
+    {
+      ret = ftl_log_erase(dev, best);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  blk->state     = FTL_BLK_OPEN;
+  blk->seq       = dev->seq++;
+  blk->nvalid    = 0;
+
+  dev->head      = best;
+  dev->headpage  = 0;
+  dev->headopen  = true;
+  dev->nfree--;
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: ftl_log_gc
+ *
+ * Description:
+ *   Reclaim one closed erase block by copying its current sectors to the
+ *   head block.  The victim is the block with the fewest current sectors
+ *   or, for wear leveling, the block with the lowest erase count.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FTL_LOGSTRUCTURED
+static int ftl_log_gc(FAR struct ftl_struct_s *dev, bool wearlevel)
+{
+  FAR struct ftl_logblock_s *blk;
+  uint32_t victim = FTL_LOG_UNMAPPED;
+  uint32_t eblock;
+  uint32_t first;
+  uint32_t lba;
+  size_t nxfrd;
+  int ret;
+  int i;
+
+  for (eblock = 0; eblock < dev->geo.neraseblocks; eblock++)
+    {
+      blk = &dev->blocks[eblock];
+      if (blk->state != FTL_BLK_CLOSED)
+        {
+          continue;
+        }
+
+      if (victim == FTL_LOG_UNMAPPED ||
+          (wearlevel && blk->erasecount < dev->blocks[victim].erasecount) ||
+          (!wearlevel && blk->nvalid < dev->blocks[victim].nvalid))
+        {
+          victim = eblock;
+        }
+    }
+
+  if (victim == FTL_LOG_UNMAPPED ||
+      (!wearlevel && dev->blocks[victim].nvalid >= dev->ndata))
+    {
+      return -ENOSPC;
+    }
+
+  finfo("Reclaim block=%d nvalid=%d erasecount=%d\n",
+        victim, dev->blocks[victim].nvalid, dev->blocks[victim].erasecount);
+
+  first = victim * dev->blkper;
+  nxfrd = MTD_BREAD(dev->mtd, first, dev->ndata, dev->eblock);
+  if (nxfrd != dev->ndata)
+    {
+      ferr("ERROR: Read erase block %d failed: %d\n", victim, nxfrd);
+      return -EIO;
+    }
+
+  /* Each copy invalidates the original.  The victim is reclaimed when the
+   * last one has been copied.
+   */
+
+  for (i = 0; i < dev->ndata; i++)
+    {
+      lba = dev->p2l[first + i];
+      if (lba != FTL_LOG_UNMAPPED)
+        {
+          ret = ftl_log_write(dev, lba, dev->eblock + i * dev->geo.blocksize,
+                              1, true);
+          if (ret < 0)
+            {
+              return ret;
+            }
+        }
+    }
+
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: ftl_log_wearlevel
+ *
+ * Description:
+ *   Static wear leveling:  If the erase counts have drifted too far apart,
+ *   relocate the sectors of the least worn closed block (which probably
+ *   hold data that is never rewritten) so that the block returns to the
+ *   free pool.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FTL_LOGSTRUCTURED
+static int ftl_log_wearlevel(FAR struct ftl_struct_s *dev)
+{
+  uint32_t minerase = UINT32_MAX;
+  uint32_t eblock;
+
+  /* A full block may be moved.  That needs one free block if the head
+   * block is closed and the garbage collection reserve on top of it if the
+   * copies may spill over from the head block.
+   */
+
+  if (dev->nfree <= (dev->headopen ? FTL_LOG_GCRESERVE : 0))
+    {
+      return OK;
+    }
+
+  for (eblock = 0; eblock < dev->geo.neraseblocks; eblock++)
+    {
+      if (dev->blocks[eblock].state == FTL_BLK_CLOSED &&
+          dev->blocks[eblock].erasecount < minerase)
+        {
+          minerase = dev->blocks[eblock].erasecount;
+        }
+    }
+
+  if (minerase == UINT32_MAX ||
+      dev->maxerase - minerase <= CONFIG_FTL_LOG_WLTHRESHOLD)
+    {
+      return OK;
+    }
+
+  return ftl_log_gc(dev, true);
+}
+#endif
+
+/****************************************************************************
+ * Name: ftl_log_allocpage
+ *
+ * Description:
+ *   Make sure that there is a free page in the head block, closing the
+ *   full head block and reclaiming space as necessary.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FTL_LOGSTRUCTURED
+static int ftl_log_allocpage(FAR struct ftl_struct_s *dev, bool gc)
+{
+  int ret;
+
+  while (!dev->headopen || dev->headpage >= dev->ndata)
+    {
+      if (dev->headopen)
+        {
+          ret = ftl_log_closehead(dev);
+          if (ret >= 0 && !gc)
+            {
+              ret = ftl_log_wearlevel(dev);
+            }
+        }
+      else if (!gc && dev->nfree <= FTL_LOG_GCRESERVE)
+        {
+          /* The copies go to a new head block taken from the reserve and
+           * the host write continues in that block.
+           */
+
+          ret = ftl_log_gc(dev, false);
+          if (ret == -ENOSPC && dev->nfree > 0)
+            {
+              ret = ftl_log_openhead(dev);
+            }
+        }
+      else
+        {
+          ret = ftl_log_openhead(dev);
+        }
+
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: ftl_log_write
+ *
+ * Description:
+ *   Append sectors to the head block and update the maps.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FTL_LOGSTRUCTURED
+static int ftl_log_write(FAR struct ftl_struct_s *dev, uint32_t lba,
+                         FAR const uint8_t *buffer, size_t nsectors, bool gc)
+{
+  uint32_t page;
+  uint32_t old;
+  size_t nxfrd;
+  size_t n;
+  size_t i;
+  int ret;
+
+  while (nsectors > 0)
+    {
+      ret = ftl_log_allocpage(dev, gc);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      /* Write as many sectors as fit in the head block at once */
+
+      n = dev->ndata - dev->headpage;
+      if (n > nsectors)
+        {
+          n = nsectors;
+        }
+
+      page  = dev->head * dev->blkper + dev->headpage;
+      nxfrd = MTD_BWRITE(dev->mtd, page, n, buffer);
+      if (nxfrd != n)
+        {
+          ferr("ERROR: Write %d pages at %d failed: %d\n", n, page, nxfrd);
+          return -EIO;
+        }
+
+      for (i = 0; i < n; i++)
+        {
+          old = dev->l2p[lba + i];
+          if (old != FTL_LOG_UNMAPPED)
+            {
+              ftl_log_invalidate(dev, old);
+            }
+
+          dev->l2p[lba + i]  = page + i;
+          dev->p2l[page + i] = lba + i;
+          dev->blocks[dev->head].nvalid++;
+        }
+
+      dev->headpage += n;
+      lba           += n;
+      buffer        += n * dev->geo.blocksize;
+      nsectors      -= n;
+    }
+
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: ftl_log_gcworker
+ *
+ * Description:
+ *   Reclaim space on the low priority work queue so that host writes
+ *   rarely have to wait for the garbage collection.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FTL_LOG_BGGC
+static void ftl_log_gcworker(FAR void *arg)
+{
+  FAR struct ftl_struct_s *dev = (FAR struct ftl_struct_s *)arg;
+
+  ftl_log_lock(dev);
+
+  while (dev->nfree > FTL_LOG_GCRESERVE &&
+         dev->nfree + dev->ndead < CONFIG_FTL_LOG_GCTHRESHOLD)
+    {
+      if (ftl_log_gc(dev, false) < 0)
+        {
+          break;
+        }
+    }
+
+  (void)ftl_log_wearlevel(dev);
+  ftl_log_unlock(dev);
+}
+#endif
+
+/****************************************************************************
+ * Name: ftl_log_mount
+ *
+ * Description:
+ *   Rebuild the maps from the summaries of the closed erase blocks.  When
+ *   the same logical sector is found in several blocks, the copy in the
+ *   block with the highest sequence number is the current one.  Blocks
+ *   without a valid summary are erased before they are used.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FTL_LOGSTRUCTURED
+static int ftl_log_mount(FAR struct ftl_struct_s *dev)
+{
+  FAR struct ftl_logsummary_s *summary = dev->summary;
+  FAR struct ftl_logblock_s *blk;
+  uint64_t erasesum = 0;
+  uint32_t nknown = 0;
+  uint32_t eblock;
+  uint32_t first;
+  uint32_t page;
+  uint32_t lba;
+  uint32_t old;
+  size_t nxfrd;
+  int i;
+
+  memset(dev->l2p, 0xff, dev->nsectors * sizeof(uint32_t));
+  memset(dev->p2l, 0xff,
+         dev->geo.neraseblocks * dev->blkper * sizeof(uint32_t));
+  memset(dev->blocks, 0,
+         dev->geo.neraseblocks * sizeof(struct ftl_logblock_s));
+
+  dev->seq      = 1;
+  dev->maxerase = 0;
+  dev->nfree    = 0;
+  dev->ndead    = 0;
+  dev->headopen = false;
+
+  for (eblock = 0; eblock < dev->geo.neraseblocks; eblock++)
+    {
+      blk   = &dev->blocks[eblock];
+      first = eblock * dev->blkper;
+
+      nxfrd = MTD_BREAD(dev->mtd, first + dev->ndata, dev->nsumm,
+                        (FAR uint8_t *)summary);
+      if (nxfrd != dev->nsumm || summary->magic != FTL_LOG_MAGIC ||
+          summary->crc != crc32((FAR const uint8_t *)&summary->seq,
+                                SIZEOF_FTL_LOGSUMMARY_S(dev->ndata) - 8))
+        {
+          blk->state = FTL_BLK_FREE;
+          blk->dirty = true;
+          dev->nfree++;
+          continue;
+        }
+
+      blk->state      = FTL_BLK_CLOSED;
+      blk->seq        = summary->seq;
+      blk->erasecount = summary->erasecount;
+
+      erasesum += blk->erasecount;
+      nknown++;
+
+      if (blk->seq >= dev->seq)
+        {
+          dev->seq = blk->seq + 1;
+        }
+
+      if (blk->erasecount > dev->maxerase)
+        {
+          dev->maxerase = blk->erasecount;
+        }
+
+      for (i = 0; i < dev->ndata; i++)
+        {
+          lba = summary->lba[i];
+          if (lba >= dev->nsectors)
+            {
+              continue;
+            }
+
+          /* Within a block, later pages supersede earlier ones */
+
+          page = first + i;
+          old  = dev->l2p[lba];
+          if (old != FTL_LOG_UNMAPPED)
+            {
+              if (dev->blocks[old / dev->blkper].seq > blk->seq)
+                {
+                  continue;
+                }
+
+              dev->p2l[old] = FTL_LOG_UNMAPPED;
+              dev->blocks[old / dev->blkper].nvalid--;
+            }
+
+          dev->l2p[lba]  = page;
+          dev->p2l[page] = lba;
+          blk->nvalid++;
+        }
+    }
+
+  /* Closed blocks without current sectors are free.  The erase counts of
+   * blocks without a summary are unknown:  Assume the average.
+   */
+
+  for (eblock = 0; eblock < dev->geo.neraseblocks; eblock++)
+    {
+      blk = &dev->blocks[eblock];
+      if (blk->state == FTL_BLK_CLOSED && blk->nvalid == 0)
+        {
+          blk->state = FTL_BLK_FREE;
+          blk->dirty = true;
+          dev->nfree++;
+        }
+      else if (blk->state == FTL_BLK_FREE && nknown > 0)
+        {
+          blk->erasecount = (uint32_t)(erasesum / nknown);
+        }
+    }
+
+  finfo("nsectors=%d nfree=%d seq=%d\n", dev->nsectors, dev->nfree,
+        dev->seq);
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: ftl_log_initialize
+ *
+ * Description:
+ *   Size the log-structured layout, allocate the maps and mount the log.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FTL_LOGSTRUCTURED
+static int ftl_log_initialize(FAR struct ftl_struct_s *dev)
+{
+  uint32_t nreserve;
+  uint32_t npages;
+  int ret;
+
+  /* Reserve enough pages at the end of each erase block for its summary */
+
+  for (dev->nsumm = 1; dev->nsumm < dev->blkper; dev->nsumm++)
+    {
+      if (SIZEOF_FTL_LOGSUMMARY_S(dev->blkper - dev->nsumm) <=
+          dev->nsumm * dev->geo.blocksize)
+        {
+          break;
+        }
+    }
+
+  /* Do not export the over-provisioned erase blocks */
+
+  nreserve = dev->geo.neraseblocks * CONFIG_FTL_LOG_OVERPROVISION / 100;
+  if (nreserve < FTL_LOG_MINRESERVE)
+    {
+      nreserve = FTL_LOG_MINRESERVE;
+    }
+
+  dev->ndata = dev->blkper - dev->nsumm;
+  if (dev->ndata < 1 ||
+      dev->geo.neraseblocks <= nreserve + FTL_LOG_GCRESERVE)
+    {
+      ferr("ERROR: Geometry too small for the log-structured FTL\n");
+      return -EINVAL;
+    }
+
+  npages        = dev->geo.neraseblocks * dev->blkper;
+  dev->nsectors = (dev->geo.neraseblocks - nreserve) * dev->ndata;
+
+  dev->l2p     = (FAR uint32_t *)kmm_malloc(dev->nsectors * sizeof(uint32_t));
+  dev->p2l     = (FAR uint32_t *)kmm_malloc(npages * sizeof(uint32_t));
+  dev->blocks  = (FAR struct ftl_logblock_s *)
+    kmm_malloc(dev->geo.neraseblocks * sizeof(struct ftl_logblock_s));
+  dev->summary = (FAR struct ftl_logsummary_s *)
+    kmm_malloc(dev->nsumm * dev->geo.blocksize);
+
+  if (!dev->l2p || !dev->p2l || !dev->blocks || !dev->summary)
+    {
+      ferr("ERROR: Failed to allocate the FTL maps\n");
+      ret = -ENOMEM;
+      goto errout;
+    }
+
+  sem_init(&dev->exclsem, 0, 1);
+
+  ret = ftl_log_mount(dev);
+  if (ret < 0)
+    {
+      sem_destroy(&dev->exclsem);
+      goto errout;
+    }
+
+  return OK;
+
+errout:
+  kmm_free(dev->l2p);
+  kmm_free(dev->p2l);
+  kmm_free(dev->blocks);
+  kmm_free(dev->summary);
+  return ret;
+}
+#endif
+
+/****************************************************************************
+ * Name: ftl_log_uninitialize
+ *
+ * Description: Free the resources allocated by ftl_log_initialize
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FTL_LOGSTRUCTURED
+static void ftl_log_uninitialize(FAR struct ftl_struct_s *dev)
+{
+  sem_destroy(&dev->exclsem);
+  kmm_free(dev->l2p);
+  kmm_free(dev->p2l);
+  kmm_free(dev->blocks);
+  kmm_free(dev->summary);
+}
+#endif
+
 /****************************************************************************
  * Name: ftl_open
  *
@@ -146,8 +969,31 @@ static int ftl_open(FAR struct inode *inode)
 
 static int ftl_close(FAR struct inode *inode)
 {
+#ifdef CONFIG_FTL_LOGSTRUCTURED
+  FAR struct ftl_struct_s *dev;
+  int ret = OK;
+
+  finfo("Entry\n");
+
+  DEBUGASSERT(inode && inode->i_private);
+  dev = (FAR struct ftl_struct_s *)inode->i_private;
+
+  /* The sectors in the head block are not persistent until its summary
+   * has been written.
+   */
+
+  ftl_log_lock(dev);
+  if (dev->headopen && dev->headpage > 0)
+    {
+      ret = ftl_log_closehead(dev);
+    }
+
+  ftl_log_unlock(dev);
+  return ret;
+#else
   finfo("Entry\n");
   return OK;
+#endif
 }
 
 /****************************************************************************
@@ -157,6 +1003,59 @@ static int ftl_close(FAR struct inode *inode)
  *
  ****************************************************************************/
 
+#ifdef CONFIG_FTL_LOGSTRUCTURED
+static ssize_t ftl_reload(FAR void *priv, FAR uint8_t *buffer,
+                          off_t startblock, size_t nblocks)
+{
+  FAR struct ftl_struct_s *dev = (FAR struct ftl_struct_s *)priv;
+  size_t remaining = nblocks;
+  uint32_t lba = startblock;
+  uint32_t page;
+  size_t nxfrd;
+  size_t n;
+
+  DEBUGASSERT(startblock + nblocks <= dev->nsectors);
+
+  ftl_log_lock(dev);
+  while (remaining > 0)
+    {
+      page = dev->l2p[lba];
+      n    = 1;
+
+      if (page == FTL_LOG_UNMAPPED)
+        {
+          /* Never written:  Looks like erased FLASH */
+
+          memset(buffer, 0xff, dev->geo.blocksize);
+        }
+      else
+        {
+          /* Read physically contiguous sectors at once */
+
+          while (n < remaining && dev->l2p[lba + n] == page + n)
+            {
+              n++;
+            }
+
+          nxfrd = MTD_BREAD(dev->mtd, page, n, buffer);
+          if (nxfrd != n)
+            {
+              ferr("ERROR: Read %d pages at %d failed: %d\n",
+                   n, page, nxfrd);
+              ftl_log_unlock(dev);
+              return -EIO;
+            }
+        }
+
+      lba       += n;
+      buffer    += n * dev->geo.blocksize;
+      remaining -= n;
+    }
+
+  ftl_log_unlock(dev);
+  return nblocks;
+}
+#else
 static ssize_t ftl_reload(FAR void *priv, FAR uint8_t *buffer,
                           off_t startblock, size_t nblocks)
 {
@@ -174,6 +1073,7 @@ static ssize_t ftl_reload(FAR void *priv, FAR uint8_t *buffer,
 
   return nread;
 }
+#endif
 
 /****************************************************************************
  * Name: ftl_read
@@ -206,7 +1106,32 @@ static ssize_t ftl_read(FAR struct inode *inode, unsigned char *buffer,
  *
  ****************************************************************************/
 
-#ifdef CONFIG_FS_WRITABLE
+#if defined(CONFIG_FS_WRITABLE) && defined(CONFIG_FTL_LOGSTRUCTURED)
+static ssize_t ftl_flush(FAR void *priv, FAR const uint8_t *buffer,
+                         off_t startblock, size_t nblocks)
+{
+  FAR struct ftl_struct_s *dev = (FAR struct ftl_struct_s *)priv;
+  int ret;
+
+  DEBUGASSERT(startblock + nblocks <= dev->nsectors);
+
+  ftl_log_lock(dev);
+  ret = ftl_log_write(dev, startblock, buffer, nblocks, false);
+
+#ifdef CONFIG_FTL_LOG_BGGC
+  /* Reclaim space in the background before the writer has to */
+
+  if (dev->nfree + dev->ndead < CONFIG_FTL_LOG_GCTHRESHOLD &&
+      work_available(&dev->gcwork))
+    {
+      (void)work_queue(LPWORK, &dev->gcwork, ftl_log_gcworker, dev, 0);
+    }
+#endif
+
+  ftl_log_unlock(dev);
+  return ret < 0 ? ret : nblocks;
+}
+#elif defined(CONFIG_FS_WRITABLE)
 static ssize_t ftl_flush(FAR void *priv, FAR const uint8_t *buffer,
                          off_t startblock, size_t nblocks)
 {
@@ -425,7 +1350,11 @@ static int ftl_geometry(FAR struct inode *inode, struct geometry *geometry)
 #else
       geometry->geo_writeenabled  = false;
 #endif
+#ifdef CONFIG_FTL_LOGSTRUCTURED
+      geometry->geo_nsectors      = dev->nsectors;
+#else
       geometry->geo_nsectors      = dev->geo.neraseblocks * dev->blkper;
+#endif
       geometry->geo_sectorsize    = dev->geo.blocksize;
 
       finfo("available: true mediachanged: false writeenabled: %s\n",
@@ -459,6 +1388,35 @@ static int ftl_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
    * different form).
    */
 
+  dev = (struct ftl_struct_s *)inode->i_private;
+
+#ifdef CONFIG_FTL_LOGSTRUCTURED
+  /* Logical sectors are not at fixed locations in the FLASH */
+
+  if (cmd == BIOC_XIPBASE)
+    {
+      return -ENOTTY;
+    }
+
+  /* The sectors in the head block are not persistent until its summary
+   * has been written.  Close the head block early to make them persistent.
+   * The rest of the block is left unused until it is reclaimed.
+   */
+
+  if (cmd == BIOC_FLUSH)
+    {
+      ret = OK;
+
+      ftl_log_lock(dev);
+      if (dev->headopen && dev->headpage > 0)
+        {
+          ret = ftl_log_closehead(dev);
+        }
+
+      ftl_log_unlock(dev);
+      return ret;
+    }
+#else
   if (cmd == BIOC_XIPBASE)
     {
       /* The argument accompanying the BIOC_XIPBASE should be non-NULL.  If
@@ -478,13 +1436,13 @@ static int ftl_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
 
       cmd = MTDIOC_XIPBASE;
     }
+#endif
 
   /* No other block driver ioctl commmands are not recognized by this
    * driver.  Other possible MTD driver ioctl commands are passed through
    * to the MTD driver (unchanged).
    */
 
-  dev = (struct ftl_struct_s *)inode->i_private;
   ret = MTD_IOCTL(dev->mtd, cmd, arg);
   if (ret < 0)
     {
@@ -565,11 +1523,25 @@ int ftl_initialize(int minor, FAR struct mtd_dev_s *mtd)
       dev->blkper = dev->geo.erasesize / dev->geo.blocksize;
       DEBUGASSERT(dev->blkper * dev->geo.blocksize == dev->geo.erasesize);
 
+#ifdef CONFIG_FTL_LOGSTRUCTURED
+      ret = ftl_log_initialize(dev);
+      if (ret < 0)
+        {
+          kmm_free(dev->eblock);
+          kmm_free(dev);
+          return ret;
+        }
+#endif
+
       /* Configure read-ahead/write buffering */
 
 #ifdef FTL_HAVE_RWBUFFER
       dev->rwb.blocksize   = dev->geo.blocksize;
+#ifdef CONFIG_FTL_LOGSTRUCTURED
+      dev->rwb.nblocks     = dev->nsectors;
+#else
       dev->rwb.nblocks     = dev->geo.neraseblocks * dev->blkper;
+#endif
       dev->rwb.dev         = (FAR void *)dev;
 
 #if defined(CONFIG_FS_WRITABLE) && defined(CONFIG_FTL_WRITEBUFFER)
@@ -586,6 +1558,9 @@ int ftl_initialize(int minor, FAR struct mtd_dev_s *mtd)
       if (ret < 0)
         {
           ferr("ERROR: rwb_initialize failed: %d\n", ret);
+#ifdef CONFIG_FTL_LOGSTRUCTURED
+          ftl_log_uninitialize(dev);
+#endif
 #ifdef CONFIG_FS_WRITABLE
           kmm_free(dev->eblock);
 #endif
@@ -604,6 +1579,9 @@ int ftl_initialize(int minor, FAR struct mtd_dev_s *mtd)
       if (ret < 0)
         {
           ferr("ERROR: register_blockdriver failed: %d\n", -ret);
+#ifdef CONFIG_FTL_LOGSTRUCTURED
+          ftl_log_uninitialize(dev);
+#endif
 #ifdef CONFIG_FS_WRITABLE
           kmm_free(dev->eblock);
 #endif
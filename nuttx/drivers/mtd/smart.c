@@ -109,6 +109,7 @@
 #define SMART_FMT_VERSION_POS     (SMART_FMT_POS1 + 4)
 #define SMART_FMT_NAMESIZE_POS    (SMART_FMT_POS1 + 5)
 #define SMART_FMT_ROOTDIRS_POS    (SMART_FMT_POS1 + 6)
+#define SMART_FMT_CHECKPOINT_POS  (SMART_FMT_POS1 + 7)
 #define SMARTFS_FMT_WEAR_POS      36
 #define SMART_WEAR_LEVEL_FORMAT_SIG 32
 #define SMART_PARTNAME_SIZE         4
@@ -142,6 +143,23 @@
 #define smart_free(d, p)        kmm_free(p)
 #endif
 
+/* Checkpoint signature and the value recorded in the format sector of a
+ * volume formatted with a checkpoint area.
+ */
+
+#define SMART_CP_SIG1             'S'
+#define SMART_CP_SIG2             'M'
+#define SMART_CP_SIG3             'C'
+#define SMART_CP_SIG4             'P'
+#define SMART_FMT_CHECKPOINT_SIG  'C'
+
+#define SMART_NBLOCKS(n, s)       (((n) + (s) - 1) / (s))
+#define SMART_CP_ISDIRTY(d, b)    (((d)->cpdirty[(b) >> 3] & (1 << ((b) & 0x07))) != 0)
+
+#ifndef CONFIG_MTD_SMART_CHECKPOINT
+#  define smart_checkpoint_touch(d, b)
+#endif
+
 #define SMART_WEAR_FULL_RELOCATE_THRESHOLD  8
 #define SMART_WEAR_REORG_THRESHOLD          14
 #define SMART_WEAR_MIN_LEVEL                5
@@ -213,6 +231,28 @@ struct smart_allocsector_s
 };
 #endif
 
+/* Header of one copy of the checkpoint.  The header occupies the first MTD
+ * block of the copy.  It is followed, starting with the next MTD block, by
+ * the logical sector map and the release and free counts of each erase
+ * block as they are held in RAM.  The next MTD block boundary after those
+ * begins a bit map of the erase blocks modified after the checkpoint was
+ * written.  A bit is programmed before its erase block is first modified.
+ */
+
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+struct smart_cphdr_s
+{
+  uint8_t               signature[4];     /* SMART_CP_SIG1-4 */
+  uint32_t              seq;              /* Incremented for each checkpoint */
+  uint16_t              sectorsize;       /* Sector size of the volume */
+  uint16_t              totalsectors;     /* Number of logical sectors */
+  uint16_t              neraseblocks;     /* Number of erase blocks in use */
+  uint16_t              reserved;
+  uint32_t              datacrc;          /* CRC-32 of the map and counts */
+  uint32_t              crc;              /* CRC-32 of the preceding fields */
+};
+#endif
+
 struct smart_struct_s
 {
   FAR struct mtd_dev_s *mtd;              /* Contained MTD interface */
@@ -267,6 +307,18 @@ struct smart_struct_s
 #ifdef CONFIG_MTD_SMART_SECTOR_ERASE_DEBUG
   FAR uint8_t          *erasecounts;      /* Number of erases for each erase block */
 #endif
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+  uint16_t              mtdneraseblocks;  /* Number of erase blocks on the MTD device */
+  uint16_t              cpblocks;         /* Erase blocks in each checkpoint copy */
+  uint16_t              cpndirty;         /* Erase blocks modified since the checkpoint */
+  uint8_t               cpcopy;           /* Copy holding the current checkpoint */
+  bool                  cpvalid;          /* The current checkpoint copy is valid */
+  bool                  cpformat;         /* Volume was formatted with a checkpoint area */
+  bool                  cpnone;           /* Do not reserve a checkpoint area */
+  uint32_t              cpseq;            /* Sequence number of the current checkpoint */
+  FAR uint8_t          *cpbuffer;         /* MTD block buffer for checkpoint I/O */
+  FAR uint8_t          *cpdirty;          /* Bit map of modified erase blocks */
+#endif
 #ifdef CONFIG_MTD_SMART_ALLOC_DEBUG
   size_t                bytesalloc;
   struct smart_alloc_s  alloc[SMART_MAX_ALLOCS];   /* Array of memory allocations */
@@ -387,6 +439,13 @@ static int smart_relocate_static_data(FAR struct smart_struct_s *dev, uint16_t b
 static int smart_relocate_sector(FAR struct smart_struct_s *dev,
                  uint16_t oldsector, uint16_t newsector);
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+static uint16_t smart_checkpoint_blocks(FAR struct smart_struct_s *dev);
+static void smart_checkpoint_touch(FAR struct smart_struct_s *dev,
+                                   uint16_t block);
+static int smart_checkpoint_write(FAR struct smart_struct_s *dev);
+#endif
+
 #ifdef CONFIG_SMART_DEV_LOOP
 static ssize_t smart_loop_read(FAR struct file *filep, FAR char *buffer,
                  size_t buflen);
@@ -882,6 +941,7 @@ static ssize_t smart_write(FAR struct inode *inode,
           /* Erase the erase block */
 
           eraseblock = alignedblock / mtdBlksPerErase;
+          smart_checkpoint_touch(dev, eraseblock);
           ret = MTD_ERASE(dev->mtd, eraseblock, 1);
           if (ret < 0)
             {
@@ -909,6 +969,7 @@ static ssize_t smart_write(FAR struct inode *inode,
       /* Try to write to the sector. */
 
       finfo("Write MTD block %d from offset %d\n", nextblock, offset);
+      smart_checkpoint_touch(dev, nextblock / mtdBlksPerErase);
       nxfrd = MTD_BWRITE(dev->mtd, nextblock, blkstowrite, &buffer[offset]);
       if (nxfrd != blkstowrite)
         {
@@ -1044,6 +1105,16 @@ static int smart_setsectorsize(FAR struct smart_struct_s *dev, uint16_t size)
         }
     }
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+  /* Reserve erase blocks at the end of the device for two copies of the
+   * checkpoint.  The volume uses only the erase blocks before them.
+   */
+
+  dev->cpblocks         = dev->cpnone ? 0 : smart_checkpoint_blocks(dev);
+  dev->geo.neraseblocks = dev->mtdneraseblocks - 2 * dev->cpblocks;
+  dev->neraseblocks     = dev->geo.neraseblocks;
+#endif
+
 #if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
   dev->unusedsectors = 0;
   dev->blockerases = 0;
@@ -1084,6 +1155,17 @@ static int smart_setsectorsize(FAR struct smart_struct_s *dev, uint16_t size)
     }
 #endif
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+  if (dev->cpbuffer != NULL)
+    {
+      smart_free(dev, dev->cpbuffer);
+      dev->cpbuffer = NULL;
+    }
+
+  dev->cpvalid  = false;
+  dev->cpndirty = 0;
+#endif
+
   /* Allocate a virtual to physical sector map buffer.  Also allocate
    * the storage space for releasecount and freecounts.
    */
@@ -1220,6 +1302,21 @@ static int smart_setsectorsize(FAR struct smart_struct_s *dev, uint16_t size)
   dev->uneven_wearcount = 0;
 #endif
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+  /* Allocate the checkpoint I/O buffer and the modified erase block map */
+
+  dev->cpbuffer = (FAR uint8_t *) smart_malloc(dev, dev->geo.blocksize +
+      ((dev->neraseblocks + 7) >> 3), "Checkpoint");
+  if (!dev->cpbuffer)
+    {
+      ferr("ERROR: Error allocating checkpoint buffer\n");
+      goto errexit;
+    }
+
+  dev->cpdirty = dev->cpbuffer + dev->geo.blocksize;
+  memset(dev->cpdirty, 0, (dev->neraseblocks + 7) >> 3);
+#endif
+
   /* Allocate a read/write buffer */
 
   dev->rwbuffer = (FAR char *) smart_malloc(dev, size, "RW Buffer");
@@ -1269,6 +1366,13 @@ errexit:
     }
 #endif
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+  if (dev->cpbuffer)
+    {
+      smart_free(dev, dev->cpbuffer);
+    }
+#endif
+
   kmm_free(dev);
   return -ENOMEM;
 }
@@ -1289,6 +1393,8 @@ static ssize_t smart_bytewrite(FAR struct smart_struct_s *dev, size_t offset,
 {
   ssize_t       ret;
 
+  smart_checkpoint_touch(dev, offset / dev->geo.erasesize);
+
 #ifdef CONFIG_MTD_BYTE_WRITE
   /* Check if the underlying MTD device supports write */
 
@@ -1792,472 +1898,1146 @@ static int smart_set_wear_level(FAR struct smart_struct_s *dev, uint16_t block,
 #endif
 
 /****************************************************************************
- * Name: smart_scan
+ * Name: smart_scan_format
  *
- * Description: Performs a scan of the MTD device searching for format
- *              information and fills in logical sector mapping, freesector
- *              count, etc.
+ * Description: Validates the format signature in the physical sector at
+ *              'readaddress' that holds logical sector zero and, if it is
+ *              valid, records the format information of the volume.
+ *
+ * Returned Value:
+ *   OK if the signature is valid, -EINVAL if it is not, or another negated
+ *   errno value on a failure.
  *
  ****************************************************************************/
 
-static int smart_scan(FAR struct smart_struct_s *dev)
+static int smart_scan_format(FAR struct smart_struct_s *dev,
+                             uint32_t readaddress)
 {
-  int       sector;
   int       ret;
-  uint16_t  totalsectors;
-  uint16_t  sectorsize, prerelease;
-  uint16_t  logicalsector;
-  uint16_t  loser;
-  uint32_t  readaddress;
-  uint32_t  offset;
-  uint16_t  seq1;
-  uint16_t  seq2;
-  struct    smart_sect_header_s header;
-#ifdef CONFIG_MTD_SMART_MINIMIZE_RAM
-  int       dupsector;
-  uint16_t  duplogsector;
-#endif
 #ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
   int       x;
   char      devname[22];
   FAR struct smart_multiroot_device_s *rootdirdev;
 #endif
 
-  finfo("Entry\n");
+  /* Read the sector data */
 
-  /* Find the sector size on the volume by reading headers from
-   * sectors of decreasing size.  On a formatted volume, the sector
-   * size is saved in the header status byte of seach sector, so
-   * by starting with the largest supported sector size and
-   * decreasing from there, we will be sure to find data that is
-   * a header and not sector data.
-   */
+  ret = MTD_READ(dev->mtd, readaddress, 32,
+                 (FAR uint8_t *)dev->rwbuffer);
+  if (ret != 32)
+    {
+      ferr("ERROR: Error reading format sector.\n");
+      return -EIO;
+    }
 
-  sectorsize = 0xffff;
-  offset = 16384;
+  /* Validate the format signature */
 
-  while (sectorsize == 0xffff)
+  if (dev->rwbuffer[SMART_FMT_POS1] != SMART_FMT_SIG1 ||
+      dev->rwbuffer[SMART_FMT_POS2] != SMART_FMT_SIG2 ||
+      dev->rwbuffer[SMART_FMT_POS3] != SMART_FMT_SIG3 ||
+      dev->rwbuffer[SMART_FMT_POS4] != SMART_FMT_SIG4)
     {
-      readaddress = 0;
+      return -EINVAL;
+    }
 
-      while (readaddress < dev->erasesize * dev->geo.neraseblocks)
-        {
-          /* Read the next sector from the device */
+  /* Mark the volume as formatted and set the sector size */
 
-          ret = MTD_READ(dev->mtd, 0, sizeof(struct smart_sect_header_s),
-                         (FAR uint8_t *) &header);
-          if (ret != sizeof(struct smart_sect_header_s))
-            {
-              goto err_out;
-            }
+  dev->formatstatus = SMART_FMT_STAT_FORMATTED;
+  dev->namesize = dev->rwbuffer[SMART_FMT_NAMESIZE_POS];
+  dev->formatversion = dev->rwbuffer[SMART_FMT_VERSION_POS];
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+  dev->cpformat = dev->rwbuffer[SMART_FMT_CHECKPOINT_POS] ==
+                  SMART_FMT_CHECKPOINT_SIG;
+#endif
 
-          if (header.status != CONFIG_SMARTFS_ERASEDSTATE)
-            {
-              sectorsize = (header.status & SMART_STATUS_SIZEBITS) << 7;
-              break;
-            }
+#ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
+  dev->rootdirentries = dev->rwbuffer[SMART_FMT_ROOTDIRS_POS];
 
-          readaddress += offset;
-        }
+  /* If rootdirentries is greater than 1, then we need to register
+   * additional block devices.
+   */
 
-      offset >>= 1;
-      if (offset < 256 && sectorsize == 0xffff)
+  for (x = 1; x < dev->rootdirentries; x++)
+    {
+      if (dev->partname[0] != '\0')
         {
-          /* No valid sectors found on device.  Default the
-           * sector size to the CONFIG value
-           */
+          snprintf(dev->rwbuffer, sizeof(devname), "/dev/smart%d%sd%d",
+                  dev->minor, dev->partname, x+1);
+        }
+      else
+        {
+          snprintf(devname, sizeof(devname), "/dev/smart%dd%d", dev->minor,
+                   x + 1);
+        }
 
-          sectorsize = CONFIG_MTD_SMART_SECTOR_SIZE;
+      /* Inode private data is a reference to a struct containing
+       * the SMART device structure and the root directory number.
+       */
+
+      rootdirdev = (struct smart_multiroot_device_s *)
+        smart_malloc(dev, sizeof(*rootdirdev), "Root Dir");
+      if (rootdirdev == NULL)
+        {
+          ferr("ERROR: Memory alloc failed\n");
+          return -ENOMEM;
         }
+
+      /* Populate the rootdirdev */
+
+      rootdirdev->dev = dev;
+      rootdirdev->rootdirnum = x;
+      ret = register_blockdriver(dev->rwbuffer, &g_bops, 0, rootdirdev);
+
+      /* Inode private data is a reference to the SMART device structure */
+
+      ret = register_blockdriver(devname, &g_bops, 0, rootdirdev);
     }
+#endif
 
-  /* Now set the sectorsize and other sectorsize derived variables */
+  return OK;
+}
 
-  ret = smart_setsectorsize(dev, sectorsize);
-  if (ret != OK)
+/****************************************************************************
+ * Name: smart_scan_sector
+ *
+ * Description: Reads the header of one physical sector and accounts for it
+ *              in the logical sector map and the free and release counts of
+ *              its erase block.  Duplicate logical sectors are resolved
+ *              using the sequence number.
+ *
+ ****************************************************************************/
+
+static int smart_scan_sector(FAR struct smart_struct_s *dev, uint16_t sector)
+{
+  int       ret;
+  uint16_t  logicalsector;
+  uint16_t  loser;
+  uint32_t  readaddress;
+  uint32_t  offset;
+  uint16_t  seq1;
+  uint16_t  seq2;
+  struct    smart_sect_header_s header;
+#ifdef CONFIG_MTD_SMART_MINIMIZE_RAM
+  int       dupsector;
+  uint16_t  duplogsector;
+#endif
+
+  finfo("Scan sector %d\n", sector);
+
+  /* Calculate the read address for this sector */
+
+  readaddress = sector * dev->mtdBlksPerSector * dev->geo.blocksize;
+
+  /* Read the header for this sector */
+
+  ret = MTD_READ(dev->mtd, readaddress, sizeof(struct smart_sect_header_s),
+                 (FAR uint8_t *) &header);
+  if (ret != sizeof(struct smart_sect_header_s))
     {
-      goto err_out;
+      return -EIO;
     }
 
-  /* Initialize the device variables */
+  /* Get the logical sector number for this physical sector */
 
-  totalsectors = dev->totalsectors;
-  dev->formatstatus = SMART_FMT_STAT_NOFMT;
-  dev->freesectors = dev->availSectPerBlk * dev->geo.neraseblocks;
-  dev->releasesectors = 0;
+  logicalsector = *((FAR uint16_t *) header.logicalsector);
+#if CONFIG_SMARTFS_ERASEDSTATE == 0x00
+  if (logicalsector == 0)
+    {
+      logicalsector = -1;
+    }
+#endif
 
-  /* Initialize the freecount and releasecount arrays */
+  /* Test if this sector has been committed */
 
-  for (sector = 0; sector < dev->neraseblocks; sector++)
+  if ((header.status & SMART_STATUS_COMMITTED) ==
+          (CONFIG_SMARTFS_ERASEDSTATE & SMART_STATUS_COMMITTED))
     {
-      if (sector == dev->neraseblocks - 1 && dev->totalsectors == 65534)
-        {
-          prerelease = 2;
-        }
-      else
-        {
-          prerelease = 0;
-        }
+      return OK;
+    }
+
+  /* This block is commited, therefore not free.  Update the
+   * erase block's freecount.
+   */
 
 #ifdef CONFIG_MTD_SMART_PACK_COUNTS
-      smart_set_count(dev, dev->freecount, sector, dev->availSectPerBlk - prerelease);
-      smart_set_count(dev, dev->releasecount, sector, prerelease);
+  smart_add_count(dev, dev->freecount, sector / dev->sectorsPerBlk, -1);
 #else
-      dev->freecount[sector] = dev->availSectPerBlk - prerelease;
-      dev->releasecount[sector] = prerelease;
+  dev->freecount[sector / dev->sectorsPerBlk]--;
 #endif
-    }
+  dev->freesectors--;
 
-  /* Initialize the sector map */
+  /* Test if this sector has been release and if it has,
+   * update the erase block's releasecount.
+   */
 
-#ifndef CONFIG_MTD_SMART_MINIMIZE_RAM
-  for (sector = 0; sector < totalsectors; sector++)
+  if ((header.status & SMART_STATUS_RELEASED) !=
+          (CONFIG_SMARTFS_ERASEDSTATE & SMART_STATUS_RELEASED))
     {
-      dev->sMap[sector] = -1;
-    }
-#else
-  /* Clear all logical sector used bits */
+      /* Keep track of the total number of released sectors and
+       * released sectors per erase block.
+       */
 
-  memset(dev->sBitMap, 0, (dev->totalsectors + 7) >> 3);
+      dev->releasesectors++;
+#ifdef CONFIG_MTD_SMART_PACK_COUNTS
+      smart_add_count(dev, dev->releasecount, sector / dev->sectorsPerBlk, 1);
+#else
+      dev->releasecount[sector / dev->sectorsPerBlk]++;
 #endif
+      return OK;
+    }
 
-  /* Now scan the MTD device */
-
-  for (sector = 0; sector < totalsectors; sector++)
+  if ((header.status & SMART_STATUS_VERBITS) != SMART_STATUS_VERSION)
     {
-      finfo("Scan sector %d\n", sector);
-
-      /* Calculate the read address for this sector */
+      return OK;
+    }
 
-      readaddress = sector * dev->mtdBlksPerSector * dev->geo.blocksize;
+  /* Validate the logical sector number is in bounds */
 
-      /* Read the header for this sector */
+  if (logicalsector >= dev->totalsectors)
+    {
+      /* Error in logical sector read from the MTD device */
 
-      ret = MTD_READ(dev->mtd, readaddress, sizeof(struct smart_sect_header_s),
-                     (FAR uint8_t *) &header);
-      if (ret != sizeof(struct smart_sect_header_s))
-        {
-          goto err_out;
-        }
+      ferr("ERROR: Invalid logical sector %d at physical %d.\n",
+           logicalsector, sector);
+      return OK;
+    }
 
-      /* Get the logical sector number for this physical sector */
+  /* If this is logical sector zero, then read in the signature
+   * information to validate the format signature.
+   */
 
-      logicalsector = *((FAR uint16_t *) header.logicalsector);
-#if CONFIG_SMARTFS_ERASEDSTATE == 0x00
-      if (logicalsector == 0)
+  if (logicalsector == 0)
+    {
+      ret = smart_scan_format(dev, readaddress);
+      if (ret == -EINVAL)
         {
-          logicalsector = -1;
-        }
-#endif
-
-      /* Test if this sector has been committed */
+          /* Invalid signature on a sector claiming to be sector 0!
+           * What should we do?  Release it?
+           */
 
-      if ((header.status & SMART_STATUS_COMMITTED) ==
-              (CONFIG_SMARTFS_ERASEDSTATE & SMART_STATUS_COMMITTED))
+          return OK;
+        }
+      else if (ret < 0)
         {
-          continue;
+          return ret;
         }
+    }
 
-      /* This block is commited, therefore not free.  Update the
-       * erase block's freecount.
-       */
+  /* Test for duplicate logical sectors on the device */
 
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
-      smart_add_count(dev, dev->freecount, sector / dev->sectorsPerBlk, -1);
+#ifndef CONFIG_MTD_SMART_MINIMIZE_RAM
+  if (dev->sMap[logicalsector] != 0xffff)
 #else
-      dev->freecount[sector / dev->sectorsPerBlk]--;
+  if (dev->sBitMap[logicalsector >> 3] & (1 << (logicalsector & 0x07)))
 #endif
-      dev->freesectors--;
-
-      /* Test if this sector has been release and if it has,
-       * update the erase block's releasecount.
+    {
+      /* Uh-oh, we found more than 1 physical sector claiming to be
+       * the same logical sector.  Use the sequence number information
+       * to resolve who wins.
        */
 
-      if ((header.status & SMART_STATUS_RELEASED) !=
-              (CONFIG_SMARTFS_ERASEDSTATE & SMART_STATUS_RELEASED))
+#if SMART_STATUS_VERSION == 1
+      if (header.status & SMART_STATUS_CRC)
         {
-          /* Keep track of the total number of released sectors and
-           * released sectors per erase block.
-           */
-
-          dev->releasesectors++;
-#ifdef CONFIG_MTD_SMART_PACK_COUNTS
-          smart_add_count(dev, dev->releasecount, sector / dev->sectorsPerBlk, 1);
-#else
-          dev->releasecount[sector / dev->sectorsPerBlk]++;
-#endif
-          continue;
+          seq2 = header.seq;
         }
-
-      if ((header.status & SMART_STATUS_VERBITS) != SMART_STATUS_VERSION)
+      else
         {
-          continue;
+          seq2 = *((FAR uint16_t *) &header.seq);
         }
+#else
+      seq2 = header.seq;
+#endif
 
-      /* Validate the logical sector number is in bounds */
-
-      if (logicalsector >= totalsectors)
-        {
-          /* Error in logical sector read from the MTD device */
-
-          ferr("ERROR: Invalid logical sector %d at physical %d.\n",
-               logicalsector, sector);
-          continue;
-        }
+      /* We must re-read the 1st physical sector to get it's seq number */
 
-      /* If this is logical sector zero, then read in the signature
-       * information to validate the format signature.
+#ifndef CONFIG_MTD_SMART_MINIMIZE_RAM
+      readaddress = dev->sMap[logicalsector]  * dev->mtdBlksPerSector * dev->geo.blocksize;
+#else
+      /* For minimize RAM, we have to rescan to find the 1st sector claiming to
+       * be this logical sector.
        */
 
-      if (logicalsector == 0)
+      for (dupsector = 0; dupsector < sector; dupsector++)
         {
-          /* Read the sector data */
+          /* Calculate the read address for this sector */
+
+          readaddress = dupsector * dev->mtdBlksPerSector * dev->geo.blocksize;
 
-          ret = MTD_READ(dev->mtd, readaddress, 32,
-                         (FAR uint8_t *)dev->rwbuffer);
-          if (ret != 32)
+          /* Read the header for this sector */
+
+          ret = MTD_READ(dev->mtd, readaddress, sizeof(struct smart_sect_header_s),
+                         (FAR uint8_t *) &header);
+          if (ret != sizeof(struct smart_sect_header_s))
             {
-              ferr("ERROR: Error reading physical sector %d.\n", sector);
-              goto err_out;
+              return -EIO;
             }
 
-          /* Validate the format signature */
+          /* Get the logical sector number for this physical sector */
 
-          if (dev->rwbuffer[SMART_FMT_POS1] != SMART_FMT_SIG1 ||
-              dev->rwbuffer[SMART_FMT_POS2] != SMART_FMT_SIG2 ||
-              dev->rwbuffer[SMART_FMT_POS3] != SMART_FMT_SIG3 ||
-              dev->rwbuffer[SMART_FMT_POS4] != SMART_FMT_SIG4)
-            {
-              /* Invalid signature on a sector claiming to be sector 0!
-               * What should we do?  Release it?
-               */
+          duplogsector = *((FAR uint16_t *) header.logicalsector);
+
+#if CONFIG_SMARTFS_ERASEDSTATE == 0x00
+          if (duplogsector == 0)
+            {
+              duplogsector = -1;
+            }
+#endif
+
+          /* Test if this sector has been committed */
 
+          if ((header.status & SMART_STATUS_COMMITTED) ==
+                  (CONFIG_SMARTFS_ERASEDSTATE & SMART_STATUS_COMMITTED))
+            {
               continue;
             }
 
-          /* Mark the volume as formatted and set the sector size */
+          /* Test if this sector has been release and skip it if it has */
 
-          dev->formatstatus = SMART_FMT_STAT_FORMATTED;
-          dev->namesize = dev->rwbuffer[SMART_FMT_NAMESIZE_POS];
-          dev->formatversion = dev->rwbuffer[SMART_FMT_VERSION_POS];
+          if ((header.status & SMART_STATUS_RELEASED) !=
+                  (CONFIG_SMARTFS_ERASEDSTATE & SMART_STATUS_RELEASED))
+            {
+              continue;
+            }
 
-#ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
-          dev->rootdirentries = dev->rwbuffer[SMART_FMT_ROOTDIRS_POS];
+          if ((header.status & SMART_STATUS_VERBITS) != SMART_STATUS_VERSION)
+            {
+              continue;
+            }
 
-          /* If rootdirentries is greater than 1, then we need to register
-           * additional block devices.
-           */
+          /* Now compare if this logical sector matches the current sector */
 
-          for (x = 1; x < dev->rootdirentries; x++)
+          if (duplogsector == logicalsector)
             {
-              if (dev->partname[0] != '\0')
-                {
-                  snprintf(dev->rwbuffer, sizeof(devname), "/dev/smart%d%sd%d",
-                          dev->minor, dev->partname, x+1);
-                }
-              else
-                {
-                  snprintf(devname, sizeof(devname), "/dev/smart%dd%d", dev->minor,
-                           x + 1);
-                }
+              break;
+            }
+        }
+#endif
 
-              /* Inode private data is a reference to a struct containing
-               * the SMART device structure and the root directory number.
-               */
+      ret = MTD_READ(dev->mtd, readaddress, sizeof(struct smart_sect_header_s),
+              (FAR uint8_t *) &header);
+      if (ret != sizeof(struct smart_sect_header_s))
+        {
+          return -EIO;
+        }
 
-              rootdirdev = (struct smart_multiroot_device_s *)
-                smart_malloc(dev, sizeof(*rootdirdev), "Root Dir");
-              if (rootdirdev == NULL)
-                {
-                  ferr("ERROR: Memory alloc failed\n");
-                  ret = -ENOMEM;
-                  goto err_out;
-                }
+#if SMART_STATUS_VERSION == 1
+      if (header.status & SMART_STATUS_CRC)
+        {
+          seq1 = header.seq;
+        }
+      else
+        {
+          seq1 = *((FAR uint16_t *) &header.seq);
+        }
+#else
+      seq1 = header.seq;
+#endif
+
+      /* Now determine who wins */
+
+      if ((seq1 > 0xfff0 && seq2 < 10) || seq2 > seq1)
+        {
+          /* Seq 2 is the winner ... bigger or it wrapped */
+
+#ifndef CONFIG_MTD_SMART_MINIMIZE_RAM
+          loser = dev->sMap[logicalsector];
+          dev->sMap[logicalsector] = sector;
+#else
+          loser = dupsector;
+#endif
+        }
+      else
+        {
+          /* We keep the original mapping and seq2 is the loser */
+
+          loser = sector;
+        }
+
+      /* Now release the loser sector */
+
+      readaddress = loser  * dev->mtdBlksPerSector * dev->geo.blocksize;
+      ret = MTD_READ(dev->mtd, readaddress, sizeof(struct smart_sect_header_s),
+              (FAR uint8_t *) &header);
+      if (ret != sizeof(struct smart_sect_header_s))
+        {
+          return -EIO;
+        }
+
+#if CONFIG_SMARTFS_ERASEDSTATE == 0xff
+      header.status &= ~SMART_STATUS_RELEASED;
+#else
+      header.status |= SMART_STATUS_RELEASED;
+#endif
+      offset = readaddress + offsetof(struct smart_sect_header_s, status);
+      ret = smart_bytewrite(dev, offset, 1, &header.status);
+      if (ret < 0)
+        {
+          ferr("ERROR: Error %d releasing duplicate sector\n", -ret);
+          return ret;
+        }
+
+      dev->releasesectors++;
+#ifdef CONFIG_MTD_SMART_PACK_COUNTS
+      smart_add_count(dev, dev->releasecount, loser / dev->sectorsPerBlk, 1);
+#else
+      dev->releasecount[loser / dev->sectorsPerBlk]++;
+#endif
+
+      /* If this sector lost, then the original mapping stands */
+
+      if (loser == sector)
+        {
+          return OK;
+        }
+    }
+
+#ifndef CONFIG_MTD_SMART_MINIMIZE_RAM
+  /* Update the logical to physical sector map */
+
+  dev->sMap[logicalsector] = sector;
+#else
+  /* Mark the logical sector as used in the bitmap */
+
+  dev->sBitMap[logicalsector >> 3] |= 1 << (logicalsector & 0x07);
+
+  if (logicalsector < SMART_FIRST_ALLOC_SECTOR)
+    {
+      smart_add_sector_to_cache(dev, logicalsector, sector, __LINE__);
+    }
+#endif
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: smart_checkpoint_blocks
+ *
+ * Description: Returns the number of erase blocks needed for one copy of
+ *              the checkpoint, or zero if the device is too small to spare
+ *              them.  The size is computed for the whole MTD device so that
+ *              it does not depend on the number of erase blocks reserved.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+static uint16_t smart_checkpoint_blocks(FAR struct smart_struct_s *dev)
+{
+  uint32_t  totalsectors;
+  uint32_t  nmtdblocks;
+  uint32_t  nblocks;
+
+  totalsectors = (uint32_t)dev->mtdneraseblocks * dev->sectorsPerBlk;
+  if (totalsectors > 65536)
+    {
+      totalsectors = 65536;
+    }
+
+  /* The header, the map and counts, and the bit map of modified erase
+   * blocks each begin on an MTD block boundary.
+   */
+
+  nmtdblocks = 1 +
+    SMART_NBLOCKS(totalsectors * sizeof(uint16_t) + 2 * dev->mtdneraseblocks,
+                  dev->geo.blocksize) +
+    SMART_NBLOCKS((dev->mtdneraseblocks + 7) >> 3, dev->geo.blocksize);
+  nblocks = SMART_NBLOCKS(nmtdblocks * dev->geo.blocksize,
+                          dev->geo.erasesize);
+
+  /* Don't give more than an eighth of the device to the checkpoint */
+
+  if (2 * nblocks > (dev->mtdneraseblocks >> 3))
+    {
+      return 0;
+    }
+
+  return (uint16_t)nblocks;
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_checkpoint_datasize
+ *
+ * Description: Returns the size of the logical sector map and the release
+ *              and free counts.  These are allocated contiguously.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+static inline uint32_t smart_checkpoint_datasize(FAR struct smart_struct_s *dev)
+{
+  return (uint32_t)dev->totalsectors * sizeof(uint16_t) +
+         2 * dev->neraseblocks;
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_checkpoint_start
+ *
+ * Description: Returns the first MTD block of a copy of the checkpoint.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+static inline off_t smart_checkpoint_start(FAR struct smart_struct_s *dev,
+                                           uint8_t copy)
+{
+  return (off_t)(dev->geo.neraseblocks + copy * dev->cpblocks) *
+         (dev->geo.erasesize / dev->geo.blocksize);
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_checkpoint_mapaddr
+ *
+ * Description: Returns the byte address of the bit map of modified erase
+ *              blocks in a copy of the checkpoint.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+static inline uint32_t smart_checkpoint_mapaddr(FAR struct smart_struct_s *dev,
+                                                uint8_t copy)
+{
+  return (smart_checkpoint_start(dev, copy) + 1 +
+          SMART_NBLOCKS(smart_checkpoint_datasize(dev), dev->geo.blocksize)) *
+         dev->geo.blocksize;
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_checkpoint_bytewrite
+ *
+ * Description: Programs one byte of the checkpoint area.  Like
+ *              smart_bytewrite() but uses the checkpoint buffer so that the
+ *              sector data in rwbuffer is preserved.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+static int smart_checkpoint_bytewrite(FAR struct smart_struct_s *dev,
+                                      uint32_t offset, uint8_t value)
+{
+  off_t     block;
+  ssize_t   ret;
+
+#ifdef CONFIG_MTD_BYTE_WRITE
+  if (dev->mtd->write != NULL)
+    {
+      ret = dev->mtd->write(dev->mtd, offset, 1, &value);
+      return ret == 1 ? OK : -EIO;
+    }
+#endif
+
+  block = offset / dev->geo.blocksize;
+  ret   = MTD_BREAD(dev->mtd, block, 1, dev->cpbuffer);
+  if (ret == 1)
+    {
+      dev->cpbuffer[offset - block * dev->geo.blocksize] = value;
+      ret = MTD_BWRITE(dev->mtd, block, 1, dev->cpbuffer);
+    }
+
+  return ret == 1 ? OK : -EIO;
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_checkpoint_touch
+ *
+ * Description: Called before an erase block is programmed or erased.  The
+ *              first time a block is modified after the checkpoint was
+ *              written, its bit is programmed in the bit map of the current
+ *              copy so that a mount will scan the block again.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+static void smart_checkpoint_touch(FAR struct smart_struct_s *dev,
+                                   uint16_t block)
+{
+  uint8_t   bit = 1 << (block & 0x07);
+  uint32_t  offset;
+  int       ret;
+
+  if (!dev->cpvalid || block >= dev->neraseblocks ||
+      (dev->cpdirty[block >> 3] & bit) != 0)
+    {
+      return;
+    }
+
+  dev->cpdirty[block >> 3] |= bit;
+  dev->cpndirty++;
 
-              /* Populate the rootdirdev */
+  offset = smart_checkpoint_mapaddr(dev, dev->cpcopy) + (block >> 3);
+  ret = smart_checkpoint_bytewrite(dev, offset, CONFIG_SMARTFS_ERASEDSTATE ^
+                                   dev->cpdirty[block >> 3]);
+  if (ret < 0)
+    {
+      /* The checkpoint no longer describes the device.  Invalidate it so
+       * that the next mount scans the whole device.
+       */
+
+      ferr("ERROR: Error %d updating checkpoint\n", -ret);
+
+      offset = smart_checkpoint_start(dev, dev->cpcopy) * dev->geo.blocksize;
+      (void)smart_checkpoint_bytewrite(dev, offset,
+                                       (uint8_t)~CONFIG_SMARTFS_ERASEDSTATE);
+      dev->cpvalid = false;
+    }
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_checkpoint_write
+ *
+ * Description: Writes the logical sector map and the release and free
+ *              counts to the copy of the checkpoint not in use, then makes
+ *              it the current copy with no modified erase blocks.  This must
+ *              only be called when the map and counts in RAM match the
+ *              device, i.e. between block driver operations.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+static int smart_checkpoint_write(FAR struct smart_struct_s *dev)
+{
+  FAR struct smart_cphdr_s *header;
+  uint32_t  datasize;
+  uint32_t  blocksize;
+  size_t    nblocks;
+  size_t    remaining;
+  ssize_t   nxfrd;
+  off_t     start;
+  uint8_t   copy;
+  int       ret;
+#ifdef CONFIG_MTD_SMART_ENABLE_CRC
+  FAR struct smart_allocsector_s *allocsector;
+  FAR struct smart_allocsector_s *other;
+  uint16_t  block;
+  uint8_t   bits;
+#endif
+
+  if (dev->cpblocks == 0)
+    {
+      return -ENOSYS;
+    }
+
+  /* Erase the copy that does not hold the current checkpoint */
+
+  copy      = dev->cpcopy ^ 1;
+  start     = smart_checkpoint_start(dev, copy);
+  blocksize = dev->geo.blocksize;
+  datasize  = smart_checkpoint_datasize(dev);
+
+  ret = MTD_ERASE(dev->mtd, dev->geo.neraseblocks + copy * dev->cpblocks,
+                  dev->cpblocks);
+  if (ret < 0)
+    {
+      ferr("ERROR: Error %d erasing checkpoint\n", -ret);
+      return ret;
+    }
+
+  /* Write the map and the counts after the header block */
+
+  nblocks = datasize / blocksize;
+  if (nblocks > 0)
+    {
+      nxfrd = MTD_BWRITE(dev->mtd, start + 1, nblocks,
+                         (FAR const uint8_t *)dev->sMap);
+      if (nxfrd != nblocks)
+        {
+          goto errout;
+        }
+    }
+
+  remaining = datasize - nblocks * blocksize;
+  if (remaining > 0)
+    {
+      memset(dev->cpbuffer, CONFIG_SMARTFS_ERASEDSTATE, blocksize);
+      memcpy(dev->cpbuffer, (FAR uint8_t *)dev->sMap + nblocks * blocksize,
+             remaining);
+      nxfrd = MTD_BWRITE(dev->mtd, start + 1 + nblocks, 1, dev->cpbuffer);
+      if (nxfrd != 1)
+        {
+          goto errout;
+        }
+    }
+
+#ifdef CONFIG_MTD_SMART_ENABLE_CRC
+  /* Sectors that are allocated but not yet written are not on the device.
+   * Mark their erase blocks as modified in the new copy so that a mount
+   * scans them.
+   */
+
+  for (allocsector = dev->allocsector; allocsector != NULL;
+       allocsector = allocsector->next)
+    {
+      block = allocsector->physical / dev->sectorsPerBlk;
+      bits  = 0;
+
+      for (other = dev->allocsector; other != NULL; other = other->next)
+        {
+          if ((other->physical / dev->sectorsPerBlk) >> 3 == block >> 3)
+            {
+              bits |= 1 << ((other->physical / dev->sectorsPerBlk) & 0x07);
+            }
+        }
+
+      ret = smart_checkpoint_bytewrite(dev,
+                                       smart_checkpoint_mapaddr(dev, copy) +
+                                       (block >> 3),
+                                       CONFIG_SMARTFS_ERASEDSTATE ^ bits);
+      if (ret < 0)
+        {
+          goto errout;
+        }
+    }
+#endif
+
+  /* Write the header last.  The new copy is not valid until it is written. */
+
+  memset(dev->cpbuffer, CONFIG_SMARTFS_ERASEDSTATE, blocksize);
+  header = (FAR struct smart_cphdr_s *)dev->cpbuffer;
+  header->signature[0] = SMART_CP_SIG1;
+  header->signature[1] = SMART_CP_SIG2;
+  header->signature[2] = SMART_CP_SIG3;
+  header->signature[3] = SMART_CP_SIG4;
+  header->seq          = dev->cpseq + 1;
+  header->sectorsize   = dev->sectorsize;
+  header->totalsectors = dev->totalsectors;
+  header->neraseblocks = dev->neraseblocks;
+  header->reserved     = 0;
+  header->datacrc      = crc32((FAR const uint8_t *)dev->sMap, datasize);
+  header->crc          = crc32(dev->cpbuffer,
+                               offsetof(struct smart_cphdr_s, crc));
+
+  nxfrd = MTD_BWRITE(dev->mtd, start, 1, dev->cpbuffer);
+  if (nxfrd != 1)
+    {
+      goto errout;
+    }
+
+  /* Invalidate the previous copy so that it cannot be used if the new one
+   * is invalidated later.
+   */
+
+  (void)smart_checkpoint_bytewrite(dev,
+          smart_checkpoint_start(dev, dev->cpcopy) * blocksize,
+          (uint8_t)~CONFIG_SMARTFS_ERASEDSTATE);
+
+  dev->cpcopy   = copy;
+  dev->cpseq++;
+  dev->cpvalid  = true;
+  dev->cpndirty = 0;
+  memset(dev->cpdirty, 0, (dev->neraseblocks + 7) >> 3);
+
+#ifdef CONFIG_MTD_SMART_ENABLE_CRC
+  for (allocsector = dev->allocsector; allocsector != NULL;
+       allocsector = allocsector->next)
+    {
+      block = allocsector->physical / dev->sectorsPerBlk;
+      if (!SMART_CP_ISDIRTY(dev, block))
+        {
+          dev->cpdirty[block >> 3] |= 1 << (block & 0x07);
+          dev->cpndirty++;
+        }
+    }
+#endif
+
+  return OK;
+
+errout:
+  ferr("ERROR: Error writing checkpoint\n");
+  return -EIO;
+}
+#endif
+
+/****************************************************************************
+ * Name: smart_checkpoint_restore
+ *
+ * Description: Restores the logical sector map and the release and free
+ *              counts from the newest valid copy of the checkpoint, then
+ *              scans only the erase blocks modified after it was written.
+ *
+ * Returned Value:
+ *   OK on success.  A negated errno value if there is no usable checkpoint
+ *   and the device must be scanned.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+static int smart_checkpoint_restore(FAR struct smart_struct_s *dev)
+{
+  struct    smart_cphdr_s header[2];
+  bool      valid[2];
+  uint32_t  datasize;
+  uint16_t  nbytes;
+  uint16_t  block;
+  uint16_t  sector;
+  uint16_t  prerelease;
+  uint8_t   copy;
+  ssize_t   nread;
+  int       ret;
+  int       x;
+
+  dev->cpvalid  = false;
+  dev->cpndirty = 0;
+
+  if (dev->cpblocks == 0)
+    {
+      return -ENOENT;
+    }
+
+  datasize = smart_checkpoint_datasize(dev);
+  nbytes   = (dev->neraseblocks + 7) >> 3;
+
+  /* Read and validate the header of each copy */
+
+  for (copy = 0; copy < 2; copy++)
+    {
+      nread = MTD_READ(dev->mtd,
+                       smart_checkpoint_start(dev, copy) * dev->geo.blocksize,
+                       sizeof(struct smart_cphdr_s),
+                       (FAR uint8_t *)&header[copy]);
+
+      valid[copy] =
+        nread == sizeof(struct smart_cphdr_s) &&
+        header[copy].signature[0] == SMART_CP_SIG1 &&
+        header[copy].signature[1] == SMART_CP_SIG2 &&
+        header[copy].signature[2] == SMART_CP_SIG3 &&
+        header[copy].signature[3] == SMART_CP_SIG4 &&
+        header[copy].crc == crc32((FAR const uint8_t *)&header[copy],
+                                  offsetof(struct smart_cphdr_s, crc)) &&
+        header[copy].sectorsize == dev->sectorsize &&
+        header[copy].totalsectors == dev->totalsectors &&
+        header[copy].neraseblocks == dev->neraseblocks;
+    }
+
+  /* Load the map and counts from the newest copy whose data is intact */
+
+  copy = (valid[1] && (!valid[0] ||
+          (int32_t)(header[1].seq - header[0].seq) > 0)) ? 1 : 0;
+
+  for (x = 0; x < 2; x++, copy ^= 1)
+    {
+      if (!valid[copy])
+        {
+          continue;
+        }
+
+      nread = MTD_READ(dev->mtd,
+                       (smart_checkpoint_start(dev, copy) + 1) *
+                       dev->geo.blocksize, datasize,
+                       (FAR uint8_t *)dev->sMap);
+      if (nread == datasize &&
+          crc32((FAR const uint8_t *)dev->sMap, datasize) ==
+          header[copy].datacrc)
+        {
+          break;
+        }
+    }
+
+  if (x == 2)
+    {
+      return -ENOENT;
+    }
+
+  /* Read the bit map of erase blocks modified since */
+
+  nread = MTD_READ(dev->mtd, smart_checkpoint_mapaddr(dev, copy), nbytes,
+                   dev->cpdirty);
+  if (nread != nbytes)
+    {
+      return -EIO;
+    }
+
+  for (x = 0; x < nbytes; x++)
+    {
+      dev->cpdirty[x] ^= CONFIG_SMARTFS_ERASEDSTATE;
+    }
+
+  for (block = 0; block < dev->neraseblocks; block++)
+    {
+      if (SMART_CP_ISDIRTY(dev, block))
+        {
+          dev->cpndirty++;
+        }
+    }
 
-              rootdirdev->dev = dev;
-              rootdirdev->rootdirnum = x;
-              ret = register_blockdriver(dev->rwbuffer, &g_bops, 0, rootdirdev);
+  dev->cpcopy  = copy;
+  dev->cpseq   = header[copy].seq;
+  dev->cpvalid = true;
 
-              /* Inode private data is a reference to the SMART device structure */
+  if (dev->cpndirty > 0)
+    {
+      /* Forget what the checkpoint recorded for the modified erase blocks */
 
-              ret = register_blockdriver(devname, &g_bops, 0, rootdirdev);
+      for (sector = 0; sector < dev->totalsectors; sector++)
+        {
+          if (dev->sMap[sector] != 0xffff &&
+              SMART_CP_ISDIRTY(dev, dev->sMap[sector] / dev->sectorsPerBlk))
+            {
+              dev->sMap[sector] = 0xffff;
             }
-#endif
         }
 
-      /* Test for duplicate logical sectors on the device */
-
-#ifndef CONFIG_MTD_SMART_MINIMIZE_RAM
-      if (dev->sMap[logicalsector] != 0xffff)
-#else
-      if (dev->sBitMap[logicalsector >> 3] & (1 << (logicalsector & 0x07)))
-#endif
+      for (block = 0; block < dev->neraseblocks; block++)
         {
-          /* Uh-oh, we found more than 1 physical sector claiming to be
-           * the same logical sector.  Use the sequence number information
-           * to resolve who wins.
-           */
+          if (!SMART_CP_ISDIRTY(dev, block))
+            {
+              continue;
+            }
 
-#if SMART_STATUS_VERSION == 1
-          if (header.status & SMART_STATUS_CRC)
+          if (block == dev->neraseblocks - 1 && dev->totalsectors == 65534)
             {
-              seq2 = header.seq;
+              prerelease = 2;
             }
           else
             {
-              seq2 = *((FAR uint16_t *) &header.seq);
+              prerelease = 0;
             }
+
+#ifdef CONFIG_MTD_SMART_PACK_COUNTS
+          smart_set_count(dev, dev->freecount, block,
+                          dev->availSectPerBlk - prerelease);
+          smart_set_count(dev, dev->releasecount, block, prerelease);
 #else
-          seq2 = header.seq;
+          dev->freecount[block] = dev->availSectPerBlk - prerelease;
+          dev->releasecount[block] = prerelease;
 #endif
+        }
 
-          /* We must re-read the 1st physical sector to get it's seq number */
+      /* Then scan them */
 
-#ifndef CONFIG_MTD_SMART_MINIMIZE_RAM
-          readaddress = dev->sMap[logicalsector]  * dev->mtdBlksPerSector * dev->geo.blocksize;
-#else
-          /* For minimize RAM, we have to rescan to find the 1st sector claiming to
-           * be this logical sector.
-           */
+      for (block = 0; block < dev->neraseblocks; block++)
+        {
+          if (!SMART_CP_ISDIRTY(dev, block))
+            {
+              continue;
+            }
 
-          for (dupsector = 0; dupsector < sector; dupsector++)
+          for (sector = block * dev->sectorsPerBlk;
+               sector < (block + 1) * dev->sectorsPerBlk &&
+               sector < dev->totalsectors; sector++)
             {
-              /* Calculate the read address for this sector */
+              ret = smart_scan_sector(dev, sector);
+              if (ret < 0)
+                {
+                  dev->cpvalid = false;
+                  return ret;
+                }
+            }
+        }
+    }
 
-              readaddress = dupsector * dev->mtdBlksPerSector * dev->geo.blocksize;
+  /* Recompute the totals from the counts of each erase block */
 
-              /* Read the header for this sector */
+  dev->freesectors = 0;
+  dev->releasesectors = 0;
 
-              ret = MTD_READ(dev->mtd, readaddress, sizeof(struct smart_sect_header_s),
-                             (FAR uint8_t *) &header);
-              if (ret != sizeof(struct smart_sect_header_s))
-                {
-                  goto err_out;
-                }
+  for (block = 0; block < dev->neraseblocks; block++)
+    {
+      if (block == dev->neraseblocks - 1 && dev->totalsectors == 65534)
+        {
+          prerelease = 2;
+        }
+      else
+        {
+          prerelease = 0;
+        }
 
-              /* Get the logical sector number for this physical sector */
+#ifdef CONFIG_MTD_SMART_PACK_COUNTS
+      dev->freesectors += smart_get_count(dev, dev->freecount, block) +
+                          prerelease;
+      dev->releasesectors += smart_get_count(dev, dev->releasecount, block) -
+                             prerelease;
+#else
+      dev->freesectors += dev->freecount[block] + prerelease;
+      dev->releasesectors += dev->releasecount[block] - prerelease;
+#endif
+    }
 
-              duplogsector = *((FAR uint16_t *) header.logicalsector);
+  /* Read the format information unless logical sector zero was scanned */
 
-#if CONFIG_SMARTFS_ERASEDSTATE == 0x00
-              if (duplogsector == 0)
-                {
-                  duplogsector = -1;
-                }
+  if (dev->formatstatus != SMART_FMT_STAT_FORMATTED && dev->sMap[0] != 0xffff)
+    {
+      ret = smart_scan_format(dev, (uint32_t)dev->sMap[0] *
+                              dev->mtdBlksPerSector * dev->geo.blocksize);
+      if (ret < 0)
+        {
+          dev->cpvalid = false;
+          return ret;
+        }
+    }
+
+  return OK;
+}
 #endif
 
-              /* Test if this sector has been committed */
+/****************************************************************************
+ * Name: smart_scan
+ *
+ * Description: Performs a scan of the MTD device searching for format
+ *              information and fills in logical sector mapping, freesector
+ *              count, etc.
+ *
+ ****************************************************************************/
 
-              if ((header.status & SMART_STATUS_COMMITTED) ==
-                      (CONFIG_SMARTFS_ERASEDSTATE & SMART_STATUS_COMMITTED))
-                {
-                  continue;
-                }
+static int smart_scan(FAR struct smart_struct_s *dev)
+{
+  int       sector;
+  int       ret;
+  uint16_t  totalsectors;
+  uint16_t  sectorsize, prerelease;
+  uint32_t  readaddress;
+  uint32_t  offset;
+  struct    smart_sect_header_s header;
 
-              /* Test if this sector has been release and skip it if it has */
+  finfo("Entry\n");
 
-              if ((header.status & SMART_STATUS_RELEASED) !=
-                      (CONFIG_SMARTFS_ERASEDSTATE & SMART_STATUS_RELEASED))
-                {
-                  continue;
-                }
+  /* Find the sector size on the volume by reading headers from
+   * sectors of decreasing size.  On a formatted volume, the sector
+   * size is saved in the header status byte of seach sector, so
+   * by starting with the largest supported sector size and
+   * decreasing from there, we will be sure to find data that is
+   * a header and not sector data.
+   */
 
-              if ((header.status & SMART_STATUS_VERBITS) != SMART_STATUS_VERSION)
-                {
-                  continue;
-                }
+  sectorsize = 0xffff;
+  offset = 16384;
 
-              /* Now compare if this logical sector matches the current sector */
+  while (sectorsize == 0xffff)
+    {
+      readaddress = 0;
 
-              if (duplogsector == logicalsector)
-                {
-                  break;
-                }
-            }
-#endif
+      while (readaddress < dev->erasesize * dev->geo.neraseblocks)
+        {
+          /* Read the next sector from the device */
 
-          ret = MTD_READ(dev->mtd, readaddress, sizeof(struct smart_sect_header_s),
-                  (FAR uint8_t *) &header);
+          ret = MTD_READ(dev->mtd, 0, sizeof(struct smart_sect_header_s),
+                         (FAR uint8_t *) &header);
           if (ret != sizeof(struct smart_sect_header_s))
             {
               goto err_out;
             }
 
-#if SMART_STATUS_VERSION == 1
-          if (header.status & SMART_STATUS_CRC)
-            {
-              seq1 = header.seq;
-            }
-          else
+          if (header.status != CONFIG_SMARTFS_ERASEDSTATE)
             {
-              seq1 = *((FAR uint16_t *) &header.seq);
+              sectorsize = (header.status & SMART_STATUS_SIZEBITS) << 7;
+              break;
             }
-#else
-          seq1 = header.seq;
+
+          readaddress += offset;
+        }
+
+      offset >>= 1;
+      if (offset < 256 && sectorsize == 0xffff)
+        {
+          /* No valid sectors found on device.  Default the
+           * sector size to the CONFIG value
+           */
+
+          sectorsize = CONFIG_MTD_SMART_SECTOR_SIZE;
+        }
+    }
+
+  /* Now set the sectorsize and other sectorsize derived variables */
+
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+rescan:
 #endif
+  ret = smart_setsectorsize(dev, sectorsize);
+  if (ret != OK)
+    {
+      goto err_out;
+    }
+
+  /* Initialize the device variables */
 
-          /* Now determine who wins */
+  totalsectors = dev->totalsectors;
+  dev->formatstatus = SMART_FMT_STAT_NOFMT;
 
-          if ((seq1 > 0xfff0 && seq2 < 10) || seq2 > seq1)
-            {
-              /* Seq 2 is the winner ... bigger or it wrapped */
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+  /* Restore the map from the checkpoint if there is one.  Otherwise,
+   * fall back to scanning the whole device.
+   */
 
-#ifndef CONFIG_MTD_SMART_MINIMIZE_RAM
-              loser = dev->sMap[logicalsector];
-              dev->sMap[logicalsector] = sector;
-#else
-              loser = dupsector;
+  dev->cpformat = false;
+  if (smart_checkpoint_restore(dev) == OK)
+    {
+      goto scan_done;
+    }
+
+  dev->formatstatus = SMART_FMT_STAT_NOFMT;
+  dev->cpformat = false;
 #endif
-            }
-          else
-            {
-              /* We keep the original mapping and seq2 is the loser */
 
-              loser = sector;
-            }
+  dev->freesectors = dev->availSectPerBlk * dev->geo.neraseblocks;
+  dev->releasesectors = 0;
 
-          /* Now release the loser sector */
+  /* Initialize the freecount and releasecount arrays */
 
-          readaddress = loser  * dev->mtdBlksPerSector * dev->geo.blocksize;
-          ret = MTD_READ(dev->mtd, readaddress, sizeof(struct smart_sect_header_s),
-                  (FAR uint8_t *) &header);
-          if (ret != sizeof(struct smart_sect_header_s))
-            {
-              goto err_out;
-            }
+  for (sector = 0; sector < dev->neraseblocks; sector++)
+    {
+      if (sector == dev->neraseblocks - 1 && dev->totalsectors == 65534)
+        {
+          prerelease = 2;
+        }
+      else
+        {
+          prerelease = 0;
+        }
 
-#if CONFIG_SMARTFS_ERASEDSTATE == 0xff
-          header.status &= ~SMART_STATUS_RELEASED;
+#ifdef CONFIG_MTD_SMART_PACK_COUNTS
+      smart_set_count(dev, dev->freecount, sector, dev->availSectPerBlk - prerelease);
+      smart_set_count(dev, dev->releasecount, sector, prerelease);
 #else
-          header.status |= SMART_STATUS_RELEASED;
+      dev->freecount[sector] = dev->availSectPerBlk - prerelease;
+      dev->releasecount[sector] = prerelease;
 #endif
-          offset = readaddress + offsetof(struct smart_sect_header_s, status);
-          ret = smart_bytewrite(dev, offset, 1, &header.status);
-          if (ret < 0)
-            {
-              ferr("ERROR: Error %d releasing duplicate sector\n", -ret);
-              goto err_out;
-            }
-        }
+    }
 
-#ifndef CONFIG_MTD_SMART_MINIMIZE_RAM
-      /* Update the logical to physical sector map */
+  /* Initialize the sector map */
 
-      dev->sMap[logicalsector] = sector;
+#ifndef CONFIG_MTD_SMART_MINIMIZE_RAM
+  for (sector = 0; sector < totalsectors; sector++)
+    {
+      dev->sMap[sector] = -1;
+    }
 #else
-      /* Mark the logical sector as used in the bitmap */
+  /* Clear all logical sector used bits */
+
+  memset(dev->sBitMap, 0, (dev->totalsectors + 7) >> 3);
+#endif
 
-      dev->sBitMap[logicalsector >> 3] |= 1 << (logicalsector & 0x07);
+  /* Now scan the MTD device */
 
-      if (logicalsector < SMART_FIRST_ALLOC_SECTOR)
+  for (sector = 0; sector < totalsectors; sector++)
+    {
+      ret = smart_scan_sector(dev, sector);
+      if (ret < 0)
         {
-          smart_add_sector_to_cache(dev, logicalsector, sector, __LINE__);
+          goto err_out;
         }
-#endif
     }
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+  /* A volume formatted without the checkpoint uses the erase blocks that
+   * are reserved for it.  Scan again using the whole device.
+   */
+
+  if (dev->formatstatus == SMART_FMT_STAT_FORMATTED && dev->cpblocks > 0 &&
+      !dev->cpformat)
+    {
+      fwarn("WARNING: Volume has no checkpoint.  Reformat to enable it\n");
+      dev->cpnone     = true;
+      dev->sectorsize = 0;
+      goto rescan;
+    }
+
+scan_done:
+#endif
+
 #if defined (CONFIG_MTD_SMART_WEAR_LEVEL) && (SMART_STATUS_VERSION == 1)
 #ifdef CONFIG_MTD_SMART_CONVERT_WEAR_FORMAT
 
@@ -2364,6 +3144,16 @@ static int smart_scan(FAR struct smart_struct_s *dev)
     }
 #endif
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+  /* Write a checkpoint so that the next mount need not scan the device */
+
+  if (!dev->cpvalid && dev->formatstatus == SMART_FMT_STAT_FORMATTED &&
+      dev->cpformat)
+    {
+      (void)smart_checkpoint_write(dev);
+    }
+#endif
+
   ret = OK;
 
 err_out:
@@ -2475,6 +3265,7 @@ static void smart_erase_block_if_empty(FAR struct smart_struct_s *dev,
       dev->unusedsectors += freecount;
       dev->blockerases++;
 #endif
+      smart_checkpoint_touch(dev, block);
       MTD_ERASE(dev->mtd, block, 1);
 
 #ifdef CONFIG_MTD_SMART_SECTOR_ERASE_DEBUG
@@ -2868,6 +3659,21 @@ static inline int smart_llformat(FAR struct smart_struct_s *dev, unsigned long a
       sectorsize = CONFIG_MTD_SMART_SECTOR_SIZE;
     }
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+  /* The new format always reserves the erase blocks for the checkpoint.
+   * The old checkpoint is erased with the rest of the device.
+   */
+
+  if (dev->cpnone)
+    {
+      dev->cpnone     = false;
+      dev->sectorsize = 0;
+    }
+
+  dev->cpvalid  = false;
+  dev->cpndirty = 0;
+#endif
+
   /* Set the sector size for the device */
 
   smart_setsectorsize(dev, sectorsize);
@@ -2951,6 +3757,15 @@ static inline int smart_llformat(FAR struct smart_struct_s *dev, unsigned long a
 
   dev->rwbuffer[SMART_FMT_ROOTDIRS_POS] = (uint8_t) (arg & 0xff);
 
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+  /* Record that the volume reserves erase blocks for the checkpoint */
+
+  if (dev->cpblocks > 0)
+    {
+      dev->rwbuffer[SMART_FMT_CHECKPOINT_POS] = SMART_FMT_CHECKPOINT_SIG;
+    }
+#endif
+
 #ifdef CONFIG_SMART_CRC_8
   sectorheader->crc8 = smart_calc_sector_crc(dev);
 #elif defined(CONFIG_SMART_CRC_16)
@@ -3120,6 +3935,7 @@ static int smart_relocate_sector(FAR struct smart_struct_s *dev,
 
   /* Write the data to the new physical sector location */
 
+  smart_checkpoint_touch(dev, newsector / dev->sectorsPerBlk);
   ret = MTD_BWRITE(dev->mtd, newsector * dev->mtdBlksPerSector,
                    dev->mtdBlksPerSector, (FAR uint8_t *) dev->rwbuffer);
 
@@ -3133,6 +3949,7 @@ static int smart_relocate_sector(FAR struct smart_struct_s *dev,
 
   /* Write the data to the new physical sector location */
 
+  smart_checkpoint_touch(dev, newsector / dev->sectorsPerBlk);
   ret = MTD_BWRITE(dev->mtd, newsector * dev->mtdBlksPerSector,
                    dev->mtdBlksPerSector, (FAR uint8_t *) dev->rwbuffer);
 
@@ -3347,6 +4164,7 @@ static int smart_relocate_block(FAR struct smart_struct_s *dev, uint16_t block)
 
   /* Now erase the erase block */
 
+  smart_checkpoint_touch(dev, block);
   MTD_ERASE(dev->mtd, block, 1);
 #if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
   dev->unusedsectors += freecount;
@@ -4106,6 +4924,7 @@ static int smart_write_alloc_sector(FAR struct smart_struct_s *dev,
 
 #ifndef CONFIG_MTD_SMART_ENABLE_CRC
   finfo("Write MTD block %d\n", physical * dev->mtdBlksPerSector);
+  smart_checkpoint_touch(dev, physical / dev->sectorsPerBlk);
   ret = MTD_BWRITE(dev->mtd, physical * dev->mtdBlksPerSector, 1,
       (FAR uint8_t *) dev->rwbuffer);
   if (ret != 1)
@@ -4456,6 +5275,7 @@ static int smart_writesector(FAR struct smart_struct_s *dev,
     {
       /* Write the entire sector to the new physical location, uncommitted. */
 
+      smart_checkpoint_touch(dev, physsector / dev->sectorsPerBlk);
       ret = MTD_BWRITE(dev->mtd, physsector * dev->mtdBlksPerSector,
               dev->mtdBlksPerSector, (FAR uint8_t *) dev->rwbuffer);
       if (ret != dev->mtdBlksPerSector)
@@ -4540,6 +5360,7 @@ static int smart_writesector(FAR struct smart_struct_s *dev,
 #ifdef CONFIG_MTD_SMART_ENABLE_CRC
       /* Write the entire sector to FLASH when CRC enabled */
 
+      smart_checkpoint_touch(dev, physsector / dev->sectorsPerBlk);
       ret = MTD_BWRITE(dev->mtd, physsector * dev->mtdBlksPerSector,
               dev->mtdBlksPerSector, (FAR uint8_t *) dev->rwbuffer);
       if (ret != dev->mtdBlksPerSector)
@@ -5202,6 +6023,22 @@ static int smart_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
 #endif
 
       goto ok_out;
+
+    case BIOC_FLUSH:
+
+      /* Write the checkpoint if the device was modified since the last */
+
+      ret = OK;
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+      if (dev->cpndirty > 0 ||
+          (!dev->cpvalid && dev->formatstatus == SMART_FMT_STAT_FORMATTED &&
+           dev->cpformat))
+        {
+          ret = smart_checkpoint_write(dev);
+        }
+#endif
+
+      goto ok_out;
 #endif /* CONFIG_FS_WRITABLE */
 
 #if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
@@ -5272,6 +6109,17 @@ static int smart_ioctl(FAR struct inode *inode, int cmd, unsigned long arg)
     }
 
 ok_out:
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+  /* Write a new checkpoint once enough erase blocks have been modified
+   * that the mount would spend a noticeable time scanning them.
+   */
+
+  if (dev->cpndirty > CONFIG_MTD_SMART_CHECKPOINT_DIRTY)
+    {
+      (void)smart_checkpoint_write(dev);
+    }
+#endif
+
   return ret;
 }
 
@@ -5351,6 +6199,14 @@ int smart_initialize(int minor, FAR struct mtd_dev_s *mtd, FAR const char *partn
 #endif
 #ifdef CONFIG_MTD_SMART_ENABLE_CRC
       dev->allocsector = NULL;
+#endif
+#ifdef CONFIG_MTD_SMART_CHECKPOINT
+      dev->mtdneraseblocks = dev->geo.neraseblocks;
+      dev->cpbuffer = NULL;
+      dev->cpcopy = 0;
+      dev->cpseq = 0;
+      dev->cpformat = false;
+      dev->cpnone = false;
 #endif
       dev->sectorsize = 0;
       ret = smart_setsectorsize(dev, CONFIG_MTD_SMART_SECTOR_SIZE);
@@ -147,6 +147,145 @@ static void pipecommon_pollnotify(FAR struct pipe_dev_s *dev,
 #  define pipecommon_pollnotify(dev,event)
 #endif
 
+/****************************************************************************
+ * Name: pipecommon_isfull
+ *
+ * Description:
+ *   Return true if there is no room in the circular buffer.  One byte of
+ *   the buffer is always left unused so that a full buffer can be
+ *   distinguished from an empty one.
+ *
+ ****************************************************************************/
+
+static inline bool pipecommon_isfull(FAR struct pipe_dev_s *dev)
+{
+  pipe_ndx_t nxtwrndx = dev->d_wrndx + 1;
+
+  if (nxtwrndx >= dev->d_bufsize)
+    {
+      nxtwrndx = 0;
+    }
+
+  return nxtwrndx == dev->d_rdndx;
+}
+
+/****************************************************************************
+ * Name: pipecommon_getdata
+ *
+ * Description:
+ *   Remove up to 'len' bytes from the circular buffer.  The data is copied
+ *   in (at most two) contiguous chunks rather than byte-by-byte.
+ *
+ * Returned Value:
+ *   The number of bytes removed from the buffer.
+ *
+ ****************************************************************************/
+
+static size_t pipecommon_getdata(FAR struct pipe_dev_s *dev,
+                                 FAR uint8_t *buffer, size_t len)
+{
+  size_t nread = 0;
+  size_t chunk;
+
+  while (nread < len && dev->d_wrndx != dev->d_rdndx)
+    {
+      /* Get the size of the contiguous data following d_rdndx */
+
+      if (dev->d_wrndx > dev->d_rdndx)
+        {
+          chunk = dev->d_wrndx - dev->d_rdndx;
+        }
+      else
+        {
+          chunk = dev->d_bufsize - dev->d_rdndx;
+        }
+
+      if (chunk > len - nread)
+        {
+          chunk = len - nread;
+        }
+
+      memcpy(&buffer[nread], &dev->d_buffer[dev->d_rdndx], chunk);
+      nread += chunk;
+
+      if (dev->d_rdndx + chunk >= dev->d_bufsize)
+        {
+          dev->d_rdndx = 0;
+        }
+      else
+        {
+          dev->d_rdndx += chunk;
+        }
+    }
+
+  return nread;
+}
+
+/****************************************************************************
+ * Name: pipecommon_putdata
+ *
+ * Description:
+ *   Add up to 'len' bytes to the circular buffer.  The data is copied in
+ *   (at most two) contiguous chunks rather than byte-by-byte.
+ *
+ * Returned Value:
+ *   The number of bytes added to the buffer.
+ *
+ ****************************************************************************/
+
+static size_t pipecommon_putdata(FAR struct pipe_dev_s *dev,
+                                 FAR const uint8_t *buffer, size_t len)
+{
+  size_t nwritten = 0;
+  size_t chunk;
+
+  while (nwritten < len)
+    {
+      /* Get the size of the contiguous free space following d_wrndx,
+       * keeping the one unused byte just before d_rdndx.
+       */
+
+      if (dev->d_wrndx >= dev->d_rdndx)
+        {
+          chunk = dev->d_bufsize - dev->d_wrndx;
+          if (dev->d_rdndx == 0)
+            {
+              chunk--;
+            }
+        }
+      else
+        {
+          chunk = dev->d_rdndx - dev->d_wrndx - 1;
+        }
+
+      if (chunk == 0)
+        {
+          /* The buffer is full */
+
+          break;
+        }
+
+      if (chunk > len - nwritten)
+        {
+          chunk = len - nwritten;
+        }
+
+      memcpy(&dev->d_buffer[dev->d_wrndx], &buffer[nwritten], chunk);
+      nwritten += chunk;
+
+      if (dev->d_wrndx + chunk >= dev->d_bufsize)
+        {
+          dev->d_wrndx = 0;
+        }
+      else
+        {
+          dev->d_wrndx += chunk;
+        }
+    }
+
+  return nwritten;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -428,6 +567,7 @@ ssize_t pipecommon_read(FAR struct file *filep, FAR char *buffer, size_t len)
   FAR uint8_t           *start  = (FAR uint8_t *)buffer;
 #endif
   ssize_t                nread  = 0;
+  bool                   wasfull;
   int                    sval;
   int                    ret;
 
@@ -478,30 +618,33 @@ ssize_t pipecommon_read(FAR struct file *filep, FAR char *buffer, size_t len)
         }
     }
 
-  /* Then return whatever is available in the pipe (which is at least one byte) */
-
-  nread = 0;
-  while ((size_t)nread < len && dev->d_wrndx != dev->d_rdndx)
-    {
-      *buffer++ = dev->d_buffer[dev->d_rdndx];
-      if (++dev->d_rdndx >= dev->d_bufsize)
-        {
-          dev->d_rdndx = 0;
-        }
+  /* Then return whatever is available in the pipe (which is at least one
+   * byte).  Remember if the buffer was full before the data was removed.
+   */
 
-      nread++;
-    }
+  wasfull = pipecommon_isfull(dev);
+  nread   = pipecommon_getdata(dev, (FAR uint8_t *)buffer, len);
 
-  /* Notify all waiting writers that bytes have been removed from the buffer */
+  /* Notify all waiting writers that bytes have been removed from the
+   * buffer.  This is done on every read, not only when the buffer was full:
+   * On SMP, a writer may not yet be waiting on d_wrsem when the buffer
+   * becomes non-full.  It must then be woken by a later read.
+   */
 
   while (sem_getvalue(&dev->d_wrsem, &sval) == 0 && sval < 0)
     {
       sem_post(&dev->d_wrsem);
     }
 
-  /* Notify all poll/select waiters that they can write to the FIFO */
+  /* Poll/select waiters are set up and notified with the device locked, so
+   * they need to be notified only when the buffer transitions from full to
+   * not full.
+   */
 
-  pipecommon_pollnotify(dev, POLLOUT);
+  if (wasfull)
+    {
+      pipecommon_pollnotify(dev, POLLOUT);
+    }
 
   sem_post(&dev->d_bfsem);
   pipe_dumpbuffer("From PIPE:", start, nread);
@@ -519,7 +662,7 @@ ssize_t pipecommon_write(FAR struct file *filep, FAR const char *buffer,
   FAR struct pipe_dev_s *dev      = inode->i_private;
   ssize_t                nwritten = 0;
   ssize_t                last;
-  int                    nxtwrndx;
+  bool                   wasempty;
   int                    sval;
 
   DEBUGASSERT(dev);
@@ -556,82 +699,72 @@ ssize_t pipecommon_write(FAR struct file *filep, FAR const char *buffer,
   last = 0;
   for (; ; )
     {
-      /* Calculate the write index AFTER the next byte is written */
-
-      nxtwrndx = dev->d_wrndx + 1;
-      if (nxtwrndx >= dev->d_bufsize)
-        {
-          nxtwrndx = 0;
-        }
+      /* Copy as much data as will fit into the circular buffer.  Remember if
+       * the buffer was empty before the data was added.
+       */
 
-      /* Would the next write overflow the circular buffer? */
+      wasempty  = (dev->d_wrndx == dev->d_rdndx);
+      nwritten += pipecommon_putdata(dev,
+                                     (FAR const uint8_t *)buffer + nwritten,
+                                     len - nwritten);
 
-      if (nxtwrndx != dev->d_rdndx)
+      if (last < nwritten)
         {
-          /* No... copy the byte */
-
-          dev->d_buffer[dev->d_wrndx] = *buffer++;
-          dev->d_wrndx = nxtwrndx;
-
-          /* Is the write complete? */
+          /* Notify all of the waiting readers that more data is available.
+           * As for writers, this is done on every write so that a reader
+           * that was not yet waiting when the buffer became non-empty is
+           * woken by a later write.
+           */
 
-          nwritten++;
-          if ((size_t)nwritten >= len)
+          while (sem_getvalue(&dev->d_rdsem, &sval) == 0 && sval < 0)
             {
-              /* Yes.. Notify all of the waiting readers that more data is available */
-
-              while (sem_getvalue(&dev->d_rdsem, &sval) == 0 && sval < 0)
-                {
-                  sem_post(&dev->d_rdsem);
-                }
+              sem_post(&dev->d_rdsem);
+            }
 
-              /* Notify all poll/select waiters that they can write to the FIFO */
+          /* Notify all poll/select waiters that they can read from the
+           * FIFO if it was empty before.
+           */
 
+          if (wasempty)
+            {
               pipecommon_pollnotify(dev, POLLIN);
-
-              /* Return the number of bytes written */
-
-              sem_post(&dev->d_bfsem);
-              return len;
             }
         }
-      else
+
+      /* Is the write complete? */
+
+      if ((size_t)nwritten >= len)
         {
-          /* There is not enough room for the next byte.  Was anything written in this pass? */
+          /* Yes.. return the number of bytes written */
 
-          if (last < nwritten)
-            {
-              /* Yes.. Notify all of the waiting readers that more data is available */
+          sem_post(&dev->d_bfsem);
+          return len;
+        }
 
-              while (sem_getvalue(&dev->d_rdsem, &sval) == 0 && sval < 0)
-                {
-                  sem_post(&dev->d_rdsem);
-                }
-            }
+      /* There is not enough room for the remaining data */
 
-          last = nwritten;
+      last = nwritten;
 
-          /* If O_NONBLOCK was set, then return partial bytes written or EGAIN */
+      /* If O_NONBLOCK was set, then return partial bytes written or EGAIN */
 
-          if (filep->f_oflags & O_NONBLOCK)
+      if (filep->f_oflags & O_NONBLOCK)
+        {
+          if (nwritten == 0)
             {
-              if (nwritten == 0)
-                {
-                  nwritten = -EAGAIN;
-                }
-
-              sem_post(&dev->d_bfsem);
-              return nwritten;
+              nwritten = -EAGAIN;
             }
 
-          /* There is more to be written.. wait for data to be removed from the pipe */
-
-          sched_lock();
           sem_post(&dev->d_bfsem);
-          pipecommon_semtake(&dev->d_wrsem);
-          sched_unlock();
-          pipecommon_semtake(&dev->d_bfsem);
+          return nwritten;
         }
+
+      /* There is more to be written.. wait for data to be removed from the pipe */
+
+      sched_lock();
+      sem_post(&dev->d_bfsem);
+      pipecommon_semtake(&dev->d_wrsem);
+      sched_unlock();
+      pipecommon_semtake(&dev->d_bfsem);
     }
 }
 
@@ -40,12 +40,14 @@
 #include <nuttx/config.h>
 
 #include <sys/types.h>
-#include <sched.h>
+#include <stdbool.h>
+#include <semaphore.h>
 #include <assert.h>
 #include <errno.h>
 
 #include <nuttx/sched_note.h>
 #include <nuttx/fs/fs.h>
+#include <nuttx/fs/ioctl.h>
 
 #if defined(CONFIG_SCHED_INSTRUMENTATION_BUFFER) && \
     defined(CONFIG_DRIVER_NOTE)
@@ -56,6 +58,8 @@
 
 static ssize_t note_read(FAR struct file *filep, FAR char *buffer,
                  size_t buflen);
+static int     note_ioctl(FAR struct file *filep, int cmd,
+                 unsigned long arg);
 
 /****************************************************************************
  * Private Data
@@ -68,15 +72,19 @@ static const struct file_operations note_fops =
   note_read,     /* read */
   0,             /* write */
   0,             /* seek */
-  0              /* ioctl */
+  note_ioctl     /* ioctl */
 #ifndef CONFIG_DISABLE_POLL
   , 0            /* poll */
 #endif
 #ifndef CONFIG_DISABLE_PSEUDOFS_OPERATIONS
   , 0            /* unlink */
-#endif 
+#endif
 };
 
+/* sched_note_get() supports only one reader at a time */
+
+static sem_t g_note_exclsem = SEM_INITIALIZER(1);
+
 /****************************************************************************
  * Private Functions
  ****************************************************************************/
@@ -96,7 +104,15 @@ static ssize_t note_read(FAR struct file *filep, FAR char *buffer,
   /* Then loop, adding as many notes as possible to the user buffer. */
 
   retlen = 0;
-  sched_lock();
+  while (sem_wait(&g_note_exclsem) < 0)
+    {
+      /* The only case that an error should occur here is if the wait was
+       * awakened by a signal.
+       */
+
+      DEBUGASSERT(get_errno() == EINTR);
+    }
+
   do
     {
      /* Get the next note (removing it from the buffer) */
@@ -137,10 +153,36 @@ static ssize_t note_read(FAR struct file *filep, FAR char *buffer,
     }
   while (notelen > 0 && notelen <= buflen);
 
-  sched_unlock();
+  sem_post(&g_note_exclsem);
   return retlen;
 }
 
+/****************************************************************************
+ * Name: note_ioctl
+ ****************************************************************************/
+
+static int note_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
+{
+  FAR unsigned long *dropped = (FAR unsigned long *)((uintptr_t)arg);
+
+  switch (cmd)
+    {
+      /* Return the number of notes lost because the buffer was full */
+
+      case NOTEIOC_GETDROPPED:
+        if (dropped == NULL)
+          {
+            return -EINVAL;
+          }
+
+        *dropped = sched_note_dropped(true);
+        return OK;
+
+      default:
+        return -ENOTTY;
+    }
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
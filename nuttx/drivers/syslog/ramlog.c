@@ -46,16 +46,21 @@
 #include <stdint.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <stdarg.h>
 #include <fcntl.h>
 #include <string.h>
 #include <poll.h>
+#include <time.h>
 #include <errno.h>
 #include <assert.h>
 #include <debug.h>
 
 #include <nuttx/arch.h>
+#include <nuttx/init.h>
+#include <nuttx/clock.h>
 #include <nuttx/kmalloc.h>
 #include <nuttx/semaphore.h>
+#include <nuttx/spinlock.h>
 #include <nuttx/fs/fs.h>
 #include <nuttx/syslog/ramlog.h>
 
@@ -63,6 +68,61 @@
 
 #ifdef CONFIG_RAMLOG
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Read and write positions are free running counts that wrap at a multiple
+ * of the buffer size.  Each reader keeps its own read position and can
+ * tell how far it has fallen behind the writer from the difference between
+ * the two positions;  there is no shared tail index.
+ */
+
+#define RAMLOG_POSLIMIT(s) ((uint32_t)(s) * (0x80000000ul / (uint32_t)(s)))
+
+#ifdef CONFIG_RAMLOG_BINARY
+/* In the binary mode, there is one circular buffer per CPU.  Each buffer is
+ * written only by its own CPU with local interrupts disabled.
+ */
+
+#  ifdef CONFIG_SMP
+#    define RAMLOG_NCPUS    CONFIG_SMP_NCPUS
+#    define ramlog_cpu()    up_cpu_index()
+#  else
+#    define RAMLOG_NCPUS    1
+#    define ramlog_cpu()    (0)
+#  endif
+
+#  if CONFIG_RAMLOG_BUFSIZE < CONFIG_RAMLOG_BINARY_RECSIZE
+#    error CONFIG_RAMLOG_BUFSIZE must be at least CONFIG_RAMLOG_BINARY_RECSIZE
+#  endif
+
+/* Record types */
+
+#  define RAMLOG_REC_FORMAT 0       /* Format string pointer + arguments */
+#  define RAMLOG_REC_TEXT   1       /* Pre-formatted text */
+
+/* Argument types */
+
+#  define RAMLOG_ARG_NONE   0       /* No argument (e.g., %%) */
+#  define RAMLOG_ARG_INT    1       /* int (also char and short) */
+#  define RAMLOG_ARG_LONG   2       /* long */
+#  define RAMLOG_ARG_LLONG  3       /* long long */
+#  define RAMLOG_ARG_PTR    4       /* void * */
+#  define RAMLOG_ARG_STR    5       /* char *, string is copied */
+#  define RAMLOG_ARG_DOUBLE 6       /* double */
+#  define RAMLOG_ARG_SKIP   7       /* int * for %n, consumed but ignored */
+
+/* Maximum size of pre-formatted text in one record, of one formatted
+ * record, and of one conversion specification.
+ */
+
+#  define RAMLOG_TEXTSIZE \
+     (CONFIG_RAMLOG_BINARY_RECSIZE - sizeof(struct ramlog_rec_s))
+#  define RAMLOG_LINESIZE   (2 * CONFIG_RAMLOG_BINARY_RECSIZE)
+#  define RAMLOG_SPECSIZE   32
+#endif /* CONFIG_RAMLOG_BINARY */
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -72,14 +132,17 @@ struct ramlog_dev_s
 #ifndef CONFIG_RAMLOG_NONBLOCKING
   volatile uint8_t  rl_nwaiters;     /* Number of threads waiting for data */
 #endif
-  volatile uint16_t rl_head;         /* The head index (where data is added) */
-  volatile uint16_t rl_tail;         /* The tail index (where data is removed) */
+#ifndef CONFIG_RAMLOG_BINARY
+  volatile uint32_t rl_head;         /* The head position (where data is added) */
+#endif
   sem_t             rl_exclsem;      /* Enforces mutually exclusive access */
 #ifndef CONFIG_RAMLOG_NONBLOCKING
   sem_t             rl_waitsem;      /* Used to wait for data */
 #endif
+#ifndef CONFIG_RAMLOG_BINARY
   size_t            rl_bufsize;      /* Size of the RAM buffer */
   FAR char         *rl_buffer;       /* Circular RAM buffer */
+#endif
 
   /* The following is a list if poll structures of threads waiting for
    * driver events. The 'struct pollfd' reference for each open is also
@@ -91,6 +154,69 @@ struct ramlog_dev_s
 #endif
 };
 
+#ifdef CONFIG_RAMLOG_BINARY
+/* This is the header of each record in the binary RAM log.  The record
+ * length must be the first field.  RAMLOG_REC_FORMAT records are followed
+ * by the argument values in the order that they are consumed by the format
+ * string; RAMLOG_REC_TEXT records are followed by the text.
+ */
+
+struct ramlog_rec_s
+{
+  uint16_t rr_len;                   /* Record length, including header */
+  uint8_t  rr_type;                  /* See RAMLOG_REC_* definitions */
+  uint8_t  rr_pad;
+  uint32_t rr_sec;                   /* Time stamp (seconds) */
+  uint32_t rr_nsec;                  /* Time stamp (nanoseconds) */
+  FAR const char *rr_fmt;            /* Format string (RAMLOG_REC_FORMAT) */
+};
+
+/* A record under construction or being formatted */
+
+union ramlog_recbuf_u
+{
+  struct ramlog_rec_s rb_hdr;
+  uint8_t rb_bytes[CONFIG_RAMLOG_BINARY_RECSIZE];
+};
+
+/* One conversion specification in a format string */
+
+struct ramlog_spec_s
+{
+  FAR const char *rs_start;          /* The '%' beginning the conversion */
+  FAR const char *rs_end;            /* Just past the conversion character */
+  uint8_t rs_nstar;                  /* Number of '*' width/precision args */
+  uint8_t rs_type;                   /* See RAMLOG_ARG_* definitions */
+};
+
+/* The per-CPU circular buffer */
+
+struct ramlog_cpu_s
+{
+  volatile uint32_t rc_head;         /* Position where records are added */
+  volatile uint32_t rc_tail;         /* Position of the oldest record */
+  uint16_t rc_nline;                 /* Number of characters in rc_line */
+  char rc_line[RAMLOG_TEXTSIZE];     /* Partial line from ramlog_putc() */
+  uint8_t rc_buffer[CONFIG_RAMLOG_BUFSIZE];
+};
+#endif
+
+/* Each open file has its own read position so that any number of readers
+ * can consume the log independently.
+ */
+
+struct ramlog_reader_s
+{
+#ifdef CONFIG_RAMLOG_BINARY
+  uint32_t rd_pos[RAMLOG_NCPUS];     /* Read position in each CPU buffer */
+  uint16_t rd_nline;                 /* Number of characters in rd_line */
+  uint16_t rd_offset;                /* Characters of rd_line already read */
+  char rd_line[RAMLOG_LINESIZE];     /* The last formatted record */
+#else
+  uint32_t rd_pos;                   /* Read position in the buffer */
+#endif
+};
+
 /****************************************************************************
  * Private Function Prototypes
  ****************************************************************************/
@@ -98,6 +224,9 @@ struct ramlog_dev_s
 /* Syslog channel methods */
 
 #ifdef CONFIG_RAMLOG_SYSLOG
+#ifdef CONFIG_SYSLOG_WRITE
+static ssize_t ramlog_syslog_write(FAR const char *buffer, size_t buflen);
+#endif
 static int ramlog_flush(void);
 #endif
 
@@ -107,10 +236,21 @@ static int ramlog_flush(void);
 static void ramlog_pollnotify(FAR struct ramlog_dev_s *priv,
                               pollevent_t eventset);
 #endif
-static ssize_t ramlog_addchar(FAR struct ramlog_dev_s *priv, char ch);
+static void ramlog_notify(FAR struct ramlog_dev_s *priv);
+static void ramlog_addtext(FAR struct ramlog_dev_s *priv,
+                           FAR const char *buffer, size_t buflen);
+#ifndef CONFIG_DISABLE_POLL
+static bool ramlog_available(FAR struct ramlog_dev_s *priv,
+                             FAR struct ramlog_reader_s *rd);
+#endif
+static size_t ramlog_copyout(FAR struct ramlog_dev_s *priv,
+                             FAR struct ramlog_reader_s *rd,
+                             FAR char *buffer, size_t buflen);
 
 /* Character driver methods */
 
+static int     ramlog_open(FAR struct file *filep);
+static int     ramlog_close(FAR struct file *filep);
 static ssize_t ramlog_read(FAR struct file *filep, FAR char *buffer,
                            size_t buflen);
 static ssize_t ramlog_write(FAR struct file *filep, FAR const char *buffer,
@@ -128,7 +268,7 @@ static int     ramlog_poll(FAR struct file *filep, FAR struct pollfd *fds,
 static const struct syslog_channel_s g_ramlog_syslog_channel =
 {
 #ifdef CONFIG_SYSLOG_WRITE
-  syslog_default_write,
+  ramlog_syslog_write,
 #endif
   ramlog_putc,
   ramlog_putc,
@@ -142,8 +282,8 @@ static const struct syslog_channel_s g_ramlog_syslog_channel =
 
 static const struct file_operations g_ramlogfops =
 {
-  NULL,         /* open */
-  NULL,         /* close */
+  ramlog_open,  /* open */
+  ramlog_close, /* close */
   ramlog_read,  /* read */
   ramlog_write, /* write */
   NULL,         /* seek */
@@ -161,7 +301,11 @@ static const struct file_operations g_ramlogfops =
  */
 
 #if defined(CONFIG_RAMLOG_CONSOLE) || defined(CONFIG_RAMLOG_SYSLOG)
+#ifdef CONFIG_RAMLOG_BINARY
+static struct ramlog_cpu_s g_ramlog_cpu[RAMLOG_NCPUS];
+#else
 static char g_sysbuffer[CONFIG_RAMLOG_BUFSIZE];
+#endif
 
 /* This is the device structure for the console or syslogging function.  It
  * must be statically initialized because the RAMLOG ramlog_putc function
@@ -173,101 +317,1191 @@ static struct ramlog_dev_s g_sysdev =
 #ifndef CONFIG_RAMLOG_NONBLOCKING
   0,                             /* rl_nwaiters */
 #endif
+#ifndef CONFIG_RAMLOG_BINARY
   0,                             /* rl_head */
-  0,                             /* rl_tail */
+#endif
   SEM_INITIALIZER(1),            /* rl_exclsem */
 #ifndef CONFIG_RAMLOG_NONBLOCKING
   SEM_INITIALIZER(0),            /* rl_waitsem */
 #endif
+#ifndef CONFIG_RAMLOG_BINARY
   CONFIG_RAMLOG_BUFSIZE,         /* rl_bufsize */
   g_sysbuffer                    /* rl_buffer */
+#endif
 };
 #endif
 
-/****************************************************************************
- * Private Functions
- ****************************************************************************/
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: ramlog_posadd and ramlog_posdiff
+ *
+ * Description:
+ *   Advance a buffer position and get the distance between two buffer
+ *   positions, handling wraparound of the free running position counts.
+ *
+ ****************************************************************************/
+
+static inline uint32_t ramlog_posadd(uint32_t pos, uint32_t n, size_t size)
+{
+  pos += n;
+  if (pos >= RAMLOG_POSLIMIT(size))
+    {
+      pos -= RAMLOG_POSLIMIT(size);
+    }
+
+  return pos;
+}
+
+static inline uint32_t ramlog_posdiff(uint32_t to, uint32_t from,
+                                      size_t size)
+{
+  return to >= from ? to - from : to + RAMLOG_POSLIMIT(size) - from;
+}
+
+/****************************************************************************
+ * Name: ramlog_bin_copyin and ramlog_bin_copyout
+ *
+ * Description:
+ *   Copy data into or out of a per-CPU circular buffer, handling
+ *   wraparound.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_RAMLOG_BINARY
+static void ramlog_bin_copyin(FAR struct ramlog_cpu_s *rc, uint32_t pos,
+                              FAR const void *src, size_t len)
+{
+  size_t ndx = pos % CONFIG_RAMLOG_BUFSIZE;
+  size_t nbytes = CONFIG_RAMLOG_BUFSIZE - ndx;
+
+  if (nbytes > len)
+    {
+      nbytes = len;
+    }
+
+  memcpy(&rc->rc_buffer[ndx], src, nbytes);
+  memcpy(rc->rc_buffer, (FAR const uint8_t *)src + nbytes, len - nbytes);
+}
+
+static void ramlog_bin_copyout(FAR struct ramlog_cpu_s *rc, uint32_t pos,
+                               FAR void *dest, size_t len)
+{
+  size_t ndx = pos % CONFIG_RAMLOG_BUFSIZE;
+  size_t nbytes = CONFIG_RAMLOG_BUFSIZE - ndx;
+
+  if (nbytes > len)
+    {
+      nbytes = len;
+    }
+
+  memcpy(dest, &rc->rc_buffer[ndx], nbytes);
+  memcpy((FAR uint8_t *)dest + nbytes, rc->rc_buffer, len - nbytes);
+}
+
+/****************************************************************************
+ * Name: ramlog_bin_valid
+ *
+ * Description:
+ *   Return true if the data at 'pos' has not yet been overwritten.  The
+ *   writer always advances rc_tail before it overwrites old records, so a
+ *   reader calls this after copying a record to verify the copy.
+ *
+ ****************************************************************************/
+
+static bool ramlog_bin_valid(FAR struct ramlog_cpu_s *rc, uint32_t pos)
+{
+  uint32_t tail;
+  uint32_t head;
+
+  SP_DMB();
+  tail = rc->rc_tail;
+  head = rc->rc_head;
+
+  return ramlog_posdiff(pos, tail, CONFIG_RAMLOG_BUFSIZE) <=
+         ramlog_posdiff(head, tail, CONFIG_RAMLOG_BUFSIZE);
+}
+
+/****************************************************************************
+ * Name: ramlog_bin_commit
+ *
+ * Description:
+ *   Time stamp a record and add it to the circular buffer of this CPU,
+ *   discarding the oldest records if necessary.  This does not require any
+ *   lock:  Only this CPU modifies its buffer and it does so with its local
+ *   interrupts disabled.  Readers verify that the records that they copied
+ *   were not overwritten while they were copying them.
+ *
+ ****************************************************************************/
+
+static void ramlog_bin_commit(FAR union ramlog_recbuf_u *rec)
+{
+  FAR struct ramlog_cpu_s *rc;
+  struct timespec ts;
+  irqstate_t flags;
+  uint32_t head;
+  uint32_t tail;
+  uint32_t used;
+  uint16_t reclen = rec->rb_hdr.rr_len;
+  uint16_t len;
+  int ret = -EAGAIN;
+
+  DEBUGASSERT(reclen >= sizeof(struct ramlog_rec_s) &&
+              reclen <= CONFIG_RAMLOG_BINARY_RECSIZE);
+
+  flags = up_irq_save();
+
+  /* Time stamp the record.  Since debug output may be generated very early
+   * in the start-up sequence, hardware timer support may not yet be
+   * available.
+   */
+
+  if (OSINIT_HW_READY())
+    {
+#ifdef CONFIG_CLOCK_MONOTONIC
+      ret = clock_gettime(CLOCK_MONOTONIC, &ts);
+#else
+      ret = clock_systimespec(&ts);
+#endif
+    }
+
+  if (ret < 0)
+    {
+      ts.tv_sec  = 0;
+      ts.tv_nsec = 0;
+    }
+
+  rec->rb_hdr.rr_sec  = (uint32_t)ts.tv_sec;
+  rec->rb_hdr.rr_nsec = (uint32_t)ts.tv_nsec;
+
+  /* Discard the oldest records until the new record fits */
+
+  rc   = &g_ramlog_cpu[ramlog_cpu()];
+  head = rc->rc_head;
+  tail = rc->rc_tail;
+  used = ramlog_posdiff(head, tail, CONFIG_RAMLOG_BUFSIZE);
+
+  if (used + reclen > CONFIG_RAMLOG_BUFSIZE)
+    {
+      do
+        {
+          ramlog_bin_copyout(rc, tail, &len, sizeof(uint16_t));
+          tail  = ramlog_posadd(tail, len, CONFIG_RAMLOG_BUFSIZE);
+          used -= len;
+        }
+      while (used + reclen > CONFIG_RAMLOG_BUFSIZE);
+
+      /* Release the old records before overwriting them */
+
+      rc->rc_tail = tail;
+      SP_DMB();
+    }
+
+  /* Copy the record and then make it visible to readers */
+
+  ramlog_bin_copyin(rc, head, rec, reclen);
+  SP_DMB();
+  rc->rc_head = ramlog_posadd(head, reclen, CONFIG_RAMLOG_BUFSIZE);
+
+  up_irq_restore(flags);
+}
+
+/****************************************************************************
+ * Name: ramlog_bin_addtext
+ *
+ * Description:
+ *   Add pre-formatted text to the binary RAM log.
+ *
+ ****************************************************************************/
+
+static void ramlog_bin_addtext(FAR const char *buffer, size_t buflen)
+{
+  union ramlog_recbuf_u rec;
+  size_t nbytes;
+
+  while (buflen > 0)
+    {
+      nbytes = buflen;
+      if (nbytes > RAMLOG_TEXTSIZE)
+        {
+          nbytes = RAMLOG_TEXTSIZE;
+        }
+
+      rec.rb_hdr.rr_len  = sizeof(struct ramlog_rec_s) + nbytes;
+      rec.rb_hdr.rr_type = RAMLOG_REC_TEXT;
+      rec.rb_hdr.rr_pad  = 0;
+      rec.rb_hdr.rr_fmt  = NULL;
+      memcpy(&rec.rb_bytes[sizeof(struct ramlog_rec_s)], buffer, nbytes);
+
+      ramlog_bin_commit(&rec);
+
+      buffer += nbytes;
+      buflen -= nbytes;
+    }
+}
+
+/****************************************************************************
+ * Name: ramlog_bin_flushline
+ *
+ * Description:
+ *   Commit the partial line that ramlog_putc() has accumulated for this
+ *   CPU.
+ *
+ ****************************************************************************/
+
+static void ramlog_bin_flushline(void)
+{
+  FAR struct ramlog_cpu_s *rc;
+  irqstate_t flags;
+
+  flags = up_irq_save();
+  rc = &g_ramlog_cpu[ramlog_cpu()];
+  if (rc->rc_nline > 0)
+    {
+      ramlog_bin_addtext(rc->rc_line, rc->rc_nline);
+      rc->rc_nline = 0;
+    }
+
+  up_irq_restore(flags);
+}
+
+/****************************************************************************
+ * Name: ramlog_nextspec
+ *
+ * Description:
+ *   Find the next conversion specification in a format string and
+ *   determine the type of its argument.  Only the conversions supported by
+ *   lib_vsprintf() need to be recognized.
+ *
+ * Returned Value:
+ *   True if a conversion specification was found.  In any case,
+ *   spec->rs_start is set to the end of the literal text that precedes the
+ *   specification.
+ *
+ ****************************************************************************/
+
+static bool ramlog_nextspec(FAR const char *fmt,
+                            FAR struct ramlog_spec_s *spec)
+{
+  int nlong = 0;
+
+  while (*fmt != '%')
+    {
+      if (*fmt == '\0')
+        {
+          spec->rs_start = fmt;
+          return false;
+        }
+
+      fmt++;
+    }
+
+  spec->rs_start = fmt++;
+  spec->rs_nstar = 0;
+  spec->rs_type  = RAMLOG_ARG_NONE;
+
+  /* Skip over flags, field width and precision */
+
+  for (; ; fmt++)
+    {
+      if (*fmt == '*')
+        {
+          spec->rs_nstar++;
+        }
+      else if (*fmt != '-' && *fmt != '+' && *fmt != ' ' && *fmt != '#' &&
+               *fmt != '.' && (*fmt < '0' || *fmt > '9'))
+        {
+          break;
+        }
+    }
+
+  /* Then the length modifiers */
+
+  for (; ; fmt++)
+    {
+      if (*fmt == 'l')
+        {
+          nlong++;
+        }
+      else if (*fmt == 'L')
+        {
+          nlong = 2;
+        }
+      else if (*fmt != 'h')
+        {
+          break;
+        }
+    }
+
+  /* And, finally, the conversion itself */
+
+  switch (*fmt)
+    {
+      case '\0':
+        spec->rs_end = fmt;
+        return true;
+
+      case 'd':
+      case 'i':
+      case 'u':
+      case 'x':
+      case 'X':
+      case 'o':
+      case 'b':
+        spec->rs_type = nlong > 1 ? RAMLOG_ARG_LLONG :
+                        nlong > 0 ? RAMLOG_ARG_LONG : RAMLOG_ARG_INT;
+        break;
+
+      case 'c':
+        spec->rs_type = RAMLOG_ARG_INT;
+        break;
+
+      case 'p':
+        spec->rs_type = RAMLOG_ARG_PTR;
+        break;
+
+      case 's':
+        spec->rs_type = RAMLOG_ARG_STR;
+        break;
+
+      case 'n':
+        spec->rs_type = RAMLOG_ARG_SKIP;
+        break;
+
+#ifdef CONFIG_LIBC_FLOATINGPOINT
+      case 'e':
+      case 'E':
+      case 'f':
+      case 'g':
+      case 'G':
+        spec->rs_type = RAMLOG_ARG_DOUBLE;
+        break;
+#endif
+
+      default:
+        break;
+    }
+
+  spec->rs_end = fmt + 1;
+  return true;
+}
+
+/****************************************************************************
+ * Name: ramlog_putarg and ramlog_getarg
+ *
+ * Description:
+ *   Save an argument value in a record or retrieve an argument value from
+ *   a record.  False is returned if the record is full (or exhausted).
+ *
+ ****************************************************************************/
+
+static bool ramlog_putarg(FAR uint8_t **pptr, FAR const uint8_t *end,
+                          FAR const void *value, size_t size)
+{
+  if ((size_t)(end - *pptr) < size)
+    {
+      return false;
+    }
+
+  memcpy(*pptr, value, size);
+  *pptr += size;
+  return true;
+}
+
+static bool ramlog_getarg(FAR const uint8_t **pptr, FAR const uint8_t *end,
+                          FAR void *value, size_t size)
+{
+  if ((size_t)(end - *pptr) < size)
+    {
+      return false;
+    }
+
+  memcpy(value, *pptr, size);
+  *pptr += size;
+  return true;
+}
+
+/****************************************************************************
+ * Name: ramlog_format
+ *
+ * Description:
+ *   Format one record from the binary RAM log into a line of text.
+ *
+ * Returned Value:
+ *   The number of characters in the line (not NUL terminated).
+ *
+ ****************************************************************************/
+
+static size_t ramlog_format(FAR const union ramlog_recbuf_u *rec,
+                            FAR char *line, size_t size)
+{
+  FAR const uint8_t *ptr = &rec->rb_bytes[sizeof(struct ramlog_rec_s)];
+  FAR const uint8_t *end = &rec->rb_bytes[rec->rb_hdr.rr_len];
+  FAR const char *fmt = rec->rb_hdr.rr_fmt;
+  struct ramlog_spec_s spec;
+  char specbuf[RAMLOG_SPECSIZE];
+  size_t nline = 0;
+  size_t nbytes;
+  bool more;
+  int ret;
+
+  if (rec->rb_hdr.rr_type == RAMLOG_REC_TEXT)
+    {
+      nbytes = end - ptr;
+      if (nbytes > size)
+        {
+          nbytes = size;
+        }
+
+      memcpy(line, ptr, nbytes);
+      return nbytes;
+    }
+
+  /* Each snprintf() below needs space for its NUL terminator */
+
+  size--;
+
+#ifdef CONFIG_SYSLOG_TIMESTAMP
+  /* Pre-pend the message with the time that it was logged */
+
+  ret = snprintf(line, size + 1, "[%6d.%06d]", (int)rec->rb_hdr.rr_sec,
+                 (int)(rec->rb_hdr.rr_nsec / 1000));
+  nline = ret < 0 ? 0 : (size_t)ret > size ? size : (size_t)ret;
+#endif
+
+  do
+    {
+      /* Copy the literal text that precedes the next conversion */
+
+      more   = ramlog_nextspec(fmt, &spec);
+      nbytes = spec.rs_start - fmt;
+      if (nbytes > size - nline)
+        {
+          nbytes = size - nline;
+        }
+
+      memcpy(&line[nline], fmt, nbytes);
+      nline += nbytes;
+
+      if (!more)
+        {
+          break;
+        }
+
+      /* Copy the conversion specification, replacing any '*' field width
+       * or precision with the saved value.
+       */
+
+      for (nbytes = 0, fmt = spec.rs_start;
+           fmt < spec.rs_end && nbytes < RAMLOG_SPECSIZE - 12;
+           fmt++)
+        {
+          if (*fmt == '*')
+            {
+              int star;
+
+              if (!ramlog_getarg(&ptr, end, &star, sizeof(int)))
+                {
+                  return nline;
+                }
+
+              nbytes += sprintf(&specbuf[nbytes], "%d", star);
+            }
+          else
+            {
+              specbuf[nbytes++] = *fmt;
+            }
+        }
+
+      specbuf[nbytes] = '\0';
+      fmt = spec.rs_end;
+
+      /* Then format the saved argument value */
+
+      switch (spec.rs_type)
+        {
+          case RAMLOG_ARG_INT:
+            {
+              int value;
+
+              if (!ramlog_getarg(&ptr, end, &value, sizeof(int)))
+                {
+                  return nline;
+                }
+
+              ret = snprintf(&line[nline], size + 1 - nline, specbuf, value);
+            }
+            break;
+
+          case RAMLOG_ARG_LONG:
+            {
+              long value;
+
+              if (!ramlog_getarg(&ptr, end, &value, sizeof(long)))
+                {
+                  return nline;
+                }
+
+              ret = snprintf(&line[nline], size + 1 - nline, specbuf, value);
+            }
+            break;
+
+          case RAMLOG_ARG_LLONG:
+            {
+              long long value;
+
+              if (!ramlog_getarg(&ptr, end, &value, sizeof(long long)))
+                {
+                  return nline;
+                }
+
+              ret = snprintf(&line[nline], size + 1 - nline, specbuf, value);
+            }
+            break;
+
+          case RAMLOG_ARG_PTR:
+          case RAMLOG_ARG_SKIP:
+            {
+              FAR void *value;
+
+              if (!ramlog_getarg(&ptr, end, &value, sizeof(FAR void *)))
+                {
+                  return nline;
+                }
+
+              /* %n must not be passed on to snprintf() */
+
+              ret = spec.rs_type == RAMLOG_ARG_SKIP ? 0 :
+                    snprintf(&line[nline], size + 1 - nline, specbuf, value);
+            }
+            break;
+
+          case RAMLOG_ARG_STR:
+            {
+              FAR const char *value = (FAR const char *)ptr;
+
+              nbytes = strnlen(value, end - ptr);
+              if (nbytes >= (size_t)(end - ptr))
+                {
+                  return nline;
+                }
+
+              ptr += nbytes + 1;
+              ret  = snprintf(&line[nline], size + 1 - nline, specbuf, value);
+            }
+            break;
+
+#ifdef CONFIG_LIBC_FLOATINGPOINT
+          case RAMLOG_ARG_DOUBLE:
+            {
+              double value;
+
+              if (!ramlog_getarg(&ptr, end, &value, sizeof(double)))
+                {
+                  return nline;
+                }
+
+              ret = snprintf(&line[nline], size + 1 - nline, specbuf, value);
+            }
+            break;
+#endif
+
+          default:
+            ret = snprintf(&line[nline], size + 1 - nline, "%s",
+                           spec.rs_start[1] == '%' ? "%" : "");
+            break;
+        }
+
+      if (ret > 0)
+        {
+          nline += (size_t)ret > size - nline ? size - nline : (size_t)ret;
+        }
+    }
+  while (nline < size);
+
+  return nline;
+}
+
+/****************************************************************************
+ * Name: ramlog_bin_next
+ *
+ * Description:
+ *   Get the oldest record that this reader has not yet read from any of the
+ *   per-CPU buffers and format it into the reader's line buffer.
+ *
+ * Returned Value:
+ *   True if a record was formatted; false if there are no more records.
+ *
+ ****************************************************************************/
+
+static bool ramlog_bin_next(FAR struct ramlog_reader_s *rd)
+{
+  FAR struct ramlog_cpu_s *rc;
+  union ramlog_recbuf_u rec;
+  struct ramlog_rec_s hdr;
+  uint32_t sec = 0;
+  uint32_t nsec = 0;
+  int best;
+  int cpu;
+
+retry:
+  best = -1;
+
+  for (cpu = 0; cpu < RAMLOG_NCPUS; cpu++)
+    {
+      rc = &g_ramlog_cpu[cpu];
+
+      /* Skip over any records that were overwritten before we could read
+       * them.
+       */
+
+      if (!ramlog_bin_valid(rc, rd->rd_pos[cpu]))
+        {
+          rd->rd_pos[cpu] = rc->rc_tail;
+        }
+
+      if (rd->rd_pos[cpu] == rc->rc_head)
+        {
+          continue;
+        }
+
+      SP_DMB();
+      ramlog_bin_copyout(rc, rd->rd_pos[cpu], &hdr, sizeof(hdr));
+      if (!ramlog_bin_valid(rc, rd->rd_pos[cpu]))
+        {
+          goto retry;
+        }
+
+      if (best < 0 || hdr.rr_sec < sec ||
+          (hdr.rr_sec == sec && hdr.rr_nsec < nsec))
+        {
+          best = cpu;
+          sec  = hdr.rr_sec;
+          nsec = hdr.rr_nsec;
+        }
+    }
+
+  if (best < 0)
+    {
+      return false;
+    }
+
+  /* Copy the whole record and verify that it was not overwritten while we
+   * were copying it.
+   */
+
+  rc = &g_ramlog_cpu[best];
+  ramlog_bin_copyout(rc, rd->rd_pos[best], &rec.rb_hdr, sizeof(hdr));
+  if (rec.rb_hdr.rr_len < sizeof(hdr) ||
+      rec.rb_hdr.rr_len > CONFIG_RAMLOG_BINARY_RECSIZE)
+    {
+      goto retry;
+    }
+
+  ramlog_bin_copyout(rc, rd->rd_pos[best], rec.rb_bytes,
+                     rec.rb_hdr.rr_len);
+  if (!ramlog_bin_valid(rc, rd->rd_pos[best]))
+    {
+      goto retry;
+    }
+
+  rd->rd_pos[best] = ramlog_posadd(rd->rd_pos[best], rec.rb_hdr.rr_len,
+                                   CONFIG_RAMLOG_BUFSIZE);
+
+  /* Then format it */
+
+#ifdef CONFIG_RAMLOG_CRLF
+  {
+    FAR char *line = rd->rd_line;
+    size_t nline;
+    size_t ncr = 0;
+    size_t i;
+    size_t j;
+
+    /* Format into the beginning of the line buffer, dropping carriage
+     * returns and counting linefeeds.
+     */
+
+    nline = ramlog_format(&rec, line, RAMLOG_LINESIZE);
+    for (i = 0, j = 0; i < nline; i++)
+      {
+        if (line[i] != '\r')
+          {
+            ncr += line[i] == '\n';
+            line[j++] = line[i];
+          }
+      }
+
+    nline = j;
+    while (nline + ncr > RAMLOG_LINESIZE)
+      {
+        ncr -= line[--nline] == '\n';
+      }
+
+    /* Then pre-pend a carriage return before each linefeed, working
+     * backward from the end of the line.
+     */
+
+    rd->rd_nline = nline + ncr;
+    for (i = nline, j = nline + ncr; i > 0; )
+      {
+        line[--j] = line[--i];
+        if (line[i] == '\n')
+          {
+            line[--j] = '\r';
+          }
+      }
+  }
+#else
+  rd->rd_nline = ramlog_format(&rec, rd->rd_line, RAMLOG_LINESIZE);
+#endif
+
+  rd->rd_offset = 0;
+  return true;
+}
+#endif /* CONFIG_RAMLOG_BINARY */
+
+/****************************************************************************
+ * Name: ramlog_flush
+ ****************************************************************************/
+
+#ifdef CONFIG_RAMLOG_SYSLOG
+static int ramlog_flush(void)
+{
+#ifdef CONFIG_RAMLOG_BINARY
+  ramlog_bin_flushline();
+#endif
+  return OK;
+}
+#endif
+
+/****************************************************************************
+ * Name: ramlog_syslog_write
+ ****************************************************************************/
+
+#if defined(CONFIG_RAMLOG_SYSLOG) && defined(CONFIG_SYSLOG_WRITE)
+static ssize_t ramlog_syslog_write(FAR const char *buffer, size_t buflen)
+{
+  ramlog_addtext(&g_sysdev, buffer, buflen);
+  return buflen;
+}
+#endif
+
+/****************************************************************************
+ * Name: ramlog_pollnotify
+ ****************************************************************************/
+
+#ifndef CONFIG_DISABLE_POLL
+static void ramlog_pollnotify(FAR struct ramlog_dev_s *priv,
+                              pollevent_t eventset)
+{
+  FAR struct pollfd *fds;
+  irqstate_t flags;
+  int i;
+
+  /* This function may be called from an interrupt handler */
+
+  for (i = 0; i < CONFIG_RAMLOG_NPOLLWAITERS; i++)
+    {
+      flags = enter_critical_section();
+      fds = priv->rl_fds[i];
+      if (fds)
+        {
+          fds->revents |= (fds->events & eventset);
+          if (fds->revents != 0)
+            {
+              sem_post(fds->sem);
+            }
+        }
+      leave_critical_section(flags);
+    }
+}
+#else
+#  define ramlog_pollnotify(priv,event)
+#endif
+
+/****************************************************************************
+ * Name: ramlog_notify
+ *
+ * Description:
+ *   Wake up any readers waiting for data and notify poll/select waiters
+ *   that data is available.
+ *
+ ****************************************************************************/
+
+static void ramlog_notify(FAR struct ramlog_dev_s *priv)
+{
+#if !defined(CONFIG_RAMLOG_NONBLOCKING) || !defined(CONFIG_DISABLE_POLL)
+  irqstate_t flags;
+  int i;
+
+  /* Avoid the critical section in the common case that nobody is
+   * waiting.
+   */
+
+#ifndef CONFIG_RAMLOG_NONBLOCKING
+  i = priv->rl_nwaiters;
+#else
+  i = 0;
+#endif
+
+#ifndef CONFIG_DISABLE_POLL
+  {
+    int j;
+
+    for (j = 0; j < CONFIG_RAMLOG_NPOLLWAITERS; j++)
+      {
+        i |= priv->rl_fds[j] != NULL;
+      }
+  }
+#endif
+
+  if (i == 0)
+    {
+      return;
+    }
+
+  /* Are there threads waiting for read data? */
+
+  flags = enter_critical_section();
+#ifndef CONFIG_RAMLOG_NONBLOCKING
+  for (i = 0; i < priv->rl_nwaiters; i++)
+    {
+      /* Yes.. Notify all of the waiting readers that more data is available */
+
+      sem_post(&priv->rl_waitsem);
+    }
+#endif
+
+  /* Notify all poll/select waiters that they can read from the FIFO */
+
+  ramlog_pollnotify(priv, POLLIN);
+  leave_critical_section(flags);
+#endif
+}
+
+/****************************************************************************
+ * Name: ramlog_oldest
+ *
+ * Description:
+ *   Return the position of the oldest complete line in the text RAM log.
+ *   Once the buffer has wrapped, the oldest data still in the buffer is
+ *   normally the end of a line whose beginning has been overwritten.  That
+ *   partial line is skipped.  Must be called in a critical section.
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_RAMLOG_BINARY
+static uint32_t ramlog_oldest(FAR struct ramlog_dev_s *priv)
+{
+  uint32_t pos;
+  size_t i;
+
+  /* Nothing has been overwritten if the buffer has never been filled */
+
+  if (priv->rl_head < priv->rl_bufsize)
+    {
+      return 0;
+    }
+
+  pos = ramlog_posadd(priv->rl_head,
+                      RAMLOG_POSLIMIT(priv->rl_bufsize) - priv->rl_bufsize,
+                      priv->rl_bufsize);
+
+  /* Start after the first newline.  If there is none, the buffer holds
+   * part of one very long line; return all of it.
+   */
+
+  for (i = 0; i < priv->rl_bufsize; i++)
+    {
+      if (priv->rl_buffer[(pos + i) % priv->rl_bufsize] == '\n')
+        {
+          return ramlog_posadd(pos, i + 1, priv->rl_bufsize);
+        }
+    }
+
+  return pos;
+}
+#endif
+
+/****************************************************************************
+ * Name: ramlog_addbuf
+ *
+ * Description:
+ *   Add data to the text RAM log, overwriting the oldest data if the
+ *   buffer is full.  Readers that have not read the overwritten data yet
+ *   will skip over it.
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_RAMLOG_BINARY
+static void ramlog_addbuf(FAR struct ramlog_dev_s *priv,
+                          FAR const char *buffer, size_t buflen)
+{
+  irqstate_t flags;
+  uint32_t head;
+  size_t nskip = 0;
+  size_t ndx;
+  size_t nbytes;
+
+  /* Only the most recent rl_bufsize bytes can be retained */
+
+  if (buflen > priv->rl_bufsize)
+    {
+      nskip   = buflen - priv->rl_bufsize;
+      buffer += nskip;
+      buflen  = priv->rl_bufsize;
+    }
+
+  /* Disable interrupts (in case we are NOT called from interrupt handler) */
+
+  flags = enter_critical_section();
+
+  head   = ramlog_posadd(priv->rl_head, nskip, priv->rl_bufsize);
+  ndx    = head % priv->rl_bufsize;
+  nbytes = priv->rl_bufsize - ndx;
+  if (nbytes > buflen)
+    {
+      nbytes = buflen;
+    }
+
+  memcpy(&priv->rl_buffer[ndx], buffer, nbytes);
+  memcpy(priv->rl_buffer, buffer + nbytes, buflen - nbytes);
+
+  priv->rl_head = ramlog_posadd(head, buflen, priv->rl_bufsize);
+  leave_critical_section(flags);
+}
+#endif
+
+/****************************************************************************
+ * Name: ramlog_addtext
+ *
+ * Description:
+ *   Add text to the RAM log.  In the binary mode, the text is added as a
+ *   text record and carriage returns are handled when the record is read.
+ *
+ ****************************************************************************/
+
+static void ramlog_addtext(FAR struct ramlog_dev_s *priv,
+                           FAR const char *buffer, size_t buflen)
+{
+#if defined(CONFIG_RAMLOG_BINARY)
+  ramlog_bin_addtext(buffer, buflen);
+
+#elif defined(CONFIG_RAMLOG_CRLF)
+  size_t start;
+  size_t i;
+
+  /* Add the text between carriage returns and linefeeds in bulk.  Ignore
+   * carriage returns and pre-pend a carriage return before each linefeed.
+   */
+
+  for (start = 0, i = 0; i < buflen; i++)
+    {
+      if (buffer[i] == '\r' || buffer[i] == '\n')
+        {
+          if (i > start)
+            {
+              ramlog_addbuf(priv, &buffer[start], i - start);
+            }
+
+          if (buffer[i] == '\n')
+            {
+              ramlog_addbuf(priv, "\r\n", 2);
+            }
+
+          start = i + 1;
+        }
+    }
+
+  if (buflen > start)
+    {
+      ramlog_addbuf(priv, &buffer[start], buflen - start);
+    }
+
+#else
+  ramlog_addbuf(priv, buffer, buflen);
+#endif
+}
 
 /****************************************************************************
- * Name: ramlog_flush
+ * Name: ramlog_available
+ *
+ * Description:
+ *   Return true if there is data that this reader has not yet read.
+ *
  ****************************************************************************/
 
-#ifdef CONFIG_RAMLOG_SYSLOG
-static int ramlog_flush(void)
+#ifndef CONFIG_DISABLE_POLL
+static bool ramlog_available(FAR struct ramlog_dev_s *priv,
+                             FAR struct ramlog_reader_s *rd)
 {
-  return OK;
+#ifdef CONFIG_RAMLOG_BINARY
+  int cpu;
+
+  if (rd->rd_offset < rd->rd_nline)
+    {
+      return true;
+    }
+
+  for (cpu = 0; cpu < RAMLOG_NCPUS; cpu++)
+    {
+      if (rd->rd_pos[cpu] != g_ramlog_cpu[cpu].rc_head)
+        {
+          return true;
+        }
+    }
+
+  return false;
+#else
+  return rd->rd_pos != priv->rl_head;
+#endif
 }
 #endif
 
 /****************************************************************************
- * Name: ramlog_pollnotify
+ * Name: ramlog_copyout
+ *
+ * Description:
+ *   Copy data that this reader has not yet read into the user buffer.
+ *
+ * Returned Value:
+ *   The number of bytes copied; zero if there is no more data.
+ *
  ****************************************************************************/
 
-#ifndef CONFIG_DISABLE_POLL
-static void ramlog_pollnotify(FAR struct ramlog_dev_s *priv,
-                              pollevent_t eventset)
+static size_t ramlog_copyout(FAR struct ramlog_dev_s *priv,
+                             FAR struct ramlog_reader_s *rd,
+                             FAR char *buffer, size_t buflen)
 {
-  FAR struct pollfd *fds;
-  irqstate_t flags;
-  int i;
+#ifdef CONFIG_RAMLOG_BINARY
+  size_t nread = 0;
+  size_t nbytes;
 
-  /* This function may be called from an interrupt handler */
-
-  for (i = 0; i < CONFIG_RAMLOG_NPOLLWAITERS; i++)
+  while (nread < buflen)
     {
-      flags = enter_critical_section();
-      fds = priv->rl_fds[i];
-      if (fds)
+      /* Format the next record when the last one has been read */
+
+      if (rd->rd_offset >= rd->rd_nline && !ramlog_bin_next(rd))
         {
-          fds->revents |= (fds->events & eventset);
-          if (fds->revents != 0)
-            {
-              sem_post(fds->sem);
-            }
+          break;
         }
-      leave_critical_section(flags);
+
+      nbytes = rd->rd_nline - rd->rd_offset;
+      if (nbytes > buflen - nread)
+        {
+          nbytes = buflen - nread;
+        }
+
+      memcpy(&buffer[nread], &rd->rd_line[rd->rd_offset], nbytes);
+      rd->rd_offset += nbytes;
+      nread         += nbytes;
     }
-}
+
+  return nread;
 #else
-#  define ramlog_pollnotify(priv,event)
+  irqstate_t flags;
+  uint32_t head;
+  size_t navail;
+  size_t ndx;
+  size_t nbytes;
+
+  flags = enter_critical_section();
+
+  /* Has the writer overwritten data that we have not read yet?  If so,
+   * skip to the oldest complete line still in the buffer.
+   */
+
+  head   = priv->rl_head;
+  navail = ramlog_posdiff(head, rd->rd_pos, priv->rl_bufsize);
+  if (navail > priv->rl_bufsize)
+    {
+      rd->rd_pos = ramlog_oldest(priv);
+      navail     = ramlog_posdiff(head, rd->rd_pos, priv->rl_bufsize);
+    }
+
+  /* Copy the contiguous part of the available data */
+
+  ndx    = rd->rd_pos % priv->rl_bufsize;
+  nbytes = priv->rl_bufsize - ndx;
+  if (nbytes > navail)
+    {
+      nbytes = navail;
+    }
+
+  if (nbytes > buflen)
+    {
+      nbytes = buflen;
+    }
+
+  memcpy(buffer, &priv->rl_buffer[ndx], nbytes);
+  rd->rd_pos = ramlog_posadd(rd->rd_pos, nbytes, priv->rl_bufsize);
+
+  leave_critical_section(flags);
+  return nbytes;
 #endif
+}
 
 /****************************************************************************
- * Name: ramlog_addchar
+ * Name: ramlog_open
  ****************************************************************************/
 
-static int ramlog_addchar(FAR struct ramlog_dev_s *priv, char ch)
+static int ramlog_open(FAR struct file *filep)
 {
+  FAR struct inode *inode = filep->f_inode;
+  FAR struct ramlog_dev_s *priv;
+  FAR struct ramlog_reader_s *rd;
+#ifdef CONFIG_RAMLOG_BINARY
+  int cpu;
+#else
   irqstate_t flags;
-  size_t nexthead;
+#endif
 
-  /* Disable interrupts (in case we are NOT called from interrupt handler) */
+  /* Some sanity checking */
 
-  flags = enter_critical_section();
+  DEBUGASSERT(inode && inode->i_private);
+  priv = (FAR struct ramlog_dev_s *)inode->i_private;
+  UNUSED(priv);
+
+  /* Allocate a read position for this open file */
 
-  /* Calculate the write index AFTER the next byte is written */
+  rd = (FAR struct ramlog_reader_s *)
+    kmm_zalloc(sizeof(struct ramlog_reader_s));
 
-  nexthead = priv->rl_head + 1;
-  if (nexthead >= priv->rl_bufsize)
+  if (rd == NULL)
     {
-      nexthead = 0;
+      return -ENOMEM;
     }
 
-  /* Would the next write overflow the circular buffer? */
+  /* Start reading with the oldest record still in the buffer */
 
-  if (nexthead == priv->rl_tail)
+#ifdef CONFIG_RAMLOG_BINARY
+  for (cpu = 0; cpu < RAMLOG_NCPUS; cpu++)
     {
-      /* Yes... Return an indication that nothing was saved in the buffer. */
-
-      leave_critical_section(flags);
-      return -EBUSY;
+      rd->rd_pos[cpu] = g_ramlog_cpu[cpu].rc_tail;
     }
+#else
+  flags = enter_critical_section();
+  rd->rd_pos = ramlog_oldest(priv);
+  leave_critical_section(flags);
+#endif
+
+  filep->f_priv = rd;
+  return OK;
+}
 
-  /* No... copy the byte and re-enable interrupts */
+/****************************************************************************
+ * Name: ramlog_close
+ ****************************************************************************/
 
-  priv->rl_buffer[priv->rl_head] = ch;
-  priv->rl_head = nexthead;
-  leave_critical_section(flags);
+static int ramlog_close(FAR struct file *filep)
+{
+  DEBUGASSERT(filep->f_priv != NULL);
+
+  kmm_free(filep->f_priv);
+  filep->f_priv = NULL;
   return OK;
 }
 
@@ -279,22 +1513,23 @@ static ssize_t ramlog_read(FAR struct file *filep, FAR char *buffer, size_t len)
 {
   FAR struct inode *inode = filep->f_inode;
   FAR struct ramlog_dev_s *priv;
+  FAR struct ramlog_reader_s *rd;
   ssize_t nread;
-  char ch;
   int ret;
 
   /* Some sanity checking */
 
-  DEBUGASSERT(inode && inode->i_private);
+  DEBUGASSERT(inode && inode->i_private && filep->f_priv);
   priv = (FAR struct ramlog_dev_s *)inode->i_private;
+  rd   = (FAR struct ramlog_reader_s *)filep->f_priv;
 
-  /* If the circular buffer is empty, then wait for something to be written
-   * to it.  This function may NOT be called from an interrupt handler.
+  /* If there is no new data, then wait for something to be written.
+   * This function may NOT be called from an interrupt handler.
    */
 
   DEBUGASSERT(!up_interrupt_context());
 
-  /* Get exclusive access to the rl_tail index */
+  /* Get exclusive access to the read position */
 
   ret = sem_wait(&priv->rl_exclsem);
   if (ret < 0)
@@ -306,11 +1541,16 @@ static ssize_t ramlog_read(FAR struct file *filep, FAR char *buffer, size_t len)
 
   for (nread = 0; (size_t)nread < len; )
     {
-      /* Get the next byte from the buffer */
+      /* Get the next data from the buffer */
 
-      if (priv->rl_head == priv->rl_tail)
+      ret = ramlog_copyout(priv, rd, &buffer[nread], len - nread);
+      if (ret > 0)
+        {
+          nread += ret;
+        }
+      else
         {
-          /* The circular buffer is empty. */
+          /* There is no more data for this reader. */
 
 #ifdef CONFIG_RAMLOG_NONBLOCKING
           /* Return what we have (with zero mean the end-of-file) */
@@ -400,45 +1640,16 @@ static ssize_t ramlog_read(FAR struct file *filep, FAR char *buffer, size_t len)
             }
 #endif /* CONFIG_RAMLOG_NONBLOCKING */
         }
-      else
-        {
-          /* The circular buffer is not empty, get the next byte from the
-           * tail index.
-           */
-
-          ch = priv->rl_buffer[priv->rl_tail];
-
-          /* Increment the tail index and re-enable interrupts */
-
-          if (++priv->rl_tail >= priv->rl_bufsize)
-            {
-              priv->rl_tail = 0;
-            }
-
-          /* Add the character to the user buffer */
-
-          buffer[nread] = ch;
-          nread++;
-        }
     }
 
   /* Relinquish the mutual exclusion semaphore */
 
   sem_post(&priv->rl_exclsem);
 
-  /* Notify all poll/select waiters that they can write to the FIFO */
-
 #ifndef CONFIG_RAMLOG_NONBLOCKING
 errout_without_sem:
 #endif
 
-#ifndef CONFIG_DISABLE_POLL
-  if (nread > 0)
-    {
-      ramlog_pollnotify(priv, POLLOUT);
-    }
-#endif
-
   /* Return the number of characters actually read */
 
   return nread;
@@ -452,102 +1663,27 @@ static ssize_t ramlog_write(FAR struct file *filep, FAR const char *buffer, size
 {
   FAR struct inode *inode = filep->f_inode;
   FAR struct ramlog_dev_s *priv;
-  ssize_t nwritten;
-  char ch;
-  int ret;
 
   /* Some sanity checking */
 
   DEBUGASSERT(inode && inode->i_private);
   priv = (FAR struct ramlog_dev_s *)inode->i_private;
 
-  /* Loop until all of the bytes have been written.  This function may be
-   * called from an interrupt handler!  Semaphores cannot be used!
+  /* Add the data to the RAM log.  This function may be called from an
+   * interrupt handler!  Semaphores cannot be used!
    *
-   * The write logic only needs to modify the rl_head index.  Therefore,
-   * there is a difference in the way that rl_head and rl_tail are protected:
-   * rl_tail is protected with a semaphore; rl_tail is protected by disabling
-   * interrupts.
+   * If the buffer is full, the oldest data is overwritten.  So all of the
+   * data is always written.
    */
 
-  for (nwritten = 0; (size_t)nwritten < len; nwritten++)
-    {
-      /* Get the next character to output */
-
-      ch = buffer[nwritten];
-
-      /* Ignore carriage returns */
-
-#ifdef CONFIG_RAMLOG_CRLF
-      if (ch == '\r')
-        {
-          continue;
-        }
-
-      /* Pre-pend a carriage before a linefeed */
-
-      if (ch == '\n')
-        {
-          ret = ramlog_addchar(priv, '\r');
-          if (ret < 0)
-            {
-              /* The buffer is full and nothing was saved. Break out of the
-               * loop to return the number of bytes written up to this point.
-               * The data to be written is dropped on the floor.
-               */
-
-              break;
-            }
-        }
-#endif
-
-      /* Then output the character */
-
-      ret = ramlog_addchar(priv, ch);
-      if (ret < 0)
-        {
-          /* The buffer is full and nothing was saved. Break out of the
-           * loop to return the number of bytes written up to this point.
-           * The data to be written is dropped on the floor.
-           */
-
-          break;
-        }
-    }
-
-  /* Was anything written? */
-
-#if !defined(CONFIG_RAMLOG_NONBLOCKING) || !defined(CONFIG_DISABLE_POLL)
-  if (nwritten > 0)
+  if (len > 0)
     {
-      irqstate_t flags;
-#ifndef CONFIG_RAMLOG_NONBLOCKING
-      int i;
-#endif
-
-      /* Are there threads waiting for read data? */
-
-      flags = enter_critical_section();
-#ifndef CONFIG_RAMLOG_NONBLOCKING
-      for (i = 0; i < priv->rl_nwaiters; i++)
-        {
-          /* Yes.. Notify all of the waiting readers that more data is available */
-
-          sem_post(&priv->rl_waitsem);
-        }
-#endif
+      ramlog_addtext(priv, buffer, len);
 
-      /* Notify all poll/select waiters that they can write to the FIFO */
+      /* Notify waiting readers that data is available */
 
-      ramlog_pollnotify(priv, POLLIN);
-      leave_critical_section(flags);
+      ramlog_notify(priv);
     }
-#endif
-
-  /* We always have to return the number of bytes requested and NOT the
-   * number of bytes that were actually written.  Otherwise, callers
-   * will think that this is a short write and probably retry (causing
-   */
 
   return len;
 }
@@ -561,15 +1697,16 @@ int ramlog_poll(FAR struct file *filep, FAR struct pollfd *fds, bool setup)
 {
   FAR struct inode *inode = filep->f_inode;
   FAR struct ramlog_dev_s *priv;
+  FAR struct ramlog_reader_s *rd;
   pollevent_t eventset;
-  size_t ndx;
   int ret;
   int i;
 
   /* Some sanity checking */
 
-  DEBUGASSERT(inode && inode->i_private);
+  DEBUGASSERT(inode && inode->i_private && filep->f_priv);
   priv = (FAR struct ramlog_dev_s *)inode->i_private;
+  rd   = (FAR struct ramlog_reader_s *)filep->f_priv;
 
   /* Get exclusive access to the poll structures */
 
@@ -609,35 +1746,21 @@ int ramlog_poll(FAR struct file *filep, FAR struct pollfd *fds, bool setup)
           goto errout;
         }
 
-      /* Should immediately notify on any of the requested events?
-       * First, check if the xmit buffer is full.
+      /* Should immediately notify on any of the requested events?  Writing
+       * never blocks because the oldest data is overwritten when the buffer
+       * is full.
        */
 
-      eventset = 0;
-
-      ndx = priv->rl_head + 1;
-      if (ndx >= priv->rl_bufsize)
-        {
-          ndx = 0;
-        }
-
-      if (ndx != priv->rl_tail)
-       {
-         eventset |= POLLOUT;
-       }
+      eventset = POLLOUT;
 
-      /* Check if the receive buffer is empty */
+      /* Check if there is data that this reader has not yet read */
 
-      if (priv->rl_head != priv->rl_tail)
+      if (ramlog_available(priv, rd))
        {
          eventset |= POLLIN;
        }
 
-      if (eventset)
-        {
-          ramlog_pollnotify(priv, eventset);
-        }
-
+      ramlog_pollnotify(priv, eventset);
     }
   else if (fds->priv)
     {
@@ -782,8 +1905,35 @@ int ramlog_syslog_channel(void)
 #if defined(CONFIG_RAMLOG_CONSOLE) || defined(CONFIG_RAMLOG_SYSLOG)
 int ramlog_putc(int ch)
 {
-  FAR struct ramlog_dev_s *priv = &g_sysdev;
-  int ret;
+#ifdef CONFIG_RAMLOG_BINARY
+  FAR struct ramlog_cpu_s *rc;
+  irqstate_t flags;
+  bool eol = false;
+
+  /* Accumulate a line of text for this CPU and add it as one text record
+   * when it is complete.
+   */
+
+  flags = up_irq_save();
+  rc = &g_ramlog_cpu[ramlog_cpu()];
+  rc->rc_line[rc->rc_nline++] = (char)ch;
+
+  if (ch == '\n' || rc->rc_nline >= RAMLOG_TEXTSIZE)
+    {
+      ramlog_bin_addtext(rc->rc_line, rc->rc_nline);
+      rc->rc_nline = 0;
+      eol = true;
+    }
+
+  up_irq_restore(flags);
+
+  if (eol)
+    {
+      ramlog_notify(&g_sysdev);
+    }
+
+#else
+  char tmp = (char)ch;
 
 #ifdef CONFIG_RAMLOG_CRLF
   /* Ignore carriage returns.  But return success. */
@@ -797,33 +1947,140 @@ int ramlog_putc(int ch)
 
   if (ch == '\n')
     {
-      ret = ramlog_addchar(priv, '\r');
-      if (ret < 0)
-        {
-          /* The buffer is full and nothing was saved. */
-
-          goto errout;
-        }
+      ramlog_addbuf(&g_sysdev, "\r\n", 2);
+      return ch;
     }
 #endif
 
-  /* Add the character to the RAMLOG */
+  /* Add the character to the RAMLOG.  This never fails:  If the RAMLOG is
+   * full, the oldest data is overwritten.
+   */
+
+  ramlog_addbuf(&g_sysdev, &tmp, 1);
+#endif
+
+  return ch;
+}
+#endif
+
+/****************************************************************************
+ * Name: ramlog_vsyslog
+ *
+ * Description:
+ *   Add a binary record to the RAM log consisting of the format string
+ *   pointer and the values of the arguments.  Formatting is deferred until
+ *   the record is read.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_RAMLOG_BINARY
+int ramlog_vsyslog(FAR const IPTR char *fmt, va_list ap)
+{
+  union ramlog_recbuf_u rec;
+  FAR uint8_t *ptr = &rec.rb_bytes[sizeof(struct ramlog_rec_s)];
+  FAR const uint8_t *end = &rec.rb_bytes[CONFIG_RAMLOG_BINARY_RECSIZE];
+  struct ramlog_spec_s spec;
+  bool ok = true;
+  int i;
 
-  ret = ramlog_addchar(priv, ch);
-  if (ret >= 0)
+  rec.rb_hdr.rr_type = RAMLOG_REC_FORMAT;
+  rec.rb_hdr.rr_pad  = 0;
+  rec.rb_hdr.rr_fmt  = fmt;
+
+  /* Save the argument values in the order that they are consumed.  If the
+   * record fills up, the remaining arguments are not saved and the
+   * formatted output will be truncated at that point.
+   */
+
+  while (ok && ramlog_nextspec(fmt, &spec))
     {
-      /* Return the character added on success */
+      for (i = 0; ok && i < spec.rs_nstar; i++)
+        {
+          int star = va_arg(ap, int);
+          ok = ramlog_putarg(&ptr, end, &star, sizeof(int));
+        }
 
-      return ch;
+      switch (spec.rs_type)
+        {
+          case RAMLOG_ARG_INT:
+            {
+              int value = va_arg(ap, int);
+              ok = ok && ramlog_putarg(&ptr, end, &value, sizeof(int));
+            }
+            break;
+
+          case RAMLOG_ARG_LONG:
+            {
+              long value = va_arg(ap, long);
+              ok = ok && ramlog_putarg(&ptr, end, &value, sizeof(long));
+            }
+            break;
+
+          case RAMLOG_ARG_LLONG:
+            {
+              long long value = va_arg(ap, long long);
+              ok = ok && ramlog_putarg(&ptr, end, &value, sizeof(long long));
+            }
+            break;
+
+          case RAMLOG_ARG_PTR:
+          case RAMLOG_ARG_SKIP:
+            {
+              FAR void *value = va_arg(ap, FAR void *);
+              ok = ok && ramlog_putarg(&ptr, end, &value, sizeof(FAR void *));
+            }
+            break;
+
+          case RAMLOG_ARG_STR:
+            {
+              /* The string itself must be copied since it may not exist
+               * when the record is read.  Truncate it if necessary.
+               */
+
+              FAR const char *value = va_arg(ap, FAR const char *);
+              size_t len;
+
+              if (value == NULL)
+                {
+                  value = "(null)";
+                }
+
+              if (!ok || ptr >= end)
+                {
+                  ok = false;
+                  break;
+                }
+
+              len = strnlen(value, end - ptr - 1);
+              memcpy(ptr, value, len);
+              ptr[len] = '\0';
+              ptr += len + 1;
+            }
+            break;
+
+#ifdef CONFIG_LIBC_FLOATINGPOINT
+          case RAMLOG_ARG_DOUBLE:
+            {
+              double value = va_arg(ap, double);
+              ok = ok && ramlog_putarg(&ptr, end, &value, sizeof(double));
+            }
+            break;
+#endif
+
+          default:
+            break;
+        }
+
+      fmt = spec.rs_end;
     }
 
-  /* On a failure, we need to return EOF and set the errno so that
-   * work like all other putc-like functions.
-   */
+  rec.rb_hdr.rr_len = ptr - rec.rb_bytes;
+  ramlog_bin_commit(&rec);
 
-errout:
-  set_errno(-ret);
-  return EOF;
+  /* Notify waiting readers that data is available */
+
+  ramlog_notify(&g_sysdev);
+  return rec.rb_hdr.rr_len;
 }
 #endif
 
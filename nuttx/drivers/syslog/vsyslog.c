@@ -48,6 +48,7 @@
 #include <nuttx/clock.h>
 #include <nuttx/streams.h>
 #include <nuttx/syslog/syslog.h>
+#include <nuttx/syslog/ramlog.h>
 
 /****************************************************************************
  * Public Functions
@@ -73,7 +74,21 @@ int _vsyslog(int priority, FAR const IPTR char *fmt, FAR va_list *ap)
 
 #ifdef CONFIG_SYSLOG_TIMESTAMP
   struct timespec ts;
+#endif
+
+#ifdef CONFIG_RAMLOG_BINARY
+  /* Save the format and arguments in the binary RAM log.  Formatting is
+   * deferred until the RAM log is read.  Emergency output is still
+   * formatted now since it is forced out through the emergency stream.
+   */
 
+  if (priority != LOG_EMERG)
+    {
+      return ramlog_vsyslog(fmt, *ap);
+    }
+#endif
+
+#ifdef CONFIG_SYSLOG_TIMESTAMP
   /* Get the current time.  Since debug output may be generated very early
    * in the start-up sequence, hardware timer support may not yet be
    * available.
@@ -43,6 +43,7 @@
 #include <nuttx/config.h>
 
 #include <sys/types.h>
+#include <stdbool.h>
 #include <string.h>
 #include <aio.h>
 #include <queue.h>
@@ -63,6 +64,12 @@
 #  define CONFIG_FS_NAIOC 8
 #endif
 
+/* Maximum size of a merged transfer in a batch */
+
+#ifndef CONFIG_FS_AIO_MERGEMAX
+#  define CONFIG_FS_AIO_MERGEMAX 4096
+#endif
+
 #undef AIO_HAVE_FILEP
 #undef AIO_HAVE_PSOCK
 
@@ -106,6 +113,15 @@ struct aio_container_s
 #ifdef CONFIG_PRIORITY_INHERITANCE
   uint8_t aioc_prio;               /* Priority of the waiting task */
 #endif
+
+  /* Batched I/O.  The containers of a batch are linked through aioc_next
+   * and only the work structure of the first container is queued.
+   */
+
+  bool aioc_batched;               /* Part of a batch submitted by aio_submit() */
+  bool aioc_cancelled;             /* Batched I/O cancelled before it started */
+  FAR struct aio_container_s *aioc_next; /* Next container of the batch */
+  FAR struct aio_ring_s *aioc_ring;      /* Completion ring or NULL */
 };
 
 /****************************************************************************
@@ -187,6 +203,23 @@ void aio_unlock(void);
 
 FAR struct aio_container_s *aioc_alloc(void);
 
+/****************************************************************************
+ * Name: aioc_tryalloc
+ *
+ * Description:
+ *   Allocate a new AIO container, if one is available, without waiting.
+ *
+ * Input Parameters:
+ *   None
+ *
+ * Returned Value:
+ *   A reference to the allocated AIO container or NULL if there is no free
+ *   container.
+ *
+ ****************************************************************************/
+
+FAR struct aio_container_s *aioc_tryalloc(void);
+
 /****************************************************************************
  * Name: aioc_free
  *
@@ -223,6 +256,28 @@ void aioc_free(FAR struct aio_container_s *aioc);
 
 FAR struct aio_container_s *aio_contain(FAR struct aiocb *aiocbp);
 
+/****************************************************************************
+ * Name: aio_batchcontain
+ *
+ * Description:
+ *   Create and initialize a container for an AIO control block that will
+ *   be performed as part of a batch.  Unlike aio_contain(), the caller may
+ *   choose not to wait for a free container.
+ *
+ * Input Parameters:
+ *   aiocbp - The AIO control block pointer
+ *   wait   - True: Wait for a free container.  False: Fail with EAGAIN
+ *            if there is no free container.
+ *
+ * Returned Value:
+ *   A reference to the new AIO control block container.  NULL is returned
+ *   on failure with the errno value set appropriately.
+ *
+ ****************************************************************************/
+
+FAR struct aio_container_s *aio_batchcontain(FAR struct aiocb *aiocbp,
+                                             bool wait);
+
 /****************************************************************************
  * Name: aioc_decant
  *
@@ -277,6 +332,28 @@ int aio_queue(FAR struct aio_container_s *aioc, worker_t worker);
 
 int aio_signal(pid_t pid, FAR struct aiocb *aiocbp);
 
+/****************************************************************************
+ * Name: aio_notify and aio_sigpoll
+ *
+ * Description:
+ *   The two halves of aio_signal():  aio_notify() performs the notification
+ *   requested by aiocbp->aio_sigevent and aio_sigpoll() sends the SIGPOLL
+ *   signal that wakes up aio_suspend() and lio_listio().  A batch of I/O
+ *   performs aio_notify() for each request but only one aio_sigpoll().
+ *
+ * Input Parameters:
+ *   pid    - ID of the task to signal
+ *   aiocbp - Pointer to the asynchronous I/O state structure
+ *
+ * Returned Value:
+ *   Zero (OK) if the client was successfully signalled.  Otherwise, -1 is
+ *   returned and the errno is set appropriately.
+ *
+ ****************************************************************************/
+
+int aio_notify(pid_t pid, FAR struct aiocb *aiocbp);
+int aio_sigpoll(pid_t pid, FAR struct aiocb *aiocbp);
+
 #undef EXTERN
 #if defined(__cplusplus)
 }
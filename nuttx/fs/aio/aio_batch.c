@@ -0,0 +1,645 @@
+/****************************************************************************
+ * fs/aio/aio_batch.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <aio.h>
+#include <assert.h>
+#include <errno.h>
+#include <debug.h>
+
+#include <nuttx/kmalloc.h>
+#include <nuttx/spinlock.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/net/net.h>
+
+#include "aio/aio.h"
+
+#ifdef CONFIG_FS_AIO
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: aioc_isfile
+ *
+ * Description:
+ *   Return true if the I/O of the container is on a file (vs. a socket).
+ *
+ ****************************************************************************/
+
+static inline bool aioc_isfile(FAR struct aio_container_s *aioc)
+{
+#if defined(AIO_HAVE_FILEP) && defined(AIO_HAVE_PSOCK)
+  return aioc->aioc_aiocbp->aio_fildes < CONFIG_NFILE_DESCRIPTORS;
+#elif defined(AIO_HAVE_FILEP)
+  return true;
+#else
+  return false;
+#endif
+}
+
+/****************************************************************************
+ * Name: aio_batch_precedes
+ *
+ * Description:
+ *   Return true if the I/O in container 'a' should be performed before the
+ *   I/O in container 'b'.  The batch is grouped by file and ordered by
+ *   file offset so that adjacent requests can be merged.  I/O on a socket
+ *   keeps the order of submission.
+ *
+ ****************************************************************************/
+
+static bool aio_batch_precedes(FAR struct aio_container_s *a,
+                               FAR struct aio_container_s *b)
+{
+  if (a->u.ptr != b->u.ptr)
+    {
+      return (uintptr_t)a->u.ptr < (uintptr_t)b->u.ptr;
+    }
+
+  return aioc_isfile(a) &&
+         a->aioc_aiocbp->aio_offset < b->aioc_aiocbp->aio_offset;
+}
+
+/****************************************************************************
+ * Name: aio_batch_insert
+ *
+ * Description:
+ *   Add a container to a batch that has not yet been queued, keeping the
+ *   batch ordered by aio_batch_precedes().
+ *
+ ****************************************************************************/
+
+static void aio_batch_insert(FAR struct aio_container_s **head,
+                             FAR struct aio_container_s **tail,
+                             FAR struct aio_container_s *aioc)
+{
+  FAR struct aio_container_s *prev;
+
+  aioc->aioc_next = NULL;
+
+  /* Requests are most often submitted in order:  Check the tail first */
+
+  if (*tail == NULL)
+    {
+      *head = aioc;
+      *tail = aioc;
+    }
+  else if (!aio_batch_precedes(aioc, *tail))
+    {
+      (*tail)->aioc_next = aioc;
+      *tail = aioc;
+    }
+  else if (aio_batch_precedes(aioc, *head))
+    {
+      aioc->aioc_next = *head;
+      *head = aioc;
+    }
+  else
+    {
+      for (prev = *head;
+           !aio_batch_precedes(aioc, prev->aioc_next);
+           prev = prev->aioc_next);
+
+      aioc->aioc_next = prev->aioc_next;
+      prev->aioc_next = aioc;
+    }
+}
+
+/****************************************************************************
+ * Name: aio_batch_mergeable
+ *
+ * Description:
+ *   Return true if the file I/O in container 'next' continues the I/O in
+ *   container 'last' so that both can be performed as one transfer.
+ *
+ ****************************************************************************/
+
+static bool aio_batch_mergeable(FAR struct aio_container_s *last,
+                                FAR struct aio_container_s *next,
+                                size_t total)
+{
+  FAR struct aiocb *a = last->aioc_aiocbp;
+  FAR struct aiocb *b = next->aioc_aiocbp;
+
+  return !next->aioc_cancelled && next->u.ptr == last->u.ptr &&
+         aioc_isfile(next) &&
+         b->aio_lio_opcode == a->aio_lio_opcode &&
+         b->aio_offset == a->aio_offset + (off_t)a->aio_nbytes &&
+         total + b->aio_nbytes <= CONFIG_FS_AIO_MERGEMAX;
+}
+
+/****************************************************************************
+ * Name: aio_batch_xfer
+ *
+ * Description:
+ *   Perform one read or write transfer for the I/O in the container.
+ *
+ * Returned Value:
+ *   The number of bytes transferred or a negated errno value.
+ *
+ ****************************************************************************/
+
+static ssize_t aio_batch_xfer(FAR struct aio_container_s *aioc,
+                              FAR void *buf, size_t nbytes, off_t offset)
+{
+  FAR struct aiocb *aiocbp = aioc->aioc_aiocbp;
+  ssize_t ret = 0;
+
+#if defined(AIO_HAVE_FILEP) && defined(AIO_HAVE_PSOCK)
+  if (aioc_isfile(aioc))
+#endif
+#ifdef AIO_HAVE_FILEP
+    {
+      FAR struct file *filep = aioc->u.aioc_filep;
+
+      if (aiocbp->aio_lio_opcode == LIO_READ)
+        {
+          ret = file_pread(filep, buf, nbytes, offset);
+        }
+      else if ((filep->f_oflags & O_APPEND) != 0)
+        {
+          /* Append to the current file position */
+
+          ret = file_write(filep, buf, nbytes);
+        }
+      else
+        {
+          ret = file_pwrite(filep, buf, nbytes, offset);
+        }
+    }
+#endif
+#if defined(AIO_HAVE_FILEP) && defined(AIO_HAVE_PSOCK)
+  else
+#endif
+#ifdef AIO_HAVE_PSOCK
+    {
+      if (aiocbp->aio_lio_opcode == LIO_READ)
+        {
+          ret = psock_recv(aioc->u.aioc_psock, buf, nbytes, 0);
+        }
+      else
+        {
+          ret = psock_send(aioc->u.aioc_psock, buf, nbytes, 0);
+        }
+    }
+#endif
+
+  if (ret < 0)
+    {
+      int errcode = get_errno();
+      ferr("ERROR: I/O failed: %d\n", errcode);
+      DEBUGASSERT(errcode > 0);
+      ret = -errcode;
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: aio_batch_perform
+ *
+ * Description:
+ *   Perform the I/O of the containers from 'first' through 'last'.  If
+ *   there is more than one, the I/O is adjacent in the same file and is
+ *   performed as a single transfer, directly if the buffers are also
+ *   adjacent in memory, or else through a bounce buffer.
+ *
+ ****************************************************************************/
+
+static void aio_batch_perform(FAR struct aio_container_s *first,
+                              FAR struct aio_container_s *last,
+                              size_t total)
+{
+  FAR struct aio_container_s *aioc;
+  FAR struct aiocb *aiocbp;
+  FAR uint8_t *buffer;
+  FAR uint8_t *next;
+  bool contiguous;
+  bool isread;
+  ssize_t nxfer;
+  size_t nbytes;
+  size_t pos;
+
+  if (first != last)
+    {
+      /* Are the user buffers adjacent in memory, too? */
+
+      buffer     = (FAR uint8_t *)first->aioc_aiocbp->aio_buf;
+      next       = buffer;
+      contiguous = true;
+
+      for (aioc = first; ; aioc = aioc->aioc_next)
+        {
+          aiocbp = aioc->aioc_aiocbp;
+          if ((FAR uint8_t *)aiocbp->aio_buf != next)
+            {
+              contiguous = false;
+              break;
+            }
+
+          next += aiocbp->aio_nbytes;
+          if (aioc == last)
+            {
+              break;
+            }
+        }
+
+      if (!contiguous)
+        {
+          buffer = (FAR uint8_t *)kmm_malloc(total);
+        }
+
+      if (buffer != NULL)
+        {
+          isread = (first->aioc_aiocbp->aio_lio_opcode == LIO_READ);
+
+          /* Gather the write data into the bounce buffer */
+
+          if (!contiguous && !isread)
+            {
+              for (aioc = first, pos = 0; ; aioc = aioc->aioc_next)
+                {
+                  aiocbp = aioc->aioc_aiocbp;
+                  memcpy(&buffer[pos], (FAR const void *)aiocbp->aio_buf,
+                         aiocbp->aio_nbytes);
+                  pos += aiocbp->aio_nbytes;
+
+                  if (aioc == last)
+                    {
+                      break;
+                    }
+                }
+            }
+
+          nxfer = aio_batch_xfer(first, buffer, total,
+                                 first->aioc_aiocbp->aio_offset);
+
+          /* Distribute the result over the requests in file order.  A
+           * short transfer completes the leading requests.
+           */
+
+          for (aioc = first, pos = 0; ; aioc = aioc->aioc_next)
+            {
+              aiocbp = aioc->aioc_aiocbp;
+              if (nxfer < 0)
+                {
+                  aiocbp->aio_result = nxfer;
+                }
+              else
+                {
+                  nbytes = (size_t)nxfer - pos;
+                  if (nbytes > aiocbp->aio_nbytes)
+                    {
+                      nbytes = aiocbp->aio_nbytes;
+                    }
+
+                  if (!contiguous && isread && nbytes > 0)
+                    {
+                      memcpy((FAR void *)aiocbp->aio_buf, &buffer[pos],
+                             nbytes);
+                    }
+
+                  aiocbp->aio_result = nbytes;
+                  pos += nbytes;
+                }
+
+              if (aioc == last)
+                {
+                  break;
+                }
+            }
+
+          if (!contiguous)
+            {
+              kmm_free(buffer);
+            }
+
+          return;
+        }
+
+      /* There is no memory for the bounce buffer.  Perform the I/O one
+       * request at a time.
+       */
+    }
+
+  for (aioc = first; ; aioc = aioc->aioc_next)
+    {
+      aiocbp = aioc->aioc_aiocbp;
+      aiocbp->aio_result =
+        aio_batch_xfer(aioc, (FAR void *)aiocbp->aio_buf,
+                       aiocbp->aio_nbytes, aiocbp->aio_offset);
+
+      if (aioc == last)
+        {
+          break;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: aio_batch_complete
+ *
+ * Description:
+ *   Report the completion of one request of the batch:  Post it to the
+ *   completion ring, if any, and perform the notification requested by
+ *   the control block.
+ *
+ ****************************************************************************/
+
+static void aio_batch_complete(FAR struct aio_ring_s *ring, pid_t pid,
+                               FAR struct aiocb *aiocbp)
+{
+  uint32_t head;
+
+  if (ring != NULL)
+    {
+      /* The entry must be visible before the new head index */
+
+      head = ring->head;
+      if (head - ring->tail <= ring->mask)
+        {
+          ring->entries[head & ring->mask] = aiocbp;
+          SP_DMB();
+          ring->head = head + 1;
+        }
+      else
+        {
+          ring->overflow++;
+        }
+    }
+
+  (void)aio_notify(pid, aiocbp);
+}
+
+/****************************************************************************
+ * Name: aio_batch_worker
+ *
+ * Description:
+ *   This function executes on the worker thread and performs all of the
+ *   I/O of a batch.
+ *
+ * Input Parameters:
+ *   arg - Worker argument.  In this case, a pointer to the first container
+ *     of the batch cast to void *.
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+static void aio_batch_worker(FAR void *arg)
+{
+  FAR struct aio_container_s *aioc = (FAR struct aio_container_s *)arg;
+  FAR struct aio_container_s *last;
+  FAR struct aio_container_s *next;
+  FAR struct aio_container_s *tmp;
+  FAR struct aio_ring_s *ring;
+  FAR struct aiocb *aiocbp = NULL;
+  bool cancelled;
+  bool done;
+  size_t total = 0;
+  pid_t pid;
+#ifdef CONFIG_PRIORITY_INHERITANCE
+  uint8_t prio;
+#endif
+
+  DEBUGASSERT(aioc && aioc->aioc_batched);
+  pid  = aioc->aioc_pid;
+#ifdef CONFIG_PRIORITY_INHERITANCE
+  prio = aioc->aioc_prio;
+#endif
+  ring = aioc->aioc_ring;
+
+  while (aioc != NULL)
+    {
+      /* Take the next request and any adjacent requests that can be merged
+       * with it.  Once removed from the pending list, the I/O can no
+       * longer be cancelled.
+       */
+
+      aio_lock();
+      last      = aioc;
+      cancelled = aioc->aioc_cancelled;
+
+      if (!cancelled)
+        {
+          dq_rem(&aioc->aioc_link, &g_aio_pending);
+          total = aioc->aioc_aiocbp->aio_nbytes;
+
+          if (aioc_isfile(aioc))
+            {
+              while (last->aioc_next != NULL &&
+                     aio_batch_mergeable(last, last->aioc_next, total))
+                {
+                  last   = last->aioc_next;
+                  total += last->aioc_aiocbp->aio_nbytes;
+                  dq_rem(&last->aioc_link, &g_aio_pending);
+                }
+            }
+        }
+
+      aio_unlock();
+
+      /* Perform the I/O.  Cancelled I/O already has its result. */
+
+      if (!cancelled)
+        {
+          aio_batch_perform(aioc, last, total);
+        }
+
+      /* Report the completions and free the containers */
+
+      next = last->aioc_next;
+      do
+        {
+          tmp    = aioc->aioc_next;
+          done   = (aioc == last);
+          aiocbp = aioc->aioc_aiocbp;
+
+          aio_batch_complete(ring, pid, aiocbp);
+          aioc_free(aioc);
+          aioc   = tmp;
+        }
+      while (!done);
+
+      aioc = next;
+    }
+
+  /* Send one poll signal for the whole batch in case the caller is waiting
+   * in aio_suspend() or lio_listio().
+   */
+
+  if (aiocbp != NULL)
+    {
+      (void)aio_sigpoll(pid, aiocbp);
+    }
+
+#ifdef CONFIG_PRIORITY_INHERITANCE
+  /* Restore the low priority worker thread default priority */
+
+  lpwork_restorepriority(prio);
+#endif
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: aio_submit
+ *
+ * Description:
+ *   Non-standard.  Submit a list of asynchronous read and write requests
+ *   as a single batch.  The batch is performed by one invocation of the
+ *   low priority worker:  The requests are grouped by file and ordered by
+ *   offset, and runs of requests that are adjacent in the same file are
+ *   merged into a single transfer of up to CONFIG_FS_AIO_MERGEMAX bytes.
+ *   The order in which the requests are performed is unspecified, as for
+ *   lio_listio().
+ *
+ *   Each request completes as if submitted by aio_read() or aio_write()
+ *   and the notification requested by its aio_sigevent is performed, but
+ *   only one SIGPOLL signal is sent for each batch.  If 'ring' is not
+ *   NULL, each completed control block is also posted to that ring where
+ *   the application can collect it without a system call.
+ *
+ *   If more requests are submitted than there are free AIO containers, the
+ *   list is submitted as more than one batch.
+ *
+ * Input Parameters:
+ *   list - The list of I/O operations to be performed.  NULL entries and
+ *          entries with an aio_lio_opcode other than LIO_READ or LIO_WRITE
+ *          are ignored.
+ *   nent - The number of elements in the list
+ *   ring - The completion ring or NULL
+ *
+ * Returned Value:
+ *   The number of requests that were queued.  The aio_result of each
+ *   request that could not be queued is set to a negated errno value.
+ *   On failure, -1 is returned and the errno is set to EINVAL.
+ *
+ ****************************************************************************/
+
+int aio_submit(FAR struct aiocb *const list[], int nent,
+               FAR struct aio_ring_s *ring)
+{
+  FAR struct aio_container_s *head = NULL;
+  FAR struct aio_container_s *tail = NULL;
+  FAR struct aio_container_s *aioc;
+  FAR struct aiocb *aiocbp;
+  int nqueued = 0;
+  int i;
+
+  if (list == NULL || nent < 0 || (ring != NULL && ring->entries == NULL))
+    {
+      set_errno(EINVAL);
+      return ERROR;
+    }
+
+  for (i = 0; i < nent; i++)
+    {
+      aiocbp = list[i];
+      if (aiocbp == NULL ||
+          (aiocbp->aio_lio_opcode != LIO_READ &&
+           aiocbp->aio_lio_opcode != LIO_WRITE))
+        {
+          continue;
+        }
+
+      /* The result -EINPROGRESS means that the transfer has not yet
+       * completed
+       */
+
+      aiocbp->aio_result = -EINPROGRESS;
+      aiocbp->aio_priv   = NULL;
+
+      /* Create a container for the AIO control block.  The containers of
+       * a batch are only freed by the worker, so never wait for a free
+       * container while holding the containers of a batch that has not
+       * yet been queued.  Queue the batch first.
+       */
+
+      aioc = aio_batchcontain(aiocbp, head == NULL);
+      if (aioc == NULL && head != NULL && get_errno() == EAGAIN)
+        {
+          DEBUGVERIFY(aio_queue(head, aio_batch_worker));
+          head = NULL;
+          tail = NULL;
+
+          aioc = aio_batchcontain(aiocbp, true);
+        }
+
+      if (aioc == NULL)
+        {
+          /* The errno has already been set (probably EBADF) */
+
+          aiocbp->aio_result = -get_errno();
+          continue;
+        }
+
+      aioc->aioc_ring = ring;
+      aio_batch_insert(&head, &tail, aioc);
+      nqueued++;
+    }
+
+  /* Defer the batch to the worker thread */
+
+  if (head != NULL)
+    {
+      DEBUGVERIFY(aio_queue(head, aio_batch_worker));
+    }
+
+  return nqueued;
+}
+
+#endif /* CONFIG_FS_AIO */
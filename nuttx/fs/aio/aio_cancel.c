@@ -50,6 +50,60 @@
 
 #ifdef CONFIG_FS_AIO
 
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: aioc_cancel
+ *
+ * Description:
+ *   Attempt to cancel the I/O of one pending container and remove the
+ *   container from the list of pending transfers.  There are two
+ *   possibilities: (1) the work has already been started and is no longer
+ *   queued, or (2) the work has not been started and is still in the work
+ *   queue.  Only the second case can be canceled.
+ *
+ *   The container of batched I/O remains linked in its batch:  It is only
+ *   marked as cancelled and the batch worker will skip and free it.
+ *   Batched I/O is removed from the pending list when the batch worker
+ *   starts it, so any batched container that is still pending can be
+ *   cancelled.
+ *
+ * Input Parameters:
+ *   aioc - The container of the I/O to be cancelled
+ *
+ * Returned Value:
+ *   True if the I/O was cancelled.
+ *
+ * Assumptions:
+ *   The caller holds the AIO lock.
+ *
+ ****************************************************************************/
+
+static bool aioc_cancel(FAR struct aio_container_s *aioc)
+{
+  int status;
+
+  if (aioc->aioc_batched)
+    {
+      dq_rem(&aioc->aioc_link, &g_aio_pending);
+      aioc->aioc_cancelled = true;
+      return true;
+    }
+
+  /* work_cancel() will return -ENOENT if the work has already been
+   * started.
+   */
+
+  status = work_cancel(LPWORK, &aioc->aioc_work);
+
+  /* Remove the container from the list of pending transfers */
+
+  (void)aioc_decant(aioc);
+  return status >= 0;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -98,7 +152,6 @@ int aio_cancel(int fildes, FAR struct aiocb *aiocbp)
 {
   FAR struct aio_container_s *aioc;
   FAR struct aio_container_s *next;
-  int status;
   int ret;
 
   /* Check if a non-NULL aiocbp was provided */
@@ -129,16 +182,9 @@ int aio_cancel(int fildes, FAR struct aiocb *aiocbp)
 
           if (aioc)
             {
-              /* Yes... attempt to cancel the I/O.  There are two
-               * possibilities:* (1) the work has already been started and
-               * is no longer queued, or (2) the work has not been started
-               * and is still in the work queue.  Only the second case can
-               * be canceled.  work_cancel() will return -ENOENT in the
-               * first case.
-               */
-
-              status = work_cancel(LPWORK, &aioc->aioc_work);
-              if (status >= 0)
+              /* Yes... attempt to cancel the I/O */
+
+              if (aioc_cancel(aioc))
                 {
                   aiocbp->aio_result = -ECANCELED;
                   ret = AIO_CANCELED;
@@ -147,10 +193,6 @@ int aio_cancel(int fildes, FAR struct aiocb *aiocbp)
                 {
                   ret = AIO_NOTCANCELED;
                 }
-
-              /* Remove the container from the list of pending transfers */
-
-              (void)aioc_decant(aioc);
             }
         }
     }
@@ -173,23 +215,13 @@ int aio_cancel(int fildes, FAR struct aiocb *aiocbp)
 
           if (aioc)
             {
-              /* Yes... attempt to cancel the I/O.  There are two
-               * possibilities:* (1) the work has already been started and
-               * is no longer queued, or (2) the work has not been started
-               * and is still in the work queue.  Only the second case can
-               * be canceled.  work_cancel() will return -ENOENT in the
-               * first case.
-               */
-
-              status = work_cancel(LPWORK, &aioc->aioc_work);
-
-              /* Remove the container from the list of pending transfers */
+              /* Yes... attempt to cancel the I/O */
 
               next   = (FAR struct aio_container_s *)aioc->aioc_link.flink;
-              aiocbp = aioc_decant(aioc);
+              aiocbp = aioc->aioc_aiocbp;
               DEBUGASSERT(aiocbp);
 
-              if (status >= 0)
+              if (aioc_cancel(aioc))
                 {
                   aiocbp->aio_result = -ECANCELED;
                   if (ret != AIO_NOTCANCELED)
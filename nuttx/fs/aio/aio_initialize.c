@@ -235,6 +235,38 @@ FAR struct aio_container_s *aioc_alloc(void)
   return aioc;
 }
 
+/****************************************************************************
+ * Name: aioc_tryalloc
+ *
+ * Description:
+ *   Allocate a new AIO container, if one is available, without waiting.
+ *
+ * Input Parameters:
+ *   None
+ *
+ * Returned Value:
+ *   A reference to the allocated AIO container or NULL if there is no free
+ *   container.
+ *
+ ****************************************************************************/
+
+FAR struct aio_container_s *aioc_tryalloc(void)
+{
+  FAR struct aio_container_s *aioc;
+
+  if (sem_trywait(&g_aioc_freesem) < 0)
+    {
+      return NULL;
+    }
+
+  aio_lock();
+  aioc = (FAR struct aio_container_s *)dq_remfirst(&g_aioc_free);
+  aio_unlock();
+
+  DEBUGASSERT(aioc);
+  return aioc;
+}
+
 /****************************************************************************
  * Name: aioc_free
  *
@@ -56,10 +56,10 @@
  ****************************************************************************/
 
 /****************************************************************************
- * Name: aio_signal
+ * Name: aio_notify
  *
  * Description:
- *   Signal the client that an I/O has completed.
+ *   Perform the notification requested by aiocbp->aio_sigevent.
  *
  * Input Parameters:
  *   pid    - ID of the task to signal
@@ -67,27 +67,20 @@
  *            information about how to signal the client
  *
  * Returned Value:
- *   Zero (OK) if the client was successfully signalled.  Otherwise, a
- *   negated errno value is returned.
+ *   Zero (OK) if the client was successfully signalled.  Otherwise, -1 is
+ *   returned and the errno is set appropriately.
  *
  * Assumptions:
  *   This function runs only in the context of the worker thread.
  *
  ****************************************************************************/
 
-int aio_signal(pid_t pid, FAR struct aiocb *aiocbp)
+int aio_notify(pid_t pid, FAR struct aiocb *aiocbp)
 {
-#ifdef CONFIG_CAN_PASS_STRUCTS
-  union sigval value;
-#endif
-  int errcode;
   int status;
-  int ret;
 
   DEBUGASSERT(aiocbp);
 
-  ret = OK; /* Assume success */
-
   /* Signal the client */
 
   if (aiocbp->aio_sigevent.sigev_notify == SIGEV_SIGNAL)
@@ -101,9 +94,8 @@ int aio_signal(pid_t pid, FAR struct aiocb *aiocbp)
 #endif
       if (status < 0)
         {
-          errcode = get_errno();
-          ferr("ERROR: sigqueue #1 failed: %d\n", errcode);
-          ret = ERROR;
+          ferr("ERROR: sigqueue #1 failed: %d\n", get_errno());
+          return ERROR;
         }
     }
 
@@ -112,17 +104,46 @@ int aio_signal(pid_t pid, FAR struct aiocb *aiocbp)
 
   else if (aiocbp->aio_sigevent.sigev_notify == SIGEV_THREAD)
     {
-      ret = sig_notification(pid, &aiocbp->aio_sigevent);
-      if (ret < 0)
+      status = sig_notification(pid, &aiocbp->aio_sigevent);
+      if (status < 0)
         {
-          ferr("ERROR: sig_notification failed: %d\n", ret);
+          ferr("ERROR: sig_notification failed: %d\n", status);
+          set_errno(-status);
+          return ERROR;
         }
     }
 #endif
 
-  /* Send the poll signal in any event in case the caller is waiting
-   * on sig_suspend();
-   */
+  return OK;
+}
+
+/****************************************************************************
+ * Name: aio_sigpoll
+ *
+ * Description:
+ *   Send the SIGPOLL signal to the client in case the caller is waiting
+ *   in aio_suspend() or lio_listio().
+ *
+ * Input Parameters:
+ *   pid    - ID of the task to signal
+ *   aiocbp - Pointer to the asynchronous I/O state structure that is
+ *            passed with the signal
+ *
+ * Returned Value:
+ *   Zero (OK) if the client was successfully signalled.  Otherwise, -1 is
+ *   returned and the errno is set appropriately.
+ *
+ * Assumptions:
+ *   This function runs only in the context of the worker thread.
+ *
+ ****************************************************************************/
+
+int aio_sigpoll(pid_t pid, FAR struct aiocb *aiocbp)
+{
+#ifdef CONFIG_CAN_PASS_STRUCTS
+  union sigval value;
+#endif
+  int status;
 
 #ifdef CONFIG_CAN_PASS_STRUCTS
   value.sival_ptr = aiocbp;
@@ -130,10 +151,55 @@ int aio_signal(pid_t pid, FAR struct aiocb *aiocbp)
 #else
   status = sigqueue(pid, SIGPOLL, aiocbp);
 #endif
-  if (status && ret == OK)
+  if (status < 0)
+    {
+      ferr("ERROR: sigqueue #2 failed: %d\n", get_errno());
+      return ERROR;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: aio_signal
+ *
+ * Description:
+ *   Signal the client that an I/O has completed.
+ *
+ * Input Parameters:
+ *   pid    - ID of the task to signal
+ *   aiocbp - Pointer to the asynchronous I/O state structure that includes
+ *            information about how to signal the client
+ *
+ * Returned Value:
+ *   Zero (OK) if the client was successfully signalled.  Otherwise, a
+ *   negated errno value is returned.
+ *
+ * Assumptions:
+ *   This function runs only in the context of the worker thread.
+ *
+ ****************************************************************************/
+
+int aio_signal(pid_t pid, FAR struct aiocb *aiocbp)
+{
+  int errcode = 0;
+  int ret;
+
+  DEBUGASSERT(aiocbp);
+
+  ret = aio_notify(pid, aiocbp);
+  if (ret < 0)
+    {
+      errcode = get_errno();
+    }
+
+  /* Send the poll signal in any event in case the caller is waiting
+   * on sig_suspend();
+   */
+
+  if (aio_sigpoll(pid, aiocbp) < 0 && ret == OK)
     {
       errcode = get_errno();
-      ferr("ERROR: sigqueue #2 failed: %d\n", errcode);
       ret = ERROR;
     }
 
@@ -50,27 +50,28 @@
 #ifdef CONFIG_FS_AIO
 
 /****************************************************************************
- * Public Functions
+ * Private Functions
  ****************************************************************************/
 
 /****************************************************************************
- * Name: aio_contain
+ * Name: aio_containerize
  *
  * Description:
  *   Create and initialize a container for the provided AIO control block
  *
  * Input Parameters:
- *   aiocbp - The AIO control block pointer
+ *   aiocbp  - The AIO control block pointer
+ *   batched - True if the I/O will be performed as part of a batch
+ *   wait    - True: Wait for a free container
  *
  * Returned Value:
- *   A reference to the new AIO control block container.   This function
- *   will not fail but will wait if necessary for the resources to perform
- *   this operation.  NULL will be returned on certain errors with the
- *   errno value already set appropriately.
+ *   A reference to the new AIO control block container or NULL with the
+ *   errno value set appropriately.
  *
  ****************************************************************************/
 
-FAR struct aio_container_s *aio_contain(FAR struct aiocb *aiocbp)
+static FAR struct aio_container_s *
+  aio_containerize(FAR struct aiocb *aiocbp, bool batched, bool wait)
 {
   FAR struct aio_container_s *aioc;
   union
@@ -122,11 +123,23 @@ FAR struct aio_container_s *aio_contain(FAR struct aiocb *aiocbp)
 #endif
 
   /* Allocate the AIO control block container, waiting for one to become
-   * available if necessary.  This should never fail.
+   * available if necessary.  This should never fail if we wait.
    */
 
-  aioc = aioc_alloc();
-  DEBUGASSERT(aioc);
+  if (wait)
+    {
+      aioc = aioc_alloc();
+      DEBUGASSERT(aioc);
+    }
+  else
+    {
+      aioc = aioc_tryalloc();
+      if (!aioc)
+        {
+          set_errno(EAGAIN);
+          return NULL;
+        }
+    }
 
   /* Initialize the container */
 
@@ -134,6 +147,7 @@ FAR struct aio_container_s *aio_contain(FAR struct aiocb *aiocbp)
   aioc->aioc_aiocbp = aiocbp;
   aioc->u.ptr = u.ptr;
   aioc->aioc_pid = getpid();
+  aioc->aioc_batched = batched;
 
 #ifdef CONFIG_PRIORITY_INHERITANCE
   DEBUGVERIFY(sched_getparam (aioc->aioc_pid, &param));
@@ -148,6 +162,57 @@ FAR struct aio_container_s *aio_contain(FAR struct aiocb *aiocbp)
   return aioc;
 }
 
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: aio_contain
+ *
+ * Description:
+ *   Create and initialize a container for the provided AIO control block
+ *
+ * Input Parameters:
+ *   aiocbp - The AIO control block pointer
+ *
+ * Returned Value:
+ *   A reference to the new AIO control block container.   This function
+ *   will not fail but will wait if necessary for the resources to perform
+ *   this operation.  NULL will be returned on certain errors with the
+ *   errno value already set appropriately.
+ *
+ ****************************************************************************/
+
+FAR struct aio_container_s *aio_contain(FAR struct aiocb *aiocbp)
+{
+  return aio_containerize(aiocbp, false, true);
+}
+
+/****************************************************************************
+ * Name: aio_batchcontain
+ *
+ * Description:
+ *   Create and initialize a container for an AIO control block that will
+ *   be performed as part of a batch.  Unlike aio_contain(), the caller may
+ *   choose not to wait for a free container.
+ *
+ * Input Parameters:
+ *   aiocbp - The AIO control block pointer
+ *   wait   - True: Wait for a free container.  False: Fail with EAGAIN
+ *            if there is no free container.
+ *
+ * Returned Value:
+ *   A reference to the new AIO control block container.  NULL is returned
+ *   on failure with the errno value set appropriately.
+ *
+ ****************************************************************************/
+
+FAR struct aio_container_s *aio_batchcontain(FAR struct aiocb *aiocbp,
+                                             bool wait)
+{
+  return aio_containerize(aiocbp, true, wait);
+}
+
 /****************************************************************************
  * Name: aioc_decant
  *
@@ -62,6 +62,7 @@
 #include <nuttx/kmalloc.h>
 #include <nuttx/fs/fs.h>
 #include <nuttx/fs/fat.h>
+#include <nuttx/fs/ioctl.h>
 #include <nuttx/fs/dirent.h>
 
 #include "inode/inode.h"
@@ -1293,6 +1294,17 @@ static int fat_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
       return ret;
     }
 
+  /* The position of the directory entry identifies the file */
+
+  if (cmd == FIOC_FILEID && arg != 0)
+    {
+      *(FAR uintptr_t *)((uintptr_t)arg) =
+        (uintptr_t)ff->ff_dirsector * DIRSEC_NDIRS(fs) + ff->ff_dirindex;
+
+      fat_semgive(fs);
+      return OK;
+    }
+
   /* ioctl calls are just passed through to the contained block driver */
 
   fat_semgive(fs);
@@ -1397,6 +1409,26 @@ static int fat_sync(FAR struct file *filep)
 
       fs->fs_dirty = true;
       ret          = fat_updatefsinfo(fs);
+      if (ret < 0)
+        {
+          goto errout_with_semaphore;
+        }
+
+      /* Let the block driver write any state that it caches (such as the
+       * sector map of a log-structured FTL) so that the file data survives
+       * a loss of power.  Block drivers that cache nothing do not support
+       * this command.
+       */
+
+      inode = fs->fs_blkdriver;
+      if (inode->u.i_bops->ioctl)
+        {
+          ret = inode->u.i_bops->ioctl(inode, BIOC_FLUSH, 0);
+          if (ret == -ENOTTY || ret == -ENOSYS || ret == -EINVAL)
+            {
+              ret = OK;
+            }
+        }
     }
 
 errout_with_semaphore:
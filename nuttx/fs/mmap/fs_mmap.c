@@ -67,7 +67,9 @@
  *        system that maps files contiguously on the media should support
  *        this ioctl. (vs. file system that scatter files over the media
  *        in non-contiguous sectors).  As of this writing, ROMFS is the
- *        only file system that meets this requirement.
+ *        only such file system on block media.  TMPFS also supports this
+ *        ioctl by gathering the file into a contiguous image in RAM that
+ *        is shared by all openers of the file.
  *     b. The underlying block driver supports the BIOC_XIPBASE ioctl
  *        command that maps the underlying media to a randomly accessible
  *        address. At  present, only the RAM/ROM disk driver does this.
@@ -47,6 +47,7 @@
 #include <assert.h>
 #include <debug.h>
 
+#include <nuttx/sched.h>
 #include <nuttx/kmalloc.h>
 
 #include "inode/inode.h"
@@ -92,8 +93,9 @@
  *
  *   2. If CONFIG_FS_RAMMAP is defined in the configuration, then mmap() will
  *      support simulation of memory mapped files by copying files whole
- *      into RAM.  munmap() is required in this case to free the allocated
- *      memory holding the shared copy of the file.
+ *      into RAM.  munmap() is required in this case to release the mapping.
+ *      The memory holding the shared copy of the file is freed when its
+ *      last mapping is released.
  *
  * Parameters:
  *   start   The start address of the mapping to delete.  For this
@@ -110,14 +112,18 @@
 
 int munmap(FAR void *start, size_t length)
 {
-  FAR struct fs_rammap_s *prev;
-  FAR struct fs_rammap_s *curr;
+  FAR struct task_group_s *group = sched_self()->group;
+  FAR struct fs_rammapref_s *prev;
+  FAR struct fs_rammapref_s *curr;
+  FAR struct fs_rammap_s *map;
   FAR void *newaddr;
-  unsigned int offset;
+  size_t offset;
   int ret;
   int errcode;
 
-  /* Find a region containing this start and length in the list of regions */
+  /* Find a mapping by this task group containing this start and length in
+   * the list of mappings.
+   */
 
   rammap_initialize();
   ret = sem_wait(&g_rammaps.exclsem);
@@ -126,20 +132,21 @@ int munmap(FAR void *start, size_t length)
       return ERROR;
     }
 
-  /* Seach the list of regions */
+  /* Seach the list of mappings */
 
-  for (prev = NULL, curr = g_rammaps.head; curr; prev = curr, curr = curr->flink)
+  for (prev = NULL, curr = g_rammaps.refs; curr; prev = curr, curr = curr->flink)
     {
-      /* Does this region include any part of the specified range? */
+      /* Does this mapping include any part of the specified range? */
 
-      if ((uintptr_t)start < (uintptr_t)curr->addr + curr->length &&
+      if (curr->group == group &&
+          (uintptr_t)start < (uintptr_t)curr->addr + curr->length &&
           (uintptr_t)start + length >= (uintptr_t)curr->addr)
         {
           break;
         }
     }
 
-  /* Did we find the region */
+  /* Did we find the mapping */
 
   if (!curr)
     {
@@ -148,14 +155,14 @@ int munmap(FAR void *start, size_t length)
       goto errout_with_semaphore;
     }
 
-  /* Get the offset from the beginning of the region and the actual number
-   * of bytes to "unmap".  All mappings must extend to the end of the region.
-   * There is no support for free a block of memory but leaving a block of
-   * memory at the end.  This is a consequence of using kumm_realloc() to
-   * simulate the unmapping.
+  /* Get the offset from the beginning of the mapping and the actual number
+   * of bytes to "unmap".  All mappings must extend to the end of the
+   * mapping.  There is no support for free a block of memory but leaving a
+   * block of memory at the end.  This is a consequence of using
+   * kumm_realloc() to simulate the unmapping.
    */
 
-  offset = start - curr->addr;
+  offset = (uintptr_t)start - (uintptr_t)curr->addr;
   if (offset + length < curr->length)
     {
       ferr("ERROR: Cannot umap without unmapping to the end\n");
@@ -163,41 +170,38 @@ int munmap(FAR void *start, size_t length)
       goto errout_with_semaphore;
     }
 
-  /* Okay.. the region is beging umapped to the end.  Make sure the length
-   * indicates that.
-   */
-
-  length = curr->length - offset;
-
-  /* Are we unmapping the entire region (offset == 0)? */
+  /* Are we unmapping the entire mapping (offset == 0)? */
 
-  if (length >= curr->length)
+  if (offset == 0)
     {
-      /* Yes.. remove the mapping from the list */
+      /* Yes.. remove the mapping.  The region is freed when its last
+       * mapping is removed.
+       */
 
-      if (prev)
-        {
-          prev->flink = curr->flink;
-        }
-      else
-        {
-          g_rammaps.head = curr->flink;
-        }
-
-      /* Then free the region */
-
-      kumm_free(curr);
+      rammap_unref(prev, curr);
     }
 
   /* No.. We have been asked to "unmap' only a portion of the memory
-   * (offset > 0).
+   * (offset > 0).  The memory can be released only if this is the only
+   * mapping of the region and it extends to the end of the region.
    */
 
   else
     {
-      newaddr = kumm_realloc(curr->addr, sizeof(struct fs_rammap_s) + length);
-      DEBUGASSERT(newaddr == (FAR void *)(curr->addr));
-      curr->length = length;
+      map          = curr->map;
+      curr->length = offset;
+
+      if (map->crefs == 1 &&
+          (FAR uint8_t *)curr->addr + offset <
+          (FAR uint8_t *)map->addr + map->length)
+        {
+          map->length = (FAR uint8_t *)curr->addr + offset -
+                        (FAR uint8_t *)map->addr;
+          newaddr = kumm_realloc(map, sizeof(struct fs_rammap_s) +
+                                 map->length);
+          DEBUGASSERT(newaddr == (FAR void *)map);
+          UNUSED(newaddr);
+        }
     }
 
   sem_post(&g_rammaps.exclsem);
@@ -42,12 +42,17 @@
 #include <sys/types.h>
 #include <sys/mman.h>
 
+#include <stdint.h>
 #include <string.h>
 #include <unistd.h>
+#include <assert.h>
 #include <errno.h>
 #include <debug.h>
 
+#include <nuttx/sched.h>
 #include <nuttx/kmalloc.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/fs/ioctl.h>
 
 #include "inode/inode.h"
 #include "fs_rammap.h"
@@ -62,6 +67,71 @@
 
 struct fs_allmaps_s g_rammaps;
 
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: rammap_find
+ *
+ * Description:
+ *   Find a region that already holds the requested part of the file.  The
+ *   caller must hold g_rammaps.exclsem.
+ *
+ ****************************************************************************/
+
+static FAR struct fs_rammap_s *rammap_find(FAR struct inode *inode,
+                                           uintptr_t fileid, off_t offset,
+                                           size_t length)
+{
+  FAR struct fs_rammap_s *curr;
+
+  for (curr = g_rammaps.head; curr; curr = curr->flink)
+    {
+      if (curr->shared && curr->inode == inode && curr->fileid == fileid &&
+          offset >= curr->offset &&
+          offset + length <= curr->offset + curr->length)
+        {
+          return curr;
+        }
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: rammap_addref
+ *
+ * Description:
+ *   Add a mapping of a region to the list of mappings.  The caller must
+ *   hold g_rammaps.exclsem.
+ *
+ * Returned Value:
+ *   The address of the mapping or NULL if the region already has the
+ *   maximum number of mappings.
+ *
+ ****************************************************************************/
+
+static FAR void *rammap_addref(FAR struct fs_rammapref_s *ref,
+                               FAR struct fs_rammap_s *map,
+                               size_t length, off_t offset)
+{
+  if (map->crefs >= UINT16_MAX)
+    {
+      return NULL;
+    }
+
+  ref->map    = map;
+  ref->group  = sched_self()->group;
+  ref->addr   = (FAR uint8_t *)map->addr + (offset - map->offset);
+  ref->length = length;
+  ref->flink  = g_rammaps.refs;
+
+  g_rammaps.refs = ref;
+  map->crefs++;
+  return ref->addr;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -94,6 +164,8 @@ void rammap_initialize(void)
  *
  * Description:
  *   Support simulation of memory mapped files by copying files into RAM.
+ *   If the same part of the same file is already mapped, the existing
+ *   region is shared.
  *
  * Parameters:
  *   fd      file descriptor of the backing file -- required.
@@ -111,32 +183,105 @@ void rammap_initialize(void)
  *       'length' or 'offset' are invalid
  *     ENOMEM
  *       Insufficient memory is available to map the file.
+ *     EMFILE
+ *       The same part of the file already has the maximum number of
+ *       mappings.
  *
  ****************************************************************************/
 
 FAR void *rammap(int fd, size_t length, off_t offset)
 {
+  FAR struct fs_rammapref_s *ref;
   FAR struct fs_rammap_s *map;
+  FAR struct fs_rammap_s *curr;
+  FAR struct inode *inode;
+  FAR struct file *filep;
   FAR uint8_t *alloc;
   FAR uint8_t *rdbuffer;
+  FAR void *addr;
+  uintptr_t fileid = 0;
+  uint32_t gen = 0;
   ssize_t nread;
   off_t fpos;
+  bool shared = true;
   int errcode;
   int ret;
 
-  /* There is a major design flaw that I have not yet thought of fix for:
-   * The goal is to have a single region of memory that represents a single
-   * file and can be shared by many threads.  That is, given a filename a
-   * thread should be able to open the file, get a file descriptor, and
-   * call mmap() to get a memory region.  Different file descriptors opened
-   * with the same file path should get the same memory region when mapped.
-   *
-   * The design flaw is that I don't have sufficient knowledge to know that
-   * these different file descriptors map to the same file.  So, for the time
-   * being, a new memory region is created each time that rammap() is called.
-   * Not very useful!
+  /* Get the inode of the file.  Different file descriptors opened on the
+   * same file are recognized by the inode of the driver or, for a file in
+   * a mounted file system, by the mountpoint inode plus a file ID that is
+   * provided by the file system.  If the file system cannot identify the
+   * file, the region is not shared.
    */
 
+  filep = fs_getfilep(fd);
+  if (filep == NULL)
+    {
+      return MAP_FAILED;
+    }
+
+  inode = filep->f_inode;
+  DEBUGASSERT(inode != NULL);
+
+#ifndef CONFIG_DISABLE_MOUNTPOINT
+  if (INODE_IS_MOUNTPT(inode))
+    {
+      errcode = get_errno();
+      ret = file_ioctl(filep, FIOC_FILEID,
+                       (unsigned long)((uintptr_t)&fileid));
+      if (ret < 0)
+        {
+          set_errno(errcode);
+          shared = false;
+        }
+    }
+#endif
+
+  /* Allocate the mapping */
+
+  ref = (FAR struct fs_rammapref_s *)
+    kmm_malloc(sizeof(struct fs_rammapref_s));
+  if (ref == NULL)
+    {
+      errcode = ENOMEM;
+      goto errout;
+    }
+
+  /* Is this part of the file already mapped? */
+
+  rammap_initialize();
+  ret = sem_wait(&g_rammaps.exclsem);
+  if (ret < 0)
+    {
+      errcode = get_errno();
+      goto errout_with_ref;
+    }
+
+  if (shared)
+    {
+      curr = rammap_find(inode, fileid, offset, length);
+      if (curr != NULL)
+        {
+          addr = rammap_addref(ref, curr, length, offset);
+          sem_post(&g_rammaps.exclsem);
+          if (addr == NULL)
+            {
+              errcode = EMFILE;
+              goto errout_with_ref;
+            }
+
+          return addr;
+        }
+
+      /* Remember the generation so that a modification of the file while
+       * it is being read can be detected.
+       */
+
+      gen = g_rammaps.gen;
+    }
+
+  sem_post(&g_rammaps.exclsem);
+
   /* Allocate a region of memory of the specified size */
 
   alloc = (FAR uint8_t *)kumm_malloc(sizeof(struct fs_rammap_s) + length);
@@ -144,7 +289,7 @@ FAR void *rammap(int fd, size_t length, off_t offset)
     {
       ferr("ERROR: Region allocation failed, length: %d\n", (int)length);
       errcode = ENOMEM;
-      goto errout;
+      goto errout_with_ref;
     }
 
   /* Initialize the region */
@@ -154,6 +299,9 @@ FAR void *rammap(int fd, size_t length, off_t offset)
   map->addr   = alloc + sizeof(struct fs_rammap_s);
   map->length = length;
   map->offset = offset;
+  map->inode  = inode;
+  map->fileid = fileid;
+  map->shared = shared;
 
   /* Seek to the specified file offset */
 
@@ -217,30 +365,266 @@ FAR void *rammap(int fd, size_t length, off_t offset)
 
   memset(rdbuffer, 0, length);
 
-  /* Add the buffer to the list of regions */
+  /* Add the buffer to the list of regions, unless another thread mapped
+   * the same part of the file while we were reading it.
+   */
 
-  rammap_initialize();
   ret = sem_wait(&g_rammaps.exclsem);
   if (ret < 0)
     {
       goto errout_with_errno;
     }
 
-  map->flink  = g_rammaps.head;
+  if (shared)
+    {
+      curr = rammap_find(inode, fileid, offset, map->length);
+      if (curr != NULL)
+        {
+          addr = rammap_addref(ref, curr, map->length, offset);
+          sem_post(&g_rammaps.exclsem);
+          if (addr == NULL)
+            {
+              errcode = EMFILE;
+              goto errout_with_region;
+            }
+
+          kumm_free(alloc);
+          return addr;
+        }
+
+      /* If a file was modified while this one was being read, then the
+       * copy may already be stale and must not be shared.
+       */
+
+      if (g_rammaps.gen != gen)
+        {
+          map->shared = false;
+        }
+      else
+        {
+          g_rammaps.nshared++;
+        }
+    }
+
+  /* The region holds a reference on the inode so that the inode cannot be
+   * reused for a different file system or driver while it is mapped.
+   */
+
+  inode_addref(inode);
+
+  map->flink     = g_rammaps.head;
   g_rammaps.head = map;
 
+  addr = rammap_addref(ref, map, map->length, offset);
   sem_post(&g_rammaps.exclsem);
-  return map->addr;
+  return addr;
 
 errout_with_region:
   kumm_free(alloc);
+errout_with_ref:
+  kmm_free(ref);
 errout:
   set_errno(errcode);
   return MAP_FAILED;
 
 errout_with_errno:
   kumm_free(alloc);
+  kmm_free(ref);
   return MAP_FAILED;
 }
 
+/****************************************************************************
+ * Name: rammap_unref
+ *
+ * Description:
+ *   Remove one mapping from the list of mappings and free it.  The region
+ *   is freed when its last mapping is removed.  The caller must hold
+ *   g_rammaps.exclsem.
+ *
+ * Parameters:
+ *   prev    The mapping before 'ref' in the list of mappings (or NULL)
+ *   ref     The mapping to be removed
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void rammap_unref(FAR struct fs_rammapref_s *prev,
+                  FAR struct fs_rammapref_s *ref)
+{
+  FAR struct fs_rammap_s *map = ref->map;
+  FAR struct fs_rammap_s *curr;
+  FAR struct fs_rammap_s *mprev;
+
+  /* Remove the mapping from the list of mappings */
+
+  if (prev)
+    {
+      prev->flink = ref->flink;
+    }
+  else
+    {
+      g_rammaps.refs = ref->flink;
+    }
+
+  kmm_free(ref);
+
+  /* Was that the last mapping of the region? */
+
+  DEBUGASSERT(map->crefs > 0);
+  if (--map->crefs > 0)
+    {
+      return;
+    }
+
+  /* Yes.. remove the region from the list of regions */
+
+  for (mprev = NULL, curr = g_rammaps.head;
+       curr && curr != map;
+       mprev = curr, curr = curr->flink);
+
+  DEBUGASSERT(curr != NULL);
+  if (mprev)
+    {
+      mprev->flink = map->flink;
+    }
+  else
+    {
+      g_rammaps.head = map->flink;
+    }
+
+  /* Then release the inode and free the region */
+
+  if (map->shared)
+    {
+      DEBUGASSERT(g_rammaps.nshared > 0);
+      g_rammaps.nshared--;
+    }
+
+  inode_release(map->inode);
+  kumm_free(map);
+}
+
+/****************************************************************************
+ * Name: rammap_invalidate
+ *
+ * Description:
+ *   Stop sharing the regions that hold a copy of a file after the file has
+ *   been modified.  Existing mappings of those regions are not affected,
+ *   but later mappings of the file read it again.
+ *
+ * Parameters:
+ *   inode   The driver or mountpoint inode of the file
+ *   filep   The modified file.  If NULL, the regions of all files in the
+ *           file system are no longer shared.
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void rammap_invalidate(FAR struct inode *inode, FAR struct file *filep)
+{
+  FAR struct fs_rammap_s *curr;
+  uintptr_t fileid = 0;
+  bool all = false;
+  int errcode;
+
+  /* Let a region that is being read now know that it may be stale */
+
+  g_rammaps.gen++;
+
+  /* Nothing more to do if no region is shared */
+
+  if (g_rammaps.nshared == 0)
+    {
+      return;
+    }
+
+#ifndef CONFIG_DISABLE_MOUNTPOINT
+  if (INODE_IS_MOUNTPT(inode))
+    {
+      /* Identify the file in the file system, if possible */
+
+      all = true;
+      if (filep != NULL)
+        {
+          errcode = get_errno();
+          if (file_ioctl(filep, FIOC_FILEID,
+                         (unsigned long)((uintptr_t)&fileid)) >= 0)
+            {
+              all = false;
+            }
+
+          set_errno(errcode);
+        }
+    }
+#endif
+
+  while (sem_wait(&g_rammaps.exclsem) < 0)
+    {
+      DEBUGASSERT(get_errno() == EINTR);
+    }
+
+  for (curr = g_rammaps.head; curr; curr = curr->flink)
+    {
+      if (curr->shared && curr->inode == inode &&
+          (all || curr->fileid == fileid))
+        {
+          curr->shared = false;
+          g_rammaps.nshared--;
+        }
+    }
+
+  sem_post(&g_rammaps.exclsem);
+}
+
+/****************************************************************************
+ * Name: rammap_release
+ *
+ * Description:
+ *   Release all of the mappings that belong to a task group.  This is
+ *   called when the task group exits.
+ *
+ * Parameters:
+ *   group   The task group that is exiting
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void rammap_release(FAR struct task_group_s *group)
+{
+  FAR struct fs_rammapref_s *prev;
+  FAR struct fs_rammapref_s *curr;
+  FAR struct fs_rammapref_s *next;
+
+  if (!g_rammaps.initialized)
+    {
+      return;
+    }
+
+  while (sem_wait(&g_rammaps.exclsem) < 0)
+    {
+      DEBUGASSERT(get_errno() == EINTR);
+    }
+
+  for (prev = NULL, curr = g_rammaps.refs; curr; curr = next)
+    {
+      next = curr->flink;
+      if (curr->group == group)
+        {
+          rammap_unref(prev, curr);
+        }
+      else
+        {
+          prev = curr;
+        }
+    }
+
+  sem_post(&g_rammaps.exclsem);
+}
+
 #endif /* CONFIG_FS_RAMMAP */
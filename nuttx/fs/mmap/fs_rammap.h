@@ -45,6 +45,8 @@
 #include <nuttx/config.h>
 
 #include <sys/types.h>
+#include <stdbool.h>
+#include <stdint.h>
 #include <semaphore.h>
 
 #ifdef CONFIG_FS_RAMMAP
@@ -62,12 +64,19 @@
  * This copied file has many of the properties of a standard memory mapped
  * file except:
  *
- * - All of the file must be present in memory.  This limits the size of
- *   files that may be memory mapped (especially on MCUs with no significant
- *   RAM resources).
+ * - All of the mapped part of the file must be present in memory.  This
+ *   limits the size of files that may be memory mapped (especially on MCUs
+ *   with no significant RAM resources).
  * - All mapped files are read-only.  You can write to the in-memory image,
  *   but the file contents will not change.
  * - There are not access privileges.
+ *
+ * A region is shared by all mappings of the same part of the same file if
+ * the file can be identified:  By the driver inode for a driver or by the
+ * mountpoint inode and the FIOC_FILEID ioctl for a file in a file system.
+ * A region is no longer shared once the file has been written or
+ * truncated, or once a file in the same file system has been unlinked or
+ * renamed (after which its FIOC_FILEID may be reused by another file).
  */
 
 struct fs_rammap_s
@@ -76,15 +85,36 @@ struct fs_rammap_s
   FAR void           *addr;        /* Start of allocated memory */
   size_t              length;      /* Length of region */
   off_t               offset;      /* File offset */
+  FAR struct inode   *inode;       /* Driver or mountpoint inode (held) */
+  uintptr_t           fileid;      /* Identifies the file in the file system */
+  bool                shared;      /* True: The file identity is known */
+  uint16_t            crefs;       /* Number of mappings (<= UINT16_MAX) */
+};
+
+/* This structure describes one mapping returned by mmap().  Each mapping
+ * holds one reference on a region and belongs to the task group that
+ * created it so that it can be released when the group exits.
+ */
+
+struct fs_rammapref_s
+{
+  struct fs_rammapref_s   *flink;  /* Implements a singly linked list */
+  FAR struct fs_rammap_s  *map;    /* The mapped region */
+  FAR struct task_group_s *group;  /* The task group that owns the mapping */
+  FAR void                *addr;   /* The address returned by mmap() */
+  size_t                   length; /* The length of the mapping */
 };
 
 /* This structure defines all "mapped" files */
 
 struct fs_allmaps_s
 {
-  bool                initialized; /* True: This structure has been initialized */
-  sem_t               exclsem;     /* Provides exclusive access the list */
-  struct fs_rammap_s *head;        /* List of mapped files */
+  bool                   initialized; /* True: This structure has been initialized */
+  volatile uint16_t      nshared;     /* Number of shared regions */
+  volatile uint32_t      gen;         /* Incremented when a file is modified */
+  sem_t                  exclsem;     /* Provides exclusive access the list */
+  struct fs_rammap_s    *head;        /* List of mapped files */
+  struct fs_rammapref_s *refs;        /* List of all mappings */
 };
 
 /****************************************************************************
@@ -120,6 +150,8 @@ void rammap_initialize(void);
  *
  * Description:
  *   Support simulation of memory mapped files by copying files into RAM.
+ *   If the same part of the same file is already mapped, the existing
+ *   region is shared.
  *
  * Parameters:
  *   fd      file descriptor of the backing file -- required.
@@ -142,5 +174,25 @@ void rammap_initialize(void);
 
 FAR void *rammap(int fd, size_t length, off_t offset);
 
+/****************************************************************************
+ * Name: rammap_unref
+ *
+ * Description:
+ *   Remove one mapping from the list of mappings and free it.  The region
+ *   is freed when its last mapping is removed.  The caller must hold
+ *   g_rammaps.exclsem.
+ *
+ * Parameters:
+ *   prev    The mapping before 'ref' in the list of mappings (or NULL)
+ *   ref     The mapping to be removed
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void rammap_unref(FAR struct fs_rammapref_s *prev,
+                  FAR struct fs_rammapref_s *ref);
+
 #endif /* CONFIG_FS_RAMMAP */
 #endif /* __FS_MMAP_RAMMAP_H */
@@ -52,6 +52,10 @@
 #include <nuttx/mtd/mtd.h>
 #include <nuttx/fs/nxffs.h>
 
+#ifdef CONFIG_NXFFS_GC
+#  include <nuttx/wqueue.h>
+#endif
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
@@ -184,6 +188,19 @@
 
 #define NXFFS_NERASED             128
 
+/* The hash bucket in the in-memory inode index that holds a name hash */
+
+#ifdef CONFIG_NXFFS_INDEX
+#  define NXFFS_HBUCKET(h)        ((h) % CONFIG_NXFFS_INDEX_NBUCKETS)
+#endif
+
+/* An incremental packing step that stops between two inodes covers the
+ * FLASH up to the next inode with a deleted inode header.  This is the
+ * smallest gap that can be covered in this way.
+ */
+
+#define NXFFS_MINFILLER           (SIZEOF_NXFFS_INODE_HDR + SIZEOF_NXFFS_DATA_HDR + 1)
+
 /* Quasi-standard definitions */
 
 #ifndef MIN
@@ -283,6 +300,20 @@ struct nxffs_wrfile_s
   uint32_t                  crc;        /* Accumulated data block CRC */
 };
 
+/* This structure describes one valid inode in the in-memory inode index.
+ * Only the hash of the inode name is held in memory; the name itself is
+ * verified by reading the inode header from FLASH.
+ */
+
+#ifdef CONFIG_NXFFS_INDEX
+struct nxffs_hnode_s
+{
+  FAR struct nxffs_hnode_s *flink;     /* Next inode in the hash bucket */
+  uint32_t                  hash;      /* Hash of the inode name */
+  off_t                     hoffset;   /* FLASH offset to the inode header */
+};
+#endif
+
 /* This structure represents the overall state of on NXFFS instance. */
 
 struct nxffs_volume_s
@@ -301,6 +332,23 @@ struct nxffs_volume_s
   FAR struct nxffs_ofile_s *ofiles;    /* A singly-linked list of open files */
   FAR uint8_t              *cache;     /* On cached erase block for general I/O */
   FAR uint8_t              *pack;      /* A full erase block to support packing */
+#ifdef CONFIG_NXFFS_INDEX
+  bool                      idxvalid;  /* True: The inode index is complete */
+  off_t                     nfiles;    /* Number of valid inodes */
+  off_t                     nused;     /* FLASH bytes used by valid inodes */
+
+  /* The in-memory inode index:  Valid inodes hashed by name */
+
+  FAR struct nxffs_hnode_s *index[CONFIG_NXFFS_INDEX_NBUCKETS];
+#endif
+#ifdef CONFIG_NXFFS_GC
+  struct work_s             gcwork;    /* Schedules background packing */
+  bool                      gcstop;    /* True: The volume is not mounted */
+  bool                      gcdirty;   /* True: Inodes were deleted */
+  off_t                     gcoffset;  /* Resume offset of the packing sweep */
+  off_t                     gcend;     /* End of the FLASH being reclaimed */
+  off_t                     gcblock;   /* Next erase block to be reclaimed */
+#endif
 };
 
 /* This structure describes the state of the blocks on the NXFFS volume */
@@ -363,6 +411,9 @@ extern struct nxffs_volume_s g_volume;
  *   data is written, or (2) recalculated as part of the file system packing
  *   operation.
  *
+ *   The in-memory inode index is rebuilt with the valid inodes that are
+ *   found.
+ *
  * Input Parameters:
  *   volume - Identifies the NXFFS volume
  *
@@ -621,7 +672,8 @@ int nxffs_nextentry(FAR struct nxffs_volume_s *volume, off_t offset,
  * Description:
  *   Search for an inode with the provided name starting with the first
  *   valid inode and proceeding to the end FLASH or until the matching
- *   inode is found.
+ *   inode is found.  If CONFIG_NXFFS_INDEX is enabled, the in-memory inode
+ *   index is used instead to find the inode.
  *
  * Input Parameters:
  *   volume - Describes the NXFFS volume
@@ -666,6 +718,153 @@ int nxffs_findinode(FAR struct nxffs_volume_s *volume, FAR const char *name,
 off_t nxffs_inodeend(FAR struct nxffs_volume_s *volume,
                      FAR struct nxffs_entry_s *entry);
 
+/****************************************************************************
+ * Name: nxffs_hashname
+ *
+ * Description:
+ *   Return the hash of an inode name that is used to locate the inode in
+ *   the in-memory inode index.
+ *
+ * Input Parameters:
+ *   name - The inode name.
+ *
+ * Returned Value:
+ *   The hash value.
+ *
+ * Defined in nxffs_index.c
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXFFS_INDEX
+uint32_t nxffs_hashname(FAR const char *name);
+#endif
+
+/****************************************************************************
+ * Name: nxffs_idxreset
+ *
+ * Description:
+ *   Discard the content of the in-memory inode index and start a new,
+ *   empty index.  The index is then populated with nxffs_idxadd() as the
+ *   valid inodes are found on FLASH.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *
+ * Returned Value:
+ *   None
+ *
+ * Defined in nxffs_index.c
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXFFS_INDEX
+void nxffs_idxreset(FAR struct nxffs_volume_s *volume);
+#else
+#  define nxffs_idxreset(v)
+#endif
+
+/****************************************************************************
+ * Name: nxffs_idxbuild
+ *
+ * Description:
+ *   Rebuild the in-memory inode index by searching FLASH for all valid
+ *   inodes.  This is only necessary if the index can no longer be trusted,
+ *   for example after a failure in the middle of the packing operation.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *
+ * Returned Value:
+ *   None
+ *
+ * Defined in nxffs_index.c
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXFFS_INDEX
+void nxffs_idxbuild(FAR struct nxffs_volume_s *volume);
+#else
+#  define nxffs_idxbuild(v)
+#endif
+
+/****************************************************************************
+ * Name: nxffs_idxadd
+ *
+ * Description:
+ *   Add a valid inode to the in-memory inode index.  This is done when the
+ *   inode is found at initialization time and when the inode header of a
+ *   new file is written.  If memory for the index cannot be allocated, the
+ *   index is discarded and the inodes will be searched for on FLASH.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *   entry  - Describes the inode.
+ *
+ * Returned Value:
+ *   None
+ *
+ * Defined in nxffs_index.c
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXFFS_INDEX
+void nxffs_idxadd(FAR struct nxffs_volume_s *volume,
+                  FAR const struct nxffs_entry_s *entry);
+#else
+#  define nxffs_idxadd(v,e)
+#endif
+
+/****************************************************************************
+ * Name: nxffs_idxremove
+ *
+ * Description:
+ *   Remove an inode that has been marked deleted from the in-memory inode
+ *   index.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *   entry  - Describes the inode.
+ *
+ * Returned Value:
+ *   None
+ *
+ * Defined in nxffs_index.c
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXFFS_INDEX
+void nxffs_idxremove(FAR struct nxffs_volume_s *volume,
+                     FAR const struct nxffs_entry_s *entry);
+#else
+#  define nxffs_idxremove(v,e)
+#endif
+
+/****************************************************************************
+ * Name: nxffs_idxmove
+ *
+ * Description:
+ *   The packing logic has moved an inode.  Update the FLASH offset to the
+ *   inode header in the in-memory inode index.
+ *
+ * Input Parameters:
+ *   volume  - Describes the NXFFS volume
+ *   hoffset - The old FLASH offset to the inode header
+ *   entry   - Describes the inode at its new location.
+ *
+ * Returned Value:
+ *   None
+ *
+ * Defined in nxffs_index.c
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXFFS_INDEX
+void nxffs_idxmove(FAR struct nxffs_volume_s *volume, off_t hoffset,
+                   FAR const struct nxffs_entry_s *entry);
+#else
+#  define nxffs_idxmove(v,o,e)
+#endif
+
 /****************************************************************************
  * Name: nxffs_verifyblock
  *
@@ -1059,6 +1258,57 @@ int nxffs_rminode(FAR struct nxffs_volume_s *volume, FAR const char *name);
 
 int nxffs_pack(FAR struct nxffs_volume_s *volume);
 
+/****************************************************************************
+ * Name: nxffs_packstep
+ *
+ * Description:
+ *   Perform one step of an incremental packing sweep.  The sweep starts at
+ *   the first gap between inodes and resumes where the previous step
+ *   stopped.  Each step rewrites at most 'neblocks' erase blocks.  On
+ *   return, volume->gcoffset is non-zero if the sweep is not yet complete.
+ *
+ *   The caller must hold the volume exclsem and there must be no open
+ *   files on the volume.
+ *
+ * Input Parameters:
+ *   volume   - The volume to be packed.
+ *   neblocks - The maximum number of erase blocks to rewrite.
+ *
+ * Returned Values:
+ *   Zero on success; Otherwise, a negated errno value is returned to
+ *   indicate the nature of the failure.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXFFS_GC
+int nxffs_packstep(FAR struct nxffs_volume_s *volume, int neblocks);
+#endif
+
+/****************************************************************************
+ * Name: nxffs_gcschedule
+ *
+ * Description:
+ *   Schedule background packing of the volume on the low-priority work
+ *   queue if a packing sweep is in progress or if inodes have been deleted
+ *   and the erased FLASH at the end of the volume has fallen below the
+ *   reserve.  The caller must hold the volume exclsem.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *
+ * Returned Value:
+ *   None
+ *
+ * Defined in nxffs_gc.c
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXFFS_GC
+void nxffs_gcschedule(FAR struct nxffs_volume_s *volume);
+#else
+#  define nxffs_gcschedule(v)
+#endif
+
 /****************************************************************************
  * Standard mountpoint operation methods
  *
@@ -0,0 +1,165 @@
+/****************************************************************************
+ * fs/nxffs/nxffs_gc.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <semaphore.h>
+#include <errno.h>
+#include <debug.h>
+
+#include <nuttx/clock.h>
+#include <nuttx/wqueue.h>
+
+#include "nxffs.h"
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxffs_gcneeded
+ *
+ * Description:
+ *   Return true if a packing sweep is in progress or should be started:
+ *   Inodes have been deleted and less than the reserve of erased FLASH
+ *   remains at the end of the volume.
+ *
+ ****************************************************************************/
+
+static bool nxffs_gcneeded(FAR struct nxffs_volume_s *volume)
+{
+  off_t nfree;
+
+  if (volume->gcoffset > 0)
+    {
+      return true;
+    }
+
+  nfree = volume->nblocks * volume->geo.blocksize - volume->froffset;
+  return volume->gcdirty &&
+         nfree < (off_t)CONFIG_NXFFS_GC_RESERVE * volume->geo.erasesize;
+}
+
+/****************************************************************************
+ * Name: nxffs_gcworker
+ *
+ * Description:
+ *   Perform one step of background packing on the low-priority work queue.
+ *   The step is deferred while the volume is in use and is re-queued until
+ *   the packing sweep is complete.
+ *
+ ****************************************************************************/
+
+static void nxffs_gcworker(FAR void *arg)
+{
+  FAR struct nxffs_volume_s *volume = (FAR struct nxffs_volume_s *)arg;
+  int ret;
+
+  /* Don't wait for the volume.  If it is busy, try again later. */
+
+  if (sem_trywait(&volume->exclsem) < 0)
+    {
+      (void)work_queue(LPWORK, &volume->gcwork, nxffs_gcworker, volume,
+                       MSEC2TICK(CONFIG_NXFFS_GC_DELAY));
+      return;
+    }
+
+  /* Packing moves inodes, so it cannot be done while files are open.
+   * Closing the last file will schedule the packing again.  Packing
+   * stopped by an unmount resumes when the volume is mounted again.
+   */
+
+  if (!volume->gcstop && volume->ofiles == NULL && nxffs_gcneeded(volume))
+    {
+      if (volume->gcoffset == 0)
+        {
+          finfo("Starting sweep, froffset: %d\n", volume->froffset);
+          volume->gcdirty = false;
+        }
+
+      ret = nxffs_packstep(volume, CONFIG_NXFFS_GC_NBLOCKS);
+      if (ret < 0)
+        {
+          ferr("ERROR: Packing step failed: %d\n", -ret);
+          volume->gcoffset = 0;
+          volume->gcend    = 0;
+        }
+      else if (volume->gcoffset > 0)
+        {
+          /* Continue with the next step as soon as the work queue is
+           * available.
+           */
+
+          (void)work_queue(LPWORK, &volume->gcwork, nxffs_gcworker, volume, 0);
+        }
+    }
+
+  sem_post(&volume->exclsem);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxffs_gcschedule
+ *
+ * Description:
+ *   Schedule background packing of the volume on the low-priority work
+ *   queue if a packing sweep is in progress or if inodes have been deleted
+ *   and the erased FLASH at the end of the volume has fallen below the
+ *   reserve.  The caller must hold the volume exclsem.
+ *
+ * Input Parameters:
+ *   volume - Describes the NXFFS volume
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void nxffs_gcschedule(FAR struct nxffs_volume_s *volume)
+{
+  if (!volume->gcstop && volume->ofiles == NULL && nxffs_gcneeded(volume) &&
+      work_available(&volume->gcwork))
+    {
+      (void)work_queue(LPWORK, &volume->gcwork, nxffs_gcworker, volume,
+                       MSEC2TICK(CONFIG_NXFFS_GC_DELAY));
+    }
+}
@@ -0,0 +1,304 @@
+/****************************************************************************
+ * fs/nxffs/nxffs_index.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <string.h>
+#include <crc32.h>
+#include <errno.h>
+#include <debug.h>
+
+#include <nuttx/kmalloc.h>
+
+#include "nxffs.h"
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxffs_idxsize
+ *
+ * Description:
+ *   Return the number of FLASH bytes used by an inode:  The inode header,
+ *   the inode name, and the inode data with (at least) one data header per
+ *   I/O block.  The value does not depend on the location of the inode so
+ *   that it is not changed when the inode is moved by the packing logic.
+ *
+ ****************************************************************************/
+
+static off_t nxffs_idxsize(FAR struct nxffs_volume_s *volume,
+                           FAR const struct nxffs_entry_s *entry)
+{
+  uint16_t maxsize;
+  off_t size;
+
+  size = SIZEOF_NXFFS_INODE_HDR + strlen(entry->name) + entry->datlen;
+  if (entry->datlen > 0)
+    {
+      maxsize = volume->geo.blocksize - SIZEOF_NXFFS_BLOCK_HDR -
+                SIZEOF_NXFFS_DATA_HDR;
+      size   += ((entry->datlen + maxsize - 1) / maxsize) *
+                SIZEOF_NXFFS_DATA_HDR;
+    }
+
+  return size;
+}
+
+/****************************************************************************
+ * Name: nxffs_idxfree
+ *
+ * Description:
+ *   Free all nodes of the in-memory inode index.
+ *
+ ****************************************************************************/
+
+static void nxffs_idxfree(FAR struct nxffs_volume_s *volume)
+{
+  FAR struct nxffs_hnode_s *hnode;
+  FAR struct nxffs_hnode_s *next;
+  int i;
+
+  for (i = 0; i < CONFIG_NXFFS_INDEX_NBUCKETS; i++)
+    {
+      for (hnode = volume->index[i]; hnode; hnode = next)
+        {
+          next = hnode->flink;
+          kmm_free(hnode);
+        }
+
+      volume->index[i] = NULL;
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxffs_hashname
+ *
+ * Description:
+ *   Return the hash of an inode name that is used to locate the inode in
+ *   the in-memory inode index.
+ *
+ ****************************************************************************/
+
+uint32_t nxffs_hashname(FAR const char *name)
+{
+  return crc32((FAR const uint8_t *)name, strlen(name));
+}
+
+/****************************************************************************
+ * Name: nxffs_idxreset
+ *
+ * Description:
+ *   Discard the content of the in-memory inode index and start a new,
+ *   empty index.
+ *
+ ****************************************************************************/
+
+void nxffs_idxreset(FAR struct nxffs_volume_s *volume)
+{
+  nxffs_idxfree(volume);
+
+  volume->idxvalid = true;
+  volume->nfiles   = 0;
+  volume->nused    = 0;
+}
+
+/****************************************************************************
+ * Name: nxffs_idxbuild
+ *
+ * Description:
+ *   Rebuild the in-memory inode index by searching FLASH for all valid
+ *   inodes.
+ *
+ ****************************************************************************/
+
+void nxffs_idxbuild(FAR struct nxffs_volume_s *volume)
+{
+  struct nxffs_entry_s entry;
+  off_t offset;
+
+  nxffs_idxreset(volume);
+
+  offset = volume->inoffset;
+  while (nxffs_nextentry(volume, offset, &entry) == OK)
+    {
+      nxffs_idxadd(volume, &entry);
+
+      offset = nxffs_inodeend(volume, &entry);
+      nxffs_freeentry(&entry);
+    }
+
+  finfo("%d inodes, %d bytes\n", volume->nfiles, volume->nused);
+}
+
+/****************************************************************************
+ * Name: nxffs_idxadd
+ *
+ * Description:
+ *   Add a valid inode to the in-memory inode index.
+ *
+ ****************************************************************************/
+
+void nxffs_idxadd(FAR struct nxffs_volume_s *volume,
+                  FAR const struct nxffs_entry_s *entry)
+{
+  FAR struct nxffs_hnode_s *hnode;
+  uint32_t hash;
+  int ndx;
+
+  /* The file counts are kept even if the index itself could not be
+   * allocated.
+   */
+
+  volume->nfiles++;
+  volume->nused += nxffs_idxsize(volume, entry);
+
+  if (!volume->idxvalid)
+    {
+      return;
+    }
+
+  hnode = (FAR struct nxffs_hnode_s *)kmm_malloc(sizeof(struct nxffs_hnode_s));
+  if (!hnode)
+    {
+      /* Without a complete index, nxffs_findinode() cannot trust a failed
+       * look-up.  Discard the index and fall back to searching FLASH.
+       */
+
+      fwarn("WARNING: Failed to allocate index node, index disabled\n");
+      nxffs_idxfree(volume);
+      volume->idxvalid = false;
+      return;
+    }
+
+  hash           = nxffs_hashname(entry->name);
+  ndx            = NXFFS_HBUCKET(hash);
+
+  hnode->hash    = hash;
+  hnode->hoffset = entry->hoffset;
+  hnode->flink   = volume->index[ndx];
+  volume->index[ndx] = hnode;
+}
+
+/****************************************************************************
+ * Name: nxffs_idxremove
+ *
+ * Description:
+ *   Remove an inode that has been marked deleted from the in-memory inode
+ *   index.
+ *
+ ****************************************************************************/
+
+void nxffs_idxremove(FAR struct nxffs_volume_s *volume,
+                     FAR const struct nxffs_entry_s *entry)
+{
+  FAR struct nxffs_hnode_s *prev;
+  FAR struct nxffs_hnode_s *hnode;
+  FAR struct nxffs_hnode_s **head;
+
+  DEBUGASSERT(volume->nfiles > 0);
+  volume->nfiles--;
+  volume->nused -= nxffs_idxsize(volume, entry);
+
+  if (!volume->idxvalid)
+    {
+      return;
+    }
+
+  /* Find the inode in its hash bucket */
+
+  head = &volume->index[NXFFS_HBUCKET(nxffs_hashname(entry->name))];
+  for (prev = NULL, hnode = *head;
+       hnode && hnode->hoffset != entry->hoffset;
+       prev = hnode, hnode = hnode->flink);
+
+  if (hnode)
+    {
+      if (prev)
+        {
+          prev->flink = hnode->flink;
+        }
+      else
+        {
+          *head = hnode->flink;
+        }
+
+      kmm_free(hnode);
+    }
+  else
+    {
+      ferr("ERROR: Inode at %d not in index\n", entry->hoffset);
+    }
+}
+
+/****************************************************************************
+ * Name: nxffs_idxmove
+ *
+ * Description:
+ *   The packing logic has moved an inode.  Update the FLASH offset to the
+ *   inode header in the in-memory inode index.
+ *
+ ****************************************************************************/
+
+void nxffs_idxmove(FAR struct nxffs_volume_s *volume, off_t hoffset,
+                   FAR const struct nxffs_entry_s *entry)
+{
+  FAR struct nxffs_hnode_s *hnode;
+
+  if (!volume->idxvalid)
+    {
+      return;
+    }
+
+  /* Inodes are packed in FLASH order so the new location of an inode never
+   * matches the old location of an inode that has not yet been moved.
+   */
+
+  hnode = volume->index[NXFFS_HBUCKET(nxffs_hashname(entry->name))];
+  for (; hnode && hnode->hoffset != hoffset; hnode = hnode->flink);
+
+  if (hnode)
+    {
+      hnode->hoffset = entry->hoffset;
+    }
+}
@@ -163,6 +163,18 @@ int nxffs_initialize(FAR struct mtd_dev_s *mtd)
 #ifdef CONFIG_NXFFS_PREALLOCATED
 
   volume = &g_volume;
+
+#ifdef CONFIG_NXFFS_GC
+  /* Cancel any background packing that was scheduled for a previous
+   * instance of the volume.
+   */
+
+  (void)work_cancel(LPWORK, &volume->gcwork);
+#endif
+
+  /* Free the inode index of a previous instance of the volume */
+
+  nxffs_idxreset(volume);
   memset(volume, 0, sizeof(struct nxffs_volume_s));
 
 #else
@@ -183,6 +195,12 @@ int nxffs_initialize(FAR struct mtd_dev_s *mtd)
   sem_init(&volume->exclsem, 0, 1);
   sem_init(&volume->wrsem, 0, 1);
 
+#ifdef CONFIG_NXFFS_GC
+  /* The FLASH may already hold deleted inodes that can be reclaimed */
+
+  volume->gcdirty = true;
+#endif
+
   /* Get the volume geometry. (casting to uintptr_t first eliminates
    * complaints on some architectures where the sizeof long is different
    * from the size of a pointer).
@@ -333,6 +351,9 @@ errout_with_volume:
  *   data is written, or (2) recalculated as part of the file system packing
  *   operation.
  *
+ *   The in-memory inode index is rebuilt with the valid inodes that are
+ *   found.
+ *
  * Input Parameters:
  *   volume - Identifies the NXFFS volume
  *
@@ -351,6 +372,10 @@ int nxffs_limits(FAR struct nxffs_volume_s *volume)
   int nerased;
   int ret;
 
+  /* Start a new inode index */
+
+  nxffs_idxreset(volume);
+
   /* Get the offset to the first valid block on the FLASH */
 
   block = 0;
@@ -394,8 +419,11 @@ int nxffs_limits(FAR struct nxffs_volume_s *volume)
       volume->inoffset = entry.hoffset;
       finfo("First inode at offset %d\n", volume->inoffset);
 
-      /* Discard this entry and set the next offset. */
+      /* Add the inode to the index, discard this entry and set the next
+       * offset.
+       */
 
+      nxffs_idxadd(volume, &entry);
       offset = nxffs_inodeend(volume, &entry);
       nxffs_freeentry(&entry);
     }
@@ -404,10 +432,13 @@ int nxffs_limits(FAR struct nxffs_volume_s *volume)
 
   if (!noinodes)
     {
-      while (nxffs_nextentry(volume, offset, &entry) == OK)
+      while ((ret = nxffs_nextentry(volume, offset, &entry)) == OK)
         {
-          /* Discard the entry and guess the next offset. */
+          /* Add the inode to the index, discard the entry and guess the
+           * next offset.
+           */
 
+          nxffs_idxadd(volume, &entry);
           offset = nxffs_inodeend(volume, &entry);
           nxffs_freeentry(&entry);
         }
@@ -415,6 +446,25 @@ int nxffs_limits(FAR struct nxffs_volume_s *volume)
       finfo("Last inode before offset %d\n", offset);
     }
 
+  /* The search for inodes ended when it encountered NXFFS_NERASED erased
+   * bytes.  Unlike the search for erased FLASH below, it skips over the
+   * data of deleted inodes (which may include erased bytes) and over the
+   * filler inodes that cover unpacked FLASH during incremental packing.
+   * Begin the search for erased FLASH no earlier than that (allowing for
+   * an intervening block header).
+   */
+
+  if (ret == -ENOENT)
+    {
+      off_t erased = nxffs_iotell(volume) - NXFFS_NERASED -
+                     SIZEOF_NXFFS_BLOCK_HDR;
+
+      if (erased > offset)
+        {
+          offset = erased;
+        }
+    }
+
   /* No inodes were found after this offset.  Now search for a block of
    * erased flash.
    */
@@ -525,12 +575,30 @@ int nxffs_bind(FAR struct inode *blkdriver, FAR const void *data,
 #ifndef CONFIG_NXFFS_PREALLOCATED
 #  error "No design to support dynamic allocation of volumes"
 #else
+#ifdef CONFIG_NXFFS_GC
+  int ret;
+#endif
 
   /* If CONFIG_NXFFS_PREALLOCATED is defined, then this is the single, pre-
    * allocated NXFFS volume instance.
    */
 
   DEBUGASSERT(g_volume.cache);
+
+#ifdef CONFIG_NXFFS_GC
+  /* Resume any background packing that was stopped by an unmount */
+
+  ret = sem_wait(&g_volume.exclsem);
+  if (ret < 0)
+    {
+      return -get_errno();
+    }
+
+  g_volume.gcstop = false;
+  nxffs_gcschedule(&g_volume);
+  sem_post(&g_volume.exclsem);
+#endif
+
   *handle = &g_volume;
 #endif
   return OK;
@@ -550,6 +618,8 @@ int nxffs_unbind(FAR void *handle, FAR struct inode **blkdriver,
 #ifndef CONFIG_NXFFS_PREALLOCATED
 #  error "No design to support dynamic allocation of volumes"
 #else
+  int ret;
+
   /* This implementation currently only supports unmounting if there are no
    * open file references.
    */
@@ -559,6 +629,33 @@ int nxffs_unbind(FAR void *handle, FAR struct inode **blkdriver,
       return -ENOSYS;
     }
 
-  return g_volume.ofiles ? -EBUSY : OK;
+  /* Get exclusive access to the volume.  This also waits for a background
+   * packing step that is in progress to complete.
+   */
+
+  ret = sem_wait(&g_volume.exclsem);
+  if (ret < 0)
+    {
+      return -get_errno();
+    }
+
+  if (g_volume.ofiles != NULL)
+    {
+      ret = -EBUSY;
+    }
+#ifdef CONFIG_NXFFS_GC
+  else
+    {
+      /* Stop background packing.  If the worker has already been dequeued,
+       * it will see gcstop and do nothing.
+       */
+
+      (void)work_cancel(LPWORK, &g_volume.gcwork);
+      g_volume.gcstop = true;
+    }
+#endif
+
+  sem_post(&g_volume.exclsem);
+  return ret;
 #endif
 }
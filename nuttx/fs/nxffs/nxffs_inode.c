@@ -359,7 +359,8 @@ int nxffs_nextentry(FAR struct nxffs_volume_s *volume, off_t offset,
  * Description:
  *   Search for an inode with the provided name starting with the first
  *   valid inode and proceeding to the end FLASH or until the matching
- *   inode is found.
+ *   inode is found.  If CONFIG_NXFFS_INDEX is enabled, the in-memory inode
+ *   index is used instead to find the inode.
  *
  * Input Parameters:
  *   volume - Describes the NXFFS volume
@@ -375,9 +376,57 @@ int nxffs_nextentry(FAR struct nxffs_volume_s *volume, off_t offset,
 int nxffs_findinode(FAR struct nxffs_volume_s *volume, FAR const char *name,
                     FAR struct nxffs_entry_s *entry)
 {
+#ifdef CONFIG_NXFFS_INDEX
+  FAR struct nxffs_hnode_s *hnode;
+  uint32_t hash;
+#endif
   off_t offset;
   int ret;
 
+#ifdef CONFIG_NXFFS_INDEX
+  /* If the in-memory inode index is complete, then only the inode headers
+   * of the inodes with the same name hash need to be read from FLASH.
+   */
+
+  if (volume->idxvalid)
+    {
+      hash = nxffs_hashname(name);
+      for (hnode = volume->index[NXFFS_HBUCKET(hash)];
+           hnode;
+           hnode = hnode->flink)
+        {
+          if (hnode->hash != hash)
+            {
+              continue;
+            }
+
+          /* Read the inode header into the cache and verify it */
+
+          nxffs_ioseek(volume, hnode->hoffset);
+          ret = nxffs_rdcache(volume, volume->ioblock);
+          if (ret < 0)
+            {
+              ferr("ERROR: nxffs_rdcache failed: %d\n", -ret);
+              return ret;
+            }
+
+          ret = nxffs_rdentry(volume, hnode->hoffset, entry);
+          if (ret == OK)
+            {
+              if (strcmp(name, entry->name) == 0)
+                {
+                  return OK;
+                }
+
+              nxffs_freeentry(entry);
+            }
+        }
+
+      finfo("No inode found\n");
+      return -ENOENT;
+    }
+#endif
+
   /* Start with the first valid inode that was discovered when the volume
    * was created (or modified after the last file system re-packing).
    */
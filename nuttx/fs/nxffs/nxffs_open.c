@@ -902,9 +902,13 @@ static inline int nxffs_wrclose(FAR struct nxffs_volume_s *volume,
         }
     }
 
-  /* Write the inode header to FLASH */
+  /* Write the inode header to FLASH and add the new inode to the index */
 
   ret = nxffs_wrinode(volume, &wrfile->ofile.entry);
+  if (ret == OK)
+    {
+      nxffs_idxadd(volume, &wrfile->ofile.entry);
+    }
 
   /* The volume is now available for other writers */
 
@@ -1176,6 +1180,10 @@ int nxffs_close(FAR struct file *filep)
       /* Release all resouces held by the open file */
 
       nxffs_freeofile(volume, ofile);
+
+      /* Reclaim the FLASH in the background if it is running low */
+
+      nxffs_gcschedule(volume);
     }
   else
     {
@@ -1273,10 +1281,7 @@ int nxffs_wrinode(FAR struct nxffs_volume_s *volume,
            volume->ioblock, -ret);
     }
 
-  /* The volume is now available for other writers */
-
 errout:
-  sem_post(&volume->wrsem);
   return ret;
 }
 
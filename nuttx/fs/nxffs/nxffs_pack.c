@@ -86,6 +86,21 @@ struct nxffs_pack_s
   off_t                ioblock;    /* I/O block number */
   off_t                block0;     /* First I/O block number in the erase block */
   uint16_t             iooffset;   /* I/O block offset */
+
+  /* These describe the progress of the packing operation */
+
+  bool                 packed;     /* All inodes have been packed */
+  FAR struct nxffs_wrfile_s *wrfile; /* In-progress write to be packed */
+
+#ifdef CONFIG_NXFFS_GC
+  /* These support incremental packing */
+
+  bool                 stop;       /* Stop in the last block of the erase block */
+  bool                 stopped;    /* Stopped at an inode boundary */
+  off_t                tailend;    /* End of the FLASH being reclaimed */
+  off_t                fillto;     /* Cover the FLASH up to here with a filler */
+  off_t                filler;     /* FLASH offset to the filler inode header */
+#endif
 };
 
 /****************************************************************************
@@ -710,6 +725,12 @@ static int nxffs_wrinodehdr(FAR struct nxffs_volume_s *volume,
         }
     }
 
+  /* Update the location of the inode in the index.  pack->src still
+   * describes the inode at its old location.
+   */
+
+  nxffs_idxmove(volume, pack->src.entry.hoffset, &pack->dest.entry);
+
   /* Reset the dest inode information */
 
   nxffs_freeentry(&pack->dest.entry);
@@ -874,7 +895,9 @@ static int nxffs_endsrcblock(FAR struct nxffs_volume_s *volume,
  *
  * Returned Values:
  *   Zero on success; Otherwise, a negated errno value is returned to
- *   indicate the nature of the failure.
+ *   indicate the nature of the failure.  -ENOSPC means that there are no
+ *   further inodes to be packed; -EAGAIN means that an incremental packing
+ *   step stopped before the next source inode.
  *
  ****************************************************************************/
 
@@ -966,6 +989,24 @@ static inline int nxffs_packblock(FAR struct nxffs_volume_s *volume,
               return -ENOSPC;
             }
 
+#ifdef CONFIG_NXFFS_GC
+          /* If this is an incremental packing step that should stop, stop
+           * here between two inodes once the last I/O block of the erase
+           * block is reached.  The FLASH between the end of the packed
+           * inodes and the next source inode will be covered with a filler
+           * inode header.  That requires room for the inode header (and its
+           * empty name) in this block and a sufficiently large gap.
+           */
+
+          if (pack->stop &&
+              pack->ioblock + 1 >= pack->block0 + volume->blkper &&
+              pack->iooffset + SIZEOF_NXFFS_INODE_HDR < volume->geo.blocksize &&
+              pack->src.entry.hoffset >= nxffs_packtell(volume, pack) + NXFFS_MINFILLER)
+            {
+              return -EAGAIN;
+            }
+#endif
+
           /* Setup the new source stream */
 
           ret = nxffs_srcsetup(volume, pack, pack->src.entry.doffset);
@@ -1243,6 +1284,432 @@ static inline int nxffs_packwriter(FAR struct nxffs_volume_s *volume,
   return -ENOSYS;
 }
 
+/****************************************************************************
+ * Name: nxffs_packfiller
+ *
+ * Description:
+ *   Write a filler inode header at the current destination position.  The
+ *   filler is a deleted inode with no name whose data length is chosen so
+ *   that nxffs_inodeend() returns the 'to' offset (or up to ten bytes
+ *   before it, too few to hold an inode header).  Searches for inodes will
+ *   then skip over the unpacked FLASH up to 'to' exactly as they skip over
+ *   the data of any other deleted inode.
+ *
+ * Input Parameters:
+ *   volume - The volume to be packed
+ *   pack   - The volume packing state structure.
+ *   to     - FLASH offset to the end of the region to be covered.
+ *
+ * Returned Values:
+ *   None.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXFFS_GC
+static void nxffs_packfiller(FAR struct nxffs_volume_s *volume,
+                             FAR struct nxffs_pack_s *pack, off_t to)
+{
+  FAR struct nxffs_inode_s *inode;
+  uint16_t maxsize;
+  off_t hoffset;
+  off_t datlen;
+  off_t span;
+  uint32_t crc;
+
+  hoffset = nxffs_packtell(volume, pack);
+  DEBUGASSERT(pack->iooffset + SIZEOF_NXFFS_INODE_HDR < volume->geo.blocksize &&
+              to >= hoffset + NXFFS_MINFILLER);
+
+  /* nxffs_inodeend() will return doffset + datlen plus the size of one
+   * data block header for each maxsize bytes of data.  Find the largest
+   * data length for which that does not exceed 'to'.
+   */
+
+  maxsize = volume->geo.blocksize - SIZEOF_NXFFS_BLOCK_HDR - SIZEOF_NXFFS_DATA_HDR;
+  span    = to - hoffset - SIZEOF_NXFFS_INODE_HDR;
+  datlen  = span - SIZEOF_NXFFS_DATA_HDR *
+            ((span + maxsize + SIZEOF_NXFFS_DATA_HDR - 1) /
+             (maxsize + SIZEOF_NXFFS_DATA_HDR));
+
+  while (datlen + 1 + SIZEOF_NXFFS_DATA_HDR * ((datlen + maxsize) / maxsize) <= span)
+    {
+      datlen++;
+    }
+
+  /* Initialize the inode header.  There is no name and the (fictitious)
+   * data follows the inode header.
+   */
+
+  inode = (FAR struct nxffs_inode_s *)&pack->iobuffer[pack->iooffset];
+  memcpy(inode->magic, g_inodemagic, NXFFS_MAGICSIZE);
+
+  nxffs_wrle32(inode->noffs,  hoffset + SIZEOF_NXFFS_INODE_HDR);
+  nxffs_wrle32(inode->doffs,  hoffset + SIZEOF_NXFFS_INODE_HDR);
+  nxffs_wrle32(inode->utc,    0);
+  nxffs_wrle32(inode->crc,    0);
+  nxffs_wrle32(inode->datlen, datlen);
+
+  inode->state  = CONFIG_NXFFS_ERASEDSTATE;
+  inode->namlen = 0;
+
+  /* Calculate the CRC and mark the inode deleted */
+
+  crc = crc32((FAR const uint8_t *)inode, SIZEOF_NXFFS_INODE_HDR);
+  inode->state = INODE_STATE_DELETED;
+  nxffs_wrle32(inode->crc, crc);
+
+  pack->filler    = hoffset;
+  pack->iooffset += SIZEOF_NXFFS_INODE_HDR;
+}
+#endif
+
+/****************************************************************************
+ * Name: nxffs_packeblock
+ *
+ * Description:
+ *   Pack one erase block:  Read the erase block into the pack buffer, pack
+ *   inode data into each of its I/O blocks starting at pack->ioblock, then
+ *   erase the block and write the new content back to FLASH.
+ *
+ *   If the packing stops at an inode boundary (incremental packing only),
+ *   the rest of the erase block is written back unchanged.
+ *
+ * Input Parameters:
+ *   volume - The volume to be packed
+ *   pack   - The volume packing state structure.
+ *   eblock - The erase block to be packed.
+ *
+ * Returned Values:
+ *   Zero on success; Otherwise, a negated errno value is returned to
+ *   indicate the nature of the failure.
+ *
+ ****************************************************************************/
+
+static int nxffs_packeblock(FAR struct nxffs_volume_s *volume,
+                            FAR struct nxffs_pack_s *pack, off_t eblock)
+{
+  off_t block;
+  int i;
+  int ret;
+
+  /* Get the starting block number of the erase block */
+
+  pack->block0 = eblock * volume->blkper;
+
+#ifndef CONFIG_NXFFS_NAND
+  /* Read the erase block into the pack buffer.  We need to do this even
+   * if we are overwriting the entire block so that we skip over
+   * previously marked bad blocks.
+   */
+
+  ret = MTD_BREAD(volume->mtd, pack->block0, volume->blkper, volume->pack);
+  if (ret < 0)
+    {
+      ferr("ERROR: Failed to read erase block %d: %d\n", eblock, -ret);
+      return ret;
+    }
+
+#else
+  /* Read the entire erase block into the pack buffer, one-block-at-a-
+   * time.  We need to do this even if we are overwriting the entire
+   * block so that (1) we skip over previously marked bad blocks, and
+   * (2) we can handle individual block read failures.
+   *
+   * For most FLASH, a read failure indicates a fatal hardware failure.
+   * But for NAND FLASH, the read failure probably indicates a block
+   * with uncorrectable bit errors.
+   */
+
+  /* Read each I/O block */
+
+  for (i = 0, block = pack->block0, pack->iobuffer = volume->pack;
+       i < volume->blkper;
+       i++, block++, pack->iobuffer += volume->geo.blocksize)
+    {
+      /* Read the next block in the erase block */
+
+      ret = MTD_BREAD(volume->mtd, block, 1, pack->iobuffer);
+      if (ret < 0)
+        {
+          /* Force a the block to be an NXFFS bad block */
+
+          ferr("ERROR: Failed to read block %d: %d\n", block, ret);
+          nxffs_blkinit(volume, pack->iobuffer, BLOCK_STATE_BAD);
+        }
+    }
+#endif
+
+  /* Now pack each I/O block */
+
+  for (i = 0, block = pack->block0, pack->iobuffer = volume->pack;
+       i < volume->blkper;
+       i++, block++, pack->iobuffer += volume->geo.blocksize)
+    {
+      /* The first time here, the ioblock may point to an offset into
+       * the erase block.  We just need to skip over those cases.
+       */
+
+      if (block >= pack->ioblock)
+        {
+          /* Set the I/O position.  Note on the first time we get
+           * pack->iooffset will hold the offset in the first I/O block
+           * to the first inode header.  After that, it will always
+           * refer to the first byte after the block header.
+           */
+
+          pack->ioblock = block;
+
+          /* If this is not a valid block or if we have already
+           * finished packing the valid inode entries, then just fall
+           * through, reset the FLASH memory to the erase state, and
+           * write the reset values to FLASH.  (The first block that
+           * we want to process will always be valid -- we have
+           * already verified that).
+           */
+
+          if (nxffs_packvalid(pack))
+            {
+              /* Have we finished packing inodes? */
+
+              if (!pack->packed)
+                {
+                  DEBUGASSERT(pack->wrfile == NULL);
+
+                  /* Pack inode data into this block */
+
+                  ret = nxffs_packblock(volume, pack);
+                  if (ret < 0)
+                    {
+                      /* The error -ENOSPC is a special value that simply
+                       * means that there is nothing further to be packed.
+                       */
+
+                      if (ret == -ENOSPC)
+                        {
+                          pack->packed = true;
+
+                          /* Writing is performed at the end of the free
+                           * FLASH region and this implemenation is restricted
+                           * to a single writer.  The new inode is not
+                           * written to FLASH until the writer is closed
+                           * and so will not be found by nxffs_packblock().
+                           */
+
+                          pack->wrfile = nxffs_setupwriter(volume, pack);
+
+#ifdef CONFIG_NXFFS_GC
+                          /* An incremental packing step may have to cover
+                           * the FLASH that remains to be reclaimed.
+                           */
+
+                          pack->fillto = pack->tailend;
+#endif
+                        }
+
+#ifdef CONFIG_NXFFS_GC
+                      /* The error -EAGAIN means that an incremental
+                       * packing step stopped before the next source inode.
+                       * Cover the FLASH up to that inode.  The remainder of
+                       * the erase block is left as it is; the source inode
+                       * may lie there.
+                       */
+
+                      else if (ret == -EAGAIN)
+                        {
+                          nxffs_packfiller(volume, pack, pack->src.entry.hoffset);
+                          pack->stopped = true;
+                          break;
+                        }
+#endif
+                      else
+                        {
+                          /* Otherwise, something really bad happened */
+
+                          ferr("ERROR: Failed to pack into block %d: %d\n",
+                               block, ret);
+                          return ret;
+                        }
+                    }
+                }
+
+              /* If all of the "normal" inodes have been packed, then check if
+               * we need to pack the current, in-progress write operation.
+               */
+
+              if (pack->wrfile)
+                {
+                  DEBUGASSERT(pack->packed == true);
+
+                  /* Pack write data into this block */
+
+                  ret = nxffs_packwriter(volume, pack, pack->wrfile);
+                  if (ret < 0)
+                    {
+                      /* The error -ENOSPC is a special value that simply
+                       * means that there is nothing further to be packed.
+                       */
+
+                      if (ret == -ENOSPC)
+                        {
+                          pack->wrfile = NULL;
+                        }
+                      else
+                        {
+                          /* Otherwise, something really bad happened */
+
+                          ferr("ERROR: Failed to pack into block %d: %d\n",
+                               block, ret);
+                          return ret;
+                        }
+                    }
+                }
+
+#ifdef CONFIG_NXFFS_GC
+              /* If the FLASH that remains to be reclaimed extends beyond
+               * this erase block, it will be erased by later steps.  Until
+               * then, cover it with a filler.
+               */
+
+              if (pack->fillto > 0 && pack->wrfile == NULL &&
+                  pack->iooffset + SIZEOF_NXFFS_INODE_HDR < volume->geo.blocksize)
+                {
+                  if (pack->fillto > (eblock + 1) * volume->geo.erasesize)
+                    {
+                      nxffs_packfiller(volume, pack, pack->fillto);
+                    }
+
+                  pack->fillto = 0;
+                }
+#endif
+            }
+
+          /* Set any unused portion at the end of the block to the
+           * erased state.
+           */
+
+          if (pack->iooffset < volume->geo.blocksize)
+            {
+              memset(&pack->iobuffer[pack->iooffset],
+                     CONFIG_NXFFS_ERASEDSTATE,
+                     volume->geo.blocksize - pack->iooffset);
+            }
+
+          /* Next time through the loop, pack->iooffset will point to the
+           * first byte after the block header.
+           */
+
+          pack->iooffset = SIZEOF_NXFFS_BLOCK_HDR;
+        }
+    }
+
+  /* We now have an in-memory image of how we want this erase block to
+   * appear. Now it is safe to erase the block.
+   */
+
+  ret = MTD_ERASE(volume->mtd, eblock, 1);
+  if (ret < 0)
+    {
+      ferr("ERROR: Failed to erase block %d [%d]: %d\n",
+           eblock, pack->block0, -ret);
+      return ret;
+    }
+
+  /* Write the packed I/O block to FLASH */
+
+  ret = MTD_BWRITE(volume->mtd, pack->block0, volume->blkper, volume->pack);
+  if (ret < 0)
+    {
+      ferr("ERROR: Failed to write erase block %d [%d]: %d\n",
+           eblock, pack->block0, -ret);
+      return ret;
+    }
+
+  /* The volume cache may hold the previous content of one of the blocks
+   * that were just re-written.  Force it to be re-read.
+   */
+
+  if (volume->cblock >= pack->block0 &&
+      volume->cblock < pack->block0 + volume->blkper)
+    {
+      volume->cblock = (off_t)-1;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: nxffs_packtail
+ *
+ * Description:
+ *   The final phase of an incremental packing sweep:  All inodes have been
+ *   packed and the FLASH from the filler at volume->gcoffset up to
+ *   volume->gcend is to be reclaimed.  Erase at most 'neblocks' of the
+ *   erase blocks in this region.  When all have been erased, remove the
+ *   filler and return the region to the free FLASH.
+ *
+ * Input Parameters:
+ *   volume   - The volume to be packed.
+ *   neblocks - The maximum number of erase blocks to rewrite.
+ *
+ * Returned Values:
+ *   Zero on success; Otherwise, a negated errno value is returned to
+ *   indicate the nature of the failure.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXFFS_GC
+static int nxffs_packtail(FAR struct nxffs_volume_s *volume, int neblocks)
+{
+  struct nxffs_pack_s pack;
+  off_t lastblock;
+  int ret;
+
+  memset(&pack, 0, sizeof(struct nxffs_pack_s));
+  pack.packed = true;
+
+  /* Erase the blocks after the one holding the filler.  No inodes can lie
+   * there:  Nothing has been written since the end of the region was the
+   * free FLASH offset.
+   */
+
+  lastblock = (volume->gcend - 1) / volume->geo.erasesize;
+  while (neblocks > 0 && volume->gcblock <= lastblock)
+    {
+      pack.ioblock  = volume->gcblock * volume->blkper;
+      pack.iooffset = SIZEOF_NXFFS_BLOCK_HDR;
+
+      ret = nxffs_packeblock(volume, &pack, volume->gcblock);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      volume->gcblock++;
+      neblocks--;
+    }
+
+  /* Then erase the filler itself and everything that follows it */
+
+  if (neblocks > 0 && volume->gcblock > lastblock)
+    {
+      pack.ioblock  = nxffs_getblock(volume, volume->gcoffset);
+      pack.iooffset = nxffs_getoffset(volume, volume->gcoffset, pack.ioblock);
+
+      ret = nxffs_packeblock(volume, &pack, pack.ioblock / volume->blkper);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      volume->froffset = volume->gcoffset;
+      volume->gcoffset = 0;
+      volume->gcend    = 0;
+    }
+
+  return OK;
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -1271,9 +1738,15 @@ int nxffs_pack(FAR struct nxffs_volume_s *volume)
   off_t eblock;
   off_t block;
   bool packed;
-  int i;
   int ret = OK;
 
+#ifdef CONFIG_NXFFS_GC
+  /* A full pack replaces any incremental packing sweep in progress */
+
+  volume->gcoffset = 0;
+  volume->gcend    = 0;
+#endif
+
   /* Get the offset to the first valid inode entry */
 
   wrfile = NULL;
@@ -1395,8 +1868,19 @@ start_pack:
 
   pack.ioblock     = nxffs_getblock(volume, iooffset);
   pack.iooffset    = nxffs_getoffset(volume, iooffset, pack.ioblock);
+  pack.packed      = packed;
+  pack.wrfile      = wrfile;
   volume->froffset = iooffset;
 
+  /* Inodes may be moved in front of the first inode; searches must start
+   * no later than the packing position.
+   */
+
+  if (iooffset < volume->inoffset)
+    {
+      volume->inoffset = iooffset;
+    }
+
   /* Then pack all erase blocks starting with the erase block that contains
    * the ioblock and through the final erase block on the FLASH.
    */
@@ -1405,199 +1889,228 @@ start_pack:
        eblock < volume->geo.neraseblocks;
        eblock++)
     {
-      /* Get the starting block number of the erase block */
-
-      pack.block0 = eblock * volume->blkper;
-
-#ifndef CONFIG_NXFFS_NAND
-      /* Read the erase block into the pack buffer.  We need to do this even
-       * if we are overwriting the entire block so that we skip over
-       * previously marked bad blocks.
-       */
-
-      ret = MTD_BREAD(volume->mtd, pack.block0, volume->blkper, volume->pack);
+      ret = nxffs_packeblock(volume, &pack, eblock);
       if (ret < 0)
         {
-          ferr("ERROR: Failed to read erase block %d: %d\n", eblock, -ret);
           goto errout_with_pack;
         }
+    }
 
-#else
-      /* Read the entire erase block into the pack buffer, one-block-at-a-
-       * time.  We need to do this even if we are overwriting the entire
-       * block so that (1) we skip over previously marked bad blocks, and
-       * (2) we can handle individual block read failures.
-       *
-       * For most FLASH, a read failure indicates a fatal hardware failure.
-       * But for NAND FLASH, the read failure probably indicates a block
-       * with uncorrectable bit errors.
-       */
+errout_with_pack:
+  nxffs_freeentry(&pack.src.entry);
+  nxffs_freeentry(&pack.dest.entry);
 
-      /* Read each I/O block */
+  /* If the packing operation failed, then some inodes may or may not have
+   * been moved.  The index can no longer be trusted and must be rebuilt.
+   */
 
-      for (i = 0, block = pack.block0, pack.iobuffer = volume->pack;
-           i < volume->blkper;
-           i++, block++, pack.iobuffer += volume->geo.blocksize)
-        {
-          /* Read the next block in the erase block */
+  if (ret < 0)
+    {
+      nxffs_idxbuild(volume);
+    }
 
-          ret = MTD_BREAD(volume->mtd, block, 1, pack.iobuffer);
-          if (ret < 0)
-            {
-              /* Force a the block to be an NXFFS bad block */
+  return ret;
+}
 
-              ferr("ERROR: Failed to read block %d: %d\n", block, ret);
-              nxffs_blkinit(volume, pack.iobuffer, BLOCK_STATE_BAD);
-            }
-        }
-#endif
+/****************************************************************************
+ * Name: nxffs_packstep
+ *
+ * Description:
+ *   Perform one step of an incremental packing sweep.  The sweep starts at
+ *   the first gap between inodes and resumes where the previous step
+ *   stopped.  Each step rewrites at most 'neblocks' erase blocks.  On
+ *   return, volume->gcoffset is non-zero if the sweep is not yet complete.
+ *
+ *   Between steps, the unpacked FLASH that follows the packed inodes is
+ *   covered by a filler inode header so that the volume remains consistent
+ *   if it is accessed or re-mounted before the sweep is complete.  When
+ *   all inodes have been packed, the FLASH up to the free FLASH offset is
+ *   erased in the same bounded steps (see nxffs_packtail()).
+ *
+ *   The caller must hold the volume exclsem and there must be no open
+ *   files on the volume.
+ *
+ * Input Parameters:
+ *   volume   - The volume to be packed.
+ *   neblocks - The maximum number of erase blocks to rewrite.
+ *
+ * Returned Values:
+ *   Zero on success; Otherwise, a negated errno value is returned to
+ *   indicate the nature of the failure.
+ *
+ ****************************************************************************/
 
-      /* Now pack each I/O block */
+#ifdef CONFIG_NXFFS_GC
+int nxffs_packstep(FAR struct nxffs_volume_s *volume, int neblocks)
+{
+  struct nxffs_pack_s pack;
+  off_t froffset = volume->froffset;
+  off_t iooffset;
+  off_t eblock;
+  off_t block;
+  bool packed = false;
+  int ret;
+
+  DEBUGASSERT(volume->ofiles == NULL && neblocks > 0);
 
-      for (i = 0, block = pack.block0, pack.iobuffer = volume->pack;
-           i < volume->blkper;
-           i++, block++, pack.iobuffer += volume->geo.blocksize)
+  /* Are we erasing the FLASH at the end of a sweep? */
+
+  if (volume->gcend > 0)
+    {
+      if (volume->froffset == volume->gcend)
         {
-          /* The first time here, the ioblock may point to an offset into
-           * the erase block.  We just need to skip over those cases.
-           */
+          return nxffs_packtail(volume, neblocks);
+        }
 
-          if (block >= pack.ioblock)
-            {
-              /* Set the I/O position.  Note on the first time we get
-               * pack.iooffset will hold the offset in the first I/O block
-               * to the first inode header.  After that, it will always
-               * refer to the first byte after the block header.
-               */
+      /* No.. new inodes have been written after that FLASH.  Resume the
+       * sweep at the filler.  The new inodes will be packed over it.
+       */
 
-              pack.ioblock = block;
+      volume->gcend = 0;
+    }
 
-              /* If this is not a valid block or if we have already
-               * finished packing the valid inode entries, then just fall
-               * through, reset the FLASH memory to the erase state, and
-               * write the reset values to FLASH.  (The first block that
-               * we want to process will always be valid -- we have
-               * already verified that).
-               */
+  memset(&pack, 0, sizeof(struct nxffs_pack_s));
+  if (volume->gcoffset == 0)
+    {
+      /* Start a new sweep with the first valid inode */
 
-              if (nxffs_packvalid(&pack))
-                {
-                  /* Have we finished packing inodes? */
+      iooffset = nxffs_mediacheck(volume, &pack);
+      if (iooffset == 0)
+        {
+          /* There are no valid inodes.  All of the FLASH after the first
+           * block header can be reclaimed.
+           */
 
-                  if (!packed)
-                    {
-                      DEBUGASSERT(wrfile == NULL);
+          block = 0;
+          ret = nxffs_validblock(volume, &block);
+          if (ret < 0)
+            {
+              return ret;
+            }
+
+          iooffset = block * volume->geo.blocksize + SIZEOF_NXFFS_BLOCK_HDR;
+          packed   = true;
+        }
+    }
+  else
+    {
+      /* Resume the sweep with the first valid inode after the filler */
 
-                      /* Pack inode data into this block */
+      iooffset = volume->gcoffset;
+      ret = nxffs_nextentry(volume, iooffset, &pack.src.entry);
+      if (ret < 0)
+        {
+          if (ret != -ENOENT)
+            {
+              return ret;
+            }
 
-                      ret = nxffs_packblock(volume, &pack);
-                      if (ret < 0)
-                        {
-                          /* The error -ENOSPC is a special value that simply
-                           * means that there is nothing further to be packed.
-                           */
+          packed = true;
+        }
+    }
 
-                          if (ret == -ENOSPC)
-                            {
-                              packed = true;
-
-                              /* Writing is performed at the end of the free
-                               * FLASH region and this implemenation is restricted
-                               * to a single writer.  The new inode is not
-                               * written to FLASH until the writer is closed
-                               * and so will not be found by nxffs_packblock().
-                               */
-
-                              wrfile = nxffs_setupwriter(volume, &pack);
-                            }
-                          else
-                            {
-                              /* Otherwise, something really bad happened */
-
-                              ferr("ERROR: Failed to pack into block %d: %d\n",
-                                   block, ret);
-                              goto errout_with_pack;
-                            }
-                        }
-                    }
+  volume->gcoffset = 0;
 
-                  /* If all of the "normal" inodes have been packed, then check if
-                   * we need to pack the current, in-progress write operation.
-                   */
+  /* Find the position where packing should begin */
 
-                  if (wrfile)
-                    {
-                      DEBUGASSERT(packed == true);
+  if (!packed)
+    {
+      ret = nxffs_startpos(volume, &pack, &iooffset);
+      if (ret == -ENOSPC)
+        {
+          packed = true;
+        }
+      else if (ret < 0)
+        {
+          ferr("ERROR: Failed to find a packing position: %d\n", -ret);
+          goto errout_with_pack;
+        }
+    }
 
-                      /* Pack write data into this block */
+  /* If all of the inodes are packed, is it worth erasing the FLASH that
+   * follows them?
+   */
 
-                      ret = nxffs_packwriter(volume, &pack, wrfile);
-                      if (ret < 0)
-                        {
-                          /* The error -ENOSPC is a special value that simply
-                           * means that there is nothing further to be packed.
-                           */
+  if (packed && iooffset + CONFIG_NXFFS_TAILTHRESHOLD >= froffset)
+    {
+      ret = OK;
+      goto errout_with_pack;
+    }
 
-                          if (ret == -ENOSPC)
-                            {
-                              wrfile = NULL;
-                            }
-                          else
-                            {
-                              /* Otherwise, something really bad happened */
-
-                              ferr("ERROR: Failed to pack into block %d: %d\n",
-                                   block, ret);
-                              goto errout_with_pack;
-                            }
-                        }
-                    }
-                }
+  pack.ioblock     = nxffs_getblock(volume, iooffset);
+  pack.iooffset    = nxffs_getoffset(volume, iooffset, pack.ioblock);
+  pack.packed      = packed;
+  pack.tailend     = froffset;
+  pack.fillto      = packed ? froffset : 0;
+  volume->froffset = iooffset;
 
-              /* Set any unused portion at the end of the block to the
-               * erased state.
-               */
+  if (iooffset < volume->inoffset)
+    {
+      volume->inoffset = iooffset;
+    }
 
-              if (pack.iooffset < volume->geo.blocksize)
-                {
-                  memset(&pack.iobuffer[pack.iooffset],
-                         CONFIG_NXFFS_ERASEDSTATE,
-                         volume->geo.blocksize - pack.iooffset);
-                }
+  /* Pack erase blocks until the step stops at an inode boundary or until
+   * all inodes have been packed.
+   */
 
-              /* Next time through the loop, pack.iooffset will point to the
-               * first byte after the block header.
-               */
+  for (eblock = pack.ioblock / volume->blkper;
+       eblock < volume->geo.neraseblocks;
+       eblock++, neblocks--)
+    {
+      pack.stop = (neblocks <= 1);
 
-              pack.iooffset = SIZEOF_NXFFS_BLOCK_HDR;
-            }
+      ret = nxffs_packeblock(volume, &pack, eblock);
+      if (ret < 0)
+        {
+          goto errout_with_pack;
         }
 
-      /* We now have an in-memory image of how we want this erase block to
-       * appear. Now it is safe to erase the block.
+      /* Did the step stop before the next source inode?  Then the next step
+       * will resume at the filler.  The free FLASH offset is unchanged.
        */
 
-      ret = MTD_ERASE(volume->mtd, eblock, 1);
-      if (ret < 0)
+      if (pack.stopped)
         {
-          ferr("ERROR: Failed to erase block %d [%d]: %d\n",
-               eblock, pack.block0, -ret);
-          goto errout_with_pack;
+          volume->gcoffset = pack.filler;
+          volume->froffset = froffset;
+          break;
         }
 
-      /* Write the packed I/O block to FLASH */
+      /* Have all inodes been packed (and the filler placed if necessary)? */
 
-      ret = MTD_BWRITE(volume->mtd, pack.block0, volume->blkper, volume->pack);
-      if (ret < 0)
+      if (pack.packed && pack.fillto == 0)
         {
-          ferr("ERROR: Failed to write erase block %d [%d]: %d\n",
-               eblock, pack.block0, -ret);
-          goto errout_with_pack;
+          if (pack.filler > 0)
+            {
+              /* The FLASH after the filler remains to be erased */
+
+              volume->gcoffset = pack.filler;
+              volume->gcend    = froffset;
+              volume->gcblock  = eblock + 1;
+              volume->froffset = froffset;
+            }
+
+          /* Otherwise, the sweep is complete and volume->froffset is the
+           * offset to the end of the packed inodes.
+           */
+
+          break;
         }
     }
 
 errout_with_pack:
   nxffs_freeentry(&pack.src.entry);
   nxffs_freeentry(&pack.dest.entry);
+
+  /* If the packing step failed, then some inodes may or may not have
+   * been moved.  The index can no longer be trusted and must be rebuilt.
+   */
+
+  if (ret < 0)
+    {
+      nxffs_idxbuild(volume);
+    }
+
   return ret;
 }
+#endif
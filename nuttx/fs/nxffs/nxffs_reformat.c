@@ -278,6 +278,10 @@ int nxffs_reformat(FAR struct nxffs_volume_s *volume)
 {
   int ret;
 
+  /* All inodes will be lost */
+
+  nxffs_idxreset(volume);
+
   /* Erase and reformat the entire volume */
 
   ret = nxffs_format(volume);
@@ -69,6 +69,10 @@
 int nxffs_statfs(FAR struct inode *mountpt, FAR struct statfs *buf)
 {
   FAR struct nxffs_volume_s *volume;
+#ifdef CONFIG_NXFFS_INDEX
+  off_t blksize;
+  off_t nused;
+#endif
   int ret;
 
   finfo("Entry\n");
@@ -88,7 +92,8 @@ int nxffs_statfs(FAR struct inode *mountpt, FAR struct statfs *buf)
 
   /* Fill in the statfs info
    *
-   * REVISIT: Need f_bfree, f_bavail, f_files, f_ffree calculation
+   * REVISIT: Need f_ffree calculation.  Without CONFIG_NXFFS_INDEX, there
+   * is also no f_bfree, f_bavail, or f_files calculation.
    */
 
   memset(buf, 0, sizeof(struct statfs));
@@ -96,6 +101,21 @@ int nxffs_statfs(FAR struct inode *mountpt, FAR struct statfs *buf)
   buf->f_bsize   = volume->geo.blocksize;
   buf->f_blocks  = volume->nblocks;
   buf->f_namelen = volume->geo.blocksize - SIZEOF_NXFFS_BLOCK_HDR - SIZEOF_NXFFS_INODE_HDR;
+
+#ifdef CONFIG_NXFFS_INDEX
+  /* FLASH used by deleted inodes is recovered by packing the volume when
+   * it is needed, so it is reported as free.  The free block count is
+   * approximate:  It assumes that the valid inodes are perfectly packed.
+   */
+
+  blksize        = volume->geo.blocksize - SIZEOF_NXFFS_BLOCK_HDR;
+  nused          = (volume->nused + blksize - 1) / blksize;
+
+  buf->f_bfree   = nused < volume->nblocks ? volume->nblocks - nused : 0;
+  buf->f_bavail  = buf->f_bfree;
+  buf->f_files   = volume->nfiles;
+#endif
+
   ret            = OK;
 
   sem_post(&volume->exclsem);
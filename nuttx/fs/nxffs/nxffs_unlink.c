@@ -129,6 +129,15 @@ int nxffs_rminode(FAR struct nxffs_volume_s *volume, FAR const char *name)
       ferr("ERROR: Failed to write block %d: %d\n",
            volume->ioblock, ret);
     }
+  else
+    {
+      /* The inode is no longer valid; remove it from the index */
+
+      nxffs_idxremove(volume, &entry);
+#ifdef CONFIG_NXFFS_GC
+      volume->gcdirty = true;
+#endif
+    }
 
 errout_with_entry:
   nxffs_freeentry(&entry);
@@ -166,6 +175,12 @@ int nxffs_unlink(FAR struct inode *mountpt, FAR const char *relpath)
   /* Then remove the NXFFS inode */
 
   ret = nxffs_rminode(volume, relpath);
+  if (ret == OK)
+    {
+      /* Reclaim the FLASH in the background if it is running low */
+
+      nxffs_gcschedule(volume);
+    }
 
   sem_post(&volume->exclsem);
 errout:
@@ -61,7 +61,7 @@
 #include <nuttx/fs/procfs.h>
 #include <nuttx/fs/dirent.h>
 
-#ifdef CONFIG_SCHED_CPULOAD
+#if defined(CONFIG_SCHED_CPULOAD) || defined(CONFIG_SCHED_TIMESTATS)
 #  include <nuttx/clock.h>
 #endif
 
@@ -105,6 +105,15 @@ enum proc_node_e
   PROC_LOADAVG,                       /* Average CPU utilization */
 #endif
   PROC_STACK,                         /* Task stack info */
+#ifdef CONFIG_SCHED_RUNTIME
+  PROC_RUNTIME,                       /* Accumulated run time */
+#endif
+#ifdef CONFIG_SCHED_LATENCY
+  PROC_LATENCY,                       /* Wakeup latency histogram */
+#endif
+#ifdef CONFIG_SCHED_CRITMONITOR
+  PROC_CRITMON,                       /* Interrupts-off times */
+#endif
   PROC_GROUP,                         /* Group directory */
   PROC_GROUP_STATUS,                  /* Task group status */
   PROC_GROUP_FD                       /* Group file descriptors */
@@ -171,6 +180,26 @@ static ssize_t proc_loadavg(FAR struct proc_file_s *procfile,
 static ssize_t proc_stack(FAR struct proc_file_s *procfile,
                  FAR struct tcb_s *tcb, FAR char *buffer, size_t buflen,
                  off_t offset);
+#ifdef CONFIG_SCHED_TIMESTATS
+static size_t  proc_perftime(FAR struct proc_file_s *procfile,
+                 FAR const char *name, uint64_t count, FAR char *buffer,
+                 size_t buflen, FAR off_t *offset);
+#endif
+#ifdef CONFIG_SCHED_RUNTIME
+static ssize_t proc_runtime(FAR struct proc_file_s *procfile,
+                 FAR struct tcb_s *tcb, FAR char *buffer, size_t buflen,
+                 off_t offset);
+#endif
+#ifdef CONFIG_SCHED_LATENCY
+static ssize_t proc_latency(FAR struct proc_file_s *procfile,
+                 FAR struct tcb_s *tcb, FAR char *buffer, size_t buflen,
+                 off_t offset);
+#endif
+#ifdef CONFIG_SCHED_CRITMONITOR
+static ssize_t proc_critmon(FAR struct proc_file_s *procfile,
+                 FAR struct tcb_s *tcb, FAR char *buffer, size_t buflen,
+                 off_t offset);
+#endif
 static ssize_t proc_groupstatus(FAR struct proc_file_s *procfile,
                  FAR struct tcb_s *tcb, FAR char *buffer, size_t buflen,
                  off_t offset);
@@ -255,6 +284,27 @@ static const struct proc_node_s g_stack =
   "stack",        "stack",   (uint8_t)PROC_STACK,        DTYPE_FILE        /* Task stack info */
 };
 
+#ifdef CONFIG_SCHED_RUNTIME
+static const struct proc_node_s g_runtime =
+{
+  "runtime",      "runtime", (uint8_t)PROC_RUNTIME,      DTYPE_FILE        /* Accumulated run time */
+};
+#endif
+
+#ifdef CONFIG_SCHED_LATENCY
+static const struct proc_node_s g_latency =
+{
+  "latency",      "latency", (uint8_t)PROC_LATENCY,      DTYPE_FILE        /* Wakeup latency histogram */
+};
+#endif
+
+#ifdef CONFIG_SCHED_CRITMONITOR
+static const struct proc_node_s g_critmon =
+{
+  "critmon",      "critmon", (uint8_t)PROC_CRITMON,      DTYPE_FILE        /* Interrupts-off times */
+};
+#endif
+
 static const struct proc_node_s g_group =
 {
   "group",        "group",   (uint8_t)PROC_GROUP,        DTYPE_DIRECTORY   /* Group directory */
@@ -280,6 +330,15 @@ static FAR const struct proc_node_s * const g_nodeinfo[] =
   &g_loadavg,      /* Average CPU utilization */
 #endif
   &g_stack,        /* Task stack info */
+#ifdef CONFIG_SCHED_RUNTIME
+  &g_runtime,      /* Accumulated run time */
+#endif
+#ifdef CONFIG_SCHED_LATENCY
+  &g_latency,      /* Wakeup latency histogram */
+#endif
+#ifdef CONFIG_SCHED_CRITMONITOR
+  &g_critmon,      /* Interrupts-off times */
+#endif
   &g_group,        /* Group directory */
   &g_groupstatus,  /* Task group status */
   &g_groupfd       /* Group file descriptors */
@@ -296,6 +355,15 @@ static const struct proc_node_s * const g_level0info[] =
   &g_loadavg,      /* Average CPU utilization */
 #endif
   &g_stack,        /* Task stack info */
+#ifdef CONFIG_SCHED_RUNTIME
+  &g_runtime,      /* Accumulated run time */
+#endif
+#ifdef CONFIG_SCHED_LATENCY
+  &g_latency,      /* Wakeup latency histogram */
+#endif
+#ifdef CONFIG_SCHED_CRITMONITOR
+  &g_critmon,      /* Interrupts-off times */
+#endif
   &g_group,        /* Group directory */
 };
 #define PROC_NLEVEL0NODES (sizeof(g_level0info)/sizeof(FAR const struct proc_node_s * const))
@@ -763,6 +831,193 @@ static ssize_t proc_stack(FAR struct proc_file_s *procfile,
   return totalsize;
 }
 
+/****************************************************************************
+ * Name: proc_perftime
+ *
+ * Description:
+ *   Format one "<name> <seconds>.<microseconds>" line from a count of
+ *   up_perf_gettime() units.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_TIMESTATS
+static size_t proc_perftime(FAR struct proc_file_s *procfile,
+                            FAR const char *name, uint64_t count,
+                            FAR char *buffer, size_t buflen,
+                            FAR off_t *offset)
+{
+  uint32_t freq = up_perf_getfreq();
+  uint32_t sec;
+  uint32_t usec;
+  size_t linesize;
+
+  sec      = (uint32_t)(count / freq);
+  usec     = (uint32_t)(((count % freq) * USEC_PER_SEC) / freq);
+
+  linesize = snprintf(procfile->line, STATUS_LINELEN, "%-12s%lu.%06lu\n",
+                      name, (unsigned long)sec, (unsigned long)usec);
+  return procfs_memcpy(procfile->line, linesize, buffer, buflen, offset);
+}
+#endif
+
+/****************************************************************************
+ * Name: proc_runtime
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_RUNTIME
+static ssize_t proc_runtime(FAR struct proc_file_s *procfile,
+                            FAR struct tcb_s *tcb, FAR char *buffer,
+                            size_t buflen, off_t offset)
+{
+  uint64_t runtime;
+  size_t remaining;
+  size_t linesize;
+  size_t copysize;
+  size_t totalsize;
+
+  remaining = buflen;
+  totalsize = 0;
+
+  /* Include the current interval if the thread is running now */
+
+  runtime = tcb->run_time;
+  if (tcb->task_state == TSTATE_TASK_RUNNING && tcb->run_count > 0)
+    {
+      runtime += (uint32_t)(up_perf_gettime() - tcb->run_start);
+    }
+
+  /* Show the total run time */
+
+  copysize   = proc_perftime(procfile, "RunTime:", runtime, buffer,
+                             remaining, &offset);
+
+  totalsize += copysize;
+  buffer    += copysize;
+  remaining -= copysize;
+
+  if (totalsize >= buflen)
+    {
+      return totalsize;
+    }
+
+  /* Show the number of times that the thread has been resumed */
+
+  linesize   = snprintf(procfile->line, STATUS_LINELEN, "%-12s%lu\n",
+                        "Switches:", (unsigned long)tcb->run_count);
+  copysize   = procfs_memcpy(procfile->line, linesize, buffer, remaining, &offset);
+
+  totalsize += copysize;
+  return totalsize;
+}
+#endif
+
+/****************************************************************************
+ * Name: proc_latency
+ *
+ * Description:
+ *   Bucket n of the histogram holds wakeup latencies in the range
+ *   [2^(n-1), 2^n) microseconds; the last bucket holds all longer
+ *   latencies.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_LATENCY
+static ssize_t proc_latency(FAR struct proc_file_s *procfile,
+                            FAR struct tcb_s *tcb, FAR char *buffer,
+                            size_t buflen, off_t offset)
+{
+  size_t remaining;
+  size_t linesize;
+  size_t copysize;
+  size_t totalsize;
+  int i;
+
+  remaining = buflen;
+  totalsize = 0;
+
+  /* Show the maximum latency */
+
+  copysize   = proc_perftime(procfile, "MaxLatency:", tcb->lat_max, buffer,
+                             remaining, &offset);
+
+  totalsize += copysize;
+  buffer    += copysize;
+  remaining -= copysize;
+
+  /* Show the histogram */
+
+  for (i = 0; i < CONFIG_SCHED_LATENCY_NBUCKETS; i++)
+    {
+      if (totalsize >= buflen)
+        {
+          return totalsize;
+        }
+
+      if (i < CONFIG_SCHED_LATENCY_NBUCKETS - 1)
+        {
+          linesize = snprintf(procfile->line, STATUS_LINELEN,
+                              " < %10lu us: %lu\n", 1ul << i,
+                              (unsigned long)tcb->lat_hist[i]);
+        }
+      else
+        {
+          linesize = snprintf(procfile->line, STATUS_LINELEN,
+                              ">= %10lu us: %lu\n", 1ul << (i - 1),
+                              (unsigned long)tcb->lat_hist[i]);
+        }
+
+      copysize   = procfs_memcpy(procfile->line, linesize, buffer, remaining,
+                                 &offset);
+
+      totalsize += copysize;
+      buffer    += copysize;
+      remaining -= copysize;
+    }
+
+  return totalsize;
+}
+#endif
+
+/****************************************************************************
+ * Name: proc_critmon
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_CRITMONITOR
+static ssize_t proc_critmon(FAR struct proc_file_s *procfile,
+                            FAR struct tcb_s *tcb, FAR char *buffer,
+                            size_t buflen, off_t offset)
+{
+  size_t remaining;
+  size_t copysize;
+  size_t totalsize;
+
+  remaining = buflen;
+  totalsize = 0;
+
+  /* Show the longest time with interrupts disabled */
+
+  copysize   = proc_perftime(procfile, "CritMax:", tcb->crit_max, buffer,
+                             remaining, &offset);
+
+  totalsize += copysize;
+  buffer    += copysize;
+  remaining -= copysize;
+
+  if (totalsize >= buflen)
+    {
+      return totalsize;
+    }
+
+  /* Show the total time with interrupts disabled */
+
+  copysize   = proc_perftime(procfile, "CritTotal:", tcb->crit_time, buffer,
+                             remaining, &offset);
+
+  totalsize += copysize;
+  return totalsize;
+}
+#endif
+
 /****************************************************************************
  * Name: proc_groupstatus
  ****************************************************************************/
@@ -1180,6 +1435,22 @@ static ssize_t proc_read(FAR struct file *filep, FAR char *buffer,
       ret = proc_stack(procfile, tcb, buffer, buflen, filep->f_pos);
       break;
 
+#ifdef CONFIG_SCHED_RUNTIME
+    case PROC_RUNTIME: /* Accumulated run time */
+      ret = proc_runtime(procfile, tcb, buffer, buflen, filep->f_pos);
+      break;
+#endif
+#ifdef CONFIG_SCHED_LATENCY
+    case PROC_LATENCY: /* Wakeup latency histogram */
+      ret = proc_latency(procfile, tcb, buffer, buflen, filep->f_pos);
+      break;
+#endif
+#ifdef CONFIG_SCHED_CRITMONITOR
+    case PROC_CRITMON: /* Interrupts-off times */
+      ret = proc_critmon(procfile, tcb, buffer, buflen, filep->f_pos);
+      break;
+#endif
+
     case PROC_GROUP_STATUS: /* Task group status */
       ret = proc_groupstatus(procfile, tcb, buffer, buflen, filep->f_pos);
       break;
@@ -595,9 +595,7 @@ static int romfs_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
 
   DEBUGASSERT(rm != NULL);
 
-  /* Only one ioctl command is supported */
-
-  if (cmd == FIOC_MMAP && rm->rm_xipbase && ppv)
+  if ((cmd == FIOC_MMAP || cmd == FIOC_XIPBASE) && rm->rm_xipbase && ppv)
     {
       /* Return the address on the media corresponding to the start of
        * the file.
@@ -607,6 +605,14 @@ static int romfs_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
       return OK;
     }
 
+  /* The offset of the file data on the media identifies the file */
+
+  if (cmd == FIOC_FILEID && arg != 0)
+    {
+      *(FAR uintptr_t *)((uintptr_t)arg) = (uintptr_t)rf->rf_startoffset;
+      return OK;
+    }
+
   ferr("ERROR: Invalid cmd: %d \n", cmd);
   return -ENOTTY;
 }
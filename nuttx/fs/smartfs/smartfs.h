@@ -220,6 +220,20 @@
 #define CONFIG_SMARTFS_USE_SECTOR_BUFFER
 #endif
 
+/* Directory sector access.  With the sector cache, directory sectors are
+ * read and written through the cache; otherwise they go directly to the
+ * SMART block driver.
+ */
+
+#ifndef CONFIG_SMARTFS_SECTOR_CACHE
+#  define smartfs_cache_setup(f)     (OK)
+#  define smartfs_cache_teardown(f)
+#  define smartfs_cache_read(f,r)    FS_IOCTL(f, BIOC_READSECT, (unsigned long)(r))
+#  define smartfs_cache_write(f,r)   FS_IOCTL(f, BIOC_WRITESECT, (unsigned long)(r))
+#  define smartfs_cache_free(f,s)    FS_IOCTL(f, BIOC_FREESECT, (unsigned long)(s))
+#  define smartfs_cache_flush(f)     (OK)
+#endif
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -309,6 +323,71 @@ struct smartfs_ofile_s
                                           * causes the sector to change. */
 };
 
+#ifdef CONFIG_SMARTFS_SECTOR_CACHE
+/* This structure describes one sector held in the directory sector cache.
+ * Bytes dirtylo through dirtyhi-1 of the sector have been changed and not
+ * yet written to the device.
+ */
+
+struct smartfs_cache_s
+{
+  FAR uint8_t              *buffer;     /* Sector data (availbytes) */
+  uint32_t                  age;        /* Time of last use */
+  uint16_t                  sector;     /* Logical sector or 0xffff if unused */
+  uint16_t                  dirtylo;    /* Start of the dirty range */
+  uint16_t                  dirtyhi;    /* End of the dirty range (0: clean) */
+};
+#endif
+
+#ifdef CONFIG_SMARTFS_NAME_INDEX
+/* One name in a directory index:  The hash of the entry name and the
+ * directory sector that holds the entry.
+ */
+
+struct smartfs_idxname_s
+{
+  uint16_t                  hash;       /* Hash of the entry name */
+  uint16_t                  sector;     /* Directory sector holding the entry */
+  uint16_t                  next;       /* Next name in the hash chain */
+};
+
+/* One sector of an indexed directory and its count of free entries */
+
+struct smartfs_idxsect_s
+{
+  uint16_t                  sector;     /* Logical sector number */
+  uint16_t                  nfree;      /* Number of free entries */
+};
+
+/* The in-RAM index of one directory.  The sectors are kept in the order of
+ * the directory chain.
+ */
+
+struct smartfs_dirindex_s
+{
+  FAR struct smartfs_dirindex_s *flink; /* Next index, most recently used first */
+  FAR struct smartfs_idxname_s *names;  /* Name records */
+  FAR struct smartfs_idxsect_s *sects;  /* Directory sectors in chain order */
+  FAR uint16_t             *buckets;    /* Hash buckets */
+  uint16_t                  dirsector;  /* First sector of the directory */
+  uint16_t                  nbuckets;   /* Number of buckets (a power of 2) */
+  uint16_t                  nnames;     /* Number of names in the index */
+  uint16_t                  nused;      /* Number of name records used */
+  uint16_t                  nalloc;     /* Number of name records allocated */
+  uint16_t                  freename;   /* List of released name records */
+  uint16_t                  nsects;     /* Number of directory sectors */
+  uint16_t                  nsectalloc; /* Number of sector records allocated */
+};
+
+/* The state of a search of the index for one name */
+
+struct smartfs_idxpos_s
+{
+  uint16_t                  hash;       /* Hash of the name searched for */
+  uint16_t                  name;       /* Current name record */
+};
+#endif
+
 /* This structure represents the overall mountpoint state.  An instance of this
  * structure is retained as inode private data on each mountpoint that is
  * mounted with a smartfs filesystem.
@@ -327,6 +406,14 @@ struct smartfs_mountpt_s
   char                       *fs_rwbuffer;  /* Read/Write working buffer */
   char                       *fs_workbuffer;/* Working buffer */
   uint8_t                     fs_rootsector;/* Root directory sector num */
+#ifdef CONFIG_SMARTFS_SECTOR_CACHE
+  FAR struct smartfs_cache_s *fs_cache;     /* Directory sector cache */
+  FAR uint8_t                *fs_cachebuf;  /* Data of all cached sectors */
+  uint32_t                    fs_cacheage;  /* Cache use counter */
+#endif
+#ifdef CONFIG_SMARTFS_NAME_INDEX
+  FAR struct smartfs_dirindex_s *fs_index;  /* Directory name indexes */
+#endif
 };
 
 /****************************************************************************
@@ -379,6 +466,62 @@ uint32_t smartfs_rdle32(FAR const void *val);
 
 void smartfs_wrle32(uint8_t *dest, uint32_t val);
 
+#ifdef CONFIG_SMARTFS_SECTOR_CACHE
+/* Directory sector cache (smartfs_cache.c) */
+
+int smartfs_cache_setup(FAR struct smartfs_mountpt_s *fs);
+
+void smartfs_cache_teardown(FAR struct smartfs_mountpt_s *fs);
+
+int smartfs_cache_read(FAR struct smartfs_mountpt_s *fs,
+        FAR struct smart_read_write_s *req);
+
+int smartfs_cache_write(FAR struct smartfs_mountpt_s *fs,
+        FAR const struct smart_read_write_s *req);
+
+int smartfs_cache_free(FAR struct smartfs_mountpt_s *fs, uint16_t sector);
+
+int smartfs_cache_flush(FAR struct smartfs_mountpt_s *fs);
+#endif
+
+#ifdef CONFIG_SMARTFS_NAME_INDEX
+/* Directory name index (smartfs_index.c) */
+
+FAR struct smartfs_dirindex_s *smartfs_index_get(
+        FAR struct smartfs_mountpt_s *fs, uint16_t dirsector);
+
+FAR struct smartfs_dirindex_s *smartfs_index_find(
+        FAR struct smartfs_mountpt_s *fs, uint16_t dirsector);
+
+uint16_t smartfs_index_first(FAR struct smartfs_mountpt_s *fs,
+        FAR struct smartfs_dirindex_s *index, FAR const char *name,
+        FAR struct smartfs_idxpos_s *pos);
+
+uint16_t smartfs_index_next(FAR struct smartfs_dirindex_s *index,
+        FAR struct smartfs_idxpos_s *pos);
+
+uint16_t smartfs_index_freesector(FAR struct smartfs_dirindex_s *index);
+
+int smartfs_index_add(FAR struct smartfs_mountpt_s *fs,
+        FAR struct smartfs_dirindex_s *index, FAR const char *name,
+        uint16_t sector);
+
+void smartfs_index_remove(FAR struct smartfs_mountpt_s *fs,
+        FAR struct smartfs_dirindex_s *index, FAR const char *name,
+        uint16_t sector);
+
+int smartfs_index_addsector(FAR struct smartfs_mountpt_s *fs,
+        FAR struct smartfs_dirindex_s *index, uint16_t sector);
+
+void smartfs_index_remsector(FAR struct smartfs_dirindex_s *index,
+        uint16_t sector);
+
+void smartfs_index_drop(FAR struct smartfs_mountpt_s *fs,
+        uint16_t dirsector);
+
+void smartfs_index_release(FAR struct smartfs_mountpt_s *fs);
+#endif
+
 #if defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS)
 struct smartfs_mountpt_s* smartfs_get_first_mount(void);
 #endif
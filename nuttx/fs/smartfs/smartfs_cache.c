@@ -0,0 +1,398 @@
+/****************************************************************************
+ * fs/smartfs/smartfs_cache.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <debug.h>
+
+#include <nuttx/kmalloc.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/fs/ioctl.h>
+
+#include "smartfs.h"
+
+#ifdef CONFIG_SMARTFS_SECTOR_CACHE
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define SMARTFS_CACHE_NOSECTOR 0xffff
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: smartfs_cache_lookup
+ *
+ * Description:
+ *   Return the cache entry holding 'sector' or NULL if the sector is not
+ *   cached.
+ *
+ ****************************************************************************/
+
+static FAR struct smartfs_cache_s *
+smartfs_cache_lookup(FAR struct smartfs_mountpt_s *fs, uint16_t sector)
+{
+  FAR struct smartfs_cache_s *cache;
+  int i;
+
+  for (i = 0; i < CONFIG_SMARTFS_SECTOR_CACHE_NSECTORS; i++)
+    {
+      cache = &fs->fs_cache[i];
+      if (cache->sector == sector)
+        {
+          cache->age = ++fs->fs_cacheage;
+          return cache;
+        }
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: smartfs_cache_writeback
+ *
+ * Description:
+ *   Write the dirty part of a cached sector to the device.
+ *
+ ****************************************************************************/
+
+static int smartfs_cache_writeback(FAR struct smartfs_mountpt_s *fs,
+                                   FAR struct smartfs_cache_s *cache)
+{
+  struct smart_read_write_s readwrite;
+  int ret;
+
+  if (cache->dirtyhi == 0)
+    {
+      return OK;
+    }
+
+  readwrite.logsector = cache->sector;
+  readwrite.offset    = cache->dirtylo;
+  readwrite.count     = cache->dirtyhi - cache->dirtylo;
+  readwrite.buffer    = &cache->buffer[cache->dirtylo];
+
+  ret = FS_IOCTL(fs, BIOC_WRITESECT, (unsigned long)&readwrite);
+  if (ret < 0)
+    {
+      ferr("ERROR: Error %d writing back sector %d\n", ret, cache->sector);
+      return ret;
+    }
+
+  cache->dirtylo = 0;
+  cache->dirtyhi = 0;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: smartfs_cache_fill
+ *
+ * Description:
+ *   Read 'sector' into the least recently used cache entry, writing back
+ *   the previous contents of that entry if they are dirty.
+ *
+ ****************************************************************************/
+
+static int smartfs_cache_fill(FAR struct smartfs_mountpt_s *fs,
+                              uint16_t sector,
+                              FAR struct smartfs_cache_s **entry)
+{
+  FAR struct smartfs_cache_s *cache;
+  struct smart_read_write_s readwrite;
+  int ret;
+  int i;
+
+  /* Select an unused entry or, if there is none, the least recently used
+   * entry.
+   */
+
+  cache = &fs->fs_cache[0];
+  for (i = 0; i < CONFIG_SMARTFS_SECTOR_CACHE_NSECTORS; i++)
+    {
+      if (fs->fs_cache[i].sector == SMARTFS_CACHE_NOSECTOR)
+        {
+          cache = &fs->fs_cache[i];
+          break;
+        }
+
+      if ((int32_t)(fs->fs_cache[i].age - cache->age) < 0)
+        {
+          cache = &fs->fs_cache[i];
+        }
+    }
+
+  ret = smartfs_cache_writeback(fs, cache);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  /* Read the whole sector into the entry */
+
+  cache->sector       = SMARTFS_CACHE_NOSECTOR;
+  readwrite.logsector = sector;
+  readwrite.offset    = 0;
+  readwrite.count     = fs->fs_llformat.availbytes;
+  readwrite.buffer    = cache->buffer;
+
+  ret = FS_IOCTL(fs, BIOC_READSECT, (unsigned long)&readwrite);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  cache->sector = sector;
+  cache->age    = ++fs->fs_cacheage;
+  *entry        = cache;
+  return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: smartfs_cache_setup
+ *
+ * Description:
+ *   Allocate the directory sector cache of a volume being mounted.
+ *
+ ****************************************************************************/
+
+int smartfs_cache_setup(FAR struct smartfs_mountpt_s *fs)
+{
+  int i;
+
+  fs->fs_cache = (FAR struct smartfs_cache_s *)
+    kmm_zalloc(CONFIG_SMARTFS_SECTOR_CACHE_NSECTORS *
+               sizeof(struct smartfs_cache_s));
+  fs->fs_cachebuf = (FAR uint8_t *)
+    kmm_malloc(CONFIG_SMARTFS_SECTOR_CACHE_NSECTORS *
+               fs->fs_llformat.availbytes);
+
+  if (fs->fs_cache == NULL || fs->fs_cachebuf == NULL)
+    {
+      smartfs_cache_teardown(fs);
+      return -ENOMEM;
+    }
+
+  for (i = 0; i < CONFIG_SMARTFS_SECTOR_CACHE_NSECTORS; i++)
+    {
+      fs->fs_cache[i].buffer = &fs->fs_cachebuf[i * fs->fs_llformat.availbytes];
+      fs->fs_cache[i].sector = SMARTFS_CACHE_NOSECTOR;
+    }
+
+  fs->fs_cacheage = 0;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: smartfs_cache_teardown
+ *
+ * Description:
+ *   Free the directory sector cache.  Dirty sectors are discarded;  the
+ *   caller should flush the cache first.
+ *
+ ****************************************************************************/
+
+void smartfs_cache_teardown(FAR struct smartfs_mountpt_s *fs)
+{
+  if (fs->fs_cache != NULL)
+    {
+      kmm_free(fs->fs_cache);
+      fs->fs_cache = NULL;
+    }
+
+  if (fs->fs_cachebuf != NULL)
+    {
+      kmm_free(fs->fs_cachebuf);
+      fs->fs_cachebuf = NULL;
+    }
+}
+
+/****************************************************************************
+ * Name: smartfs_cache_read
+ *
+ * Description:
+ *   Read part of a directory sector like BIOC_READSECT.  A cached sector is
+ *   copied from RAM.  A read of a whole sector that is not cached brings
+ *   the sector into the cache;  other reads of uncached sectors go to the
+ *   device so that reads of file sector headers do not displace the
+ *   directory sectors.
+ *
+ * Returned Value:
+ *   The number of bytes read on success; a negated errno value on failure.
+ *
+ ****************************************************************************/
+
+int smartfs_cache_read(FAR struct smartfs_mountpt_s *fs,
+                       FAR struct smart_read_write_s *req)
+{
+  FAR struct smartfs_cache_s *cache;
+  int ret;
+
+  cache = smartfs_cache_lookup(fs, req->logsector);
+  if (cache == NULL)
+    {
+      if (req->offset != 0 || req->count != fs->fs_llformat.availbytes)
+        {
+          return FS_IOCTL(fs, BIOC_READSECT, (unsigned long)req);
+        }
+
+      ret = smartfs_cache_fill(fs, req->logsector, &cache);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  memcpy((FAR uint8_t *)req->buffer, &cache->buffer[req->offset],
+         req->count);
+  return req->count;
+}
+
+/****************************************************************************
+ * Name: smartfs_cache_write
+ *
+ * Description:
+ *   Write part of a directory sector like BIOC_WRITESECT.  The data is
+ *   copied to the cached sector, reading the sector into the cache first
+ *   if needed, and is written to the device later.
+ *
+ ****************************************************************************/
+
+int smartfs_cache_write(FAR struct smartfs_mountpt_s *fs,
+                        FAR const struct smart_read_write_s *req)
+{
+  FAR struct smartfs_cache_s *cache;
+  int ret;
+
+  DEBUGASSERT(req->offset + req->count <= fs->fs_llformat.availbytes);
+
+  cache = smartfs_cache_lookup(fs, req->logsector);
+  if (cache == NULL)
+    {
+      ret = smartfs_cache_fill(fs, req->logsector, &cache);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  memcpy(&cache->buffer[req->offset], req->buffer, req->count);
+
+  /* Extend the dirty range to include the new data */
+
+  if (cache->dirtyhi == 0)
+    {
+      cache->dirtylo = req->offset;
+      cache->dirtyhi = req->offset + req->count;
+    }
+  else
+    {
+      cache->dirtylo = MIN(cache->dirtylo, req->offset);
+      cache->dirtyhi = MAX(cache->dirtyhi, req->offset + req->count);
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: smartfs_cache_free
+ *
+ * Description:
+ *   Release a logical sector like BIOC_FREESECT, first discarding any
+ *   cached copy of the sector.
+ *
+ ****************************************************************************/
+
+int smartfs_cache_free(FAR struct smartfs_mountpt_s *fs, uint16_t sector)
+{
+  FAR struct smartfs_cache_s *cache;
+
+  cache = smartfs_cache_lookup(fs, sector);
+  if (cache != NULL)
+    {
+      cache->sector  = SMARTFS_CACHE_NOSECTOR;
+      cache->dirtylo = 0;
+      cache->dirtyhi = 0;
+    }
+
+  return FS_IOCTL(fs, BIOC_FREESECT, (unsigned long)sector);
+}
+
+/****************************************************************************
+ * Name: smartfs_cache_flush
+ *
+ * Description:
+ *   Write all dirty cached sectors to the device.
+ *
+ ****************************************************************************/
+
+int smartfs_cache_flush(FAR struct smartfs_mountpt_s *fs)
+{
+  int ret = OK;
+  int err;
+  int i;
+
+  if (fs->fs_cache == NULL)
+    {
+      return OK;
+    }
+
+  for (i = 0; i < CONFIG_SMARTFS_SECTOR_CACHE_NSECTORS; i++)
+    {
+      err = smartfs_cache_writeback(fs, &fs->fs_cache[i]);
+      if (err < 0 && ret == OK)
+        {
+          ret = err;
+        }
+    }
+
+  return ret;
+}
+
+#endif /* CONFIG_SMARTFS_SECTOR_CACHE */
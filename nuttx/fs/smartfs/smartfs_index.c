@@ -0,0 +1,772 @@
+/****************************************************************************
+ * fs/smartfs/smartfs_index.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <debug.h>
+
+#include <nuttx/kmalloc.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/fs/ioctl.h>
+
+#include "smartfs.h"
+
+#ifdef CONFIG_SMARTFS_NAME_INDEX
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define SMARTFS_IDX_NONE       0xffff
+#define SMARTFS_IDX_MINBUCKETS 16
+
+#ifdef CONFIG_SMARTFS_ALIGNED_ACCESS
+#  define SMARTFS_ENTRYFLAGS(e) smartfs_rdle16(&(e)->flags)
+#else
+#  define SMARTFS_ENTRYFLAGS(e) ((e)->flags)
+#endif
+
+/* An entry is active if it is in use and not deleted.  It is free if it
+ * is erased or in use but deleted.  These are the same tests applied by
+ * smartfs_finddirentry() and smartfs_createentry().
+ */
+
+#define SMARTFS_ENTRY_ACTIVE(f) \
+  (((f) & SMARTFS_DIRENT_EMPTY) != (SMARTFS_ERASEDSTATE_16BIT & SMARTFS_DIRENT_EMPTY) && \
+   ((f) & SMARTFS_DIRENT_ACTIVE) == (SMARTFS_ERASEDSTATE_16BIT & SMARTFS_DIRENT_ACTIVE))
+
+#define SMARTFS_ENTRY_FREE(f) \
+  ((f) == SMARTFS_ERASEDSTATE_16BIT || \
+   ((f) & (SMARTFS_DIRENT_EMPTY | SMARTFS_DIRENT_ACTIVE)) == \
+   (~SMARTFS_ERASEDSTATE_16BIT & (SMARTFS_DIRENT_EMPTY | SMARTFS_DIRENT_ACTIVE)))
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: smartfs_index_hash
+ *
+ * Description:
+ *   Hash an entry name.  Only the first 'namesize' characters take part,
+ *   just as only those are compared when searching a directory.
+ *
+ ****************************************************************************/
+
+static uint16_t smartfs_index_hash(FAR const char *name, uint16_t namesize)
+{
+  uint32_t hash = 2166136261ul;
+
+  while (namesize-- > 0 && *name != '\0')
+    {
+      hash ^= (uint8_t)*name++;
+      hash *= 16777619ul;
+    }
+
+  return (uint16_t)(hash ^ (hash >> 16));
+}
+
+/****************************************************************************
+ * Name: smartfs_index_sect
+ *
+ * Description:
+ *   Return the sector record for 'sector' or NULL if the sector is not part
+ *   of the indexed directory.
+ *
+ ****************************************************************************/
+
+static FAR struct smartfs_idxsect_s *
+smartfs_index_sect(FAR struct smartfs_dirindex_s *index, uint16_t sector)
+{
+  int i;
+
+  for (i = 0; i < index->nsects; i++)
+    {
+      if (index->sects[i].sector == sector)
+        {
+          return &index->sects[i];
+        }
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: smartfs_index_free
+ *
+ * Description:
+ *   Free the memory of one directory index.
+ *
+ ****************************************************************************/
+
+static void smartfs_index_free(FAR struct smartfs_dirindex_s *index)
+{
+  if (index->names != NULL)
+    {
+      kmm_free(index->names);
+    }
+
+  if (index->sects != NULL)
+    {
+      kmm_free(index->sects);
+    }
+
+  if (index->buckets != NULL)
+    {
+      kmm_free(index->buckets);
+    }
+
+  kmm_free(index);
+}
+
+/****************************************************************************
+ * Name: smartfs_index_rehash
+ *
+ * Description:
+ *   Resize the bucket array to 'nbuckets' (a power of 2) and re-link all
+ *   names.
+ *
+ ****************************************************************************/
+
+static int smartfs_index_rehash(FAR struct smartfs_dirindex_s *index,
+                                uint16_t nbuckets)
+{
+  FAR uint16_t *buckets;
+  FAR struct smartfs_idxname_s *name;
+  uint16_t bucket;
+  int i;
+
+  buckets = (FAR uint16_t *)kmm_realloc(index->buckets,
+                                        nbuckets * sizeof(uint16_t));
+  if (buckets == NULL)
+    {
+      return -ENOMEM;
+    }
+
+  memset(buckets, 0xff, nbuckets * sizeof(uint16_t));
+  index->buckets  = buckets;
+  index->nbuckets = nbuckets;
+
+  for (i = 0; i < index->nused; i++)
+    {
+      name = &index->names[i];
+      if (name->sector != SMARTFS_IDX_NONE)
+        {
+          bucket          = name->hash & (nbuckets - 1);
+          name->next      = buckets[bucket];
+          buckets[bucket] = i;
+        }
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: smartfs_index_insert
+ *
+ * Description:
+ *   Add a name record to the index.
+ *
+ ****************************************************************************/
+
+static int smartfs_index_insert(FAR struct smartfs_dirindex_s *index,
+                                uint16_t hash, uint16_t sector)
+{
+  FAR struct smartfs_idxname_s *names;
+  FAR struct smartfs_idxname_s *name;
+  uint16_t bucket;
+  uint16_t ndx;
+  uint16_t nalloc;
+
+  if (index->freename != SMARTFS_IDX_NONE)
+    {
+      ndx             = index->freename;
+      index->freename = index->names[ndx].next;
+    }
+  else
+    {
+      if (index->nused >= index->nalloc)
+        {
+          if (index->nalloc >= SMARTFS_IDX_NONE / 2)
+            {
+              return -ENOMEM;
+            }
+
+          nalloc = index->nalloc ? 2 * index->nalloc : SMARTFS_IDX_MINBUCKETS;
+          names  = (FAR struct smartfs_idxname_s *)
+            kmm_realloc(index->names,
+                        nalloc * sizeof(struct smartfs_idxname_s));
+          if (names == NULL)
+            {
+              return -ENOMEM;
+            }
+
+          index->names  = names;
+          index->nalloc = nalloc;
+        }
+
+      ndx = index->nused++;
+    }
+
+  name                   = &index->names[ndx];
+  bucket                 = hash & (index->nbuckets - 1);
+  name->hash             = hash;
+  name->sector           = sector;
+  name->next             = index->buckets[bucket];
+  index->buckets[bucket] = ndx;
+  index->nnames++;
+
+  /* Keep the hash chains short.  Failure to grow the bucket array is not
+   * an error; the chains just get longer.
+   */
+
+  if (index->nnames > 2 * index->nbuckets && index->nbuckets < 0x4000)
+    {
+      (void)smartfs_index_rehash(index, 2 * index->nbuckets);
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: smartfs_index_append
+ *
+ * Description:
+ *   Add a sector at the end of the directory chain.
+ *
+ ****************************************************************************/
+
+static int smartfs_index_append(FAR struct smartfs_dirindex_s *index,
+                                uint16_t sector, uint16_t nfree)
+{
+  FAR struct smartfs_idxsect_s *sects;
+  uint16_t nalloc;
+
+  if (index->nsects >= index->nsectalloc)
+    {
+      nalloc = index->nsectalloc ? 2 * index->nsectalloc : 4;
+      sects  = (FAR struct smartfs_idxsect_s *)
+        kmm_realloc(index->sects, nalloc * sizeof(struct smartfs_idxsect_s));
+      if (sects == NULL)
+        {
+          return -ENOMEM;
+        }
+
+      index->sects      = sects;
+      index->nsectalloc = nalloc;
+    }
+
+  index->sects[index->nsects].sector = sector;
+  index->sects[index->nsects].nfree  = nfree;
+  index->nsects++;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: smartfs_index_build
+ *
+ * Description:
+ *   Scan the directory chain and record each active entry and the number
+ *   of free entries of each sector.  Uses the mountpoint read/write buffer.
+ *
+ ****************************************************************************/
+
+static int smartfs_index_build(FAR struct smartfs_mountpt_s *fs,
+                               FAR struct smartfs_dirindex_s *index)
+{
+  FAR struct smartfs_chain_header_s *header;
+  FAR struct smartfs_entry_header_s *entry;
+  struct smart_read_write_s readwrite;
+  uint16_t entrysize;
+  uint16_t offset;
+  uint16_t sector;
+  uint16_t nfree;
+  uint16_t flags;
+  int ret;
+
+  ret = smartfs_index_rehash(index, SMARTFS_IDX_MINBUCKETS);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  entrysize = sizeof(struct smartfs_entry_header_s) + fs->fs_llformat.namesize;
+  header    = (FAR struct smartfs_chain_header_s *)fs->fs_rwbuffer;
+  sector    = index->dirsector;
+
+  while (sector != SMARTFS_ERASEDSTATE_16BIT)
+    {
+      /* A chain longer than the volume must contain a loop */
+
+      if (index->nsects >= fs->fs_llformat.nsectors)
+        {
+          return -EIO;
+        }
+
+      readwrite.logsector = sector;
+      readwrite.offset    = 0;
+      readwrite.count     = fs->fs_llformat.availbytes;
+      readwrite.buffer    = (FAR uint8_t *)fs->fs_rwbuffer;
+
+      ret = smartfs_cache_read(fs, &readwrite);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      nfree = 0;
+      for (offset = sizeof(struct smartfs_chain_header_s);
+           offset + entrysize < readwrite.count;
+           offset += entrysize)
+        {
+          entry = (FAR struct smartfs_entry_header_s *)&fs->fs_rwbuffer[offset];
+          flags = SMARTFS_ENTRYFLAGS(entry);
+
+          if (SMARTFS_ENTRY_FREE(flags))
+            {
+              nfree++;
+            }
+          else if (SMARTFS_ENTRY_ACTIVE(flags))
+            {
+              ret = smartfs_index_insert(index,
+                      smartfs_index_hash(entry->name, fs->fs_llformat.namesize),
+                      sector);
+              if (ret < 0)
+                {
+                  return ret;
+                }
+            }
+        }
+
+      ret = smartfs_index_append(index, sector, nfree);
+      if (ret < 0)
+        {
+          return ret;
+        }
+
+      sector = SMARTFS_NEXTSECTOR(header);
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: smartfs_index_unlink
+ *
+ * Description:
+ *   Remove a directory index from the list of the mountpoint.
+ *
+ ****************************************************************************/
+
+static void smartfs_index_unlink(FAR struct smartfs_mountpt_s *fs,
+                                 FAR struct smartfs_dirindex_s *index)
+{
+  FAR struct smartfs_dirindex_s *prev;
+
+  if (fs->fs_index == index)
+    {
+      fs->fs_index = index->flink;
+      return;
+    }
+
+  for (prev = fs->fs_index; prev != NULL; prev = prev->flink)
+    {
+      if (prev->flink == index)
+        {
+          prev->flink = index->flink;
+          return;
+        }
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: smartfs_index_find
+ *
+ * Description:
+ *   Return the index of the directory whose first sector is 'dirsector' or
+ *   NULL if the directory is not indexed.
+ *
+ ****************************************************************************/
+
+FAR struct smartfs_dirindex_s *
+smartfs_index_find(FAR struct smartfs_mountpt_s *fs, uint16_t dirsector)
+{
+  FAR struct smartfs_dirindex_s *index;
+
+  for (index = fs->fs_index; index != NULL; index = index->flink)
+    {
+      if (index->dirsector == dirsector)
+        {
+          return index;
+        }
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: smartfs_index_get
+ *
+ * Description:
+ *   Return the index of the directory whose first sector is 'dirsector',
+ *   building it if the directory is not yet indexed.  Building the index
+ *   uses the mountpoint read/write buffer.  NULL is returned if the index
+ *   cannot be built;  the caller must then scan the directory chain.
+ *
+ ****************************************************************************/
+
+FAR struct smartfs_dirindex_s *
+smartfs_index_get(FAR struct smartfs_mountpt_s *fs, uint16_t dirsector)
+{
+  FAR struct smartfs_dirindex_s **link;
+  FAR struct smartfs_dirindex_s *index;
+  int ndirs;
+  int ret;
+
+  /* Move an existing index to the head of the list */
+
+  index = smartfs_index_find(fs, dirsector);
+  if (index != NULL)
+    {
+      if (fs->fs_index != index)
+        {
+          smartfs_index_unlink(fs, index);
+          index->flink = fs->fs_index;
+          fs->fs_index = index;
+        }
+
+      return index;
+    }
+
+  /* Discard the least recently used indexes to make room for a new one */
+
+  link  = &fs->fs_index;
+  ndirs = 1;
+  while (*link != NULL && ndirs < CONFIG_SMARTFS_NAME_INDEX_NDIRS)
+    {
+      link = &(*link)->flink;
+      ndirs++;
+    }
+
+  while (*link != NULL)
+    {
+      index = *link;
+      *link = index->flink;
+      smartfs_index_free(index);
+    }
+
+  /* Build a new index */
+
+  index = (FAR struct smartfs_dirindex_s *)
+    kmm_zalloc(sizeof(struct smartfs_dirindex_s));
+  if (index == NULL)
+    {
+      return NULL;
+    }
+
+  index->dirsector = dirsector;
+  index->freename  = SMARTFS_IDX_NONE;
+
+  ret = smartfs_index_build(fs, index);
+  if (ret < 0)
+    {
+      ferr("ERROR: Failed to index directory %d: %d\n", dirsector, ret);
+      smartfs_index_free(index);
+      return NULL;
+    }
+
+  index->flink = fs->fs_index;
+  fs->fs_index = index;
+  return index;
+}
+
+/****************************************************************************
+ * Name: smartfs_index_first / smartfs_index_next
+ *
+ * Description:
+ *   Iterate through the directory sectors that may hold an entry called
+ *   'name'.  A sector may be returned more than once.  The end of the
+ *   iteration is indicated by SMARTFS_ERASEDSTATE_16BIT.
+ *
+ ****************************************************************************/
+
+uint16_t smartfs_index_next(FAR struct smartfs_dirindex_s *index,
+                            FAR struct smartfs_idxpos_s *pos)
+{
+  FAR struct smartfs_idxname_s *name;
+
+  while (pos->name != SMARTFS_IDX_NONE)
+    {
+      name      = &index->names[pos->name];
+      pos->name = name->next;
+
+      if (name->hash == pos->hash)
+        {
+          return name->sector;
+        }
+    }
+
+  return SMARTFS_ERASEDSTATE_16BIT;
+}
+
+uint16_t smartfs_index_first(FAR struct smartfs_mountpt_s *fs,
+                             FAR struct smartfs_dirindex_s *index,
+                             FAR const char *name,
+                             FAR struct smartfs_idxpos_s *pos)
+{
+  pos->hash = smartfs_index_hash(name, fs->fs_llformat.namesize);
+  pos->name = index->buckets[pos->hash & (index->nbuckets - 1)];
+  return smartfs_index_next(index, pos);
+}
+
+/****************************************************************************
+ * Name: smartfs_index_freesector
+ *
+ * Description:
+ *   Return the first sector of the directory chain that has a free entry
+ *   or, if there is none, the last sector of the chain.  This is where
+ *   smartfs_createentry() should start its search.
+ *
+ ****************************************************************************/
+
+uint16_t smartfs_index_freesector(FAR struct smartfs_dirindex_s *index)
+{
+  int i;
+
+  for (i = 0; i < index->nsects; i++)
+    {
+      if (index->sects[i].nfree > 0)
+        {
+          return index->sects[i].sector;
+        }
+    }
+
+  return index->nsects > 0 ? index->sects[index->nsects - 1].sector :
+                             index->dirsector;
+}
+
+/****************************************************************************
+ * Name: smartfs_index_add
+ *
+ * Description:
+ *   Record a new entry created in 'sector'.  If the index cannot be
+ *   updated, it is discarded and must not be used by the caller again.
+ *
+ ****************************************************************************/
+
+int smartfs_index_add(FAR struct smartfs_mountpt_s *fs,
+                      FAR struct smartfs_dirindex_s *index,
+                      FAR const char *name, uint16_t sector)
+{
+  FAR struct smartfs_idxsect_s *sect;
+  int ret;
+
+  ret = smartfs_index_insert(index,
+                             smartfs_index_hash(name, fs->fs_llformat.namesize),
+                             sector);
+  if (ret < 0)
+    {
+      smartfs_index_unlink(fs, index);
+      smartfs_index_free(index);
+      return ret;
+    }
+
+  sect = smartfs_index_sect(index, sector);
+  if (sect != NULL && sect->nfree > 0)
+    {
+      sect->nfree--;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: smartfs_index_remove
+ *
+ * Description:
+ *   Forget an entry of 'sector' that has been deleted.  The entry becomes a
+ *   free entry of the sector.
+ *
+ ****************************************************************************/
+
+void smartfs_index_remove(FAR struct smartfs_mountpt_s *fs,
+                          FAR struct smartfs_dirindex_s *index,
+                          FAR const char *name, uint16_t sector)
+{
+  FAR struct smartfs_idxsect_s *sect;
+  FAR struct smartfs_idxname_s *rec;
+  FAR uint16_t *link;
+  uint16_t hash;
+  uint16_t ndx;
+
+  hash = smartfs_index_hash(name, fs->fs_llformat.namesize);
+  link = &index->buckets[hash & (index->nbuckets - 1)];
+
+  for (ndx = *link; ndx != SMARTFS_IDX_NONE; ndx = *link)
+    {
+      rec = &index->names[ndx];
+      if (rec->hash == hash && rec->sector == sector)
+        {
+          *link           = rec->next;
+          rec->sector     = SMARTFS_IDX_NONE;
+          rec->next       = index->freename;
+          index->freename = ndx;
+          index->nnames--;
+          break;
+        }
+
+      link = &rec->next;
+    }
+
+  sect = smartfs_index_sect(index, sector);
+  if (sect != NULL)
+    {
+      sect->nfree++;
+    }
+}
+
+/****************************************************************************
+ * Name: smartfs_index_addsector
+ *
+ * Description:
+ *   Record a new, empty sector chained at the end of the directory.  If
+ *   the index cannot be updated, it is discarded and must not be used by
+ *   the caller again.
+ *
+ ****************************************************************************/
+
+int smartfs_index_addsector(FAR struct smartfs_mountpt_s *fs,
+                            FAR struct smartfs_dirindex_s *index,
+                            uint16_t sector)
+{
+  uint16_t entrysize;
+  uint16_t nfree;
+  int ret;
+
+  /* Count the entries that smartfs_createentry() can use in the sector */
+
+  entrysize = sizeof(struct smartfs_entry_header_s) + fs->fs_llformat.namesize;
+  nfree     = (fs->fs_llformat.availbytes -
+               sizeof(struct smartfs_chain_header_s) - 1) / entrysize;
+
+  ret = smartfs_index_append(index, sector, nfree);
+  if (ret < 0)
+    {
+      smartfs_index_unlink(fs, index);
+      smartfs_index_free(index);
+    }
+
+  return ret;
+}
+
+/****************************************************************************
+ * Name: smartfs_index_remsector
+ *
+ * Description:
+ *   Forget a sector that has been removed from the directory chain.
+ *
+ ****************************************************************************/
+
+void smartfs_index_remsector(FAR struct smartfs_dirindex_s *index,
+                             uint16_t sector)
+{
+  int i;
+
+  for (i = 0; i < index->nsects; i++)
+    {
+      if (index->sects[i].sector == sector)
+        {
+          memmove(&index->sects[i], &index->sects[i + 1],
+                  (index->nsects - i - 1) * sizeof(struct smartfs_idxsect_s));
+          index->nsects--;
+          break;
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: smartfs_index_drop
+ *
+ * Description:
+ *   Discard the index of a directory that is being deleted.
+ *
+ ****************************************************************************/
+
+void smartfs_index_drop(FAR struct smartfs_mountpt_s *fs, uint16_t dirsector)
+{
+  FAR struct smartfs_dirindex_s *index;
+
+  index = smartfs_index_find(fs, dirsector);
+  if (index != NULL)
+    {
+      smartfs_index_unlink(fs, index);
+      smartfs_index_free(index);
+    }
+}
+
+/****************************************************************************
+ * Name: smartfs_index_release
+ *
+ * Description:
+ *   Discard all directory indexes of a volume being unmounted.
+ *
+ ****************************************************************************/
+
+void smartfs_index_release(FAR struct smartfs_mountpt_s *fs)
+{
+  FAR struct smartfs_dirindex_s *index;
+
+  while (fs->fs_index != NULL)
+    {
+      index        = fs->fs_index;
+      fs->fs_index = index->flink;
+      smartfs_index_free(index);
+    }
+}
+
+#endif /* CONFIG_SMARTFS_NAME_INDEX */
@@ -117,6 +117,8 @@ static int     smartfs_stat(FAR struct inode *mountpt,
                         FAR const char *relpath,
                         FAR struct stat *buf);
 
+static int     smartfs_sync_internal(struct smartfs_mountpt_s *fs,
+                        struct smartfs_ofile_s *sf);
 static off_t smartfs_seek_internal(struct smartfs_mountpt_s *fs,
                         struct smartfs_ofile_s *sf,
                         off_t offset, int whence);
@@ -396,14 +398,14 @@ static int smartfs_close(FAR struct file *filep)
   fs    = inode->i_private;
   sf    = filep->f_priv;
 
-  /* Sync the file */
-
-  smartfs_sync(filep);
-
   /* Take the semaphore */
 
   smartfs_semtake(fs);
 
+  /* Sync the file */
+
+  (void)smartfs_sync_internal(fs, sf);
+
   /* Check if we are the last one with a reference to the file and
    * only close if we are. */
 
@@ -1232,6 +1234,12 @@ static int smartfs_sync(FAR struct file *filep)
   smartfs_semtake(fs);
 
   ret = smartfs_sync_internal(fs, sf);
+  if (ret >= 0)
+    {
+      /* Also write back the directory sectors held in the cache */
+
+      ret = smartfs_cache_flush(fs);
+    }
 
   smartfs_semgive(fs);
   return ret;
@@ -1407,7 +1415,7 @@ static int smartfs_readdir(struct inode *mountpt, struct fs_dirent_s *dir)
       readwrite.count = fs->fs_llformat.availbytes;
       readwrite.buffer = (uint8_t *)fs->fs_rwbuffer;
       readwrite.offset = 0;
-      ret = FS_IOCTL(fs, BIOC_READSECT, (unsigned long) &readwrite);
+      ret = smartfs_cache_read(fs, &readwrite);
       if (ret < 0)
         {
           goto errout_with_semaphore;
@@ -1951,6 +1959,9 @@ int smartfs_rename(struct inode *mountpt, const char *oldrelpath,
   uint16_t                  type;
   struct smartfs_entry_header_s *direntry;
   struct smart_read_write_s readwrite;
+#ifdef CONFIG_SMARTFS_NAME_INDEX
+  FAR struct smartfs_dirindex_s *index;
+#endif
 
   /* Sanity checks */
 
@@ -2009,7 +2020,7 @@ int smartfs_rename(struct inode *mountpt, const char *oldrelpath,
       readwrite.offset = 0;
       readwrite.count = fs->fs_llformat.availbytes;
       readwrite.buffer = (uint8_t *) fs->fs_rwbuffer;
-      ret = FS_IOCTL(fs, BIOC_READSECT, (unsigned long) &readwrite);
+      ret = smartfs_cache_read(fs, &readwrite);
       if (ret < 0)
         {
           ferr("ERROR: Error %d reading sector %d data\n",
@@ -2029,13 +2040,21 @@ int smartfs_rename(struct inode *mountpt, const char *oldrelpath,
       readwrite.offset = oldentry.doffset;
       readwrite.count = sizeof(direntry->flags);
       readwrite.buffer = (uint8_t *) &direntry->flags;
-      ret = FS_IOCTL(fs, BIOC_WRITESECT, (unsigned long) &readwrite);
+      ret = smartfs_cache_write(fs, &readwrite);
       if (ret < 0)
         {
           ferr("ERROR: Error %d writing flag bytes for sector %d\n",
                ret, readwrite.logsector);
           goto errout_with_semaphore;
         }
+
+#ifdef CONFIG_SMARTFS_NAME_INDEX
+      index = smartfs_index_find(fs, oldentry.dfirst);
+      if (index != NULL)
+        {
+          smartfs_index_remove(fs, index, oldentry.name, oldentry.dsector);
+        }
+#endif
     }
   else
     {
@@ -244,6 +244,15 @@ int smartfs_mount(struct smartfs_mountpt_s *fs, bool writeable)
       goto errout;
     }
 
+  /* Allocate the directory sector cache */
+
+  ret = smartfs_cache_setup(fs);
+  if (ret < 0)
+    {
+      ferr("ERROR: Failed to allocate the sector cache: %d\n", ret);
+      goto errout;
+    }
+
   /* Allocate a read/write buffer */
 
 #ifdef CONFIG_SMARTFS_MULTI_ROOT_DIRS
@@ -350,6 +359,16 @@ int smartfs_unmount(struct smartfs_mountpt_s *fs)
   int           found = FALSE;
 #endif
 
+  /* Write back any directory sectors still held in the cache */
+
+  ret = smartfs_cache_flush(fs);
+
+  /* Let the block driver write any state that it caches, such as the SMART
+   * checkpoint, so that the next mount finds the volume clean.
+   */
+
+  (void)FS_IOCTL(fs, BIOC_FLUSH, 0);
+
 #if defined(CONFIG_SMARTFS_MULTI_ROOT_DIRS) || \
   (defined(CONFIG_FS_PROCFS) && !defined(CONFIG_FS_PROCFS_EXCLUDE_SMARTFS))
   /* Start at the head of the mounts and search for our entry.  Also
@@ -459,6 +478,11 @@ int smartfs_unmount(struct smartfs_mountpt_s *fs)
   kmm_free(fs->fs_workbuffer);
 #endif
 
+  smartfs_cache_teardown(fs);
+#ifdef CONFIG_SMARTFS_NAME_INDEX
+  smartfs_index_release(fs);
+#endif
+
   return ret;
 }
 
@@ -494,6 +518,10 @@ int smartfs_finddirentry(struct smartfs_mountpt_s *fs,
   struct      smartfs_chain_header_s *header;
   struct      smart_read_write_s readwrite;
   struct      smartfs_entry_header_s *entry;
+#ifdef CONFIG_SMARTFS_NAME_INDEX
+  FAR struct  smartfs_dirindex_s *index;
+  struct      smartfs_idxpos_s pos;
+#endif
 
   /* Initialize directory level zero as the root sector */
 
@@ -577,9 +605,23 @@ int smartfs_finddirentry(struct smartfs_mountpt_s *fs,
 
           dirsector = dirstack[depth];
 
+#ifdef CONFIG_SMARTFS_NAME_INDEX
+          /* If the directory is indexed, visit only the sectors that the
+           * index gives for this name instead of the whole chain.
+           */
+
+          index = smartfs_index_get(fs, dirsector);
+          if (index != NULL)
+            {
+              dirsector = smartfs_index_first(fs, index, fs->fs_workbuffer,
+                                              &pos);
+            }
+#endif
+
           /* Read the directory */
 
           offset = 0xFFFF;
+          readwrite.count = 0;
 
 #if CONFIG_SMARTFS_ERASEDSTATE == 0xFF
           while (dirsector != 0xFFFF)
@@ -593,7 +635,7 @@ int smartfs_finddirentry(struct smartfs_mountpt_s *fs,
               readwrite.count = fs->fs_llformat.availbytes;
               readwrite.buffer = (uint8_t *)fs->fs_rwbuffer;
               readwrite.offset = 0;
-              ret = FS_IOCTL(fs, BIOC_READSECT, (unsigned long) &readwrite);
+              ret = smartfs_cache_read(fs, &readwrite);
               if (ret < 0)
                 {
                   goto errout;
@@ -602,7 +644,16 @@ int smartfs_finddirentry(struct smartfs_mountpt_s *fs,
               /* Point to next sector in chain */
 
               header = (struct smartfs_chain_header_s *) fs->fs_rwbuffer;
-              dirsector = SMARTFS_NEXTSECTOR(header);
+#ifdef CONFIG_SMARTFS_NAME_INDEX
+              if (index != NULL)
+                {
+                  dirsector = smartfs_index_next(index, &pos);
+                }
+              else
+#endif
+                {
+                  dirsector = SMARTFS_NEXTSECTOR(header);
+                }
 
               /* Search for the entry */
 
@@ -837,6 +888,9 @@ int smartfs_createentry(FAR struct smartfs_mountpt_s *fs,
   uint16_t  entrysize;
   struct    smartfs_entry_header_s *entry;
   struct    smartfs_chain_header_s *chainheader;
+#ifdef CONFIG_SMARTFS_NAME_INDEX
+  FAR struct smartfs_dirindex_s *index;
+#endif
 
   /* Start at the 1st sector in the parent directory */
 
@@ -852,6 +906,18 @@ int smartfs_createentry(FAR struct smartfs_mountpt_s *fs,
       return -ENAMETOOLONG;
     }
 
+#ifdef CONFIG_SMARTFS_NAME_INDEX
+  /* If the directory is indexed, start at the first sector known to have
+   * a free entry.
+   */
+
+  index = smartfs_index_get(fs, parentdirsector);
+  if (index != NULL)
+    {
+      psector = smartfs_index_freesector(index);
+    }
+#endif
+
   /* Read the parent directory sector and find a place to insert
    * the new entry.
    */
@@ -864,7 +930,7 @@ int smartfs_createentry(FAR struct smartfs_mountpt_s *fs,
       readwrite.count = fs->fs_llformat.availbytes;
       readwrite.offset = 0;
       readwrite.buffer = (uint8_t *) fs->fs_rwbuffer;
-      ret = FS_IOCTL(fs, BIOC_READSECT, (unsigned long) &readwrite);
+      ret = smartfs_cache_read(fs, &readwrite);
       if (ret < 0)
         {
           goto errout;
@@ -936,12 +1002,20 @@ int smartfs_createentry(FAR struct smartfs_mountpt_s *fs,
               nextsector);
           readwrite.count = sizeof(uint16_t);
           readwrite.buffer = chainheader->nextsector;
-          ret = FS_IOCTL(fs, BIOC_WRITESECT, (unsigned long) &readwrite);
+          ret = smartfs_cache_write(fs, &readwrite);
           if (ret < 0)
             {
               ferr("ERROR: Error chaining sector %d\n", nextsector);
               goto errout;
             }
+
+#ifdef CONFIG_SMARTFS_NAME_INDEX
+          if (index != NULL &&
+              smartfs_index_addsector(fs, index, nextsector) < 0)
+            {
+              index = NULL;
+            }
+#endif
         }
 
       /* Now update to the next sector */
@@ -1047,17 +1121,25 @@ int smartfs_createentry(FAR struct smartfs_mountpt_s *fs,
   readwrite.offset = offset;
   readwrite.count = entrysize;
   readwrite.buffer = (uint8_t *) &fs->fs_rwbuffer[offset];
-  ret = FS_IOCTL(fs, BIOC_WRITESECT, (unsigned long) &readwrite);
+  ret = smartfs_cache_write(fs, &readwrite);
   if (ret < 0)
     {
       goto errout;
     }
 
+#ifdef CONFIG_SMARTFS_NAME_INDEX
+  if (index != NULL)
+    {
+      (void)smartfs_index_add(fs, index, filename, psector);
+    }
+#endif
+
   /* Now fill in the entry */
 
   direntry->firstsector = nextsector;
   direntry->dsector = psector;
   direntry->doffset = offset;
+  direntry->dfirst = parentdirsector;
 #ifdef CONFIG_SMARTFS_ALIGNED_ACCESS
   direntry->flags = smartfs_rdle16(&entry->flags);
   direntry->utc = smartfs_rdle32(&entry->utc);
@@ -1103,6 +1185,9 @@ int smartfs_deleteentry(struct smartfs_mountpt_s *fs,
   struct smartfs_entry_header_s  *direntry;
   struct smartfs_chain_header_s  *header;
   struct smart_read_write_s       readwrite;
+#ifdef CONFIG_SMARTFS_NAME_INDEX
+  FAR struct smartfs_dirindex_s  *index;
+#endif
 
   /* Okay, delete the file.  Loop through each sector and release them
    *
@@ -1128,7 +1213,7 @@ int smartfs_deleteentry(struct smartfs_mountpt_s *fs,
 
       sector = nextsector;
       readwrite.logsector = sector;
-      ret = FS_IOCTL(fs, BIOC_READSECT, (unsigned long) &readwrite);
+      ret = smartfs_cache_read(fs, &readwrite);
       if (ret < 0)
         {
           ferr("ERROR: Error reading sector %d\n", nextsector);
@@ -1138,16 +1223,25 @@ int smartfs_deleteentry(struct smartfs_mountpt_s *fs,
       /* Release this sector */
 
       nextsector = SMARTFS_NEXTSECTOR(header);
-      ret = FS_IOCTL(fs, BIOC_FREESECT, sector);
+      ret = smartfs_cache_free(fs, sector);
     }
 
+#ifdef CONFIG_SMARTFS_NAME_INDEX
+  /* A deleted directory no longer needs its index */
+
+  if ((entry->flags & SMARTFS_DIRENT_TYPE) == SMARTFS_DIRENT_TYPE_DIR)
+    {
+      smartfs_index_drop(fs, entry->firstsector);
+    }
+#endif
+
   /* Remove the entry from the directory tree */
 
   readwrite.logsector = entry->dsector;
   readwrite.offset = 0;
   readwrite.count = fs->fs_llformat.availbytes;
   readwrite.buffer = (uint8_t *) fs->fs_rwbuffer;
-  ret = FS_IOCTL(fs, BIOC_READSECT, (unsigned long) &readwrite);
+  ret = smartfs_cache_read(fs, &readwrite);
   if (ret < 0)
     {
       ferr("ERROR: Error reading directory info at sector %d\n",
@@ -1177,7 +1271,7 @@ int smartfs_deleteentry(struct smartfs_mountpt_s *fs,
   readwrite.offset = entry->doffset;
   readwrite.count = sizeof(uint16_t);
   readwrite.buffer = (uint8_t *) &direntry->flags;
-  ret = FS_IOCTL(fs, BIOC_WRITESECT, (unsigned long) &readwrite);
+  ret = smartfs_cache_write(fs, &readwrite);
   if (ret < 0)
     {
       ferr("ERROR: Error marking entry inactive at sector %d\n",
@@ -1185,6 +1279,14 @@ int smartfs_deleteentry(struct smartfs_mountpt_s *fs,
       goto errout;
     }
 
+#ifdef CONFIG_SMARTFS_NAME_INDEX
+  index = smartfs_index_find(fs, entry->dfirst);
+  if (index != NULL && entry->name != NULL)
+    {
+      smartfs_index_remove(fs, index, entry->name, entry->dsector);
+    }
+#endif
+
   /* Test if any entries in this sector are being used */
 
   if ((entry->dsector != fs->fs_rootsector) &&
@@ -1243,7 +1345,7 @@ int smartfs_deleteentry(struct smartfs_mountpt_s *fs,
               /* Read the header for the next sector */
 
               readwrite.logsector = sector;
-              ret = FS_IOCTL(fs, BIOC_READSECT, (unsigned long) &readwrite);
+              ret = smartfs_cache_read(fs, &readwrite);
               if (ret < 0)
                 {
                   ferr("ERROR: Error reading sector %d\n", nextsector);
@@ -1260,7 +1362,7 @@ int smartfs_deleteentry(struct smartfs_mountpt_s *fs,
                   readwrite.offset = offsetof(struct smartfs_chain_header_s, nextsector);
                   readwrite.count = sizeof(uint16_t);
                   readwrite.buffer = header->nextsector;
-                  ret = FS_IOCTL(fs, BIOC_WRITESECT, (unsigned long) &readwrite);
+                  ret = smartfs_cache_write(fs, &readwrite);
                   if (ret < 0)
                     {
                       ferr("ERROR: Error unchaining sector (%d)\n", nextsector);
@@ -1269,13 +1371,20 @@ int smartfs_deleteentry(struct smartfs_mountpt_s *fs,
 
                   /* Now release our sector */
 
-                  ret = FS_IOCTL(fs, BIOC_FREESECT, (unsigned long) entry->dsector);
+                  ret = smartfs_cache_free(fs, entry->dsector);
                   if (ret < 0)
                     {
                       ferr("ERROR: Error freeing sector %d\n", entry->dsector);
                       goto errout;
                     }
 
+#ifdef CONFIG_SMARTFS_NAME_INDEX
+                  if (index != NULL)
+                    {
+                      smartfs_index_remsector(index, entry->dsector);
+                    }
+#endif
+
                   /* Break out of the loop, we are done! */
 
                   break;
@@ -1328,7 +1437,7 @@ int smartfs_countdirentries(struct smartfs_mountpt_s *fs,
       readwrite.offset = 0;
       readwrite.count = fs->fs_llformat.availbytes;
       readwrite.buffer = (uint8_t *) fs->fs_rwbuffer;
-      ret = FS_IOCTL(fs, BIOC_READSECT, (unsigned long) &readwrite);
+      ret = smartfs_cache_read(fs, &readwrite);
       if (ret < 0)
         {
           ferr("ERROR: Error reading sector %d\n", nextsector);
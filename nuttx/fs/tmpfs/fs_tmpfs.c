@@ -67,10 +67,6 @@
 #  warning CONFIG_FS_TMPFS_DIRECTORY_FREEGUARD needs to be > ALLOCGUARD
 #endif
 
-#if CONFIG_FS_TMPFS_FILE_FREEGUARD <= CONFIG_FS_TMPFS_FILE_ALLOCGUARD
-#  warning CONFIG_FS_TMPFS_FILE_FREEGUARD needs to be > ALLOCGUARD
-#endif
-
 #define tmpfs_lock_file(tfo) \
            (tmpfs_lock_object((FAR struct tmpfs_object_s *)tfo))
 #define tmpfs_lock_directory(tdo) \
@@ -93,8 +89,18 @@ static void tmpfs_lock_object(FAR struct tmpfs_object_s *to);
 static void tmpfs_unlock_object(FAR struct tmpfs_object_s *to);
 static int  tmpfs_realloc_directory(FAR struct tmpfs_directory_s **tdo,
               unsigned int nentries);
-static int  tmpfs_realloc_file(FAR struct tmpfs_file_s **tfo,
-              size_t newsize);
+static int  tmpfs_grow_pagetable(FAR struct tmpfs_file_s *tfo,
+              size_t npages);
+static int  tmpfs_alloc_pages(FAR struct tmpfs_file_s *tfo,
+              size_t npages);
+static void tmpfs_free_pages(FAR struct tmpfs_file_s *tfo, size_t npages);
+static int  tmpfs_resize_file(FAR struct tmpfs_file_s *tfo, size_t newsize);
+static void tmpfs_copyin(FAR struct tmpfs_file_s *tfo, off_t offset,
+              FAR const char *buffer, size_t nbytes);
+static void tmpfs_copyout(FAR struct tmpfs_file_s *tfo, off_t offset,
+              FAR char *buffer, size_t nbytes);
+static int  tmpfs_map_file(FAR struct tmpfs_file_s *tfo, FAR void **ppv);
+static void tmpfs_free_file(FAR struct tmpfs_file_s *tfo);
 static void tmpfs_release_lockedobject(FAR struct tmpfs_object_s *to);
 static void tmpfs_release_lockedfile(FAR struct tmpfs_file_s *tfo);
 static int  tmpfs_find_dirent(FAR struct tmpfs_directory_s *tdo,
@@ -361,74 +367,335 @@ static int tmpfs_realloc_directory(FAR struct tmpfs_directory_s **tdo,
 }
 
 /****************************************************************************
- * Name: tmpfs_realloc_file
+ * Name: tmpfs_grow_pagetable
+ *
+ * Description:
+ *   Make sure that the page table of the file can hold 'npages' pages.  The
+ *   page table grows geometrically so that appending to a file takes
+ *   amortized constant time.  Only the page pointers are copied.
+ *
  ****************************************************************************/
 
-static int tmpfs_realloc_file(FAR struct tmpfs_file_s **tfo,
-                              size_t newsize)
+static int tmpfs_grow_pagetable(FAR struct tmpfs_file_s *tfo, size_t npages)
 {
-  FAR struct tmpfs_file_s *oldtfo = *tfo;
-  FAR struct tmpfs_file_s *newtfo;
-  size_t objsize;
-  size_t allocsize;
-  size_t delta;
+  FAR uint8_t **newpages;
+  size_t maxpages;
+
+  if (npages <= tfo->tfo_maxpages)
+    {
+      return OK;
+    }
+
+  maxpages = tfo->tfo_maxpages > 2 ? 2 * tfo->tfo_maxpages : 4;
+  if (maxpages < npages)
+    {
+      maxpages = npages;
+    }
 
-  /* Check if the current allocation is sufficent */
+  newpages = (FAR uint8_t **)
+    kmm_realloc(tfo->tfo_pages, maxpages * sizeof(FAR uint8_t *));
+  if (newpages == NULL)
+    {
+      return -ENOMEM;
+    }
 
-  objsize = SIZEOF_TMPFS_FILE(newsize);
+  tfo->tfo_alloc   += (maxpages - tfo->tfo_maxpages) * sizeof(FAR uint8_t *);
+  tfo->tfo_pages    = newpages;
+  tfo->tfo_maxpages = maxpages;
+  return OK;
+}
 
-  /* Are we growing or shrinking the object? */
+/****************************************************************************
+ * Name: tmpfs_alloc_pages
+ *
+ * Description:
+ *   Make sure that at least 'npages' pages are allocated to the file.  The
+ *   content of new pages is not initialized.
+ *
+ ****************************************************************************/
 
-  if (objsize <= oldtfo->tfo_alloc)
+static int tmpfs_alloc_pages(FAR struct tmpfs_file_s *tfo, size_t npages)
+{
+  FAR struct tmpfs_image_s *image = tfo->tfo_image;
+  FAR uint8_t *page;
+  int ret;
+
+  if (npages <= tfo->tfo_npages)
     {
-      /* Shrinking ... Shrink unconditionally if the size is shrinking to
-       * zero.
-       */
+      return OK;
+    }
 
-      if (newsize > 0)
-        {
-          /* Otherwise, don't realloc unless the object has shrunk by a
-           * lot.
-           */
+  ret = tmpfs_grow_pagetable(tfo, npages);
+  if (ret < 0)
+    {
+      return ret;
+    }
 
-          delta = oldtfo->tfo_alloc - objsize;
-          if (delta <= CONFIG_FS_TMPFS_FILE_FREEGUARD)
-            {
-              /* Hasn't shrunk enough.. Return doing nothing for now */
+  /* Add the new pages, using the space reserved in the mapped image, if
+   * any.
+   */
 
-              oldtfo->tfo_size = newsize;
-              return OK;
+  while (tfo->tfo_npages < npages)
+    {
+      if (image != NULL && tfo->tfo_npages < image->tim_npages)
+        {
+          page = &image->tim_data[tfo->tfo_npages * TMPFS_PAGESIZE];
+        }
+      else
+        {
+          page = (FAR uint8_t *)kmm_malloc(TMPFS_PAGESIZE);
+          if (page == NULL)
+            {
+              return -ENOMEM;
             }
+
+          tfo->tfo_alloc += TMPFS_PAGESIZE;
         }
+
+      tfo->tfo_pages[tfo->tfo_npages++] = page;
     }
 
-  /* Added some additional amount to the new size to account frequent
-   * reallocations.
-   */
+  return OK;
+}
 
-  allocsize = objsize + CONFIG_FS_TMPFS_FILE_ALLOCGUARD;
+/****************************************************************************
+ * Name: tmpfs_free_pages
+ *
+ * Description:
+ *   Release all but the first 'npages' pages of the file.  Pages that lie
+ *   in the mapped image are not freed.
+ *
+ ****************************************************************************/
 
-  /* Realloc the file object */
+static void tmpfs_free_pages(FAR struct tmpfs_file_s *tfo, size_t npages)
+{
+  size_t nimage = tfo->tfo_image != NULL ? tfo->tfo_image->tim_npages : 0;
 
-  newtfo = (FAR struct tmpfs_file_s *)kmm_realloc(oldtfo, allocsize);
-  if (newtfo == NULL)
+  while (tfo->tfo_npages > npages)
     {
-      return -ENOMEM;
+      if (--tfo->tfo_npages >= nimage)
+        {
+          kmm_free(tfo->tfo_pages[tfo->tfo_npages]);
+          tfo->tfo_alloc -= TMPFS_PAGESIZE;
+        }
     }
 
-  /* Adjust the reference in the parent directory entry */
+  if (npages == 0 && tfo->tfo_pages != NULL)
+    {
+      kmm_free(tfo->tfo_pages);
+      tfo->tfo_alloc   -= tfo->tfo_maxpages * sizeof(FAR uint8_t *);
+      tfo->tfo_pages    = NULL;
+      tfo->tfo_maxpages = 0;
+    }
+}
 
-  DEBUGASSERT(newtfo->tfo_dirent);
-  newtfo->tfo_dirent->tde_object = (FAR struct tmpfs_object_s *)newtfo;
+/****************************************************************************
+ * Name: tmpfs_resize_file
+ *
+ * Description:
+ *   Set the size of the file.  If the file grows, the new data is zeroed.
+ *
+ ****************************************************************************/
 
-  /* Return the new address of the reallocated file object */
+static int tmpfs_resize_file(FAR struct tmpfs_file_s *tfo, size_t newsize)
+{
+  size_t offset;
+  size_t nbytes;
+  int ret;
+
+  if (newsize <= tfo->tfo_size)
+    {
+      tmpfs_free_pages(tfo, TMPFS_NPAGES(newsize));
+      tfo->tfo_size = newsize;
+      return OK;
+    }
 
-  newtfo->tfo_alloc = allocsize;
-  newtfo->tfo_size  = newsize;
-  *tfo              = newtfo;
+  ret = tmpfs_alloc_pages(tfo, TMPFS_NPAGES(newsize));
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  /* Zero the data between the old and the new end of the file */
+
+  for (offset = tfo->tfo_size; offset < newsize; offset += nbytes)
+    {
+      nbytes = TMPFS_PAGESIZE - offset % TMPFS_PAGESIZE;
+      if (nbytes > newsize - offset)
+        {
+          nbytes = newsize - offset;
+        }
+
+      memset(&tfo->tfo_pages[offset / TMPFS_PAGESIZE]
+                            [offset % TMPFS_PAGESIZE], 0, nbytes);
+    }
+
+  tfo->tfo_size = newsize;
   return OK;
 }
 
+/****************************************************************************
+ * Name: tmpfs_copyin and tmpfs_copyout
+ *
+ * Description:
+ *   Copy data into or out of the pages of the file.  The pages must already
+ *   be allocated.
+ *
+ ****************************************************************************/
+
+static void tmpfs_copyin(FAR struct tmpfs_file_s *tfo, off_t offset,
+                         FAR const char *buffer, size_t nbytes)
+{
+  size_t pgoff;
+  size_t ncopy;
+
+  while (nbytes > 0)
+    {
+      pgoff = offset % TMPFS_PAGESIZE;
+      ncopy = TMPFS_PAGESIZE - pgoff;
+      if (ncopy > nbytes)
+        {
+          ncopy = nbytes;
+        }
+
+      memcpy(&tfo->tfo_pages[offset / TMPFS_PAGESIZE][pgoff], buffer, ncopy);
+
+      offset += ncopy;
+      buffer += ncopy;
+      nbytes -= ncopy;
+    }
+}
+
+static void tmpfs_copyout(FAR struct tmpfs_file_s *tfo, off_t offset,
+                          FAR char *buffer, size_t nbytes)
+{
+  size_t pgoff;
+  size_t ncopy;
+
+  while (nbytes > 0)
+    {
+      pgoff = offset % TMPFS_PAGESIZE;
+      ncopy = TMPFS_PAGESIZE - pgoff;
+      if (ncopy > nbytes)
+        {
+          ncopy = nbytes;
+        }
+
+      memcpy(buffer, &tfo->tfo_pages[offset / TMPFS_PAGESIZE][pgoff], ncopy);
+
+      offset += ncopy;
+      buffer += ncopy;
+      nbytes -= ncopy;
+    }
+}
+
+/****************************************************************************
+ * Name: tmpfs_map_file
+ *
+ * Description:
+ *   Return the address of a contiguous image of the file data.  The image
+ *   is shared by all openers of the file.  Reads and writes of the mapped
+ *   part of the file access the image directly, so they are coherent with
+ *   the mapping.
+ *
+ *   If the file has grown beyond its image, the data is gathered into a new
+ *   image with room for the file to double in size.  The old image may
+ *   still be mapped (or in use by sendfile()), so it is retained until the
+ *   file is freed, but it no longer follows changes to the file.  Since
+ *   each image is at least twice the size of the one that it replaces, the
+ *   retired images together are smaller than the current image.
+ *
+ ****************************************************************************/
+
+static int tmpfs_map_file(FAR struct tmpfs_file_s *tfo, FAR void **ppv)
+{
+  FAR struct tmpfs_image_s *image = tfo->tfo_image;
+  FAR struct tmpfs_image_s *newimage;
+  size_t npages;
+  size_t nimage;
+  size_t offset;
+  size_t i;
+  int ret;
+
+  if (image == NULL || tfo->tfo_npages > image->tim_npages)
+    {
+      npages = tfo->tfo_npages > 0 ? 2 * tfo->tfo_npages : 1;
+      newimage = (FAR struct tmpfs_image_s *)
+        kmm_malloc(SIZEOF_TMPFS_IMAGE(npages));
+      if (newimage == NULL)
+        {
+          return -ENOMEM;
+        }
+
+      /* Make sure that the page table can hold all of the image pages */
+
+      ret = tmpfs_grow_pagetable(tfo, npages);
+      if (ret < 0)
+        {
+          kmm_free(newimage);
+          return ret;
+        }
+
+      /* Gather the file data into the new image and release the pages
+       * that it replaces.
+       */
+
+      nimage               = image != NULL ? image->tim_npages : 0;
+      newimage->tim_flink  = image;
+      newimage->tim_npages = npages;
+
+      for (i = 0; i < tfo->tfo_npages; i++)
+        {
+          offset = i * TMPFS_PAGESIZE;
+          if (offset < tfo->tfo_size)
+            {
+              memcpy(&newimage->tim_data[offset], tfo->tfo_pages[i],
+                     tfo->tfo_size - offset < TMPFS_PAGESIZE ?
+                     tfo->tfo_size - offset : TMPFS_PAGESIZE);
+            }
+
+          if (i >= nimage)
+            {
+              kmm_free(tfo->tfo_pages[i]);
+              tfo->tfo_alloc -= TMPFS_PAGESIZE;
+            }
+
+          tfo->tfo_pages[i] = &newimage->tim_data[offset];
+        }
+
+      tfo->tfo_alloc += SIZEOF_TMPFS_IMAGE(npages);
+      tfo->tfo_image  = newimage;
+      image           = newimage;
+    }
+
+  *ppv = (FAR void *)image->tim_data;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: tmpfs_free_file
+ *
+ * Description:
+ *   Free the file object and all of the memory that holds its data.
+ *
+ ****************************************************************************/
+
+static void tmpfs_free_file(FAR struct tmpfs_file_s *tfo)
+{
+  FAR struct tmpfs_image_s *image;
+
+  tmpfs_free_pages(tfo, 0);
+
+  while ((image = tfo->tfo_image) != NULL)
+    {
+      tfo->tfo_image = image->tim_flink;
+      kmm_free(image);
+    }
+
+  sem_destroy(&tfo->tfo_exclsem.ts_sem);
+  kmm_free(tfo);
+}
+
 /****************************************************************************
  * Name: tmpfs_release_lockedobject
  ****************************************************************************/
@@ -464,8 +731,7 @@ static void tmpfs_release_lockedfile(FAR struct tmpfs_file_s *tfo)
 
   if (tfo->tfo_refs == 1 && (tfo->tfo_flags & TFO_FLAG_UNLINKED) != 0)
     {
-      sem_destroy(&tfo->tfo_exclsem.ts_sem);
-      kmm_free(tfo);
+      tmpfs_free_file(tfo);
     }
 
   /* Otherwise, just decrement the reference count on the file object */
@@ -611,12 +877,12 @@ static int tmpfs_add_dirent(FAR struct tmpfs_directory_s **tdo,
 static FAR struct tmpfs_file_s *tmpfs_alloc_file(void)
 {
   FAR struct tmpfs_file_s *tfo;
-  size_t allocsize;
 
-  /* Create a new zero length file object */
+  /* Create a new zero length file object.  No pages are allocated until
+   * data is written to the file.
+   */
 
-  allocsize = SIZEOF_TMPFS_FILE(CONFIG_FS_TMPFS_FILE_ALLOCGUARD);
-  tfo = (FAR struct tmpfs_file_s *)kmm_malloc(allocsize);
+  tfo = (FAR struct tmpfs_file_s *)kmm_malloc(sizeof(struct tmpfs_file_s));
   if (tfo == NULL)
     {
       return NULL;
@@ -626,11 +892,15 @@ static FAR struct tmpfs_file_s *tmpfs_alloc_file(void)
    * locked with one reference count.
    */
 
-  tfo->tfo_alloc = allocsize;
-  tfo->tfo_type  = TMPFS_REGULAR;
-  tfo->tfo_refs  = 1;
-  tfo->tfo_flags = 0;
-  tfo->tfo_size  = 0;
+  tfo->tfo_alloc    = sizeof(struct tmpfs_file_s);
+  tfo->tfo_type     = TMPFS_REGULAR;
+  tfo->tfo_refs     = 1;
+  tfo->tfo_flags    = 0;
+  tfo->tfo_size     = 0;
+  tfo->tfo_npages   = 0;
+  tfo->tfo_maxpages = 0;
+  tfo->tfo_pages    = NULL;
+  tfo->tfo_image    = NULL;
 
   tfo->tfo_exclsem.ts_holder = getpid();
   tfo->tfo_exclsem.ts_count  = 1;
@@ -1264,6 +1534,11 @@ static int tmpfs_free_callout(FAR struct tmpfs_directory_s *tdo,
           tfo->tfo_flags |= TFO_FLAG_UNLINKED;
           return TMPFS_UNLINKED;
         }
+
+      /* Free the file object and its data now */
+
+      tmpfs_free_file(tfo);
+      return TMPFS_DELETED;
     }
 
   /* Free the object now */
@@ -1417,7 +1692,7 @@ static int tmpfs_open(FAR struct file *filep, FAR const char *relpath,
 
           if (tfo->tfo_size > 0)
             {
-              ret = tmpfs_realloc_file(&tfo, 0);
+              ret = tmpfs_resize_file(tfo, 0);
               if (ret < 0)
                 {
                   goto errout_with_filelock;
@@ -1532,7 +1807,7 @@ static int tmpfs_close(FAR struct file *filep)
        * have any other references.
        */
 
-      kmm_free(tfo);
+      tmpfs_free_file(tfo);
       return OK;
     }
 
@@ -1572,15 +1847,19 @@ static ssize_t tmpfs_read(FAR struct file *filep, FAR char *buffer,
   nread    = buflen;
   endpos   = startpos + buflen;
 
-  if (endpos > tfo->tfo_size)
+  if (startpos >= tfo->tfo_size)
+    {
+      nread = 0;
+    }
+  else if (endpos > tfo->tfo_size)
     {
       endpos = tfo->tfo_size;
       nread  = endpos - startpos;
     }
 
-  /* Copy data from the memory object to the user buffer */
+  /* Copy data from the pages of the file to the user buffer */
 
-  memcpy(buffer, &tfo->tfo_data[startpos], nread);
+  tmpfs_copyout(tfo, startpos, buffer, nread);
   filep->f_pos += nread;
 
   /* Release the lock on the file */
@@ -1622,20 +1901,38 @@ static ssize_t tmpfs_write(FAR struct file *filep, FAR const char *buffer,
 
   if (endpos > tfo->tfo_size)
     {
-      /* Reallocate the file to handle the write past the end of the file. */
+      /* If the write starts beyond the end of the file, the gap reads as
+       * zeroes.
+       */
+
+      if (startpos > tfo->tfo_size)
+        {
+          ret = tmpfs_resize_file(tfo, (size_t)startpos);
+          if (ret < 0)
+            {
+              goto errout_with_lock;
+            }
+        }
 
-      ret = tmpfs_realloc_file(&tfo, (size_t)endpos);
+      /* Add pages to handle the write past the end of the file.  The data
+       * already in the file is not moved.
+       */
+
+      ret = tmpfs_alloc_pages(tfo, TMPFS_NPAGES((size_t)endpos));
       if (ret < 0)
         {
           goto errout_with_lock;
         }
-
-      filep->f_priv = tfo;
     }
 
-  /* Copy data from the memory object to the user buffer */
+  /* Copy data from the user buffer to the pages of the file */
+
+  tmpfs_copyin(tfo, startpos, buffer, nwritten);
+  if (endpos > tfo->tfo_size)
+    {
+      tfo->tfo_size = endpos;
+    }
 
-  memcpy(&tfo->tfo_data[startpos], buffer, nwritten);
   filep->f_pos += nwritten;
 
   /* Release the lock on the file */
@@ -1716,26 +2013,49 @@ static int tmpfs_ioctl(FAR struct file *filep, int cmd, unsigned long arg)
 {
   FAR struct tmpfs_file_s *tfo;
   FAR void **ppv = (FAR void**)arg;
+  int ret;
 
   finfo("filep: %p cmd: %d arg: %08lx\n", filep, cmd, arg);
   DEBUGASSERT(filep->f_priv != NULL && filep->f_inode != NULL);
 
   /* Recover our private data from the struct file instance */
 
-  tfo = filep->f_inode->i_private;
+  tfo = filep->f_priv;
 
   DEBUGASSERT(tfo != NULL);
 
-  /* Only one ioctl command is supported */
-
   if (cmd == FIOC_MMAP && ppv != NULL)
     {
-      /* Return the address on the media corresponding to the start of
-       * the file.
+      /* Return the address of the mapped image of the file, creating the
+       * image if necessary.  This is the same image for all openers.
        */
 
-      *ppv = (FAR void *)tfo->tfo_data;
-      return OK;
+      tmpfs_lock_file(tfo);
+      ret = tmpfs_map_file(tfo, ppv);
+      tmpfs_unlock_file(tfo);
+      return ret;
+    }
+
+  if (cmd == FIOC_XIPBASE && ppv != NULL)
+    {
+      /* The file data is contiguous only if the file has already been
+       * mapped and has not grown beyond its image since.
+       */
+
+      tmpfs_lock_file(tfo);
+      if (tfo->tfo_image != NULL &&
+          tfo->tfo_npages <= tfo->tfo_image->tim_npages)
+        {
+          *ppv = (FAR void *)tfo->tfo_image->tim_data;
+          ret  = OK;
+        }
+      else
+        {
+          ret  = -ENOTTY;
+        }
+
+      tmpfs_unlock_file(tfo);
+      return ret;
     }
 
   ferr("ERROR: Invalid cmd: %d\n", cmd);
@@ -2205,8 +2525,7 @@ static int tmpfs_unlink(FAR struct inode *mountpt, FAR const char *relpath)
 
   else
     {
-      sem_destroy(&tfo->tfo_exclsem.ts_sem);
-      kmm_free(tfo);
+      tmpfs_free_file(tfo);
     }
 
   /* Release the reference and lock on the parent directory */
@@ -58,6 +58,14 @@
 
 #define TFO_FLAG_UNLINKED (1 << 0)  /* Bit 0: File is unlinked */
 
+/* File data page size */
+
+#define TMPFS_PAGESIZE    CONFIG_FS_TMPFS_PAGESIZE
+
+/* The number of pages needed to hold 'n' bytes of file data */
+
+#define TMPFS_NPAGES(n)   (((n) + TMPFS_PAGESIZE - 1) / TMPFS_PAGESIZE)
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -131,7 +139,29 @@ struct tmpfs_directory_s
 #define SIZEOF_TMPFS_DIRECTORY(n) \
   (sizeof(struct tmpfs_directory_s) + ((n) - 1) * sizeof(struct tmpfs_dirent_s))
 
+/* The form of one memory mapped image of a regular file.  The image holds
+ * the leading pages of the file contiguously so that the address of the
+ * file data can be returned by FIOC_MMAP.  An image that has been replaced
+ * by a larger image is retained (on tim_flink) until the file is freed so
+ * that addresses returned earlier remain valid.
+ */
+
+struct tmpfs_image_s
+{
+  FAR struct tmpfs_image_s *tim_flink; /* Older, retired images */
+  size_t   tim_npages;   /* Capacity of the image in pages */
+  uint8_t  tim_data[1];  /* The image starts here */
+};
+
+#define SIZEOF_TMPFS_IMAGE(n) \
+  (sizeof(struct tmpfs_image_s) + (n) * TMPFS_PAGESIZE - 1)
+
 /* The form of a regular file memory object
+ *
+ * The file data is held in pages of TMPFS_PAGESIZE bytes referenced by the
+ * page table tfo_pages[], so that a file can grow without moving (or
+ * copying) the data that it already holds.  If the file has been memory
+ * mapped, the pages below tfo_image->tim_npages lie in the mapped image.
  *
  * NOTE that in this very simplified implementation, there is no per-open
  * state.  The file memory object also serves as the open file object,
@@ -146,19 +176,20 @@ struct tmpfs_file_s
   FAR struct tmpfs_dirent_s *tfo_dirent;
   struct tmpfs_sem_s tfo_exclsem;
 
-  size_t   tfo_alloc;    /* Allocated size of the file object */
+  size_t   tfo_alloc;    /* Allocated size of the file object and its data */
   uint8_t  tfo_type;     /* See enum tmpfs_objtype_e */
   uint8_t  tfo_refs;     /* Reference count */
 
-  /* Remaining fields are unique to a directory object */
+  /* Remaining fields are unique to a file object */
 
   uint8_t  tfo_flags;    /* See TFO_FLAG_* definitions */
   size_t   tfo_size;     /* Valid file size */
-  uint8_t  tfo_data[1];  /* File data starts here */
+  size_t   tfo_npages;   /* Number of pages allocated to the file */
+  size_t   tfo_maxpages; /* Capacity of the page table */
+  FAR uint8_t **tfo_pages;              /* The page table */
+  FAR struct tmpfs_image_s *tfo_image;  /* The mapped image (if mapped) */
 };
 
-#define SIZEOF_TMPFS_FILE(n) (sizeof(struct tmpfs_file_s) + (n) - 1)
-
 /* This structure represents one instance of a TMPFS file system */
 
 struct tmpfs_s
@@ -244,6 +244,15 @@ int open(const char *path, int oflags, ...)
       goto errout_with_fd;
     }
 
+#ifdef CONFIG_FS_RAMMAP
+  /* Copies of a truncated file made by mmap() are now stale */
+
+  if ((oflags & O_TRUNC) != 0)
+    {
+      rammap_invalidate(inode, filep);
+    }
+#endif
+
 #ifdef CONFIG_PSEUDOTERM_SUSV1
   /* If the return value from the open method is > 0, then it may actually
    * be an encoded file descriptor.  This kind of logic is currently only
@@ -467,6 +467,14 @@ next_subdir:
        */
 
       ret = oldinode->u.i_mops->rename(oldinode, oldrelpath, newrelpath);
+
+#ifdef CONFIG_FS_RAMMAP
+      /* The file system may now reuse the file ID of the renamed file (or
+       * of a file that was replaced).
+       */
+
+      rammap_invalidate(oldinode, NULL);
+#endif
     }
 
 errout_with_newinode:
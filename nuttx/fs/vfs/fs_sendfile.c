@@ -42,15 +42,185 @@
 #include <sys/sendfile.h>
 #include <stdbool.h>
 #include <stdlib.h>
+#include <string.h>
 #include <unistd.h>
 #include <errno.h>
 #include <assert.h>
 
 #include <nuttx/sched.h>
+#include <nuttx/fs/fs.h>
+#include <nuttx/fs/ioctl.h>
 #include <nuttx/net/net.h>
 
 #if CONFIG_NFILE_DESCRIPTORS > 0 && CONFIG_NET_SENDFILE
 
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sendfile_xipbase
+ *
+ * Description:
+ *   Check if the input file is memory resident.  File systems that keep the
+ *   file data contiguously in addressable memory (ROMFS on XIP media, a
+ *   TMPFS file that is already mapped) report the address of the data via
+ *   the FIOC_XIPBASE ioctl.  Unlike FIOC_MMAP, that never creates a copy of
+ *   the file.
+ *
+ *   The address is only guaranteed to remain valid while the file is open.
+ *   The caller's descriptor may be closed by another thread during the
+ *   transfer, so a private reference is taken on the file and the address
+ *   is obtained through it.  The caller must release that reference with
+ *   file_close_detached() when the transfer completes.
+ *
+ * Input Parmeters:
+ *   filep  - The input file
+ *   pinned - Location to return the private reference on the input file.
+ *            This is opened only if a non-NULL address is returned.
+ *
+ * Returned Value:
+ *   The address of the file data or NULL if the file is not memory
+ *   resident or could not be pinned.  The errno value is not modified.
+ *
+ ****************************************************************************/
+
+static FAR const uint8_t *sendfile_xipbase(FAR struct file *filep,
+                                           FAR struct file *pinned)
+{
+  FAR const uint8_t *base = NULL;
+  int errcode;
+  int ret;
+
+  /* Save the errno value so that it can be restored if the ioctl fails */
+
+  errcode = get_errno();
+  ret = file_ioctl(filep, FIOC_XIPBASE, (unsigned long)((uintptr_t)&base));
+  if (ret < 0 || base == NULL)
+    {
+      set_errno(errcode);
+      return NULL;
+    }
+
+  /* Hold the file open for the duration of the transfer and get the
+   * address again through that reference.
+   */
+
+  memset(pinned, 0, sizeof(struct file));
+  if (file_dup2(filep, pinned) < 0)
+    {
+      set_errno(errcode);
+      return NULL;
+    }
+
+  base = NULL;
+  ret  = file_ioctl(pinned, FIOC_XIPBASE, (unsigned long)((uintptr_t)&base));
+  if (ret < 0 || base == NULL)
+    {
+      (void)file_close_detached(pinned);
+      set_errno(errcode);
+      return NULL;
+    }
+
+  return base;
+}
+
+/****************************************************************************
+ * Name: sendfile_xip
+ *
+ * Description:
+ *   Perform a file-to-file transfer from a memory resident input file.  The
+ *   output file is written directly from the file data, avoiding the
+ *   intermediate I/O buffer used by lib_sendfile().
+ *
+ * Input Parmeters:
+ *   outfd  - A descriptor opened for writing.
+ *   filep  - The input file
+ *   base   - The address of the input file data from sendfile_xipbase().
+ *            The input file must be held open until this returns.
+ *   offset - Same as sendfile().
+ *   count  - Same as sendfile().
+ *
+ * Returned Value:
+ *   The number of bytes transferred on success; ERROR on a failure with the
+ *   errno value set appropriately.
+ *
+ ****************************************************************************/
+
+static ssize_t sendfile_xip(int outfd, FAR struct file *filep,
+                            FAR const uint8_t *base, FAR off_t *offset,
+                            size_t count)
+{
+  ssize_t nwritten;
+  size_t ntransferred;
+  off_t startpos;
+  off_t curpos;
+  off_t endpos;
+
+  /* Get the size of the file, leaving the file position unchanged */
+
+  curpos = file_seek(filep, 0, SEEK_CUR);
+  if (curpos == (off_t)-1)
+    {
+      return ERROR;
+    }
+
+  endpos = file_seek(filep, 0, SEEK_END);
+  if (file_seek(filep, curpos, SEEK_SET) == (off_t)-1 ||
+      endpos == (off_t)-1)
+    {
+      return ERROR;
+    }
+
+  /* Get the starting position and clip the count to the end of the file */
+
+  startpos = offset ? *offset : curpos;
+  if (startpos >= endpos)
+    {
+      count = 0;
+    }
+  else if (count > (size_t)(endpos - startpos))
+    {
+      count = (size_t)(endpos - startpos);
+    }
+
+  /* Write the data directly from the file data in memory */
+
+  for (ntransferred = 0; ntransferred < count; )
+    {
+      nwritten = write(outfd, base + startpos + ntransferred,
+                       count - ntransferred);
+      if (nwritten < 0)
+        {
+#ifndef CONFIG_DISABLE_SIGNALS
+          /* EINTR is not an error (but will still stop the copy) */
+
+          if (get_errno() == EINTR && ntransferred > 0)
+            {
+              break;
+            }
+#endif
+
+          return ERROR;
+        }
+
+      ntransferred += nwritten;
+    }
+
+  /* Update the offset or the file position, as appropriate */
+
+  if (offset)
+    {
+      *offset = startpos + ntransferred;
+    }
+  else if (file_seek(filep, startpos + ntransferred, SEEK_SET) == (off_t)-1)
+    {
+      return ERROR;
+    }
+
+  return (ssize_t)ntransferred;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -61,11 +231,14 @@
  * Description:
  *   sendfile() copies data between one file descriptor and another.
  *   Used with file descriptors it basically just wraps a sequence of
- *   reads() and writes() to perform a copy.
+ *   reads() and writes() to perform a copy.  If the input file is memory
+ *   resident (see FIOC_XIPBASE), the output is written directly from the
+ *   file data without an intermediate buffer.
  *
  *   If the destination descriptor is a socket, it gives a better
  *   performance than simple reds() and writes(). The data is read directly
- *   into the net buffer and the whole tcp window is filled if possible.
+ *   into the net buffer (or copied from the file data if the file is
+ *   memory resident) and the whole tcp window is filled if possible.
  *
  *   NOTE: This interface is *not* specified in POSIX.1-2001, or other
  *   standards.  The implementation here is very similar to the Linux
@@ -131,10 +304,37 @@ ssize_t sendfile(int outfd, int infd, off_t *offset, size_t count)
   else
 #endif
     {
-      /* No... then this is probably a file-to-file transfer.  The generic
-       * lib_sendfile() can handle that case.
+      FAR struct file *filep;
+      FAR const uint8_t *base;
+      struct file pinned;
+      ssize_t ret;
+
+      /* No... then this is probably a file-to-file transfer.  If the input
+       * file is memory resident, then the output can be written directly
+       * from the file data.
        */
 
+      if ((unsigned int)infd < CONFIG_NFILE_DESCRIPTORS)
+        {
+          filep = fs_getfilep(infd);
+          if (filep == NULL)
+            {
+              /* The errno value has already been set */
+
+              return ERROR;
+            }
+
+          base = sendfile_xipbase(filep, &pinned);
+          if (base != NULL)
+            {
+              ret = sendfile_xip(outfd, filep, base, offset, count);
+              (void)file_close_detached(&pinned);
+              return ret;
+            }
+        }
+
+      /* Otherwise, the generic lib_sendfile() can handle that case. */
+
       return lib_sendfile(outfd, infd, offset, count);
     }
 }
@@ -125,6 +125,12 @@ int unlink(FAR const char *pathname)
               errcode = -ret;
               goto errout_with_inode;
             }
+
+#ifdef CONFIG_FS_RAMMAP
+          /* The file system may now reuse the file ID of the file */
+
+          rammap_invalidate(inode, NULL);
+#endif
         }
       else
         {
@@ -100,6 +100,12 @@ ssize_t file_write(FAR struct file *filep, FAR const void *buf, size_t nbytes)
       goto errout;
     }
 
+#ifdef CONFIG_FS_RAMMAP
+  /* Copies of the file made by mmap() are now stale */
+
+  rammap_invalidate(inode, filep);
+#endif
+
   return ret;
 
 errout:
@@ -45,6 +45,7 @@
 #include <stdint.h>
 #include <stdbool.h>
 
+#include <nuttx/clock.h>
 #include <nuttx/nx/nx.h>
 #include <nuttx/nx/nxglib.h>
 #include <nuttx/nx/nxbe.h>
@@ -61,10 +62,36 @@
 #define NX_CLIPORDER_BRLT    (3)   /* Bottom-right-left-top */
 #define NX_CLIPORDER_DEFAULT NX_CLIPORDER_TLRB
 
+/* Report an updated region of a plane to external logic, either directly or
+ * through the damage list of the plane.
+ */
+
+#if defined(CONFIG_NX_UPDATE_DAMAGE)
+#  define nxbe_notify_rectangle(p,r) nxbe_damage_add(p,r)
+#elif defined(CONFIG_NX_UPDATE)
+#  define nxbe_notify_rectangle(p,r) nx_notify_rectangle(&(p)->pinfo,r)
+#endif
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
 
+/* Damage tracking **********************************************************/
+
+#ifdef CONFIG_NX_UPDATE_DAMAGE
+/* The regions of a plane that have been updated but not yet reported with
+ * nx_notify_rectangle().  Rectangles that overlap are usually merged, but
+ * not if their bounding box would include too much that was not updated.
+ */
+
+struct nxbe_damage_s
+{
+  systime_t start;                  /* Time that the first rectangle was added */
+  uint8_t nrects;                   /* Number of rectangles in the list */
+  struct nxgl_rect_s rect[CONFIG_NX_UPDATE_DAMAGE_NRECTS];
+};
+#endif
+
 /* Rasterization ************************************************************/
 
 /* A tiny vtable of raster operation function pointers.  The types of the
@@ -96,10 +123,30 @@ struct nxbe_plane_s
                              FAR const void *src,
                              FAR const struct nxgl_point_s *origin,
                              unsigned int srcstride);
+#ifdef CONFIG_NX_BLEND
+  /* Blending callbacks.  These are NULL if the plane cannot be blended */
+
+  CODE void (*blendrectangle)(FAR NX_PLANEINFOTYPE *pinfo,
+                              FAR const struct nxgl_rect_s *dest,
+                              FAR const void *src,
+                              FAR const struct nxgl_point_s *origin,
+                              unsigned int srcstride, uint8_t alpha);
+  CODE void (*fillmask)(FAR NX_PLANEINFOTYPE *pinfo,
+                        FAR const struct nxgl_rect_s *dest,
+                        FAR const uint8_t *mask,
+                        FAR const struct nxgl_point_s *origin,
+                        unsigned int maskstride, nxgl_mxpixel_t color);
+#endif
 
   /* Framebuffer plane info describing destination video plane */
 
   NX_PLANEINFOTYPE pinfo;
+
+#ifdef CONFIG_NX_UPDATE_DAMAGE
+  /* Updated regions not yet reported to external logic */
+
+  struct nxbe_damage_s damage;
+#endif
 };
 
 /* Clipping *****************************************************************/
@@ -386,6 +433,66 @@ void nxbe_bitmap(FAR struct nxbe_window_s *wnd,
                  FAR const struct nxgl_point_s *origin,
                  unsigned int stride);
 
+/****************************************************************************
+ * Name: nxbe_blendbitmap
+ *
+ * Description:
+ *   Blend a rectangular region of a larger image over the rectangle in the
+ *   specified window with a constant opacity.
+ *
+ * Input Parameters:
+ *   wnd    - The window that will receive the bitmap image
+ *   dest   - Describes the rectangular on the display that will receive the
+ *            the bit map.
+ *   src    - The start of the source image.
+ *   origin - The origin of the upper, left-most corner of the full bitmap.
+ *            Both dest and origin are in window coordinates, however, origin
+ *            may lie outside of the display.
+ *   stride - The width of the full source image in bytes.
+ *   alpha  - The opacity of the image, from 0 (transparent) to 255 (opaque)
+ *
+ * Return:
+ *   None
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NX_BLEND
+void nxbe_blendbitmap(FAR struct nxbe_window_s *wnd,
+                      FAR const struct nxgl_rect_s *dest,
+                      FAR const void *src[CONFIG_NX_NPLANES],
+                      FAR const struct nxgl_point_s *origin,
+                      unsigned int stride, uint8_t alpha);
+
+/****************************************************************************
+ * Name: nxbe_fillmask
+ *
+ * Description:
+ *   Draw a color through a rectangular region of a larger 8-bit coverage
+ *   mask into the rectangle in the specified window.
+ *
+ * Input Parameters:
+ *   wnd    - The window that will receive the color
+ *   dest   - Describes the rectangular on the display that will be drawn
+ *   mask   - The start of the mask, one byte per pixel.
+ *   origin - The origin of the upper, left-most corner of the full mask.
+ *            Both dest and origin are in window coordinates, however, origin
+ *            may lie outside of the display.
+ *   stride - The width of the full mask in bytes.
+ *   color  - The color to draw
+ *
+ * Return:
+ *   None
+ *
+ ****************************************************************************/
+
+void nxbe_fillmask(FAR struct nxbe_window_s *wnd,
+                   FAR const struct nxgl_rect_s *dest,
+                   FAR const uint8_t *mask,
+                   FAR const struct nxgl_point_s *origin,
+                   unsigned int stride,
+                   nxgl_mxpixel_t color[CONFIG_NX_NPLANES]);
+#endif
+
 /****************************************************************************
  * Name: nxbe_redraw
  *
@@ -465,6 +572,48 @@ void nxbe_clipnull(FAR struct nxbe_clipops_s *cops,
                    FAR struct nxbe_plane_s *plane,
                    FAR const struct nxgl_rect_s *rect);
 
+/****************************************************************************
+ * Name: nxbe_damage_add
+ *
+ * Description:
+ *   Add an updated rectangle to the damage list of a plane.  The rectangle
+ *   is merged with any rectangles in the list that it overlaps or touches,
+ *   provided that the merged bounding box does not include too much of the
+ *   display that was not updated.
+ *
+ * Input Parameters:
+ *   plane - The plane that was updated
+ *   rect  - The updated rectangle in absolute display coordinates
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NX_UPDATE_DAMAGE
+void nxbe_damage_add(FAR struct nxbe_plane_s *plane,
+                     FAR const struct nxgl_rect_s *rect);
+#endif
+
+/****************************************************************************
+ * Name: nxbe_damage_flush
+ *
+ * Description:
+ *   Report every rectangle in the damage list of a plane with
+ *   nx_notify_rectangle() and empty the list.
+ *
+ * Input Parameters:
+ *   plane - The plane to be flushed
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NX_UPDATE_DAMAGE
+void nxbe_damage_flush(FAR struct nxbe_plane_s *plane);
+#endif
+
 #undef EXTERN
 #if defined(__cplusplus)
 }
@@ -0,0 +1,363 @@
+/****************************************************************************
+ * graphics/nxbe/nxbe_blend.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <errno.h>
+#include <debug.h>
+
+#include <nuttx/nx/nxglib.h>
+#include "nxbe.h"
+
+#ifdef CONFIG_NX_BLEND
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+struct nx_blendbitmap_s
+{
+  struct nxbe_clipops_s cops;
+  FAR const void *src;              /* The start of the source image. */
+  struct nxgl_point_s origin;       /* Offset into the source image data */
+  unsigned int stride;              /* The width of the full source image in bytes. */
+  uint8_t alpha;                    /* Opacity of the image */
+};
+
+struct nx_fillmask_s
+{
+  struct nxbe_clipops_s cops;
+  FAR const uint8_t *mask;          /* The start of the mask. */
+  struct nxgl_point_s origin;       /* Offset into the mask data */
+  unsigned int stride;              /* The width of the full mask in bytes. */
+  nxgl_mxpixel_t color;             /* The color to draw */
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxs_clipblend
+ *
+ * Description:
+ *  Called from nxbe_clipper() to performed the blend operation on visible
+ *  portions of the rectangle.  A plane that cannot be blended gets the
+ *  image only where it is at least half opaque.
+ *
+ ****************************************************************************/
+
+static void nxs_clipblend(FAR struct nxbe_clipops_s *cops,
+                          FAR struct nxbe_plane_s *plane,
+                          FAR const struct nxgl_rect_s *rect)
+{
+  FAR struct nx_blendbitmap_s *bminfo = (FAR struct nx_blendbitmap_s *)cops;
+
+  if (plane->blendrectangle != NULL)
+    {
+      plane->blendrectangle(&plane->pinfo, rect, bminfo->src,
+                            &bminfo->origin, bminfo->stride, bminfo->alpha);
+    }
+  else if (bminfo->alpha >= 128)
+    {
+      plane->copyrectangle(&plane->pinfo, rect, bminfo->src,
+                           &bminfo->origin, bminfo->stride);
+    }
+  else
+    {
+      return;
+    }
+
+#ifdef CONFIG_NX_UPDATE
+  /* Notify external logic that the display has been updated */
+
+  nxbe_notify_rectangle(plane, rect);
+#endif
+}
+
+/****************************************************************************
+ * Name: nxs_clipmask
+ *
+ * Description:
+ *  Called from nxbe_clipper() to performed the mask operation on visible
+ *  portions of the rectangle.  On a plane that cannot be blended, the
+ *  pixels that are at least half covered are set to the color.
+ *
+ ****************************************************************************/
+
+static void nxs_clipmask(FAR struct nxbe_clipops_s *cops,
+                         FAR struct nxbe_plane_s *plane,
+                         FAR const struct nxgl_rect_s *rect)
+{
+  FAR struct nx_fillmask_s *mkinfo = (FAR struct nx_fillmask_s *)cops;
+  FAR const uint8_t *mline;
+  struct nxgl_point_s pos;
+
+  if (plane->fillmask != NULL)
+    {
+      plane->fillmask(&plane->pinfo, rect, mkinfo->mask, &mkinfo->origin,
+                      mkinfo->stride, mkinfo->color);
+    }
+  else
+    {
+      mline = mkinfo->mask + (rect->pt1.y - mkinfo->origin.y) * mkinfo->stride;
+      for (pos.y = rect->pt1.y; pos.y <= rect->pt2.y; pos.y++)
+        {
+          for (pos.x = rect->pt1.x; pos.x <= rect->pt2.x; pos.x++)
+            {
+              if (mline[pos.x - mkinfo->origin.x] >= 128)
+                {
+                  plane->setpixel(&plane->pinfo, &pos, mkinfo->color);
+                }
+            }
+
+          mline += mkinfo->stride;
+        }
+    }
+
+#ifdef CONFIG_NX_UPDATE
+  /* Notify external logic that the display has been updated */
+
+  nxbe_notify_rectangle(plane, rect);
+#endif
+}
+
+/****************************************************************************
+ * Name: nxbe_cliprect
+ *
+ * Description:
+ *   Offset the destination rectangle and the origin of the source data by
+ *   the window origin and clip the rectangle to the window and to the
+ *   display.
+ *
+ * Return:
+ *   true if some part of the rectangle remains
+ *
+ ****************************************************************************/
+
+static bool nxbe_cliprect(FAR struct nxbe_window_s *wnd,
+                          FAR const struct nxgl_rect_s *dest,
+                          FAR const struct nxgl_point_s *origin,
+                          FAR struct nxgl_rect_s *remaining,
+                          FAR struct nxgl_point_s *offset)
+{
+  struct nxgl_rect_s bounds;
+
+  nxgl_rectoffset(&bounds, dest, wnd->bounds.pt1.x, wnd->bounds.pt1.y);
+  nxgl_vectoradd(offset, origin, &wnd->bounds.pt1);
+
+  nxgl_rectintersect(remaining, &bounds, &wnd->bounds);
+  nxgl_rectintersect(remaining, remaining, &wnd->be->bkgd.bounds);
+
+  return !nxgl_nullrect(remaining);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxbe_blendbitmap
+ *
+ * Description:
+ *   Blend a rectangular region of a larger image over the rectangle in the
+ *   specified window with a constant opacity.
+ *
+ * Input Parameters:
+ *   wnd    - The window that will receive the bitmap image
+ *   dest   - Describes the rectangular on the display that will receive the
+ *            the bit map.
+ *   src    - The start of the source image.
+ *   origin - The origin of the upper, left-most corner of the full bitmap.
+ *            Both dest and origin are in window coordinates, however, origin
+ *            may lie outside of the display.
+ *   stride - The width of the full source image in bytes.
+ *   alpha  - The opacity of the image, from 0 (transparent) to 255 (opaque)
+ *
+ * Return:
+ *   None
+ *
+ ****************************************************************************/
+
+void nxbe_blendbitmap(FAR struct nxbe_window_s *wnd,
+                      FAR const struct nxgl_rect_s *dest,
+                      FAR const void *src[CONFIG_NX_NPLANES],
+                      FAR const struct nxgl_point_s *origin,
+                      unsigned int stride, uint8_t alpha)
+{
+  struct nx_blendbitmap_s info;
+  struct nxgl_point_s offset;
+  struct nxgl_rect_s remaining;
+  unsigned int deststride;
+  int i;
+
+#ifdef CONFIG_DEBUG_FEATURES
+  if (!wnd || !dest || !src || !origin)
+    {
+      return;
+    }
+#endif
+
+  /* Verify that the destination rectangle begins "below" and to the "right"
+   * of the origin and that it lies within the width of the source bitmap
+   */
+
+  if (dest->pt1.x < origin->x || dest->pt1.y < origin->y)
+    {
+      gerr("ERROR: Bad dest start position\n");
+      return;
+    }
+
+  deststride = (((dest->pt2.x - origin->x + 1) * wnd->be->plane[0].pinfo.bpp + 7) >> 3);
+  if (deststride > stride)
+    {
+      gerr("ERROR: Bad dest width\n");
+      return;
+    }
+
+  if (alpha == 0 || !nxbe_cliprect(wnd, dest, origin, &remaining, &offset))
+    {
+      return;
+    }
+
+  /* Then perform the clipped blend */
+
+#if CONFIG_NX_NPLANES > 1
+  for (i = 0; i < wnd->be->vinfo.nplanes; i++)
+#else
+  i = 0;
+#endif
+    {
+      info.cops.visible  = nxs_clipblend;
+      info.cops.obscured = nxbe_clipnull;
+      info.src           = src[i];
+      info.origin.x      = offset.x;
+      info.origin.y      = offset.y;
+      info.stride        = stride;
+      info.alpha         = alpha;
+
+      nxbe_clipper(wnd->above, &remaining, NX_CLIPORDER_DEFAULT,
+                   &info.cops, &wnd->be->plane[i]);
+    }
+}
+
+/****************************************************************************
+ * Name: nxbe_fillmask
+ *
+ * Description:
+ *   Draw a color through a rectangular region of a larger 8-bit coverage
+ *   mask into the rectangle in the specified window.
+ *
+ * Input Parameters:
+ *   wnd    - The window that will receive the color
+ *   dest   - Describes the rectangular on the display that will be drawn
+ *   mask   - The start of the mask, one byte per pixel.
+ *   origin - The origin of the upper, left-most corner of the full mask.
+ *            Both dest and origin are in window coordinates, however, origin
+ *            may lie outside of the display.
+ *   stride - The width of the full mask in bytes.
+ *   color  - The color to draw
+ *
+ * Return:
+ *   None
+ *
+ ****************************************************************************/
+
+void nxbe_fillmask(FAR struct nxbe_window_s *wnd,
+                   FAR const struct nxgl_rect_s *dest,
+                   FAR const uint8_t *mask,
+                   FAR const struct nxgl_point_s *origin,
+                   unsigned int stride,
+                   nxgl_mxpixel_t color[CONFIG_NX_NPLANES])
+{
+  struct nx_fillmask_s info;
+  struct nxgl_point_s offset;
+  struct nxgl_rect_s remaining;
+  int i;
+
+#ifdef CONFIG_DEBUG_FEATURES
+  if (!wnd || !dest || !mask || !origin)
+    {
+      return;
+    }
+#endif
+
+  /* Verify that the destination rectangle begins "below" and to the "right"
+   * of the origin and that it lies within the width of the mask
+   */
+
+  if (dest->pt1.x < origin->x || dest->pt1.y < origin->y)
+    {
+      gerr("ERROR: Bad dest start position\n");
+      return;
+    }
+
+  if (dest->pt2.x - origin->x + 1 > stride)
+    {
+      gerr("ERROR: Bad dest width\n");
+      return;
+    }
+
+  if (!nxbe_cliprect(wnd, dest, origin, &remaining, &offset))
+    {
+      return;
+    }
+
+  /* Then perform the clipped draw */
+
+#if CONFIG_NX_NPLANES > 1
+  for (i = 0; i < wnd->be->vinfo.nplanes; i++)
+#else
+  i = 0;
+#endif
+    {
+      info.cops.visible  = nxs_clipmask;
+      info.cops.obscured = nxbe_clipnull;
+      info.mask          = mask;
+      info.origin.x      = offset.x;
+      info.origin.y      = offset.y;
+      info.stride        = stride;
+      info.color         = color[i];
+
+      nxbe_clipper(wnd->above, &remaining, NX_CLIPORDER_DEFAULT,
+                   &info.cops, &wnd->be->plane[i]);
+    }
+}
+
+#endif /* CONFIG_NX_BLEND */
@@ -188,6 +188,10 @@ int nxbe_configure(FAR NX_DRIVERTYPE *dev, FAR struct nxbe_state_s *be)
           be->plane[i].filltrapezoid = nxgl_filltrapezoid_16bpp;
           be->plane[i].moverectangle = nxgl_moverectangle_16bpp;
           be->plane[i].copyrectangle = nxgl_copyrectangle_16bpp;
+#ifdef CONFIG_NX_BLEND
+          be->plane[i].blendrectangle = nxgl_blendrectangle_16bpp;
+          be->plane[i].fillmask       = nxgl_fillmask_16bpp;
+#endif
         }
       else
 #endif
@@ -200,6 +204,10 @@ int nxbe_configure(FAR NX_DRIVERTYPE *dev, FAR struct nxbe_state_s *be)
           be->plane[i].filltrapezoid = nxgl_filltrapezoid_24bpp;
           be->plane[i].moverectangle = nxgl_moverectangle_24bpp;
           be->plane[i].copyrectangle = nxgl_copyrectangle_24bpp;
+#ifdef CONFIG_NX_BLEND
+          be->plane[i].blendrectangle = nxgl_blendrectangle_24bpp;
+          be->plane[i].fillmask       = nxgl_fillmask_24bpp;
+#endif
         }
       else
 #endif
@@ -212,6 +220,10 @@ int nxbe_configure(FAR NX_DRIVERTYPE *dev, FAR struct nxbe_state_s *be)
           be->plane[i].filltrapezoid = nxgl_filltrapezoid_32bpp;
           be->plane[i].moverectangle = nxgl_moverectangle_32bpp;
           be->plane[i].copyrectangle = nxgl_copyrectangle_32bpp;
+#ifdef CONFIG_NX_BLEND
+          be->plane[i].blendrectangle = nxgl_blendrectangle_32bpp;
+          be->plane[i].fillmask       = nxgl_fillmask_32bpp;
+#endif
         }
       else
 #endif
@@ -0,0 +1,218 @@
+/****************************************************************************
+ * graphics/nxbe/nxbe_damage.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <debug.h>
+
+#include <nuttx/clock.h>
+#include <nuttx/nx/nxglib.h>
+
+#include "nxbe.h"
+
+#ifdef CONFIG_NX_UPDATE_DAMAGE
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Two rectangles are merged if their bounding box is no more than 1/4
+ * larger than the two of them, plus this much slack so that neighboring
+ * small regions (such as the glyphs of a line of text) are always merged.
+ */
+
+#define NXBE_DAMAGE_SLACK  (16 * 16)
+
+/* The area of a rectangle */
+
+#define NXBE_RECTAREA(r) \
+  ((uint32_t)((r)->pt2.x - (r)->pt1.x + 1) * \
+   (uint32_t)((r)->pt2.y - (r)->pt1.y + 1))
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxbe_damage_mergeable
+ *
+ * Description:
+ *   Return true if two rectangles should be replaced with their bounding
+ *   box.
+ *
+ ****************************************************************************/
+
+static bool nxbe_damage_mergeable(FAR const struct nxgl_rect_s *rect1,
+                                  FAR const struct nxgl_rect_s *rect2,
+                                  FAR struct nxgl_rect_s *bounds)
+{
+  uint32_t area;
+
+  nxgl_rectunion(bounds, rect1, rect2);
+
+  area = NXBE_RECTAREA(rect1) + NXBE_RECTAREA(rect2);
+  return NXBE_RECTAREA(bounds) <= area + (area >> 2) + NXBE_DAMAGE_SLACK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxbe_damage_add
+ *
+ * Description:
+ *   Add an updated rectangle to the damage list of a plane.  The rectangle
+ *   is merged with any rectangles in the list that it overlaps or touches,
+ *   provided that the merged bounding box does not include too much of the
+ *   display that was not updated.
+ *
+ * Input Parameters:
+ *   plane - The plane that was updated
+ *   rect  - The updated rectangle in absolute display coordinates
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void nxbe_damage_add(FAR struct nxbe_plane_s *plane,
+                     FAR const struct nxgl_rect_s *rect)
+{
+  FAR struct nxbe_damage_s *damage = &plane->damage;
+  struct nxgl_rect_s merged;
+  struct nxgl_rect_s bounds;
+  uint32_t growth;
+  uint32_t least;
+  int best;
+  int i;
+
+  if (damage->nrects == 0)
+    {
+      damage->start = clock_systimer();
+    }
+
+  merged = *rect;
+
+  for (; ; )
+    {
+      /* Absorb every rectangle that can be merged with the new one.  The
+       * merged rectangle may now absorb rectangles that were already
+       * checked, so start over after each merge.
+       */
+
+      i = 0;
+      while (i < damage->nrects)
+        {
+          if (nxbe_damage_mergeable(&damage->rect[i], &merged, &bounds))
+            {
+              merged          = bounds;
+              damage->rect[i] = damage->rect[--damage->nrects];
+              i               = 0;
+            }
+          else
+            {
+              i++;
+            }
+        }
+
+      if (damage->nrects < CONFIG_NX_UPDATE_DAMAGE_NRECTS)
+        {
+          damage->rect[damage->nrects++] = merged;
+          return;
+        }
+
+      /* The list is full.  Merge with the rectangle that grows the least
+       * and then try again with the result.
+       */
+
+      best  = 0;
+      least = UINT32_MAX;
+
+      for (i = 0; i < damage->nrects; i++)
+        {
+          nxgl_rectunion(&bounds, &damage->rect[i], &merged);
+          growth = NXBE_RECTAREA(&bounds) - NXBE_RECTAREA(&damage->rect[i]);
+          if (growth < least)
+            {
+              best  = i;
+              least = growth;
+            }
+        }
+
+      nxgl_rectunion(&merged, &damage->rect[best], &merged);
+      damage->rect[best] = damage->rect[--damage->nrects];
+    }
+}
+
+/****************************************************************************
+ * Name: nxbe_damage_flush
+ *
+ * Description:
+ *   Report every rectangle in the damage list of a plane with
+ *   nx_notify_rectangle() and empty the list.
+ *
+ * Input Parameters:
+ *   plane - The plane to be flushed
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void nxbe_damage_flush(FAR struct nxbe_plane_s *plane)
+{
+  FAR struct nxbe_damage_s *damage = &plane->damage;
+  int i;
+
+  for (i = 0; i < damage->nrects; i++)
+    {
+      ginfo("Flush rect={(%d,%d),(%d,%d)}\n",
+            damage->rect[i].pt1.x, damage->rect[i].pt1.y,
+            damage->rect[i].pt2.x, damage->rect[i].pt2.y);
+
+      nx_notify_rectangle(&plane->pinfo, &damage->rect[i]);
+    }
+
+  damage->nrects = 0;
+}
+
+#endif /* CONFIG_NX_UPDATE_DAMAGE */
@@ -78,7 +78,7 @@ static void nxbe_clipmovesrc(FAR struct nxbe_clipops_s *cops,
 {
   struct nxbe_move_s *info = (struct nxbe_move_s *)cops;
   struct nxgl_point_s offset;
-#ifdef CONFIG_NX_UPDATE
+#if defined(CONFIG_NX_UPDATE) && !defined(CONFIG_NX_UPDATE_MOVE)
   struct nxgl_rect_s update;
 #endif
 
@@ -93,7 +93,18 @@ static void nxbe_clipmovesrc(FAR struct nxbe_clipops_s *cops,
 
       plane->moverectangle(&plane->pinfo, rect, &offset);
 
-#ifdef CONFIG_NX_UPDATE
+#if defined(CONFIG_NX_UPDATE_MOVE)
+#ifdef CONFIG_NX_UPDATE_DAMAGE
+      /* External logic must see all earlier updates before the move */
+
+      nxbe_damage_flush(plane);
+#endif
+
+      /* Notify external logic that the region has been moved */
+
+      nx_notify_move(&plane->pinfo, rect, &offset);
+
+#elif defined(CONFIG_NX_UPDATE)
       /* Notify external logic that the display has been updated */
 
       update.pt1.x = offset.x;
@@ -101,7 +112,7 @@ static void nxbe_clipmovesrc(FAR struct nxbe_clipops_s *cops,
       update.pt2.x = rect->pt2.x + info->offset.x;
       update.pt2.y = rect->pt2.y + info->offset.y;
 
-      nx_notify_rectangle(&plane->pinfo, &update);
+      nxbe_notify_rectangle(plane, &update);
 #endif
     }
 }
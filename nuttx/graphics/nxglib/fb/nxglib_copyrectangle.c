@@ -71,12 +71,8 @@ void NXGL_FUNCNAME(nxgl_copyrectangle, NXGLIB_SUFFIX)
   unsigned int rows;
 
 #if NXGLIB_BITSPERPIXEL < 8
-  FAR const uint8_t *sptr;
-  FAR uint8_t *dptr;
-  uint8_t leadmask;
-  uint8_t tailmask;
-  uint8_t mask;
-  int lnlen;
+  unsigned int srem;
+  unsigned int drem;
 #endif
 
   /* Get the width of the framebuffer in bytes */
@@ -91,22 +87,10 @@ void NXGL_FUNCNAME(nxgl_copyrectangle, NXGLIB_SUFFIX)
   rows  = dest->pt2.y - dest->pt1.y + 1;
 
 #if NXGLIB_BITSPERPIXEL < 8
-# ifdef CONFIG_NX_PACKEDMSFIRST
+  /* Get the position of the first pixel in the first byte of each row */
 
-  /* Get the mask for pixels that are ordered so that they pack from the
-   * MS byte down.
-   */
-
-  leadmask = (uint8_t)(0xff >> (8 - NXGL_REMAINDERX(dest->pt1.x)));
-  tailmask = (uint8_t)(0xff << (8 - NXGL_REMAINDERX(dest->pt2.x-1)));
-# else
-  /* Get the mask for pixels that are ordered so that they pack from the
-   * LS byte up.
-   */
-
-  leadmask = (uint8_t)(0xff << (8 - NXGL_REMAINDERX(dest->pt1.x)));
-  tailmask = (uint8_t)(0xff >> (8 - NXGL_REMAINDERX(dest->pt1.x-1)));
-# endif
+  srem = NXGL_REMAINDERX(dest->pt1.x - origin->x);
+  drem = NXGL_REMAINDERX(dest->pt1.x);
 #endif
 
   /* Then copy the image */
@@ -117,37 +101,9 @@ void NXGL_FUNCNAME(nxgl_copyrectangle, NXGLIB_SUFFIX)
   while (rows--)
     {
 #if NXGLIB_BITSPERPIXEL < 8
-     /* Handle masking of the fractional initial byte */
-
-     mask  = leadmask;
-     sptr  = sline;
-     dptr  = dline;
-     lnlen = width;
-
-     if (lnlen > 1 && mask)
-        {
-          dptr[0] = (dptr[0] & ~mask) | (sptr[0] & mask);
-          mask = 0xff;
-          dptr++;
-          sptr++;
-          lnlen--;
-        }
-
-      /* Handle masking of the fractional final byte */
-
-      mask &= tailmask;
-      if (lnlen > 0 && mask)
-        {
-          dptr[lnlen-1] = (dptr[lnlen-1] & ~mask) | (sptr[lnlen-1] & mask);
-          lnlen--;
-        }
-
-      /* Handle all of the unmasked bytes in-between */
-
-      if (lnlen > 0)
-        {
-          NXGL_MEMCPY(dptr, sptr, lnlen);
-        }
+      /* Copy the line, masking the partial bytes at each end */
+
+      nxgl_lowrescopy(dline, drem, sline, srem, width);
 #else
       /* Copy the whole line */
 
@@ -77,12 +77,7 @@ void NXGL_FUNCNAME(nxgl_fillrectangle, NXGLIB_SUFFIX)
   int rows;
 
 #if NXGLIB_BITSPERPIXEL < 8
-  FAR uint8_t *dest;
   uint8_t mpixel = NXGL_MULTIPIXEL(color);
-  uint8_t leadmask;
-  uint8_t tailmask;
-  uint8_t mask;
-  int lnlen;
 #endif
 
   /* Get the width of the framebuffer in bytes */
@@ -98,59 +93,14 @@ void NXGL_FUNCNAME(nxgl_fillrectangle, NXGLIB_SUFFIX)
 
   line   = pinfo->fbmem + rect->pt1.y * stride + NXGL_SCALEX(rect->pt1.x);
 
-#if NXGLIB_BITSPERPIXEL < 8
-# ifdef CONFIG_NX_PACKEDMSFIRST
-
-  /* Get the mask for pixels that are ordered so that they pack from the
-   * MS byte down.
-   */
-
-  leadmask = (uint8_t)(0xff >> (8 - NXGL_REMAINDERX(rect->pt1.x)));
-  tailmask = (uint8_t)(0xff << (8 - NXGL_REMAINDERX(rect->pt2.x-1)));
-# else
-  /* Get the mask for pixels that are ordered so that they pack from the
-   * LS byte up.
-   */
-
-  leadmask = (uint8_t)(0xff << (8 - NXGL_REMAINDERX(rect->pt1.x)));
-  tailmask = (uint8_t)(0xff >> (8 - NXGL_REMAINDERX(rect->pt1.x-1)));
-# endif
-#endif
-
   /* Then fill the rectangle line-by-line */
 
   while (rows-- > 0)
     {
 #if NXGLIB_BITSPERPIXEL < 8
-     /* Handle masking of the fractional initial byte */
-
-     mask  = leadmask;
-     dest  = line;
-     lnlen = width;
-
-     if (lnlen > 1 && mask)
-        {
-          dest[0] = (dest[0] & ~mask) | (mpixel & mask);
-          mask = 0xff;
-          dest++;
-          lnlen--;
-        }
-
-      /* Handle masking of the fractional final byte */
-
-      mask &= tailmask;
-      if (lnlen > 0 && mask)
-        {
-          dest[lnlen-1] = (dest[lnlen-1] & ~mask) | (mpixel & mask);
-          lnlen--;
-        }
-
-      /* Handle all of the unmasked bytes in-between */
-
-      if (lnlen > 0)
-        {
-          NXGL_MEMSET(dest, (NXGL_PIXEL_T)color, lnlen);
-        }
+      /* Draw the raster line, masking the partial bytes at each end */
+
+      nxgl_lowresfill(line, NXGL_REMAINDERX(rect->pt1.x), width, mpixel);
 #else
       /* Draw the entire raster line */
 
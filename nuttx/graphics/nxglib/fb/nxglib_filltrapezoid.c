@@ -90,8 +90,6 @@ void NXGL_FUNCNAME(nxgl_filltrapezoid, NXGLIB_SUFFIX)(
 
 #if NXGLIB_BITSPERPIXEL < 8
   uint8_t mpixel = NXGL_MULTIPIXEL(color);
-  uint8_t mask;
-  int lnlen;
 #endif
 
   /* Get the width of the framebuffer in bytes */
@@ -215,43 +213,10 @@ void NXGL_FUNCNAME(nxgl_filltrapezoid, NXGLIB_SUFFIX)(
           width = ix2 - ix1 + 1;
 
 #if NXGLIB_BITSPERPIXEL < 8
-          /* Handle masking of the fractional initial byte */
+          /* Draw the run, masking the partial bytes at each end */
 
-#ifdef CONFIG_NX_PACKEDMSFIRST
-          mask  = (uint8_t)(0xff >> (8 - NXGL_REMAINDERX(ix1)));
-#else
-          mask  = (uint8_t)(0xff << (8 - NXGL_REMAINDERX(ix1)));
-#endif
-          dest  = line;
-          lnlen = width;
-
-          if (lnlen > 1 && mask)
-            {
-              dest[0] = (dest[0] & ~mask) | (mpixel & mask);
-              mask = 0xff;
-              dest++;
-              lnlen--;
-            }
-
-          /* Handle masking of the fractional final byte */
-
-#ifdef CONFIG_NX_PACKEDMSFIRST
-          mask &= (uint8_t)(0xff << (8 - NXGL_REMAINDERX(ix2)));
-#else
-          mask &= (uint8_t)(0xff >> (8 - NXGL_REMAINDERX(ix2)));
-#endif
-          if (lnlen > 0 && mask)
-            {
-              dest[lnlen-1] = (dest[lnlen-1] & ~mask) | (mpixel & mask);
-              lnlen--;
-            }
-
-          /* Handle all of the unmasked bytes in-between */
-
-          if (lnlen > 0)
-            {
-              NXGL_MEMSET(dest, (NXGL_PIXEL_T)color, lnlen);
-            }
+          dest = line + NXGL_SCALEX(ix1);
+          nxgl_lowresfill(dest, NXGL_REMAINDERX(ix1), width, mpixel);
 
 #else /* NXGLIB_BITSPERPIXEL < 8 */
 
@@ -46,58 +46,6 @@
 
 #include "nxglib_bitblit.h"
 
-/****************************************************************************
- * Private Functions
- ****************************************************************************/
-
-/****************************************************************************
- * Name: nxgl_lowresmemcpy
- ****************************************************************************/
-
-#if NXGLIB_BITSPERPIXEL < 8
-static inline void nxgl_lowresmemcpy(FAR uint8_t *dline, FAR const uint8_t *sline,
-                                     unsigned int width,
-                                     uint8_t leadmask, uint8_t tailmask)
-{
-  FAR const uint8_t *sptr;
-  FAR uint8_t *dptr;
-  uint8_t mask;
-  int lnlen;
-
-  /* Handle masking of the fractional initial byte */
-
-  mask  = leadmask;
-  sptr  = sline;
-  dptr  = dline;
-  lnlen = width;
-
-  if (lnlen > 1 && mask)
-     {
-       dptr[0] = (dptr[0] & ~mask) | (sptr[0] & mask);
-       mask = 0xff;
-       dptr++;
-       sptr++;
-       lnlen--;
-     }
-
-   /* Handle masking of the fractional final byte */
-
-   mask &= tailmask;
-   if (lnlen > 0 && mask)
-     {
-       dptr[lnlen-1] = (dptr[lnlen-1] & ~mask) | (sptr[lnlen-1] & mask);
-       lnlen--;
-     }
-
-   /* Handle all of the unmasked bytes in-between */
-
-   if (lnlen > 0)
-     {
-       NXGL_MEMCPY(dptr, sptr, lnlen);
-     }
-}
-#endif
-
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -121,10 +69,6 @@ void NXGL_FUNCNAME(nxgl_getrectangle, NXGLIB_SUFFIX)
   unsigned int fbstride;
   unsigned int rows;
 
-#if NXGLIB_BITSPERPIXEL < 8
-  uint8_t leadmask;
-  uint8_t tailmask;
-#endif
 
   /* Get the width of the framebuffer in bytes */
 
@@ -137,25 +81,6 @@ void NXGL_FUNCNAME(nxgl_getrectangle, NXGLIB_SUFFIX)
   width = rect->pt2.x - rect->pt1.x + 1;
   rows  = rect->pt2.y - rect->pt1.y + 1;
 
-#if NXGLIB_BITSPERPIXEL < 8
-# ifdef CONFIG_NX_PACKEDMSFIRST
-
-  /* Get the mask for pixels that are ordered so that they pack from the
-   * MS byte down.
-   */
-
-  leadmask = (uint8_t)(0xff >> (8 - NXGL_REMAINDERX(rect->pt1.x)));
-  tailmask = (uint8_t)(0xff << (8 - NXGL_REMAINDERX(rect->pt2.x-1)));
-# else
-  /* Get the mask for pixels that are ordered so that they pack from the
-   * LS byte up.
-   */
-
-  leadmask = (uint8_t)(0xff << (8 - NXGL_REMAINDERX(rect->pt1.x)));
-  tailmask = (uint8_t)(0xff >> (8 - NXGL_REMAINDERX(rect->pt1.x-1)));
-# endif
-#endif
-
   /* sline = address of the first pixel in the top row of the source in
    * framebuffer memory
    */
@@ -173,7 +98,7 @@ void NXGL_FUNCNAME(nxgl_getrectangle, NXGLIB_SUFFIX)
       /* Copy the row */
 
 #if NXGLIB_BITSPERPIXEL < 8
-      nxgl_lowresmemcpy(dline, sline, width, leadmask, tailmask);
+      nxgl_lowrescopy(dline, 0, sline, NXGL_REMAINDERX(rect->pt1.x), width);
 #else
       NXGL_MEMCPY(dline, sline, width);
 #endif
@@ -0,0 +1,104 @@
+/****************************************************************************
+ * graphics/nxglib/lcd/nxglib_blendrectangle.c
+ *
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+
+#include <nuttx/lcd/lcd.h>
+#include <nuttx/nx/nxglib.h>
+
+#include "nxglib_bitblit.h"
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxgl_blendrectangle_*bpp
+ *
+ * Descripton:
+ *   Blend a rectangular bitmap image over the specific position on the
+ *   LCD with a constant opacity, from 0 (transparent) to 255 (opaque).
+ *   Each row is read into the run buffer, blended and written back.
+ *
+ ****************************************************************************/
+
+void NXGL_FUNCNAME(nxgl_blendrectangle, NXGLIB_SUFFIX)
+(FAR struct lcd_planeinfo_s *pinfo, FAR const struct nxgl_rect_s *dest,
+ FAR const void *src, FAR const struct nxgl_point_s *origin,
+ unsigned int srcstride, uint8_t alpha)
+{
+  FAR const uint8_t *sline;
+  unsigned int ncols;
+  unsigned int row;
+
+  if (alpha == 0)
+    {
+      return;
+    }
+
+  /* Get the width of the rectange to blend in pixels */
+
+  ncols = dest->pt2.x - dest->pt1.x + 1;
+
+  /* Set up to blend the image */
+
+  sline = (FAR const uint8_t *)src + NXGL_SCALEX(dest->pt1.x - origin->x) +
+          (dest->pt1.y - origin->y) * srcstride;
+
+  /* Blend the image, one row at a time */
+
+  for (row = dest->pt1.y; row <= dest->pt2.y; row++)
+    {
+      if (alpha == 255)
+        {
+          (void)pinfo->putrun(row, dest->pt1.x, sline, ncols);
+        }
+      else
+        {
+          (void)pinfo->getrun(row, dest->pt1.x, pinfo->buffer, ncols);
+          NXGL_BLENDRUN(pinfo->buffer, sline, ncols, alpha);
+          (void)pinfo->putrun(row, dest->pt1.x, pinfo->buffer, ncols);
+        }
+
+      sline += srcstride;
+    }
+}
@@ -43,9 +43,13 @@
 #include <nuttx/config.h>
 
 #include <stdint.h>
+#include <stdbool.h>
 
 #include <nuttx/nx/nxglib.h>
 
+#include "nxglib_wide.h"
+#include "nxglib_blend.h"
+
 /****************************************************************************
  * Pre-processor Definitions
  ****************************************************************************/
@@ -120,53 +124,45 @@
 #  define NXGL_ALIGNDOWN(x)        ((x) & ~NXGL_PIXELMASK)
 #  define NXGL_ALIGNUP(x)          (((x) + NXGL_PIXELMASK) & ~NXGL_PIXELMASK)
 
+/* The largest pixel value, the bit position of pixel n (0..NXGL_PIXELMASK)
+ * within a byte, the mask of the pixels from pixel n to the end of a byte
+ * and the mask of the pixels from the start of a byte through pixel n.
+ */
+
+#  define NXGL_PIXELMAX            ((1 << NXGLIB_BITSPERPIXEL) - 1)
+
+#  ifdef CONFIG_NX_PACKEDMSFIRST
+#    define NXGL_PIXELBIT(n)       (8 - NXGLIB_BITSPERPIXEL * ((n) + 1))
+#    define NXGL_LEADMASK(n)       ((uint8_t)(0xff >> (NXGLIB_BITSPERPIXEL * (n))))
+#    define NXGL_TAILMASK(n)       ((uint8_t)(0xff << NXGL_PIXELBIT(n)))
+#  else
+#    define NXGL_PIXELBIT(n)       (NXGLIB_BITSPERPIXEL * (n))
+#    define NXGL_LEADMASK(n)       ((uint8_t)(0xff << NXGL_PIXELBIT(n)))
+#    define NXGL_TAILMASK(n)       ((uint8_t)(0xff >> (8 - NXGLIB_BITSPERPIXEL * ((n) + 1))))
+#  endif
+
+#elif NXGLIB_BITSPERPIXEL == 8
+
 #  define NXGL_MEMSET(dest,value,width) \
-   { \
-     FAR uint8_t *_ptr = (FAR uint8_t*)(dest); \
-     int        _nby = NXGL_SCALEX(width); \
-     while (_nby--) \
-       { \
-         *_ptr++ = (value); \
-       } \
-   }
+     nxgl_wmemset8((FAR uint8_t *)(dest), (value), (width))
 
 #  define NXGL_MEMCPY(dest,src,width) \
-   { \
-     FAR uint8_t *_dptr = (FAR uint8_t*)(dest); \
-     FAR uint8_t *_sptr = (FAR uint8_t*)(src); \
-     int        _nby  = NXGL_SCALEX(width); \
-     while (_nby--) \
-       { \
-         *_dptr++ = *_sptr++; \
-       } \
-   }
+     nxgl_wmemmove((dest), (src), (width))
 
 #elif NXGLIB_BITSPERPIXEL == 24
 
 #  define NXGL_MEMSET(dest,value,width) \
-   { \
-     FAR uint8_t *_ptr  = (FAR uint8_t*)(dest); \
-     nxgl_coord_t _npix = (width); \
-     while (_npix--) \
-       { \
-         *_ptr++ = (value); \
-         *_ptr++ = (value) >> 8; \
-         *_ptr++ = (value) >> 16; \
-       } \
-   }
+     nxgl_wmemset24((FAR uint8_t *)(dest), (value), (width))
 
 #  define NXGL_MEMCPY(dest,src,width) \
-   { \
-     FAR uint8_t *_dptr = (FAR uint8_t*)(dest); \
-     FAR uint8_t *_sptr = (FAR uint8_t*)(src); \
-     nxgl_coord_t _npix = (width); \
-     while (_npix--) \
-       { \
-         *_dptr++ = *_sptr++; \
-         *_dptr++ = *_sptr++; \
-         *_dptr++ = *_sptr++; \
-       } \
-   }
+     nxgl_wmemmove((dest), (src), 3 * (width))
+
+#  define NXGL_BLENDRUN(dest,src,width,alpha) \
+     nxgl_blendrun24((FAR uint8_t *)(dest), (FAR const uint8_t *)(src), \
+                     (width), (alpha))
+
+#  define NXGL_MASKRUN(dest,mask,width,color) \
+     nxgl_maskrun24((FAR uint8_t *)(dest), (mask), (width), (color))
 
 #ifdef CONFIG_NX_ANTIALIASING
 
@@ -187,26 +183,32 @@
 #endif /* CONFIG_NX_ANTIALIASING */
 #else /* NXGLIB_BITSPERPIXEL == 16 || NXGLIB_BITSPERPIXEL == 32 */
 
+#if NXGLIB_BITSPERPIXEL == 16
 #  define NXGL_MEMSET(dest,value,width) \
-   { \
-     FAR NXGL_PIXEL_T *_ptr = (FAR NXGL_PIXEL_T*)(dest); \
-     nxgl_coord_t     _npix = (width); \
-     while (_npix--) \
-       { \
-         *_ptr++ = (value); \
-       } \
-   }
+     nxgl_wmemset16((FAR uint16_t *)(dest), (value), (width))
+#else
+#  define NXGL_MEMSET(dest,value,width) \
+     nxgl_wmemset32((FAR uint32_t *)(dest), (value), (width))
+#endif
 
 #  define NXGL_MEMCPY(dest,src,width) \
-   { \
-     FAR NXGL_PIXEL_T *_dptr = (FAR NXGL_PIXEL_T*)(dest); \
-     FAR NXGL_PIXEL_T *_sptr = (FAR NXGL_PIXEL_T*)(src); \
-     nxgl_coord_t      _npix = (width); \
-     while (_npix--) \
-       { \
-         *_dptr++ = *_sptr++; \
-       } \
-   }
+     nxgl_wmemmove((dest), (src), sizeof(NXGL_PIXEL_T) * (width))
+
+#if NXGLIB_BITSPERPIXEL == 16
+#  define NXGL_BLENDRUN(dest,src,width,alpha) \
+     nxgl_blendrun16((FAR uint16_t *)(dest), (FAR const uint16_t *)(src), \
+                     (width), (alpha))
+
+#  define NXGL_MASKRUN(dest,mask,width,color) \
+     nxgl_maskrun16((FAR uint16_t *)(dest), (mask), (width), (color))
+#else
+#  define NXGL_BLENDRUN(dest,src,width,alpha) \
+     nxgl_blendrun32((FAR uint32_t *)(dest), (FAR const uint32_t *)(src), \
+                     (width), (alpha))
+
+#  define NXGL_MASKRUN(dest,mask,width,color) \
+     nxgl_maskrun32((FAR uint32_t *)(dest), (mask), (width), (color))
+#endif
 
 #ifdef CONFIG_NX_ANTIALIASING
 
@@ -250,4 +252,159 @@ extern "C" {
 }
 #endif
 
+/****************************************************************************
+ * Inline Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxgl_lowresfill
+ *
+ * Description:
+ *   Fill a run of packed 1-, 2- or 4-bit pixels.  dest is the byte that
+ *   holds the first pixel and rem is the position of that pixel in the
+ *   byte.  The partial bytes at the ends of the run are masked; the whole
+ *   bytes in between are filled a word at a time.
+ *
+ ****************************************************************************/
+
+#if NXGLIB_BITSPERPIXEL < 8
+static inline void nxgl_lowresfill(FAR uint8_t *dest, unsigned int rem,
+                                   unsigned int width, uint8_t mpixel)
+{
+  FAR uint8_t *end;
+  unsigned int last;
+  uint8_t mask;
+
+  /* Get the byte that holds the final pixel and its position in it */
+
+  last = rem + width - 1;
+  end  = dest + (last >> NXGL_PIXELSHIFT);
+  last = NXGL_REMAINDERX(last);
+
+  if (end == dest)
+    {
+      mask  = NXGL_LEADMASK(rem) & NXGL_TAILMASK(last);
+      *dest = (*dest & ~mask) | (mpixel & mask);
+      return;
+    }
+
+  if (rem != 0)
+    {
+      mask  = NXGL_LEADMASK(rem);
+      *dest = (*dest & ~mask) | (mpixel & mask);
+      dest++;
+    }
+
+  if (last != NXGL_PIXELMASK)
+    {
+      mask  = NXGL_TAILMASK(last);
+      *end  = (*end & ~mask) | (mpixel & mask);
+    }
+  else
+    {
+      end++;
+    }
+
+  if (end > dest)
+    {
+      nxgl_wmemset8(dest, mpixel, end - dest);
+    }
+}
+
+/****************************************************************************
+ * Name: nxgl_lowrescopy
+ *
+ * Description:
+ *   Copy a run of packed 1-, 2- or 4-bit pixels.  dest and src are the
+ *   bytes that hold the first pixel of each run and drem and srem are the
+ *   positions of those pixels in the bytes.  The runs may overlap.
+ *
+ *   If the pixels have the same position in their bytes, the partial end
+ *   bytes are masked and the bytes in between are copied a word at a time.
+ *   Otherwise every pixel must be shifted and the run is copied pixel by
+ *   pixel.
+ *
+ ****************************************************************************/
+
+static inline void nxgl_lowrescopy(FAR uint8_t *dest, unsigned int drem,
+                                   FAR const uint8_t *src, unsigned int srem,
+                                   unsigned int width)
+{
+  unsigned int last;
+  unsigned int first;
+  unsigned int end;
+  uint8_t lead;
+  uint8_t tail;
+  uint8_t mask;
+
+  if (drem == srem)
+    {
+      last = drem + width - 1;
+      end  = last >> NXGL_PIXELSHIFT;
+      last = NXGL_REMAINDERX(last);
+
+      if (end == 0)
+        {
+          mask  = NXGL_LEADMASK(drem) & NXGL_TAILMASK(last);
+          *dest = (*dest & ~mask) | (*src & mask);
+          return;
+        }
+
+      /* Save the partial source bytes in case the copy overwrites them */
+
+      lead  = src[0];
+      tail  = src[end];
+      first = (drem != 0) ? 1 : 0;
+
+      if (last == NXGL_PIXELMASK)
+        {
+          end++;
+        }
+
+      if (end > first)
+        {
+          nxgl_wmemmove(dest + first, src + first, end - first);
+        }
+
+      if (drem != 0)
+        {
+          mask    = NXGL_LEADMASK(drem);
+          dest[0] = (dest[0] & ~mask) | (lead & mask);
+        }
+
+      if (last != NXGL_PIXELMASK)
+        {
+          mask      = NXGL_TAILMASK(last);
+          dest[end] = (dest[end] & ~mask) | (tail & mask);
+        }
+    }
+  else
+    {
+      FAR uint8_t *dptr;
+      unsigned int dpos;
+      unsigned int spos;
+      unsigned int i;
+      uint8_t pixel;
+
+      /* Copy from the end if the destination follows the source */
+
+      bool backward = (dest > src || (dest == src && drem > srem));
+
+      for (i = 0; i < width; i++)
+        {
+          spos  = srem + (backward ? width - 1 - i : i);
+          dpos  = drem + (backward ? width - 1 - i : i);
+
+          pixel = (src[spos >> NXGL_PIXELSHIFT] >>
+                   NXGL_PIXELBIT(NXGL_REMAINDERX(spos))) & NXGL_PIXELMAX;
+
+          dptr  = &dest[dpos >> NXGL_PIXELSHIFT];
+          mask  = NXGL_PIXELMAX << NXGL_PIXELBIT(NXGL_REMAINDERX(dpos));
+          *dptr = (*dptr & ~mask) |
+                  (pixel << NXGL_PIXELBIT(NXGL_REMAINDERX(dpos)));
+        }
+    }
+}
+#endif /* NXGLIB_BITSPERPIXEL < 8 */
+
 #endif /* __GRAPHICS_NXGLIB_NXGLIB_BITBLIT_H */
@@ -0,0 +1,266 @@
+/****************************************************************************
+ * graphics/nxglib/nxglib_blend.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+
+#include "nxglib_blend.h"
+
+#ifdef CONFIG_NX_BLEND
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Scale an 8-bit opacity to the range 0..256 so that the blend can divide
+ * by shifting and 255 still gives the source color exactly.
+ */
+
+#define NXGL_ALPHA256(a)   ((uint32_t)(a) + ((uint32_t)(a) >> 7))
+
+/* RGB565 with the green field moved to the upper half word.  This leaves
+ * enough room above each field for its product with a 5-bit opacity, so
+ * that all three fields are blended with a single multiply.
+ */
+
+#define NXGL_RGB565MASK    0x07e0f81f
+#define NXGL_EXPAND565(c)  (((uint32_t)(c) | ((uint32_t)(c) << 16)) & NXGL_RGB565MASK)
+#define NXGL_PACK565(x)    ((uint16_t)((x) | ((x) >> 16)))
+#define NXGL_ALPHA32(a)    (((uint32_t)(a) + 4) >> 3)
+
+/* RGB888 split into the red and blue fields and the green field.  Each
+ * pair is blended with a single multiply.
+ */
+
+#define NXGL_RBMASK        0x00ff00ff
+#define NXGL_GMASK         0x0000ff00
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxgl_blend565
+ *
+ * Description:
+ *   Blend two expanded RGB565 colors.  a is the opacity of the source
+ *   in the range 0..32.  The borrows from a field whose source value is
+ *   smaller than the destination value cancel when the destination is
+ *   added back.
+ *
+ ****************************************************************************/
+
+static inline uint32_t nxgl_blend565(uint32_t dx, uint32_t sx, uint32_t a)
+{
+  return (dx + (((sx - dx) * a) >> 5)) & NXGL_RGB565MASK;
+}
+
+/****************************************************************************
+ * Name: nxgl_blend888
+ *
+ * Description:
+ *   Blend two RGB888 colors.  a is the opacity of the source in the range
+ *   0..256.  The upper byte of the destination is kept.
+ *
+ ****************************************************************************/
+
+static inline uint32_t nxgl_blend888(uint32_t d, uint32_t s, uint32_t a)
+{
+  uint32_t rb = d & NXGL_RBMASK;
+  uint32_t g  = d & NXGL_GMASK;
+
+  rb += (((s & NXGL_RBMASK) - rb) * a) >> 8;
+  g  += (((s & NXGL_GMASK) - g) * a) >> 8;
+
+  return (d & 0xff000000) | (rb & NXGL_RBMASK) | (g & NXGL_GMASK);
+}
+
+/****************************************************************************
+ * Name: nxgl_get24 and nxgl_put24
+ *
+ * Description:
+ *   Read and write one packed 24-bit pixel, in the same byte order that
+ *   nxgl_wmemset24() uses.
+ *
+ ****************************************************************************/
+
+static inline uint32_t nxgl_get24(FAR const uint8_t *src)
+{
+  return (uint32_t)src[0] | ((uint32_t)src[1] << 8) |
+         ((uint32_t)src[2] << 16);
+}
+
+static inline void nxgl_put24(FAR uint8_t *dest, uint32_t color)
+{
+  dest[0] = color;
+  dest[1] = color >> 8;
+  dest[2] = color >> 16;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxgl_blendrun16
+ ****************************************************************************/
+
+void nxgl_blendrun16(FAR uint16_t *dest, FAR const uint16_t *src,
+                     size_t npixels, uint8_t alpha)
+{
+  uint32_t a = NXGL_ALPHA32(alpha);
+  uint32_t dx;
+
+  while (npixels-- > 0)
+    {
+      dx      = nxgl_blend565(NXGL_EXPAND565(*dest), NXGL_EXPAND565(*src), a);
+      *dest++ = NXGL_PACK565(dx);
+      src++;
+    }
+}
+
+/****************************************************************************
+ * Name: nxgl_blendrun24
+ ****************************************************************************/
+
+void nxgl_blendrun24(FAR uint8_t *dest, FAR const uint8_t *src,
+                     size_t npixels, uint8_t alpha)
+{
+  uint32_t a = NXGL_ALPHA256(alpha);
+
+  while (npixels-- > 0)
+    {
+      nxgl_put24(dest, nxgl_blend888(nxgl_get24(dest), nxgl_get24(src), a));
+      dest += 3;
+      src  += 3;
+    }
+}
+
+/****************************************************************************
+ * Name: nxgl_blendrun32
+ ****************************************************************************/
+
+void nxgl_blendrun32(FAR uint32_t *dest, FAR const uint32_t *src,
+                     size_t npixels, uint8_t alpha)
+{
+  uint32_t a = NXGL_ALPHA256(alpha);
+
+  while (npixels-- > 0)
+    {
+      *dest = nxgl_blend888(*dest, *src++, a);
+      dest++;
+    }
+}
+
+/****************************************************************************
+ * Name: nxgl_maskrun16
+ ****************************************************************************/
+
+void nxgl_maskrun16(FAR uint16_t *dest, FAR const uint8_t *mask,
+                    size_t npixels, uint16_t color)
+{
+  uint32_t sx = NXGL_EXPAND565(color);
+  uint32_t dx;
+  uint8_t m;
+
+  for (; npixels > 0; npixels--, dest++)
+    {
+      m = *mask++;
+      if (m == 255)
+        {
+          *dest = color;
+        }
+      else if (m != 0)
+        {
+          dx    = nxgl_blend565(NXGL_EXPAND565(*dest), sx, NXGL_ALPHA32(m));
+          *dest = NXGL_PACK565(dx);
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: nxgl_maskrun24
+ ****************************************************************************/
+
+void nxgl_maskrun24(FAR uint8_t *dest, FAR const uint8_t *mask,
+                    size_t npixels, uint32_t color)
+{
+  uint8_t m;
+
+  for (; npixels > 0; npixels--, dest += 3)
+    {
+      m = *mask++;
+      if (m == 255)
+        {
+          nxgl_put24(dest, color);
+        }
+      else if (m != 0)
+        {
+          nxgl_put24(dest, nxgl_blend888(nxgl_get24(dest), color,
+                                         NXGL_ALPHA256(m)));
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: nxgl_maskrun32
+ ****************************************************************************/
+
+void nxgl_maskrun32(FAR uint32_t *dest, FAR const uint8_t *mask,
+                    size_t npixels, uint32_t color)
+{
+  uint8_t m;
+
+  for (; npixels > 0; npixels--, dest++)
+    {
+      m = *mask++;
+      if (m == 255)
+        {
+          *dest = color;
+        }
+      else if (m != 0)
+        {
+          *dest = nxgl_blend888(*dest, color, NXGL_ALPHA256(m));
+        }
+    }
+}
+
+#endif /* CONFIG_NX_BLEND */
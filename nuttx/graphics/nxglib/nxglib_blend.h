@@ -0,0 +1,104 @@
+/****************************************************************************
+ * graphics/nxglib/nxglib_blend.h
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+#ifndef __GRAPHICS_NXGLIB_NXGLIB_BLEND_H
+#define __GRAPHICS_NXGLIB_NXGLIB_BLEND_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+
+#ifdef CONFIG_NX_BLEND
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+#undef EXTERN
+#if defined(__cplusplus)
+#define EXTERN extern "C"
+extern "C" {
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Name: nxgl_blendrun16, nxgl_blendrun24, and nxgl_blendrun32
+ *
+ * Description:
+ *   Blend a run of RGB565, packed RGB888 or RGB888 (in 32 bits) source
+ *   pixels over the destination pixels with a constant opacity.  alpha
+ *   ranges from 0 (transparent) to 255 (opaque).  nxgl_blendrun32 keeps
+ *   the upper byte of each destination pixel.
+ *
+ ****************************************************************************/
+
+void nxgl_blendrun16(FAR uint16_t *dest, FAR const uint16_t *src,
+                     size_t npixels, uint8_t alpha);
+void nxgl_blendrun24(FAR uint8_t *dest, FAR const uint8_t *src,
+                     size_t npixels, uint8_t alpha);
+void nxgl_blendrun32(FAR uint32_t *dest, FAR const uint32_t *src,
+                     size_t npixels, uint8_t alpha);
+
+/****************************************************************************
+ * Name: nxgl_maskrun16, nxgl_maskrun24, and nxgl_maskrun32
+ *
+ * Description:
+ *   Draw a run of pixels of one color through an 8-bit coverage mask, as
+ *   produced by an anti-aliasing glyph rasterizer.  Each byte of the mask
+ *   is the opacity of the color over the corresponding destination pixel,
+ *   from 0 (untouched) to 255 (replaced by the color).
+ *
+ ****************************************************************************/
+
+void nxgl_maskrun16(FAR uint16_t *dest, FAR const uint8_t *mask,
+                    size_t npixels, uint16_t color);
+void nxgl_maskrun24(FAR uint8_t *dest, FAR const uint8_t *mask,
+                    size_t npixels, uint32_t color);
+void nxgl_maskrun32(FAR uint32_t *dest, FAR const uint8_t *mask,
+                    size_t npixels, uint32_t color);
+
+#undef EXTERN
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* CONFIG_NX_BLEND */
+#endif /* __GRAPHICS_NXGLIB_NXGLIB_BLEND_H */
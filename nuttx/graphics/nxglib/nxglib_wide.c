@@ -0,0 +1,472 @@
+/****************************************************************************
+ * graphics/nxglib/nxglib_wide.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "nxglib_wide.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* The runs are written with the natural word size of the machine */
+
+#define NXGL_WORDSIZE      sizeof(uintptr_t)
+#define NXGL_WORDMASK      (sizeof(uintptr_t) - 1)
+#define NXGL_WORDBITS      (8 * sizeof(uintptr_t))
+#define NXGL_ALIGNED(p)    (((uintptr_t)(p) & NXGL_WORDMASK) == 0)
+
+/* Replicate a value across a word */
+
+#define NXGL_REPLICATE8(v)  ((uintptr_t)(v) * (UINTPTR_MAX / 0xff))
+#define NXGL_REPLICATE16(v) ((uintptr_t)(v) * (UINTPTR_MAX / 0xffff))
+#if UINTPTR_MAX > 0xffff
+#  define NXGL_REPLICATE32(v) ((uintptr_t)(v) * (UINTPTR_MAX / 0xffffffff))
+#endif
+
+/* Form one destination word from two adjacent source words when the
+ * source is 'lo' bits past a word boundary and the destination is not.
+ */
+
+#ifdef CONFIG_ENDIAN_BIG
+#  define NXGL_MERGE(w1,w2,lo,hi) (((w1) << (lo)) | ((w2) >> (hi)))
+#else
+#  define NXGL_MERGE(w1,w2,lo,hi) (((w1) >> (lo)) | ((w2) << (hi)))
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxgl_fillwords
+ *
+ * Description:
+ *   Write a pattern to a run of aligned words.
+ *
+ ****************************************************************************/
+
+static void nxgl_fillwords(FAR uintptr_t *dest, uintptr_t pattern,
+                           size_t nwords)
+{
+  while (nwords >= 4)
+    {
+      dest[0] = pattern;
+      dest[1] = pattern;
+      dest[2] = pattern;
+      dest[3] = pattern;
+      dest   += 4;
+      nwords -= 4;
+    }
+
+  while (nwords-- > 0)
+    {
+      *dest++ = pattern;
+    }
+}
+
+/****************************************************************************
+ * Name: nxgl_copyforward
+ *
+ * Description:
+ *   Copy a run of bytes from the first byte to the last.  The destination
+ *   is aligned to a word boundary and then written a word at a time.  If
+ *   the source is then not aligned too, each destination word is formed
+ *   from two aligned source words.  Only source words that hold bytes of
+ *   the run are read.
+ *
+ ****************************************************************************/
+
+static void nxgl_copyforward(FAR uint8_t *dest, FAR const uint8_t *src,
+                             size_t nbytes)
+{
+  FAR const uintptr_t *sw;
+  FAR uintptr_t *dw;
+  uintptr_t prev;
+  uintptr_t next;
+  unsigned int lo;
+  unsigned int hi;
+  size_t nwords;
+
+  if (nbytes >= 2 * NXGL_WORDSIZE)
+    {
+      while (!NXGL_ALIGNED(dest))
+        {
+          *dest++ = *src++;
+          nbytes--;
+        }
+
+      nwords  = nbytes / NXGL_WORDSIZE;
+      dw      = (FAR uintptr_t *)dest;
+      lo      = 8 * ((uintptr_t)src & NXGL_WORDMASK);
+      dest   += nwords * NXGL_WORDSIZE;
+      src    += nwords * NXGL_WORDSIZE;
+      nbytes &= NXGL_WORDMASK;
+
+      if (lo == 0)
+        {
+          sw = (FAR const uintptr_t *)(src - nwords * NXGL_WORDSIZE);
+
+          while (nwords >= 4)
+            {
+              dw[0]   = sw[0];
+              dw[1]   = sw[1];
+              dw[2]   = sw[2];
+              dw[3]   = sw[3];
+              dw     += 4;
+              sw     += 4;
+              nwords -= 4;
+            }
+
+          while (nwords-- > 0)
+            {
+              *dw++ = *sw++;
+            }
+        }
+      else
+        {
+          hi   = NXGL_WORDBITS - lo;
+          sw   = (FAR const uintptr_t *)
+                 (src - nwords * NXGL_WORDSIZE - (lo >> 3));
+          prev = *sw++;
+
+          while (nwords-- > 0)
+            {
+              next  = *sw++;
+              *dw++ = NXGL_MERGE(prev, next, lo, hi);
+              prev  = next;
+            }
+        }
+    }
+
+  while (nbytes-- > 0)
+    {
+      *dest++ = *src++;
+    }
+}
+
+/****************************************************************************
+ * Name: nxgl_copybackward
+ *
+ * Description:
+ *   Copy a run of bytes from the last byte to the first.  This is the
+ *   mirror image of nxgl_copyforward() and is used when the destination
+ *   overlaps the end of the source.
+ *
+ ****************************************************************************/
+
+static void nxgl_copybackward(FAR uint8_t *dest, FAR const uint8_t *src,
+                              size_t nbytes)
+{
+  FAR const uintptr_t *sw;
+  FAR uintptr_t *dw;
+  uintptr_t prev;
+  uintptr_t next;
+  unsigned int lo;
+  unsigned int hi;
+  size_t nwords;
+
+  dest += nbytes;
+  src  += nbytes;
+
+  if (nbytes >= 2 * NXGL_WORDSIZE)
+    {
+      while (!NXGL_ALIGNED(dest))
+        {
+          *--dest = *--src;
+          nbytes--;
+        }
+
+      nwords  = nbytes / NXGL_WORDSIZE;
+      dw      = (FAR uintptr_t *)dest;
+      lo      = 8 * ((uintptr_t)src & NXGL_WORDMASK);
+      dest   -= nwords * NXGL_WORDSIZE;
+      src    -= nwords * NXGL_WORDSIZE;
+      nbytes &= NXGL_WORDMASK;
+
+      if (lo == 0)
+        {
+          sw = (FAR const uintptr_t *)(src + nwords * NXGL_WORDSIZE);
+
+          while (nwords >= 4)
+            {
+              dw     -= 4;
+              sw     -= 4;
+              dw[3]   = sw[3];
+              dw[2]   = sw[2];
+              dw[1]   = sw[1];
+              dw[0]   = sw[0];
+              nwords -= 4;
+            }
+
+          while (nwords-- > 0)
+            {
+              *--dw = *--sw;
+            }
+        }
+      else
+        {
+          hi   = NXGL_WORDBITS - lo;
+          sw   = (FAR const uintptr_t *)
+                 (src + nwords * NXGL_WORDSIZE - (lo >> 3));
+          next = *sw;
+
+          while (nwords-- > 0)
+            {
+              prev  = *--sw;
+              *--dw = NXGL_MERGE(prev, next, lo, hi);
+              next  = prev;
+            }
+        }
+    }
+
+  while (nbytes-- > 0)
+    {
+      *--dest = *--src;
+    }
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nxgl_wmemset8
+ ****************************************************************************/
+
+void nxgl_wmemset8(FAR uint8_t *dest, uint8_t value, size_t nbytes)
+{
+#ifdef CONFIG_LIBC_ARCH_MEMSET
+  /* The architecture-specific memset() is at least as good */
+
+  memset(dest, value, nbytes);
+#else
+  size_t nwords;
+
+  if (nbytes >= 2 * NXGL_WORDSIZE)
+    {
+      while (!NXGL_ALIGNED(dest))
+        {
+          *dest++ = value;
+          nbytes--;
+        }
+
+      nwords = nbytes / NXGL_WORDSIZE;
+      nxgl_fillwords((FAR uintptr_t *)dest, NXGL_REPLICATE8(value), nwords);
+
+      dest   += nwords * NXGL_WORDSIZE;
+      nbytes &= NXGL_WORDMASK;
+    }
+
+  while (nbytes-- > 0)
+    {
+      *dest++ = value;
+    }
+#endif
+}
+
+/****************************************************************************
+ * Name: nxgl_wmemset16
+ ****************************************************************************/
+
+void nxgl_wmemset16(FAR uint16_t *dest, uint16_t value, size_t npixels)
+{
+  size_t nwords;
+
+  /* Short runs and odd-aligned 16-bit pixels are written one at a time */
+
+  if (npixels >= NXGL_WORDSIZE && ((uintptr_t)dest & 1) == 0)
+    {
+      while (!NXGL_ALIGNED(dest))
+        {
+          *dest++ = value;
+          npixels--;
+        }
+
+      nwords = npixels / (NXGL_WORDSIZE / 2);
+      nxgl_fillwords((FAR uintptr_t *)dest, NXGL_REPLICATE16(value), nwords);
+
+      dest    += nwords * (NXGL_WORDSIZE / 2);
+      npixels -= nwords * (NXGL_WORDSIZE / 2);
+    }
+
+  while (npixels-- > 0)
+    {
+      *dest++ = value;
+    }
+}
+
+/****************************************************************************
+ * Name: nxgl_wmemset24
+ ****************************************************************************/
+
+void nxgl_wmemset24(FAR uint8_t *dest, uint32_t value, size_t npixels)
+{
+  union
+  {
+    uint8_t   b[3 * sizeof(uintptr_t)];
+    uintptr_t w[3];
+  } pattern;
+  FAR uintptr_t *dw;
+  int i;
+
+  if (npixels >= 2 * NXGL_WORDSIZE)
+    {
+      /* Three is prime to the word size, so fewer than NXGL_WORDSIZE
+       * pixels bring the run to a word boundary.  Then NXGL_WORDSIZE
+       * pixels fill exactly three words.
+       */
+
+      while (!NXGL_ALIGNED(dest))
+        {
+          *dest++ = value;
+          *dest++ = value >> 8;
+          *dest++ = value >> 16;
+          npixels--;
+        }
+
+      for (i = 0; i < 3 * NXGL_WORDSIZE; i += 3)
+        {
+          pattern.b[i]     = value;
+          pattern.b[i + 1] = value >> 8;
+          pattern.b[i + 2] = value >> 16;
+        }
+
+      dw = (FAR uintptr_t *)dest;
+      while (npixels >= NXGL_WORDSIZE)
+        {
+          dw[0]    = pattern.w[0];
+          dw[1]    = pattern.w[1];
+          dw[2]    = pattern.w[2];
+          dw      += 3;
+          npixels -= NXGL_WORDSIZE;
+        }
+
+      dest = (FAR uint8_t *)dw;
+    }
+
+  while (npixels-- > 0)
+    {
+      *dest++ = value;
+      *dest++ = value >> 8;
+      *dest++ = value >> 16;
+    }
+}
+
+/****************************************************************************
+ * Name: nxgl_wmemset32
+ ****************************************************************************/
+
+void nxgl_wmemset32(FAR uint32_t *dest, uint32_t value, size_t npixels)
+{
+#if UINTPTR_MAX > 0xffff
+  size_t nwords;
+
+  /* A word holds at least one 32-bit pixel only if pointers are at least
+   * 32 bits wide.  Otherwise, the pixels are written one at a time.
+   */
+
+  if (npixels >= NXGL_WORDSIZE / 2 && ((uintptr_t)dest & 3) == 0)
+    {
+      while (!NXGL_ALIGNED(dest))
+        {
+          *dest++ = value;
+          npixels--;
+        }
+
+      nwords = npixels / (NXGL_WORDSIZE / 4);
+      nxgl_fillwords((FAR uintptr_t *)dest, NXGL_REPLICATE32(value), nwords);
+
+      dest    += nwords * (NXGL_WORDSIZE / 4);
+      npixels -= nwords * (NXGL_WORDSIZE / 4);
+    }
+#endif
+
+  while (npixels-- > 0)
+    {
+      *dest++ = value;
+    }
+}
+
+/****************************************************************************
+ * Name: nxgl_wmemmove
+ ****************************************************************************/
+
+void nxgl_wmemmove(FAR void *dest, FAR const void *src, size_t nbytes)
+{
+  uintptr_t offset = (uintptr_t)dest - (uintptr_t)src;
+
+  if (nbytes == 0 || offset == 0)
+    {
+      return;
+    }
+
+  /* If the destination does not start inside of the source, then a
+   * forward copy never overwrites source bytes before they are read.
+   */
+
+  if (offset >= nbytes)
+    {
+#ifdef CONFIG_LIBC_ARCH_MEMCPY
+      /* Use the architecture-specific memcpy() if the runs are disjoint */
+
+      if ((uintptr_t)src - (uintptr_t)dest >= nbytes)
+        {
+          memcpy(dest, src, nbytes);
+          return;
+        }
+#endif
+
+      nxgl_copyforward((FAR uint8_t *)dest, (FAR const uint8_t *)src,
+                       nbytes);
+    }
+  else
+    {
+#ifdef CONFIG_LIBC_ARCH_MEMMOVE
+      memmove(dest, src, nbytes);
+#else
+      nxgl_copybackward((FAR uint8_t *)dest, (FAR const uint8_t *)src,
+                        nbytes);
+#endif
+    }
+}
@@ -0,0 +1,95 @@
+/****************************************************************************
+ * graphics/nxglib/nxglib_wide.h
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+#ifndef __GRAPHICS_NXGLIB_NXGLIB_WIDE_H
+#define __GRAPHICS_NXGLIB_NXGLIB_WIDE_H
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <sys/types.h>
+#include <stdint.h>
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+#undef EXTERN
+#if defined(__cplusplus)
+#define EXTERN extern "C"
+extern "C" {
+#else
+#define EXTERN extern
+#endif
+
+/****************************************************************************
+ * Name: nxgl_wmemset8, nxgl_wmemset16, nxgl_wmemset24, and nxgl_wmemset32
+ *
+ * Description:
+ *   Fill a run of 8-, 16-, 24- (packed) or 32-bit pixels with a color.
+ *   After any leading pixels up to the first word boundary, the color is
+ *   replicated across a machine word and the run is written a word at a
+ *   time.  nxgl_wmemset8 takes a count of bytes and also serves the packed
+ *   1-, 2- and 4-bit formats; the others take a count of pixels.
+ *
+ ****************************************************************************/
+
+void nxgl_wmemset8(FAR uint8_t *dest, uint8_t value, size_t nbytes);
+void nxgl_wmemset16(FAR uint16_t *dest, uint16_t value, size_t npixels);
+void nxgl_wmemset24(FAR uint8_t *dest, uint32_t value, size_t npixels);
+void nxgl_wmemset32(FAR uint32_t *dest, uint32_t value, size_t npixels);
+
+/****************************************************************************
+ * Name: nxgl_wmemmove
+ *
+ * Description:
+ *   Copy a run of bytes a word at a time.  The source and destination may
+ *   overlap, as they do when a region is moved within the same rows of a
+ *   framebuffer.
+ *
+ ****************************************************************************/
+
+void nxgl_wmemmove(FAR void *dest, FAR const void *src, size_t nbytes);
+
+#undef EXTERN
+#if defined(__cplusplus)
+}
+#endif
+
+#endif /* __GRAPHICS_NXGLIB_NXGLIB_WIDE_H */
@@ -45,9 +45,11 @@
 #include <semaphore.h>
 #include <mqueue.h>
 #include <fcntl.h>
+#include <time.h>
 #include <errno.h>
 #include <debug.h>
 
+#include <nuttx/clock.h>
 #include <nuttx/nx/nx.h>
 #include "nxfe.h"
 
@@ -71,6 +73,117 @@
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: nxmu_damagetimeout
+ *
+ * Description:
+ *   Return the number of clock ticks left before the damage lists must be
+ *   flushed, or a negative value if there is no damage.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NX_UPDATE_DAMAGE
+static ssystime_t nxmu_damagetimeout(FAR struct nxbe_state_s *be)
+{
+  ssystime_t remaining = -1;
+  ssystime_t left;
+  int i;
+
+  for (i = 0; i < be->vinfo.nplanes; i++)
+    {
+      if (be->plane[i].damage.nrects > 0)
+        {
+          left = (ssystime_t)MSEC2TICK(CONFIG_NX_UPDATE_DAMAGE_MSEC) -
+                 (ssystime_t)(clock_systimer() - be->plane[i].damage.start);
+          if (left < 0)
+            {
+              left = 0;
+            }
+
+          if (remaining < 0 || left < remaining)
+            {
+              remaining = left;
+            }
+        }
+    }
+
+  return remaining;
+}
+#endif
+
+/****************************************************************************
+ * Name: nxmu_damageflush
+ *
+ * Description:
+ *   Flush the damage lists of every plane.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NX_UPDATE_DAMAGE
+static void nxmu_damageflush(FAR struct nxbe_state_s *be)
+{
+  int i;
+
+  for (i = 0; i < be->vinfo.nplanes; i++)
+    {
+      nxbe_damage_flush(&be->plane[i]);
+    }
+}
+#endif
+
+/****************************************************************************
+ * Name: nxmu_receive
+ *
+ * Description:
+ *   Receive the next server message.  If there is damage, wait only until
+ *   the end of the frame interval, then flush the damage and wait again.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NX_UPDATE_DAMAGE
+static int nxmu_receive(FAR struct nxfe_state_s *fe, FAR char *buffer)
+{
+  struct timespec abstime;
+  ssystime_t remaining;
+  systime_t usec;
+  int nbytes;
+
+  for (; ; )
+    {
+      remaining = nxmu_damagetimeout(&fe->be);
+      if (remaining < 0)
+        {
+          return mq_receive(fe->conn.crdmq, buffer, NX_MXSVRMSGLEN, 0);
+        }
+
+      if (remaining > 0)
+        {
+          (void)clock_gettime(CLOCK_REALTIME, &abstime);
+
+          usec             = TICK2USEC(remaining);
+          abstime.tv_sec  += usec / USEC_PER_SEC;
+          abstime.tv_nsec += (usec % USEC_PER_SEC) * NSEC_PER_USEC;
+          if (abstime.tv_nsec >= NSEC_PER_SEC)
+            {
+              abstime.tv_sec++;
+              abstime.tv_nsec -= NSEC_PER_SEC;
+            }
+
+          nbytes = mq_timedreceive(fe->conn.crdmq, buffer, NX_MXSVRMSGLEN,
+                                   0, &abstime);
+          if (nbytes >= 0 || errno != ETIMEDOUT)
+            {
+              return nbytes;
+            }
+        }
+
+      /* The frame interval has expired */
+
+      nxmu_damageflush(&fe->be);
+    }
+}
+#endif
+
 /****************************************************************************
  * Name: nxmu_disconnect
  ****************************************************************************/
@@ -329,7 +442,11 @@ int nx_runinstance(FAR const char *mqname, FAR NX_DRIVERTYPE *dev)
     {
        /* Receive the next server message */
 
+#ifdef CONFIG_NX_UPDATE_DAMAGE
+       nbytes = nxmu_receive(&fe, buffer);
+#else
        nbytes = mq_receive(fe.conn.crdmq, buffer, NX_MXSVRMSGLEN, 0);
+#endif
        if (nbytes < 0)
          {
            if (errno != EINTR)
@@ -484,6 +601,34 @@ int nx_runinstance(FAR const char *mqname, FAR NX_DRIVERTYPE *dev)
            }
            break;
 
+#ifdef CONFIG_NX_BLEND
+         case NX_SVRMSG_BLENDBITMAP: /* Blend a rectangular bitmap over the window */
+           {
+             FAR struct nxsvrmsg_blendbitmap_s *bmpmsg = (FAR struct nxsvrmsg_blendbitmap_s *)buffer;
+             nxbe_blendbitmap(bmpmsg->wnd, &bmpmsg->dest, bmpmsg->src, &bmpmsg->origin,
+                              bmpmsg->stride, bmpmsg->alpha);
+
+             if (bmpmsg->sem_done)
+              {
+                sem_post(bmpmsg->sem_done);
+              }
+           }
+           break;
+
+         case NX_SVRMSG_FILLMASK: /* Draw a color through a coverage mask */
+           {
+             FAR struct nxsvrmsg_fillmask_s *maskmsg = (FAR struct nxsvrmsg_fillmask_s *)buffer;
+             nxbe_fillmask(maskmsg->wnd, &maskmsg->dest, maskmsg->mask, &maskmsg->origin,
+                           maskmsg->stride, maskmsg->color);
+
+             if (maskmsg->sem_done)
+              {
+                sem_post(maskmsg->sem_done);
+              }
+           }
+           break;
+#endif
+
          case NX_SVRMSG_SETBGCOLOR: /* Set the color of the background */
            {
              FAR struct nxsvrmsg_setbgcolor_s *bgcolormsg =
@@ -548,6 +693,17 @@ int nx_runinstance(FAR const char *mqname, FAR NX_DRIVERTYPE *dev)
            gerr("ERROR: Unrecognized command: %d\n", msg->msgid);
            break;
          }
+
+#ifdef CONFIG_NX_UPDATE_DAMAGE
+       /* Flush the damage if the frame interval has expired while the
+        * message was processed.
+        */
+
+       if (nxmu_damagetimeout(&fe.be) == 0)
+         {
+           nxmu_damageflush(&fe.be);
+         }
+#endif
     }
 
 errout:
@@ -0,0 +1,96 @@
+/****************************************************************************
+ * graphics/nxsu/nx_fillmask.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <errno.h>
+#include <debug.h>
+
+#include <nuttx/nx/nx.h>
+
+#include "nxbe.h"
+#include "nxfe.h"
+
+#ifdef CONFIG_NX_BLEND
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: nx_fillmask
+ *
+ * Description:
+ *   Draw a color into the specified window through a rectangular region of
+ *   a larger 8-bit coverage mask.
+ *
+ * Input Parameters:
+ *   hwnd   - The window that will receive the color
+ *   dest   - Describes the rectangular region on the display that will be
+ *            drawn.
+ *   mask   - The start of the mask, one byte per pixel.
+ *   origin - The origin of the upper, left-most corner of the full mask.
+ *            Both dest and origin are in window coordinates, however, origin
+ *            may lie outside of the display.
+ *   stride - The width of the full mask in bytes.
+ *   color  - The color to draw
+ *
+ * Return:
+ *   OK on success; ERROR on failure with errno set appropriately
+ *
+ ****************************************************************************/
+
+int nx_fillmask(NXWINDOW hwnd, FAR const struct nxgl_rect_s *dest,
+                FAR const uint8_t *mask, FAR const struct nxgl_point_s *origin,
+                unsigned int stride, nxgl_mxpixel_t color[CONFIG_NX_NPLANES])
+{
+#ifdef CONFIG_DEBUG_FEATURES
+  if (!hwnd || !dest || !mask || !origin || !color)
+    {
+      errno = EINVAL;
+      return ERROR;
+    }
+#endif
+
+  nxbe_fillmask((FAR struct nxbe_window_s *)hwnd, dest, mask, origin,
+                stride, color);
+  return OK;
+}
+
+#endif /* CONFIG_NX_BLEND */
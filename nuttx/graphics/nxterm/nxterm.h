@@ -141,6 +141,12 @@ struct nxterm_state_s
 
   struct nxgl_point_s fpos;                 /* Next display position */
 
+#ifdef CONFIG_NXTERM_TEXTRUNS
+  uint16_t ndrawn;                          /* Number of chars in bm[] drawn */
+  unsigned int runstride;                   /* Width of runbuf[] in bytes */
+  FAR uint8_t *runbuf;                      /* Composes one line of text */
+#endif
+
   /* VT100 escape sequence processing */
 
   char seq[VT100_MAX_SEQUENCE];             /* Buffered characters */
@@ -222,6 +228,13 @@ int nxterm_hidechar(FAR struct nxterm_state_s *priv,
 int nxterm_backspace(FAR struct nxterm_state_s *priv);
 void nxterm_fillchar(FAR struct nxterm_state_s *priv,
     FAR const struct nxgl_rect_s *rect, FAR const struct nxterm_bitmap_s *bm);
+void nxterm_fillchars(FAR struct nxterm_state_s *priv,
+    FAR const struct nxgl_rect_s *rect, int first, int last);
+#ifdef CONFIG_NXTERM_TEXTRUNS
+void nxterm_flush(FAR struct nxterm_state_s *priv);
+#else
+#  define nxterm_flush(p)
+#endif
 
 void nxterm_putc(FAR struct nxterm_state_s *priv, uint8_t ch);
 void nxterm_showcursor(FAR struct nxterm_state_s *priv);
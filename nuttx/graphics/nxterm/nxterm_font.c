@@ -82,6 +82,57 @@ static int nxterm_fontsize(FAR struct nxterm_state_s *priv, uint8_t ch,
   return -ENOENT;
 }
 
+/****************************************************************************
+ * Name: nxterm_drawrun
+ *
+ * Description:
+ *   Draw the first 'width' columns of the line buffer at 'origin', clipped
+ *   to 'rect' (if provided).
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXTERM_TEXTRUNS
+static void nxterm_drawrun(FAR struct nxterm_state_s *priv,
+                           FAR const struct nxgl_rect_s *rect,
+                           FAR const struct nxgl_point_s *origin,
+                           nxgl_coord_t width)
+{
+  struct nxgl_rect_s bounds;
+  struct nxgl_rect_s intersection;
+  FAR const void *src;
+  int ret;
+
+  /* Construct a bounding box for the run */
+
+  bounds.pt1.x = origin->x;
+  bounds.pt1.y = origin->y;
+  bounds.pt2.x = origin->x + width - 1;
+  bounds.pt2.y = origin->y + priv->fheight - 1;
+
+  /* Clip it to the redraw region, if any */
+
+  if (rect)
+    {
+      nxgl_rectintersect(&intersection, rect, &bounds);
+    }
+  else
+    {
+      nxgl_rectcopy(&intersection, &bounds);
+    }
+
+  /* Blit the whole run into the window */
+
+  if (!nxgl_nullrect(&intersection))
+    {
+      src = (FAR const void *)priv->runbuf;
+      ret = priv->ops->bitmap(priv, &intersection, &src, origin,
+                              priv->runstride);
+      DEBUGASSERT(ret >= 0);
+      UNUSED(ret);
+    }
+}
+#endif
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -198,6 +249,10 @@ int nxterm_backspace(FAR struct nxterm_state_s *priv)
   int ndx;
   int ret = -ENOENT;
 
+  /* Make sure that the character to be erased has been drawn */
+
+  nxterm_flush(priv);
+
   /* Is there a character on the display? */
 
   if (priv->nchars > 0)
@@ -348,3 +403,110 @@ void nxterm_fillchar(FAR struct nxterm_state_s *priv,
       DEBUGASSERT(ret >= 0);
     }
 }
+
+/****************************************************************************
+ * Name: nxterm_fillchars
+ *
+ * Description:
+ *   Draw the characters bm[first] through bm[last - 1], clipped to 'rect'
+ *   (if provided).  If CONFIG_NXTERM_TEXTRUNS is selected, each run of
+ *   adjacent characters on a line is composed in the line buffer and drawn
+ *   with one bitmap operation; otherwise each character is drawn alone.
+ *
+ ****************************************************************************/
+
+void nxterm_fillchars(FAR struct nxterm_state_s *priv,
+                      FAR const struct nxgl_rect_s *rect, int first, int last)
+{
+#ifdef CONFIG_NXTERM_TEXTRUNS
+  FAR const struct nxterm_bitmap_s *bm;
+  struct nxgl_point_s origin;
+  nxgl_coord_t width = 0;
+  nxf_code_t code;
+  int nrun = 0;
+  int ret;
+  int i;
+
+  for (i = first; i < last; i++)
+    {
+      bm = &priv->bm[i];
+
+      /* Does this character continue the current run?  If not, draw the
+       * run and start a new one.
+       */
+
+      if (nrun > 0 &&
+          (bm->pos.y != origin.y || bm->pos.x != origin.x + width))
+        {
+          nxterm_drawrun(priv, rect, &origin, width);
+          nrun = 0;
+        }
+
+      if (nrun == 0)
+        {
+          origin.x = bm->pos.x;
+          origin.y = bm->pos.y;
+          width    = 0;
+        }
+
+      /* Add the character to the line buffer */
+
+      code = bm->code;
+      ret  = nxf_cache_renderrun(priv->fcache, priv->runbuf, priv->fheight,
+                                 priv->runstride, width, &code, 1,
+                                 priv->spwidth);
+      if (ret < 0)
+        {
+          /* It does not fit in the line buffer.  This should not happen;
+           * just draw it by itself.
+           */
+
+          if (nrun > 0)
+            {
+              nxterm_drawrun(priv, rect, &origin, width);
+              nrun = 0;
+            }
+
+          nxterm_fillchar(priv, rect, bm);
+        }
+      else
+        {
+          width = ret;
+          nrun++;
+        }
+    }
+
+  if (nrun > 0)
+    {
+      nxterm_drawrun(priv, rect, &origin, width);
+    }
+#else
+  int i;
+
+  for (i = first; i < last; i++)
+    {
+      nxterm_fillchar(priv, rect, &priv->bm[i]);
+    }
+#endif
+}
+
+/****************************************************************************
+ * Name: nxterm_flush
+ *
+ * Description:
+ *   Draw any characters that have been added to the display with
+ *   nxterm_addchar() but not yet drawn.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NXTERM_TEXTRUNS
+void nxterm_flush(FAR struct nxterm_state_s *priv)
+{
+  if (priv->ndrawn < priv->nchars)
+    {
+      nxterm_fillchars(priv, NULL, priv->ndrawn, priv->nchars);
+    }
+
+  priv->ndrawn = priv->nchars;
+}
+#endif
@@ -119,14 +119,19 @@ void nxterm_putc(FAR struct nxterm_state_s *priv, uint8_t ch)
     }
 
   /* Find the glyph associated with the character and render it onto the
-   * display.
+   * display.  When text is rendered in runs, the character is drawn later
+   * by nxterm_flush() along with the rest of its line.
    */
 
   bm = nxterm_addchar(priv, ch);
+#ifndef CONFIG_NXTERM_TEXTRUNS
   if (bm)
     {
       nxterm_fillchar(priv, NULL, bm);
     }
+#else
+  UNUSED(bm);
+#endif
 }
 
 /****************************************************************************
@@ -138,6 +138,19 @@ FAR struct nxterm_state_s *
 
   priv->maxchars  = CONFIG_NXTERM_MXCHARS;
 
+#ifdef CONFIG_NXTERM_TEXTRUNS
+  /* Allocate the buffer used to compose one line of text */
+
+  priv->runstride = (wndo->wsize.w * CONFIG_NXTERM_BPP + 7) >> 3;
+  priv->runbuf    = (FAR uint8_t *)kmm_malloc(priv->runstride * priv->fheight);
+  if (priv->runbuf == NULL)
+    {
+      gerr("ERROR: Failed to allocate the line buffer\n");
+      nxf_cache_disconnect(priv->fcache);
+      goto errout;
+    }
+#endif
+
   /* Set the initial display position */
 
   nxterm_home(priv);
@@ -72,7 +72,11 @@
 static inline void nxterm_movedisplay(FAR struct nxterm_state_s *priv,
                                      int bottom, int scrollheight)
 {
+#ifdef CONFIG_NXTERM_TEXTRUNS
+  int last;
+#else
   FAR struct nxterm_bitmap_s *bm;
+#endif
   struct nxgl_rect_s rect;
   nxgl_coord_t row;
   int ret;
@@ -104,6 +108,21 @@ static inline void nxterm_movedisplay(FAR struct nxterm_state_s *priv,
 
       /* Fill each character that might lie within in the bounding box */
 
+#ifdef CONFIG_NXTERM_TEXTRUNS
+      /* Characters are kept in display order, so those in the bounding box
+       * are contiguous in bm[].
+       */
+
+      for (i = 0;
+           i < priv->nchars && priv->bm[i].pos.y + priv->fheight < rect.pt1.y;
+           i++);
+
+      for (last = i;
+           last < priv->nchars && priv->bm[last].pos.y <= rect.pt2.y;
+           last++);
+
+      nxterm_fillchars(priv, &rect, i, last);
+#else
       for (i = 0; i < priv->nchars; i++)
         {
           bm = &priv->bm[i];
@@ -112,6 +131,7 @@ static inline void nxterm_movedisplay(FAR struct nxterm_state_s *priv,
               nxterm_fillchar(priv, &rect, bm);
             }
         }
+#endif
     }
 
   /* Finally, clear the vacated part of the display */
@@ -186,9 +206,17 @@ void nxterm_scroll(FAR struct nxterm_state_s *priv, int scrollheight)
   int i;
   int j;
 
-  /* Adjust the vertical position of each character */
+  /* Draw any pending characters before the display is moved */
+
+  nxterm_flush(priv);
+
+  /* Adjust the vertical position of each character, discarding those that
+   * have scrolled off the display.  The characters that are kept are
+   * packed down to the beginning of bm[] in one pass ('j' is the index
+   * where the next kept character goes).
+   */
 
-  for (i = 0; i < priv->nchars; )
+  for (i = 0, j = 0; i < priv->nchars; i++)
     {
       FAR struct nxterm_bitmap_s *bm = &priv->bm[i];
 
@@ -196,35 +224,30 @@ void nxterm_scroll(FAR struct nxterm_state_s *priv, int scrollheight)
 
       if (bm->pos.y < scrollheight + CONFIG_NXTERM_LINESEPARATION)
         {
-          /* Yes... Delete the character by moving all of the data */
+          /* Yes... Delete the character by not keeping it */
 
-          for (j = i; j < priv->nchars-1; j++)
-            {
-              memcpy(&priv->bm[j], &priv->bm[j+1],
-                     sizeof(struct nxterm_bitmap_s));
-            }
-
-          /* Decrement the number of cached characters ('i' is not incremented
-           * in this case because it already points to the next character)
-           */
-
-          priv->nchars--;
+          continue;
         }
 
       /* No.. just decrement its vertical position (moving it "up" the
-       * display by one line).
+       * display by one line) and keep it.
        */
 
-      else
+      bm->pos.y -= scrollheight;
+      if (j != i)
         {
-          bm->pos.y -= scrollheight;
-
-          /* We are keeping this one so increment to the next character */
-
-          i++;
+          memcpy(&priv->bm[j], bm, sizeof(struct nxterm_bitmap_s));
         }
+
+      j++;
     }
 
+  priv->nchars = j;
+
+#ifdef CONFIG_NXTERM_TEXTRUNS
+  priv->ndrawn = priv->nchars;
+#endif
+
   /* And move the next display position up by one line as well */
 
   priv->fpos.y -= scrollheight;
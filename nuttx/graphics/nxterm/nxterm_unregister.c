@@ -87,6 +87,9 @@ void nxterm_unregister(NXTERM handle)
   /* Free the font cache */
 
   nxf_cache_disconnect(priv->fcache);
+#ifdef CONFIG_NXTERM_TEXTRUNS
+  kmm_free(priv->runbuf);
+#endif
 
   /* Unregister the driver */
 
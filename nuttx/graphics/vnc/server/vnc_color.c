@@ -45,6 +45,48 @@
 
 #include "vnc_server.h"
 
+/****************************************************************************
+ * Private Function Prototypes
+ ****************************************************************************/
+
+static uint32_t vnc_widen_rgb8_222(lfb_color_t rgb);
+static uint32_t vnc_widen_rgb8_332(lfb_color_t rgb);
+static uint32_t vnc_widen_rgb16_555(lfb_color_t rgb);
+static uint32_t vnc_widen_rgb16_565(lfb_color_t rgb);
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: vnc_widen_rgbNN
+ *
+ * Description:
+ *  Wrap the 8- and 16-bit color conversions so that all remote color
+ *  formats can be handled through a vnc_convert32_t.
+ *
+ ****************************************************************************/
+
+static uint32_t vnc_widen_rgb8_222(lfb_color_t rgb)
+{
+  return vnc_convert_rgb8_222(rgb);
+}
+
+static uint32_t vnc_widen_rgb8_332(lfb_color_t rgb)
+{
+  return vnc_convert_rgb8_332(rgb);
+}
+
+static uint32_t vnc_widen_rgb16_555(lfb_color_t rgb)
+{
+  return vnc_convert_rgb16_555(rgb);
+}
+
+static uint32_t vnc_widen_rgb16_565(lfb_color_t rgb)
+{
+  return vnc_convert_rgb16_565(rgb);
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
@@ -155,7 +197,7 @@ uint8_t vnc_convert_rgb8_332(lfb_color_t rgb)
    *          RRRGGGBB
    */
 
-  return (uint8_t)(((rgb >> 8) & 0x0070)  |
+  return (uint8_t)(((rgb >> 8) & 0x00e0)  |
                    ((rgb >> 6) & 0x001c)  |
                    ((rgb >> 3) & 0x0003));
 }
@@ -189,7 +231,7 @@ uint32_t vnc_convert_rgb32_888(lfb_color_t rgb)
    */
 
   return (((uint32_t)rgb << 8) & 0x00f80000) |
-         (((uint32_t)rgb << 6) & 0x0000fc00) |
+         (((uint32_t)rgb << 5) & 0x0000fc00) |
          (((uint32_t)rgb << 3) & 0x000000f8);
 }
 
@@ -206,7 +248,7 @@ uint8_t vnc_convert_rgb8_222(lfb_color_t rgb)
 
   return (uint8_t)(((rgb >> 18) & 0x00000030)  |
                    ((rgb >> 12) & 0x0000000c)  |
-                    (rgb >> 6)  & 0x00000003));
+                   ((rgb >> 6)  & 0x00000003));
 }
 
 uint8_t vnc_convert_rgb8_332(lfb_color_t rgb)
@@ -218,9 +260,9 @@ uint8_t vnc_convert_rgb8_332(lfb_color_t rgb)
    *                            RRRGGGBB
    */
 
-  return (uint8_t)(((rgb >> 16) & 0x00000070)  |
+  return (uint8_t)(((rgb >> 16) & 0x000000e0)  |
                    ((rgb >> 11) & 0x0000001c)  |
-                    (rgb >> 6)  & 0x00000003));
+                   ((rgb >> 6)  & 0x00000003));
 }
 
 uint16_t vnc_convert_rgb16_555(lfb_color_t rgb)
@@ -261,6 +303,87 @@ uint32_t vnc_convert_rgb32_888(lfb_color_t rgb)
 #  error Unspecified/unsupported color format
 #endif
 
+/****************************************************************************
+ * Name: vnc_converter
+ *
+ * Description:
+ *  Select the function that converts the native framebuffer color format
+ *  to the remote framebuffer color format, returning the remote pixel in a
+ *  32-bit value regardless of the remote pixel size.
+ *
+ * Input Parameters:
+ *   colorfmt - The remote framebuffer color format
+ *
+ * Returned Value:
+ *   The conversion function; NULL if the color format is not supported.
+ *
+ ****************************************************************************/
+
+vnc_convert32_t vnc_converter(uint8_t colorfmt)
+{
+  switch (colorfmt)
+    {
+      case FB_FMT_RGB8_222:
+        return vnc_widen_rgb8_222;
+
+      case FB_FMT_RGB8_332:
+        return vnc_widen_rgb8_332;
+
+      case FB_FMT_RGB16_555:
+        return vnc_widen_rgb16_555;
+
+      case FB_FMT_RGB16_565:
+        return vnc_widen_rgb16_565;
+
+      case FB_FMT_RGB32:
+        return vnc_convert_rgb32_888;
+
+      default:
+        return NULL;
+    }
+}
+
+/****************************************************************************
+ * Name: vnc_putpixel
+ *
+ * Description:
+ *  Store the least significant 'nbytes' bytes of a remote pixel value in
+ *  the remote byte order.
+ *
+ * Input Parameters:
+ *   dest      - The location to store the pixel
+ *   pixel     - The pixel in the remote framebuffer color format
+ *   nbytes    - The number of bytes to store (1-4)
+ *   bigendian - True: Store in big-endian byte order
+ *
+ * Returned Value:
+ *   The location following the stored pixel.
+ *
+ ****************************************************************************/
+
+FAR uint8_t *vnc_putpixel(FAR uint8_t *dest, uint32_t pixel,
+                          unsigned int nbytes, bool bigendian)
+{
+  if (bigendian)
+    {
+      while (nbytes > 0)
+        {
+          nbytes--;
+          *dest++ = (uint8_t)(pixel >> (nbytes << 3));
+        }
+    }
+  else
+    {
+      for (; nbytes > 0; nbytes--)
+        {
+          *dest++ = (uint8_t)pixel;
+          pixel >>= 8;
+        }
+    }
+
+  return dest;
+}
+
 /****************************************************************************
  * Name: vnc_colors
  *
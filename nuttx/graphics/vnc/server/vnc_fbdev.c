@@ -890,3 +890,46 @@ void nx_notify_rectangle(FAR NX_PLANEINFOTYPE *pinfo,
     }
 }
 #endif
+
+/****************************************************************************
+ * Name: nx_notify_move
+ *
+ * Description:
+ *   When CONFIG_NX_UPDATE_MOVE=y, then a region moved within the display
+ *   is reported with this callout instead of with nx_notify_rectangle().
+ *   The move is queued so that it can be sent to a VNC client that
+ *   supports the CopyRect encoding.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NX_UPDATE_MOVE
+void nx_notify_move(FAR NX_PLANEINFOTYPE *pinfo,
+                    FAR const struct nxgl_rect_s *rect,
+                    FAR const struct nxgl_point_s *offset)
+{
+  FAR struct vnc_session_s *session;
+  int ret;
+
+  DEBUGASSERT(pinfo != NULL && rect != NULL && offset != NULL);
+
+  /* Recover the session informatin from the display number in the planeinfo
+   * structure.
+   */
+
+  DEBUGASSERT(pinfo->display >= 0 && pinfo->display < RFB_MAX_DISPLAYS);
+  session = g_vnc_sessions[pinfo->display];
+
+  /* Verify that the session is still valid */
+
+  if (session != NULL && session->state == VNCSERVER_RUNNING)
+    {
+      /* Queue the move */
+
+      ret = vnc_move_rectangle(session, rect, offset);
+      if (ret < 0)
+        {
+          gerr("ERROR: vnc_move_rectangle failed: %d\n", ret);
+        }
+    }
+}
+#endif
@@ -0,0 +1,636 @@
+/****************************************************************************
+ * graphics/vnc/server/vnc_hextile.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <assert.h>
+#include <errno.h>
+
+#if defined(CONFIG_VNCSERVER_DEBUG) && !defined(CONFIG_DEBUG_GRAPHICS)
+#  undef  CONFIG_DEBUG_FEATURES
+#  undef  CONFIG_DEBUG_ERROR
+#  undef  CONFIG_DEBUG_WARN
+#  undef  CONFIG_DEBUG_INFO
+#  define CONFIG_DEBUG_FEATURES 1
+#  define CONFIG_DEBUG_ERROR    1
+#  define CONFIG_DEBUG_WARN     1
+#  define CONFIG_DEBUG_INFO     1
+#  define CONFIG_DEBUG_GRAPHICS 1
+#endif
+#include <debug.h>
+
+#include "vnc_server.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* The largest encoded tile is a raw tile of 32-bit pixels.  Each tile is
+ * formatted directly in the update buffer.  The update buffer also has
+ * room for the FramebufferUpdate header, which more than covers the
+ * subencoding byte.
+ */
+
+#define HEXTILE_MAXTILE \
+  (1 + 4 * VNC_HEXTILE_SIZE * VNC_HEXTILE_SIZE)
+
+#if CONFIG_VNCSERVER_UPDATE_BUFSIZE < (HEXTILE_MAXTILE - 1)
+#  error CONFIG_VNCSERVER_UPDATE_BUFSIZE is too small for Hextile
+#endif
+
+/* Maximum number of sub-rectangles in a tile */
+
+#define HEXTILE_MAXSUBRECTS 255
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* The state of one Hextile encoded rectangle */
+
+struct hextile_stream_s
+{
+  FAR struct vnc_session_s *session;
+  vnc_convert32_t convert;     /* Local to remote color conversion */
+  size_t nbytes;               /* Number of bytes buffered in outbuf */
+  uint8_t bytesperpixel;       /* Remote bytes per pixel */
+  bool bigendian;              /* True: Remote pixels are big-endian */
+  bool bgvalid;                /* True: bg may be carried over */
+  bool fgvalid;                /* True: fg may be carried over */
+  lfb_color_t bg;              /* Background of the previous tile */
+  lfb_color_t fg;              /* Foreground of the previous tile */
+};
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: vnc_hextile_flush
+ *
+ * Description:
+ *  Send all of the data buffered in outbuf.
+ *
+ * Input Parameters:
+ *   stream - The state of the Hextile encoded rectangle
+ *
+ * Returned Value:
+ *   Zero (OK) on success; a negated errno value on a network failure.
+ *
+ ****************************************************************************/
+
+static int vnc_hextile_flush(FAR struct hextile_stream_s *stream)
+{
+  FAR struct vnc_session_s *session = stream->session;
+  FAR const uint8_t *src = session->outbuf;
+  size_t size = stream->nbytes;
+  ssize_t nsent;
+
+  /* Send until all of the bytes are out.  This may loop for the case where
+   * TCP write buffering is enabled and there are a limited number of IOBs
+   * available.
+   */
+
+  while (size > 0)
+    {
+      nsent = psock_send(&session->connect, src, size, 0);
+      if (nsent < 0)
+        {
+          int errcode = get_errno();
+          gerr("ERROR: Send Hextile FrameBufferUpdate failed: %d\n",
+               errcode);
+          DEBUGASSERT(errcode > 0);
+          return -errcode;
+        }
+
+      DEBUGASSERT(nsent <= size);
+      src  += nsent;
+      size -= nsent;
+    }
+
+  stream->nbytes = 0;
+  return OK;
+}
+
+/****************************************************************************
+ * Name: vnc_hextile_background
+ *
+ * Description:
+ *  Copy one tile from the local framebuffer into the tile buffer and pick
+ *  its background color.  The background is the majority color if there
+ *  is one (Boyer-Moore majority vote).
+ *
+ * Input Parameters:
+ *   stream        - The state of the Hextile encoded rectangle
+ *   x, y          - The position of the tile in the local framebuffer
+ *   width, height - The size of the tile
+ *   bg            - The location to return the background color
+ *
+ * Returned Value:
+ *   The number of colors in the tile:  1, 2 or 3 (meaning more than 2).
+ *
+ ****************************************************************************/
+
+static int vnc_hextile_background(FAR struct hextile_stream_s *stream,
+                                  nxgl_coord_t x, nxgl_coord_t y,
+                                  nxgl_coord_t width, nxgl_coord_t height,
+                                  FAR lfb_color_t *bg)
+{
+  FAR struct vnc_session_s *session = stream->session;
+  FAR lfb_color_t *tile = session->hextile.tile;
+  FAR const lfb_color_t *src;
+  lfb_color_t c0;
+  lfb_color_t c1;
+  lfb_color_t candidate;
+  unsigned int votes;
+  int ncolors;
+  int col;
+  int row;
+
+  src = (FAR const lfb_color_t *)
+    (session->fb + RFB_STRIDE * y + RFB_BYTESPERPIXEL * x);
+
+  c0        = *src;
+  c1        = c0;
+  ncolors   = 1;
+  candidate = c0;
+  votes     = 0;
+
+  for (row = 0; row < height; row++)
+    {
+      for (col = 0; col < width; col++)
+        {
+          lfb_color_t pixel = src[col];
+          *tile++ = pixel;
+
+          if (pixel != c0 && ncolors < 3)
+            {
+              if (ncolors == 1)
+                {
+                  c1      = pixel;
+                  ncolors = 2;
+                }
+              else if (pixel != c1)
+                {
+                  ncolors = 3;
+                }
+            }
+
+          if (votes == 0)
+            {
+              candidate = pixel;
+              votes     = 1;
+            }
+          else if (pixel == candidate)
+            {
+              votes++;
+            }
+          else
+            {
+              votes--;
+            }
+        }
+
+      src = (FAR const lfb_color_t *)((uintptr_t)src + RFB_STRIDE);
+    }
+
+  *bg = candidate;
+  return ncolors;
+}
+
+/****************************************************************************
+ * Name: vnc_hextile_subrects
+ *
+ * Description:
+ *  Cover the pixels of the tile buffer that differ from the background
+ *  with single color sub-rectangles.  Each sub-rectangle is grown either
+ *  right first or down first, whichever covers more pixels.
+ *
+ * Input Parameters:
+ *   stream        - The state of the Hextile encoded rectangle
+ *   width, height - The size of the tile
+ *   bg            - The background color of the tile
+ *   maxsubrects   - Give up after this many sub-rectangles
+ *
+ * Returned Value:
+ *   The number of sub-rectangles; a value larger than maxsubrects if the
+ *   tile is not worth encoding with sub-rectangles.
+ *
+ ****************************************************************************/
+
+static int vnc_hextile_subrects(FAR struct hextile_stream_s *stream,
+                                int width, int height, lfb_color_t bg,
+                                int maxsubrects)
+{
+  FAR struct vnc_hextile_s *hextile = &stream->session->hextile;
+  FAR lfb_color_t *tile = hextile->tile;
+  FAR lfb_color_t *line;
+  lfb_color_t color;
+  int nsubrects = 0;
+  int x;
+  int y;
+  int i;
+  int j;
+  int hx;
+  int hy;
+  int vx;
+  int vy;
+
+  for (y = 0; y < height; y++)
+    {
+      for (x = 0; x < width; x++)
+        {
+          color = tile[y * width + x];
+          if (color == bg)
+            {
+              continue;
+            }
+
+          if (nsubrects >= maxsubrects)
+            {
+              return maxsubrects + 1;
+            }
+
+          /* Grow right, then down as far as the whole row matches */
+
+          for (hx = x + 1; hx < width && tile[y * width + hx] == color; hx++);
+
+          for (hy = y + 1; hy < height; hy++)
+            {
+              line = &tile[hy * width];
+              for (i = x; i < hx && line[i] == color; i++);
+              if (i < hx)
+                {
+                  break;
+                }
+            }
+
+          /* Grow down, then right as far as the whole column matches */
+
+          for (vy = y + 1; vy < height && tile[vy * width + x] == color; vy++);
+
+          for (vx = x + 1; vx < width; vx++)
+            {
+              for (j = y; j < vy && tile[j * width + vx] == color; j++);
+              if (j < vy)
+                {
+                  break;
+                }
+            }
+
+          if ((vx - x) * (vy - y) > (hx - x) * (hy - y))
+            {
+              hx = vx;
+              hy = vy;
+            }
+
+          /* Record the sub-rectangle and remove it from the tile */
+
+          hextile->color[nsubrects] = color;
+          hextile->xy[nsubrects]    = (uint8_t)(x << 4 | y);
+          hextile->wh[nsubrects]    = (uint8_t)((hx - x - 1) << 4 |
+                                                (hy - y - 1));
+          nsubrects++;
+
+          for (j = y; j < hy; j++)
+            {
+              line = &tile[j * width];
+              for (i = x; i < hx; i++)
+                {
+                  line[i] = bg;
+                }
+            }
+        }
+    }
+
+  return nsubrects;
+}
+
+/****************************************************************************
+ * Name: vnc_hextile_tile
+ *
+ * Description:
+ *  Encode one tile into outbuf.
+ *
+ * Input Parameters:
+ *   stream        - The state of the Hextile encoded rectangle
+ *   x, y          - The position of the tile in the local framebuffer
+ *   width, height - The size of the tile
+ *
+ * Returned Value:
+ *   Zero (OK) on success; a negated errno value on a network failure.
+ *
+ ****************************************************************************/
+
+static int vnc_hextile_tile(FAR struct hextile_stream_s *stream,
+                            nxgl_coord_t x, nxgl_coord_t y,
+                            nxgl_coord_t width, nxgl_coord_t height)
+{
+  FAR struct vnc_session_s *session = stream->session;
+  FAR struct vnc_hextile_s *hextile = &session->hextile;
+  FAR const lfb_color_t *src;
+  FAR uint8_t *dest;
+  FAR uint8_t *flags;
+  unsigned int bpp = stream->bytesperpixel;
+  unsigned int rawsize;
+  unsigned int size;
+  lfb_color_t bg;
+  lfb_color_t fg;
+  bool setbg;
+  bool setfg;
+  bool mono;
+  bool raw;
+  int nsubrects;
+  int ncolors;
+  int maxsubrects;
+  int ret;
+  int col;
+  int row;
+  int i;
+
+  /* Pick the background and see how many colors there are */
+
+  rawsize   = 1 + width * height * bpp;
+  ncolors   = vnc_hextile_background(stream, x, y, width, height, &bg);
+  setbg     = !stream->bgvalid || bg != stream->bg;
+  size      = 1 + (setbg ? bpp : 0);
+  nsubrects = 0;
+  mono      = false;
+  raw       = false;
+  fg        = bg;
+  setfg     = false;
+
+  if (ncolors > 1)
+    {
+      /* Sub-rectangles cost at least two bytes each.  Give up as soon as
+       * they cannot beat raw pixels.
+       */
+
+      size++;
+      maxsubrects = (int)(rawsize - size) / 2;
+      if (maxsubrects > HEXTILE_MAXSUBRECTS)
+        {
+          maxsubrects = HEXTILE_MAXSUBRECTS;
+        }
+
+      nsubrects = vnc_hextile_subrects(stream, width, height, bg,
+                                       maxsubrects);
+      if (nsubrects <= maxsubrects)
+        {
+          /* All sub-rectangles have the same color in a two color tile */
+
+          mono = (ncolors == 2);
+          if (mono)
+            {
+              fg     = hextile->color[0];
+              setfg  = !stream->fgvalid || fg != stream->fg;
+              size  += (setfg ? bpp : 0) + 2 * nsubrects;
+            }
+          else
+            {
+              size  += (bpp + 2) * nsubrects;
+            }
+        }
+
+      if (nsubrects > maxsubrects || size >= rawsize)
+        {
+          raw  = true;
+          size = rawsize;
+        }
+    }
+
+  /* Send what has been buffered if this tile does not fit in outbuf */
+
+  if (stream->nbytes + size > VNCSERVER_UPDATE_BUFSIZE)
+    {
+      ret = vnc_hextile_flush(stream);
+      if (ret < 0)
+        {
+          return ret;
+        }
+    }
+
+  dest  = &session->outbuf[stream->nbytes];
+  flags = dest++;
+
+  if (raw)
+    {
+      /* Send the tile as raw pixels */
+
+      *flags = RFB_SUBENCODING_RAW;
+
+      src = (FAR const lfb_color_t *)
+        (session->fb + RFB_STRIDE * y + RFB_BYTESPERPIXEL * x);
+
+      for (row = 0; row < height; row++)
+        {
+          for (col = 0; col < width; col++)
+            {
+              dest = vnc_putpixel(dest, stream->convert(src[col]), bpp,
+                                  stream->bigendian);
+            }
+
+          src = (FAR const lfb_color_t *)((uintptr_t)src + RFB_STRIDE);
+        }
+
+      /* Neither color may be carried over a raw tile */
+
+      stream->bgvalid = false;
+      stream->fgvalid = false;
+      stream->nbytes += rawsize;
+      return OK;
+    }
+
+  /* Background (and foreground) followed by the sub-rectangles */
+
+  *flags = 0;
+  if (setbg)
+    {
+      *flags |= RFB_SUBENCODING_BACK;
+      dest    = vnc_putpixel(dest, stream->convert(bg), bpp,
+                             stream->bigendian);
+    }
+
+  if (nsubrects > 0)
+    {
+      *flags |= RFB_SUBENCODING_ANY;
+
+      if (mono)
+        {
+          if (setfg)
+            {
+              *flags |= RFB_SUBENCODING_FORE;
+              dest    = vnc_putpixel(dest, stream->convert(fg), bpp,
+                                     stream->bigendian);
+            }
+
+          *dest++ = (uint8_t)nsubrects;
+          for (i = 0; i < nsubrects; i++)
+            {
+              *dest++ = hextile->xy[i];
+              *dest++ = hextile->wh[i];
+            }
+
+          stream->fg      = fg;
+          stream->fgvalid = true;
+        }
+      else
+        {
+          *flags |= RFB_SUBENCODING_COLORED;
+
+          *dest++ = (uint8_t)nsubrects;
+          for (i = 0; i < nsubrects; i++)
+            {
+              dest    = vnc_putpixel(dest, stream->convert(hextile->color[i]),
+                                     bpp, stream->bigendian);
+              *dest++ = hextile->xy[i];
+              *dest++ = hextile->wh[i];
+            }
+
+          /* The foreground may not be carried over a colored tile */
+
+          stream->fgvalid = false;
+        }
+    }
+
+  stream->bg      = bg;
+  stream->bgvalid = true;
+  stream->nbytes  = dest - session->outbuf;
+  DEBUGASSERT(stream->nbytes <= VNCSERVER_UPDATE_BUFSIZE);
+  return OK;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: vnc_hextile
+ *
+ * Description:
+ *  Send the framebuffer update using the Hextile encoding.
+ *
+ * Input Parameters:
+ *   session - An instance of the session structure.
+ *   rect    - Describes the rectangle in the local framebuffer.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; A negated errno value is returned on failure that
+ *   indicates the nature of the failure.  A failure is only returned
+ *   in cases of a network failure and unexpected internal failures.
+ *
+ ****************************************************************************/
+
+int vnc_hextile(FAR struct vnc_session_s *session,
+                FAR struct nxgl_rect_s *rect)
+{
+  FAR struct rfb_framebufferupdate_s *update;
+  struct hextile_stream_s stream;
+  nxgl_coord_t width;
+  nxgl_coord_t height;
+  nxgl_coord_t x;
+  nxgl_coord_t y;
+  int ret;
+
+  /* Use one color format for the whole rectangle, even if a SetPixelFormat
+   * is received asynchronously.
+   */
+
+  stream.session       = session;
+  stream.convert       = vnc_converter(session->colorfmt);
+  stream.bytesperpixel = (session->bpp + 7) >> 3;
+  stream.bigendian     = session->bigendian;
+  stream.bgvalid       = false;
+  stream.fgvalid       = false;
+  stream.bg            = 0;
+  stream.fg            = 0;
+
+  if (stream.convert == NULL)
+    {
+      gerr("ERROR: Unrecognized color format: %d\n", session->colorfmt);
+      return -EINVAL;
+    }
+
+  /* Format the FramebufferUpdate message with a single Hextile rectangle */
+
+  DEBUGASSERT(rect->pt1.x <= rect->pt2.x && rect->pt1.y <= rect->pt2.y);
+
+  update          = (FAR struct rfb_framebufferupdate_s *)session->outbuf;
+  update->msgtype = RFB_FBUPDATE_MSG;
+  update->padding = 0;
+  rfb_putbe16(update->nrect, 1);
+
+  rfb_putbe16(update->rect[0].xpos,   rect->pt1.x);
+  rfb_putbe16(update->rect[0].ypos,   rect->pt1.y);
+  rfb_putbe16(update->rect[0].width,  rect->pt2.x - rect->pt1.x + 1);
+  rfb_putbe16(update->rect[0].height, rect->pt2.y - rect->pt1.y + 1);
+  rfb_putbe32(update->rect[0].encoding, RFB_ENCODING_HEXTILE);
+
+  stream.nbytes = SIZEOF_RFB_FRAMEBUFFERUPDATE_S(SIZEOF_RFB_RECTANGE_S(0));
+
+  /* Then the tiles, left-to-right and top-to-bottom */
+
+  for (y = rect->pt1.y; y <= rect->pt2.y; y += VNC_HEXTILE_SIZE)
+    {
+      height = MIN(VNC_HEXTILE_SIZE, rect->pt2.y - y + 1);
+
+      for (x = rect->pt1.x; x <= rect->pt2.x; x += VNC_HEXTILE_SIZE)
+        {
+          width = MIN(VNC_HEXTILE_SIZE, rect->pt2.x - x + 1);
+
+          ret = vnc_hextile_tile(&stream, x, y, width, height);
+          if (ret < 0)
+            {
+              return ret;
+            }
+        }
+    }
+
+  ret = vnc_hextile_flush(&stream);
+  if (ret < 0)
+    {
+      return ret;
+    }
+
+  updinfo("Sent {(%d, %d),(%d, %d)}\n",
+          rect->pt1.x, rect->pt1.y, rect->pt2.x, rect->pt2.y);
+  return OK;
+}
@@ -241,7 +241,7 @@ int vnc_receiver(FAR struct vnc_session_s *session)
                */
 
               ret = vnc_read_remainder(session,
-                                       SIZEOF_RFB_SERVERINIT_S(0) - 1,
+                                       SIZEOF_RFB_SETENCODINGS_S(0) - 1,
                                        1);
               if (ret < 0)
                 {
@@ -257,7 +257,7 @@ int vnc_receiver(FAR struct vnc_session_s *session)
 
                   ret = vnc_read_remainder(session,
                                            nencodings * sizeof(uint32_t),
-                                           SIZEOF_RFB_SERVERINIT_S(0));
+                                           SIZEOF_RFB_SETENCODINGS_S(0));
                   if (ret < 0)
                     {
                       gerr("ERROR: Failed to read encodings: %d\n",
@@ -466,6 +466,7 @@ int vnc_client_encodings(FAR struct vnc_session_s *session,
                          FAR struct rfb_setencodings_s *encodings)
 {
   uint32_t encoding;
+  int16_t preferred;
   unsigned int nencodings;
   unsigned int i;
 
@@ -473,9 +474,16 @@ int vnc_client_encodings(FAR struct vnc_session_s *session,
 
   /* Assume that there are no common encodings (other than RAW) */
 
-  session->rre = false;
+  session->rre      = false;
+#ifdef CONFIG_VNCSERVER_COPYRECT
+  session->copyrect = false;
+#endif
+  preferred         = RFB_ENCODING_RAW;
 
-  /* Loop for each client supported encoding */
+  /* Loop for each client supported encoding.  The client lists the
+   * encodings in its order of preference, so the first of Hextile or ZRLE
+   * becomes the preferred encoding for all framebuffer updates.
+   */
 
   nencodings = rfb_getbe16(encodings->nencodings);
   for (i = 0; i < nencodings; i++)
@@ -484,14 +492,42 @@ int vnc_client_encodings(FAR struct vnc_session_s *session,
 
       encoding = rfb_getbe32(&encodings->encodings[i << 2]);
 
-      /* Only a limited support for of RRE is vailable now. */
-
-      if (encoding == RFB_ENCODING_RRE)
+      switch (encoding)
         {
-          session->rre = true;
+          /* Only a limited support for of RRE is vailable now. */
+
+          case RFB_ENCODING_RRE:
+            session->rre = true;
+            break;
+
+#ifdef CONFIG_VNCSERVER_COPYRECT
+          case RFB_ENCODING_COPYRECT:
+            session->copyrect = true;
+            break;
+#endif
+
+#ifdef CONFIG_VNCSERVER_HEXTILE
+          case RFB_ENCODING_HEXTILE:
+#endif
+#ifdef CONFIG_VNCSERVER_ZRLE
+          case RFB_ENCODING_ZRLE:
+#endif
+#if defined(CONFIG_VNCSERVER_HEXTILE) || defined(CONFIG_VNCSERVER_ZRLE)
+            if (preferred == RFB_ENCODING_RAW)
+              {
+                preferred = encoding;
+              }
+            break;
+#endif
+
+          default:
+            break;
         }
     }
 
+  ginfo("Preferred encoding: %d\n", (int)preferred);
+  session->encoding = preferred;
+
   session->change = true;
   return OK;
 }
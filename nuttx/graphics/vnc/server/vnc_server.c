@@ -134,11 +134,25 @@ static void vnc_reset_session(FAR struct vnc_session_s *session,
   sem_reset(&session->freesem, CONFIG_VNCSERVER_NUPDATES);
   sem_reset(&session->queuesem, 0);
 
-  session->fb      = fb;
-  session->display = display;
-  session->state   = VNCSERVER_INITIALIZED;
-  session->nwhupd  = 0;
-  session->change  = true;
+  session->fb       = fb;
+  session->display  = display;
+  session->state    = VNCSERVER_INITIALIZED;
+  session->nwhupd   = 0;
+  session->change   = true;
+
+  /* Only RAW encoding is used until the client sends SetEncodings.  Any
+   * ZRLE stream of a previous client is abandoned.
+   */
+
+  session->rre      = false;
+  session->encoding = RFB_ENCODING_RAW;
+#ifdef CONFIG_VNCSERVER_COPYRECT
+  session->copyrect = false;
+  session->sending  = NULL;
+#endif
+#ifdef CONFIG_VNCSERVER_ZRLE
+  session->zrle.started = false;
+#endif
 
   /* Careful not to disturb the keyboard/mouse callouts set by
    * vnc_fbinitialize().  Client related data left in garbage state.
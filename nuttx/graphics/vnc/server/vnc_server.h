@@ -160,6 +160,31 @@
 #define VNCSERVER_UPDATE_BUFSIZE \
   (CONFIG_VNCSERVER_UPDATE_BUFSIZE + SIZEOF_RFB_FRAMEBUFFERUPDATE_S(0))
 
+#ifdef CONFIG_VNCSERVER_COPYRECT
+#  ifndef CONFIG_NX_UPDATE_MOVE
+#    error CONFIG_NX_UPDATE_MOVE must be set to use CopyRect
+#  endif
+#endif
+
+/* Hextile and ZRLE tile sizes */
+
+#define VNC_HEXTILE_SIZE    16
+#define VNC_ZRLE_SIZE       64
+
+/* ZRLE buffers.  The uncompressed ZRLE data of one tile can be no larger
+ * than the raw tile:  One subencoding byte followed by up to four bytes
+ * per pixel.  The deflated data may add one zlib header, one stored block
+ * header and one final empty stored block.  Room is reserved in front of
+ * it for the FramebufferUpdate and rectangle headers and the ZRLE length.
+ */
+
+#define VNC_ZRLE_TILEBUFSIZE (1 + 4 * VNC_ZRLE_SIZE * VNC_ZRLE_SIZE)
+#define VNC_ZRLE_HDRSIZE     (SIZEOF_RFB_FRAMEBUFFERUPDATE_S(0) + \
+                              SIZEOF_RFB_RECTANGE_S(0) + 4)
+#define VNC_ZRLE_ZBUFSIZE    (VNC_ZRLE_HDRSIZE + VNC_ZRLE_TILEBUFSIZE + 16)
+#define VNC_ZRLE_HASHBITS    12
+#define VNC_ZRLE_HASHSIZE    (1 << VNC_ZRLE_HASHBITS)
+
 /* Local framebuffer characteristics in bytes */
 
 #define RFB_BYTESPERPIXEL   ((RFB_BITSPERPIXEL + 7) >> 3)
@@ -210,6 +235,18 @@
  * Public Types
  ****************************************************************************/
 
+/* The size of the color type in the local framebuffer */
+
+#if defined(CONFIG_VNCSERVER_COLORFMT_RGB8)
+typedef uint8_t lfb_color_t;
+#elif defined(CONFIG_VNCSERVER_COLORFMT_RGB16)
+typedef uint16_t lfb_color_t;
+#elif defined(CONFIG_VNCSERVER_COLORFMT_RGB32)
+typedef uint32_t lfb_color_t;
+#else
+#  error Unspecified/unsupported color format
+#endif
+
 /* This enumeration indicates the state of the VNC server */
 
 enum vnc_server_e
@@ -231,9 +268,37 @@ struct vnc_fbupdate_s
 {
   FAR struct vnc_fbupdate_s *flink;
   bool whupd;                  /* True: whole screen update */
+#ifdef CONFIG_VNCSERVER_COPYRECT
+  bool copy;                   /* True: CopyRect update from srcpos */
+  struct nxgl_point_s srcpos;  /* Source position of a CopyRect update */
+#endif
   struct nxgl_rect_s rect;     /* The enqueued update rectangle */
 };
 
+#ifdef CONFIG_VNCSERVER_HEXTILE
+/* Working storage for the Hextile encoder */
+
+struct vnc_hextile_s
+{
+  lfb_color_t tile[VNC_HEXTILE_SIZE * VNC_HEXTILE_SIZE];
+  lfb_color_t color[VNC_HEXTILE_SIZE * VNC_HEXTILE_SIZE];
+  uint8_t xy[VNC_HEXTILE_SIZE * VNC_HEXTILE_SIZE];
+  uint8_t wh[VNC_HEXTILE_SIZE * VNC_HEXTILE_SIZE];
+};
+#endif
+
+#ifdef CONFIG_VNCSERVER_ZRLE
+/* Working storage and stream state of the ZRLE encoder */
+
+struct vnc_zrle_s
+{
+  bool started;                /* True: The zlib header has been sent */
+  uint16_t hash[VNC_ZRLE_HASHSIZE];
+  uint8_t tile[VNC_ZRLE_TILEBUFSIZE];
+  uint8_t zbuf[VNC_ZRLE_ZBUFSIZE];
+};
+#endif
+
 struct vnc_session_s
 {
   /* Connection data */
@@ -250,7 +315,12 @@ struct vnc_session_s
   volatile uint8_t colorfmt;   /* Remote color format (See include/nuttx/fb.h) */
   volatile uint8_t bpp;        /* Remote bits per pixel */
   volatile bool bigendian;     /* True: Remote expect data in big-endian format */
+  volatile uint8_t depth;      /* Remote color depth */
   volatile bool rre;           /* True: Remote supports RRE encoding */
+#ifdef CONFIG_VNCSERVER_COPYRECT
+  volatile bool copyrect;      /* True: Remote supports CopyRect encoding */
+#endif
+  volatile int16_t encoding;   /* Preferred encoding (RFB_ENCODING_*) */
   FAR uint8_t *fb;             /* Allocated local frame buffer */
 
   /* VNC client input support */
@@ -270,11 +340,23 @@ struct vnc_session_s
   sq_queue_t updqueue;
   sem_t freesem;
   sem_t queuesem;
+#ifdef CONFIG_VNCSERVER_COPYRECT
+  FAR struct vnc_fbupdate_s *sending; /* Update being sent by the updater */
+#endif
 
   /* I/O buffers for misc network send/receive */
 
   uint8_t inbuf[CONFIG_VNCSERVER_INBUFFER_SIZE];
   uint8_t outbuf[VNCSERVER_UPDATE_BUFSIZE];
+
+  /* Encoder working storage */
+
+#ifdef CONFIG_VNCSERVER_HEXTILE
+  struct vnc_hextile_s hextile;
+#endif
+#ifdef CONFIG_VNCSERVER_ZRLE
+  struct vnc_zrle_s zrle;
+#endif
 };
 
 /* This structure is used to communicate start-up status between the server
@@ -288,18 +370,6 @@ struct fb_startup_s
   int16_t result;               /* OK: successfully initialized */
 };
 
-/* The size of the color type in the local framebuffer */
-
-#if defined(CONFIG_VNCSERVER_COLORFMT_RGB8)
-typedef uint8_t lfb_color_t;
-#elif defined(CONFIG_VNCSERVER_COLORFMT_RGB16)
-typedef uint16_t lfb_color_t;
-#elif defined(CONFIG_VNCSERVER_COLORFMT_RGB32)
-typedef uint32_t lfb_color_t;
-#else
-#  error Unspecified/unsupported color format
-#endif
-
 /* Color conversion function pointer types */
 
 typedef CODE uint8_t  (*vnc_convert8_t) (lfb_color_t rgb);
@@ -459,6 +529,31 @@ int vnc_update_rectangle(FAR struct vnc_session_s *session,
                          FAR const struct nxgl_rect_s *rect,
                          bool change);
 
+/****************************************************************************
+ * Name: vnc_move_rectangle
+ *
+ * Description:
+ *  Queue the update of a region that was moved within the display.  If the
+ *  client supports CopyRect, the move is sent as a CopyRect update;
+ *  otherwise the destination is queued as an ordinary update.
+ *
+ * Input Parameters:
+ *   session - An instance of the session structure.
+ *   rect    - The source rectangle of the move.
+ *   offset  - The new position of the upper left corner of the rectangle.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success; a negated errno value is returned on
+ *   any failure.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_VNCSERVER_COPYRECT
+int vnc_move_rectangle(FAR struct vnc_session_s *session,
+                       FAR const struct nxgl_rect_s *rect,
+                       FAR const struct nxgl_point_s *offset);
+#endif
+
 /****************************************************************************
  * Name: vnc_receiver
  *
@@ -518,6 +613,73 @@ int vnc_rre(FAR struct vnc_session_s *session, FAR struct nxgl_rect_s *rect);
 
 int vnc_raw(FAR struct vnc_session_s *session, FAR struct nxgl_rect_s *rect);
 
+/****************************************************************************
+ * Name: vnc_hextile
+ *
+ * Description:
+ *  Send the framebuffer update using the Hextile encoding.
+ *
+ * Input Parameters:
+ *   session - An instance of the session structure.
+ *   rect    - Describes the rectangle in the local framebuffer.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; A negated errno value is returned on failure that
+ *   indicates the nature of the failure.  A failure is only returned
+ *   in cases of a network failure and unexpected internal failures.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_VNCSERVER_HEXTILE
+int vnc_hextile(FAR struct vnc_session_s *session,
+                FAR struct nxgl_rect_s *rect);
+#endif
+
+/****************************************************************************
+ * Name: vnc_zrle
+ *
+ * Description:
+ *  Send the framebuffer update using the ZRLE encoding.
+ *
+ * Input Parameters:
+ *   session - An instance of the session structure.
+ *   rect    - Describes the rectangle in the local framebuffer.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; A negated errno value is returned on failure that
+ *   indicates the nature of the failure.  A failure is only returned
+ *   in cases of a network failure and unexpected internal failures.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_VNCSERVER_ZRLE
+int vnc_zrle(FAR struct vnc_session_s *session, FAR struct nxgl_rect_s *rect);
+#endif
+
+/****************************************************************************
+ * Name: vnc_copyrect
+ *
+ * Description:
+ *  Send a framebuffer update using the CopyRect encoding.
+ *
+ * Input Parameters:
+ *   session - An instance of the session structure.
+ *   rect    - The destination rectangle in the local framebuffer.
+ *   srcpos  - The upper left corner of the source rectangle.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; A negated errno value is returned on failure that
+ *   indicates the nature of the failure.  A failure is only returned
+ *   in cases of a network failure and unexpected internal failures.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_VNCSERVER_COPYRECT
+int vnc_copyrect(FAR struct vnc_session_s *session,
+                 FAR struct nxgl_rect_s *rect,
+                 FAR const struct nxgl_point_s *srcpos);
+#endif
+
 /****************************************************************************
  * Name: vnc_key_map
  *
@@ -563,6 +725,45 @@ uint16_t vnc_convert_rgb16_555(lfb_color_t rgb);
 uint16_t vnc_convert_rgb16_565(lfb_color_t rgb);
 uint32_t vnc_convert_rgb32_888(lfb_color_t rgb);
 
+/****************************************************************************
+ * Name: vnc_converter
+ *
+ * Description:
+ *  Select the function that converts the native framebuffer color format
+ *  to the remote framebuffer color format, returning the remote pixel in a
+ *  32-bit value regardless of the remote pixel size.
+ *
+ * Input Parameters:
+ *   colorfmt - The remote framebuffer color format
+ *
+ * Returned Value:
+ *   The conversion function; NULL if the color format is not supported.
+ *
+ ****************************************************************************/
+
+vnc_convert32_t vnc_converter(uint8_t colorfmt);
+
+/****************************************************************************
+ * Name: vnc_putpixel
+ *
+ * Description:
+ *  Store the least significant 'nbytes' bytes of a remote pixel value in
+ *  the remote byte order.
+ *
+ * Input Parameters:
+ *   dest      - The location to store the pixel
+ *   pixel     - The pixel in the remote framebuffer color format
+ *   nbytes    - The number of bytes to store (1-4)
+ *   bigendian - True: Store in big-endian byte order
+ *
+ * Returned Value:
+ *   The location following the stored pixel.
+ *
+ ****************************************************************************/
+
+FAR uint8_t *vnc_putpixel(FAR uint8_t *dest, uint32_t pixel,
+                          unsigned int nbytes, bool bigendian);
+
 /****************************************************************************
  * Name: vnc_colors
  *
@@ -71,6 +71,20 @@
 #undef VNCSERVER_SEM_DEBUG          /* Define to dump queue/semaphore state */
 #undef VNCSERVER_SEM_DEBUG_SILENT   /* Define to dump only suspicious conditions */
 
+/* Two update rectangles are merged if the bounding rectangle adds no more
+ * than this many pixels plus 25% to the area of the two rectangles.  This
+ * trades the cost of re-sending some unchanged pixels against the
+ * per-update message overhead.
+ */
+
+#define VNC_MERGE_SLACK     (VNC_HEXTILE_SIZE * VNC_HEXTILE_SIZE)
+
+/* The area of a rectangle in pixels */
+
+#define VNC_RECTAREA(r) \
+  ((uint32_t)((r)->pt2.x - (r)->pt1.x + 1) * \
+   (uint32_t)((r)->pt2.y - (r)->pt1.y + 1))
+
 /****************************************************************************
  * Private Data
  ****************************************************************************/
@@ -242,6 +256,13 @@ static void vnc_free_update(FAR struct vnc_session_s *session,
   sched_lock();
   vnc_sem_debug(session, "Before free", 1);
 
+#ifdef CONFIG_VNCSERVER_COPYRECT
+  if (session->sending == update)
+    {
+      session->sending = NULL;
+    }
+#endif
+
   /* Put the entry into the free list */
 
   sq_addlast((FAR sq_entry_t *)update, &session->updfree);
@@ -306,6 +327,14 @@ vnc_remove_queue(FAR struct vnc_session_s *session)
       updinfo("Whole screen update: nwhupd=%d\n", session->nwhupd);
     }
 
+#ifdef CONFIG_VNCSERVER_COPYRECT
+  /* Remember the update that is being sent.  A move may not be sent as a
+   * CopyRect while the source region might still be in transit.
+   */
+
+  session->sending = rect;
+#endif
+
   sched_unlock();
   return rect;
 }
@@ -351,6 +380,156 @@ static void vnc_add_queue(FAR struct vnc_session_s *session,
   sched_unlock();
 }
 
+/****************************************************************************
+ * Name: vnc_merge_update
+ *
+ * Description:
+ *   Try to merge a new update rectangle with one of the queued updates.
+ *   The rectangle is dropped if a queued update already contains it or it
+ *   is merged into a queued update if the bounding rectangle of the two
+ *   is not much larger than the two rectangles.
+ *
+ *   An update is never merged into an update queued ahead of a CopyRect.
+ *   That would send the new pixels before the copy, and the copy could
+ *   then read them from its source region.
+ *
+ * Input Parameters:
+ *   session - A reference to the VNC session structure.
+ *   rect    - The new update rectangle, clipped to the display.
+ *   force   - True: There are no free update structures.  Merge the
+ *             rectangle into the last mergeable update regardless of size.
+ *
+ * Returned Value:
+ *   True if the rectangle was merged or dropped; false if it must be
+ *   queued as a new update.
+ *
+ * Assumptions:
+ *   The scheduler is locked.
+ *
+ ****************************************************************************/
+
+static bool vnc_merge_update(FAR struct vnc_session_s *session,
+                             FAR const struct nxgl_rect_s *rect, bool force)
+{
+  FAR struct vnc_fbupdate_s *first;
+  FAR struct vnc_fbupdate_s *last;
+  FAR struct vnc_fbupdate_s *curr;
+  struct nxgl_rect_s merged;
+  uint32_t rectarea;
+  uint32_t currarea;
+
+  /* Find the first update following the last queued CopyRect */
+
+  first = (FAR struct vnc_fbupdate_s *)sq_peek(&session->updqueue);
+
+#ifdef CONFIG_VNCSERVER_COPYRECT
+  for (curr = first; curr != NULL; curr = curr->flink)
+    {
+      if (curr->copy)
+        {
+          first = curr->flink;
+        }
+    }
+#endif
+
+  rectarea = VNC_RECTAREA(rect);
+  last     = NULL;
+
+  for (curr = first; curr != NULL; curr = curr->flink)
+    {
+      /* Is the rectangle already covered by this update? */
+
+      if (rect->pt1.x >= curr->rect.pt1.x && rect->pt2.x <= curr->rect.pt2.x &&
+          rect->pt1.y >= curr->rect.pt1.y && rect->pt2.y <= curr->rect.pt2.y)
+        {
+          updinfo("Covered {(%d, %d),(%d, %d)}\n",
+                  rect->pt1.x, rect->pt1.y, rect->pt2.x, rect->pt2.y);
+          return true;
+        }
+
+      /* Would the bounding rectangle waste too much? */
+
+      nxgl_rectunion(&merged, &curr->rect, rect);
+      currarea = VNC_RECTAREA(&curr->rect);
+
+      if (VNC_RECTAREA(&merged) <= currarea + rectarea +
+                                   ((currarea + rectarea) >> 2) +
+                                   VNC_MERGE_SLACK)
+        {
+          updinfo("Merged {(%d, %d),(%d, %d)}\n",
+                  merged.pt1.x, merged.pt1.y, merged.pt2.x, merged.pt2.y);
+          nxgl_rectcopy(&curr->rect, &merged);
+          return true;
+        }
+
+      last = curr;
+    }
+
+  /* If we are out of update structures, then grow the last update rather
+   * than waiting for the updater to free one.
+   */
+
+  if (force && last != NULL)
+    {
+      nxgl_rectunion(&last->rect, &last->rect, rect);
+      updinfo("Forced merge {(%d, %d),(%d, %d)}\n",
+              last->rect.pt1.x, last->rect.pt1.y,
+              last->rect.pt2.x, last->rect.pt2.y);
+      return true;
+    }
+
+  return false;
+}
+
+/****************************************************************************
+ * Name: vnc_source_dirty
+ *
+ * Description:
+ *   Check if the source region of a move may differ on the client.  This
+ *   is the case if an update that overlaps the source region is queued or
+ *   is being sent:  The client would then receive the pixels of the
+ *   source region as they are after the move, not as they were before.
+ *   Queued CopyRect updates do not matter; the client performs those
+ *   before this one.
+ *
+ * Input Parameters:
+ *   session - A reference to the VNC session structure.
+ *   srcrect - The source rectangle of the move.
+ *
+ * Returned Value:
+ *   True if the move cannot be sent as a CopyRect.
+ *
+ * Assumptions:
+ *   The scheduler is locked.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_VNCSERVER_COPYRECT
+static bool vnc_source_dirty(FAR struct vnc_session_s *session,
+                             FAR struct nxgl_rect_s *srcrect)
+{
+  FAR struct vnc_fbupdate_s *curr;
+
+  curr = session->sending;
+  if (curr != NULL && !curr->copy && nxgl_rectoverlap(&curr->rect, srcrect))
+    {
+      return true;
+    }
+
+  for (curr = (FAR struct vnc_fbupdate_s *)sq_peek(&session->updqueue);
+       curr != NULL;
+       curr = curr->flink)
+    {
+      if (!curr->copy && nxgl_rectoverlap(&curr->rect, srcrect))
+        {
+          return true;
+        }
+    }
+
+  return false;
+}
+#endif
+
 /****************************************************************************
  * Name: vnc_updater
  *
@@ -394,14 +573,47 @@ static FAR void *vnc_updater(FAR void *arg)
               srcrect->rect.pt1.x, srcrect->rect.pt1.y,
               srcrect->rect.pt2.x, srcrect->rect.pt2.y);
 
-      /* Attempt to use RRE encoding */
+#ifdef CONFIG_VNCSERVER_COPYRECT
+      /* Send moved regions as CopyRect updates */
 
-      ret = vnc_rre(session, &srcrect->rect);
-      if (ret == 0)
+      if (srcrect->copy)
         {
-          /* Perform the framebuffer update using the default RAW encoding */
+          ret = vnc_copyrect(session, &srcrect->rect, &srcrect->srcpos);
+        }
+      else
+#endif
+        {
+          /* Use the encoding preferred by the client */
+
+          switch (session->encoding)
+            {
+#ifdef CONFIG_VNCSERVER_ZRLE
+              case RFB_ENCODING_ZRLE:
+                ret = vnc_zrle(session, &srcrect->rect);
+                break;
+#endif
+
+#ifdef CONFIG_VNCSERVER_HEXTILE
+              case RFB_ENCODING_HEXTILE:
+                ret = vnc_hextile(session, &srcrect->rect);
+                break;
+#endif
 
-          ret = vnc_raw(session, &srcrect->rect);
+              default:
+
+                /* Attempt to use RRE encoding */
+
+                ret = vnc_rre(session, &srcrect->rect);
+                if (ret == 0)
+                  {
+                    /* Perform the framebuffer update using the default RAW
+                     * encoding
+                     */
+
+                    ret = vnc_raw(session, &srcrect->rect);
+                  }
+                break;
+            }
         }
 
       /* Release the update structure */
@@ -609,23 +821,36 @@ int vnc_update_rectangle(FAR struct vnc_session_s *session,
               session->change |= change;
             }
 
-          /* Allocate an update structure... waiting if necessary */
+          /* Merge the update with a queued update if possible.  If there
+           * are no free update structures, always merge if possible
+           * rather than waiting.
+           */
 
-          update = vnc_alloc_update(session);
-          DEBUGASSERT(update != NULL);
+          if (whupd ||
+              !vnc_merge_update(session, &intersection,
+                                sq_peek(&session->updfree) == NULL))
+            {
+              /* Allocate an update structure... waiting if necessary */
+
+              update = vnc_alloc_update(session);
+              DEBUGASSERT(update != NULL);
 
-          /* Copy the clipped rectangle into the update structure */
+              /* Copy the clipped rectangle into the update structure */
 
-          update->whupd = whupd;
-          nxgl_rectcopy(&update->rect, &intersection);
+              update->whupd = whupd;
+#ifdef CONFIG_VNCSERVER_COPYRECT
+              update->copy  = false;
+#endif
+              nxgl_rectcopy(&update->rect, &intersection);
 
-          /* Add the upate to the end of the update queue. */
+              /* Add the upate to the end of the update queue. */
 
-          vnc_add_queue(session, update);
+              vnc_add_queue(session, update);
 
-          updinfo("Queued {(%d, %d),(%d, %d)}\n",
-                  intersection.pt1.x, intersection.pt1.y,
-                  intersection.pt2.x, intersection.pt2.y);
+              updinfo("Queued {(%d, %d),(%d, %d)}\n",
+                      intersection.pt1.x, intersection.pt1.y,
+                      intersection.pt2.x, intersection.pt2.y);
+            }
         }
 
       sched_unlock();
@@ -637,3 +862,89 @@ int vnc_update_rectangle(FAR struct vnc_session_s *session,
 
   return OK;
 }
+
+/****************************************************************************
+ * Name: vnc_move_rectangle
+ *
+ * Description:
+ *  Queue the update of a region that was moved within the display.  If the
+ *  client supports CopyRect, the move is sent as a CopyRect update;
+ *  otherwise the destination is queued as an ordinary update.
+ *
+ * Input Parameters:
+ *   session - An instance of the session structure.
+ *   rect    - The source rectangle of the move.
+ *   offset  - The new position of the upper left corner of the rectangle.
+ *
+ * Returned Value:
+ *   Zero (OK) is returned on success; a negated errno value is returned on
+ *   any failure.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_VNCSERVER_COPYRECT
+int vnc_move_rectangle(FAR struct vnc_session_s *session,
+                       FAR const struct nxgl_rect_s *rect,
+                       FAR const struct nxgl_point_s *offset)
+{
+  FAR struct vnc_fbupdate_s *update;
+  struct nxgl_rect_s srcrect;
+  struct nxgl_rect_s destrect;
+  nxgl_coord_t dx;
+  nxgl_coord_t dy;
+
+  /* Clip both the source and the destination to the screen dimensions */
+
+  dx = offset->x - rect->pt1.x;
+  dy = offset->y - rect->pt1.y;
+
+  nxgl_rectintersect(&srcrect, rect, &g_wholescreen);
+  nxgl_rectoffset(&destrect, &srcrect, dx, dy);
+  nxgl_rectintersect(&destrect, &destrect, &g_wholescreen);
+  nxgl_rectoffset(&srcrect, &destrect, -dx, -dy);
+
+  if (nxgl_nullrect(&destrect))
+    {
+      return OK;
+    }
+
+  sched_lock();
+
+  /* Send an ordinary update of the destination if the client does not
+   * support CopyRect, if the client's copy of the source region may be
+   * stale, or if we would have to wait for a free update structure.
+   * Nothing need be done if there is a queued whole screen update.
+   */
+
+  if (!session->copyrect || vnc_source_dirty(session, &srcrect) ||
+      sq_peek(&session->updfree) == NULL)
+    {
+      sched_unlock();
+      return vnc_update_rectangle(session, &destrect, true);
+    }
+
+  if (session->nwhupd == 0)
+    {
+      session->change = true;
+
+      update = vnc_alloc_update(session);
+      DEBUGASSERT(update != NULL);
+
+      update->whupd    = false;
+      update->copy     = true;
+      update->srcpos.x = srcrect.pt1.x;
+      update->srcpos.y = srcrect.pt1.y;
+      nxgl_rectcopy(&update->rect, &destrect);
+
+      vnc_add_queue(session, update);
+
+      updinfo("Queued copy (%d, %d) to {(%d, %d),(%d, %d)}\n",
+              srcrect.pt1.x, srcrect.pt1.y,
+              destrect.pt1.x, destrect.pt1.y,
+              destrect.pt2.x, destrect.pt2.y);
+    }
+
+  sched_unlock();
+  return OK;
+}
+#endif
@@ -0,0 +1,911 @@
+/****************************************************************************
+ * graphics/vnc/server/vnc_zrle.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <limits.h>
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+
+#if defined(CONFIG_VNCSERVER_DEBUG) && !defined(CONFIG_DEBUG_GRAPHICS)
+#  undef  CONFIG_DEBUG_FEATURES
+#  undef  CONFIG_DEBUG_ERROR
+#  undef  CONFIG_DEBUG_WARN
+#  undef  CONFIG_DEBUG_INFO
+#  define CONFIG_DEBUG_FEATURES 1
+#  define CONFIG_DEBUG_ERROR    1
+#  define CONFIG_DEBUG_WARN     1
+#  define CONFIG_DEBUG_INFO     1
+#  define CONFIG_DEBUG_GRAPHICS 1
+#endif
+#include <debug.h>
+
+#include "vnc_server.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Palette limits of the ZRLE tile subencodings */
+
+#define ZRLE_MAXPALETTE    127
+#define ZRLE_MAXPACKED     16
+
+/* Deflate limits */
+
+#define DEFLATE_MINMATCH   3
+#define DEFLATE_MAXMATCH   258
+#define DEFLATE_NLITERALS  288
+#define DEFLATE_EOB        256
+
+/* Hash of the three bytes at 'p' */
+
+#define DEFLATE_HASH(p) \
+  ((((uint32_t)(p)[0] << 16 | (uint32_t)(p)[1] << 8 | (p)[2]) * \
+    2654435761u) >> (32 - VNC_ZRLE_HASHBITS))
+
+/****************************************************************************
+ * Private Types
+ ****************************************************************************/
+
+/* The state of one ZRLE encoded update */
+
+struct zrle_stream_s
+{
+  FAR struct vnc_session_s *session;
+  vnc_convert32_t convert;     /* Local to remote color conversion */
+  uint8_t bytespercpixel;      /* Remote bytes per CPIXEL */
+  bool bigendian;              /* True: Remote pixels are big-endian */
+  uint8_t npalette;            /* Number of colors in the tile palette */
+  lfb_color_t palette[ZRLE_MAXPALETTE];
+};
+
+/* Deflate bit writer.  Deflate packs bits starting with the least
+ * significant bit of each byte.
+ */
+
+struct deflate_bits_s
+{
+  FAR uint8_t *out;            /* Output buffer */
+  size_t pos;                  /* Number of complete bytes */
+  size_t limit;                /* Size of the output buffer */
+  uint32_t bitbuf;             /* Pending bits */
+  unsigned int nbits;          /* Number of pending bits */
+};
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* Base lengths and number of extra bits of the length codes 257-285 */
+
+static const uint16_t g_lenbase[29] =
+{
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31,
+  35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+};
+
+static const uint8_t g_lenextra[29] =
+{
+  0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2,
+  3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+};
+
+/* Base distances and number of extra bits of the distance codes 0-29 */
+
+static const uint16_t g_distbase[30] =
+{
+  1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193,
+  257, 385, 513, 769, 1025, 1537, 2049, 3073, 4097, 6145,
+  8193, 12289, 16385, 24577
+};
+
+static const uint8_t g_distextra[30] =
+{
+  0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6,
+  7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+};
+
+/* Bit-reversed fixed Huffman codes of the literal/length symbols and the
+ * length code of each match length.  These are built on first use.
+ */
+
+static bool g_deflate_init;
+static uint16_t g_litcode[DEFLATE_NLITERALS];
+static uint8_t g_litlen[DEFLATE_NLITERALS];
+static uint8_t g_lencode[DEFLATE_MAXMATCH + 1];
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: deflate_reverse
+ *
+ * Description:
+ *  Reverse the order of the 'nbits' least significant bits of 'code'.
+ *  Huffman codes are packed starting with their most significant bit.
+ *
+ ****************************************************************************/
+
+static uint16_t deflate_reverse(uint16_t code, unsigned int nbits)
+{
+  uint16_t result = 0;
+
+  for (; nbits > 0; nbits--)
+    {
+      result = (result << 1) | (code & 1);
+      code >>= 1;
+    }
+
+  return result;
+}
+
+/****************************************************************************
+ * Name: deflate_initialize
+ *
+ * Description:
+ *  Build the fixed Huffman code tables (RFC 1951, section 3.2.6).
+ *
+ ****************************************************************************/
+
+static void deflate_initialize(void)
+{
+  unsigned int sym;
+  unsigned int len;
+  unsigned int code;
+
+  for (sym = 0; sym < DEFLATE_NLITERALS; sym++)
+    {
+      if (sym < 144)
+        {
+          g_litcode[sym] = deflate_reverse(0x30 + sym, 8);
+          g_litlen[sym]  = 8;
+        }
+      else if (sym < 256)
+        {
+          g_litcode[sym] = deflate_reverse(0x190 + sym - 144, 9);
+          g_litlen[sym]  = 9;
+        }
+      else if (sym < 280)
+        {
+          g_litcode[sym] = deflate_reverse(sym - 256, 7);
+          g_litlen[sym]  = 7;
+        }
+      else
+        {
+          g_litcode[sym] = deflate_reverse(0xc0 + sym - 280, 8);
+          g_litlen[sym]  = 8;
+        }
+    }
+
+  for (code = 0, len = DEFLATE_MINMATCH; len <= DEFLATE_MAXMATCH; len++)
+    {
+      if (code < 28 && len >= g_lenbase[code + 1])
+        {
+          code++;
+        }
+
+      g_lencode[len] = code;
+    }
+
+  g_deflate_init = true;
+}
+
+/****************************************************************************
+ * Name: deflate_putbits
+ *
+ * Description:
+ *  Append bits to the deflate output.  Output beyond the end of the
+ *  buffer is counted but discarded.
+ *
+ ****************************************************************************/
+
+static inline void deflate_putbits(FAR struct deflate_bits_s *bits,
+                                   uint32_t value, unsigned int nbits)
+{
+  bits->bitbuf |= value << bits->nbits;
+  bits->nbits  += nbits;
+
+  while (bits->nbits >= 8)
+    {
+      if (bits->pos < bits->limit)
+        {
+          bits->out[bits->pos] = (uint8_t)bits->bitbuf;
+        }
+
+      bits->pos++;
+      bits->bitbuf >>= 8;
+      bits->nbits   -= 8;
+    }
+}
+
+/****************************************************************************
+ * Name: deflate_putliteral and deflate_putmatch
+ *
+ * Description:
+ *  Append one literal byte or one <length, distance> pair using the fixed
+ *  Huffman codes.
+ *
+ ****************************************************************************/
+
+static inline void deflate_putliteral(FAR struct deflate_bits_s *bits,
+                                      unsigned int sym)
+{
+  deflate_putbits(bits, g_litcode[sym], g_litlen[sym]);
+}
+
+static void deflate_putmatch(FAR struct deflate_bits_s *bits,
+                             unsigned int len, unsigned int dist)
+{
+  unsigned int code;
+
+  code = g_lencode[len];
+  deflate_putliteral(bits, 257 + code);
+  if (g_lenextra[code] > 0)
+    {
+      deflate_putbits(bits, len - g_lenbase[code], g_lenextra[code]);
+    }
+
+  for (code = 29; g_distbase[code] > dist; code--);
+
+  deflate_putbits(bits, deflate_reverse(code, 5), 5);
+  if (g_distextra[code] > 0)
+    {
+      deflate_putbits(bits, dist - g_distbase[code], g_distextra[code]);
+    }
+}
+
+/****************************************************************************
+ * Name: vnc_deflate
+ *
+ * Description:
+ *  Compress one ZRLE tile as a part of the session's zlib stream.  The
+ *  data is compressed with greedy LZ77 matching and the fixed Huffman
+ *  codes and is followed by an empty stored block (a zlib sync flush) so
+ *  that the client can decode the complete tile.  If that does not make
+ *  the data smaller, a single stored block is sent instead.  Matches never
+ *  reach back into earlier tiles, but the stream itself is continuous as
+ *  required by ZRLE.
+ *
+ * Input Parameters:
+ *   zrle  - The ZRLE encoder state
+ *   inlen - The size of the uncompressed tile in zrle->tile
+ *   out   - The location to store the compressed data
+ *
+ * Returned Value:
+ *   The size of the compressed data.
+ *
+ ****************************************************************************/
+
+static size_t vnc_deflate(FAR struct vnc_zrle_s *zrle, size_t inlen,
+                          FAR uint8_t *out)
+{
+  FAR const uint8_t *in = zrle->tile;
+  FAR uint16_t *hash = zrle->hash;
+  struct deflate_bits_s bits;
+  size_t storedsize;
+  size_t hdrsize = 0;
+  unsigned int maxlen;
+  unsigned int len;
+  unsigned int h;
+  size_t cand;
+  size_t i;
+  size_t j;
+
+  if (!g_deflate_init)
+    {
+      deflate_initialize();
+    }
+
+  /* The zlib header (deflate, 32K window, no dictionary, fastest) starts
+   * the stream.  There is no trailer; the stream never ends.
+   */
+
+  if (!zrle->started)
+    {
+      out[0]        = 0x78;
+      out[1]        = 0x01;
+      hdrsize       = 2;
+      zrle->started = true;
+    }
+
+  DEBUGASSERT(inlen <= VNC_ZRLE_TILEBUFSIZE);
+  storedsize  = 5 + inlen;
+
+  bits.out    = &out[hdrsize];
+  bits.pos    = 0;
+  bits.limit  = storedsize;
+  bits.bitbuf = 0;
+  bits.nbits  = 0;
+
+  /* BFINAL=0, BTYPE=01 (fixed Huffman codes) */
+
+  deflate_putbits(&bits, 0 | (1 << 1), 3);
+
+  for (i = 0; i < inlen && bits.pos < storedsize; )
+    {
+      len = 0;
+
+      if (i + DEFLATE_MINMATCH <= inlen)
+        {
+          /* The hash table is never cleared.  Entries left by earlier
+           * tiles are rejected by the position check or the comparison.
+           */
+
+          h       = DEFLATE_HASH(&in[i]);
+          cand    = hash[h];
+          hash[h] = (uint16_t)i;
+
+          if (cand < i && in[cand] == in[i] && in[cand + 1] == in[i + 1] &&
+              in[cand + 2] == in[i + 2])
+            {
+              maxlen = MIN(DEFLATE_MAXMATCH, inlen - i);
+              for (len = DEFLATE_MINMATCH;
+                   len < maxlen && in[cand + len] == in[i + len];
+                   len++);
+            }
+        }
+
+      if (len == 0)
+        {
+          deflate_putliteral(&bits, in[i]);
+          i++;
+        }
+      else
+        {
+          deflate_putmatch(&bits, len, i - cand);
+
+          /* Hash the positions covered by the match */
+
+          for (j = i + 1, i += len; j < i && j + DEFLATE_MINMATCH <= inlen;
+               j++)
+            {
+              hash[DEFLATE_HASH(&in[j])] = (uint16_t)j;
+            }
+        }
+    }
+
+  /* End of block, then the sync flush:  An empty stored block, aligned to
+   * a byte boundary.
+   */
+
+  deflate_putliteral(&bits, DEFLATE_EOB);
+  deflate_putbits(&bits, 0, 3);
+  if (bits.nbits > 0)
+    {
+      deflate_putbits(&bits, 0, 8 - bits.nbits);
+    }
+
+  deflate_putbits(&bits, 0x0000, 16);
+  deflate_putbits(&bits, 0xffff, 16);
+
+  if (i < inlen || bits.pos > storedsize)
+    {
+      /* Send one stored block instead:  BFINAL=0, BTYPE=00, LEN, NLEN. A
+       * stored block ends on a byte boundary so no flush is needed.
+       */
+
+      bits.out[0] = 0;
+      bits.out[1] = (uint8_t)inlen;
+      bits.out[2] = (uint8_t)(inlen >> 8);
+      bits.out[3] = (uint8_t)~inlen;
+      bits.out[4] = (uint8_t)(~inlen >> 8);
+      memcpy(&bits.out[5], in, inlen);
+      return hdrsize + storedsize;
+    }
+
+  return hdrsize + bits.pos;
+}
+
+/****************************************************************************
+ * Name: vnc_zrle_lookup
+ *
+ * Description:
+ *  Find the index of a color in the tile palette, adding it if necessary.
+ *
+ * Returned Value:
+ *   The palette index; -1 if the palette is full.
+ *
+ ****************************************************************************/
+
+static int vnc_zrle_lookup(FAR struct zrle_stream_s *stream,
+                           lfb_color_t color)
+{
+  int i;
+
+  for (i = 0; i < stream->npalette; i++)
+    {
+      if (stream->palette[i] == color)
+        {
+          return i;
+        }
+    }
+
+  if (stream->npalette >= ZRLE_MAXPALETTE)
+    {
+      return -1;
+    }
+
+  stream->palette[i] = color;
+  stream->npalette++;
+  return i;
+}
+
+/****************************************************************************
+ * Name: vnc_zrle_runlength
+ *
+ * Description:
+ *  Store the length of a run in the ZRLE format:  (length - 1) as a series
+ *  of 255's followed by the remainder.
+ *
+ ****************************************************************************/
+
+static FAR uint8_t *vnc_zrle_runlength(FAR uint8_t *dest,
+                                       unsigned int runlen)
+{
+  for (runlen--; runlen >= 255; runlen -= 255)
+    {
+      *dest++ = 255;
+    }
+
+  *dest++ = (uint8_t)runlen;
+  return dest;
+}
+
+/****************************************************************************
+ * Name: vnc_zrle_tile
+ *
+ * Description:
+ *  Encode one tile in the ZRLE tile format, choosing the smallest of the
+ *  solid, packed palette, palette RLE, plain RLE and raw subencodings.
+ *
+ * Input Parameters:
+ *   stream        - The state of the ZRLE encoded update
+ *   x, y          - The position of the tile in the local framebuffer
+ *   width, height - The size of the tile
+ *
+ * Returned Value:
+ *   The size of the uncompressed tile in session->zrle.tile.
+ *
+ ****************************************************************************/
+
+static size_t vnc_zrle_tile(FAR struct zrle_stream_s *stream,
+                            nxgl_coord_t x, nxgl_coord_t y,
+                            nxgl_coord_t width, nxgl_coord_t height)
+{
+  FAR struct vnc_session_s *session = stream->session;
+  FAR const lfb_color_t *srcrow;
+  FAR const lfb_color_t *src;
+  FAR uint8_t *dest;
+  FAR uint8_t *start;
+  lfb_color_t prev;
+  lfb_color_t pixel;
+  unsigned int bpc = stream->bytespercpixel;
+  unsigned int npixels = width * height;
+  unsigned int runlen;
+  unsigned int nruns;
+  unsigned int runbytes;
+  unsigned int singles;
+  unsigned int rawsize;
+  unsigned int rlesize;
+  unsigned int palrlesize;
+  unsigned int packedsize;
+  unsigned int nbits;
+  unsigned int shift;
+  uint8_t subencoding;
+  uint8_t packed;
+  int ndx;
+  int col;
+  int row;
+  int i;
+
+  srcrow = (FAR const lfb_color_t *)
+    (session->fb + RFB_STRIDE * y + RFB_BYTESPERPIXEL * x);
+
+  /* Pass 1:  Count the runs and collect the palette.  Runs continue from
+   * one row to the next.
+   */
+
+  stream->npalette = 0;
+  prev     = *srcrow;
+  runlen   = 0;
+  nruns    = 0;
+  runbytes = 0;
+  singles  = 0;
+  ndx    = vnc_zrle_lookup(stream, prev);
+
+  for (src = srcrow, row = 0; row < height; row++)
+    {
+      for (col = 0; col < width; col++)
+        {
+          pixel = src[col];
+          if (pixel == prev)
+            {
+              runlen++;
+              continue;
+            }
+
+          nruns++;
+          runbytes += (runlen - 1) / 255 + 1;
+          singles  += (runlen == 1);
+
+          if (ndx >= 0)
+            {
+              ndx = vnc_zrle_lookup(stream, pixel);
+            }
+
+          prev   = pixel;
+          runlen = 1;
+        }
+
+      src = (FAR const lfb_color_t *)((uintptr_t)src + RFB_STRIDE);
+    }
+
+  nruns++;
+  runbytes += (runlen - 1) / 255 + 1;
+  singles  += (runlen == 1);
+
+  /* Estimate the size of each subencoding */
+
+  rawsize    = npixels * bpc;
+  rlesize    = nruns * bpc + runbytes;
+  palrlesize = UINT_MAX;
+  packedsize = UINT_MAX;
+  nbits      = 0;
+
+  if (ndx >= 0)
+    {
+      /* A palette RLE run costs one index byte.  Only runs longer than one
+       * pixel are followed by a run length.
+       */
+
+      palrlesize = stream->npalette * bpc + nruns + runbytes - singles;
+
+      if (stream->npalette <= ZRLE_MAXPACKED)
+        {
+          nbits      = stream->npalette <= 2 ? 1 :
+                       stream->npalette <= 4 ? 2 : 4;
+          packedsize = stream->npalette * bpc +
+                       height * ((width * nbits + 7) >> 3);
+        }
+    }
+
+  /* Pass 2:  Encode the tile */
+
+  start = session->zrle.tile;
+  dest  = start + 1;
+
+  if (ndx >= 0 && stream->npalette == 1)
+    {
+      subencoding = RFB_ZRLE_SOLID;
+      dest = vnc_putpixel(dest, stream->convert(stream->palette[0]), bpc,
+                          stream->bigendian);
+    }
+  else if (packedsize <= palrlesize && packedsize <= rlesize &&
+           packedsize < rawsize)
+    {
+      /* Packed palette:  Each row starts on a byte boundary with the
+       * leftmost pixel in the most significant bits.
+       */
+
+      subencoding = stream->npalette;
+      for (i = 0; i < stream->npalette; i++)
+        {
+          dest = vnc_putpixel(dest, stream->convert(stream->palette[i]), bpc,
+                              stream->bigendian);
+        }
+
+      prev  = stream->palette[0];
+      ndx = 0;
+
+      for (src = srcrow, row = 0; row < height; row++)
+        {
+          packed = 0;
+          shift  = 8;
+
+          for (col = 0; col < width; col++)
+            {
+              pixel = src[col];
+              if (pixel != prev)
+                {
+                  ndx = vnc_zrle_lookup(stream, pixel);
+                  prev  = pixel;
+                }
+
+              shift  -= nbits;
+              packed |= (uint8_t)(ndx << shift);
+              if (shift == 0)
+                {
+                  *dest++ = packed;
+                  packed  = 0;
+                  shift   = 8;
+                }
+            }
+
+          if (shift < 8)
+            {
+              *dest++ = packed;
+            }
+
+          src = (FAR const lfb_color_t *)((uintptr_t)src + RFB_STRIDE);
+        }
+    }
+  else if (palrlesize <= rlesize && palrlesize < rawsize)
+    {
+      /* Palette RLE:  A palette index per run, with the top bit set if a
+       * run length follows.
+       */
+
+      subencoding = RFB_ZRLE_PALRLE(stream->npalette);
+      for (i = 0; i < stream->npalette; i++)
+        {
+          dest = vnc_putpixel(dest, stream->convert(stream->palette[i]), bpc,
+                              stream->bigendian);
+        }
+
+      prev   = *srcrow;
+      runlen = 0;
+
+      for (src = srcrow, row = 0; row < height; row++)
+        {
+          for (col = 0; col < width; col++)
+            {
+              pixel = src[col];
+              if (pixel == prev)
+                {
+                  runlen++;
+                  continue;
+                }
+
+              ndx = vnc_zrle_lookup(stream, prev);
+              if (runlen == 1)
+                {
+                  *dest++ = (uint8_t)ndx;
+                }
+              else
+                {
+                  *dest++ = (uint8_t)(ndx | 0x80);
+                  dest    = vnc_zrle_runlength(dest, runlen);
+                }
+
+              prev   = pixel;
+              runlen = 1;
+            }
+
+          src = (FAR const lfb_color_t *)((uintptr_t)src + RFB_STRIDE);
+        }
+
+      ndx = vnc_zrle_lookup(stream, prev);
+      if (runlen == 1)
+        {
+          *dest++ = (uint8_t)ndx;
+        }
+      else
+        {
+          *dest++ = (uint8_t)(ndx | 0x80);
+          dest    = vnc_zrle_runlength(dest, runlen);
+        }
+    }
+  else if (rlesize < rawsize)
+    {
+      /* Plain RLE:  A pixel value and a run length per run */
+
+      subencoding = RFB_ZRLE_RLE;
+      prev        = *srcrow;
+      runlen      = 0;
+
+      for (src = srcrow, row = 0; row < height; row++)
+        {
+          for (col = 0; col < width; col++)
+            {
+              pixel = src[col];
+              if (pixel == prev)
+                {
+                  runlen++;
+                  continue;
+                }
+
+              dest   = vnc_putpixel(dest, stream->convert(prev), bpc,
+                                    stream->bigendian);
+              dest   = vnc_zrle_runlength(dest, runlen);
+              prev   = pixel;
+              runlen = 1;
+            }
+
+          src = (FAR const lfb_color_t *)((uintptr_t)src + RFB_STRIDE);
+        }
+
+      dest = vnc_putpixel(dest, stream->convert(prev), bpc,
+                          stream->bigendian);
+      dest = vnc_zrle_runlength(dest, runlen);
+    }
+  else
+    {
+      /* Raw CPIXELs */
+
+      subencoding = RFB_ZRLE_RAW;
+      for (src = srcrow, row = 0; row < height; row++)
+        {
+          for (col = 0; col < width; col++)
+            {
+              dest = vnc_putpixel(dest, stream->convert(src[col]), bpc,
+                                  stream->bigendian);
+            }
+
+          src = (FAR const lfb_color_t *)((uintptr_t)src + RFB_STRIDE);
+        }
+    }
+
+  *start = subencoding;
+  DEBUGASSERT(dest - start <= VNC_ZRLE_TILEBUFSIZE);
+  return dest - start;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: vnc_zrle
+ *
+ * Description:
+ *  Send the framebuffer update using the ZRLE encoding.
+ *
+ *  Each 64x64 tile of the update is sent as a separate ZRLE rectangle.
+ *  That bounds the size of the compressed data that has to be held before
+ *  its length can be sent.
+ *
+ * Input Parameters:
+ *   session - An instance of the session structure.
+ *   rect    - Describes the rectangle in the local framebuffer.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; A negated errno value is returned on failure that
+ *   indicates the nature of the failure.  A failure is only returned
+ *   in cases of a network failure and unexpected internal failures.
+ *
+ ****************************************************************************/
+
+int vnc_zrle(FAR struct vnc_session_s *session, FAR struct nxgl_rect_s *rect)
+{
+  FAR struct rfb_framebufferupdate_s *update;
+  FAR struct rfb_rectangle_s *zrect;
+  FAR uint8_t *zbuf = session->zrle.zbuf;
+  FAR const uint8_t *src;
+  struct zrle_stream_s stream;
+  nxgl_coord_t width;
+  nxgl_coord_t height;
+  nxgl_coord_t x;
+  nxgl_coord_t y;
+  unsigned int ntiles;
+  size_t tilesize;
+  size_t zsize;
+  size_t size;
+  ssize_t nsent;
+  uint8_t bpp;
+
+  /* Use one color format for the whole update, even if a SetPixelFormat
+   * is received asynchronously.  A 32-bit pixel with a depth of 24 or less
+   * is sent as a 3 byte CPIXEL.
+   */
+
+  bpp                   = session->bpp;
+  stream.session        = session;
+  stream.convert        = vnc_converter(session->colorfmt);
+  stream.bigendian      = session->bigendian;
+  stream.bytespercpixel = (bpp == 32 && session->depth <= 24) ?
+                          3 : (bpp + 7) >> 3;
+
+  if (stream.convert == NULL)
+    {
+      gerr("ERROR: Unrecognized color format: %d\n", session->colorfmt);
+      return -EINVAL;
+    }
+
+  DEBUGASSERT(rect->pt1.x <= rect->pt2.x && rect->pt1.y <= rect->pt2.y);
+
+  ntiles = ((rect->pt2.x - rect->pt1.x + VNC_ZRLE_SIZE) / VNC_ZRLE_SIZE) *
+           ((rect->pt2.y - rect->pt1.y + VNC_ZRLE_SIZE) / VNC_ZRLE_SIZE);
+
+  /* The FramebufferUpdate header precedes the first rectangle */
+
+  update          = (FAR struct rfb_framebufferupdate_s *)zbuf;
+  update->msgtype = RFB_FBUPDATE_MSG;
+  update->padding = 0;
+  rfb_putbe16(update->nrect, ntiles);
+
+  src  = zbuf;
+  zrect = update->rect;
+
+  for (y = rect->pt1.y; y <= rect->pt2.y; y += VNC_ZRLE_SIZE)
+    {
+      height = MIN(VNC_ZRLE_SIZE, rect->pt2.y - y + 1);
+
+      for (x = rect->pt1.x; x <= rect->pt2.x; x += VNC_ZRLE_SIZE)
+        {
+          width = MIN(VNC_ZRLE_SIZE, rect->pt2.x - x + 1);
+
+          /* Encode and compress the tile behind the headers */
+
+          tilesize = vnc_zrle_tile(&stream, x, y, width, height);
+          zsize    = vnc_deflate(&session->zrle, tilesize,
+                                 &zbuf[VNC_ZRLE_HDRSIZE]);
+
+          rfb_putbe16(zrect->xpos,     x);
+          rfb_putbe16(zrect->ypos,     y);
+          rfb_putbe16(zrect->width,    width);
+          rfb_putbe16(zrect->height,   height);
+          rfb_putbe32(zrect->encoding, RFB_ENCODING_ZRLE);
+          rfb_putbe32(zrect->data,     zsize);
+
+          size = &zbuf[VNC_ZRLE_HDRSIZE] - src + zsize;
+          DEBUGASSERT(VNC_ZRLE_HDRSIZE + zsize <= VNC_ZRLE_ZBUFSIZE);
+
+          do
+            {
+              nsent = psock_send(&session->connect, src, size, 0);
+              if (nsent < 0)
+                {
+                  int errcode = get_errno();
+                  gerr("ERROR: Send ZRLE FrameBufferUpdate failed: %d\n",
+                       errcode);
+                  DEBUGASSERT(errcode > 0);
+                  return -errcode;
+                }
+
+              DEBUGASSERT(nsent <= size);
+              src  += nsent;
+              size -= nsent;
+            }
+          while (size > 0);
+
+          /* Only the rectangle header precedes the following tiles */
+
+          src = (FAR const uint8_t *)zrect;
+        }
+    }
+
+  updinfo("Sent {(%d, %d),(%d, %d)}\n",
+          rect->pt1.x, rect->pt1.y, rect->pt2.x, rect->pt2.y);
+  return OK;
+}
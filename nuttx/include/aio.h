@@ -43,6 +43,7 @@
 #include <nuttx/config.h>
 
 #include <sys/types.h>
+#include <stdint.h>
 #include <signal.h>
 #include <time.h>
 
@@ -141,6 +142,25 @@ struct aiocb
   FAR void *aio_priv;            /* Used by signal handlers */
 };
 
+/* Non-standard.  A completion ring that may be provided to aio_submit().
+ * As each request of the batch completes, the OS stores its control block
+ * pointer in entries[head & mask] and then increments 'head'.  The
+ * application consumes completions by reading entries[tail & mask] and
+ * incrementing 'tail' while 'tail' != 'head', without any system call.
+ * The number of entries must be a power of two.  A completion that finds
+ * the ring full is counted in 'overflow'; its result is still available
+ * from aio_error() and aio_return().
+ */
+
+struct aio_ring_s
+{
+  volatile uint32_t head;        /* Incremented by the OS on completion */
+  volatile uint32_t tail;        /* Incremented by the application */
+  uint32_t mask;                 /* Number of entries minus one */
+  volatile uint32_t overflow;    /* Completions lost because the ring was full */
+  FAR struct aiocb **entries;    /* The ring of completed control blocks */
+};
+
 /****************************************************************************
  * Public Data
  ****************************************************************************/
@@ -168,6 +188,13 @@ int aio_write(FAR struct aiocb *aiocbp);
 int lio_listio(int mode, FAR struct aiocb *const list[], int nent,
                FAR struct sigevent *sig);
 
+/* Non-standard.  Submit a list of LIO_READ and LIO_WRITE requests as a
+ * single batch, optionally posting their completions to 'ring'.
+ */
+
+int aio_submit(FAR struct aiocb *const list[], int nent,
+               FAR struct aio_ring_s *ring);
+
 #undef EXTERN
 #ifdef __cplusplus
 }
@@ -1940,6 +1940,29 @@ char up_romgetc(FAR const char *ptr);
 void up_mdelay(unsigned int milliseconds);
 void up_udelay(useconds_t microseconds);
 
+/****************************************************************************
+ * Name: up_perf_gettime and up_perf_getfreq
+ *
+ * Description:
+ *   up_perf_gettime() returns the current value of a free-running, 32-bit
+ *   counter that is used for high resolution time measurements.  The
+ *   counter must be monotonic and, in SMP configurations, consistent
+ *   between CPUs.  Only differences between two values are meaningful;
+ *   the counter is allowed to wrap.  up_perf_getfreq() returns the
+ *   frequency of that counter in Hz.
+ *
+ *   These may be called with interrupts disabled and from interrupt
+ *   handlers.  If the architecture does not select
+ *   CONFIG_ARCH_HAVE_PERFCOUNTER, the OS provides versions based on
+ *   clock_systimespec() with a frequency of 1 MHz.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_TIMESTATS
+uint32_t up_perf_gettime(void);
+uint32_t up_perf_getfreq(void);
+#endif
+
 /****************************************************************************
  * These are standard interfaces that are exported by the OS for use by the
  * architecture specific logic
@@ -1019,6 +1019,47 @@ int file_poll(FAR struct file *filep, FAR struct pollfd *fds, bool setup);
 int fdesc_poll(int fd, FAR struct pollfd *fds, bool setup);
 #endif
 
+/****************************************************************************
+ * Name: rammap_release
+ *
+ * Description:
+ *   Release all of the file mappings created by mmap() that belong to a
+ *   task group.  This is called when the task group exits.
+ *
+ * Parameters:
+ *   group - The task group that is exiting
+ *
+ * Return:
+ *   None
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_RAMMAP
+struct task_group_s; /* Forward reference */
+void rammap_release(FAR struct task_group_s *group);
+#endif
+
+/****************************************************************************
+ * Name: rammap_invalidate
+ *
+ * Description:
+ *   Stop sharing the memory regions created by mmap() that hold a copy of
+ *   a file.  This is called after the file has been written or truncated,
+ *   or after a file in a mounted file system has been unlinked or renamed.
+ *
+ * Parameters:
+ *   inode - The driver or mountpoint inode of the file
+ *   filep - The modified file, or NULL for all files in the file system
+ *
+ * Return:
+ *   None
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_FS_RAMMAP
+void rammap_invalidate(FAR struct inode *inode, FAR struct file *filep);
+#endif
+
 #undef EXTERN
 #if defined(__cplusplus)
 }
@@ -89,6 +89,7 @@
 #define _CLIOCBASE      (0x2400) /* Contactless modules ioctl commands */
 #define _USBCBASE       (0x2500) /* USB-C controller ioctl commands */
 #define _MAC802154BASE  (0x2600) /* 802.15.4 MAC ioctl commands */
+#define _NOTEBASE       (0x2700) /* Scheduler note driver ioctl commands */
 
 /* boardctl() commands share the same number space */
 
@@ -147,6 +148,20 @@
 #define FIONSPACE       _FIOC(0x0007)     /* IN:  Location to return value (int *)
                                            * OUT: Free space in send queue.
                                            */
+#define FIOC_FILEID     _FIOC(0x0008)     /* IN:  Location to return value (uintptr_t *)
+                                           * OUT: A value that identifies the open
+                                           *      file uniquely within its file
+                                           *      system while it is mounted.
+                                           */
+#define FIOC_XIPBASE    _FIOC(0x0009)     /* IN:  Location to return address (void **)
+                                           * OUT: If the file data is already held
+                                           *      contiguously in directly
+                                           *      accessible memory, return its
+                                           *      (void*) base address.  Unlike
+                                           *      FIOC_MMAP, never creates a copy.
+                                           *      The address remains valid only
+                                           *      while the file is open.
+                                           */
 
 /* NuttX file system ioctl definitions **************************************/
 
@@ -229,6 +244,11 @@
                                            *      the block with specific debug
                                            *      command and data.
                                            * OUT: None.  */
+#define BIOC_FLUSH      _BIOC(0x000C)     /* Write any state cached by the block
+                                           * driver to the media.
+                                           * IN:  None
+                                           * OUT: None (ioctl return value provides
+                                           *      success/failure indication). */
 
 /* NuttX MTD driver ioctl definitions ***************************************/
 
@@ -428,6 +448,12 @@
 #define _MAC802154IOCVALID(c)  (_IOC_TYPE(c)==_MAC802154BASE)
 #define _MAC802154IOC(nr)      _IOC(_MAC802154BASE,nr)
 
+/* Scheduler note driver ioctl definitions **********************************/
+/* (see nuttx/include/sched_note.h */
+
+#define _NOTEIOCVALID(c)  (_IOC_TYPE(c)==_NOTEBASE)
+#define _NOTEIOC(nr)      _IOC(_NOTEBASE,nr)
+
 /* boardctl() command definitions *******************************************/
 
 #define _BOARDIOCVALID(c) (_IOC_TYPE(c)==_BOARDBASE)
@@ -211,6 +211,8 @@ void net_initialize(void);
  *   net_unlock()        - Gives the semaphore().
  *   net_lockedwait()    - Like pthread_cond_wait(); releases the semaphore
  *                         momentarily to wait on another semaphore()
+ *   net_ioballoc()      - Like iob_alloc(); releases the semaphore
+ *                         momentarily to wait for an IOB
  *
  ****************************************************************************/
 
@@ -273,6 +275,28 @@ int net_timedwait(sem_t *sem, FAR const struct timespec *abstime);
 
 int net_lockedwait(sem_t *sem);
 
+/****************************************************************************
+ * Name: net_ioballoc
+ *
+ * Description:
+ *   Allocate an IOB.  If no IOB is available, then wait for one with the
+ *   lock on the network temporarily released so that the network can free
+ *   IOBs in the meantime.
+ *
+ * Input Parameters:
+ *   throttled - An indication of the IOB allocation is "throttled"
+ *
+ * Returned value:
+ *   A pointer to the newly allocated IOB is returned on success.  NULL is
+ *   returned on any allocation failure.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MM_IOB
+struct iob_s;  /* Forward reference */
+FAR struct iob_s *net_ioballoc(bool throttled);
+#endif
+
 /****************************************************************************
  * Name: net_setipid
  *
@@ -131,6 +131,24 @@
 #  define NETDEV_ERRORS(dev)
 #endif
 
+#ifdef CONFIG_NET_TCP_GSO
+/* Capabilities that a driver may advertise in d_features:
+ *
+ *   NETDEV_GSO - The driver's TX poll callback can accept several packets
+ *     back-to-back from a single poll and does not feed any of them back
+ *     into the network (as the loopback device does).  Large TCP sends
+ *     are split into segments by the network just before the callback.
+ *     With CONFIG_NET_TCP_CC, received ACKs request a TX poll through
+ *     d_txavail() rather than sending a segment directly, so the driver
+ *     should poll promptly when d_txavail() is called.
+ *   NETDEV_TSO - The driver (or its hardware) performs the segmentation of
+ *     large TCP sends itself.  See d_gsolen below.
+ */
+
+#  define NETDEV_GSO              (1 << 0)
+#  define NETDEV_TSO              (1 << 1)
+#endif
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -178,6 +196,7 @@ struct netdev_statistics_s
  */
 
 struct devif_callback_s; /* Forward reference */
+struct iob_s;            /* Forward reference */
 
 struct net_driver_s
 {
@@ -200,6 +219,12 @@ struct net_driver_s
 
   uint8_t d_flags;
 
+#ifdef CONFIG_NET_TCP_GSO
+  /* Driver capabilities.  See NETDEV_GSO and NETDEV_TSO */
+
+  uint8_t d_features;
+#endif
+
 #ifdef CONFIG_NET_MULTILINK
   /* Multi network devices using multiple data links protocols are selected */
 
@@ -207,9 +232,13 @@ struct net_driver_s
   uint8_t d_llhdrlen;           /* Link layer header size */
   uint16_t d_mtu;               /* Maximum packet size */
 #ifdef CONFIG_NET_TCP
+#ifdef CONFIG_NET_TCP_WINDOW_SCALE
+  uint32_t d_recvwndo;          /* TCP receive window size */
+#else
   uint16_t d_recvwndo;          /* TCP receive window size */
 #endif
 #endif
+#endif
 
 #if defined(CONFIG_NET_ETHERNET) || defined(CONFIG_NET_6LOWPAN)
   /* Link layer address */
@@ -296,6 +325,25 @@ struct net_driver_s
 
   uint16_t d_sndlen;
 
+#ifdef CONFIG_NET_TCP_GSO
+  /* Large send.  When d_gsolen is non-zero, the outgoing TCP packet in d_buf
+   * is only the first segment of a large send.  The following d_gsolen
+   * bytes of payload are in the I/O buffer chain d_gsoiob, beginning at
+   * offset d_gsooffset, and must go out in further segments of at most
+   * d_gsosize bytes.  Each of those reuses the IP and TCP headers of the
+   * packet in d_buf with the sequence number advanced and the IP length,
+   * IP ID and checksums updated.
+   *
+   * Only drivers that advertise NETDEV_TSO ever see a non-zero d_gsolen in
+   * their TX poll callback.
+   */
+
+  FAR struct iob_s *d_gsoiob;
+  uint16_t d_gsooffset;
+  uint16_t d_gsolen;
+  uint16_t d_gsosize;
+#endif
+
 #ifdef CONFIG_NET_IGMP
   /* IGMP group list */
 
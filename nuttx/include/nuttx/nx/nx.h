@@ -904,6 +904,68 @@ int nx_bitmap(NXWINDOW hwnd, FAR const struct nxgl_rect_s *dest,
               FAR const void *src[CONFIG_NX_NPLANES],
               FAR const struct nxgl_point_s *origin, unsigned int stride);
 
+/****************************************************************************
+ * Name: nx_blendbitmap
+ *
+ * Description:
+ *   Blend a rectangular region of a larger image over the rectangle in the
+ *   specified window with a constant opacity.  This draws translucent
+ *   overlays.  The image has the pixel format of the display.
+ *
+ * Input Parameters:
+ *   hwnd   - The window that will receive the bitmap image
+ *   dest   - Describes the rectangular region on the display that will
+ *            receive the the bit map.
+ *   src    - The start of the source image.  This is an array source
+ *            images of size CONFIG_NX_NPLANES.
+ *   origin - The origin of the upper, left-most corner of the full bitmap.
+ *            Both dest and origin are in window coordinates, however, origin
+ *            may lie outside of the display.
+ *   stride - The width of the full source image in bytes.
+ *   alpha  - The opacity of the image, from 0 (transparent) to 255 (opaque)
+ *
+ * Return:
+ *   OK on success; ERROR on failure with errno set appropriately
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NX_BLEND
+int nx_blendbitmap(NXWINDOW hwnd, FAR const struct nxgl_rect_s *dest,
+                   FAR const void *src[CONFIG_NX_NPLANES],
+                   FAR const struct nxgl_point_s *origin, unsigned int stride,
+                   uint8_t alpha);
+
+/****************************************************************************
+ * Name: nx_fillmask
+ *
+ * Description:
+ *   Draw a color into the specified window through a rectangular region of
+ *   a larger 8-bit coverage mask.  Each byte of the mask is the opacity of
+ *   the color over one pixel, from 0 (untouched) to 255 (set to the color).
+ *   This draws anti-aliased glyphs:  the mask is the glyph as rendered by
+ *   an anti-aliasing font rasterizer.
+ *
+ * Input Parameters:
+ *   hwnd   - The window that will receive the color
+ *   dest   - Describes the rectangular region on the display that will be
+ *            drawn.
+ *   mask   - The start of the mask, one byte per pixel.
+ *   origin - The origin of the upper, left-most corner of the full mask.
+ *            Both dest and origin are in window coordinates, however, origin
+ *            may lie outside of the display.
+ *   stride - The width of the full mask in bytes.
+ *   color  - The color to draw
+ *
+ * Return:
+ *   OK on success; ERROR on failure with errno set appropriately
+ *
+ ****************************************************************************/
+
+int nx_fillmask(NXWINDOW hwnd, FAR const struct nxgl_rect_s *dest,
+                FAR const uint8_t *mask, FAR const struct nxgl_point_s *origin,
+                unsigned int stride, nxgl_mxpixel_t color[CONFIG_NX_NPLANES]);
+#endif
+
 /****************************************************************************
  * Name: nx_notify_rectangle
  *
@@ -930,6 +992,28 @@ void nx_notify_rectangle(FAR NX_PLANEINFOTYPE *pinfo,
                          FAR const struct nxgl_rect_s *rect);
 #endif
 
+/****************************************************************************
+ * Name: nx_notify_move
+ *
+ * Description:
+ *   When CONFIG_NX_UPDATE_MOVE=y, then a region moved within the display
+ *   is reported with this callout instead of with nx_notify_rectangle().
+ *   This allows a remote display to repeat the move instead of receiving
+ *   the moved pixel data.
+ *
+ *   The same external logic that provides nx_notify_rectangle() must
+ *   provide this interface.  It receives the source rectangle and the new
+ *   position of its upper left corner, in the same form as the plane's
+ *   moverectangle method.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NX_UPDATE_MOVE
+void nx_notify_move(FAR NX_PLANEINFOTYPE *pinfo,
+                    FAR const struct nxgl_rect_s *rect,
+                    FAR const struct nxgl_point_s *offset);
+#endif
+
 /****************************************************************************
  * Name: nx_kbdin
  *
@@ -455,6 +455,12 @@ struct nx_fontpackage_s
 #endif
 };
 
+/* A character code.  The built-in font sets cover only 7- and 8-bit codes,
+ * but the glyph lookup and the font cache accept any Unicode code point.
+ */
+
+typedef uint32_t nxf_code_t;
+
 /* Font Cache ***************************************************************/
 /* Opaque handle used to reference a font cache */
 
@@ -464,8 +470,10 @@ typedef FAR void *FCACHE;
 
 struct nxfonts_glyph_s
 {
-  FAR struct nxfonts_glyph_s *flink;   /* Implements a singly linked list */
-  uint8_t code;                        /* Character code */
+  FAR struct nxfonts_glyph_s *flink;   /* LRU list, toward least recently used */
+  FAR struct nxfonts_glyph_s *blink;   /* LRU list, toward most recently used */
+  FAR struct nxfonts_glyph_s *hlink;   /* Next glyph in the same hash bucket */
+  nxf_code_t code;                     /* Character code */
   uint8_t height;                      /* Height of this glyph (in rows) */
   uint8_t width;                       /* Width of this glyph (in pixels) */
   uint8_t stride;                      /* Width of the glyph row (in bytes) */
@@ -536,7 +544,8 @@ FAR const struct nx_font_s *nxf_getfontset(NXHANDLE handle);
  *
  ****************************************************************************/
 
-FAR const struct nx_fontbitmap_s *nxf_getbitmap(NXHANDLE handle, uint16_t ch);
+FAR const struct nx_fontbitmap_s *nxf_getbitmap(NXHANDLE handle,
+                                                nxf_code_t ch);
 
 /****************************************************************************
  * Name: nxf_convert_*bpp
@@ -659,7 +668,9 @@ NXHANDLE nxf_cache_getfonthandle(FCACHE fhandle);
  * Description:
  *   Get the font glyph for the character code 'ch' from the font cache.  If
  *   the glyph for that character code does not exist in the font cache, it
- *   be rendered.
+ *   be rendered.  Once the cache is full, the least recently used glyph is
+ *   freed to make room, so the returned glyph is only valid until enough
+ *   other glyphs have been requested to push it out of the cache.
  *
  * Returned Value:
  *   On success, a non-NULL pointer to the rendered glyph in the font cache
@@ -667,7 +678,44 @@ NXHANDLE nxf_cache_getfonthandle(FCACHE fhandle);
  *
  ****************************************************************************/
 
-FAR const struct nxfonts_glyph_s *nxf_cache_getglyph(FCACHE fhandle, uint8_t ch);
+FAR const struct nxfonts_glyph_s *nxf_cache_getglyph(FCACHE fhandle,
+                                                     nxf_code_t ch);
+
+/****************************************************************************
+ * Name: nxf_cache_renderrun
+ *
+ * Description:
+ *   Compose a run of characters into a caller-provided bitmap so that a
+ *   whole line of text can be drawn with a single bitmap operation.  Each
+ *   character is placed immediately to the right of the previous one,
+ *   starting at column 'xpos'.  The glyphs are taken from the font cache
+ *   (and rendered into the cache if necessary).  Character codes with no
+ *   glyph are drawn as spaces 'spwidth' pixels wide.  Any part of the
+ *   'height' rows spanned by the run that is not covered by a glyph is
+ *   set to the background color of the font cache.
+ *
+ * Input Parameters:
+ *   fhandle - A font cache handle previously returned by nxf_cache_connect();
+ *   dest    - The bitmap memory that will receive the run
+ *   height  - The height of the bitmap in rows
+ *   stride  - The width of one row of the bitmap in bytes
+ *   xpos    - The column in 'dest' where the first character is placed
+ *   codes   - The character codes to be composed
+ *   nchars  - The number of character codes in 'codes'
+ *   spwidth - The width of a space in pixels
+ *
+ * Returned Value:
+ *   On success, the column following the last character of the run is
+ *   returned.  A negated errno value is returned on failure:  -E2BIG
+ *   means that the run would extend beyond the end of the bitmap rows;
+ *   nothing past the last character that fits will have been modified.
+ *
+ ****************************************************************************/
+
+int nxf_cache_renderrun(FCACHE fhandle, FAR void *dest, nxgl_coord_t height,
+                        unsigned int stride, nxgl_coord_t xpos,
+                        FAR const nxf_code_t *codes, unsigned int nchars,
+                        nxgl_coord_t spwidth);
 
 #undef EXTERN
 #if defined(__cplusplus)
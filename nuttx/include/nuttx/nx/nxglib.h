@@ -422,6 +422,60 @@ void nxgl_copyrectangle_32bpp(FAR NX_PLANEINFOTYPE *pinfo,
                               FAR const struct nxgl_point_s *origin,
                               unsigned int srcstride);
 
+/****************************************************************************
+ * Name: nxgl_blendrectangle_*bpp
+ *
+ * Descripton:
+ *   Blend a rectangular bitmap image over the specific position in the
+ *   graphics memory with a constant opacity, from 0 (transparent) to 255
+ *   (opaque).  Only the RGB formats can be blended.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NX_BLEND
+void nxgl_blendrectangle_16bpp(FAR NX_PLANEINFOTYPE *pinfo,
+                               FAR const struct nxgl_rect_s *dest,
+                               FAR const void *src,
+                               FAR const struct nxgl_point_s *origin,
+                               unsigned int srcstride, uint8_t alpha);
+void nxgl_blendrectangle_24bpp(FAR NX_PLANEINFOTYPE *pinfo,
+                               FAR const struct nxgl_rect_s *dest,
+                               FAR const void *src,
+                               FAR const struct nxgl_point_s *origin,
+                               unsigned int srcstride, uint8_t alpha);
+void nxgl_blendrectangle_32bpp(FAR NX_PLANEINFOTYPE *pinfo,
+                               FAR const struct nxgl_rect_s *dest,
+                               FAR const void *src,
+                               FAR const struct nxgl_point_s *origin,
+                               unsigned int srcstride, uint8_t alpha);
+
+/****************************************************************************
+ * Name: nxgl_fillmask_*bpp
+ *
+ * Descripton:
+ *   Draw a color through a rectangular 8-bit coverage mask, one byte per
+ *   pixel, at the specific position in the graphics memory.  This renders
+ *   anti-aliased glyphs and shape edges.
+ *
+ ****************************************************************************/
+
+void nxgl_fillmask_16bpp(FAR NX_PLANEINFOTYPE *pinfo,
+                         FAR const struct nxgl_rect_s *dest,
+                         FAR const uint8_t *mask,
+                         FAR const struct nxgl_point_s *origin,
+                         unsigned int maskstride, nxgl_mxpixel_t color);
+void nxgl_fillmask_24bpp(FAR NX_PLANEINFOTYPE *pinfo,
+                         FAR const struct nxgl_rect_s *dest,
+                         FAR const uint8_t *mask,
+                         FAR const struct nxgl_point_s *origin,
+                         unsigned int maskstride, nxgl_mxpixel_t color);
+void nxgl_fillmask_32bpp(FAR NX_PLANEINFOTYPE *pinfo,
+                         FAR const struct nxgl_rect_s *dest,
+                         FAR const uint8_t *mask,
+                         FAR const struct nxgl_point_s *origin,
+                         unsigned int maskstride, nxgl_mxpixel_t color);
+#endif
+
 /****************************************************************************
  * Name: nxgl_rectcopy
  *
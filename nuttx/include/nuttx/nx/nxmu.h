@@ -157,6 +157,8 @@ enum nxmsg_e
   NX_SVRMSG_FILLTRAP,         /* Fill a trapezoidal region in the window with a color */
   NX_SVRMSG_MOVE,             /* Move a rectangular region within the window */
   NX_SVRMSG_BITMAP,           /* Copy a rectangular bitmap into the window */
+  NX_SVRMSG_BLENDBITMAP,      /* Blend a rectangular bitmap over the window */
+  NX_SVRMSG_FILLMASK,         /* Draw a color through a coverage mask */
   NX_SVRMSG_SETBGCOLOR,       /* Set the color of the background */
   NX_SVRMSG_MOUSEIN,          /* New mouse report from mouse client */
   NX_SVRMSG_KBDIN,            /* New keyboard report from keyboard client */
@@ -412,6 +414,36 @@ struct nxsvrmsg_bitmap_s
   sem_t *sem_done;                /* Semaphore to report when command is done. */
 };
 
+#ifdef CONFIG_NX_BLEND
+/* Blend a rectangular bitmap over the window */
+
+struct nxsvrmsg_blendbitmap_s
+{
+  uint32_t msgid;                 /* NX_SVRMSG_BLENDBITMAP */
+  FAR struct nxbe_window_s *wnd;  /* The window with will receive the bitmap image  */
+  struct nxgl_rect_s dest;        /* Destination location of the bitmap in the window */
+  FAR const void *src[CONFIG_NX_NPLANES]; /* The start of the source image. */
+  struct nxgl_point_s origin;     /* Offset into the source image data */
+  unsigned int stride;            /* The width of the full source image in bytes. */
+  uint8_t alpha;                  /* Opacity of the image: 0 (transparent)-255 (opaque) */
+  sem_t *sem_done;                /* Semaphore to report when command is done. */
+};
+
+/* Draw a color into the window through an 8-bit coverage mask */
+
+struct nxsvrmsg_fillmask_s
+{
+  uint32_t msgid;                 /* NX_SVRMSG_FILLMASK */
+  FAR struct nxbe_window_s *wnd;  /* The window with will receive the color */
+  struct nxgl_rect_s dest;        /* Destination location of the mask in the window */
+  FAR const uint8_t *mask;        /* The start of the mask, one byte per pixel */
+  struct nxgl_point_s origin;     /* Offset into the mask data */
+  unsigned int stride;            /* The width of the full mask in bytes. */
+  nxgl_mxpixel_t color[CONFIG_NX_NPLANES]; /* Color to draw */
+  sem_t *sem_done;                /* Semaphore to report when command is done. */
+};
+#endif
+
 /* Set the color of the background */
 
 struct nxsvrmsg_setbgcolor_s
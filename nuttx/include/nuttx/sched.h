@@ -151,6 +151,7 @@
 #  define TCB_FLAG_SCHED_OTHER     (3 << TCB_FLAG_POLICY_SHIFT) /* Other scheding policy */
 #define TCB_FLAG_CPU_LOCKED        (1 << 7) /* Bit 7: Locked to this CPU */
 #define TCB_FLAG_EXIT_PROCESSING   (1 << 8) /* Bit 8: Exitting */
+#define TCB_FLAG_WAKEUP            (1 << 9) /* Bit 9: Wakeup latency pending */
                                             /* Bits 9-15: Available */
 
 /* Values for struct task_group tg_flags */
@@ -580,7 +581,7 @@ struct tcb_s
 #endif
   uint16_t flags;                        /* Misc. general status flags          */
   int16_t  lockcount;                    /* 0=preemptable (not-locked)          */
-#ifdef CONFIG_SMP
+#if defined(CONFIG_SMP) || defined(CONFIG_SCHED_CRITMONITOR)
   int16_t  irqcount;                     /* 0=interrupts enabled                */
 #endif
 #ifdef CONFIG_CANCELLATION_POINTS
@@ -597,6 +598,24 @@ struct tcb_s
 
   FAR struct wdog_s *waitdog;            /* All timed waits use this timer      */
 
+  /* Timing Statistics (see up_perf_gettime()) **********************************/
+
+#ifdef CONFIG_SCHED_RUNTIME
+  uint32_t run_start;                    /* Time when last resumed              */
+  uint32_t run_count;                    /* Number of times resumed             */
+  uint64_t run_time;                     /* Total time spent running            */
+#endif
+#ifdef CONFIG_SCHED_LATENCY
+  uint32_t wake_time;                    /* Time when made ready-to-run         */
+  uint32_t lat_max;                      /* Longest wakeup latency              */
+  uint32_t lat_hist[CONFIG_SCHED_LATENCY_NBUCKETS]; /* Latency histogram (usec) */
+#endif
+#ifdef CONFIG_SCHED_CRITMONITOR
+  uint32_t crit_start;                   /* Time when interrupts were disabled  */
+  uint32_t crit_max;                     /* Longest time with interrupts off    */
+  uint64_t crit_time;                    /* Total time with interrupts off      */
+#endif
+
   /* Stack-Related Fields *******************************************************/
 
   size_t    adj_stack_size;              /* Stack size after adjustment         */
@@ -849,7 +868,7 @@ void task_vforkabort(FAR struct task_tcb_s *child, int errcode);
  ********************************************************************************/
 
 #if CONFIG_RR_INTERVAL > 0 || defined(CONFIG_SCHED_SPORADIC) || \
-    defined(CONFIG_SCHED_INSTRUMENTATION)
+    defined(CONFIG_SCHED_INSTRUMENTATION) || defined(CONFIG_SCHED_TIMESTATS)
 void sched_resume_scheduler(FAR struct tcb_s *tcb);
 #else
 #  define sched_resume_scheduler(tcb)
@@ -871,7 +890,8 @@ void sched_resume_scheduler(FAR struct tcb_s *tcb);
  *
  ********************************************************************************/
 
-#if defined(CONFIG_SCHED_SPORADIC) || defined(CONFIG_SCHED_INSTRUMENTATION)
+#if defined(CONFIG_SCHED_SPORADIC) || defined(CONFIG_SCHED_INSTRUMENTATION) || \
+    defined(CONFIG_SCHED_TIMESTATS)
 void sched_suspend_scheduler(FAR struct tcb_s *tcb);
 #else
 #  define sched_suspend_scheduler(tcb)
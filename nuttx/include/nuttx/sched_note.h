@@ -47,6 +47,7 @@
 #include <stdbool.h>
 
 #include <nuttx/sched.h>
+#include <nuttx/fs/ioctl.h>
 
 #ifdef CONFIG_SCHED_INSTRUMENTATION
 
@@ -66,6 +67,17 @@
 #  define CONFIG_SCHED_NOTE_BUFSIZE 2048
 #endif
 
+/* IOCTL Commands ***********************************************************/
+/* NOTEIOC_GETDROPPED
+ *   Description: Return the number of notes that were lost because the
+ *                note buffer was full (total for all CPUs) and reset the
+ *                count.
+ *   Argument:    A reference to an unsigned long to receive the count
+ *   Return:      Zero (OK) on success.
+ */
+
+#define NOTEIOC_GETDROPPED _NOTEIOC(0x0001)
+
 /****************************************************************************
  * Public Types
  ****************************************************************************/
@@ -119,7 +131,12 @@ struct note_common_s
   uint8_t nc_cpu;              /* CPU thread/task running on */
 #endif
   uint8_t nc_pid[2];           /* ID of the thread/task */
+#ifdef CONFIG_SCHED_INSTRUMENTATION_HIRES
+  uint8_t nc_systime_sec[4];   /* Time when note was buffered (sec) */
+  uint8_t nc_systime_nsec[4];  /* Time when note was buffered (nsec) */
+#else
   uint8_t nc_systime[4];       /* Time when note was buffered */
+#endif
 };
 
 /* This is the specific form of the NOTE_START note */
@@ -348,6 +365,25 @@ ssize_t sched_note_get(FAR uint8_t *buffer, size_t buflen);
 ssize_t sched_note_size(void);
 #endif
 
+/****************************************************************************
+ * Name: sched_note_dropped
+ *
+ * Description:
+ *   Return the number of notes that were lost because the circular buffer
+ *   was full.  In SMP configurations, this is the total for all CPUs.
+ *
+ * Input Parameters:
+ *   reset - True: Reset the counts after they have been read
+ *
+ * Returned Value:
+ *   The number of notes that were lost.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_INSTRUMENTATION_BUFFER
+unsigned long sched_note_dropped(bool reset);
+#endif
+
 /****************************************************************************
  * Name: note_register
  *
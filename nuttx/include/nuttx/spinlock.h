@@ -58,6 +58,7 @@
  */
 
 #include <arch/spinlock.h>
+#endif /* CONFIG_SPINLOCK */
 
 /****************************************************************************
  * Pre-processor Definitions
@@ -67,6 +68,9 @@
  *
  *   DMB - Data memory barrier.  Assures writes are completed to memory.
  *   DSB - Data syncrhonization barrier.
+ *
+ * These are defined (possibly as no-ops) even if CONFIG_SPINLOCK is not
+ * selected, so that lock-free logic may use them in any configuration.
  */
 
 #undef __SP_UNLOCK_FUNCTION
@@ -80,6 +84,8 @@
 #  define SP_DSB()
 #endif
 
+#ifdef CONFIG_SPINLOCK
+
 #if defined(CONFIG_SCHED_INSTRUMENTATION_SPINLOCKS) && !defined(__SP_UNLOCK_FUNCTION)
 #  define __SP_UNLOCK_FUNCTION 1
 #endif
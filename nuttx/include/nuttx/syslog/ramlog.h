@@ -54,6 +54,9 @@
  ****************************************************************************/
 
 #include <nuttx/config.h>
+
+#include <stdarg.h>
+
 #include <nuttx/syslog/syslog.h>
 
 #ifdef CONFIG_RAMLOG
@@ -77,6 +80,11 @@
  *   used to generate debug output from interrupt level handlers.
  * CONFIG_RAMLOG_NPOLLWAITERS - The number of threads than can be waiting
  *   for this driver on poll().  Default: 4
+ * CONFIG_RAMLOG_BINARY - Save syslog() output as binary records (format
+ *   string pointer plus argument values) in per-CPU buffers and format the
+ *   records only when the RAM log is read.  Requires CONFIG_RAMLOG_SYSLOG.
+ * CONFIG_RAMLOG_BINARY_RECSIZE - The maximum size of one binary record.
+ *   Default: 128
  *
  * If CONFIG_RAMLOG_CONSOLE or CONFIG_RAMLOG_SYSLOG is selected, then the
  * following may also be provided:
@@ -190,6 +198,29 @@ int ramlog_syslog_channel(void);
 int ramlog_putc(int ch);
 #endif
 
+/****************************************************************************
+ * Name: ramlog_vsyslog
+ *
+ * Description:
+ *   Add a binary record to the RAM log consisting of the format string
+ *   pointer and the values of the arguments.  Formatting is deferred until
+ *   the RAM log is read so the format string must remain valid (normally it
+ *   is a string constant).  String arguments are copied into the record.
+ *   This is called from _vsyslog() when CONFIG_RAMLOG_BINARY is selected.
+ *
+ * Input Parameters:
+ *   fmt - The printf-style format string
+ *   ap  - The arguments
+ *
+ * Returned Value:
+ *   The size of the binary record.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_RAMLOG_BINARY
+int ramlog_vsyslog(FAR const IPTR char *fmt, va_list ap);
+#endif
+
 #undef EXTERN
 #ifdef __cplusplus
 }
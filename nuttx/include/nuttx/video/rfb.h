@@ -923,25 +923,25 @@ struct rfb_srle_s
  *  indicate a palette of that size. The possible values of subencoding are:"
  */
 
-#define RFB_SUBENCODING_RAW      0   /* Raw pixel data */
-#define RFB_SUBENCODING_SOLID    1   /* A solid tile of a single color */
-#define RFB_SUBENCODING_PACKED1  2   /* Packed palette types */
-#define RFB_SUBENCODING_PACKED2  3
-#define RFB_SUBENCODING_PACKED3  4
-#define RFB_SUBENCODING_PACKED4  5
-#define RFB_SUBENCODING_PACKED5  6
-#define RFB_SUBENCODING_PACKED6  7
-#define RFB_SUBENCODING_PACKED7  8
-#define RFB_SUBENCODING_PACKED8  9
-#define RFB_SUBENCODING_PACKED9  10
-#define RFB_SUBENCODING_PACKED10 11
-#define RFB_SUBENCODING_PACKED11 12
-#define RFB_SUBENCODING_PACKED12 13
-#define RFB_SUBENCODING_PACKED13 14
-#define RFB_SUBENCODING_PACKED14 15
-#define RFB_SUBENCODING_PACKED15 16
-#define RFB_SUBENCODING_RLE      128 /* Plain RLE */
-#define RFB_SUBENCODING_PALRLE   129 /* Palette RLE */
+#define RFB_ZRLE_RAW             0   /* Raw pixel data */
+#define RFB_ZRLE_SOLID           1   /* A solid tile of a single color */
+#define RFB_ZRLE_PACKED1         2   /* Packed palette types */
+#define RFB_ZRLE_PACKED2         3
+#define RFB_ZRLE_PACKED3         4
+#define RFB_ZRLE_PACKED4         5
+#define RFB_ZRLE_PACKED5         6
+#define RFB_ZRLE_PACKED6         7
+#define RFB_ZRLE_PACKED7         8
+#define RFB_ZRLE_PACKED8         9
+#define RFB_ZRLE_PACKED9         10
+#define RFB_ZRLE_PACKED10        11
+#define RFB_ZRLE_PACKED11        12
+#define RFB_ZRLE_PACKED12        13
+#define RFB_ZRLE_PACKED13        14
+#define RFB_ZRLE_PACKED14        15
+#define RFB_ZRLE_PACKED15        16
+#define RFB_ZRLE_RLE             128 /* Plain RLE */
+#define RFB_ZRLE_PALRLE(n)       (128 + (n)) /* Palette RLE, n = 2..127 */
 
 
 /* "Raw pixel data. width x height pixel values follow (where width and
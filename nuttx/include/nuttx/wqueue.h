@@ -44,6 +44,7 @@
 
 #include <sys/types.h>
 #include <stdint.h>
+#include <stdbool.h>
 #include <semaphore.h>
 #include <queue.h>
 
@@ -67,11 +68,6 @@
  *   is enabled, then the following options can also be used:
  * CONFIG_SCHED_HPWORKPRIORITY - The execution priority of the high-
  *   priority worker thread.  Default: 224
- * CONFIG_SCHED_HPWORKPERIOD - How often the worker thread checks for
- *   work in units of microseconds.  If the high priority worker thread is
- *   performing garbage collection, then the default is 50*1000 (50 MS).
- *   Otherwise, if the lower priority worker thread is performing garbage
- *   collection, the default is 100*1000.
  * CONFIG_SCHED_HPWORKSTACKSIZE - The stack size allocated for the worker
  *   thread.  Default: 2048.
  * CONFIG_SIG_SIGWORK - The signal number that will be used to wake-up
@@ -87,10 +83,20 @@
  *   priority worker thread.  Default: 50
  * CONFIG_SCHED_LPWORKPRIOMAX - The maximum execution priority of the lower
  *   priority worker thread.  Default: 176
- * CONFIG_SCHED_LPWORKPERIOD - How often the lower priority worker thread
- *  checks for work in units of microseconds.  Default: 50*1000 (50 MS).
  * CONFIG_SCHED_LPWORKSTACKSIZE - The stack size allocated for the lower
  *   priority worker thread.  Default: 2048.
+ * CONFIG_SCHED_LPWORKPERCPU - SMP only.  Create one low-priority work
+ *   queue per CPU, each with CONFIG_SCHED_LPNTHREADS worker threads bound
+ *   to that CPU.  Idle workers take ready work from the other CPUs'
+ *   queues unless it was queued with work_queue_cpu().
+ * CONFIG_SCHED_LPWORKFAIR - Place work queued with work_queue() on the
+ *   least loaded per-CPU queue rather than on the caller's CPU.
+ *
+ * The kernel worker threads do not poll:  They sleep until work is queued
+ * or until the earliest delayed work becomes ready.
+ *
+ * CONFIG_SCHED_WORKSTATS - Keep statistics for each kernel work queue.
+ *   These may be read with work_stats().
  *
  * The user-mode work queue is only available in the protected or kernel
  * builds.  This those configurations, the user-mode work queue provides the
@@ -150,14 +156,6 @@
 #    define CONFIG_SCHED_HPWORKPRIORITY 224
 #  endif
 
-#  ifndef CONFIG_SCHED_HPWORKPERIOD
-#    ifdef CONFIG_SCHED_LPWORK
-#      define CONFIG_SCHED_HPWORKPERIOD (100*1000) /* 100 milliseconds */
-#    else
-#      define CONFIG_SCHED_HPWORKPERIOD (50*1000)  /* 50 milliseconds */
-#    endif
-#  endif
-
 #  ifndef CONFIG_SCHED_HPWORKSTACKSIZE
 #    define CONFIG_SCHED_HPWORKSTACKSIZE CONFIG_IDLETHREAD_STACKSIZE
 #  endif
@@ -197,10 +195,6 @@
 #    error CONFIG_SCHED_LPWORKPRIORITY > CONFIG_SCHED_LPWORKPRIOMAX
 #  endif
 
-#  ifndef CONFIG_SCHED_LPWORKPERIOD
-#    define CONFIG_SCHED_LPWORKPERIOD (50*1000) /* 50 milliseconds */
-#  endif
-
 #  ifndef CONFIG_SCHED_LPWORKSTACKSIZE
 #    define CONFIG_SCHED_LPWORKSTACKSIZE CONFIG_IDLETHREAD_STACKSIZE
 #  endif
@@ -294,7 +288,30 @@ struct work_s
   FAR void *arg;         /* Callback argument */
   systime_t qtime;       /* Time work queued */
   systime_t delay;       /* Delay until work performed */
+#ifdef CONFIG_SCHED_LPWORKPERCPU
+  uint8_t   cpu;         /* The per-CPU queue holding the work */
+  bool      pinned;      /* True: Work may only run on that CPU */
+#endif
+};
+
+/* Statistics for one kernel work queue.  Latencies are measured in clock
+ * ticks from the time that the work became ready (i.e., the time that it
+ * was queued plus its delay) until the time that the worker was invoked.
+ */
+
+#if defined(CONFIG_SCHED_WORKQUEUE) && defined(CONFIG_SCHED_WORKSTATS)
+struct work_stats_s
+{
+  uint32_t  queued;      /* Number of times that work was queued */
+  uint32_t  executed;    /* Number of work items performed */
+  uint32_t  cancelled;   /* Number cancelled or re-queued while pending */
+  uint16_t  depth;       /* Number of work items now pending */
+  uint16_t  maxdepth;    /* Largest number of work items pending */
+  uint32_t  stolen;      /* Work performed by another CPU's worker */
+  systime_t maxlatency;  /* Longest latency */
+  systime_t totlatency;  /* Sum of the latencies of all work performed */
 };
+#endif
 
 /****************************************************************************
  * Public Data
@@ -363,6 +380,37 @@ int work_usrstart(void);
 int work_queue(int qid, FAR struct work_s *work, worker_t worker,
                FAR void *arg, systime_t delay);
 
+/****************************************************************************
+ * Name: work_queue_cpu
+ *
+ * Description:
+ *   Queue work to be performed on a specific CPU.  This is the same as
+ *   work_queue() except that, with CONFIG_SCHED_LPWORKPERCPU, LPWORK is
+ *   placed on the queue of the selected CPU and will be performed only by
+ *   the worker threads of that CPU.  Otherwise the work queues are not
+ *   CPU-specific and the cpu argument is only checked.
+ *
+ * Input parameters:
+ *   qid    - The work queue ID
+ *   cpu    - The CPU that will perform the work
+ *   work   - The work structure to queue
+ *   worker - The worker callback to be invoked.  The callback will invoked
+ *            on the worker thread of execution.
+ *   arg    - The argument that will be passed to the worker callback when
+ *            it is invoked.
+ *   delay  - Delay (in clock ticks) from the time queue until the worker
+ *            is invoked. Zero means to perform the work immediately.
+ *
+ * Returned Value:
+ *   Zero on success, a negated errno on failure
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_WORKQUEUE
+int work_queue_cpu(int qid, int cpu, FAR struct work_s *work,
+                   worker_t worker, FAR void *arg, systime_t delay);
+#endif
+
 /****************************************************************************
  * Name: work_cancel
  *
@@ -403,6 +451,30 @@ int work_cancel(int qid, FAR struct work_s *work);
 
 int work_signal(int qid);
 
+/****************************************************************************
+ * Name: work_stats
+ *
+ * Description:
+ *   Return a snapshot of the statistics of a kernel work queue.  With
+ *   CONFIG_SCHED_LPWORKPERCPU, the LPWORK statistics are the sums over all
+ *   of the per-CPU queues, except that maxdepth and maxlatency are the
+ *   largest values of any one queue.
+ *
+ * Input parameters:
+ *   qid   - The work queue ID (must be HPWORK or LPWORK)
+ *   stats - The location to return the statistics
+ *
+ * Returned Value:
+ *   Zero on success, a negated errno on failure
+ *
+ *   -EINVAL - An invalid work queue was specified
+ *
+ ****************************************************************************/
+
+#if defined(CONFIG_SCHED_WORKQUEUE) && defined(CONFIG_SCHED_WORKSTATS)
+int work_stats(int qid, FAR struct work_stats_s *stats);
+#endif
+
 /****************************************************************************
  * Name: work_available
  *
@@ -281,7 +281,8 @@
 #    define SYS_aio_write              (__SYS_descriptors+7)
 #    define SYS_aio_fsync              (__SYS_descriptors+8)
 #    define SYS_aio_cancel             (__SYS_descriptors+9)
-#    define __SYS_poll                 (__SYS_descriptors+10)
+#    define SYS_aio_submit             (__SYS_descriptors+10)
+#    define __SYS_poll                 (__SYS_descriptors+11)
 #  else
 #    define __SYS_poll                 (__SYS_descriptors+6)
 #  endif
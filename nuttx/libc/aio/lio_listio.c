@@ -535,8 +535,8 @@ int lio_listio(int mode, FAR struct aiocb *const list[], int nent,
                FAR struct sigevent *sig)
 {
   FAR struct aiocb *aiocbp;
+  int nrequests;
   int nqueued;
-  int errcode;
   int retcode;
   int status;
   int ret;
@@ -545,6 +545,7 @@ int lio_listio(int mode, FAR struct aiocb *const list[], int nent,
   DEBUGASSERT(mode == LIO_WAIT || mode == LIO_NOWAIT);
   DEBUGASSERT(list);
 
+  nrequests = 0;  /* No read or write operations yet found */
   nqueued = 0;    /* No I/O operations yet queued */
   ret     = OK;   /* Assume success */
 
@@ -555,8 +556,8 @@ int lio_listio(int mode, FAR struct aiocb *const list[], int nent,
 
   sched_lock();
 
-  /* Submit each asynchronous I/O operation in the list, skipping over NULL
-   * entries.
+  /* Complete the LIO_NOP and invalid operations in the list, skipping over
+   * NULL entries, and count the read and write operations.
    */
 
   for (i = 0; i < nent; i++)
@@ -566,9 +567,6 @@ int lio_listio(int mode, FAR struct aiocb *const list[], int nent,
       aiocbp = list[i];
       if (aiocbp)
         {
-          /* Submit the operation according to its opcode */
-
-          status = OK;
           switch (aiocbp->aio_lio_opcode)
             {
             case LIO_NOP:
@@ -582,35 +580,9 @@ int lio_listio(int mode, FAR struct aiocb *const list[], int nent,
             case LIO_READ:
             case LIO_WRITE:
               {
-                if (aiocbp->aio_lio_opcode == LIO_READ)
-                  {
-                    /* Submit the asynchronous read operation */
-
-                    status = aio_read(aiocbp);
-                  }
-                else
-                  {
-                    /* Submit the asynchronous write operation */
-
-                    status = aio_write(aiocbp);
-                  }
-
-                if (status < 0)
-                  {
-                    /* Failed to queue the I/O.  Set up the error return. */
-
-                    errcode = get_errno();
-                    ferr("ERROR: aio_read/write failed: %d\n", errcode);
-                    DEBUGASSERT(errcode > 0);
-                    aiocbp->aio_result = -errcode;
-                    ret = ERROR;
-                  }
-                else
-                  {
-                    /* Increment the count of successfully queue operations */
-
-                    nqueued++;
-                  }
+                /* Count the operations to be submitted */
+
+                nrequests++;
               }
               break;
 
@@ -627,6 +599,32 @@ int lio_listio(int mode, FAR struct aiocb *const list[], int nent,
         }
     }
 
+  /* Submit all of the read and write operations as a single batch */
+
+  if (nrequests > 0)
+    {
+      status = aio_submit(list, nent, NULL);
+      if (status < 0)
+        {
+          ferr("ERROR: aio_submit failed: %d\n", get_errno());
+          ret = ERROR;
+        }
+      else
+        {
+          nqueued = status;
+          if (nqueued < nrequests)
+            {
+              /* Failed to queue some of the I/O.  aio_submit() has set
+               * the error result of each.
+               */
+
+              ferr("ERROR: %d of %d operations not queued\n",
+                   nrequests - nqueued, nrequests);
+              ret = ERROR;
+            }
+        }
+    }
+
   /* If there was any failure in queuing the I/O, EIO will be returned */
 
   retcode = EIO;
@@ -39,6 +39,8 @@
 
 #include <nuttx/config.h>
 
+#include <stdint.h>
+#include <stdbool.h>
 #include <string.h>
 #include <semaphore.h>
 #include <assert.h>
@@ -49,6 +51,17 @@
 
 #include "nxcontext.h"
 
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* Map a character code to a hash bucket.  Folding in the upper bytes keeps
+ * codes from different 256-character blocks from piling up in the same
+ * buckets.
+ */
+
+#define NXF_HASH(p,ch) ((((ch) >> 16) ^ ((ch) >> 8) ^ (ch)) & (p)->hashmask)
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -69,17 +82,22 @@ struct nxfonts_fcache_s
   sem_t fsem;                          /* Serializes access to the font cache */
   uint16_t fontid;                     /* ID of font in this cache */
   int16_t fclients;                    /* Number of connected clients */
-  uint8_t maxglyphs;                   /* Maximum size of glyph[] array */
-  uint8_t nglyphs;                     /* Current size of glyph[] array */
+  uint16_t maxglyphs;                  /* Maximum number of cached glyphs */
+  uint16_t nglyphs;                    /* Current number of cached glyphs */
+  uint16_t hashmask;                   /* Number of hash buckets minus one */
   uint8_t bpp;                         /* Bits per pixel */
   nxgl_mxpixel_t fgcolor;              /* Foreground color */
   nxgl_mxpixel_t bgcolor;              /* Background color */
   nxf_renderer_t renderer;             /* Font renderer */
 
-  /* Glyph cache data storage */
+  /* Glyph cache data storage.  Each glyph is in one hash bucket list and
+   * in the LRU list, which runs from the most recently used glyph at the
+   * head to the least recently used glyph at the tail.
+   */
 
-  FAR struct nxfonts_glyph_s *head;    /* Head of the list of glyphs */
-  FAR struct nxfonts_glyph_s *tail;    /* Tail of the list of glyphs */
+  FAR struct nxfonts_glyph_s **hash;   /* Hash buckets, hashmask + 1 of them */
+  FAR struct nxfonts_glyph_s *head;    /* Head of the LRU list of glyphs */
+  FAR struct nxfonts_glyph_s *tail;    /* Tail of the LRU list of glyphs */
 };
 
 /****************************************************************************
@@ -174,58 +192,146 @@ static void nxf_cache_lock(FAR struct nxfonts_fcache_s *priv)
     }
 }
 
-#define nxf_cache_unlock(p) (sem_post(&priv->fsem))
+#define nxf_cache_unlock(p) (sem_post(&(p)->fsem))
 
 /****************************************************************************
- * Name: nxf_removeglyph
+ * Name: nxf_rehash
  *
  * Description:
- *   Removes the entry 'glyph' from the font cache.
+ *   (Re-)allocate the hash table so that it has at least one bucket per
+ *   glyph for a cache of 'maxglyphs' glyphs, then move any cached glyphs
+ *   into the new buckets.
+ *
+ * Returned Value:
+ *   Zero (OK) on success; -ENOMEM if the new table could not be allocated.
+ *   The old hash table is retained in that case.
  *
  ****************************************************************************/
 
-static inline void nxf_removeglyph(FAR struct nxfonts_fcache_s *priv,
-                                   FAR struct nxfonts_glyph_s *glyph,
-                                   FAR struct nxfonts_glyph_s *prev)
+static int nxf_rehash(FAR struct nxfonts_fcache_s *priv, int maxglyphs)
 {
-  ginfo("fcache=%p glyph=%p\n", priv, glyph);
+  FAR struct nxfonts_glyph_s **hash;
+  FAR struct nxfonts_glyph_s *glyph;
+  unsigned int nbuckets;
+  unsigned int ndx;
 
-  /* Remove the glyph for the list.  First check for removal from the head
-   * (which, I think, never actually happens).
-   */
+  /* The number of buckets is the next power of two */
 
-  if (prev == NULL)
+  for (nbuckets = 1; nbuckets < (unsigned int)maxglyphs; nbuckets <<= 1);
+
+  if (priv->hash != NULL && nbuckets <= (unsigned int)priv->hashmask + 1)
     {
-      /* Replace the head with the node following glyph */
+      return OK;
+    }
 
-      priv->head = glyph->flink;
+  hash = (FAR struct nxfonts_glyph_s **)
+    lib_zalloc(nbuckets * sizeof(FAR struct nxfonts_glyph_s *));
 
-      /* If there is no node following glyph, then the list is empty */
+  if (hash == NULL)
+    {
+      return -ENOMEM;
+    }
 
-      if (priv->head == NULL)
-        {
-          priv->tail = NULL;
-        }
+  if (priv->hash != NULL)
+    {
+      lib_free(priv->hash);
     }
 
-  /* Check for removal from the tail (we know that the list cannot become
-   * empty in either of the next two cases).
-   */
+  priv->hash     = hash;
+  priv->hashmask = nbuckets - 1;
+
+  /* Re-enter every cached glyph in the new buckets */
+
+  for (glyph = priv->head; glyph != NULL; glyph = glyph->flink)
+    {
+      ndx          = NXF_HASH(priv, glyph->code);
+      glyph->hlink = hash[ndx];
+      hash[ndx]    = glyph;
+    }
+
+  return OK;
+}
+
+/****************************************************************************
+ * Name: nxf_unlinkglyph and nxf_linkglyph
+ *
+ * Description:
+ *   Remove the entry 'glyph' from the LRU list or add it to the head of
+ *   the LRU list (making it the most recently used glyph).
+ *
+ ****************************************************************************/
+
+static inline void nxf_unlinkglyph(FAR struct nxfonts_fcache_s *priv,
+                                   FAR struct nxfonts_glyph_s *glyph)
+{
+  if (glyph->blink == NULL)
+    {
+      priv->head = glyph->flink;
+    }
+  else
+    {
+      glyph->blink->flink = glyph->flink;
+    }
 
-  else if (glyph->flink == NULL)
+  if (glyph->flink == NULL)
     {
-      priv->tail = prev;
-      prev->flink = NULL;
+      priv->tail = glyph->blink;
     }
+  else
+    {
+      glyph->flink->blink = glyph->blink;
+    }
+}
 
-  /* No.. Remove from mid-list */
+static inline void nxf_linkglyph(FAR struct nxfonts_fcache_s *priv,
+                                 FAR struct nxfonts_glyph_s *glyph)
+{
+  glyph->blink = NULL;
+  glyph->flink = priv->head;
 
+  if (priv->head == NULL)
+    {
+      priv->tail = glyph;
+    }
   else
     {
-      prev->flink = glyph->flink;
+      priv->head->blink = glyph;
     }
 
-  glyph->flink = NULL;
+  priv->head = glyph;
+}
+
+/****************************************************************************
+ * Name: nxf_removeglyph
+ *
+ * Description:
+ *   Removes the entry 'glyph' from the font cache.
+ *
+ ****************************************************************************/
+
+static inline void nxf_removeglyph(FAR struct nxfonts_fcache_s *priv,
+                                   FAR struct nxfonts_glyph_s *glyph)
+{
+  FAR struct nxfonts_glyph_s **link;
+
+  ginfo("fcache=%p glyph=%p\n", priv, glyph);
+
+  /* Remove the glyph from its hash bucket.  Buckets hold about one glyph
+   * each, so this walk is short.
+   */
+
+  for (link = &priv->hash[NXF_HASH(priv, glyph->code)];
+       *link != glyph;
+       link = &(*link)->hlink)
+    {
+      DEBUGASSERT(*link != NULL);
+    }
+
+  *link = glyph->hlink;
+
+  /* And from the LRU list */
+
+  nxf_unlinkglyph(priv, glyph);
 
   /* Decrement the count of glyphs in the font cache */
 
@@ -237,25 +343,23 @@ static inline void nxf_removeglyph(FAR struct nxfonts_fcache_s *priv,
  * Name: nxf_addglyph
  *
  * Description:
- *   Add the entry 'glyph' to the head font cache list.
+ *   Add the entry 'glyph' to its hash bucket and to the head of the LRU
+ *   list.
  *
  ****************************************************************************/
 
 static inline void nxf_addglyph(FAR struct nxfonts_fcache_s *priv,
                                 FAR struct nxfonts_glyph_s *glyph)
 {
-  ginfo("fcache=%p glyph=%p\n", priv, glyph);
-
-  /* Add the glyph to the head of the list */
+  unsigned int ndx;
 
-  glyph->flink = priv->head;
+  ginfo("fcache=%p glyph=%p\n", priv, glyph);
 
-  if (priv->head == NULL)
-    {
-      priv->tail = glyph;
-    }
+  ndx              = NXF_HASH(priv, glyph->code);
+  glyph->hlink     = priv->hash[ndx];
+  priv->hash[ndx]  = glyph;
 
-  priv->head = glyph;
+  nxf_linkglyph(priv, glyph);
 
   /* Increment the count of glyphs in the font cache. */
 
@@ -267,18 +371,10 @@ static inline void nxf_addglyph(FAR struct nxfonts_fcache_s *priv,
  * Name: nxf_findglyph
  *
  * Description:
- *   Find the glyph for the specific character 'ch' in the list of pre-
- *   rendered fonts in the font cache.
- *
- *   This is logically a part of nxf_cache_getglyph().  nxf_cache_getglyph()
- *   will attempt to find the cached glyph before rendering a new one.  So
- *   this function has two unexpected side-effects:  (1) If the font cache
- *   is full and the font is not found, then the least-recently-used glyph
- *   is deleted to make space for the new glyph that will be allocated.
- *
- *   (2) If the glyph is found, then it is moved to the head of the list of
- *   glyphs since it is now the most recently used (leaving the least
- *   recently used glyph at the tail of the list).
+ *   Find the glyph for the specific character 'ch' in the hash table of
+ *   pre-rendered glyphs in the font cache.  If the glyph is found, then it
+ *   is moved to the head of the LRU list since it is now the most recently
+ *   used (leaving the least recently used glyph at the tail of the list).
  *
  * Assumptions:
  *   The caller has exclusive access to the font cache.
@@ -286,147 +382,125 @@ static inline void nxf_addglyph(FAR struct nxfonts_fcache_s *priv,
  ****************************************************************************/
 
 static FAR struct nxfonts_glyph_s *
-nxf_findglyph(FAR struct nxfonts_fcache_s *priv, uint8_t ch)
+nxf_findglyph(FAR struct nxfonts_fcache_s *priv, nxf_code_t ch)
 {
   FAR struct nxfonts_glyph_s *glyph;
-  FAR struct nxfonts_glyph_s *prev;
 
-  ginfo("fcache=%p ch=%c (%02x)\n",
-        priv, (ch >= 32 && ch < 128) ? ch : '.', ch);
+  ginfo("fcache=%p ch=%c (%04lx)\n",
+        priv, (ch >= 32 && ch < 128) ? (int)ch : '.', (unsigned long)ch);
 
-  /* Try to find the glyph in the list of pre-rendered glyphs */
-
-   for (prev = NULL, glyph = priv->head;
-        glyph != NULL;
-        prev = glyph, glyph = glyph->flink)
+  for (glyph = priv->hash[NXF_HASH(priv, ch)];
+       glyph != NULL;
+       glyph = glyph->hlink)
     {
-      /* Check if we found the glyph for this character */
-
       if (glyph->code == ch)
         {
-          /* This is now the most recently used glyph.  Move it to the head
-           * of the list (if it is not already at the head of the list).
-           */
+          /* This is now the most recently used glyph */
 
-          if (prev != NULL)
+          if (glyph != priv->head)
             {
-              nxf_removeglyph(priv, glyph, prev);
-              nxf_addglyph(priv, glyph);
+              nxf_unlinkglyph(priv, glyph);
+              nxf_linkglyph(priv, glyph);
             }
 
-          /* And return the glyph that we found */
-
           return glyph;
         }
-
-      /* Is this the last glyph in the list?  Has the cache reached its
-       * limit for the number of cached fonts?
-       */
-
-      if (glyph->flink == NULL && priv->nglyphs >= priv->maxglyphs)
-        {
-          /* Yes.. then remove it from the list and free the glyph memory.
-           * We do this because we have all of the information in hand now
-           * and we will surely need to have this space later.
-           */
-
-          nxf_removeglyph(priv, glyph, prev);
-          return NULL;
-        }
     }
 
   return NULL;
 }
 
 /****************************************************************************
- * Name: nxf_fillglyph
+ * Name: nxf_pixelshift, nxf_setpixel, and nxf_getpixel
  *
  * Description:
- *   Fill the glyph memory with the background color
+ *   Access one pixel in a row of a bitmap with a pixel depth of less than
+ *   eight bits.
  *
  ****************************************************************************/
 
-static inline void nxf_fillglyph(FAR struct nxfonts_fcache_s *priv,
-                                 FAR struct nxfonts_glyph_s *glyph)
-{
-  int row;
-  int col;
-
-  /* Initialize the glyph memory to the background color. */
-
 #if !defined(CONFIG_NX_DISABLE_1BPP) || !defined(CONFIG_NX_DISABLE_2BPP) || \
-    !defined(CONFIG_NX_DISABLE_4BPP) || !defined(CONFIG_NX_DISABLE_8BPP)
-
-  /* For pixel depths of 1, 2, 4, and 8, build up an 8-bit value containing
-   * multiple background colored pixels.
-   */
+    !defined(CONFIG_NX_DISABLE_4BPP)
+static inline unsigned int nxf_pixelshift(unsigned int bit, uint8_t bpp)
+{
+#ifdef CONFIG_NX_PACKEDMSFIRST
+  return 8 - bpp - (bit & 7);
+#else
+  return bit & 7;
+#endif
+}
 
-  if (priv->bpp <= 8)
-    {
-      uint8_t pixel = (uint8_t)priv->bgcolor;
-      FAR uint8_t *ptr;
+static inline void nxf_setpixel(FAR uint8_t *line, unsigned int col,
+                                uint8_t bpp, uint8_t pixel)
+{
+  unsigned int bit   = col * bpp;
+  unsigned int shift = nxf_pixelshift(bit, bpp);
+  uint8_t mask       = ((1 << bpp) - 1) << shift;
 
-#ifndef CONFIG_NX_DISABLE_1BPP
-      /* Pack a 1-bit pixel to 2 pixels */
+  line[bit >> 3] = (line[bit >> 3] & ~mask) | ((pixel << shift) & mask);
+}
 
-      if (priv->bpp < 2)
-        {
-          /* Pack 1-bit pixels into a 2-bits */
+static inline uint8_t nxf_getpixel(FAR const uint8_t *line, unsigned int col,
+                                   uint8_t bpp)
+{
+  unsigned int bit = col * bpp;
 
-          pixel &= 0x01;
-          pixel  = (pixel) << 1 | pixel;
-        }
+  return (line[bit >> 3] >> nxf_pixelshift(bit, bpp)) & ((1 << bpp) - 1);
+}
 #endif
 
-#if !defined(CONFIG_NX_DISABLE_1BPP) || !defined(CONFIG_NX_DISABLE_2BPP)
-      /* Pack a 2-bit pixel to a 4-bit nibble */
-
-      if (priv->bpp < 4)
-        {
-          /* Pack 2-bit pixels into a nibble */
+/****************************************************************************
+ * Name: nxf_fillrun
+ *
+ * Description:
+ *   Fill 'nrows' rows of 'width' pixels in a bitmap with the background
+ *   color, beginning at row 'row' and column 'xpos'.
+ *
+ ****************************************************************************/
 
-          pixel &= 0x03;
-          pixel  = (pixel) << 2 | pixel;
-        }
-#endif
+static void nxf_fillrun(FAR struct nxfonts_fcache_s *priv, FAR uint8_t *dest,
+                        unsigned int stride, unsigned int xpos,
+                        unsigned int width, unsigned int row,
+                        unsigned int nrows)
+{
+  FAR uint8_t *line = dest + row * stride;
+  unsigned int col;
 
 #if !defined(CONFIG_NX_DISABLE_1BPP) || !defined(CONFIG_NX_DISABLE_2BPP) || \
     !defined(CONFIG_NX_DISABLE_4BPP)
-      /* Pack the 4-bit nibble into a byte */
-
-      if (priv->bpp < 8)
+  if (priv->bpp < 8)
+    {
+      for (; nrows > 0; nrows--, line += stride)
         {
-          pixel &= 0x0f;
-          pixel  = (pixel) << 4 | pixel;
+          for (col = xpos; col < xpos + width; col++)
+            {
+              nxf_setpixel(line, col, priv->bpp, (uint8_t)priv->bgcolor);
+            }
         }
+    }
+  else
 #endif
 
-      /* Then fill the glyph with the packed background color */
-
-      ptr = (FAR uint8_t *)glyph->bitmap;
-      for (row = 0; row < glyph->height; row++)
+#ifndef CONFIG_NX_DISABLE_8BPP
+  if (priv->bpp == 8)
+    {
+      for (; nrows > 0; nrows--, line += stride)
         {
-          for (col = 0; col < glyph->stride; col++)
-            {
-              /* Transfer the packed bytes into the buffer */
-
-              *ptr++ = pixel;
-            }
+          memset(line + xpos, (uint8_t)priv->bgcolor, width);
         }
     }
   else
 #endif
 
-#if !defined(CONFIG_NX_DISABLE_16BPP)
+#ifndef CONFIG_NX_DISABLE_16BPP
   if (priv->bpp == 16)
     {
-      FAR uint16_t *ptr = (FAR uint16_t *)glyph->bitmap;
+      FAR uint16_t *ptr;
 
-      for (row = 0; row < glyph->height; row++)
+      for (; nrows > 0; nrows--, line += stride)
         {
-          /* Just copy the color value into the glyph memory */
-
-          for (col = 0; col < glyph->width; col++)
+          ptr = (FAR uint16_t *)line + xpos;
+          for (col = 0; col < width; col++)
             {
               *ptr++ = priv->bgcolor;
             }
@@ -438,55 +512,33 @@ static inline void nxf_fillglyph(FAR struct nxfonts_fcache_s *priv,
 #ifndef CONFIG_NX_DISABLE_24BPP
   if (priv->bpp == 24)
     {
-      FAR uint32_t *ptr = (FAR uint32_t *)glyph->bitmap;
-      FAR uint32_t pixel[3];
-
-      /* Get two 32-bit values for alternating 32 representations */
+      FAR uint8_t *ptr;
 
-      pixel[0] = (uint32_t)priv->bgcolor <<  8 | (uint32_t)priv->bgcolor >> 16;
-      pixel[1] = (uint32_t)priv->bgcolor << 16 | (uint32_t)priv->bgcolor >> 8;
-      pixel[1] = (uint32_t)priv->bgcolor << 24 | (uint32_t)priv->bgcolor;
+      /* 24-bit pixels are three bytes, least significant byte first */
 
-      for (row = 0; row < glyph->height; row++)
+      for (; nrows > 0; nrows--, line += stride)
         {
-          /* Copy the color value into the glyph memory */
-
-          col = 0;
-          for (; ; )
+          ptr = line + 3 * xpos;
+          for (col = 0; col < width; col++)
             {
-              *ptr++ = pixel[0];
-              if (++col >= glyph->width)
-                {
-                  break;
-                }
-
-              *ptr++ = pixel[1];
-              if (++col >= glyph->width)
-                {
-                  break;
-                }
-
-              *ptr++ = pixel[2];
-              if (++col >= glyph->width)
-                {
-                  break;
-                }
+              *ptr++ = (uint8_t)priv->bgcolor;
+              *ptr++ = (uint8_t)(priv->bgcolor >> 8);
+              *ptr++ = (uint8_t)(priv->bgcolor >> 16);
             }
         }
     }
   else
 #endif
 
-#if !defined(CONFIG_NX_DISABLE_32BPP)
+#ifndef CONFIG_NX_DISABLE_32BPP
   if (priv->bpp == 32)
     {
-      FAR uint32_t *ptr = (FAR uint32_t *)glyph->bitmap;
+      FAR uint32_t *ptr;
 
-      for (row = 0; row < glyph->height; row++)
+      for (; nrows > 0; nrows--, line += stride)
         {
-          /* Just copy the color value into the glyph memory */
-
-          for (col = 0; col < glyph->width; col++)
+          ptr = (FAR uint32_t *)line + xpos;
+          for (col = 0; col < width; col++)
             {
               *ptr++ = priv->bgcolor;
             }
@@ -499,6 +551,52 @@ static inline void nxf_fillglyph(FAR struct nxfonts_fcache_s *priv,
     }
 }
 
+/****************************************************************************
+ * Name: nxf_copyglyph
+ *
+ * Description:
+ *   Copy the first 'nrows' rows of a rendered glyph into a bitmap at column
+ *   'xpos'.
+ *
+ ****************************************************************************/
+
+static void nxf_copyglyph(FAR struct nxfonts_fcache_s *priv,
+                          FAR uint8_t *dest, unsigned int stride,
+                          unsigned int xpos,
+                          FAR const struct nxfonts_glyph_s *glyph,
+                          unsigned int nrows)
+{
+  FAR const uint8_t *src = glyph->bitmap;
+
+#if !defined(CONFIG_NX_DISABLE_1BPP) || !defined(CONFIG_NX_DISABLE_2BPP) || \
+    !defined(CONFIG_NX_DISABLE_4BPP)
+  if (priv->bpp < 8)
+    {
+      unsigned int col;
+
+      for (; nrows > 0; nrows--, dest += stride, src += glyph->stride)
+        {
+          for (col = 0; col < glyph->width; col++)
+            {
+              nxf_setpixel(dest, xpos + col, priv->bpp,
+                           nxf_getpixel(src, col, priv->bpp));
+            }
+        }
+    }
+  else
+#endif
+    {
+      unsigned int bypp = priv->bpp >> 3;
+
+      for (dest += xpos * bypp;
+           nrows > 0;
+           nrows--, dest += stride, src += glyph->stride)
+        {
+          memcpy(dest, src, glyph->width * bypp);
+        }
+    }
+}
+
 /****************************************************************************
  * Name: nxf_renderglyph
  *
@@ -513,7 +611,7 @@ static inline void nxf_fillglyph(FAR struct nxfonts_fcache_s *priv,
 
 static inline FAR struct nxfonts_glyph_s *
 nxf_renderglyph(FAR struct nxfonts_fcache_s *priv,
-                FAR const struct nx_fontbitmap_s *fbm, uint8_t ch)
+                FAR const struct nx_fontbitmap_s *fbm, nxf_code_t ch)
 {
   FAR struct nxfonts_glyph_s *glyph = NULL;
   size_t bmsize;
@@ -522,8 +620,8 @@ nxf_renderglyph(FAR struct nxfonts_fcache_s *priv,
   unsigned int stride;
   int ret;
 
-  ginfo("fcache=%p fbm=%p ch=%c (%02x)\n",
-        priv, fbm, (ch >= 32 && ch < 128) ? ch : '.', ch);
+  ginfo("fcache=%p fbm=%p ch=%c (%04lx)\n",
+        priv, fbm, (ch >= 32 && ch < 128) ? (int)ch : '.', (unsigned long)ch);
 
   /* Get the size of the glyph */
 
@@ -550,7 +648,7 @@ nxf_renderglyph(FAR struct nxfonts_fcache_s *priv,
 
       /* Initialize the glyph memory to the background color. */
 
-      nxf_fillglyph(priv, glyph);
+      nxf_fillrun(priv, glyph->bitmap, stride, 0, width, 0, height);
 
       /* Then render the glyph into the allocated, initialized memory */
 
@@ -574,6 +672,53 @@ nxf_renderglyph(FAR struct nxfonts_fcache_s *priv,
   return glyph;
 }
 
+/****************************************************************************
+ * Name: nxf_lookupglyph
+ *
+ * Description:
+ *   Return the cached glyph for 'ch', rendering it if it is not in the
+ *   cache.  If the cache is full, the least recently used glyph is freed
+ *   to make room for the new one.
+ *
+ * Assumptions:
+ *   The caller holds the font cache semaphore.
+ *
+ ****************************************************************************/
+
+static FAR struct nxfonts_glyph_s *
+nxf_lookupglyph(FAR struct nxfonts_fcache_s *priv, nxf_code_t ch)
+{
+  FAR struct nxfonts_glyph_s *glyph;
+  FAR const struct nx_fontbitmap_s *fbm;
+
+  /* First, try to find the glyph in the cache of pre-rendered glyphs */
+
+  glyph = nxf_findglyph(priv, ch);
+  if (glyph == NULL)
+    {
+      /* No, it is not cached... Does the code map to a font? */
+
+      fbm = nxf_getbitmap(priv->font, ch);
+      if (fbm)
+        {
+          /* Yes.. make room for it if the cache is full */
+
+          if (priv->nglyphs >= priv->maxglyphs)
+            {
+              glyph = priv->tail;
+              nxf_removeglyph(priv, glyph);
+              lib_free(glyph);
+            }
+
+          /* Then render the glyph for the font */
+
+          glyph = nxf_renderglyph(priv, fbm, ch);
+        }
+    }
+
+  return glyph;
+}
+
 /****************************************************************************
  * Name: nxf_findcache
  *
@@ -648,11 +793,18 @@ FCACHE nxf_cache_connect(enum nx_fontid_e fontid,
                          int bpp, int maxglyphs)
 {
   FAR struct nxfonts_fcache_s *priv;
+  bool grow = false;
   int errcode;
 
   ginfo("fontid=%p fgcolor=%u bgcolor=%u bpp=%d maxglyphs=%d\n",
         fontid, fgcolor, bgcolor, bpp, maxglyphs);
 
+  DEBUGASSERT(maxglyphs > 0);
+  if (maxglyphs > UINT16_MAX)
+    {
+      maxglyphs = UINT16_MAX;
+    }
+
   /* Get exclusive access to the font cache list */
 
   nxf_list_lock();
@@ -746,6 +898,14 @@ FCACHE nxf_cache_connect(enum nx_fontid_e fontid,
           goto errout_with_fcache;
         }
 
+      /* Allocate the hash table */
+
+      if (nxf_rehash(priv, maxglyphs) < 0)
+        {
+          errcode = ENOMEM;
+          goto errout_with_fcache;
+        }
+
       /* Initialize the mutual exclusion semaphore */
 
       sem_init(&priv->fsem, 0, 1);
@@ -761,10 +921,7 @@ FCACHE nxf_cache_connect(enum nx_fontid_e fontid,
        * sure that it is as least a big as the size requested.
        */
 
-      if (priv->maxglyphs < maxglyphs)
-        {
-          priv->maxglyphs = maxglyphs;
-        }
+      grow = (priv->maxglyphs < maxglyphs);
 
       /* Increment the number of clients of the font cache */
 
@@ -772,6 +929,25 @@ FCACHE nxf_cache_connect(enum nx_fontid_e fontid,
     }
 
   nxf_list_unlock();
+
+  /* Grow the existing cache if necessary.  This is done after releasing
+   * the list lock; nxf_cache_disconnect() takes the two locks in the
+   * opposite order.  If the larger hash table cannot be allocated, the old
+   * one still works, just with longer bucket lists.
+   */
+
+  if (grow)
+    {
+      nxf_cache_lock(priv);
+      if (priv->maxglyphs < maxglyphs)
+        {
+          (void)nxf_rehash(priv, maxglyphs);
+          priv->maxglyphs = maxglyphs;
+        }
+
+      nxf_cache_unlock(priv);
+    }
+
   ginfo("fhandle=%p\n", priv);
   return (FCACHE)priv;
 
@@ -829,7 +1005,7 @@ void nxf_cache_disconnect(FCACHE fhandle)
 
       for (prev = NULL, fcache = g_fcaches;
            fcache != priv && fcache != NULL;
-           fcache = fcache->flink);
+           prev = fcache, fcache = fcache->flink);
 
       ASSERT(fcache == priv);
       nxf_removecache(fcache, prev);
@@ -843,6 +1019,8 @@ void nxf_cache_disconnect(FCACHE fhandle)
           lib_free(glyph);
         }
 
+      lib_free(priv->hash);
+
       /* Destroy the serializing semaphore... while we are holding it? */
 
       sem_destroy(&priv->fsem);
@@ -894,7 +1072,9 @@ NXHANDLE nxf_cache_getfonthandle(FCACHE fhandle)
  * Description:
  *   Get the font glyph for the character code 'ch' from the font cache.  If
  *   the glyph for that character code does not exist in the font cache, it
- *   be rendered.
+ *   be rendered.  Once the cache is full, the least recently used glyph is
+ *   freed to make room, so the returned glyph is only valid until enough
+ *   other glyphs have been requested to push it out of the cache.
  *
  * Returned Value:
  *   On success, a non-NULL pointer to the rendered glyph in the font cache
@@ -902,34 +1082,113 @@ NXHANDLE nxf_cache_getfonthandle(FCACHE fhandle)
  *
  ****************************************************************************/
 
-FAR const struct nxfonts_glyph_s *nxf_cache_getglyph(FCACHE fhandle, uint8_t ch)
+FAR const struct nxfonts_glyph_s *nxf_cache_getglyph(FCACHE fhandle,
+                                                     nxf_code_t ch)
 {
   FAR struct nxfonts_fcache_s *priv = (FAR struct nxfonts_fcache_s *)fhandle;
   FAR struct nxfonts_glyph_s *glyph;
-  FAR const struct nx_fontbitmap_s *fbm;
 
-  ginfo("ch=%c (%02x)\n", (ch >= 32 && ch < 128) ? ch : '.', ch);
+  ginfo("ch=%c (%04lx)\n", (ch >= 32 && ch < 128) ? (int)ch : '.',
+        (unsigned long)ch);
 
   /* Get exclusive access to the font cache */
 
   nxf_cache_lock(priv);
 
-  /* First, try to find the glyph in the cache of pre-rendered glyphs */
+  /* Find the glyph in the cache or render it */
 
-  glyph = nxf_findglyph(priv, ch);
-  if (glyph == NULL)
+  glyph = nxf_lookupglyph(priv, ch);
+
+  nxf_cache_unlock(priv);
+  return glyph;
+}
+
+/****************************************************************************
+ * Name: nxf_cache_renderrun
+ *
+ * Description:
+ *   Compose a run of characters into a caller-provided bitmap so that a
+ *   whole line of text can be drawn with a single bitmap operation.  Each
+ *   character is placed immediately to the right of the previous one,
+ *   starting at column 'xpos'.  The glyphs are taken from the font cache
+ *   (and rendered into the cache if necessary).  Character codes with no
+ *   glyph are drawn as spaces 'spwidth' pixels wide.  Any part of the
+ *   'height' rows spanned by the run that is not covered by a glyph is
+ *   set to the background color of the font cache.
+ *
+ * Input Parameters:
+ *   fhandle - A font cache handle previously returned by nxf_cache_connect();
+ *   dest    - The bitmap memory that will receive the run
+ *   height  - The height of the bitmap in rows
+ *   stride  - The width of one row of the bitmap in bytes
+ *   xpos    - The column in 'dest' where the first character is placed
+ *   codes   - The character codes to be composed
+ *   nchars  - The number of character codes in 'codes'
+ *   spwidth - The width of a space in pixels
+ *
+ * Returned Value:
+ *   On success, the column following the last character of the run is
+ *   returned.  A negated errno value is returned on failure:  -E2BIG
+ *   means that the run would extend beyond the end of the bitmap rows;
+ *   nothing past the last character that fits will have been modified.
+ *
+ ****************************************************************************/
+
+int nxf_cache_renderrun(FCACHE fhandle, FAR void *dest, nxgl_coord_t height,
+                        unsigned int stride, nxgl_coord_t xpos,
+                        FAR const nxf_code_t *codes, unsigned int nchars,
+                        nxgl_coord_t spwidth)
+{
+  FAR struct nxfonts_fcache_s *priv = (FAR struct nxfonts_fcache_s *)fhandle;
+  FAR struct nxfonts_glyph_s *glyph;
+  unsigned int width;
+  unsigned int nrows;
+  unsigned int i;
+  int ret;
+
+  DEBUGASSERT(priv != NULL && dest != NULL && height > 0 && xpos >= 0);
+
+  /* Get exclusive access to the font cache.  The glyphs are copied while
+   * the lock is held so that none of them can be evicted by another client
+   * of the cache in the meantime.
+   */
+
+  nxf_cache_lock(priv);
+
+  for (i = 0, ret = xpos; i < nchars; i++)
     {
-      /* No, it is not cached... Does the code map to a font? */
+      glyph = nxf_lookupglyph(priv, codes[i]);
+      width = (glyph != NULL) ? glyph->width : spwidth;
 
-      fbm = nxf_getbitmap(priv->font, ch);
-      if (fbm)
+      /* Will this character fit? */
+
+      if (((ret + width) * priv->bpp + 7) >> 3 > stride)
         {
-          /* Yes.. render the glyph for the font */
+          ret = -E2BIG;
+          break;
+        }
 
-          glyph = nxf_renderglyph(priv, fbm, ch);
+      /* Copy the glyph and clear whatever part of the cell it does not
+       * cover.
+       */
+
+      nrows = 0;
+      if (glyph != NULL)
+        {
+          nrows = glyph->height < height ? glyph->height : height;
+          nxf_copyglyph(priv, (FAR uint8_t *)dest, stride, ret, glyph,
+                        nrows);
+        }
+
+      if (nrows < height)
+        {
+          nxf_fillrun(priv, (FAR uint8_t *)dest, stride, ret, width, nrows,
+                      height - nrows);
         }
+
+      ret += width;
     }
 
   nxf_cache_unlock(priv);
-  return glyph;
+  return ret;
 }
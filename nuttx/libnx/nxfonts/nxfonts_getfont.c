@@ -453,7 +453,7 @@ static FAR const struct nx_fontpackage_s *g_fontpackages[] =
  ****************************************************************************/
 
 static inline FAR const struct nx_fontset_s *
-  nxf_getglyphset(uint16_t ch, FAR const struct nx_fontpackage_s *package)
+  nxf_getglyphset(nxf_code_t ch, FAR const struct nx_fontpackage_s *package)
 {
   FAR const struct nx_fontset_s *fontset;
 
@@ -472,15 +472,15 @@ static inline FAR const struct nx_fontset_s *
 
       fontset = &package->font8;
 #else
-      gwarn("WARNING: 8-bit font support disabled: %d\n", ch);
+      gwarn("WARNING: 8-bit font support disabled: %d\n", (int)ch);
       return NULL;
 #endif
     }
   else
     {
-      /* Someday, perhaps 16-bit fonts will go here */
+      /* Someday, perhaps fonts for wider codes will go here */
 
-      gerr("ERROR: 16-bit font not currently supported\n");
+      gerr("ERROR: Codes above 8 bits are not currently supported\n");
       return NULL;
     }
 
@@ -598,7 +598,8 @@ FAR const struct nx_font_s *nxf_getfontset(NXHANDLE handle)
  *
  ****************************************************************************/
 
-FAR const struct nx_fontbitmap_s *nxf_getbitmap(NXHANDLE handle, uint16_t ch)
+FAR const struct nx_fontbitmap_s *nxf_getbitmap(NXHANDLE handle,
+                                                nxf_code_t ch)
 {
   FAR const struct nx_fontpackage_s *package =
     (FAR const struct nx_fontpackage_s *)handle;
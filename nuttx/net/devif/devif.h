@@ -472,6 +472,29 @@ void devif_iob_send(FAR struct net_driver_s *dev, FAR struct iob_s *buf,
                     unsigned int len, unsigned int offset);
 #endif
 
+/****************************************************************************
+ * Name: devif_iob_gsosend
+ *
+ * Description:
+ *   Called from socket logic in response to a poll request from the
+ *   network interface driver.
+ *
+ *   This is like devif_iob_send() except that len may be larger than the
+ *   segment size, segsize.  Only the first segment is copied into the
+ *   device buffer; the remainder is described by the d_gso* fields of the
+ *   device structure and will be sent as a large send.
+ *
+ * Assumptions:
+ *   This function must be called with the network locked.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_TCP_GSO
+void devif_iob_gsosend(FAR struct net_driver_s *dev, FAR struct iob_s *buf,
+                       unsigned int len, unsigned int offset,
+                       unsigned int segsize);
+#endif
+
 /****************************************************************************
  * Name: devif_pkt_send
  *
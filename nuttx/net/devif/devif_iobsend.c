@@ -113,5 +113,43 @@ void devif_iob_send(FAR struct net_driver_s *dev, FAR struct iob_s *iob,
 #endif
 }
 
+/****************************************************************************
+ * Name: devif_iob_gsosend
+ *
+ * Description:
+ *   Called from socket logic in response to a poll request from the
+ *   network interface driver.
+ *
+ *   This is like devif_iob_send() except that len may be larger than the
+ *   segment size, segsize.  Only the first segment is copied into the
+ *   device buffer; the remainder is described by the d_gso* fields of the
+ *   device structure and will be sent as a large send.
+ *
+ * Assumptions:
+ *   Called from the interrupt level or, at a minimum, with interrupts
+ *   disabled.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_TCP_GSO
+void devif_iob_gsosend(FAR struct net_driver_s *dev, FAR struct iob_s *iob,
+                       unsigned int len, unsigned int offset,
+                       unsigned int segsize)
+{
+  DEBUGASSERT(len > segsize && segsize < NET_DEV_MTU(dev));
+
+  /* Send the first segment like any other */
+
+  devif_iob_send(dev, iob, segsize, offset);
+
+  /* And leave the rest to the segmentation at the driver boundary */
+
+  dev->d_gsoiob    = iob;
+  dev->d_gsooffset = offset + segsize;
+  dev->d_gsolen    = len - segsize;
+  dev->d_gsosize   = segsize;
+}
+#endif
+
 #endif /* CONFIG_MM_IOB */
 
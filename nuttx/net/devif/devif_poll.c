@@ -351,7 +351,11 @@ static inline int devif_poll_tcp_connections(FAR struct net_driver_s *dev,
 
       /* Call back into the driver */
 
+#ifdef CONFIG_NET_TCP_GSO
+      bstop = tcp_gso_output(dev, callback);
+#else
       bstop = callback(dev);
+#endif
     }
 
   return bstop;
@@ -364,8 +368,9 @@ static inline int devif_poll_tcp_connections(FAR struct net_driver_s *dev,
  * Name: devif_poll_tcp_timer
  *
  * Description:
- *   The TCP timer has expired.  Update TCP timing state in each active,
- *   TCP connection.
+ *   Update TCP timing state in each TCP connection with an expired timer.
+ *   Connections with no running timer, or whose timers have not yet
+ *   expired, are not visited.
  *
  * Assumptions:
  *   This function is called from the MAC device driver and may be called
@@ -375,19 +380,19 @@ static inline int devif_poll_tcp_connections(FAR struct net_driver_s *dev,
 
 #ifdef NET_TCP_HAVE_STACK
 static inline int devif_poll_tcp_timer(FAR struct net_driver_s *dev,
-                                       devif_poll_callback_t callback,
-                                       int hsec)
+                                       devif_poll_callback_t callback)
 {
-  FAR struct tcp_conn_s *conn  = NULL;
+  FAR struct tcp_conn_s *conn;
+  systime_t now = clock_systimer();
   int bstop = 0;
 
-  /* Traverse all of the active TCP connections and perform the poll action. */
+  /* Traverse the expired TCP connections and perform the timer action. */
 
-  while (!bstop && (conn = tcp_nextconn(conn)))
+  while (!bstop && (conn = tcp_timer_expired(dev, now)) != NULL)
     {
-      /* Perform the TCP timer poll */
+      /* Perform the TCP timer action */
 
-      tcp_timer(dev, conn, hsec);
+      tcp_timer(dev, conn);
 
       /* Perform any necessary conversions on outgoing packets */
 
@@ -401,7 +406,7 @@ static inline int devif_poll_tcp_timer(FAR struct net_driver_s *dev,
   return bstop;
 }
 #else
-# define devif_poll_tcp_timer(dev, callback, hsec) (0)
+# define devif_poll_tcp_timer(dev, callback) (0)
 #endif
 
 /****************************************************************************
@@ -583,14 +588,16 @@ int devif_timer(FAR struct net_driver_s *dev, devif_poll_callback_t callback)
        neighbor_periodic(hsec);
 #endif
 
+    }
+
 #ifdef NET_TCP_HAVE_STACK
-      /* Traverse all of the active TCP connections and perform the
-       * timer action.
-       */
+  /* Perform the timer action on each TCP connection with an expired timer.
+   * TCP timers are kept with system timer resolution and so are checked on
+   * every periodic poll.
+   */
 
-      bstop = devif_poll_tcp_timer(dev, callback, hsec);
+  bstop = devif_poll_tcp_timer(dev, callback);
 #endif
-    }
 
   /* If possible, continue with a normal poll checking for pending
    * network driver actions.
@@ -52,6 +52,7 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <assert.h>
 #include <errno.h>
 #include <debug.h>
 
@@ -59,6 +60,7 @@
 #include <nuttx/clock.h>
 #include <nuttx/semaphore.h>
 #include <nuttx/fs/fs.h>
+#include <nuttx/fs/ioctl.h>
 #include <nuttx/net/net.h>
 #include <nuttx/net/netdev.h>
 #include <nuttx/net/arp.h>
@@ -99,6 +101,7 @@ struct sendfile_s
   FAR struct devif_callback_s *snd_datacb; /* Data callback */
   FAR struct devif_callback_s *snd_ackcb;  /* ACK callback */
   FAR struct file   *snd_file;    /* File structure of the input file */
+  FAR const uint8_t *snd_xipbase; /* Memory-resident file image (or NULL) */
   sem_t              snd_sem;     /* Used to wake up the waiting thread */
   off_t              snd_foffset; /* Input file offset */
   size_t             snd_flen;    /* File length */
@@ -297,7 +300,7 @@ static inline bool sendfile_addrcheck(FAR struct tcp_conn_s *conn)
 }
 
 #else /* CONFIG_NET_ETHERNET */
-#  sendfile_addrcheck(r) (true)
+#  define sendfile_addrcheck(r) (true)
 #endif /* CONFIG_NET_ETHERNET */
 
 /****************************************************************************
@@ -384,23 +387,42 @@ static uint16_t sendfile_interrupt(FAR struct net_driver_s *dev, FAR void *pvcon
            * happen until the polling cycle completes).
            */
 
-          ret = file_seek(pstate->snd_file,
-                          pstate->snd_foffset + pstate->snd_sent, SEEK_SET);
-          if (ret < 0)
+          if (pstate->snd_xipbase != NULL)
             {
-              int errcode = get_errno();
-              nerr("ERROR: Failed to lseek: %d\n", errcode);
-              pstate->snd_sent = -errcode;
-              goto end_wait;
+              /* The file image is directly addressable.  Copy the segment
+               * straight from the file image into the device buffer.  This
+               * avoids the seek and read through the file system for every
+               * segment and, in particular, for every retransmission.
+               */
+
+              memcpy(dev->d_appdata,
+                     pstate->snd_xipbase + pstate->snd_foffset +
+                     pstate->snd_sent,
+                     sndlen);
+              ret = sndlen;
             }
-
-          ret = file_read(pstate->snd_file, dev->d_appdata, sndlen);
-          if (ret < 0)
+          else
             {
-              int errcode = get_errno();
-              nerr("ERROR: Failed to read from input file: %d\n", errcode);
-              pstate->snd_sent = -errcode;
-              goto end_wait;
+              ret = file_seek(pstate->snd_file,
+                              pstate->snd_foffset + pstate->snd_sent,
+                              SEEK_SET);
+              if (ret < 0)
+                {
+                  int errcode = get_errno();
+                  nerr("ERROR: Failed to lseek: %d\n", errcode);
+                  pstate->snd_sent = -errcode;
+                  goto end_wait;
+                }
+
+              ret = file_read(pstate->snd_file, dev->d_appdata, sndlen);
+              if (ret < 0)
+                {
+                  int errcode = get_errno();
+                  nerr("ERROR: Failed to read from input file: %d\n",
+                       errcode);
+                  pstate->snd_sent = -errcode;
+                  goto end_wait;
+                }
             }
 
           dev->d_sndlen = sndlen;
@@ -429,6 +451,27 @@ static uint16_t sendfile_interrupt(FAR struct net_driver_s *dev, FAR void *pvcon
               pstate->snd_sent += sndlen;
               ninfo("pid: %d SEND: acked=%d sent=%d flen=%d\n", getpid(),
                     pstate->snd_acked, pstate->snd_sent, pstate->snd_flen);
+
+#ifdef CONFIG_NET_TCP_WRITE_BUFFERS
+              /* With write buffering, tcp_appsend() leaves the accounting
+               * of unacknowledged data to the sender and tcp_input() only
+               * reports ACKs up to sndseq_max.  Without this, the ACKs are
+               * never reported and the transfer stalls.
+               */
+
+              if (TCP_SEQ_GT(seqno + sndlen, conn->sndseq_max))
+                {
+                  conn->sndseq_max = seqno + sndlen;
+                }
+
+              if (conn->unacked == 0)
+                {
+                  tcp_settimer(conn, conn->timer);
+                }
+
+              conn->unacked = conn->sndseq_max -
+                              (pstate->snd_isn + pstate->snd_acked);
+#endif
             }
         }
       else
@@ -477,6 +520,100 @@ wait:
   return flags;
 }
 
+/****************************************************************************
+ * Name: sendfile_xipbase
+ *
+ * Description:
+ *   Check if the input file is memory resident.  File systems that keep the
+ *   file data contiguously in addressable memory (ROMFS on XIP media, a
+ *   TMPFS file that is already mapped) report the address of the data via
+ *   the FIOC_XIPBASE ioctl.  In that case, outgoing segments can be copied
+ *   directly from the file image into the device buffer.
+ *
+ * Parameters:
+ *   filep  - The input file
+ *   pinned - Location to return a private reference on the input file.
+ *            This is opened only if a non-NULL address is returned and
+ *            must be released with file_close_detached() when the
+ *            transfer completes.  It must be zeroed by the caller.
+ *   offset - The file offset where the transfer begins
+ *   count  - The number of bytes to be transferred.  On return, this value
+ *            is reduced, if necessary, so that the transfer does not extend
+ *            beyond the end of the file image.
+ *
+ * Returned Value:
+ *   The address of the file image or NULL if the file is not memory
+ *   resident or could not be pinned.  The errno value is not modified.
+ *
+ ****************************************************************************/
+
+static FAR const uint8_t *sendfile_xipbase(FAR struct file *filep,
+                                           FAR struct file *pinned,
+                                           off_t offset,
+                                           FAR size_t *count)
+{
+#if CONFIG_NFILE_DESCRIPTORS > 0
+  FAR const uint8_t *base = NULL;
+  off_t endpos;
+  int errcode;
+  int ret;
+
+  errcode = get_errno();
+  ret = file_ioctl(filep, FIOC_XIPBASE, (unsigned long)((uintptr_t)&base));
+  if (ret < 0 || base == NULL)
+    {
+      /* Not memory resident.  Fall back to reading through the file
+       * system.
+       */
+
+      set_errno(errcode);
+      return NULL;
+    }
+
+  /* The image is only guaranteed to stay in place while the file is open.
+   * Hold a private reference on the file until the transfer completes and
+   * get the address again through that reference.
+   */
+
+  if (file_dup2(filep, pinned) < 0)
+    {
+      set_errno(errcode);
+      return NULL;
+    }
+
+  base = NULL;
+  ret  = file_ioctl(pinned, FIOC_XIPBASE,
+                    (unsigned long)((uintptr_t)&base));
+  if (ret < 0 || base == NULL)
+    {
+      goto errout_with_pinned;
+    }
+
+  /* Get the size of the file image.  The private reference has its own
+   * file position, so the caller's position is not disturbed.
+   */
+
+  endpos = file_seek(pinned, 0, SEEK_END);
+  if (endpos < 0 || offset > endpos)
+    {
+      goto errout_with_pinned;
+    }
+
+  if (*count > (size_t)(endpos - offset))
+    {
+      *count = (size_t)(endpos - offset);
+    }
+
+  return base;
+
+errout_with_pinned:
+  (void)file_close_detached(pinned);
+  set_errno(errcode);
+#endif
+
+  return NULL;
+}
+
 /****************************************************************************
  * Name: sendfile_txnotify
  *
@@ -605,8 +742,16 @@ ssize_t net_sendfile(int outfd, struct file *infile, off_t *offset,
 {
   FAR struct socket *psock = sockfd_socket(outfd);
   FAR struct tcp_conn_s *conn;
+  FAR const uint8_t *xipbase;
   struct sendfile_s state;
-  int errcode;
+  struct file pinned;
+  off_t startpos = 0;
+#if defined(CONFIG_NET_ARP_SEND) || defined(CONFIG_NET_ICMPv6_NEIGHBOR)
+  int ret;
+#endif
+  int errcode = OK;
+
+  memset(&pinned, 0, sizeof(struct file));
 
   /* Verify that the sockfd corresponds to valid, allocated socket */
 
@@ -680,6 +825,28 @@ ssize_t net_sendfile(int outfd, struct file *infile, off_t *offset,
     }
 #endif /* CONFIG_NET_ARP_SEND || CONFIG_NET_ICMPv6_NEIGHBOR */
 
+  /* Get the file offset where the transfer begins.  If no offset is
+   * provided, the transfer begins at the current file position.
+   */
+
+  if (offset != NULL)
+    {
+      startpos = *offset;
+    }
+  else
+    {
+      startpos = file_seek(infile, 0, SEEK_CUR);
+      if (startpos < 0)
+        {
+          errcode = get_errno();
+          goto errout;
+        }
+    }
+
+  /* Check if segments can be taken directly from the file image */
+
+  xipbase = sendfile_xipbase(infile, &pinned, startpos, &count);
+
   /* Set the socket state to sending */
 
   psock->s_flags = _SS_SETSTATE(psock->s_flags, _SF_SEND);
@@ -700,9 +867,10 @@ ssize_t net_sendfile(int outfd, struct file *infile, off_t *offset,
   sem_setprotocol(&state.snd_sem, SEM_PRIO_NONE);
 
   state.snd_sock    = psock;                /* Socket descriptor to use */
-  state.snd_foffset = offset ? *offset : 0; /* Input file offset */
+  state.snd_foffset = startpos;             /* Input file offset */
   state.snd_flen    = count;                /* Number of bytes to send */
   state.snd_file    = infile;               /* File to read from */
+  state.snd_xipbase = xipbase;              /* Or NULL if not resident */
 
   /* Allocate resources to receive a callback */
 
@@ -733,6 +901,9 @@ ssize_t net_sendfile(int outfd, struct file *infile, off_t *offset,
    */
 
   conn->unacked          = 0;
+#ifdef CONFIG_NET_TCP_WRITE_BUFFERS
+  conn->sndseq_max       = state.snd_isn;
+#endif
 
 #ifdef CONFIG_NET_SOCKOPTS
   /* Set the initial time for calculating timeouts */
@@ -775,6 +946,13 @@ errout_locked:
   sem_destroy(&state. snd_sem);
   net_unlock();
 
+  /* Release the reference that kept the file image in place */
+
+  if (pinned.f_inode != NULL)
+    {
+      (void)file_close_detached(&pinned);
+    }
+
 errout:
 
   if (errcode)
@@ -789,6 +967,17 @@ errout:
     }
   else
     {
+      /* Update the offset or the file position, as appropriate */
+
+      if (offset != NULL)
+        {
+          *offset = startpos + state.snd_sent;
+        }
+      else
+        {
+          (void)file_seek(infile, startpos + state.snd_sent, SEEK_SET);
+        }
+
       return state.snd_sent;
     }
 }
@@ -45,6 +45,7 @@
 #include <sys/types.h>
 #include <queue.h>
 
+#include <nuttx/clock.h>
 #include <nuttx/mm/iob.h>
 #include <nuttx/net/ip.h>
 
@@ -63,6 +64,26 @@
 #  define HAVE_TCP_POLL
 #endif
 
+/* Conditions for support of TCP options other than MSS */
+
+#if defined(CONFIG_NET_TCP_WINDOW_SCALE) || defined(CONFIG_NET_TCP_TIMESTAMPS) || \
+    defined(CONFIG_NET_TCP_SACK)
+#  define HAVE_TCP_OPTIONS
+#endif
+
+/* Conditions for options that are carried in every segment */
+
+#if defined(CONFIG_NET_TCP_TIMESTAMPS) || defined(CONFIG_NET_TCP_SACK)
+#  define HAVE_TCP_SEGOPTS
+#endif
+
+/* Sequence number comparisons, allowing for wrap-around */
+
+#define TCP_SEQ_LT(a,b)   ((int32_t)((a) - (b)) < 0)
+#define TCP_SEQ_LTE(a,b)  ((int32_t)((a) - (b)) <= 0)
+#define TCP_SEQ_GT(a,b)   ((int32_t)((a) - (b)) > 0)
+#define TCP_SEQ_GTE(a,b)  ((int32_t)((a) - (b)) >= 0)
+
 /* Allocate a new TCP data callback */
 
 #ifdef CONFIG_NETDEV_MULTINIC
@@ -126,6 +147,82 @@
 #endif
 #endif
 
+#ifdef CONFIG_NET_TCP_CC
+/* Congestion control definitions */
+
+#  define TCP_CC_DUPTHRESH        3     /* Duplicate ACKs that trigger a fast
+                                         * retransmission */
+#  define TCP_CC_MAXCWND          0x7fffffff
+
+/* Bit definitions for the ccflags field of struct tcp_conn_s */
+
+#  define TCP_CC_RECOVERY         (1 << 0) /* In fast recovery */
+#  define TCP_CC_REXMIT           (1 << 1) /* Fast retransmission pending */
+#endif
+
+#ifdef HAVE_TCP_OPTIONS
+/* Bit definitions for the tcpopts field of struct tcp_conn_s:  The TCP
+ * options enabled for the connection.  All configured options are
+ * offered in the SYN;  those not also offered by the peer are cleared.
+ */
+
+#  define TCP_OPTF_WSCALE         (1 << 0) /* Window scale */
+#  define TCP_OPTF_TSTAMP         (1 << 1) /* Timestamps */
+#  define TCP_OPTF_SACK           (1 << 2) /* Selective ACK */
+
+#  ifdef CONFIG_NET_TCP_WINDOW_SCALE
+#    define __TCP_OPTF_WSCALE     TCP_OPTF_WSCALE
+#  else
+#    define __TCP_OPTF_WSCALE     0
+#  endif
+#  ifdef CONFIG_NET_TCP_TIMESTAMPS
+#    define __TCP_OPTF_TSTAMP     TCP_OPTF_TSTAMP
+#  else
+#    define __TCP_OPTF_TSTAMP     0
+#  endif
+#  ifdef CONFIG_NET_TCP_SACK
+#    define __TCP_OPTF_SACK       TCP_OPTF_SACK
+#  else
+#    define __TCP_OPTF_SACK       0
+#  endif
+
+#  define TCP_OPTF_DEFAULT \
+     (__TCP_OPTF_WSCALE | __TCP_OPTF_TSTAMP | __TCP_OPTF_SACK)
+#endif
+
+/* The timestamp clock is the system timer (RFC 7323 allows a tick of 1 ms
+ * to 1 sec).
+ */
+
+#define tcp_tsnow()               ((uint32_t)clock_systimer())
+
+/* Size of the timestamps option as sent in each segment, padded with two
+ * NOPs for alignment.
+ */
+
+#define TCP_TSOPT_SIZE            12
+
+/* The number of SACK blocks retained in the scoreboard.  This is also the
+ * most that fit in the TCP option space.
+ */
+
+#define TCP_SACK_NBLOCKS          4
+
+/* Timer state flags (see tflags in struct tcp_conn_s) */
+
+#define TCP_TF_QUEUED             (1 << 0) /* Connection is in the timer queue */
+#define TCP_TF_DELACK             (1 << 1) /* An ACK is being delayed */
+
+/* Timer expiration test, allowing for wrap-around of the system timer */
+
+#define TCP_TIMER_DUE(now,t)      ((ssystime_t)((now) - (t)) >= 0)
+
+#ifdef CONFIG_NET_TCP_DELAYED_ACK
+/* The longest time that the ACK of received data may be delayed */
+
+#  define TCP_DELACK_TICKS        MSEC2TICK(CONFIG_NET_TCP_DELACK_MSEC)
+#endif
+
 /****************************************************************************
  * Public Type Definitions
  ****************************************************************************/
@@ -144,6 +241,16 @@ struct devif_callback_s;  /* Forward reference */
 struct tcp_backlog_s;     /* Forward reference */
 struct tcp_hdr_s;         /* Forward reference */
 
+#ifdef CONFIG_NET_TCP_SACK
+/* One range of data that the peer has selectively acknowledged */
+
+struct tcp_sack_s
+{
+  uint32_t left;          /* First sequence number of the block */
+  uint32_t right;         /* Sequence number following the block */
+};
+#endif
+
 struct tcp_conn_s
 {
   dq_entry_t node;        /* Implements a doubly linked list */
@@ -161,20 +268,46 @@ struct tcp_conn_s
                            * variable */
   uint8_t  rto;           /* Retransmission time-out */
   uint8_t  tcpstateflags; /* TCP state and flags */
-  uint8_t  timer;         /* The retransmission timer (units: half-seconds) */
+  uint8_t  timer;         /* The retransmission timeout (units: half-seconds) */
+  uint8_t  tflags;        /* Timer state flags.  See TCP_TF_* definitions */
   uint8_t  nrtx;          /* The number of retransmissions for the last
                            * segment sent */
   uint16_t lport;         /* The local TCP port, in network byte order */
   uint16_t rport;         /* The remoteTCP port, in network byte order */
   uint16_t mss;           /* Current maximum segment size for the
                            * connection */
+#ifdef CONFIG_NET_TCP_WINDOW_SCALE
+  uint32_t winsize;       /* Current window size of the connection */
+#else
   uint16_t winsize;       /* Current window size of the connection */
+#endif
 #ifdef CONFIG_NET_TCP_WRITE_BUFFERS
   uint32_t unacked;       /* Number bytes sent but not yet ACKed */
 #else
   uint16_t unacked;       /* Number bytes sent but not yet ACKed */
 #endif
 
+  /* Timers.  The connection is held in a timer queue, ordered by expiry
+   * time, whenever one of its timers is running so that only connections
+   * with expired timers need be visited by the periodic poll.
+   *
+   *   tflink  - The next connection in the timer queue.
+   *   tblink  - The previous connection in the timer queue.
+   *   expiry  - The time at which the connection is next due (only valid
+   *             if TCP_TF_QUEUED is set).
+   *   tmstart - The time at which 'timer' was last (re-)started.  This is
+   *             also the time of entry into TIME_WAIT or FIN_WAIT_2.
+   *   acktime - The time at which the ACK of received data was deferred.
+   */
+
+  FAR struct tcp_conn_s *tflink;
+  FAR struct tcp_conn_s *tblink;
+  systime_t  expiry;      /* Next timer expiry */
+  systime_t  tmstart;     /* Start of the current 'timer' interval */
+#ifdef CONFIG_NET_TCP_DELAYED_ACK
+  systime_t  acktime;     /* Start of the delayed ACK interval */
+#endif
+
 #ifdef CONFIG_NETDEV_MULTINIC
   /* If the TCP socket is bound to a local address, then this is
    * a reference to the device that routes traffic on the corresponding
@@ -213,6 +346,56 @@ struct tcp_conn_s
                            * segment (next greater sndseq) */
 #endif
 
+#ifdef CONFIG_NET_TCP_CC
+  /* NewReno congestion control (RFC 5681, RFC 6582)
+   *
+   *   cwnd     - The congestion window.  No more than this number of bytes
+   *              may be sent but un-ACKed.
+   *   ssthresh - The slow start threshold.
+   *   recover  - The highest sequence number sent when fast recovery was
+   *              last entered.
+   *   lastack  - The last cumulative ACK number received.
+   *   dupacks  - The number of consecutive duplicate ACKs received.
+   *   ccflags  - Congestion control state.  See TCP_CC_* definitions.
+   */
+
+  uint32_t   cwnd;        /* Congestion window */
+  uint32_t   ssthresh;    /* Slow start threshold */
+  uint32_t   recover;     /* Fast recovery end point */
+  uint32_t   lastack;     /* Last cumulative ACK number */
+  uint8_t    dupacks;     /* Consecutive duplicate ACK count */
+  uint8_t    ccflags;     /* Congestion control flags */
+#endif
+
+#ifdef HAVE_TCP_OPTIONS
+  /* Negotiated TCP options (RFC 7323, RFC 2018)
+   *
+   *   tcpopts    - The options in use.  See TCP_OPTF_* definitions.
+   *   snd_wscale - The shift applied to the window advertised by the peer.
+   *   rcv_wscale - The shift applied to the window that we advertise.
+   *   ts_recent  - The timestamp to be echoed to the peer.
+   *   sacks      - The SACK scoreboard:  Blocks above the cumulative ACK
+   *                that the peer has reported, in sequence order.
+   *   nsacks     - The number of blocks in the scoreboard.
+   *   sack_rxt   - The highest sequence number retransmitted during the
+   *                current fast recovery.
+   */
+
+  uint8_t    tcpopts;     /* Negotiated TCP options */
+#ifdef CONFIG_NET_TCP_WINDOW_SCALE
+  uint8_t    snd_wscale;  /* Send window scale shift */
+  uint8_t    rcv_wscale;  /* Receive window scale shift */
+#endif
+#ifdef CONFIG_NET_TCP_TIMESTAMPS
+  uint32_t   ts_recent;   /* Timestamp to echo */
+#endif
+#ifdef CONFIG_NET_TCP_SACK
+  uint8_t    nsacks;      /* Number of SACK blocks */
+  uint32_t   sack_rxt;    /* Fast recovery retransmission point */
+  struct tcp_sack_s sacks[TCP_SACK_NBLOCKS];
+#endif
+#endif
+
 #ifdef CONFIG_NET_TCPBACKLOG
   /* Listen backlog support
    *
@@ -284,6 +467,23 @@ struct tcp_conn_s
                                uint16_t flags);
 };
 
+#ifdef HAVE_TCP_SEGOPTS
+/* The options of interest found in an incoming, non-SYN segment */
+
+struct tcp_segopts_s
+{
+#ifdef CONFIG_NET_TCP_TIMESTAMPS
+  bool     ts;            /* True:  The timestamps option is present */
+  uint32_t tsval;         /* The peer's timestamp */
+  uint32_t tsecr;         /* The timestamp echoed by the peer */
+#endif
+#ifdef CONFIG_NET_TCP_SACK
+  uint8_t  nsacks;        /* The number of SACK blocks */
+  struct tcp_sack_s sacks[TCP_SACK_NBLOCKS]; /* The SACK blocks */
+#endif
+};
+#endif
+
 /* This structure supports TCP write buffering */
 
 #ifdef CONFIG_NET_TCP_WRITE_BUFFERS
@@ -661,16 +861,44 @@ void tcp_nextsequence(void);
 
 void tcp_poll(FAR struct net_driver_s *dev, FAR struct tcp_conn_s *conn);
 
+/****************************************************************************
+ * Name: tcp_gso_output
+ *
+ * Description:
+ *   Pass the outgoing packet that resulted from a TCP poll to the driver.
+ *   If the packet is the first segment of a large send, the remaining
+ *   segments are built from its headers and passed to the driver one at a
+ *   time, unless the driver segments large sends itself (NETDEV_TSO).
+ *
+ * Parameters:
+ *   dev      - The device driver structure holding the outgoing packet
+ *   callback - The driver's TX poll callback
+ *
+ * Return:
+ *   The value returned by the last call to the callback.
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_TCP_GSO
+int tcp_gso_output(FAR struct net_driver_s *dev,
+                   CODE int (*callback)(FAR struct net_driver_s *dev));
+#endif
+
 /****************************************************************************
  * Name: tcp_timer
  *
  * Description:
- *   Handle a TCP timer expiration for the provided TCP connection
+ *   Handle a TCP timer expiration for the provided TCP connection.  The
+ *   connection has been removed from the timer queue by
+ *   tcp_timer_expired() and is re-queued if any timer is still running
+ *   on return.
  *
  * Parameters:
  *   dev  - The device driver structure to use in the send operation
  *   conn - The TCP "connection" to poll for TX data
- *   hsec - The polling interval in halves of a second
  *
  * Return:
  *   None
@@ -680,8 +908,111 @@ void tcp_poll(FAR struct net_driver_s *dev, FAR struct tcp_conn_s *conn);
  *
  ****************************************************************************/
 
-void tcp_timer(FAR struct net_driver_s *dev, FAR struct tcp_conn_s *conn,
-               int hsec);
+void tcp_timer(FAR struct net_driver_s *dev, FAR struct tcp_conn_s *conn);
+
+/****************************************************************************
+ * Name: tcp_timer_expired
+ *
+ * Description:
+ *   Remove and return the first connection in the timer queue whose timer
+ *   has expired and that may be serviced by 'dev'.
+ *
+ * Parameters:
+ *   dev - The device driver structure that is polling
+ *   now - The current system time
+ *
+ * Return:
+ *   The expired connection or NULL if there is none
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+FAR struct tcp_conn_s *tcp_timer_expired(FAR struct net_driver_s *dev,
+                                         systime_t now);
+
+/****************************************************************************
+ * Name: tcp_timer_update
+ *
+ * Description:
+ *   Re-evaluate the timers of a connection after a change in its state
+ *   and make sure that it is queued to expire no later than the earliest
+ *   running timer.  A connection that is already queued to expire earlier
+ *   is left in place and re-evaluated when it expires; this keeps the
+ *   common case of restarting the retransmission timer on each ACK O(1).
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+void tcp_timer_update(FAR struct tcp_conn_s *conn);
+
+/****************************************************************************
+ * Name: tcp_timer_cancel
+ *
+ * Description:
+ *   Remove a connection from the timer queue.
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+void tcp_timer_cancel(FAR struct tcp_conn_s *conn);
+
+/****************************************************************************
+ * Name: tcp_settimer
+ *
+ * Description:
+ *   (Re-)start the retransmission timer of a connection.  The timer runs
+ *   only while there is unacknowledged data (or, in TIME_WAIT and
+ *   FIN_WAIT_2, until the connection times out).
+ *
+ * Parameters:
+ *   conn - The TCP connection
+ *   hsec - The timeout in half-seconds
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+void tcp_settimer(FAR struct tcp_conn_s *conn, int hsec);
+
+/****************************************************************************
+ * Name: tcp_timer_elapsed
+ *
+ * Description:
+ *   Return the time since the retransmission timer was last started in
+ *   units of half-seconds (truncating).
+ *
+ ****************************************************************************/
+
+#define tcp_timer_elapsed(conn) \
+  ((clock_systimer() - (conn)->tmstart) / TICK_PER_HSEC)
+
+/****************************************************************************
+ * Name: tcp_delack
+ *
+ * Description:
+ *   Called when received data is to be ACKed with no outgoing data to
+ *   carry the ACK.  Per RFC 1122, the ACK is deferred for the first
+ *   segment and sent for the second or when the delayed ACK timer
+ *   expires.
+ *
+ * Return:
+ *   True if the ACK was deferred; false if it must be sent now.
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_TCP_DELAYED_ACK
+bool tcp_delack(FAR struct tcp_conn_s *conn);
+#endif
 
 /****************************************************************************
  * Name: tcp_listen_initialize
@@ -881,6 +1212,223 @@ void tcp_appsend(FAR struct net_driver_s *dev, FAR struct tcp_conn_s *conn,
 void tcp_rexmit(FAR struct net_driver_s *dev, FAR struct tcp_conn_s *conn,
                 uint16_t result);
 
+/****************************************************************************
+ * Name: tcp_cc_init
+ *
+ * Description:
+ *   Initialize the congestion control state of a TCP connection that has
+ *   just entered the ESTABLISHED state.
+ *
+ * Parameters:
+ *   conn - The TCP connection structure
+ *
+ * Return:
+ *   None
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_TCP_CC
+void tcp_cc_init(FAR struct tcp_conn_s *conn);
+#endif
+
+/****************************************************************************
+ * Name: tcp_cc_ack
+ *
+ * Description:
+ *   Update the congestion window on receipt of an ACK.  New ACKs open the
+ *   window (slow start or congestion avoidance);  duplicate ACKs are
+ *   counted and trigger fast retransmit / fast recovery.
+ *
+ * Parameters:
+ *   conn   - The TCP connection structure
+ *   ackseq - The acknowledgement number of the received segment
+ *   dupack - True if the segment qualifies as a duplicate ACK candidate
+ *            (no payload, no SYN or FIN)
+ *
+ * Return:
+ *   None
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_TCP_CC
+void tcp_cc_ack(FAR struct tcp_conn_s *conn, uint32_t ackseq, bool dupack);
+#endif
+
+/****************************************************************************
+ * Name: tcp_cc_rto
+ *
+ * Description:
+ *   Collapse the congestion window after a retransmission time-out.
+ *
+ * Parameters:
+ *   conn - The TCP connection structure
+ *
+ * Return:
+ *   None
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_TCP_CC
+void tcp_cc_rto(FAR struct tcp_conn_s *conn);
+#endif
+
+/****************************************************************************
+ * Name: tcp_synopts
+ *
+ * Description:
+ *   Parse the options of a received SYN or SYN-ACK:  Set the MSS and
+ *   disable the TCP options that the peer did not offer.
+ *
+ * Parameters:
+ *   dev   - The device driver structure containing the received segment
+ *   conn  - The TCP connection structure
+ *   tcp   - The TCP header of the received segment
+ *   iplen - The size of the IP header
+ *
+ * Return:
+ *   None
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+void tcp_synopts(FAR struct net_driver_s *dev, FAR struct tcp_conn_s *conn,
+                 FAR struct tcp_hdr_s *tcp, unsigned int iplen);
+
+/****************************************************************************
+ * Name: tcp_buildsynopts
+ *
+ * Description:
+ *   Generate the options for an outgoing SYN or SYN-ACK.
+ *
+ * Parameters:
+ *   dev  - The device driver structure to use in the send operation
+ *   conn - The TCP connection structure
+ *   opts - The location of the options in the outgoing TCP header
+ *   mss  - The MSS to advertise
+ *
+ * Return:
+ *   The size of the options in bytes (a multiple of four)
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+unsigned int tcp_buildsynopts(FAR struct net_driver_s *dev,
+                              FAR struct tcp_conn_s *conn,
+                              FAR uint8_t *opts, uint16_t mss);
+
+/****************************************************************************
+ * Name: tcp_segopts
+ *
+ * Description:
+ *   Parse the options of a received, non-SYN segment.
+ *
+ * Parameters:
+ *   conn    - The TCP connection structure
+ *   tcp     - The TCP header of the received segment
+ *   segopts - Location to return the options found
+ *
+ * Return:
+ *   None
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+#ifdef HAVE_TCP_SEGOPTS
+void tcp_segopts(FAR struct tcp_conn_s *conn, FAR struct tcp_hdr_s *tcp,
+                 FAR struct tcp_segopts_s *segopts);
+#endif
+
+/****************************************************************************
+ * Name: tcp_buildtsopt
+ *
+ * Description:
+ *   Generate the NOP-padded timestamps option for an outgoing segment.
+ *
+ * Parameters:
+ *   conn - The TCP connection structure
+ *   opts - The location of the TCP_TSOPT_SIZE bytes of option space
+ *
+ * Return:
+ *   None
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_TCP_TIMESTAMPS
+void tcp_buildtsopt(FAR struct tcp_conn_s *conn, FAR uint8_t *opts);
+#endif
+
+/****************************************************************************
+ * Name: tcp_sack_ack
+ *
+ * Description:
+ *   Update the SACK scoreboard on receipt of an ACK:  Discard what is now
+ *   covered by the cumulative ACK and merge in any SACK blocks carried by
+ *   the segment.  During fast recovery, request a retransmission if a
+ *   hole remains below the highest SACKed data.
+ *
+ * Parameters:
+ *   conn    - The TCP connection structure
+ *   ackseq  - The acknowledgement number of the received segment
+ *   segopts - The options of the received segment
+ *
+ * Return:
+ *   None
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked, after
+ *   tcp_cc_ack().
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_TCP_SACK
+void tcp_sack_ack(FAR struct tcp_conn_s *conn, uint32_t ackseq,
+                  FAR const struct tcp_segopts_s *segopts);
+#endif
+
+/****************************************************************************
+ * Name: tcp_sack_nexthole
+ *
+ * Description:
+ *   Find the next range of data to be retransmitted during fast recovery:
+ *   The first un-SACKed data above both the cumulative ACK and the last
+ *   retransmission, and below the highest SACKed data.
+ *
+ * Parameters:
+ *   conn   - The TCP connection structure
+ *   seqno  - Location to return the first sequence number of the hole
+ *   len    - Location to return the size of the hole
+ *
+ * Return:
+ *   true if there is a hole to be retransmitted.
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_TCP_SACK
+bool tcp_sack_nexthole(FAR struct tcp_conn_s *conn, FAR uint32_t *seqno,
+                       FAR uint32_t *len);
+#endif
+
 /****************************************************************************
  * Name: tcp_ipv4_input
  *
@@ -145,6 +145,7 @@ void tcp_appsend(FAR struct net_driver_s *dev, FAR struct tcp_conn_s *conn,
       conn->tcpstateflags = TCP_FIN_WAIT_1;
       conn->unacked  = 1;
       conn->nrtx     = 0;
+      tcp_settimer(conn, conn->rto);
       ninfo("TCP state: TCP_FIN_WAIT_1\n");
 
       dev->d_sndlen  = 0;
@@ -171,6 +172,15 @@ void tcp_appsend(FAR struct net_driver_s *dev, FAR struct tcp_conn_s *conn,
 
           conn->unacked += dev->d_sndlen;
 
+          /* Start the retransmission timer if there was no outstanding
+           * data.
+           */
+
+          if (conn->unacked == dev->d_sndlen)
+            {
+              tcp_settimer(conn, conn->timer);
+            }
+
           /* The application cannot send more than what is allowed by the
            * MSS (the minumum of the MSS and the available window).
            */
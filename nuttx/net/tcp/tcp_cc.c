@@ -0,0 +1,305 @@
+/****************************************************************************
+ * net/tcp/tcp_cc.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#if defined(CONFIG_NET) && defined(CONFIG_NET_TCP) && defined(CONFIG_NET_TCP_CC)
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <debug.h>
+
+#include <nuttx/net/netconfig.h>
+#include <nuttx/net/tcp.h>
+
+#include "tcp/tcp.h"
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: tcp_cc_halfflight
+ *
+ * Description:
+ *   Return the new slow start threshold after a loss has been detected:
+ *   half of the data in flight, but no less than two segments
+ *   (RFC 5681, equation 4).
+ *
+ ****************************************************************************/
+
+static uint32_t tcp_cc_halfflight(FAR struct tcp_conn_s *conn)
+{
+  uint32_t ssthresh = conn->unacked >> 1;
+  uint32_t minthresh = 2 * (uint32_t)conn->mss;
+
+  return ssthresh > minthresh ? ssthresh : minthresh;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: tcp_cc_init
+ *
+ * Description:
+ *   Initialize the congestion control state of a TCP connection that has
+ *   just entered the ESTABLISHED state.
+ *
+ * Parameters:
+ *   conn - The TCP connection structure
+ *
+ * Return:
+ *   None
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+void tcp_cc_init(FAR struct tcp_conn_s *conn)
+{
+  uint32_t mss = conn->mss;
+  uint32_t iw;
+
+  /* The initial window is min(4*MSS, max(2*MSS, 4380)) (RFC 3390) */
+
+  iw = 4380;
+  if (iw < 2 * mss)
+    {
+      iw = 2 * mss;
+    }
+
+  if (iw > 4 * mss)
+    {
+      iw = 4 * mss;
+    }
+
+  conn->cwnd     = iw;
+  conn->ssthresh = TCP_CC_MAXCWND;
+  conn->lastack  = conn->isn;
+  conn->recover  = conn->isn;
+  conn->dupacks  = 0;
+  conn->ccflags  = 0;
+#ifdef CONFIG_NET_TCP_SACK
+  conn->nsacks   = 0;
+  conn->sack_rxt = conn->isn;
+#endif
+}
+
+/****************************************************************************
+ * Name: tcp_cc_ack
+ *
+ * Description:
+ *   Update the congestion window on receipt of an ACK.  New ACKs open the
+ *   window (slow start or congestion avoidance);  duplicate ACKs are
+ *   counted and trigger fast retransmit / fast recovery.
+ *
+ * Parameters:
+ *   conn   - The TCP connection structure
+ *   ackseq - The acknowledgement number of the received segment
+ *   dupack - True if the segment qualifies as a duplicate ACK candidate
+ *            (no payload, no SYN or FIN)
+ *
+ * Return:
+ *   None
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked.  On
+ *   entry, conn->unacked and the RTT estimate have already been updated
+ *   for this ACK.
+ *
+ ****************************************************************************/
+
+void tcp_cc_ack(FAR struct tcp_conn_s *conn, uint32_t ackseq, bool dupack)
+{
+  uint32_t mss = conn->mss;
+
+  if (TCP_SEQ_GT(ackseq, conn->lastack))
+    {
+      uint32_t acked = ackseq - conn->lastack;
+
+      conn->lastack = ackseq;
+
+      /* New data has been ACKed so the retransmission back-off is over.
+       * This is called after the RTT estimate has been updated.
+       */
+
+      conn->nrtx    = 0;
+
+      if ((conn->ccflags & TCP_CC_RECOVERY) != 0)
+        {
+          if (TCP_SEQ_LT(ackseq, conn->recover))
+            {
+              /* Partial ACK:  The next hole is at ackseq.  Retransmit it
+               * at once and deflate the window by the amount of new data
+               * ACKed, adding back one segment (RFC 6582, step 3).
+               */
+
+              conn->cwnd     = conn->cwnd > acked ? conn->cwnd - acked : 0;
+              if (acked >= mss)
+                {
+                  conn->cwnd += mss;
+                }
+
+              if (conn->cwnd < mss)
+                {
+                  conn->cwnd = mss;
+                }
+
+              conn->ccflags |= TCP_CC_REXMIT;
+#ifdef CONFIG_NET_TCP_SACK
+              if (TCP_SEQ_LT(conn->sack_rxt, ackseq))
+                {
+                  conn->sack_rxt = ackseq;
+                }
+#endif
+              ninfo("CC: partial ACK %08x cwnd=%u\n", ackseq, conn->cwnd);
+            }
+          else
+            {
+              /* Full ACK:  Deflate the window and leave fast recovery */
+
+              conn->cwnd     = conn->ssthresh;
+              conn->ccflags &= ~(TCP_CC_RECOVERY | TCP_CC_REXMIT);
+              conn->dupacks  = 0;
+              ninfo("CC: recovered cwnd=%u\n", conn->cwnd);
+            }
+        }
+      else
+        {
+          conn->dupacks = 0;
+
+          if (conn->cwnd < conn->ssthresh)
+            {
+              /* Slow start:  Open the window by up to one segment per ACK */
+
+              conn->cwnd += acked < mss ? acked : mss;
+            }
+          else
+            {
+              /* Congestion avoidance:  Open the window by about one
+               * segment per round trip.
+               */
+
+              uint32_t incr = (mss * mss) / conn->cwnd;
+              conn->cwnd += incr > 0 ? incr : 1;
+            }
+
+          if (conn->cwnd > TCP_CC_MAXCWND)
+            {
+              conn->cwnd = TCP_CC_MAXCWND;
+            }
+        }
+    }
+  else if (dupack && ackseq == conn->lastack && conn->unacked > 0)
+    {
+      if ((conn->ccflags & TCP_CC_RECOVERY) != 0)
+        {
+          /* Each further duplicate ACK means that another segment has left
+           * the network:  Inflate the window so that new data can be sent.
+           */
+
+          conn->cwnd += mss;
+        }
+      else if (++conn->dupacks == TCP_CC_DUPTHRESH &&
+               TCP_SEQ_GT(ackseq, conn->recover))
+        {
+          /* Fast retransmit.  Enter fast recovery unless this loss was
+           * already covered by the previous recovery episode
+           * (RFC 6582, step 2).
+           */
+
+          conn->ssthresh = tcp_cc_halfflight(conn);
+          conn->cwnd     = conn->ssthresh + TCP_CC_DUPTHRESH * mss;
+          conn->recover  = conn->sndseq_max;
+          conn->ccflags |= (TCP_CC_RECOVERY | TCP_CC_REXMIT);
+#ifdef CONFIG_NET_TCP_SACK
+          conn->sack_rxt = ackseq;
+#endif
+
+          ninfo("CC: fast retransmit %08x ssthresh=%u cwnd=%u\n",
+                ackseq, conn->ssthresh, conn->cwnd);
+        }
+    }
+}
+
+/****************************************************************************
+ * Name: tcp_cc_rto
+ *
+ * Description:
+ *   Collapse the congestion window after a retransmission time-out.
+ *
+ * Parameters:
+ *   conn - The TCP connection structure
+ *
+ * Return:
+ *   None
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+void tcp_cc_rto(FAR struct tcp_conn_s *conn)
+{
+  /* Only the first time-out of a back-off series reduces ssthresh */
+
+  if (conn->nrtx <= 1)
+    {
+      conn->ssthresh = tcp_cc_halfflight(conn);
+    }
+
+  conn->cwnd     = conn->mss;
+  conn->recover  = conn->sndseq_max;
+  conn->dupacks  = 0;
+  conn->ccflags &= ~(TCP_CC_RECOVERY | TCP_CC_REXMIT);
+
+#ifdef CONFIG_NET_TCP_SACK
+  /* Everything will be resent from the cumulative ACK.  The peer may have
+   * discarded SACKed data, so the scoreboard is not trusted any further.
+   */
+
+  conn->nsacks   = 0;
+#endif
+
+  ninfo("CC: RTO ssthresh=%u cwnd=%u\n", conn->ssthresh, conn->cwnd);
+}
+
+#endif /* CONFIG_NET && CONFIG_NET_TCP && CONFIG_NET_TCP_CC */
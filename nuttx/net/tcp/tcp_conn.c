@@ -742,7 +742,8 @@ FAR struct tcp_conn_s *tcp_alloc(uint8_t domain)
             {
               /* Yes.. Is it the oldest one we have seen so far? */
 
-              if (!conn || tmp->timer > conn->timer)
+              if (!conn ||
+                  (ssystime_t)(tmp->tmstart - conn->tmstart) < 0)
                 {
                   /* Yes.. remember it */
 
@@ -845,6 +846,10 @@ void tcp_free(FAR struct tcp_conn_s *conn)
       dq_rem(&conn->node, &g_active_tcp_connections);
     }
 
+  /* Stop any running timers */
+
+  tcp_timer_cancel(conn);
+
 #ifdef CONFIG_NET_TCP_READAHEAD
   /* Release any read-ahead buffers attached to the connection */
 
@@ -1072,7 +1077,6 @@ FAR struct tcp_conn_s *tcp_alloc_accept(FAR struct net_driver_s *dev,
       /* Fill in the necessary fields for the new connection. */
 
       conn->rto           = TCP_RTO;
-      conn->timer         = TCP_RTO;
       conn->sa            = 0;
       conn->sv            = 4;
       conn->nrtx          = 0;
@@ -1088,6 +1092,19 @@ FAR struct tcp_conn_s *tcp_alloc_accept(FAR struct net_driver_s *dev,
       conn->sent          = 0;
       conn->sndseq_max    = 0;
 #endif
+#ifdef HAVE_TCP_OPTIONS
+      conn->tcpopts       = TCP_OPTF_DEFAULT;
+#endif
+#ifdef CONFIG_NET_TCP_WINDOW_SCALE
+      conn->snd_wscale    = 0;
+      conn->rcv_wscale    = 0;
+#endif
+#ifdef CONFIG_NET_TCP_TIMESTAMPS
+      conn->ts_recent     = 0;
+#endif
+#ifdef CONFIG_NET_TCP_SACK
+      conn->nsacks        = 0;
+#endif
 
       /* rcvseq should be the seqno from the incoming packet + 1. */
 
@@ -1111,6 +1128,10 @@ FAR struct tcp_conn_s *tcp_alloc_accept(FAR struct net_driver_s *dev,
        */
 
       dq_addlast(&conn->node, &g_active_tcp_connections);
+
+      /* Start the retransmission timer for the SYNACK */
+
+      tcp_settimer(conn, TCP_RTO);
     }
 
   return conn;
@@ -1337,7 +1358,6 @@ int tcp_connect(FAR struct tcp_conn_s *conn, FAR const struct sockaddr *addr)
 
   conn->unacked    = 1;    /* TCP length of the SYN is one. */
   conn->nrtx       = 0;
-  conn->timer      = 1;    /* Send the SYN next time around. */
   conn->rto        = TCP_RTO;
   conn->sa         = 0;
   conn->sv         = 16;   /* Initial value of the RTT variance. */
@@ -1348,6 +1368,19 @@ int tcp_connect(FAR struct tcp_conn_s *conn, FAR const struct sockaddr *addr)
   conn->sent       = 0;
   conn->sndseq_max = 0;
 #endif
+#ifdef HAVE_TCP_OPTIONS
+  conn->tcpopts    = TCP_OPTF_DEFAULT;
+#endif
+#ifdef CONFIG_NET_TCP_WINDOW_SCALE
+  conn->snd_wscale = 0;
+  conn->rcv_wscale = 0;
+#endif
+#ifdef CONFIG_NET_TCP_TIMESTAMPS
+  conn->ts_recent  = 0;
+#endif
+#ifdef CONFIG_NET_TCP_SACK
+  conn->nsacks     = 0;
+#endif
 
 #ifdef CONFIG_NET_TCP_READAHEAD
   /* Initialize the list of TCP read-ahead buffers */
@@ -1365,6 +1398,10 @@ int tcp_connect(FAR struct tcp_conn_s *conn, FAR const struct sockaddr *addr)
   /* And, finally, put the connection structure into the active list. */
 
   dq_addlast(&conn->node, &g_active_tcp_connections);
+
+  /* Send the SYN on the next timer poll */
+
+  tcp_settimer(conn, 0);
   ret = OK;
 
 errout_with_lock:
@@ -86,6 +86,9 @@ void tcp_poll(FAR struct net_driver_s *dev, FAR struct tcp_conn_s *conn)
 
   dev->d_len     = 0;
   dev->d_sndlen  = 0;
+#ifdef CONFIG_NET_TCP_GSO
+  dev->d_gsolen  = 0;
+#endif
 
   /* Verify that the connection is established. */
 
@@ -126,6 +129,19 @@ void tcp_poll(FAR struct net_driver_s *dev, FAR struct tcp_conn_s *conn)
 
           result = tcp_callback(dev, conn, TCP_POLL);
 
+#ifdef CONFIG_NET_TCP_DELAYED_ACK
+          /* Send any delayed ACK that has come due.  It will be carried by
+           * outgoing data, if there is any.
+           */
+
+          if ((conn->tflags & TCP_TF_DELACK) != 0 &&
+              TCP_TIMER_DUE(clock_systimer(),
+                            conn->acktime + TCP_DELACK_TICKS))
+            {
+              result |= TCP_SNDACK;
+            }
+#endif
+
           /* Handle the callback response */
 
           tcp_appsend(dev, conn, result);
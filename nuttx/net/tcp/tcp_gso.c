@@ -0,0 +1,289 @@
+/****************************************************************************
+ * net/tcp/tcp_gso.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#if defined(CONFIG_NET) && defined(CONFIG_NET_TCP) && defined(CONFIG_NET_TCP_GSO)
+
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <debug.h>
+
+#include <nuttx/mm/iob.h>
+#include <nuttx/net/netconfig.h>
+#include <nuttx/net/netdev.h>
+#include <nuttx/net/netstats.h>
+#include <nuttx/net/ip.h>
+#include <nuttx/net/tcp.h>
+
+#include "devif/devif.h"
+#include "tcp/tcp.h"
+#include "utils/utils.h"
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+/* The largest TCP header, including options, and the largest IP + TCP
+ * header that may have to be replicated for each segment.
+ */
+
+#define TCP_MAX_HDRLEN  60
+
+#ifdef CONFIG_NET_IPv6
+#  define GSO_MAX_HDRLEN (IPv6_HDRLEN + TCP_MAX_HDRLEN)
+#else
+#  define GSO_MAX_HDRLEN (IPv4_HDRLEN + TCP_MAX_HDRLEN)
+#endif
+
+#ifndef MIN
+#  define MIN(a,b) ((a) < (b) ? (a) : (b))
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: tcp_gso_ipv4complete and tcp_gso_ipv6complete
+ *
+ * Description:
+ *   Update the IP length, IP ID and checksums of a segment whose headers
+ *   were copied from the first segment of a large send.
+ *
+ * Parameters:
+ *   dev - The device driver structure holding the segment in d_buf
+ *   ip  - The start of the IP header in d_buf
+ *   tcp - The TCP header in d_buf
+ *
+ * Return:
+ *   None
+ *
+ * Assumptions:
+ *   Called with the network locked.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_IPv4
+static void tcp_gso_ipv4complete(FAR struct net_driver_s *dev,
+                                 FAR uint8_t *ip,
+                                 FAR struct tcp_hdr_s *tcp)
+{
+  FAR struct ipv4_hdr_s *ipv4 = (FAR struct ipv4_hdr_s *)ip;
+
+  ipv4->len[0]   = (dev->d_len >> 8);
+  ipv4->len[1]   = (dev->d_len & 0xff);
+
+  ++g_ipid;
+  ipv4->ipid[0]  = g_ipid >> 8;
+  ipv4->ipid[1]  = g_ipid & 0xff;
+
+  tcp->tcpchksum = 0;
+  tcp->tcpchksum = ~tcp_ipv4_chksum(dev);
+
+  ipv4->ipchksum = 0;
+  ipv4->ipchksum = ~ipv4_chksum(dev);
+
+#ifdef CONFIG_NET_STATISTICS
+  g_netstats.ipv4.sent++;
+#endif
+}
+#endif /* CONFIG_NET_IPv4 */
+
+#ifdef CONFIG_NET_IPv6
+static void tcp_gso_ipv6complete(FAR struct net_driver_s *dev,
+                                 FAR uint8_t *ip,
+                                 FAR struct tcp_hdr_s *tcp)
+{
+  FAR struct ipv6_hdr_s *ipv6 = (FAR struct ipv6_hdr_s *)ip;
+  uint16_t iplen = dev->d_len - IPv6_HDRLEN;
+
+  ipv6->len[0]   = (iplen >> 8);
+  ipv6->len[1]   = (iplen & 0xff);
+
+  tcp->tcpchksum = 0;
+  tcp->tcpchksum = ~tcp_ipv6_chksum(dev);
+
+#ifdef CONFIG_NET_STATISTICS
+  g_netstats.ipv6.sent++;
+#endif
+}
+#endif /* CONFIG_NET_IPv6 */
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: tcp_gso_output
+ *
+ * Description:
+ *   Pass the outgoing packet that resulted from a TCP poll to the driver.
+ *   If the packet is the first segment of a large send, the remaining
+ *   segments are built from its headers and passed to the driver one at a
+ *   time, unless the driver segments large sends itself (NETDEV_TSO).
+ *
+ *   Only the sequence number, the IP length, the IP ID and the checksums
+ *   differ from one segment to the next.  Everything else, including any
+ *   TCP options, is copied from the first segment.
+ *
+ * Parameters:
+ *   dev      - The device driver structure holding the outgoing packet
+ *   callback - The driver's TX poll callback
+ *
+ * Return:
+ *   The value returned by the last call to the callback.  If the driver
+ *   stops the poll part way through a large send, the segments not yet
+ *   passed to it are dropped and will be recovered like lost segments.
+ *
+ * Assumptions:
+ *   Called with the network locked.
+ *
+ ****************************************************************************/
+
+int tcp_gso_output(FAR struct net_driver_s *dev,
+                   CODE int (*callback)(FAR struct net_driver_s *dev))
+{
+  uint8_t hdr[GSO_MAX_HDRLEN];
+  CODE void (*complete)(FAR struct net_driver_s *dev, FAR uint8_t *ip,
+                        FAR struct tcp_hdr_s *tcp);
+  FAR struct tcp_hdr_s *tcp;
+  FAR struct iob_s *iob;
+  FAR uint8_t *ip;
+  unsigned int remaining;
+  unsigned int offset;
+  unsigned int segsize;
+  unsigned int seglen;
+  unsigned int hdrlen;
+  unsigned int iplen;
+  uint32_t seqno;
+  int bstop;
+
+  /* Nothing more to do unless this is the first segment of a large send
+   * and the driver leaves the segmentation to us.
+   */
+
+  if (dev->d_gsolen == 0 || dev->d_len == 0 ||
+      (dev->d_features & NETDEV_TSO) != 0)
+    {
+      bstop = callback(dev);
+      dev->d_gsolen = 0;
+      return bstop;
+    }
+
+  iob           = dev->d_gsoiob;
+  offset        = dev->d_gsooffset;
+  remaining     = dev->d_gsolen;
+  segsize       = dev->d_gsosize;
+  dev->d_gsolen = 0;
+
+  /* Keep the IP and TCP headers of the first segment as the template for
+   * the others.  The driver may overwrite d_buf when it sends the first
+   * segment.
+   */
+
+  ip     = &dev->d_buf[NET_LL_HDRLEN(dev)];
+  hdrlen = dev->d_len - dev->d_sndlen;
+  DEBUGASSERT(hdrlen <= GSO_MAX_HDRLEN);
+
+  memcpy(hdr, ip, hdrlen);
+
+#ifdef CONFIG_NET_IPv6
+#ifdef CONFIG_NET_IPv4
+  if ((hdr[0] & IP_VERSION_MASK) == IPv6_VERSION)
+#endif
+    {
+      iplen    = IPv6_HDRLEN;
+      complete = tcp_gso_ipv6complete;
+    }
+#endif /* CONFIG_NET_IPv6 */
+
+#ifdef CONFIG_NET_IPv4
+#ifdef CONFIG_NET_IPv6
+  else
+#endif
+    {
+      iplen    = IPv4_HDRLEN;
+      complete = tcp_gso_ipv4complete;
+    }
+#endif /* CONFIG_NET_IPv4 */
+
+  tcp    = (FAR struct tcp_hdr_s *)(ip + iplen);
+  seqno  = tcp_getsequence(tcp->seqno) + dev->d_sndlen;
+
+  ninfo("Large send: hdrlen=%u first=%u remaining=%u segsize=%u\n",
+        hdrlen, dev->d_sndlen, remaining, segsize);
+
+  /* Send the first segment as it is, then the rest */
+
+  bstop = callback(dev);
+
+  while (!bstop && remaining > 0)
+    {
+      seglen = MIN(remaining, segsize);
+
+      memcpy(ip, hdr, hdrlen);
+      iob_copyout(ip + hdrlen, iob, seglen, offset);
+
+      dev->d_len    = hdrlen + seglen;
+      dev->d_sndlen = seglen;
+      tcp_setsequence(tcp->seqno, seqno);
+      complete(dev, ip, tcp);
+
+#ifdef CONFIG_NET_STATISTICS
+      g_netstats.tcp.sent++;
+#endif
+
+      bstop      = callback(dev);
+
+      seqno     += seglen;
+      offset    += seglen;
+      remaining -= seglen;
+    }
+
+  if (remaining > 0)
+    {
+      nwarn("WARNING: Poll stopped, %u bytes of large send dropped\n",
+            remaining);
+    }
+
+  return bstop;
+}
+
+#endif /* CONFIG_NET && CONFIG_NET_TCP && CONFIG_NET_TCP_GSO */
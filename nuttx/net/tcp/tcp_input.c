@@ -50,6 +50,7 @@
 #include <string.h>
 #include <debug.h>
 
+#include <nuttx/clock.h>
 #include <nuttx/net/netconfig.h>
 #include <nuttx/net/netdev.h>
 #include <nuttx/net/netstats.h>
@@ -64,6 +65,38 @@
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: tcp_rttest
+ *
+ * Description:
+ *   Update the RTT estimate and the retransmission time-out from one
+ *   round trip time sample.
+ *
+ * Parameters:
+ *   conn - The TCP connection structure
+ *   m    - The RTT sample in units of the TCP timer
+ *
+ * Return:
+ *   None
+ *
+ ****************************************************************************/
+
+static void tcp_rttest(FAR struct tcp_conn_s *conn, signed char m)
+{
+  /* This is taken directly from VJs original code in his paper */
+
+  m = m - (conn->sa >> 3);
+  conn->sa += m;
+  if (m < 0)
+    {
+      m = -m;
+    }
+
+  m = m - (conn->sv >> 2);
+  conn->sv += m;
+  conn->rto = (conn->sa >> 3) + conn->sv;
+}
+
 /****************************************************************************
  * Name: tcp_input
  *
@@ -89,13 +122,13 @@ static void tcp_input(FAR struct net_driver_s *dev, uint8_t domain,
   FAR struct tcp_hdr_s *tcp;
   FAR struct tcp_conn_s *conn = NULL;
   unsigned int tcpiplen;
-  unsigned int hdrlen;
   uint16_t tmp16;
   uint16_t flags;
   uint16_t result;
-  uint8_t  opt;
   int      len;
-  int      i;
+#ifdef HAVE_TCP_SEGOPTS
+  struct tcp_segopts_s segopts;
+#endif
 
 #ifdef CONFIG_NET_STATISTICS
   /* Bump up the count of TCP packets received */
@@ -113,10 +146,6 @@ static void tcp_input(FAR struct net_driver_s *dev, uint8_t domain,
 
   tcpiplen = iplen + TCP_HDRLEN;
 
-  /* Get the size of the link layer header, the IP header, and the TCP header */
-
-  hdrlen = tcpiplen + NET_LL_HDRLEN(dev);
-
   /* Start of TCP input header processing code. */
 
   if (tcp_chksum(dev) != 0xffff)
@@ -224,58 +253,9 @@ static void tcp_input(FAR struct net_driver_s *dev, uint8_t domain,
 
           net_incr32(conn->rcvseq, 1);
 
-          /* Parse the TCP MSS option, if present. */
+          /* Parse the TCP MSS and other options, if present. */
 
-          if ((tcp->tcpoffset & 0xf0) > 0x50)
-            {
-              for (i = 0; i < ((tcp->tcpoffset >> 4) - 5) << 2 ; )
-                {
-                  opt = dev->d_buf[hdrlen + i];
-                  if (opt == TCP_OPT_END)
-                    {
-                      /* End of options. */
-
-                      break;
-                    }
-                  else if (opt == TCP_OPT_NOOP)
-                    {
-                      /* NOP option. */
-
-                      ++i;
-                    }
-                  else if (opt == TCP_OPT_MSS &&
-                          dev->d_buf[hdrlen + 1 + i] == TCP_OPT_MSS_LEN)
-                    {
-                      uint16_t tcp_mss = TCP_MSS(dev, iplen);
-
-                      /* An MSS option with the right option length. */
-
-                      tmp16 = ((uint16_t)dev->d_buf[hdrlen + 2 + i] << 8) |
-                               (uint16_t)dev->d_buf[hdrlen + 3 + i];
-                      conn->mss = tmp16 > tcp_mss ? tcp_mss : tmp16;
-
-                      /* And we are done processing options. */
-
-                      break;
-                    }
-                  else
-                    {
-                      /* All other options have a length field, so that we easily
-                       * can skip past them.
-                       */
-
-                      if (dev->d_buf[hdrlen + 1 + i] == 0)
-                        {
-                          /* If the length field is zero, the options are malformed
-                           * and we don't process them further.
-                           */
-
-                          break;
-                        }
-                      i += dev->d_buf[hdrlen + 1 + i];
-                    }
-                }
-            }
+          tcp_synopts(dev, conn, tcp, iplen);
 
           /* Our response will be a SYNACK. */
 
@@ -309,6 +289,15 @@ found:
 
   conn->winsize = ((uint16_t)tcp->wnd[0] << 8) + (uint16_t)tcp->wnd[1];
 
+#ifdef CONFIG_NET_TCP_WINDOW_SCALE
+  /* The window field of a SYN is never scaled */
+
+  if ((conn->tcpopts & TCP_OPTF_WSCALE) != 0 && (tcp->flags & TCP_SYN) == 0)
+    {
+      conn->winsize <<= conn->snd_wscale;
+    }
+#endif
+
   flags = 0;
 
   /* We do a very naive form of TCP reset processing; we just accept
@@ -377,6 +366,50 @@ found:
 
   dev->d_len -= (len + iplen);
 
+#ifdef HAVE_TCP_SEGOPTS
+  /* Get the timestamps and SACK options carried by the segment */
+
+  tcp_segopts(conn, tcp, &segopts);
+#endif
+
+#ifdef CONFIG_NET_TCP_TIMESTAMPS
+  if (segopts.ts &&
+      (conn->tcpstateflags & TCP_STATE_MASK) >= TCP_ESTABLISHED)
+    {
+      /* PAWS:  A segment with a timestamp older than the last one
+       * recorded is an old duplicate.  Drop it but send an ACK
+       * (RFC 7323).
+       */
+
+      if (TCP_SEQ_LT(segopts.tsval, conn->ts_recent))
+        {
+          ninfo("PAWS: tsval=%u ts_recent=%u\n",
+                segopts.tsval, conn->ts_recent);
+          tcp_send(dev, conn, TCP_ACK, tcpiplen);
+          return;
+        }
+
+      /* Record the timestamp to be echoed from the segment that is next
+       * in sequence.
+       */
+
+      if (memcmp(tcp->seqno, conn->rcvseq, 4) == 0)
+        {
+          conn->ts_recent = segopts.tsval;
+        }
+    }
+#endif
+
+  /* Any payload follows the TCP options.  Move it to d_appdata where the
+   * rest of the stack expects it (and where any response is built).
+   */
+
+  if (len > TCP_HDRLEN && dev->d_len > 0 && (tcp->flags & TCP_SYN) == 0)
+    {
+      memmove(dev->d_appdata, (FAR uint8_t *)dev->d_appdata +
+              (len - TCP_HDRLEN), dev->d_len);
+    }
+
   /* First, check if the sequence number of the incoming packet is
    * what we're expecting next. If not, we send out an ACK with the
    * correct numbers in, unless we are in the SYN_RCVD state and
@@ -465,32 +498,51 @@ found:
 
       /* Do RTT estimation, unless we have done retransmissions. */
 
-      if (conn->nrtx == 0)
+#ifdef CONFIG_NET_TCP_TIMESTAMPS
+      if ((conn->tcpopts & TCP_OPTF_TSTAMP) != 0)
         {
-          signed char m;
-          m = conn->rto - conn->timer;
-
-          /* This is taken directly from VJs original code in his paper */
+          /* The echoed timestamp gives an unambiguous sample, even for
+           * retransmitted data (RFC 7323).  Only ACKs of new data are
+           * used:  A duplicate ACK echoes an older timestamp.
+           */
 
-          m = m - (conn->sa >> 3);
-          conn->sa += m;
-          if (m < 0)
+          if (segopts.ts && segopts.tsecr != 0 &&
+              TCP_SEQ_GT(ackseq, conn->lastack))
             {
-              m = -m;
+              uint32_t rtt = TICK2HSEC(tcp_tsnow() - segopts.tsecr);
+              tcp_rttest(conn, rtt > 127 ? 127 : (signed char)rtt);
             }
+        }
+      else
+#endif
+      if (conn->nrtx == 0)
+        {
+          systime_t rtt = tcp_timer_elapsed(conn);
+          tcp_rttest(conn, rtt > 127 ? 127 : (signed char)rtt);
+        }
+
+#ifdef CONFIG_NET_TCP_CC
+      /* Let congestion control account for the ACK.  A segment with no
+       * payload and no SYN or FIN is a duplicate ACK candidate.
+       */
 
-          m = m - (conn->sv >> 2);
-          conn->sv += m;
-          conn->rto = (conn->sa >> 3) + conn->sv;
+      if ((conn->tcpstateflags & TCP_STATE_MASK) == TCP_ESTABLISHED)
+        {
+          tcp_cc_ack(conn, ackseq, dev->d_len == 0 &&
+                     (tcp->flags & (TCP_SYN | TCP_FIN)) == 0);
+#ifdef CONFIG_NET_TCP_SACK
+          tcp_sack_ack(conn, ackseq, &segopts);
+#endif
         }
 
+#endif
         /* Set the acknowledged flag. */
 
        flags |= TCP_ACKDATA;
 
        /* Reset the retransmission timer. */
 
-       conn->timer = conn->rto;
+       tcp_settimer(conn, conn->rto);
     }
 
   /* Do different things depending on in what state the connection is. */
@@ -546,6 +598,9 @@ found:
             tcp_setsequence(conn->sndseq, conn->isn);
             conn->sent          = 0;
             conn->sndseq_max    = 0;
+#endif
+#ifdef CONFIG_NET_TCP_CC
+            tcp_cc_init(conn);
 #endif
             conn->unacked       = 0;
             flags               = TCP_CONNECTED;
@@ -582,59 +637,9 @@ found:
 
         if ((flags & TCP_ACKDATA) != 0 && (tcp->flags & TCP_CTL) == (TCP_SYN | TCP_ACK))
           {
-            /* Parse the TCP MSS option, if present. */
+            /* Parse the TCP MSS and other options, if present. */
 
-            if ((tcp->tcpoffset & 0xf0) > 0x50)
-              {
-                for (i = 0; i < ((tcp->tcpoffset >> 4) - 5) << 2 ; )
-                  {
-                    opt = dev->d_buf[hdrlen + i];
-                    if (opt == TCP_OPT_END)
-                      {
-                        /* End of options. */
-
-                        break;
-                      }
-                    else if (opt == TCP_OPT_NOOP)
-                      {
-                        /* NOP option. */
-
-                        ++i;
-                      }
-                    else if (opt == TCP_OPT_MSS &&
-                              dev->d_buf[hdrlen + 1 + i] == TCP_OPT_MSS_LEN)
-                      {
-                        uint16_t tcp_mss = TCP_MSS(dev, iplen);
-
-                        /* An MSS option with the right option length. */
-
-                        tmp16 =
-                          (dev->d_buf[hdrlen + 2 + i] << 8) |
-                          dev->d_buf[hdrlen + 3 + i];
-                        conn->mss = tmp16 > tcp_mss ? tcp_mss : tmp16;
-
-                        /* And we are done processing options. */
-
-                        break;
-                      }
-                    else
-                      {
-                        /* All other options have a length field, so that we
-                         * easily can skip past them.
-                         */
-
-                        if (dev->d_buf[hdrlen + 1 + i] == 0)
-                          {
-                            /* If the length field is zero, the options are
-                             * malformed and we don't process them further.
-                             */
-
-                            break;
-                          }
-                        i += dev->d_buf[hdrlen + 1 + i];
-                      }
-                  }
-              }
+            tcp_synopts(dev, conn, tcp, iplen);
 
             conn->tcpstateflags = TCP_ESTABLISHED;
             memcpy(conn->rcvseq, tcp->seqno, 4);
@@ -645,6 +650,9 @@ found:
 #ifdef CONFIG_NET_TCP_WRITE_BUFFERS
             conn->isn           = tcp_getsequence(tcp->ackno);
             tcp_setsequence(conn->sndseq, conn->isn);
+#endif
+#ifdef CONFIG_NET_TCP_CC
+            tcp_cc_init(conn);
 #endif
             dev->d_len          = 0;
             dev->d_sndlen       = 0;
@@ -718,6 +726,7 @@ found:
             conn->tcpstateflags = TCP_LAST_ACK;
             conn->unacked       = 1;
             conn->nrtx          = 0;
+            tcp_settimer(conn, conn->rto);
             ninfo("TCP state: TCP_LAST_ACK\n");
 
             tcp_send(dev, conn, TCP_FIN | TCP_ACK, tcpiplen);
@@ -810,6 +819,19 @@ found:
                 net_incr32(conn->rcvseq, len);
               }
 
+#ifdef CONFIG_NET_TCP_DELAYED_ACK
+            /* If the new data is to be ACKed but there is nothing to send
+             * that could carry the ACK, then the ACK may be delayed.
+             */
+
+            if (len > 0 && dev->d_sndlen == 0 &&
+                (result & (TCP_SNDACK | TCP_CLOSE | TCP_ABORT | NETDEV_DOWN))
+                == TCP_SNDACK && tcp_delack(conn))
+              {
+                goto drop;
+              }
+#endif
+
             /* Send the response, ACKing the data or not, as appropriate */
 
             tcp_appsend(dev, conn, result);
@@ -848,8 +870,8 @@ found:
             if ((flags & TCP_ACKDATA) != 0)
               {
                 conn->tcpstateflags = TCP_TIME_WAIT;
-                conn->timer         = 0;
                 conn->unacked       = 0;
+                tcp_settimer(conn, 0);
                 ninfo("TCP state: TCP_TIME_WAIT\n");
               }
             else
@@ -867,6 +889,7 @@ found:
           {
             conn->tcpstateflags = TCP_FIN_WAIT_2;
             conn->unacked = 0;
+            tcp_timer_update(conn);
             ninfo("TCP state: TCP_FIN_WAIT_2\n");
             goto drop;
           }
@@ -888,7 +911,7 @@ found:
         if ((tcp->flags & TCP_FIN) != 0)
           {
             conn->tcpstateflags = TCP_TIME_WAIT;
-            conn->timer         = 0;
+            tcp_settimer(conn, 0);
             ninfo("TCP state: TCP_TIME_WAIT\n");
 
             net_incr32(conn->rcvseq, 1);
@@ -913,7 +936,7 @@ found:
         if ((flags & TCP_ACKDATA) != 0)
           {
             conn->tcpstateflags = TCP_TIME_WAIT;
-            conn->timer        = 0;
+            tcp_settimer(conn, 0);
             ninfo("TCP state: TCP_TIME_WAIT\n");
           }
 
@@ -0,0 +1,455 @@
+/****************************************************************************
+ * net/tcp/tcp_options.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#if defined(CONFIG_NET) && defined(CONFIG_NET_TCP)
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <debug.h>
+
+#include <nuttx/clock.h>
+#include <nuttx/net/netconfig.h>
+#include <nuttx/net/netdev.h>
+#include <nuttx/net/tcp.h>
+
+#include "tcp/tcp.h"
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: tcp_getopt32 and tcp_putopt32
+ *
+ * Description:
+ *   Get or put an unaligned 32-bit value in network order.
+ *
+ ****************************************************************************/
+
+#ifdef HAVE_TCP_OPTIONS
+static inline uint32_t tcp_getopt32(FAR const uint8_t *ptr)
+{
+  return ((uint32_t)ptr[0] << 24) | ((uint32_t)ptr[1] << 16) |
+         ((uint32_t)ptr[2] << 8) | (uint32_t)ptr[3];
+}
+#endif
+
+#ifdef CONFIG_NET_TCP_TIMESTAMPS
+static inline void tcp_putopt32(FAR uint8_t *ptr, uint32_t value)
+{
+  ptr[0] = (uint8_t)(value >> 24);
+  ptr[1] = (uint8_t)(value >> 16);
+  ptr[2] = (uint8_t)(value >> 8);
+  ptr[3] = (uint8_t)value;
+}
+#endif
+
+/****************************************************************************
+ * Name: tcp_optlen
+ *
+ * Description:
+ *   Return the size of the options in a received TCP header.
+ *
+ ****************************************************************************/
+
+static inline unsigned int tcp_optlen(FAR struct tcp_hdr_s *tcp)
+{
+  unsigned int hdrlen = (tcp->tcpoffset >> 4) << 2;
+  return hdrlen > TCP_HDRLEN ? hdrlen - TCP_HDRLEN : 0;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: tcp_synopts
+ *
+ * Description:
+ *   Parse the options of a received SYN or SYN-ACK:  Set the MSS and
+ *   disable the TCP options that the peer did not offer.
+ *
+ * Parameters:
+ *   dev   - The device driver structure containing the received segment
+ *   conn  - The TCP connection structure
+ *   tcp   - The TCP header of the received segment
+ *   iplen - The size of the IP header
+ *
+ * Return:
+ *   None
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+void tcp_synopts(FAR struct net_driver_s *dev, FAR struct tcp_conn_s *conn,
+                 FAR struct tcp_hdr_s *tcp, unsigned int iplen)
+{
+  FAR const uint8_t *opts = (FAR const uint8_t *)tcp + TCP_HDRLEN;
+  unsigned int optlen = tcp_optlen(tcp);
+  unsigned int i;
+#ifdef HAVE_TCP_OPTIONS
+  uint8_t offered = 0;
+#endif
+
+  for (i = 0; i < optlen; )
+    {
+      uint8_t opt = opts[i];
+      uint8_t len;
+
+      if (opt == TCP_OPT_END)
+        {
+          /* End of options. */
+
+          break;
+        }
+      else if (opt == TCP_OPT_NOOP)
+        {
+          /* NOP option. */
+
+          i++;
+          continue;
+        }
+
+      /* All other options have a length field, so that we easily can skip
+       * past them.  If the length field is bad, the options are malformed
+       * and we don't process them further.
+       */
+
+      if (i + 1 >= optlen)
+        {
+          break;
+        }
+
+      len = opts[i + 1];
+      if (len < 2 || i + len > optlen)
+        {
+          break;
+        }
+
+      if (opt == TCP_OPT_MSS && len == TCP_OPT_MSS_LEN)
+        {
+          uint16_t tcp_mss = TCP_MSS(dev, iplen);
+          uint16_t tmp16;
+
+          /* An MSS option with the right option length. */
+
+          tmp16 = ((uint16_t)opts[i + 2] << 8) | (uint16_t)opts[i + 3];
+          conn->mss = tmp16 > tcp_mss ? tcp_mss : tmp16;
+        }
+#ifdef CONFIG_NET_TCP_WINDOW_SCALE
+      else if (opt == TCP_OPT_WS && len == TCP_OPT_WS_LEN)
+        {
+          conn->snd_wscale = opts[i + 2] > TCP_MAX_WSCALE ?
+                             TCP_MAX_WSCALE : opts[i + 2];
+          offered |= TCP_OPTF_WSCALE;
+        }
+#endif
+#ifdef CONFIG_NET_TCP_SACK
+      else if (opt == TCP_OPT_SACK_PERM && len == TCP_OPT_SACK_PERM_LEN)
+        {
+          offered |= TCP_OPTF_SACK;
+        }
+#endif
+#ifdef CONFIG_NET_TCP_TIMESTAMPS
+      else if (opt == TCP_OPT_TS && len == TCP_OPT_TS_LEN)
+        {
+          conn->ts_recent = tcp_getopt32(&opts[i + 2]);
+          offered |= TCP_OPTF_TSTAMP;
+        }
+#endif
+
+      i += len;
+    }
+
+#ifdef HAVE_TCP_OPTIONS
+  /* Only options offered by both sides may be used */
+
+  conn->tcpopts &= offered;
+  ninfo("TCP options: %02x\n", conn->tcpopts);
+#endif
+
+#ifdef CONFIG_NET_TCP_TIMESTAMPS
+  /* Every segment will carry the timestamps option.  Leave room for it
+   * within the MSS.
+   */
+
+  if ((conn->tcpopts & TCP_OPTF_TSTAMP) != 0 &&
+      conn->mss > 2 * TCP_TSOPT_SIZE)
+    {
+      conn->mss -= TCP_TSOPT_SIZE;
+    }
+#endif
+}
+
+/****************************************************************************
+ * Name: tcp_buildsynopts
+ *
+ * Description:
+ *   Generate the options for an outgoing SYN or SYN-ACK.
+ *
+ * Parameters:
+ *   dev  - The device driver structure to use in the send operation
+ *   conn - The TCP connection structure
+ *   opts - The location of the options in the outgoing TCP header
+ *   mss  - The MSS to advertise
+ *
+ * Return:
+ *   The size of the options in bytes (a multiple of four)
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+unsigned int tcp_buildsynopts(FAR struct net_driver_s *dev,
+                              FAR struct tcp_conn_s *conn,
+                              FAR uint8_t *opts, uint16_t mss)
+{
+  unsigned int optlen;
+
+  /* We always send out the TCP Maximum Segment Size option. */
+
+  opts[0] = TCP_OPT_MSS;
+  opts[1] = TCP_OPT_MSS_LEN;
+  opts[2] = mss >> 8;
+  opts[3] = mss & 0xff;
+  optlen  = TCP_OPT_MSS_LEN;
+
+#ifdef CONFIG_NET_TCP_WINDOW_SCALE
+  if ((conn->tcpopts & TCP_OPTF_WSCALE) != 0)
+    {
+      uint32_t rcvwndo = NET_DEV_RCVWNDO(dev);
+      uint8_t shift = 0;
+
+      /* Select the smallest shift that lets the receive window be
+       * represented in the 16-bit window field.
+       */
+
+      while ((rcvwndo >> shift) > 0xffff && shift < TCP_MAX_WSCALE)
+        {
+          shift++;
+        }
+
+      conn->rcv_wscale = shift;
+
+      opts[optlen++] = TCP_OPT_NOOP;
+      opts[optlen++] = TCP_OPT_WS;
+      opts[optlen++] = TCP_OPT_WS_LEN;
+      opts[optlen++] = shift;
+    }
+#endif
+
+#ifdef CONFIG_NET_TCP_TIMESTAMPS
+  if ((conn->tcpopts & TCP_OPTF_TSTAMP) != 0)
+    {
+      /* The SACK permitted option, if any, takes the place of the two
+       * NOPs that would otherwise pad the timestamps option.
+       */
+
+#ifdef CONFIG_NET_TCP_SACK
+      if ((conn->tcpopts & TCP_OPTF_SACK) != 0)
+        {
+          opts[optlen++] = TCP_OPT_SACK_PERM;
+          opts[optlen++] = TCP_OPT_SACK_PERM_LEN;
+        }
+      else
+#endif
+        {
+          opts[optlen++] = TCP_OPT_NOOP;
+          opts[optlen++] = TCP_OPT_NOOP;
+        }
+
+      opts[optlen++] = TCP_OPT_TS;
+      opts[optlen++] = TCP_OPT_TS_LEN;
+      tcp_putopt32(&opts[optlen], tcp_tsnow());
+      tcp_putopt32(&opts[optlen + 4], conn->ts_recent);
+      optlen += 8;
+    }
+  else
+#endif
+    {
+#ifdef CONFIG_NET_TCP_SACK
+      if ((conn->tcpopts & TCP_OPTF_SACK) != 0)
+        {
+          opts[optlen++] = TCP_OPT_NOOP;
+          opts[optlen++] = TCP_OPT_NOOP;
+          opts[optlen++] = TCP_OPT_SACK_PERM;
+          opts[optlen++] = TCP_OPT_SACK_PERM_LEN;
+        }
+#endif
+    }
+
+  return optlen;
+}
+
+/****************************************************************************
+ * Name: tcp_segopts
+ *
+ * Description:
+ *   Parse the options of a received, non-SYN segment.
+ *
+ * Parameters:
+ *   conn    - The TCP connection structure
+ *   tcp     - The TCP header of the received segment
+ *   segopts - Location to return the options found
+ *
+ * Return:
+ *   None
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+#ifdef HAVE_TCP_SEGOPTS
+void tcp_segopts(FAR struct tcp_conn_s *conn, FAR struct tcp_hdr_s *tcp,
+                 FAR struct tcp_segopts_s *segopts)
+{
+  FAR const uint8_t *opts = (FAR const uint8_t *)tcp + TCP_HDRLEN;
+  unsigned int optlen = tcp_optlen(tcp);
+  unsigned int i;
+
+  memset(segopts, 0, sizeof(struct tcp_segopts_s));
+
+  if (conn->tcpopts == 0)
+    {
+      return;
+    }
+
+  for (i = 0; i < optlen; )
+    {
+      uint8_t opt = opts[i];
+      uint8_t len;
+
+      if (opt == TCP_OPT_END)
+        {
+          break;
+        }
+      else if (opt == TCP_OPT_NOOP)
+        {
+          i++;
+          continue;
+        }
+
+      if (i + 1 >= optlen)
+        {
+          break;
+        }
+
+      len = opts[i + 1];
+      if (len < 2 || i + len > optlen)
+        {
+          break;
+        }
+
+#ifdef CONFIG_NET_TCP_TIMESTAMPS
+      if (opt == TCP_OPT_TS && len == TCP_OPT_TS_LEN &&
+          (conn->tcpopts & TCP_OPTF_TSTAMP) != 0)
+        {
+          segopts->ts    = true;
+          segopts->tsval = tcp_getopt32(&opts[i + 2]);
+          segopts->tsecr = tcp_getopt32(&opts[i + 6]);
+        }
+#endif
+#ifdef CONFIG_NET_TCP_SACK
+      if (opt == TCP_OPT_SACK && (conn->tcpopts & TCP_OPTF_SACK) != 0 &&
+          len >= 2 + TCP_OPT_SACK_BLKLEN &&
+          ((len - 2) % TCP_OPT_SACK_BLKLEN) == 0)
+        {
+          FAR const uint8_t *blk = &opts[i + 2];
+          int nblocks = (len - 2) / TCP_OPT_SACK_BLKLEN;
+
+          /* Decode the blocks now:  The option space may be overwritten
+           * before they are used.
+           */
+
+          if (nblocks > TCP_SACK_NBLOCKS)
+            {
+              nblocks = TCP_SACK_NBLOCKS;
+            }
+
+          for (segopts->nsacks = 0; segopts->nsacks < nblocks;
+               segopts->nsacks++, blk += TCP_OPT_SACK_BLKLEN)
+            {
+              segopts->sacks[segopts->nsacks].left  = tcp_getopt32(blk);
+              segopts->sacks[segopts->nsacks].right = tcp_getopt32(blk + 4);
+            }
+        }
+#endif
+
+      i += len;
+    }
+}
+#endif /* HAVE_TCP_SEGOPTS */
+
+/****************************************************************************
+ * Name: tcp_buildtsopt
+ *
+ * Description:
+ *   Generate the NOP-padded timestamps option for an outgoing segment.
+ *
+ * Parameters:
+ *   conn - The TCP connection structure
+ *   opts - The location of the TCP_TSOPT_SIZE bytes of option space
+ *
+ * Return:
+ *   None
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_TCP_TIMESTAMPS
+void tcp_buildtsopt(FAR struct tcp_conn_s *conn, FAR uint8_t *opts)
+{
+  opts[0] = TCP_OPT_NOOP;
+  opts[1] = TCP_OPT_NOOP;
+  opts[2] = TCP_OPT_TS;
+  opts[3] = TCP_OPT_TS_LEN;
+  tcp_putopt32(&opts[4], tcp_tsnow());
+  tcp_putopt32(&opts[8], conn->ts_recent);
+}
+#endif
+
+#endif /* CONFIG_NET && CONFIG_NET_TCP */
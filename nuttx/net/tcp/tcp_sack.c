@@ -0,0 +1,281 @@
+/****************************************************************************
+ * net/tcp/tcp_sack.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+#if defined(CONFIG_NET) && defined(CONFIG_NET_TCP) && defined(CONFIG_NET_TCP_SACK)
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <debug.h>
+
+#include <nuttx/net/netconfig.h>
+#include <nuttx/net/tcp.h>
+
+#include "tcp/tcp.h"
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: tcp_sack_trim
+ *
+ * Description:
+ *   Discard the parts of the scoreboard that are covered by the cumulative
+ *   ACK.
+ *
+ ****************************************************************************/
+
+static void tcp_sack_trim(FAR struct tcp_conn_s *conn, uint32_t ackseq)
+{
+  int ndx;
+  int n = 0;
+
+  for (ndx = 0; ndx < conn->nsacks; ndx++)
+    {
+      FAR struct tcp_sack_s *sack = &conn->sacks[ndx];
+
+      if (TCP_SEQ_LTE(sack->right, ackseq))
+        {
+          continue;
+        }
+
+      if (TCP_SEQ_LT(sack->left, ackseq))
+        {
+          sack->left = ackseq;
+        }
+
+      conn->sacks[n++] = *sack;
+    }
+
+  conn->nsacks = n;
+}
+
+/****************************************************************************
+ * Name: tcp_sack_insert
+ *
+ * Description:
+ *   Merge one SACK block into the scoreboard, keeping the blocks in
+ *   sequence order and coalescing blocks that overlap or abut.  If the
+ *   scoreboard is full, the highest block is lost;  the holes nearest the
+ *   cumulative ACK are the ones to be retransmitted first.
+ *
+ ****************************************************************************/
+
+static void tcp_sack_insert(FAR struct tcp_conn_s *conn, uint32_t left,
+                            uint32_t right)
+{
+  struct tcp_sack_s tmp[TCP_SACK_NBLOCKS + 1];
+  int ndx;
+  int n;
+  int m;
+
+  /* Insert the new block in sequence order */
+
+  for (ndx = 0, n = 0;
+       ndx < conn->nsacks && TCP_SEQ_LTE(conn->sacks[ndx].left, left);
+       ndx++)
+    {
+      tmp[n++] = conn->sacks[ndx];
+    }
+
+  tmp[n].left  = left;
+  tmp[n].right = right;
+  n++;
+
+  for (; ndx < conn->nsacks; ndx++)
+    {
+      tmp[n++] = conn->sacks[ndx];
+    }
+
+  /* Coalesce blocks that overlap or abut */
+
+  for (ndx = 1, m = 1; ndx < n; ndx++)
+    {
+      if (TCP_SEQ_LTE(tmp[ndx].left, tmp[m - 1].right))
+        {
+          if (TCP_SEQ_GT(tmp[ndx].right, tmp[m - 1].right))
+            {
+              tmp[m - 1].right = tmp[ndx].right;
+            }
+        }
+      else
+        {
+          tmp[m++] = tmp[ndx];
+        }
+    }
+
+  n = m;
+  if (n > TCP_SACK_NBLOCKS)
+    {
+      n = TCP_SACK_NBLOCKS;
+    }
+
+  memcpy(conn->sacks, tmp, n * sizeof(struct tcp_sack_s));
+  conn->nsacks = n;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: tcp_sack_ack
+ *
+ * Description:
+ *   Update the SACK scoreboard on receipt of an ACK:  Discard what is now
+ *   covered by the cumulative ACK and merge in any SACK blocks carried by
+ *   the segment.  During fast recovery, request a retransmission if a
+ *   hole remains below the highest SACKed data.
+ *
+ * Parameters:
+ *   conn    - The TCP connection structure
+ *   ackseq  - The acknowledgement number of the received segment
+ *   segopts - The options of the received segment
+ *
+ * Return:
+ *   None
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked, after
+ *   tcp_cc_ack().
+ *
+ ****************************************************************************/
+
+void tcp_sack_ack(FAR struct tcp_conn_s *conn, uint32_t ackseq,
+                  FAR const struct tcp_segopts_s *segopts)
+{
+  uint32_t seqno;
+  uint32_t len;
+  int ndx;
+
+  tcp_sack_trim(conn, ackseq);
+
+  for (ndx = 0; ndx < segopts->nsacks; ndx++)
+    {
+      uint32_t left  = segopts->sacks[ndx].left;
+      uint32_t right = segopts->sacks[ndx].right;
+
+      /* Ignore blocks that are empty, already ACKed (D-SACK), or beyond
+       * anything that we have sent.
+       */
+
+      if (TCP_SEQ_GTE(left, right) || TCP_SEQ_LTE(right, ackseq) ||
+          TCP_SEQ_GT(right, conn->sndseq_max))
+        {
+          continue;
+        }
+
+      if (TCP_SEQ_LT(left, ackseq))
+        {
+          left = ackseq;
+        }
+
+      ninfo("SACK: %08x-%08x\n", left, right);
+      tcp_sack_insert(conn, left, right);
+    }
+
+  /* In fast recovery, each ACK may clock out a retransmission of the next
+   * hole rather than new data.
+   */
+
+  if ((conn->ccflags & TCP_CC_RECOVERY) != 0 &&
+      tcp_sack_nexthole(conn, &seqno, &len))
+    {
+      conn->ccflags |= TCP_CC_REXMIT;
+    }
+}
+
+/****************************************************************************
+ * Name: tcp_sack_nexthole
+ *
+ * Description:
+ *   Find the next range of data to be retransmitted during fast recovery:
+ *   The first un-SACKed data above both the cumulative ACK and the last
+ *   retransmission, and below the highest SACKed data.
+ *
+ * Parameters:
+ *   conn   - The TCP connection structure
+ *   seqno  - Location to return the first sequence number of the hole
+ *   len    - Location to return the size of the hole
+ *
+ * Return:
+ *   true if there is a hole to be retransmitted.
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+bool tcp_sack_nexthole(FAR struct tcp_conn_s *conn, FAR uint32_t *seqno,
+                       FAR uint32_t *len)
+{
+  uint32_t start;
+  int ndx;
+
+  start = conn->sack_rxt;
+  if (TCP_SEQ_LT(start, conn->lastack))
+    {
+      start = conn->lastack;
+    }
+
+  for (ndx = 0; ndx < conn->nsacks; ndx++)
+    {
+      FAR struct tcp_sack_s *sack = &conn->sacks[ndx];
+
+      if (TCP_SEQ_LT(start, sack->left))
+        {
+          *seqno = start;
+          *len   = sack->left - start;
+          return true;
+        }
+
+      if (TCP_SEQ_LT(start, sack->right))
+        {
+          start = sack->right;
+        }
+    }
+
+  /* Data above the highest SACKed block is not known to be lost */
+
+  return false;
+}
+
+#endif /* CONFIG_NET && CONFIG_NET_TCP && CONFIG_NET_TCP_SACK */
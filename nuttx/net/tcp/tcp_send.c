@@ -337,6 +337,15 @@ static void tcp_sendcommon(FAR struct net_driver_s *dev,
   memcpy(tcp->ackno, conn->rcvseq, 4);
   memcpy(tcp->seqno, conn->sndseq, 4);
 
+#ifdef CONFIG_NET_TCP_DELAYED_ACK
+  /* This segment acknowledges everything received so far, including any
+   * data whose ACK was being delayed.  The connection is left in the timer
+   * queue and is simply re-evaluated when it expires.
+   */
+
+  conn->tflags &= ~TCP_TF_DELACK;
+#endif
+
   tcp->srcport  = conn->lport;
   tcp->destport = conn->rport;
 
@@ -353,8 +362,25 @@ static void tcp_sendcommon(FAR struct net_driver_s *dev,
     }
   else
     {
-      tcp->wnd[0] = ((NET_DEV_RCVWNDO(dev)) >> 8);
-      tcp->wnd[1] = ((NET_DEV_RCVWNDO(dev)) & 0xff);
+      uint32_t rcvwndo = NET_DEV_RCVWNDO(dev);
+
+#ifdef CONFIG_NET_TCP_WINDOW_SCALE
+      /* The window field of a SYN is never scaled */
+
+      if ((conn->tcpopts & TCP_OPTF_WSCALE) != 0 &&
+          (tcp->flags & TCP_SYN) == 0)
+        {
+          rcvwndo >>= conn->rcv_wscale;
+        }
+#endif
+
+      if (rcvwndo > 0xffff)
+        {
+          rcvwndo = 0xffff;
+        }
+
+      tcp->wnd[0] = (rcvwndo >> 8);
+      tcp->wnd[1] = (rcvwndo & 0xff);
     }
 
   /* Finish the IP portion of the message and calculate checksums */
@@ -395,6 +421,46 @@ void tcp_send(FAR struct net_driver_s *dev, FAR struct tcp_conn_s *conn,
   tcp->flags     = flags;
   dev->d_len     = len;
   tcp->tcpoffset = (TCP_HDRLEN / 4) << 4;
+
+#ifdef CONFIG_NET_TCP_TIMESTAMPS
+  if ((conn->tcpopts & TCP_OPTF_TSTAMP) != 0)
+    {
+      FAR uint8_t *opts = (FAR uint8_t *)tcp + TCP_HDRLEN;
+      unsigned int iplen;
+
+#ifdef CONFIG_NET_IPv6
+#ifdef CONFIG_NET_IPv4
+      if (IFF_IS_IPv6(dev->d_flags))
+#endif
+        {
+          iplen = IPv6_HDRLEN;
+        }
+#endif
+
+#ifdef CONFIG_NET_IPv4
+#ifdef CONFIG_NET_IPv6
+      else
+#endif
+        {
+          iplen = IPv4_HDRLEN;
+        }
+#endif
+
+      /* Make room for the timestamps option between the TCP header and
+       * any payload.  The MSS has been reduced to allow for the option.
+       */
+
+      if (len > iplen + TCP_HDRLEN)
+        {
+          memmove(opts + TCP_TSOPT_SIZE, opts, len - iplen - TCP_HDRLEN);
+        }
+
+      tcp_buildtsopt(conn, opts);
+      dev->d_len    += TCP_TSOPT_SIZE;
+      tcp->tcpoffset = ((TCP_HDRLEN + TCP_TSOPT_SIZE) / 4) << 4;
+    }
+#endif
+
   tcp_sendcommon(dev, conn, tcp);
 }
 
@@ -537,6 +603,7 @@ void tcp_ack(FAR struct net_driver_s *dev, FAR struct tcp_conn_s *conn,
 {
   struct tcp_hdr_s *tcp;
   uint16_t tcp_mss;
+  unsigned int optlen;
 
   /* Get values that vary with the underlying IP domain */
 
@@ -550,9 +617,9 @@ void tcp_ack(FAR struct net_driver_s *dev, FAR struct tcp_conn_s *conn,
       tcp     = TCPIPv6BUF;
       tcp_mss = TCP_IPv6_MSS(dev);
 
-      /* Set the packet length for the TCP Maximum Segment Size */
+      /* Set the packet length to the size of the headers */
 
-      dev->d_len  = IPv6TCP_HDRLEN + TCP_OPT_MSS_LEN;
+      dev->d_len  = IPv6TCP_HDRLEN;
     }
 #endif /* CONFIG_NET_IPv6 */
 
@@ -566,9 +633,9 @@ void tcp_ack(FAR struct net_driver_s *dev, FAR struct tcp_conn_s *conn,
       tcp     = TCPIPv4BUF;
       tcp_mss = TCP_IPv4_MSS(dev);
 
-      /* Set the packet length for the TCP Maximum Segment Size */
+      /* Set the packet length to the size of the headers */
 
-      dev->d_len  = IPv4TCP_HDRLEN + TCP_OPT_MSS_LEN;
+      dev->d_len  = IPv4TCP_HDRLEN;
     }
 #endif /* CONFIG_NET_IPv4 */
 
@@ -576,13 +643,15 @@ void tcp_ack(FAR struct net_driver_s *dev, FAR struct tcp_conn_s *conn,
 
   tcp->flags      = ack;
 
-  /* We send out the TCP Maximum Segment Size option with our ack. */
+  /* We send out the TCP Maximum Segment Size option (and any other
+   * options to be negotiated) with our ack.
+   */
 
-  tcp->optdata[0] = TCP_OPT_MSS;
-  tcp->optdata[1] = TCP_OPT_MSS_LEN;
-  tcp->optdata[2] = tcp_mss >> 8;
-  tcp->optdata[3] = tcp_mss & 0xff;
-  tcp->tcpoffset  = ((TCP_HDRLEN + TCP_OPT_MSS_LEN) / 4) << 4;
+  optlen          = tcp_buildsynopts(dev, conn,
+                                     (FAR uint8_t *)tcp + TCP_HDRLEN,
+                                     tcp_mss);
+  dev->d_len     += optlen;
+  tcp->tcpoffset  = ((TCP_HDRLEN + optlen) / 4) << 4;
 
   /* Complete the common portions of the TCP message */
 
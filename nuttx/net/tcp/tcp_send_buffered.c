@@ -68,6 +68,7 @@
 #include <nuttx/net/netdev.h>
 #include <nuttx/net/arp.h>
 #include <nuttx/net/tcp.h>
+#include <nuttx/net/netstats.h>
 
 #include "socket/socket.h"
 #include "netdev/netdev.h"
@@ -311,6 +312,115 @@ static inline bool psock_send_addrchck(FAR struct tcp_conn_s *conn)
 #  define psock_send_addrchck(r) (true)
 #endif /* CONFIG_NET_ETHERNET */
 
+/****************************************************************************
+ * Name: psock_fast_rexmit
+ *
+ * Description:
+ *   Perform a fast retransmission:  Resend the first un-ACKed segment (or,
+ *   with SACK, the next hole) without waiting for the retransmission timer.
+ *   The segment is resent in place from its write buffer;  no write buffer
+ *   is moved and the counts of sent and un-ACKed bytes are unchanged.
+ *
+ * Parameters:
+ *   dev      The structure of the network driver that caused the interrupt
+ *   conn     The connection structure associated with the socket
+ *
+ * Returned Value:
+ *   true if a segment was set up for transmission.
+ *
+ * Assumptions:
+ *   Running at the interrupt level
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_TCP_CC
+static bool psock_fast_rexmit(FAR struct net_driver_s *dev,
+                              FAR struct tcp_conn_s *conn)
+{
+  FAR struct tcp_wrbuffer_s *wrb;
+  FAR sq_entry_t *entry;
+  uint32_t seqno;
+  uint32_t maxlen;
+  uint32_t avail = 0;
+  size_t sndlen;
+
+  conn->ccflags &= ~TCP_CC_REXMIT;
+
+  /* Select the data to be resent */
+
+  seqno  = conn->lastack;
+  maxlen = conn->mss;
+
+#ifdef CONFIG_NET_TCP_SACK
+  if (conn->nsacks > 0)
+    {
+      uint32_t holelen;
+
+      if (!tcp_sack_nexthole(conn, &seqno, &holelen))
+        {
+          return false;
+        }
+
+      if (holelen < maxlen)
+        {
+          maxlen = holelen;
+        }
+    }
+#endif
+
+  /* Find the write buffer holding that data:  Either one in the unacked_q
+   * or the partially sent write buffer at the head of the write_q.
+   */
+
+  for (entry = sq_peek(&conn->unacked_q); entry; entry = sq_next(entry))
+    {
+      wrb = (FAR struct tcp_wrbuffer_s *)entry;
+      if (TCP_SEQ_GTE(seqno, WRB_SEQNO(wrb)) &&
+          TCP_SEQ_LT(seqno, WRB_SEQNO(wrb) + WRB_PKTLEN(wrb)))
+        {
+          avail = WRB_SEQNO(wrb) + WRB_PKTLEN(wrb) - seqno;
+          break;
+        }
+    }
+
+  if (avail == 0)
+    {
+      wrb = (FAR struct tcp_wrbuffer_s *)sq_peek(&conn->write_q);
+      if (wrb == NULL || WRB_SENT(wrb) == 0 ||
+          TCP_SEQ_LT(seqno, WRB_SEQNO(wrb)) ||
+          TCP_SEQ_GTE(seqno, WRB_SEQNO(wrb) + WRB_SENT(wrb)))
+        {
+          return false;
+        }
+
+      avail = WRB_SEQNO(wrb) + WRB_SENT(wrb) - seqno;
+    }
+
+  sndlen = avail < maxlen ? avail : maxlen;
+
+  ninfo("FASTREXMIT: wrb=%p seqno=%u sndlen=%u\n", wrb, seqno, sndlen);
+
+  tcp_setsequence(conn->sndseq, seqno);
+
+#ifdef NEED_IPDOMAIN_SUPPORT
+  send_ipselect(dev, conn);
+#endif
+
+  devif_iob_send(dev, WRB_IOB(wrb), sndlen, seqno - WRB_SEQNO(wrb));
+
+#ifdef CONFIG_NET_TCP_SACK
+  /* The next hole, if any, will be resent on a later ACK */
+
+  conn->sack_rxt = seqno + sndlen;
+#endif
+
+#ifdef CONFIG_NET_STATISTICS
+  g_netstats.tcp.rexmit++;
+#endif
+  return true;
+}
+#endif
+
 /****************************************************************************
  * Name: psock_send_interrupt
  *
@@ -677,16 +787,41 @@ static uint16_t psock_send_interrupt(FAR struct net_driver_s *dev,
       return flags;
     }
 
+#ifdef CONFIG_NET_TCP_CC
+  /* Congestion control has detected a loss from duplicate ACKs.  Resend
+   * the missing segment now, unless the buffer holds incoming data.
+   */
+
+  if ((conn->ccflags & TCP_CC_REXMIT) != 0 &&
+      (conn->tcpstateflags & TCP_ESTABLISHED) &&
+      (flags & TCP_NEWDATA) == 0 && psock_send_addrchck(conn))
+    {
+      if (psock_fast_rexmit(dev, conn))
+        {
+          flags &= ~TCP_POLL;
+          return flags;
+        }
+    }
+
+#endif
   /* We get here if (1) not all of the data has been ACKed, (2) we have been
    * asked to retransmit data, (3) the connection is still healthy, and (4)
    * the outgoing packet is available for our use.  In this case, we are
    * now free to send more data to receiver -- UNLESS the buffer contains
    * unprocessed incoming data.  In that event, we will have to wait for the
    * next polling cycle.
+   *
+   * With congestion control, an ACK without new data also clocks out the
+   * next segment rather than waiting for the next poll.
    */
 
   if ((conn->tcpstateflags & TCP_ESTABLISHED) &&
+#ifdef CONFIG_NET_TCP_CC
+      ((flags & (TCP_POLL | TCP_REXMIT)) != 0 ||
+       (flags & (TCP_ACKDATA | TCP_NEWDATA)) == TCP_ACKDATA) &&
+#else
       (flags & (TCP_POLL | TCP_REXMIT)) &&
+#endif
       !(sq_empty(&conn->write_q)))
     {
       /* Check if the destination IP address is in the ARP  or Neighbor
@@ -698,8 +833,29 @@ static uint16_t psock_send_interrupt(FAR struct net_driver_s *dev,
         {
           FAR struct tcp_wrbuffer_s *wrb;
           uint32_t predicted_seqno;
+#ifdef CONFIG_NET_TCP_CC
+          uint32_t flight;
+#endif
+#ifdef CONFIG_NET_TCP_GSO
+          size_t maxlen;
+#endif
           size_t sndlen;
 
+#if defined(CONFIG_NET_TCP_GSO) && defined(CONFIG_NET_TCP_CC)
+          /* A device that accepts large sends is only given data on TX
+           * polls, where a large send can be split at the driver boundary.
+           * Rather than clocking out a single segment on this ACK, ask the
+           * driver to poll for all that the windows now allow.
+           */
+
+          if ((dev->d_features & (NETDEV_GSO | NETDEV_TSO)) != 0 &&
+              (flags & (TCP_POLL | TCP_REXMIT)) == 0)
+            {
+              netdev_txnotify_dev(dev);
+              return flags;
+            }
+#endif
+
           /* Peek at the head of the write queue (but don't remove anything
            * from the write queue yet).  We know from the above test that
            * the write_q is not empty.
@@ -715,10 +871,28 @@ static uint16_t psock_send_interrupt(FAR struct net_driver_s *dev,
            */
 
           sndlen = WRB_PKTLEN(wrb) - WRB_SENT(wrb);
+#ifdef CONFIG_NET_TCP_GSO
+          /* On a TX poll, a device that accepts large sends may be given
+           * several segments at once.
+           */
+
+          maxlen = conn->mss;
+          if ((dev->d_features & (NETDEV_GSO | NETDEV_TSO)) != 0 &&
+              (flags & TCP_POLL) != 0)
+            {
+              maxlen *= CONFIG_NET_TCP_GSO_MAXSEGS;
+            }
+
+          if (sndlen > maxlen)
+            {
+              sndlen = maxlen;
+            }
+#else
           if (sndlen > conn->mss)
             {
               sndlen = conn->mss;
             }
+#endif
 
           if (sndlen > conn->winsize)
             {
@@ -738,6 +912,46 @@ static uint16_t psock_send_interrupt(FAR struct net_driver_s *dev,
               WRB_SEQNO(wrb) = conn->isn + conn->sent;
             }
 
+#ifdef CONFIG_NET_TCP_CC
+          /* Do not exceed the congestion window.  The data in flight is
+           * measured from the last cumulative ACK to the end of this
+           * segment:  After a retransmission time-out, anything beyond
+           * the retransmission point is considered lost.  One segment may
+           * always be sent when nothing is in flight.
+           */
+
+          flight = WRB_SEQNO(wrb) + WRB_SENT(wrb) - conn->lastack;
+
+#ifdef CONFIG_NET_TCP_GSO
+          /* Trim a large send to the whole segments that still fit in the
+           * congestion window.
+           */
+
+          if (sndlen > conn->mss)
+            {
+              uint32_t avail = conn->cwnd;
+
+              if ((int32_t)flight > 0)
+                {
+                  avail = flight < conn->cwnd ? conn->cwnd - flight : 0;
+                }
+
+              avail -= avail % conn->mss;
+              if (sndlen > avail)
+                {
+                  sndlen = avail > conn->mss ? avail : conn->mss;
+                }
+            }
+
+#endif
+          if ((int32_t)flight > 0 && flight + sndlen > conn->cwnd)
+            {
+              ninfo("SEND: flight=%u sndlen=%u cwnd=%u\n",
+                    flight, sndlen, conn->cwnd);
+              return flags;
+            }
+#endif
+
           /* The TCP stack updates sndseq on receipt of ACK *before*
            * this function is called. In that case sndseq will point
            * to the next unacknowledged byte (which might have already
@@ -761,7 +975,17 @@ static uint16_t psock_send_interrupt(FAR struct net_driver_s *dev,
            * won't actually happen until the polling cycle completes).
            */
 
-          devif_iob_send(dev, WRB_IOB(wrb), sndlen, WRB_SENT(wrb));
+#ifdef CONFIG_NET_TCP_GSO
+          if (sndlen > conn->mss)
+            {
+              devif_iob_gsosend(dev, WRB_IOB(wrb), sndlen, WRB_SENT(wrb),
+                                conn->mss);
+            }
+          else
+#endif
+            {
+              devif_iob_send(dev, WRB_IOB(wrb), sndlen, WRB_SENT(wrb));
+            }
 
           /* Remember how much data we send out now so that we know
            * when everything has been acknowledged.  Just increment
@@ -772,6 +996,15 @@ static uint16_t psock_send_interrupt(FAR struct net_driver_s *dev,
           conn->unacked += sndlen;
           conn->sent    += sndlen;
 
+          /* Start the retransmission timer if there was no outstanding
+           * data.
+           */
+
+          if (conn->unacked == sndlen)
+            {
+              tcp_settimer(conn, conn->timer);
+            }
+
           /* Below prediction will become true, unless retransmission occurrence */
 
           predicted_seqno = tcp_getsequence(conn->sndseq) + sndlen;
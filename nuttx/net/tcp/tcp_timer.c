@@ -57,10 +57,308 @@
 #include "devif/devif.h"
 #include "tcp/tcp.h"
 
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+/* The timer queue:  Connections with a running timer, ordered by expiry */
+
+static FAR struct tcp_conn_s *g_tcp_timerhead;
+static FAR struct tcp_conn_s *g_tcp_timertail;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: tcp_timer_remove
+ *
+ * Description:
+ *   Remove a queued connection from the timer queue.
+ *
+ ****************************************************************************/
+
+static void tcp_timer_remove(FAR struct tcp_conn_s *conn)
+{
+  if (conn->tblink != NULL)
+    {
+      conn->tblink->tflink = conn->tflink;
+    }
+  else
+    {
+      g_tcp_timerhead = conn->tflink;
+    }
+
+  if (conn->tflink != NULL)
+    {
+      conn->tflink->tblink = conn->tblink;
+    }
+  else
+    {
+      g_tcp_timertail = conn->tblink;
+    }
+
+  conn->tflink  = NULL;
+  conn->tblink  = NULL;
+  conn->tflags &= ~TCP_TF_QUEUED;
+}
+
+/****************************************************************************
+ * Name: tcp_timer_insert
+ *
+ * Description:
+ *   Insert a connection into the timer queue in order of expiry.  The
+ *   search starts at the tail:  A newly started timer is usually the last
+ *   to expire.
+ *
+ ****************************************************************************/
+
+static void tcp_timer_insert(FAR struct tcp_conn_s *conn, systime_t expiry)
+{
+  FAR struct tcp_conn_s *prev;
+
+  for (prev = g_tcp_timertail;
+       prev != NULL && (ssystime_t)(prev->expiry - expiry) > 0;
+       prev = prev->tblink);
+
+  conn->expiry = expiry;
+  conn->tblink = prev;
+
+  if (prev != NULL)
+    {
+      conn->tflink = prev->tflink;
+      prev->tflink = conn;
+    }
+  else
+    {
+      conn->tflink    = g_tcp_timerhead;
+      g_tcp_timerhead = conn;
+    }
+
+  if (conn->tflink != NULL)
+    {
+      conn->tflink->tblink = conn;
+    }
+  else
+    {
+      g_tcp_timertail = conn;
+    }
+
+  conn->tflags |= TCP_TF_QUEUED;
+}
+
+/****************************************************************************
+ * Name: tcp_timer_deadline
+ *
+ * Description:
+ *   Determine the time at which the earliest running timer of a connection
+ *   expires.
+ *
+ * Return:
+ *   True if any timer is running; false otherwise.
+ *
+ ****************************************************************************/
+
+static bool tcp_timer_deadline(FAR struct tcp_conn_s *conn,
+                               FAR systime_t *expiry)
+{
+  uint8_t state = conn->tcpstateflags & TCP_STATE_MASK;
+  bool running  = false;
+
+  if (state == TCP_TIME_WAIT || state == TCP_FIN_WAIT_2)
+    {
+      /* Waiting for the connection to time out */
+
+      *expiry = conn->tmstart + TCP_TIME_WAIT_TIMEOUT * TICK_PER_HSEC;
+      running = true;
+    }
+  else if (state != TCP_CLOSED && state != TCP_ALLOCATED &&
+           conn->unacked > 0)
+    {
+      /* Retransmission timer */
+
+      *expiry = conn->tmstart + conn->timer * TICK_PER_HSEC;
+      running = true;
+    }
+
+#ifdef CONFIG_NET_TCP_DELAYED_ACK
+  if ((conn->tflags & TCP_TF_DELACK) != 0)
+    {
+      systime_t acktime = conn->acktime + TCP_DELACK_TICKS;
+
+      if (!running || (ssystime_t)(acktime - *expiry) < 0)
+        {
+          *expiry = acktime;
+          running = true;
+        }
+    }
+#endif
+
+  return running;
+}
+
 /****************************************************************************
  * Public Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: tcp_timer_expired
+ *
+ * Description:
+ *   Remove and return the first connection in the timer queue whose timer
+ *   has expired and that may be serviced by 'dev'.
+ *
+ * Parameters:
+ *   dev - The device driver structure that is polling
+ *   now - The current system time
+ *
+ * Return:
+ *   The expired connection or NULL if there is none
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+FAR struct tcp_conn_s *tcp_timer_expired(FAR struct net_driver_s *dev,
+                                         systime_t now)
+{
+  FAR struct tcp_conn_s *conn;
+
+  for (conn = g_tcp_timerhead;
+       conn != NULL && TCP_TIMER_DUE(now, conn->expiry);
+       conn = conn->tflink)
+    {
+#ifdef CONFIG_NETDEV_MULTINIC
+      /* A connection with running timers is bound to a device.  If it is
+       * not the polling device, then leave it in place:  It will be
+       * serviced on the next poll from the correct device.
+       */
+
+      DEBUGASSERT(conn->dev != NULL);
+      if (dev != conn->dev)
+        {
+          continue;
+        }
+#endif
+
+      tcp_timer_remove(conn);
+      return conn;
+    }
+
+  return NULL;
+}
+
+/****************************************************************************
+ * Name: tcp_timer_update
+ *
+ * Description:
+ *   Re-evaluate the timers of a connection after a change in its state
+ *   and make sure that it is queued to expire no later than the earliest
+ *   running timer.
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+void tcp_timer_update(FAR struct tcp_conn_s *conn)
+{
+  systime_t expiry;
+
+  if (tcp_timer_deadline(conn, &expiry))
+    {
+      if ((conn->tflags & TCP_TF_QUEUED) != 0)
+        {
+          /* Already queued to expire no later than needed? */
+
+          if ((ssystime_t)(conn->expiry - expiry) <= 0)
+            {
+              return;
+            }
+
+          tcp_timer_remove(conn);
+        }
+
+      tcp_timer_insert(conn, expiry);
+    }
+}
+
+/****************************************************************************
+ * Name: tcp_timer_cancel
+ *
+ * Description:
+ *   Remove a connection from the timer queue.
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+void tcp_timer_cancel(FAR struct tcp_conn_s *conn)
+{
+  if ((conn->tflags & TCP_TF_QUEUED) != 0)
+    {
+      tcp_timer_remove(conn);
+    }
+}
+
+/****************************************************************************
+ * Name: tcp_settimer
+ *
+ * Description:
+ *   (Re-)start the retransmission timer of a connection.
+ *
+ * Parameters:
+ *   conn - The TCP connection
+ *   hsec - The timeout in half-seconds
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+void tcp_settimer(FAR struct tcp_conn_s *conn, int hsec)
+{
+  conn->timer   = hsec;
+  conn->tmstart = clock_systimer();
+  tcp_timer_update(conn);
+}
+
+/****************************************************************************
+ * Name: tcp_delack
+ *
+ * Description:
+ *   Called when received data is to be ACKed with no outgoing data to
+ *   carry the ACK.
+ *
+ * Return:
+ *   True if the ACK was deferred; false if it must be sent now.
+ *
+ * Assumptions:
+ *   Called from network stack logic with the network stack locked
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_NET_TCP_DELAYED_ACK
+bool tcp_delack(FAR struct tcp_conn_s *conn)
+{
+  /* If an ACK is already pending, then this is the second segment:  ACK
+   * both now.  tcp_send() will clear the pending state.
+   */
+
+  if ((conn->tflags & TCP_TF_DELACK) != 0)
+    {
+      return false;
+    }
+
+  conn->tflags |= TCP_TF_DELACK;
+  conn->acktime = clock_systimer();
+  tcp_timer_update(conn);
+  return true;
+}
+#endif
+
 /****************************************************************************
  * Name: tcp_timer
  *
@@ -70,7 +368,6 @@
  * Parameters:
  *   dev  - The device driver structure to use in the send operation
  *   conn - The TCP "connection" to poll for TX data
- *   hsed - The polling interval in halves of a second
  *
  * Return:
  *   None
@@ -80,9 +377,9 @@
  *
  ****************************************************************************/
 
-void tcp_timer(FAR struct net_driver_s *dev, FAR struct tcp_conn_s *conn,
-               int hsec)
+void tcp_timer(FAR struct net_driver_s *dev, FAR struct tcp_conn_s *conn)
 {
+  systime_t now = clock_systimer();
   uint16_t result;
   uint8_t hdrlen;
 
@@ -124,259 +421,180 @@ void tcp_timer(FAR struct net_driver_s *dev, FAR struct tcp_conn_s *conn,
   dev->d_sndlen = 0;
 
   /* Check if the connection is in a state in which we simply wait
-   * for the connection to time out. If so, we increase the
-   * connection's timer and remove the connection if it times
-   * out.
+   * for the connection to time out.  If so, remove the connection if it
+   * has timed out.
    */
 
   if (conn->tcpstateflags == TCP_TIME_WAIT ||
       conn->tcpstateflags == TCP_FIN_WAIT_2)
     {
-      unsigned int newtimer;
-
-      /* Increment the connection timer */
-
-      newtimer = (unsigned int)conn->timer + hsec;
-
-      /* Check if the timer exceeds the timeout value */
-
-      if (newtimer >= TCP_TIME_WAIT_TIMEOUT)
+      if (TCP_TIMER_DUE(now, conn->tmstart +
+                        TCP_TIME_WAIT_TIMEOUT * TICK_PER_HSEC))
         {
-          /* Set the timer to the maximum value */
+          conn->tcpstateflags = TCP_CLOSED;
 
-          conn->timer = TCP_TIME_WAIT_TIMEOUT;
+          /* Notify upper layers about the timeout */
 
-#ifdef CONFIG_NETDEV_MULTINIC
-          /* The TCP connection was established and, hence, should be bound
-           * to a device. Make sure that the polling device is the one that
-           * we are bound to.
-           *
-           * If not, then we will catch the timeout on the next poll from
-           * the correct device.
-           */
-
-          DEBUGASSERT(conn->dev != NULL);
-          if (dev != conn->dev)
-            {
-              ninfo("TCP: TCP_CLOSED pending\n");
-            }
-          else
-#endif
-            {
-              conn->tcpstateflags = TCP_CLOSED;
+          result = tcp_callback(dev, conn, TCP_TIMEDOUT);
+          dev->d_len = 0;
 
-              /* Notify upper layers about the timeout */
-
-              result = tcp_callback(dev, conn, TCP_TIMEDOUT);
-
-              ninfo("TCP state: TCP_CLOSED\n");
-            }
-        }
-      else
-        {
-          /* No timeout. Just update the incremented timer */
-
-          conn->timer = newtimer;
+          ninfo("TCP state: TCP_CLOSED\n");
         }
     }
   else if (conn->tcpstateflags != TCP_CLOSED)
     {
-      /* If the connection has outstanding data, we increase the connection's
-       * timer and see if it has reached the RTO value in which case we
-       * retransmit.
+      /* If the connection has outstanding data and the retransmission
+       * timer has expired, then we retransmit.
        */
 
-      if (conn->unacked > 0)
+      if (conn->unacked > 0 &&
+          TCP_TIMER_DUE(now, conn->tmstart + conn->timer * TICK_PER_HSEC))
         {
-          /* The connection has outstanding data */
-
-          if (conn->timer > hsec)
-            {
-              /* Will not yet decrement to zero */
+          /* Check for a timeout on connection in the TCP_SYN_RCVD state.
+           * On such timeouts, we would normally resend the SYNACK until
+           * the ACK is received, completing the 3-way handshake.  But if
+           * the retry count elapsed, then we must assume that no ACK is
+           * forthcoming and terminate the attempted connection.
+           */
 
-              conn->timer -= hsec;
-            }
-          else
+          if (conn->tcpstateflags == TCP_SYN_RCVD &&
+              conn->nrtx >= TCP_MAXSYNRTX)
             {
-              /* Will decrement to zero */
-
-              conn->timer = 0;
-
-#ifdef CONFIG_NETDEV_MULTINIC
-              /* The TCP is connected and, hence, should be bound to a
-               * device. Make sure that the polling device is the one that
-               * we are bound to.
-               *
-               * If not, then we will catch the timeout on the next poll
-               * from the correct device.
-               */
-
-              DEBUGASSERT(conn->dev != NULL);
-              if (dev != conn->dev)
-                {
-                  ninfo("TCP: TCP_CLOSED pending\n");
-                  goto done;
-                }
-#endif
-              /* Check for a timeout on connection in the TCP_SYN_RCVD state.
-               * On such timeouts, we would normally resend the SYNACK until
-               * the ACK is received, completing the 3-way handshake.  But if
-               * the retry count elapsed, then we must assume that no ACK is
-               * forthcoming and terminate the attempted connection.
-               */
-
-              if (conn->tcpstateflags == TCP_SYN_RCVD &&
-                  conn->nrtx >= TCP_MAXSYNRTX)
-                {
-                  FAR struct tcp_conn_s *listener;
+              FAR struct tcp_conn_s *listener;
 
-                  conn->tcpstateflags = TCP_CLOSED;
-                  ninfo("TCP state: TCP_SYN_RCVD->TCP_CLOSED\n");
+              conn->tcpstateflags = TCP_CLOSED;
+              ninfo("TCP state: TCP_SYN_RCVD->TCP_CLOSED\n");
 
-                  /* Find the listener for this connection. */
+              /* Find the listener for this connection. */
 
 #if defined(CONFIG_NET_IPv4) && defined(CONFIG_NET_IPv6)
-                  listener = tcp_findlistener(conn->lport, conn->domain);
+              listener = tcp_findlistener(conn->lport, conn->domain);
 #else
-                  listener = tcp_findlistener(conn->lport);
+              listener = tcp_findlistener(conn->lport);
 #endif
-                  if (listener != NULL)
-                    {
-                      /* We call tcp_callback() for the connection with
-                       * TCP_TIMEDOUT to inform the listener that the
-                       * connection has timed out.
-                       */
+              if (listener != NULL)
+                {
+                  /* We call tcp_callback() for the connection with
+                   * TCP_TIMEDOUT to inform the listener that the
+                   * connection has timed out.
+                   */
 
-                      result = tcp_callback(dev, listener, TCP_TIMEDOUT);
-                    }
+                  result = tcp_callback(dev, listener, TCP_TIMEDOUT);
+                }
 
-                  /* We also send a reset packet to the remote host. */
+              /* We also send a reset packet to the remote host. */
 
-                  tcp_send(dev, conn, TCP_RST | TCP_ACK, hdrlen);
+              tcp_send(dev, conn, TCP_RST | TCP_ACK, hdrlen);
 
-                  /* Finally, we must free this TCP connection structure */
+              /* Finally, we must free this TCP connection structure */
 
-                  tcp_free(conn);
-                  goto done;
-                }
+              tcp_free(conn);
+              return;
+            }
 
-              /* Otherwise, check for a timeout on an established connection.
-               * If the retry count is exceeded in this case, we should
-               * close the connection.
-               */
+          /* Otherwise, check for a timeout on an established connection.
+           * If the retry count is exceeded in this case, we should
+           * close the connection.
+           */
 
-              else if (
+          else if (
 #ifdef CONFIG_NET_TCP_WRITE_BUFFERS
-                  conn->expired > 0 ||
+              conn->expired > 0 ||
 #else
-                  conn->nrtx >= TCP_MAXRTX ||
+              conn->nrtx >= TCP_MAXRTX ||
 #endif
-                  (conn->tcpstateflags == TCP_SYN_SENT &&
-                   conn->nrtx >= TCP_MAXSYNRTX)
-                 )
-                {
-                  conn->tcpstateflags = TCP_CLOSED;
-                  ninfo("TCP state: TCP_CLOSED\n");
+              (conn->tcpstateflags == TCP_SYN_SENT &&
+               conn->nrtx >= TCP_MAXSYNRTX)
+             )
+            {
+              conn->tcpstateflags = TCP_CLOSED;
+              ninfo("TCP state: TCP_CLOSED\n");
 
-                  /* We call tcp_callback() with TCP_TIMEDOUT to
-                   * inform the application that the connection has
-                   * timed out.
-                   */
+              /* We call tcp_callback() with TCP_TIMEDOUT to
+               * inform the application that the connection has
+               * timed out.
+               */
 
-                  result = tcp_callback(dev, conn, TCP_TIMEDOUT);
+              result = tcp_callback(dev, conn, TCP_TIMEDOUT);
 
-                  /* We also send a reset packet to the remote host. */
+              /* We also send a reset packet to the remote host. */
 
-                  tcp_send(dev, conn, TCP_RST | TCP_ACK, hdrlen);
-                  goto done;
-                }
+              tcp_send(dev, conn, TCP_RST | TCP_ACK, hdrlen);
+              goto done;
+            }
 
-             /* Exponential backoff. */
+          /* Exponential backoff. */
 
-              conn->timer = TCP_RTO << (conn->nrtx > 4 ? 4: conn->nrtx);
-              (conn->nrtx)++;
+          conn->timer   = TCP_RTO << (conn->nrtx > 4 ? 4: conn->nrtx);
+          conn->tmstart = now;
+          (conn->nrtx)++;
 
-              /* Ok, so we need to retransmit. We do this differently
-               * depending on which state we are in. In ESTABLISHED, we
-               * call upon the application so that it may prepare the
-               * data for the retransmit. In SYN_RCVD, we resend the
-               * SYNACK that we sent earlier and in LAST_ACK we have to
-               * retransmit our FINACK.
-               */
+          /* Ok, so we need to retransmit. We do this differently
+           * depending on which state we are in. In ESTABLISHED, we
+           * call upon the application so that it may prepare the
+           * data for the retransmit. In SYN_RCVD, we resend the
+           * SYNACK that we sent earlier and in LAST_ACK we have to
+           * retransmit our FINACK.
+           */
 
 #ifdef CONFIG_NET_STATISTICS
-              g_netstats.tcp.rexmit++;
+          g_netstats.tcp.rexmit++;
 #endif
-              switch (conn->tcpstateflags & TCP_STATE_MASK)
-                {
-                  case TCP_SYN_RCVD:
-                    /* In the SYN_RCVD state, we should retransmit our
-                     * SYNACK.
-                     */
+          switch (conn->tcpstateflags & TCP_STATE_MASK)
+            {
+              case TCP_SYN_RCVD:
+                /* In the SYN_RCVD state, we should retransmit our
+                 * SYNACK.
+                 */
 
-                    tcp_ack(dev, conn, TCP_ACK | TCP_SYN);
-                    goto done;
+                tcp_ack(dev, conn, TCP_ACK | TCP_SYN);
+                goto done;
 
-                  case TCP_SYN_SENT:
-                    /* In the SYN_SENT state, we retransmit out SYN. */
+              case TCP_SYN_SENT:
+                /* In the SYN_SENT state, we retransmit out SYN. */
 
-                    tcp_ack(dev, conn, TCP_SYN);
-                    goto done;
+                tcp_ack(dev, conn, TCP_SYN);
+                goto done;
 
-                  case TCP_ESTABLISHED:
-                    /* In the ESTABLISHED state, we call upon the application
-                     * to do the actual retransmit after which we jump into
-                     * the code for sending out the packet.
-                     */
+              case TCP_ESTABLISHED:
+                /* In the ESTABLISHED state, we call upon the application
+                 * to do the actual retransmit after which we jump into
+                 * the code for sending out the packet.
+                 */
 
-                    result = tcp_callback(dev, conn, TCP_REXMIT);
-                    tcp_rexmit(dev, conn, result);
-                    goto done;
+#ifdef CONFIG_NET_TCP_CC
+                tcp_cc_rto(conn);
+#endif
+                result = tcp_callback(dev, conn, TCP_REXMIT);
+                tcp_rexmit(dev, conn, result);
+                break;
 
-                  case TCP_FIN_WAIT_1:
-                  case TCP_CLOSING:
-                  case TCP_LAST_ACK:
-                    /* In all these states we should retransmit a FINACK. */
+              case TCP_FIN_WAIT_1:
+              case TCP_CLOSING:
+              case TCP_LAST_ACK:
+                /* In all these states we should retransmit a FINACK. */
 
-                    tcp_send(dev, conn, TCP_FIN | TCP_ACK, hdrlen);
-                    goto done;
-                }
+                tcp_send(dev, conn, TCP_FIN | TCP_ACK, hdrlen);
+                goto done;
             }
         }
 
-      /* The connection does not have outstanding data.  Check if the TCP
-       * connection has been established.
-       */
+#ifdef CONFIG_NET_TCP_DELAYED_ACK
+      /* If nothing else was sent, then send any delayed ACK that is due */
 
-      else if ((conn->tcpstateflags & TCP_STATE_MASK) == TCP_ESTABLISHED)
+      if (dev->d_len == 0 && (conn->tflags & TCP_TF_DELACK) != 0 &&
+          TCP_TIMER_DUE(now, conn->acktime + TCP_DELACK_TICKS))
         {
-          /* If there was no need for a retransmission, we poll the
-           * application for new data.
-           */
-
-#ifdef CONFIG_NETDEV_MULTINIC
-          /* The TCP connection is established and, hence, should be bound
-           * to a device. Make sure that the polling device is the one that
-           * we are bound to.
-           */
-
-          DEBUGASSERT(conn->dev != NULL);
-          if (dev == conn->dev)
-#endif
-            {
-              result = tcp_callback(dev, conn, TCP_POLL);
-              tcp_appsend(dev, conn, result);
-              goto done;
-            }
+          tcp_send(dev, conn, TCP_ACK, hdrlen);
         }
+#endif
     }
 
-  /* Nothing to be done */
+done:
 
-  dev->d_len = 0;
+  /* Re-queue the connection if any of its timers are still running */
 
-done:
-  return;
+  tcp_timer_update(conn);
 }
 
 #endif /* CONFIG_NET && CONFIG_NET_TCP */
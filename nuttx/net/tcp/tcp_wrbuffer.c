@@ -155,9 +155,12 @@ FAR struct tcp_wrbuffer_s *tcp_wrbuffer_alloc(void)
   DEBUGASSERT(wrb);
   memset(wrb, 0, sizeof(struct tcp_wrbuffer_s));
 
-  /* Now get the first I/O buffer for the write buffer structure */
+  /* Now get the first I/O buffer for the write buffer structure.  Don't
+   * wait for it with the network locked:  The IOBs that the network would
+   * free could never be freed.
+   */
 
-  wrb->wb_iob = iob_alloc(false);
+  wrb->wb_iob = net_ioballoc(false);
   if (!wrb->wb_iob)
     {
       nerr("ERROR: Failed to allocate I/O buffer\n");
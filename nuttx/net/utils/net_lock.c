@@ -47,6 +47,7 @@
 
 #include <nuttx/irq.h>
 #include <nuttx/arch.h>
+#include <nuttx/mm/iob.h>
 #include <nuttx/net/net.h>
 
 #include "utils/utils.h"
@@ -257,3 +258,68 @@ int net_lockedwait(sem_t *sem)
   return net_timedwait(sem, NULL);
 }
 
+/****************************************************************************
+ * Name: net_ioballoc
+ *
+ * Description:
+ *   Allocate an IOB.  If no IOB is available, then wait for one with the
+ *   lock on the network temporarily released so that the network can free
+ *   IOBs in the meantime.
+ *
+ * Input Parameters:
+ *   throttled - An indication of the IOB allocation is "throttled"
+ *
+ * Returned value:
+ *   A pointer to the newly allocated IOB is returned on success.  NULL is
+ *   returned on any allocation failure.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_MM_IOB
+FAR struct iob_s *net_ioballoc(bool throttled)
+{
+  FAR struct iob_s *iob;
+  pid_t        me;
+  unsigned int count;
+  irqstate_t   flags;
+
+  /* Try without waiting first */
+
+  iob = iob_tryalloc(throttled);
+  if (iob != NULL)
+    {
+      return iob;
+    }
+
+  me    = getpid();
+  flags = enter_critical_section(); /* No interrupts */
+  sched_lock();      /* No context switches */
+  if (g_holder == me)
+    {
+      /* Release the network lock, remembering my count */
+
+      count    = g_count;
+      g_holder = NO_HOLDER;
+      g_count  = 0;
+      sem_post(&g_netlock);
+
+      /* Wait for an IOB */
+
+      iob = iob_alloc(throttled);
+
+      /* Recover the network lock at the proper count */
+
+      _net_takesem();
+      g_holder = me;
+      g_count  = count;
+    }
+  else
+    {
+      iob = iob_alloc(throttled);
+    }
+
+  sched_unlock();
+  leave_critical_section(flags);
+  return iob;
+}
+#endif
@@ -193,6 +193,12 @@ static inline void group_release(FAR struct task_group_s *group)
   mq_release(group);
 #endif
 
+#ifdef CONFIG_FS_RAMMAP
+  /* Release file mappings created by members of the group */
+
+  rammap_release(group);
+#endif
+
 #if defined(CONFIG_BUILD_KERNEL) && defined(CONFIG_MM_SHM)
   /* Release any resource held by shared memory virtual page allocator */
 
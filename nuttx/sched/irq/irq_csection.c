@@ -49,7 +49,8 @@
 #include "sched/sched.h"
 #include "irq/irq.h"
 
-#if defined(CONFIG_SMP) || defined(CONFIG_SCHED_INSTRUMENTATION_CSECTION)
+#if defined(CONFIG_SMP) || defined(CONFIG_SCHED_INSTRUMENTATION_CSECTION) || \
+    defined(CONFIG_SCHED_CRITMONITOR)
 
 /****************************************************************************
  * Public Data
@@ -371,6 +372,11 @@ try_again:
                           &g_cpu_irqlock);
               rtcb->irqcount = 1;
 
+#ifdef CONFIG_SCHED_CRITMONITOR
+              /* Start timing the interrupts-off interval */
+
+              sched_critmon_enter(rtcb);
+#endif
 #ifdef CONFIG_SCHED_INSTRUMENTATION_CSECTION
               /* Note that we have entered the critical section */
 
@@ -384,7 +390,7 @@ try_again:
 
   return ret;
 }
-#else /* defined(CONFIG_SCHED_INSTRUMENTATION_CSECTION) */
+#else /* CONFIG_SCHED_INSTRUMENTATION_CSECTION || CONFIG_SCHED_CRITMONITOR */
 irqstate_t enter_critical_section(void)
 {
   irqstate_t ret;
@@ -402,6 +408,16 @@ irqstate_t enter_critical_section(void)
       FAR struct tcb_s *rtcb = this_task();
       DEBUGASSERT(rtcb != NULL);
 
+#ifdef CONFIG_SCHED_CRITMONITOR
+      /* Only the outermost call starts the interrupts-off interval */
+
+      DEBUGASSERT(rtcb->irqcount < INT16_MAX);
+      if (rtcb->irqcount++ == 0)
+        {
+          sched_critmon_enter(rtcb);
+        }
+#endif
+
       /* Yes.. Note that we have entered the critical section */
 
       sched_note_csection(rtcb, true);
@@ -500,6 +516,11 @@ void leave_critical_section(irqstate_t flags)
               /* No.. Note that we have left the critical section */
 
               sched_note_csection(rtcb, false);
+#endif
+#ifdef CONFIG_SCHED_CRITMONITOR
+              /* Stop timing the interrupts-off interval */
+
+              sched_critmon_leave(rtcb);
 #endif
               /* Decrement our count on the lock.  If all CPUs have
                * released, then unlock the spinlock.
@@ -554,7 +575,7 @@ void leave_critical_section(irqstate_t flags)
 
   up_irq_restore(flags);
 }
-#else /* defined(CONFIG_SCHED_INSTRUMENTATION_CSECTION) */
+#else /* CONFIG_SCHED_INSTRUMENTATION_CSECTION || CONFIG_SCHED_CRITMONITOR */
 void leave_critical_section(irqstate_t flags)
 {
   /* Check if we were called from an interrupt handler and that the tasks
@@ -569,6 +590,15 @@ void leave_critical_section(irqstate_t flags)
       /* Yes.. Note that we have left the critical section */
 
       sched_note_csection(rtcb, false);
+
+#ifdef CONFIG_SCHED_CRITMONITOR
+      /* Only the outermost call ends the interrupts-off interval */
+
+      if (rtcb->irqcount > 0 && --rtcb->irqcount == 0)
+        {
+          sched_critmon_leave(rtcb);
+        }
+#endif
     }
 
   /* Restore the previous interrupt state. */
@@ -651,4 +681,4 @@ bool irq_cpu_locked(int cpu)
 }
 #endif
 
-#endif /* CONFIG_SMP || CONFIG_SCHED_INSTRUMENTATION_CSECTION */
+#endif /* CONFIG_SMP || CONFIG_SCHED_INSTRUMENTATION_CSECTION || CONFIG_SCHED_CRITMONITOR */
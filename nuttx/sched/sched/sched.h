@@ -434,6 +434,26 @@ int  sched_cpu_pause(FAR struct tcb_s *tcb);
 void weak_function sched_process_cpuload(void);
 #endif
 
+/* Thread timing statistics */
+
+#ifdef CONFIG_SCHED_TIMESTATS
+void sched_timestats_suspend(FAR struct tcb_s *tcb);
+void sched_timestats_resume(FAR struct tcb_s *tcb);
+#endif
+
+#ifdef CONFIG_SCHED_LATENCY
+void sched_timestats_wakeup(FAR struct tcb_s *tcb);
+#endif
+
+#if defined(CONFIG_SCHED_RUNTIME) && !defined(CONFIG_SCHED_TICKLESS)
+void sched_timestats_tick(void);
+#endif
+
+#ifdef CONFIG_SCHED_CRITMONITOR
+void sched_critmon_enter(FAR struct tcb_s *tcb);
+void sched_critmon_leave(FAR struct tcb_s *tcb);
+#endif
+
 /* TCB operations */
 
 bool sched_verifytcb(FAR struct tcb_s *tcb);
@@ -105,8 +105,10 @@ void sched_ufree(FAR void *address)
 
       /* Signal the worker thread that is has some clean up to do */
 
-#ifdef CONFIG_SCHED_WORKQUEUE
+#if defined(CONFIG_SCHED_LPWORK)
       work_signal(LPWORK);
+#elif defined(CONFIG_SCHED_HPWORK)
+      work_signal(HPWORK);
 #endif
       leave_critical_section(flags);
     }
@@ -146,8 +148,10 @@ void sched_kfree(FAR void *address)
 
       /* Signal the worker thread that is has some clean up to do */
 
-#ifdef CONFIG_SCHED_WORKQUEUE
+#if defined(CONFIG_SCHED_LPWORK)
       work_signal(LPWORK);
+#elif defined(CONFIG_SCHED_HPWORK)
+      work_signal(HPWORK);
 #endif
       leave_critical_section(flags);
     }
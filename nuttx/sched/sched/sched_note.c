@@ -40,10 +40,13 @@
 #include <nuttx/config.h>
 
 #include <stdint.h>
+#include <stdbool.h>
+#include <time.h>
 #include <string.h>
 #include <assert.h>
 #include <errno.h>
 
+#include <nuttx/irq.h>
 #include <nuttx/sched.h>
 #include <nuttx/clock.h>
 #include <nuttx/spinlock.h>
@@ -57,6 +60,16 @@
  * Pre-processor Definitions
  ****************************************************************************/
 
+/* There is one note buffer per CPU.  Each buffer is written only by its own
+ * CPU so that no lock is needed on the write side.
+ */
+
+#ifdef CONFIG_SMP
+#  define NOTE_NCPUS CONFIG_SMP_NCPUS
+#else
+#  define NOTE_NCPUS 1
+#endif
+
 /****************************************************************************
  * Private Types
  ****************************************************************************/
@@ -65,6 +78,8 @@ struct note_info_s
 {
   volatile unsigned int ni_head;
   volatile unsigned int ni_tail;
+  volatile unsigned long ni_dropped;  /* Only incremented by note_add() */
+  unsigned long ni_reset;             /* ni_dropped at the last reset */
   uint8_t ni_buffer[CONFIG_SCHED_NOTE_BUFSIZE];
 };
 
@@ -92,7 +107,7 @@ static void note_add(FAR const uint8_t *note, uint8_t notelen);
  * Private Data
  ****************************************************************************/
 
-static struct note_info_s g_note_info;
+static struct note_info_s g_note_info[NOTE_NCPUS];
 
 /****************************************************************************
  * Private Functions
@@ -144,7 +159,13 @@ static inline unsigned int note_next(unsigned int ndx, unsigned int offset)
 static void note_common(FAR struct tcb_s *tcb, FAR struct note_common_s *note,
                         uint8_t length, uint8_t type)
 {
+#ifdef CONFIG_SCHED_INSTRUMENTATION_HIRES
+  struct timespec ts;
+
+  (void)clock_systimespec(&ts);
+#else
   uint32_t systime    = (uint32_t)clock_systimer();
+#endif
 
   /* Save all of the common fields */
 
@@ -157,12 +178,27 @@ static void note_common(FAR struct tcb_s *tcb, FAR struct note_common_s *note,
   note->nc_pid[0]     = (uint8_t)(tcb->pid & 0xff);
   note->nc_pid[1]     = (uint8_t)((tcb->pid >> 8) & 0xff);
 
+#ifdef CONFIG_SCHED_INSTRUMENTATION_HIRES
+  /* Save the time since power up in seconds and nanoseconds, both in
+   * little endian order.
+   */
+
+  note->nc_systime_sec[0]  = (uint8_t)( ts.tv_sec         & 0xff);
+  note->nc_systime_sec[1]  = (uint8_t)((ts.tv_sec  >> 8)  & 0xff);
+  note->nc_systime_sec[2]  = (uint8_t)((ts.tv_sec  >> 16) & 0xff);
+  note->nc_systime_sec[3]  = (uint8_t)((ts.tv_sec  >> 24) & 0xff);
+  note->nc_systime_nsec[0] = (uint8_t)( ts.tv_nsec        & 0xff);
+  note->nc_systime_nsec[1] = (uint8_t)((ts.tv_nsec >> 8)  & 0xff);
+  note->nc_systime_nsec[2] = (uint8_t)((ts.tv_nsec >> 16) & 0xff);
+  note->nc_systime_nsec[3] = (uint8_t)((ts.tv_nsec >> 24) & 0xff);
+#else
   /* Save the LS 32-bits of the system timer in little endian order */
 
   note->nc_systime[0] = (uint8_t)( systime        & 0xff);
   note->nc_systime[1] = (uint8_t)((systime >> 8)  & 0xff);
   note->nc_systime[2] = (uint8_t)((systime >> 16) & 0xff);
   note->nc_systime[3] = (uint8_t)((systime >> 24) & 0xff);
+#endif
 }
 
 /****************************************************************************
@@ -202,20 +238,20 @@ void note_spincommon(FAR struct tcb_s *tcb, FAR volatile spinlock_t *spinlock,
  * Name: note_length
  *
  * Description:
- *   Length of data currently in circular buffer.
+ *   Length of data currently in a circular buffer.
  *
  * Input Parameters:
- *   None
+ *   info - The per-CPU note buffer
  *
  * Returned Value:
  *   Length of data currently in circular buffer.
  *
  ****************************************************************************/
 
-static unsigned int note_length(void)
+static unsigned int note_length(FAR struct note_info_s *info)
 {
-  unsigned int head = g_note_info.ni_head;
-  unsigned int tail = g_note_info.ni_tail;
+  unsigned int head = info->ni_head;
+  unsigned int tail = info->ni_tail;
 
   if (tail > head)
     {
@@ -225,6 +261,33 @@ static unsigned int note_length(void)
   return head - tail;
 }
 
+/****************************************************************************
+ * Name: note_copy
+ *
+ * Description:
+ *   Copy data out of a circular buffer, handling wraparound.
+ *
+ * Input Parameters:
+ *   info   - The per-CPU note buffer
+ *   ndx    - Circular buffer index of the first byte to copy
+ *   buffer - Location to return the data
+ *   buflen - The number of bytes to copy
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+static void note_copy(FAR struct note_info_s *info, unsigned int ndx,
+                      FAR uint8_t *buffer, unsigned int buflen)
+{
+  while (buflen-- > 0)
+    {
+      *buffer++ = info->ni_buffer[ndx];
+      ndx = note_next(ndx, 1);
+    }
+}
+
 /****************************************************************************
  * Name: note_remove
  *
@@ -232,120 +295,232 @@ static unsigned int note_length(void)
  *   Remove the variable length note from the tail of the circular buffer
  *
  * Input Parameters:
- *   None
+ *   info - The per-CPU note buffer
  *
  * Returned Value:
  *   None
  *
  * Assumptions:
- *   We are within a critical section.
+ *   There is a note at the tail of the circular buffer.
  *
  ****************************************************************************/
 
-static void note_remove(void)
+static void note_remove(FAR struct note_info_s *info)
 {
-  FAR struct note_common_s *note;
   unsigned int tail;
   unsigned int length;
 
   /* Get the tail index of the circular buffer */
 
-  tail = g_note_info.ni_tail;
+  tail = info->ni_tail;
   DEBUGASSERT(tail < CONFIG_SCHED_NOTE_BUFSIZE);
 
-  /* Get the length of the note at the tail index */
+  /* Get the length of the note at the tail index.  nc_length is the first
+   * byte of the note so it never wraps.
+   */
 
-  note   = (FAR struct note_common_s *)&g_note_info.ni_buffer[tail];
-  length = note->nc_length;
-  DEBUGASSERT(length <= note_length());
+  length = info->ni_buffer[tail];
+  DEBUGASSERT(length <= note_length(info));
 
   /* Increment the tail index to remove the entire note from the circular
-   * buffer.
+   * buffer.  Make sure the length has been read before the space is
+   * released to the writer.
    */
 
-  g_note_info.ni_tail = note_next(tail, length);
+  SP_DMB();
+  info->ni_tail = note_next(tail, length);
 }
 
 /****************************************************************************
  * Name: note_add
  *
  * Description:
- *   Add the variable length note to the head of the circular buffer
+ *   Add the variable length note to the head of the circular buffer of the
+ *   current CPU.
+ *
+ *   Each CPU has its own buffer so writers on different CPUs never contend
+ *   and no spinlock is needed.  Interrupts are disabled locally only to
+ *   keep nested notes on this CPU from interleaving.
+ *
+ *   If the notes can be read out (CONFIG_SCHED_NOTE_GET), the buffer is a
+ *   single-producer/single-consumer queue:  The writer only updates the head
+ *   index and the reader only updates the tail index.  A note that does not
+ *   fit is discarded and counted in ni_dropped.  Otherwise, nobody removes
+ *   notes and the oldest notes are overwritten as before.
  *
  * Input Parameters:
- *   None
+ *   note    - The note to add
+ *   notelen - The length of the note
  *
  * Returned Value:
  *   None
  *
- * Assumptions:
- *   We are within a critical section.
- *
  ****************************************************************************/
 
 static void note_add(FAR const uint8_t *note, uint8_t notelen)
 {
+  FAR struct note_info_s *info;
+  irqstate_t flags;
   unsigned int head;
-  unsigned int next;
+  int cpu;
+
+  DEBUGASSERT(note != NULL && notelen < CONFIG_SCHED_NOTE_BUFSIZE);
+
+  flags = up_irq_save();
+  cpu   = this_cpu();
 
 #ifdef CONFIG_SMP
   /* Ignore notes that are not in the set of monitored CPUs */
 
-  if ((CONFIG_SCHED_INSTRUMENTATION_CPUSET & (1 << this_cpu())) == 0)
+  if ((CONFIG_SCHED_INSTRUMENTATION_CPUSET & (1 << cpu)) == 0)
     {
       /* Not in the set of monitored CPUs.  Do not log the note. */
 
+      up_irq_restore(flags);
       return;
     }
 #endif
 
-  /* REVISIT: In the single CPU case, the following should be safe because
-   * the logic is always called within a critical section, but in the SMP
-   * case we have protection.  One option would be to precalculate and
-   * advancing the new head entry before writing the data into the buffer.
-   * That will eliminate fatal race conditions (although could result in
-   * single notes being corrupted harmlessly).
-   *
-   * But there is a complexity: Advancing the head pointer where the note
-   * buffer is almost full could advance the head to wrap beyond the tail
-   * leaving the buffer in a bad state.  A solution to this would be to pre-
-   * remove entries at the tail of the buffer as necessary to make certain
-   * that there will be space for the new note at the beginning of the
-   * buffer.  I am less certain that this can be done safely in the SMP
-   * case.
+  info = &g_note_info[cpu];
+
+#ifdef CONFIG_SCHED_NOTE_GET
+  /* Is there space for the note?  One byte is always left unused so that a
+   * full buffer can be distinguished from an empty one.
    */
 
-  /* Get the index to the head of the circular buffer */
+  if (note_length(info) + notelen >= CONFIG_SCHED_NOTE_BUFSIZE)
+    {
+      /* No.. discard the note and count it */
 
-  DEBUGASSERT(note != NULL && notelen < CONFIG_SCHED_NOTE_BUFSIZE);
-  head = g_note_info.ni_head;
+      info->ni_dropped++;
+      up_irq_restore(flags);
+      return;
+    }
 
-  /* Loop until all bytes have been transferred to the circular buffer */
+  /* Make sure that the space is not written before the reader has released
+   * it.  This pairs with the SP_DMB() before the tail index is updated.
+   */
 
+  SP_DMB();
+#else
+  /* Remove notes at the tail of the circular buffer until there is space
+   * for the new note.
+   */
+
+  while (note_length(info) + notelen >= CONFIG_SCHED_NOTE_BUFSIZE)
+    {
+      note_remove(info);
+      info->ni_dropped++;
+    }
+#endif
+
+  /* Copy the note into the circular buffer */
+
+  head = info->ni_head;
   while (notelen > 0)
     {
-      /* Get the next head index.  Would it collide with the current tail
-       * index?
-       */
+      info->ni_buffer[head] = *note++;
+      head = note_next(head, 1);
+      notelen--;
+    }
 
-      next = note_next(head, 1);
-      if (next == g_note_info.ni_tail)
-        {
-          /* Yes, then remove the note at the tail index */
+  /* Make sure that the note data is visible before the new head index */
+
+  SP_DMB();
+  info->ni_head = head;
+
+  up_irq_restore(flags);
+}
+
+/****************************************************************************
+ * Name: note_oldest
+ *
+ * Description:
+ *   Find the per-CPU buffer that holds the oldest note so that notes from
+ *   all CPUs are returned in time order.
+ *
+ * Input Parameters:
+ *   None
+ *
+ * Returned Value:
+ *   The buffer with the oldest note or NULL if all buffers are empty.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_NOTE_GET
+static FAR struct note_info_s *note_oldest(void)
+{
+  FAR struct note_info_s *oldest = NULL;
+#ifdef CONFIG_SMP
+  struct note_common_s note;
+#ifdef CONFIG_SCHED_INSTRUMENTATION_HIRES
+  uint64_t oldtime = 0;
+  uint64_t systime;
+#else
+  uint32_t oldtime = 0;
+  uint32_t systime;
+#endif
+  int cpu;
 
-          note_remove();
+  for (cpu = 0; cpu < NOTE_NCPUS; cpu++)
+    {
+      FAR struct note_info_s *info = &g_note_info[cpu];
+
+      if (note_length(info) == 0)
+        {
+          continue;
         }
 
-      /* Save the next byte at the head index */
+      /* Make sure that the note data is read after the head index.  This
+       * pairs with the SP_DMB() in note_add().
+       */
 
-      g_note_info.ni_buffer[head] = *note++;
+      SP_DMB();
 
-      head = next;
-      notelen--;
+      /* Get the time stamp of the note at the tail */
+
+      note_copy(info, info->ni_tail, (FAR uint8_t *)&note,
+                sizeof(struct note_common_s));
+
+#ifdef CONFIG_SCHED_INSTRUMENTATION_HIRES
+      systime = ((uint64_t)note.nc_systime_sec[0]        |
+                 (uint64_t)note.nc_systime_sec[1]  << 8  |
+                 (uint64_t)note.nc_systime_sec[2]  << 16 |
+                 (uint64_t)note.nc_systime_sec[3]  << 24) * NSEC_PER_SEC +
+                ((uint32_t)note.nc_systime_nsec[0]       |
+                 (uint32_t)note.nc_systime_nsec[1] << 8  |
+                 (uint32_t)note.nc_systime_nsec[2] << 16 |
+                 (uint32_t)note.nc_systime_nsec[3] << 24);
+
+      if (oldest == NULL || systime < oldtime)
+#else
+      systime = (uint32_t)note.nc_systime[0]       |
+                (uint32_t)note.nc_systime[1] << 8  |
+                (uint32_t)note.nc_systime[2] << 16 |
+                (uint32_t)note.nc_systime[3] << 24;
+
+      /* The 32-bit time stamp may wrap */
+
+      if (oldest == NULL || (int32_t)(systime - oldtime) < 0)
+#endif
+        {
+          oldest  = info;
+          oldtime = systime;
+        }
     }
+#else
+  if (note_length(&g_note_info[0]) > 0)
+    {
+      /* Make sure that the note data is read after the head index */
+
+      SP_DMB();
+      oldest = &g_note_info[0];
+    }
+#endif
 
-  g_note_info.ni_head = head;
+  return oldest;
 }
+#endif
 
 /****************************************************************************
  * Public Functions
@@ -588,6 +763,8 @@ void sched_note_spinabort(FAR struct tcb_s *tcb, FAR volatile void *spinlock)
  * Description:
  *   Remove the next note from the tail of the circular buffer.  The note
  *   is also removed from the circular buffer to make room for futher notes.
+ *   In SMP configurations, the oldest note from all per-CPU buffers is
+ *   returned.
  *
  * Input Parameters:
  *   buffer - Location to return the next note
@@ -598,40 +775,40 @@ void sched_note_spinabort(FAR struct tcb_s *tcb, FAR volatile void *spinlock)
  *   provided.  Zero is returned only if ther circular buffer is empty.  A
  *   negated errno value is returned in the event of any failure.
  *
+ * Assumptions:
+ *   There is only one reader at a time.  No critical section is needed
+ *   because the reader only modifies the tail indices.
+ *
  ****************************************************************************/
 
 #ifdef CONFIG_SCHED_NOTE_GET
 ssize_t sched_note_get(FAR uint8_t *buffer, size_t buflen)
 {
-  FAR struct note_common_s *note;
-  irqstate_t flags;
-  unsigned int remaining;
+  FAR struct note_info_s *info;
   unsigned int tail;
   ssize_t notelen;
-  size_t circlen;
 
   DEBUGASSERT(buffer != NULL);
-  flags = enter_critical_section();
 
-  /* Verify that the circular buffer is not empty */
+  /* Find the buffer with the oldest note.  Return zero if all of the
+   * circular buffers are empty.
+   */
 
-  circlen = note_length();
-  if (circlen <= 0)
+  info = note_oldest();
+  if (info == NULL)
     {
-      notelen = 0;
-      goto errout_with_csection;
+      return 0;
     }
 
   /* Get the index to the tail of the circular buffer */
 
-  tail    = g_note_info.ni_tail;
+  tail    = info->ni_tail;
   DEBUGASSERT(tail < CONFIG_SCHED_NOTE_BUFSIZE);
 
   /* Get the length of the note at the tail index */
 
-  note    = (FAR struct note_common_s *)&g_note_info.ni_buffer[tail];
-  notelen = note->nc_length;
-  DEBUGASSERT(notelen <= circlen);
+  notelen = info->ni_buffer[tail];
+  DEBUGASSERT(notelen <= note_length(info));
 
   /* Is the user buffer large enough to hold the note? */
 
@@ -639,33 +816,21 @@ ssize_t sched_note_get(FAR uint8_t *buffer, size_t buflen)
     {
       /* Remove the large note so that we do not get constipated. */
 
-      note_remove();
+      note_remove(info);
 
       /* and return an error */
 
-      notelen = -EFBIG;
-      goto errout_with_csection;
+      return -EFBIG;
     }
 
-  /* Loop until the note has been transferred to the user buffer */
+  /* Transfer the note to the user buffer */
 
-  remaining = (unsigned int)notelen;
-  while (remaining > 0)
-    {
-      /* Copy the next byte at the tail index */
+  note_copy(info, tail, buffer, notelen);
 
-      *buffer++ = g_note_info.ni_buffer[tail];
+  /* Make sure the note has been copied before its space is released */
 
-      /* Adjust indices and counts */
-
-      tail = note_next(tail, 1);
-      remaining--;
-    }
-
-  g_note_info.ni_tail = tail;
-
-errout_with_csection:
-  leave_critical_section(flags);
+  SP_DMB();
+  info->ni_tail = note_next(tail, notelen);
   return notelen;
 }
 #endif
@@ -688,38 +853,59 @@ errout_with_csection:
 #ifdef CONFIG_SCHED_NOTE_GET
 ssize_t sched_note_size(void)
 {
-  FAR struct note_common_s *note;
-  irqstate_t flags;
-  unsigned int tail;
-  ssize_t notelen;
-  size_t circlen;
-
-  flags = enter_critical_section();
-
-  /* Verify that the circular buffer is not empty */
+  FAR struct note_info_s *info;
 
-  circlen = note_length();
-  if (circlen <= 0)
+  info = note_oldest();
+  if (info == NULL)
     {
-      notelen = 0;
-      goto errout_with_csection;
+      return 0;
     }
 
-  /* Get the index to the tail of the circular buffer */
+  return info->ni_buffer[info->ni_tail];
+}
+#endif
 
-  tail = g_note_info.ni_tail;
-  DEBUGASSERT(tail < CONFIG_SCHED_NOTE_BUFSIZE);
+/****************************************************************************
+ * Name: sched_note_dropped
+ *
+ * Description:
+ *   Return the number of notes that were lost because the circular buffer
+ *   was full.  In SMP configurations, this is the total for all CPUs.
+ *
+ * Input Parameters:
+ *   reset - True: Reset the counts after they have been read
+ *
+ * Returned Value:
+ *   The number of notes that were lost.
+ *
+ ****************************************************************************/
 
-  /* Get the length of the note at the tail index */
+unsigned long sched_note_dropped(bool reset)
+{
+  FAR struct note_info_s *info;
+  unsigned long dropped = 0;
+  unsigned long count;
+  int cpu;
+
+  /* ni_dropped is never cleared here.  It may be incremented on another CPU
+   * at any time, and clearing it would lose the notes dropped between the
+   * read and the write.  Instead, the count at the time of the reset is
+   * remembered and the difference is reported.
+   */
 
-  note    = (FAR struct note_common_s *)&g_note_info.ni_buffer[tail];
-  notelen = note->nc_length;
-  DEBUGASSERT(notelen <= circlen);
+  for (cpu = 0; cpu < NOTE_NCPUS; cpu++)
+    {
+      info     = &g_note_info[cpu];
+      count    = info->ni_dropped;
+      dropped += count - info->ni_reset;
 
-errout_with_csection:
-  leave_critical_section(flags);
-  return notelen;
+      if (reset)
+        {
+          info->ni_reset = count;
+        }
+    }
+
+  return dropped;
 }
-#endif
 
 #endif /* CONFIG_SCHED_INSTRUMENTATION_BUFFER */
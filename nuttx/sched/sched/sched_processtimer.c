@@ -213,6 +213,12 @@ void sched_process_timer(void)
     }
 #endif
 
+#ifdef CONFIG_SCHED_RUNTIME
+  /* Update the run time of the running thread(s) */
+
+  sched_timestats_tick();
+#endif
+
   /* Process watchdogs */
 
   wd_timer();
@@ -87,4 +87,10 @@ void sched_removeblocked(FAR struct tcb_s *btcb)
    */
 
   btcb->task_state = TSTATE_TASK_INVALID;
+
+#ifdef CONFIG_SCHED_LATENCY
+  /* Start measuring the wakeup latency */
+
+  sched_timestats_wakeup(btcb);
+#endif
 }
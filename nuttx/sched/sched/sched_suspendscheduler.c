@@ -50,7 +50,8 @@
 #include "clock/clock.h"
 #include "sched/sched.h"
 
-#if defined(CONFIG_SCHED_SPORADIC) || defined(CONFIG_SCHED_INSTRUMENTATION)
+#if defined(CONFIG_SCHED_SPORADIC) || defined(CONFIG_SCHED_INSTRUMENTATION) || \
+    defined(CONFIG_SCHED_TIMESTATS)
 
 /****************************************************************************
  * Public Functions
@@ -88,6 +89,12 @@ void sched_suspend_scheduler(FAR struct tcb_s *tcb)
 
   sched_note_suspend(tcb);
 #endif
+
+#ifdef CONFIG_SCHED_TIMESTATS
+  /* Update the thread timing statistics */
+
+  sched_timestats_suspend(tcb);
+#endif
 }
 
-#endif /* CONFIG_SCHED_SPORADIC || CONFIG_SCHED_INSTRUMENTATION */
+#endif /* CONFIG_SCHED_SPORADIC || CONFIG_SCHED_INSTRUMENTATION || CONFIG_SCHED_TIMESTATS */
@@ -0,0 +1,370 @@
+/****************************************************************************
+ * sched/sched/sched_timestats.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <stdint.h>
+#include <strings.h>
+#include <time.h>
+#include <assert.h>
+
+#include <nuttx/arch.h>
+#include <nuttx/clock.h>
+#include <nuttx/irq.h>
+
+#include "sched/sched.h"
+
+#ifdef CONFIG_SCHED_TIMESTATS
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_LATENCY
+#  define LATENCY_LASTBUCKET (CONFIG_SCHED_LATENCY_NBUCKETS - 1)
+#endif
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_LATENCY
+/* Conversion factor from up_perf_gettime() counts to microseconds in Q32
+ * format.  This is computed once, on first use, so that the latency path
+ * needs only a multiply and a shift.
+ */
+
+static uint64_t g_usec_q32;
+#endif
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: sched_timestats_usec
+ *
+ * Description:
+ *   Convert an elapsed up_perf_gettime() count to microseconds.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_LATENCY
+static inline uint32_t sched_timestats_usec(uint32_t elapsed)
+{
+  uint64_t usec;
+
+  if (g_usec_q32 == 0)
+    {
+      g_usec_q32 = ((uint64_t)USEC_PER_SEC << 32) / up_perf_getfreq();
+    }
+
+  usec = ((uint64_t)elapsed * g_usec_q32) >> 32;
+  return usec > UINT32_MAX ? UINT32_MAX : (uint32_t)usec;
+}
+#endif
+
+/****************************************************************************
+ * Name: sched_timestats_update
+ *
+ * Description:
+ *   Add the time since the thread was last resumed to its run time.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_RUNTIME
+static inline void sched_timestats_update(FAR struct tcb_s *tcb, uint32_t now)
+{
+  /* The IDLE thread(s) start running without ever being resumed, so there
+   * is no valid start time until the first update.
+   */
+
+  if (tcb->run_count > 0)
+    {
+      tcb->run_time += (uint32_t)(now - tcb->run_start);
+    }
+  else
+    {
+      tcb->run_count = 1;
+    }
+
+  tcb->run_start = now;
+}
+#endif
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: up_perf_gettime and up_perf_getfreq
+ *
+ * Description:
+ *   Default implementations for architectures that do not provide a high
+ *   resolution counter.  The time is taken from the system timer and has
+ *   the resolution of a system clock tick unless CONFIG_SCHED_TICKLESS is
+ *   selected.
+ *
+ ****************************************************************************/
+
+#ifndef CONFIG_ARCH_HAVE_PERFCOUNTER
+uint32_t up_perf_gettime(void)
+{
+  struct timespec ts;
+
+  (void)clock_systimespec(&ts);
+  return (uint32_t)ts.tv_sec * USEC_PER_SEC +
+         (uint32_t)ts.tv_nsec / NSEC_PER_USEC;
+}
+
+uint32_t up_perf_getfreq(void)
+{
+  return USEC_PER_SEC;
+}
+#endif
+
+/****************************************************************************
+ * Name: sched_timestats_suspend
+ *
+ * Description:
+ *   Called from sched_suspend_scheduler() when the thread stops running.
+ *   Adds the time since the thread was last resumed to its run time and
+ *   pauses any interrupts-off measurement in progress.
+ *
+ * Input Parameters:
+ *   tcb - The TCB of the thread that is being suspended.
+ *
+ * Returned Value:
+ *   None
+ *
+ * Assumptions:
+ *   Called with interrupts disabled.
+ *
+ ****************************************************************************/
+
+void sched_timestats_suspend(FAR struct tcb_s *tcb)
+{
+#if defined(CONFIG_SCHED_RUNTIME) || defined(CONFIG_SCHED_CRITMONITOR)
+  uint32_t now = up_perf_gettime();
+#endif
+
+#ifdef CONFIG_SCHED_RUNTIME
+  sched_timestats_update(tcb, now);
+#endif
+
+#ifdef CONFIG_SCHED_CRITMONITOR
+  /* If the thread is suspended within a critical section, then the next
+   * thread runs with its own interrupt state.  Replace the start time with
+   * the time elapsed so far; sched_timestats_resume() converts it back.
+   */
+
+  if (tcb->irqcount > 0)
+    {
+      tcb->crit_start = now - tcb->crit_start;
+    }
+#endif
+}
+
+/****************************************************************************
+ * Name: sched_timestats_resume
+ *
+ * Description:
+ *   Called from sched_resume_scheduler() when the thread starts running.
+ *   Starts the run time interval, completes any pending wakeup latency
+ *   measurement and resumes any paused interrupts-off measurement.
+ *
+ * Input Parameters:
+ *   tcb - The TCB of the thread that is being resumed.
+ *
+ * Returned Value:
+ *   None
+ *
+ * Assumptions:
+ *   Called with interrupts disabled.
+ *
+ ****************************************************************************/
+
+void sched_timestats_resume(FAR struct tcb_s *tcb)
+{
+  uint32_t now = up_perf_gettime();
+
+#ifdef CONFIG_SCHED_RUNTIME
+  tcb->run_start = now;
+  tcb->run_count++;
+#endif
+
+#ifdef CONFIG_SCHED_LATENCY
+  if ((tcb->flags & TCB_FLAG_WAKEUP) != 0)
+    {
+      uint32_t elapsed = now - tcb->wake_time;
+      int bucket;
+
+      tcb->flags &= ~TCB_FLAG_WAKEUP;
+      if (elapsed > tcb->lat_max)
+        {
+          tcb->lat_max = elapsed;
+        }
+
+      /* Bucket n holds latencies in the range [2^(n-1), 2^n) microseconds */
+
+      bucket = fls(sched_timestats_usec(elapsed));
+      if (bucket > LATENCY_LASTBUCKET)
+        {
+          bucket = LATENCY_LASTBUCKET;
+        }
+
+      tcb->lat_hist[bucket]++;
+    }
+#endif
+
+#ifdef CONFIG_SCHED_CRITMONITOR
+  if (tcb->irqcount > 0)
+    {
+      tcb->crit_start = now - tcb->crit_start;
+    }
+#endif
+}
+
+/****************************************************************************
+ * Name: sched_timestats_wakeup
+ *
+ * Description:
+ *   Called from sched_removeblocked() when a thread is made ready-to-run.
+ *   Records the time so that the wakeup latency can be measured when the
+ *   thread is next resumed.
+ *
+ * Input Parameters:
+ *   tcb - The TCB of the thread that is being made ready-to-run.
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_LATENCY
+void sched_timestats_wakeup(FAR struct tcb_s *tcb)
+{
+  tcb->wake_time = up_perf_gettime();
+  tcb->flags    |= TCB_FLAG_WAKEUP;
+}
+#endif
+
+/****************************************************************************
+ * Name: sched_timestats_tick
+ *
+ * Description:
+ *   Called from the timer interrupt handler.  Folds the elapsed time of
+ *   the running thread(s) into the accumulated run time so that the 32-bit
+ *   up_perf_gettime() counter cannot wrap between two context switches.
+ *
+ * Input Parameters:
+ *   None
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+#if defined(CONFIG_SCHED_RUNTIME) && !defined(CONFIG_SCHED_TICKLESS)
+void sched_timestats_tick(void)
+{
+#ifdef CONFIG_SMP
+  irqstate_t flags;
+  uint32_t now;
+  int i;
+
+  /* Other CPUs may be switching contexts concurrently.  The critical
+   * section keeps their TCBs stable.
+   */
+
+  flags = enter_critical_section();
+  now   = up_perf_gettime();
+
+  for (i = 0; i < CONFIG_SMP_NCPUS; i++)
+    {
+      sched_timestats_update(current_task(i), now);
+    }
+
+  leave_critical_section(flags);
+#else
+  sched_timestats_update(this_task(), up_perf_gettime());
+#endif
+}
+#endif
+
+/****************************************************************************
+ * Name: sched_critmon_enter and sched_critmon_leave
+ *
+ * Description:
+ *   Called from enter_critical_section() and leave_critical_section() on
+ *   the outermost entry to and exit from a critical section in a thread
+ *   context.
+ *
+ * Input Parameters:
+ *   tcb - The TCB of the thread that is entering/leaving the critical
+ *         section.
+ *
+ * Returned Value:
+ *   None
+ *
+ * Assumptions:
+ *   Called with interrupts disabled.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_CRITMONITOR
+void sched_critmon_enter(FAR struct tcb_s *tcb)
+{
+  tcb->crit_start = up_perf_gettime();
+}
+
+void sched_critmon_leave(FAR struct tcb_s *tcb)
+{
+  uint32_t elapsed = up_perf_gettime() - tcb->crit_start;
+
+  if (elapsed > tcb->crit_max)
+    {
+      tcb->crit_max = elapsed;
+    }
+
+  tcb->crit_time += elapsed;
+}
+#endif
+
+#endif /* CONFIG_SCHED_TIMESTATS */
@@ -55,66 +55,134 @@
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: work_dequeue
+ *
+ * Description:
+ *   Remove queued work from whichever list holds it and mark it as
+ *   available.  Must be called with the work queue lock held.
+ *
+ * Input parameters:
+ *   wqueue - The work queue
+ *   work   - The queued work
+ *
+ * Returned Value:
+ *   True if the first delayed work was removed and the timer must be
+ *   re-armed with work_timer() after the lock is released.
+ *
+ ****************************************************************************/
+
+static bool work_dequeue(FAR struct kwork_wqueue_s *wqueue,
+                         FAR struct work_s *work)
+{
+  bool rearm = false;
+
+  DEBUGASSERT(work->worker != NULL);
+
+  if (work->delay == 0)
+    {
+      /* Work with no remaining delay is in the ready FIFO */
+
+      dq_rem((FAR dq_entry_t *)work, &wqueue->q);
+    }
+  else
+    {
+      rearm = ((FAR dq_entry_t *)work == wqueue->delayed.head);
+      dq_rem((FAR dq_entry_t *)work, &wqueue->delayed);
+    }
+
+  work->worker = NULL;
+  wqueue->npending--;
+
+#ifdef CONFIG_SCHED_WORKSTATS
+  wqueue->stats.cancelled++;
+  wqueue->stats.depth--;
+#endif
+
+  return rearm;
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
 /****************************************************************************
  * Name: work_qcancel
  *
  * Description:
- *   Cancel previously queued work.  This removes work from the work queue.
- *   After work has been cancelled, it may be re-queue by calling work_queue()
- *   again.
+ *   Remove work from the work queue that holds it, if it is queued.
  *
  * Input parameters:
  *   qid    - The work queue ID
- *   work   - The previously queue work structure to cancel
+ *   work   - The work to remove
  *
  * Returned Value:
- *   Zero (OK) on success, a negated errno on failure.  This error may be
- *   reported:
- *
- *   -ENOENT - There is no such work queued.
- *   -EINVAL - An invalid work queue was specified
+ *   True if the work was queued and has been removed.
  *
  ****************************************************************************/
 
-static int work_qcancel(FAR struct kwork_wqueue_s *wqueue,
-                        FAR struct work_s *work)
+bool work_qcancel(int qid, FAR struct work_s *work)
 {
+  FAR struct kwork_wqueue_s *wqueue;
   irqstate_t flags;
-  int ret = -ENOENT;
+  bool queued;
+  bool rearm = false;
 
   DEBUGASSERT(work != NULL);
 
-  /* Cancelling the work is simply a matter of removing the work structure
-   * from the work queue.  This must be done with interrupts disabled because
-   * new work is typically added to the work queue from interrupt handlers.
-   */
-
-  flags = enter_critical_section();
-  if (work->worker != NULL)
+  for (; ; )
     {
-      /* A little test of the integrity of the work queue */
-
-      DEBUGASSERT(work->dq.flink != NULL ||
-                  (FAR dq_entry_t *)work == wqueue->q.tail);
-      DEBUGASSERT(work->dq.blink != NULL ||
-                  (FAR dq_entry_t *)work == wqueue->q.head);
+#ifdef CONFIG_SCHED_HPWORK
+      if (qid == HPWORK)
+        {
+          wqueue = (FAR struct kwork_wqueue_s *)&g_hpwork;
+        }
+      else
+#endif
+        {
+#ifdef CONFIG_SCHED_LPWORK
+          wqueue = (FAR struct kwork_wqueue_s *)&g_lpwork[WORK_CPU(work)];
+#else
+          return false;
+#endif
+        }
 
-      /* Remove the entry from the work queue and make sure that it is
-       * marked as available (i.e., the worker field is nullified).
+      /* Cancelling the work is simply a matter of removing the work
+       * structure from the work queue.  This must be done with the work
+       * queue locked because new work is typically added to the work queue
+       * from interrupt handlers.
        */
 
-      dq_rem((FAR dq_entry_t *)work, &wqueue->q);
-      work->worker = NULL;
-      ret = OK;
+      flags  = work_lock(wqueue);
+      queued = (work->worker != NULL);
+      if (queued && WORK_CPU(work) != wqueue->cpu)
+        {
+          /* The work was re-queued on another CPU's queue.  Try again. */
+
+          work_unlock(wqueue, flags);
+          continue;
+        }
+
+      if (queued)
+        {
+          /* Remove the entry from the work queue and make sure that it is
+           * marked as available (i.e., the worker field is nullified).
+           */
+
+          rearm = work_dequeue(wqueue, work);
+        }
+
+      work_unlock(wqueue, flags);
+      break;
     }
 
-  leave_critical_section(flags);
-  return ret;
-}
+  if (rearm)
+    {
+      work_timer(wqueue);
+    }
 
-/****************************************************************************
- * Public Functions
- ****************************************************************************/
+  return queued;
+}
 
 /****************************************************************************
  * Name: work_cancel
@@ -144,7 +212,7 @@ int work_cancel(int qid, FAR struct work_s *work)
     {
       /* Cancel high priority work */
 
-      return work_qcancel((FAR struct kwork_wqueue_s *)&g_hpwork, work);
+      return work_qcancel(HPWORK, work) ? OK : -ENOENT;
     }
   else
 #endif
@@ -153,7 +221,7 @@ int work_cancel(int qid, FAR struct work_s *work)
     {
       /* Cancel low priority work */
 
-      return work_qcancel((FAR struct kwork_wqueue_s *)&g_lpwork, work);
+      return work_qcancel(LPWORK, work) ? OK : -ENOENT;
     }
   else
 #endif
@@ -111,12 +111,12 @@ static int work_hpthread(int argc, char *argv[])
       sched_garbage_collection();
 #endif
 
-      /* Then process queued work.  work_process will not return until: (1)
-       * there is no further work in the work queue, and (2) the polling
-       * period provided by g_hpwork.delay expires.
+      /* Then process queued work.  work_process will not return until
+       * there is no further work ready in the work queue and the worker
+       * thread has been awakened again.
        */
 
-      work_process((FAR struct kwork_wqueue_s *)&g_hpwork, g_hpwork.delay, 0);
+      work_process((FAR struct kwork_wqueue_s *)&g_hpwork);
     }
 
   return OK; /* To keep some compilers happy */
@@ -147,8 +147,8 @@ int work_hpstart(void)
 
   /* Initialize work queue data structures */
 
-  g_hpwork.delay          = CONFIG_SCHED_HPWORKPERIOD / USEC_PER_TICK;
-  dq_init(&g_hpwork.q);
+  work_initialize((FAR struct kwork_wqueue_s *)&g_hpwork, sizeof(g_hpwork),
+                  HPWORK, 0);
 
   /* Start the high-priority, kernel mode worker thread */
 
@@ -170,7 +170,6 @@ int work_hpstart(void)
     }
 
   g_hpwork.worker[0].pid  = pid;
-  g_hpwork.worker[0].busy = true;
   return pid;
 }
 
@@ -332,6 +332,7 @@ static void lpwork_restoreworker(pid_t wpid, uint8_t reqprio)
 void lpwork_boostpriority(uint8_t reqprio)
 {
   irqstate_t flags;
+  int qndx;
   int wndx;
 
   /* Clip to the configured maximum priority */
@@ -348,9 +349,12 @@ void lpwork_boostpriority(uint8_t reqprio)
 
   /* Adjust the priority of every worker thread */
 
-  for (wndx = 0; wndx < CONFIG_SCHED_LPNTHREADS; wndx++)
+  for (qndx = 0; qndx < LPWORK_NQUEUES; qndx++)
     {
-      lpwork_boostworker(g_lpwork.worker[wndx].pid, reqprio);
+      for (wndx = 0; wndx < CONFIG_SCHED_LPNTHREADS; wndx++)
+        {
+          lpwork_boostworker(g_lpwork[qndx].worker[wndx].pid, reqprio);
+        }
     }
 
   sched_unlock();
@@ -378,6 +382,7 @@ void lpwork_boostpriority(uint8_t reqprio)
 void lpwork_restorepriority(uint8_t reqprio)
 {
   irqstate_t flags;
+  int qndx;
   int wndx;
 
   /* Clip to the configured maximum priority */
@@ -394,9 +399,12 @@ void lpwork_restorepriority(uint8_t reqprio)
 
   /* Adjust the priority of every worker thread */
 
-  for (wndx = 0; wndx < CONFIG_SCHED_LPNTHREADS; wndx++)
+  for (qndx = 0; qndx < LPWORK_NQUEUES; qndx++)
     {
-      lpwork_restoreworker(g_lpwork.worker[wndx].pid, reqprio);
+      for (wndx = 0; wndx < CONFIG_SCHED_LPNTHREADS; wndx++)
+        {
+          lpwork_restoreworker(g_lpwork[qndx].worker[wndx].pid, reqprio);
+        }
     }
 
   sched_unlock();
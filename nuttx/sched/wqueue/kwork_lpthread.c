@@ -41,7 +41,6 @@
 
 #include <unistd.h>
 #include <sched.h>
-#include <string.h>
 #include <errno.h>
 #include <queue.h>
 #include <debug.h>
@@ -61,7 +60,7 @@
 
 /* The state of the kernel mode, low priority work queue(s). */
 
-struct lp_wqueue_s g_lpwork;
+struct lp_wqueue_s g_lpwork[LPWORK_NQUEUES];
 
 /****************************************************************************
  * Private Functions
@@ -75,10 +74,9 @@ struct lp_wqueue_s g_lpwork;
  *   low priority work queue.
  *
  *   These, along with the higher priority worker thread are the kernel mode
- *   work queues (also build in the flat build).  One of these threads also
- *   performs periodic garbage collection (that would otherwise be performed
- *   by the idle thread if CONFIG_SCHED_WORKQUEUE is not defined).  That will
- *   be the lower priority worker thread if it is available.
+ *   work queues (also build in the flat build).  These threads also
+ *   perform garbage collection (that would otherwise be performed by the
+ *   idle thread if CONFIG_SCHED_WORKQUEUE is not defined).
  *
  *   All kernel mode worker threads are started by the OS during normal
  *   bring up.  This entry point is referenced by OS internally and should
@@ -94,65 +92,52 @@ struct lp_wqueue_s g_lpwork;
 
 static int work_lpthread(int argc, char *argv[])
 {
-#if CONFIG_SCHED_LPNTHREADS > 0
-  int wndx;
+  FAR struct kwork_wqueue_s *wqueue = NULL;
   pid_t me = getpid();
-  int i;
+  int qndx;
+  int wndx;
 
-  /* Find out thread index by search the workers in g_lpwork */
+  /* Find out which queue this thread serves by searching the workers in
+   * g_lpwork.
+   */
 
-  for (wndx = 0, i = 0; i < CONFIG_SCHED_LPNTHREADS; i++)
+  for (qndx = 0; qndx < LPWORK_NQUEUES && wqueue == NULL; qndx++)
     {
-      if (g_lpwork.worker[i].pid == me)
+      for (wndx = 0; wndx < CONFIG_SCHED_LPNTHREADS; wndx++)
         {
-          wndx = i;
-          break;
+          if (g_lpwork[qndx].worker[wndx].pid == me)
+            {
+              wqueue = (FAR struct kwork_wqueue_s *)&g_lpwork[qndx];
+              break;
+            }
         }
     }
 
-  DEBUGASSERT(i < CONFIG_SCHED_LPNTHREADS);
-#endif
+  DEBUGASSERT(wqueue != NULL);
 
   /* Loop forever */
 
   for (; ; )
     {
-#if CONFIG_SCHED_LPNTHREADS > 0
-      /* Thread 0 is special.  Only thread 0 performs period garbage collection */
-
-      if (wndx > 0)
-        {
-          /* The other threads will perform work, waiting indefinitely until
-           * signalled for the next work availability.
-           *
-           * The special value of zero for the poll period instructs work_process
-           * to wait indefinitely until a signal is received.
-           */
-
-          work_process((FAR struct kwork_wqueue_s *)&g_lpwork, 0, wndx);
-        }
-      else
-#endif
-        {
-          /* Perform garbage collection.  This cleans-up memory de-allocations
-           * that were queued because they could not be freed in that execution
-           * context (for example, if the memory was freed from an interrupt handler).
-           * NOTE: If the work thread is disabled, this clean-up is performed by
-           * the IDLE thread (at a very, very low priority).
-           *
-           * In the event of multiple low priority threads, on index == 0 will do
-           * the garbage collection.
-           */
-
-          sched_garbage_collection();
-
-          /* Then process queued work.  work_process will not return until:
-           * (1) there is no further work in the work queue, and (2) the polling
-           * period provided by g_lpwork.delay expires.
-           */
-
-          work_process((FAR struct kwork_wqueue_s *)&g_lpwork, g_lpwork.delay, 0);
-        }
+      /* Perform garbage collection.  This cleans-up memory de-allocations
+       * that were queued because they could not be freed in that execution
+       * context (for example, if the memory was freed from an interrupt handler).
+       * NOTE: If the work thread is disabled, this clean-up is performed by
+       * the IDLE thread (at a very, very low priority).
+       *
+       * Deferred de-allocations signal an idle low priority thread, which
+       * may be any of the threads in the pool, so each thread does the
+       * garbage collection when it is awakened.
+       */
+
+      sched_garbage_collection();
+
+      /* Then process queued work.  work_process will not return until
+       * there is no further work ready in the work queue and the worker
+       * thread has been awakened again.
+       */
+
+      work_process(wqueue);
     }
 
   return OK; /* To keep some compilers happy */
@@ -179,15 +164,20 @@ static int work_lpthread(int argc, char *argv[])
 
 int work_lpstart(void)
 {
+#ifdef CONFIG_SCHED_LPWORKPERCPU
+  cpu_set_t cpuset;
+#endif
   pid_t pid;
+  int qndx;
   int wndx;
 
   /* Initialize work queue data structures */
 
-  memset(&g_lpwork, 0, sizeof(struct kwork_wqueue_s));
-
-  g_lpwork.delay = CONFIG_SCHED_LPWORKPERIOD / USEC_PER_TICK;
-  dq_init(&g_lpwork.q);
+  for (qndx = 0; qndx < LPWORK_NQUEUES; qndx++)
+    {
+      work_initialize((FAR struct kwork_wqueue_s *)&g_lpwork[qndx],
+                      sizeof(struct lp_wqueue_s), LPWORK, qndx);
+    }
 
   /* Don't permit any of the threads to run until we have fully initialized
    * g_lpwork.
@@ -199,30 +189,40 @@ int work_lpstart(void)
 
   sinfo("Starting low-priority kernel worker thread(s)\n");
 
-  for (wndx = 0; wndx < CONFIG_SCHED_LPNTHREADS; wndx++)
+  for (qndx = 0; qndx < LPWORK_NQUEUES; qndx++)
     {
-       pid = kernel_thread(LPWORKNAME, CONFIG_SCHED_LPWORKPRIORITY,
-                           CONFIG_SCHED_LPWORKSTACKSIZE,
-                           (main_t)work_lpthread,
-                           (FAR char * const *)NULL);
-
-      DEBUGASSERT(pid > 0);
-      if (pid < 0)
+      for (wndx = 0; wndx < CONFIG_SCHED_LPNTHREADS; wndx++)
         {
-          int errcode = errno;
-          DEBUGASSERT(errcode > 0);
+          pid = kernel_thread(LPWORKNAME, CONFIG_SCHED_LPWORKPRIORITY,
+                              CONFIG_SCHED_LPWORKSTACKSIZE,
+                              (main_t)work_lpthread,
+                              (FAR char * const *)NULL);
+
+          DEBUGASSERT(pid > 0);
+          if (pid < 0)
+            {
+              int errcode = errno;
+              DEBUGASSERT(errcode > 0);
+
+              serr("ERROR: kernel_thread %d failed: %d\n", wndx, errcode);
+              sched_unlock();
+              return -errcode;
+            }
+
+#ifdef CONFIG_SCHED_LPWORKPERCPU
+          /* Each per-CPU queue is served only by threads on that CPU */
+
+          CPU_ZERO(&cpuset);
+          CPU_SET(qndx, &cpuset);
+          (void)sched_setaffinity(pid, sizeof(cpu_set_t), &cpuset);
+#endif
 
-          serr("ERROR: kernel_thread %d failed: %d\n", wndx, errcode);
-          sched_unlock();
-          return -errcode;
+          g_lpwork[qndx].worker[wndx].pid = pid;
         }
-
-      g_lpwork.worker[wndx].pid  = pid;
-      g_lpwork.worker[wndx].busy = true;
     }
 
   sched_unlock();
-  return g_lpwork.worker[0].pid;
+  return g_lpwork[0].worker[0].pid;
 }
 
 #endif /* CONFIG_SCHED_LPWORK */
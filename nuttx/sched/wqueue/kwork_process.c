@@ -40,13 +40,17 @@
 #include <nuttx/config.h>
 
 #include <stdint.h>
-#include <unistd.h>
-#include <signal.h>
+#include <string.h>
+#include <semaphore.h>
 #include <assert.h>
+#include <errno.h>
 #include <queue.h>
 
 #include <nuttx/irq.h>
 #include <nuttx/clock.h>
+#include <nuttx/spinlock.h>
+#include <nuttx/semaphore.h>
+#include <nuttx/wdog.h>
 #include <nuttx/wqueue.h>
 
 #include "wqueue/wqueue.h"
@@ -54,216 +58,514 @@
 #ifdef CONFIG_SCHED_WORKQUEUE
 
 /****************************************************************************
- * Pre-processor Definitions
+ * Private Functions
  ****************************************************************************/
 
-/* Use CLOCK_MONOTONIC if it is available.  CLOCK_REALTIME can cause bad
- * delays if the time is changed.
- */
-
-#ifdef CONFIG_CLOCK_MONOTONIC
-#  define WORK_CLOCK CLOCK_MONOTONIC
-#else
-#  define WORK_CLOCK CLOCK_REALTIME
-#endif
+/****************************************************************************
+ * Name: work_timeout
+ *
+ * Description:
+ *   The work queue timer has expired:  The first delayed work is ready.
+ *   Wake up a worker thread.  This runs in the context of the timer
+ *   interrupt.
+ *
+ * Input parameters:
+ *   argc - The number of arguments (should be 1)
+ *   arg1 - The work queue
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
 
-#ifndef MIN
-#  define MIN(a,b) ((a) < (b) ? (a) : (b))
-#endif
+static void work_timeout(int argc, wdparm_t arg1, ...)
+{
+  work_wakeup((FAR struct kwork_wqueue_s *)arg1, true);
+}
 
 /****************************************************************************
- * Public Functions
+ * Name: work_expire
+ *
+ * Description:
+ *   Move all delayed work whose deadline has passed to the tail of the
+ *   ready FIFO, in deadline order.  Must be called with the work queue
+ *   lock held.
+ *
+ * Input parameters:
+ *   wqueue - Describes the work queue
+ *   ctick  - The current time, sampled before taking the lock
+ *
+ * Returned Value:
+ *   True if the timer must be re-armed with work_timer() after the lock is
+ *   released.
+ *
  ****************************************************************************/
 
+static bool work_expire(FAR struct kwork_wqueue_s *wqueue, systime_t ctick)
+{
+  FAR struct work_s *work;
+  bool expired = false;
+
+  while ((work = (FAR struct work_s *)wqueue->delayed.head) != NULL &&
+         ctick - work->qtime >= work->delay)
+    {
+      (void)dq_remfirst(&wqueue->delayed);
+
+      /* From here on, qtime is the time that the work became ready and a
+       * delay of zero means that the work is in the ready FIFO.
+       */
+
+      work->qtime += work->delay;
+      work->delay  = 0;
+      dq_addlast((FAR dq_entry_t *)work, &wqueue->q);
+      expired = true;
+    }
+
+  /* Re-arm the timer for the new first delayed work.  The timer should
+   * already be running if nothing expired, but re-arm it anyway if it is
+   * not so that delayed work can never be stranded.
+   */
+
+  return expired || (work != NULL && !WDOG_ISACTIVE(&wqueue->timer));
+}
+
 /****************************************************************************
- * Name: work_process
+ * Name: work_take
  *
  * Description:
- *   This is the logic that performs actions placed on any work list.  This
- *   logic is the common underlying logic to all work queues.  This logic is
- *   part of the internal implementation of each work queue; it should not
- *   be called from application level logic.
+ *   Remove ready work from the FIFO of a work queue and mark it as no
+ *   longer queued.  Must be called with the work queue lock held.
  *
  * Input parameters:
- *   wqueue - Describes the work queue to be processed
+ *   wqueue - Describes the work queue
+ *   work   - The ready work
+ *   ctick  - The current time
  *
  * Returned Value:
  *   None
  *
  ****************************************************************************/
 
-void work_process(FAR struct kwork_wqueue_s *wqueue, systime_t period, int wndx)
+static void work_take(FAR struct kwork_wqueue_s *wqueue,
+                      FAR struct work_s *work, systime_t ctick)
 {
-  volatile FAR struct work_s *work;
-  worker_t  worker;
-  irqstate_t flags;
-  FAR void *arg;
-  systime_t elapsed;
-  systime_t remaining;
-  systime_t stick;
-  systime_t ctick;
-  systime_t next;
+#ifdef CONFIG_SCHED_WORKSTATS
+  systime_t latency;
+#endif
 
-  /* Then process queued work.  We need to keep interrupts disabled while
-   * we process items in the work list.
-   */
+  dq_rem((FAR dq_entry_t *)work, &wqueue->q);
+  DEBUGASSERT(work->worker != NULL);
 
-  next  = period;
-  flags = enter_critical_section();
+  /* Mark the work as no longer being queued */
 
-  /* Get the time that we started this polling cycle in clock ticks. */
+  work->worker = NULL;
+  wqueue->npending--;
+
+#ifdef CONFIG_SCHED_WORKSTATS
+  latency = ctick - work->qtime;
+  if (latency > wqueue->stats.maxlatency)
+    {
+      wqueue->stats.maxlatency = latency;
+    }
 
-  stick = clock_systimer();
+  wqueue->stats.totlatency += latency;
+  wqueue->stats.executed++;
+  wqueue->stats.depth--;
+#endif
+}
 
-  /* And check each entry in the work queue.  Since we have disabled
-   * interrupts we know:  (1) we will not be suspended unless we do
-   * so ourselves, and (2) there will be no changes to the work queue
-   */
+/****************************************************************************
+ * Name: work_steal
+ *
+ * Description:
+ *   The low priority queue of this CPU has no ready work.  Take the oldest
+ *   ready work that is not pinned to a CPU from the queue of another CPU.
+ *
+ * Input parameters:
+ *   thief  - The (empty) per-CPU queue of the calling worker
+ *   worker - The location to return the work callback
+ *   arg    - The location to return the callback argument
+ *
+ * Returned Value:
+ *   True if work was taken.
+ *
+ ****************************************************************************/
+
+#ifdef CONFIG_SCHED_LPWORKPERCPU
+static bool work_steal(FAR struct kwork_wqueue_s *thief,
+                       FAR worker_t *worker, FAR void **arg)
+{
+  FAR struct kwork_wqueue_s *victim;
+  FAR struct work_s *work;
+  irqstate_t flags;
+  systime_t ctick;
+  bool rearm;
+  int i;
 
-  work = (FAR struct work_s *)wqueue->q.head;
-  while (work)
+  for (i = 1; i < LPWORK_NQUEUES; i++)
     {
-      /* Is this work ready?  It is ready if there is no delay or if
-       * the delay has elapsed. qtime is the time that the work was added
-       * to the work queue.  It will always be greater than or equal to
-       * zero.  Therefore a delay of zero will always execute immediately.
+      victim = (FAR struct kwork_wqueue_s *)
+               &g_lpwork[(thief->cpu + i) % LPWORK_NQUEUES];
+
+      /* A racy peek is sufficient here:  Work that is missed now will be
+       * handled by the victim's own workers or will wake this worker.
        */
 
-      ctick   = clock_systimer();
-      elapsed = ctick - work->qtime;
-      if (elapsed >= work->delay)
+      if (victim->npending == 0)
         {
-          /* Remove the ready-to-execute work from the list */
+          continue;
+        }
 
-          (void)dq_rem((struct dq_entry_s *)work, &wqueue->q);
+      ctick = clock_systimer();
+      flags = work_lock(victim);
+      rearm = work_expire(victim, ctick);
 
-          /* Extract the work description from the entry (in case the work
-           * instance by the re-used after it has been de-queued).
-           */
+      for (work = (FAR struct work_s *)victim->q.head;
+           work != NULL && work->pinned;
+           work = (FAR struct work_s *)work->dq.flink);
 
-          worker = work->worker;
+      if (work != NULL)
+        {
+          *worker = work->worker;
+          *arg    = work->arg;
+          work_take(victim, work, ctick);
+#ifdef CONFIG_SCHED_WORKSTATS
+          victim->stats.stolen++;
+#endif
+        }
 
-          /* Check for a race condition where the work may be nullified
-           * before it is removed from the queue.
-           */
+      work_unlock(victim, flags);
 
-          if (worker != NULL)
-            {
-              /* Extract the work argument (before re-enabling interrupts) */
+      if (rearm)
+        {
+          work_timer(victim);
+        }
 
-              arg = work->arg;
+      if (work != NULL)
+        {
+          return true;
+        }
+    }
 
-              /* Mark the work as no longer being queued */
+  return false;
+}
+#endif
 
-              work->worker = NULL;
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
 
-              /* Do the work.  Re-enable interrupts while the work is being
-               * performed... we don't have any idea how long this will take!
-               */
+/****************************************************************************
+ * Name: work_initialize
+ *
+ * Description:
+ *   Initialize the state of one kernel-mode work queue.
+ *
+ * Input parameters:
+ *   wqueue - Describes the work queue to be initialized
+ *   size   - The size of the work queue structure
+ *   qid    - The work queue ID
+ *   cpu    - The index of the per-CPU queue
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
 
-              leave_critical_section(flags);
-              worker(arg);
+void work_initialize(FAR struct kwork_wqueue_s *wqueue, size_t size,
+                     int qid, int cpu)
+{
+  memset(wqueue, 0, size);
+  dq_init(&wqueue->q);
+  dq_init(&wqueue->delayed);
+  wd_static(&wqueue->timer);
 
-              /* Now, unfortunately, since we re-enabled interrupts we don't
-               * know the state of the work list and we will have to start
-               * back at the head of the list.
-               */
+  /* The semaphore is used for signaling and, hence, should not have
+   * priority inheritance enabled.
+   */
 
-              flags = enter_critical_section();
-              work  = (FAR struct work_s *)wqueue->q.head;
-            }
-          else
-            {
-              /* Cancelled.. Just move to the next work in the list with
-               * interrupts still disabled.
-               */
+  sem_init(&wqueue->sem, 0, 0);
+  sem_setprotocol(&wqueue->sem, SEM_PRIO_NONE);
 
-              work = (FAR struct work_s *)work->dq.flink;
-            }
-        }
-      else /* elapsed < work->delay */
-        {
-          /* This one is not ready.
-           *
-           * NOTE that elapsed is relative to the current time,
-           * not the time of beginning of this queue processing pass.
-           * So it may need an adjustment.
-           */
+#ifdef CONFIG_SMP
+  spin_initialize(&wqueue->lock, SP_UNLOCKED);
+#endif
 
-          elapsed += (ctick - stick);
-          if (elapsed > work->delay)
-            {
-              /* The delay has expired while we are processing */
+  wqueue->qid = qid;
+  wqueue->cpu = cpu;
+}
 
-              elapsed = work->delay;
-            }
+/****************************************************************************
+ * Name: work_lock and work_unlock
+ *
+ * Description:
+ *   Get and release exclusive access to the lists of a work queue.  Lock
+ *   ordering:  The critical section may be held when the work queue lock
+ *   is taken, but the critical section must not be entered (including
+ *   implicitly, by clock_systimer() or wd_start() for example) while the
+ *   work queue lock is held.
+ *
+ ****************************************************************************/
 
-          /* Will it be ready before the next scheduled wakeup interval? */
+irqstate_t work_lock(FAR struct kwork_wqueue_s *wqueue)
+{
+#ifdef CONFIG_SMP
+  irqstate_t flags = up_irq_save();
+  spin_lock(&wqueue->lock);
+  return flags;
+#else
+  return enter_critical_section();
+#endif
+}
 
-          remaining = work->delay - elapsed;
-          if (remaining < next)
-            {
-              /* Yes.. Then schedule to wake up when the work is ready */
+void work_unlock(FAR struct kwork_wqueue_s *wqueue, irqstate_t flags)
+{
+#ifdef CONFIG_SMP
+  spin_unlock(&wqueue->lock);
+  up_irq_restore(flags);
+#else
+  leave_critical_section(flags);
+#endif
+}
 
-              next = remaining;
-            }
+/****************************************************************************
+ * Name: work_timer
+ *
+ * Description:
+ *   Arm the work queue timer for the deadline of the first delayed work,
+ *   or cancel the timer if there is no delayed work.  Must be called
+ *   without the work queue lock held.
+ *
+ * Input parameters:
+ *   wqueue - Describes the work queue
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
 
-          /* Then try the next in the list. */
+void work_timer(FAR struct kwork_wqueue_s *wqueue)
+{
+  FAR struct work_s *work;
+  irqstate_t flags;
+  irqstate_t lflags;
+  systime_t elapsed;
+  systime_t remaining = 0;
+  systime_t ctick;
 
-          work = (FAR struct work_s *)work->dq.flink;
+  /* The critical section serializes re-arming of the timer.  The first
+   * delayed work is sampled again within it so that the timer is always
+   * left armed for the current first deadline.
+   */
+
+  flags  = enter_critical_section();
+  ctick  = clock_systimer();
+
+  lflags = work_lock(wqueue);
+  work   = (FAR struct work_s *)wqueue->delayed.head;
+  if (work != NULL)
+    {
+      elapsed   = ctick - work->qtime;
+      remaining = elapsed < work->delay ? work->delay - elapsed : 0;
+    }
+
+  work_unlock(wqueue, lflags);
+
+  if (work == NULL)
+    {
+      (void)wd_cancel(&wqueue->timer);
+    }
+  else
+    {
+      if (remaining > INT32_MAX)
+        {
+          remaining = INT32_MAX;
         }
+
+      (void)wd_start(&wqueue->timer, (int32_t)remaining, work_timeout, 1,
+                     (wdparm_t)wqueue);
     }
 
-#if defined(CONFIG_SCHED_LPWORK) && CONFIG_SCHED_LPNTHREADS > 0
-  /* Value of zero for period means that we should wait indefinitely until
-   * signalled.  This option is used only for the case where there are
-   * multiple, low-priority worker threads.  In that case, only one of
-   * the threads does the poll... the others simple.  In all other cases
-   * period will be non-zero and equal to wqueue->delay.
+  leave_critical_section(flags);
+}
+
+/****************************************************************************
+ * Name: work_wakeup
+ *
+ * Description:
+ *   Wake up one idle worker of the work queue.  With
+ *   CONFIG_SCHED_LPWORKPERCPU, if 'steal' is true and the low priority
+ *   queue has no idle worker, an idle worker of another CPU's queue is
+ *   awakened instead so that it may take the work.  Must be called
+ *   without the work queue lock held.
+ *
+ * Input parameters:
+ *   wqueue - Describes the work queue
+ *   steal  - True: Ready work on the queue may be taken by other CPUs
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void work_wakeup(FAR struct kwork_wqueue_s *wqueue, bool steal)
+{
+  irqstate_t flags;
+  bool post = false;
+#ifdef CONFIG_SCHED_LPWORKPERCPU
+  int i;
+#endif
+
+  /* Each idle worker is posted at most once so the semaphore count never
+   * exceeds the number of workers that are waiting for it.
    */
 
-  if (period == 0)
+  flags = work_lock(wqueue);
+  if (wqueue->nidle > 0)
     {
-      sigset_t set;
+      wqueue->nidle--;
+      post = true;
+    }
 
-      /* Wait indefinitely until signalled with SIGWORK */
+  work_unlock(wqueue, flags);
 
-      sigemptyset(&set);
-      sigaddset(&set, SIGWORK);
+  if (post)
+    {
+      (void)sem_post(&wqueue->sem);
+      return;
+    }
 
-      wqueue->worker[wndx].busy = false;
-      DEBUGVERIFY(sigwaitinfo(&set, NULL));
-       wqueue->worker[wndx].busy = true;
+#ifdef CONFIG_SCHED_LPWORKPERCPU
+  if (steal && wqueue->qid == LPWORK)
+    {
+      for (i = 1; i < LPWORK_NQUEUES; i++)
+        {
+          FAR struct kwork_wqueue_s *other = (FAR struct kwork_wqueue_s *)
+            &g_lpwork[(wqueue->cpu + i) % LPWORK_NQUEUES];
+
+          if (other->nidle > 0)
+            {
+              work_wakeup(other, false);
+              return;
+            }
+        }
     }
-  else
+#else
+  UNUSED(steal);
 #endif
+}
+
+/****************************************************************************
+ * Name: work_process
+ *
+ * Description:
+ *   This is the logic that performs actions placed on any work list.  This
+ *   logic is the common underlying logic to all work queues.  This logic is
+ *   part of the internal implementation of each work queue; it should not
+ *   be called from application level logic.
+ *
+ *   All work that is ready is performed, then the worker thread waits until
+ *   it is awakened for more work.
+ *
+ * Input parameters:
+ *   wqueue - Describes the work queue to be processed
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void work_process(FAR struct kwork_wqueue_s *wqueue)
+{
+  FAR struct work_s *work;
+  worker_t worker = NULL;
+  irqstate_t flags;
+  FAR void *arg = NULL;
+  systime_t ctick;
+  bool rearm;
+  bool found;
+  bool idle;
+
+  for (; ; )
     {
-      /* Get the delay (in clock ticks) since we started the sampling */
+      /* Move any delayed work that is now ready to the ready FIFO, then
+       * take the work at the head of the FIFO.
+       */
+
+      ctick = clock_systimer();
+      flags = work_lock(wqueue);
+      rearm = work_expire(wqueue, ctick);
 
-      elapsed = clock_systimer() - stick;
-      if (elapsed < period && next > 0)
+      work  = (FAR struct work_s *)wqueue->q.head;
+      if (work != NULL)
         {
-          /* How much time would we need to delay to get to the end of the
-           * sampling period?  The amount of time we delay should be the smaller
-           * of the time to the end of the sampling period and the time to the
-           * next work expiry.
+          /* Extract the work description from the entry (in case the work
+           * instance by the re-used after it has been de-queued).
            */
 
-          remaining = period - elapsed;
-          next      = MIN(next, remaining);
+          worker = work->worker;
+          arg    = work->arg;
+          work_take(wqueue, work, ctick);
+        }
 
-          /* Wait awhile to check the work list.  We will wait here until
-           * either the time elapses or until we are awakened by a signal.
-           * Interrupts will be re-enabled while we wait.
-           */
+      work_unlock(wqueue, flags);
+
+      if (rearm)
+        {
+          work_timer(wqueue);
+        }
+
+      found = (work != NULL);
 
-          wqueue->worker[wndx].busy = false;
-          usleep(next * USEC_PER_TICK);
-          wqueue->worker[wndx].busy = true;
+#ifdef CONFIG_SCHED_LPWORKPERCPU
+      /* Nothing ready here?  Then try to take work from another CPU */
+
+      if (!found && wqueue->qid == LPWORK)
+        {
+          found = work_steal(wqueue, &worker, &arg);
         }
+#endif
+
+      if (!found)
+        {
+          break;
+        }
+
+      /* Do the work.  The work queue is not locked while the work is being
+       * performed... we don't have any idea how long this will take!
+       */
+
+      worker(arg);
     }
 
-  leave_critical_section(flags);
+  /* There is no more ready work.  Become idle, unless work became ready
+   * since the queue was last examined.  The timer and work_queue() post
+   * the semaphore only for workers that are counted as idle.
+   */
+
+  ctick = clock_systimer();
+  flags = work_lock(wqueue);
+  rearm = work_expire(wqueue, ctick);
+  idle  = (wqueue->q.head == NULL);
+  if (idle)
+    {
+      wqueue->nidle++;
+    }
+
+  work_unlock(wqueue, flags);
+
+  if (rearm)
+    {
+      work_timer(wqueue);
+    }
+
+  if (idle)
+    {
+      while (sem_wait(&wqueue->sem) < 0)
+        {
+          DEBUGASSERT(errno == EINTR);
+        }
+    }
 }
 
 #endif /* CONFIG_SCHED_WORKQUEUE */
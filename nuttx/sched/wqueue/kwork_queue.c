@@ -49,6 +49,7 @@
 #include <nuttx/clock.h>
 #include <nuttx/wqueue.h>
 
+#include "sched/sched.h"
 #include "wqueue/wqueue.h"
 
 #ifdef CONFIG_SCHED_WORKQUEUE
@@ -57,6 +58,79 @@
  * Private Functions
  ****************************************************************************/
 
+/****************************************************************************
+ * Name: work_qselect
+ *
+ * Description:
+ *   Select the kernel work queue that will hold new work.
+ *
+ * Input parameters:
+ *   qid    - The work queue ID (index)
+ *   cpu    - The CPU that will perform the work or -1 for any CPU
+ *
+ * Returned Value:
+ *   The selected work queue or NULL if the work queue ID or CPU is not
+ *   valid.
+ *
+ ****************************************************************************/
+
+static FAR struct kwork_wqueue_s *work_qselect(int qid, int cpu)
+{
+#ifdef CONFIG_SMP
+  if (cpu >= CONFIG_SMP_NCPUS)
+#else
+  if (cpu > 0)
+#endif
+    {
+      return NULL;
+    }
+
+#ifdef CONFIG_SCHED_HPWORK
+  if (qid == HPWORK)
+    {
+      return (FAR struct kwork_wqueue_s *)&g_hpwork;
+    }
+  else
+#endif
+#ifdef CONFIG_SCHED_LPWORK
+  if (qid == LPWORK)
+    {
+#ifdef CONFIG_SCHED_LPWORKPERCPU
+      if (cpu < 0)
+        {
+#ifdef CONFIG_SCHED_LPWORKFAIR
+          int i;
+
+          /* Use the queue with the least pending work.  The counts are
+           * sampled without locking; an approximate answer is sufficient.
+           */
+
+          for (cpu = 0, i = 1; i < LPWORK_NQUEUES; i++)
+            {
+              if (g_lpwork[i].npending < g_lpwork[cpu].npending)
+                {
+                  cpu = i;
+                }
+            }
+#else
+          /* Use the queue of this CPU */
+
+          cpu = this_cpu();
+#endif
+        }
+
+      return (FAR struct kwork_wqueue_s *)&g_lpwork[cpu];
+#else
+      return (FAR struct kwork_wqueue_s *)&g_lpwork[0];
+#endif
+    }
+  else
+#endif
+    {
+      return NULL;
+    }
+}
+
 /****************************************************************************
  * Name: work_qqueue
  *
@@ -73,6 +147,7 @@
  *
  * Input parameters:
  *   qid    - The work queue ID (index)
+ *   cpu    - The CPU that must perform the work or -1 for any CPU
  *   work   - The work structure to queue
  *   worker - The worker callback to be invoked.  The callback will invoked
  *            on the worker thread of execution.
@@ -82,35 +157,125 @@
  *            is invoked. Zero means to perform the work immediately.
  *
  * Returned Value:
- *   None
+ *   Zero on success, a negated errno on failure
  *
  ****************************************************************************/
 
-static void work_qqueue(FAR struct kwork_wqueue_s *wqueue,
-                        FAR struct work_s *work, worker_t worker,
-                        FAR void *arg, systime_t delay)
+static int work_qqueue(int qid, int cpu, FAR struct work_s *work,
+                       worker_t worker, FAR void *arg, systime_t delay)
 {
+  FAR struct kwork_wqueue_s *wqueue;
+  FAR struct work_s *prev;
   irqstate_t flags;
+  systime_t elapsed;
+  systime_t ctick;
+  bool rearm = false;
 
   DEBUGASSERT(work != NULL && worker != NULL);
 
-  /* First, initialize the work structure.  This must be done with interrupts
-   * disabled.  This permits this function to be called from with task logic
-   * or interrupt handlers.
+  wqueue = work_qselect(qid, cpu);
+  if (wqueue == NULL)
+    {
+      return -EINVAL;
+    }
+
+  /* If the work is still queued, remove it so that it is re-queued with the
+   * new parameters rather than linked into a queue a second time.
    */
 
-  flags        = enter_critical_section();
+  if (work->worker != NULL)
+    {
+      (void)work_qcancel(qid, work);
+    }
+
+  /* Sample the time before locking the work queue (see work_lock()) */
+
+  ctick = clock_systimer();
+
+  /* Initialize the work structure.  This must be done with the work queue
+   * locked (and interrupts disabled).  This permits this function to be
+   * called from with task logic or interrupt handlers.
+   */
+
+  flags = work_lock(wqueue);
+
   work->worker = worker;           /* Work callback. non-NULL means queued */
   work->arg    = arg;              /* Callback argument */
   work->delay  = delay;            /* Delay until work performed */
+#ifdef CONFIG_SCHED_LPWORKPERCPU
+  work->cpu    = wqueue->cpu;      /* The queue that holds the work */
+  work->pinned = (cpu >= 0);       /* Only that CPU may perform it */
+#endif
 
   /* Now, time-tag that entry and put it in the work queue */
 
-  work->qtime  = clock_systimer(); /* Time work queued */
+  work->qtime  = ctick;            /* Time work queued */
 
-  dq_addlast((FAR dq_entry_t *)work, &wqueue->q);
+  if (delay == 0)
+    {
+      /* The work is ready now.  Add it to the tail of the ready FIFO */
 
-  leave_critical_section(flags);
+      dq_addlast((FAR dq_entry_t *)work, &wqueue->q);
+    }
+  else
+    {
+      /* Find the last delayed work that becomes ready no later than this
+       * work.  Work is most often queued with the same or increasing
+       * delays, so search backward from the tail of the list.
+       */
+
+      for (prev = (FAR struct work_s *)wqueue->delayed.tail;
+           prev != NULL;
+           prev = (FAR struct work_s *)prev->dq.blink)
+        {
+          elapsed = ctick - prev->qtime;
+          if (elapsed >= prev->delay || prev->delay - elapsed <= delay)
+            {
+              break;
+            }
+        }
+
+      if (prev != NULL)
+        {
+          dq_addafter((FAR dq_entry_t *)prev, (FAR dq_entry_t *)work,
+                      &wqueue->delayed);
+        }
+      else
+        {
+          /* This is the new earliest deadline.  Re-arm the timer. */
+
+          dq_addfirst((FAR dq_entry_t *)work, &wqueue->delayed);
+          rearm = true;
+        }
+    }
+
+  wqueue->npending++;
+
+#ifdef CONFIG_SCHED_WORKSTATS
+  wqueue->stats.queued++;
+  if (++wqueue->stats.depth > wqueue->stats.maxdepth)
+    {
+      wqueue->stats.maxdepth = wqueue->stats.depth;
+    }
+#endif
+
+  work_unlock(wqueue, flags);
+
+  if (rearm)
+    {
+      work_timer(wqueue);
+    }
+
+  /* Wake up an idle worker for work that is ready now.  Delayed work will
+   * be signalled by the work queue timer.
+   */
+
+  if (delay == 0)
+    {
+      work_wakeup(wqueue, cpu < 0);
+    }
+
+  return OK;
 }
 
 /****************************************************************************
@@ -149,29 +314,44 @@ static void work_qqueue(FAR struct kwork_wqueue_s *wqueue,
 int work_queue(int qid, FAR struct work_s *work, worker_t worker,
                FAR void *arg, systime_t delay)
 {
-#ifdef CONFIG_SCHED_HPWORK
-  if (qid == HPWORK)
-    {
-      /* Queue high priority work */
+  return work_qqueue(qid, -1, work, worker, arg, delay);
+}
 
-      work_qqueue((FAR struct kwork_wqueue_s *)&g_hpwork, work, worker, arg, delay);
-      return work_signal(HPWORK);
-    }
-  else
-#endif
-#ifdef CONFIG_SCHED_LPWORK
-  if (qid == LPWORK)
-    {
-      /* Queue low priority work */
+/****************************************************************************
+ * Name: work_queue_cpu
+ *
+ * Description:
+ *   Queue work to be performed on a specific CPU.  This is the same as
+ *   work_queue() except that, with CONFIG_SCHED_LPWORKPERCPU, LPWORK is
+ *   placed on the queue of the selected CPU and will be performed only by
+ *   the worker threads of that CPU.  Otherwise the work queues are not
+ *   CPU-specific and the cpu argument is only checked.
+ *
+ * Input parameters:
+ *   qid    - The work queue ID
+ *   cpu    - The CPU that will perform the work
+ *   work   - The work structure to queue
+ *   worker - The worker callback to be invoked.  The callback will invoked
+ *            on the worker thread of execution.
+ *   arg    - The argument that will be passed to the worker callback when
+ *            it is invoked.
+ *   delay  - Delay (in clock ticks) from the time queue until the worker
+ *            is invoked. Zero means to perform the work immediately.
+ *
+ * Returned Value:
+ *   Zero on success, a negated errno on failure
+ *
+ ****************************************************************************/
 
-      work_qqueue((FAR struct kwork_wqueue_s *)&g_lpwork, work, worker, arg, delay);
-      return work_signal(LPWORK);
-    }
-  else
-#endif
+int work_queue_cpu(int qid, int cpu, FAR struct work_s *work,
+                   worker_t worker, FAR void *arg, systime_t delay)
+{
+  if (cpu < 0)
     {
       return -EINVAL;
     }
+
+  return work_qqueue(qid, cpu, work, worker, arg, delay);
 }
 
 #endif /* CONFIG_SCHED_WORKQUEUE */
@@ -39,11 +39,11 @@
 
 #include <nuttx/config.h>
 
-#include <signal.h>
 #include <errno.h>
 
 #include <nuttx/wqueue.h>
 
+#include "sched/sched.h"
 #include "wqueue/wqueue.h"
 
 #ifdef CONFIG_SCHED_WORKQUEUE
@@ -70,47 +70,25 @@
 
 int work_signal(int qid)
 {
-  pid_t pid;
-  int ret;
-
-  /* Get the process ID of the worker thread */
-
 #ifdef CONFIG_SCHED_HPWORK
   if (qid == HPWORK)
     {
-      pid = g_hpwork.worker[0].pid;
+      work_wakeup((FAR struct kwork_wqueue_s *)&g_hpwork, false);
     }
   else
 #endif
 #ifdef CONFIG_SCHED_LPWORK
   if (qid == LPWORK)
     {
-      int i;
-
-      /* Find an IDLE worker thread */
-
-      for (i = 0; i < CONFIG_SCHED_LPNTHREADS; i++)
-        {
-          /* Is this worker thread busy? */
-
-          if (!g_lpwork.worker[i].busy)
-            {
-              /* No.. select this thread */
-
-              break;
-            }
-        }
-
-      /* If all of the IDLE threads are busy, then just return successfully */
-
-      if (i >= CONFIG_SCHED_LPNTHREADS)
-        {
-          return OK;
-        }
-
-      /* Otherwise, signal the first IDLE thread found */
-
-      pid = g_lpwork.worker[i].pid;
+      /* Wake up an idle worker thread, preferably one on this CPU.  If all
+       * of the worker threads are busy, then just return successfully.
+       */
+
+#ifdef CONFIG_SCHED_LPWORKPERCPU
+      work_wakeup((FAR struct kwork_wqueue_s *)&g_lpwork[this_cpu()], true);
+#else
+      work_wakeup((FAR struct kwork_wqueue_s *)&g_lpwork[0], false);
+#endif
     }
   else
 #endif
@@ -118,15 +96,6 @@ int work_signal(int qid)
       return -EINVAL;
     }
 
-  /* Signal the worker thread */
-
-  ret = kill(pid, SIGWORK);
-  if (ret < 0)
-    {
-      int errcode = errno;
-      return -errcode;
-    }
-
   return OK;
 }
 
@@ -0,0 +1,135 @@
+/****************************************************************************
+ * sched/wqueue/kwork_stats.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *   Author: Gregory Nutt <gnutt@nuttx.org>
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <nuttx/config.h>
+
+#include <string.h>
+#include <assert.h>
+#include <errno.h>
+
+#include <nuttx/irq.h>
+#include <nuttx/wqueue.h>
+
+#include "wqueue/wqueue.h"
+
+#if defined(CONFIG_SCHED_WORKQUEUE) && defined(CONFIG_SCHED_WORKSTATS)
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+/****************************************************************************
+ * Name: work_stats
+ *
+ * Description:
+ *   Return a snapshot of the statistics of a kernel work queue.
+ *
+ * Input parameters:
+ *   qid   - The work queue ID (must be HPWORK or LPWORK)
+ *   stats - The location to return the statistics
+ *
+ * Returned Value:
+ *   Zero on success, a negated errno on failure
+ *
+ *   -EINVAL - An invalid work queue was specified
+ *
+ ****************************************************************************/
+
+int work_stats(int qid, FAR struct work_stats_s *stats)
+{
+  FAR struct kwork_wqueue_s *wqueue;
+  struct work_stats_s sample;
+  irqstate_t flags;
+  int i;
+
+  DEBUGASSERT(stats != NULL);
+  memset(stats, 0, sizeof(struct work_stats_s));
+
+  for (i = 0; ; i++)
+    {
+#ifdef CONFIG_SCHED_HPWORK
+      if (qid == HPWORK && i == 0)
+        {
+          wqueue = (FAR struct kwork_wqueue_s *)&g_hpwork;
+        }
+      else
+#endif
+#ifdef CONFIG_SCHED_LPWORK
+      if (qid == LPWORK && i < LPWORK_NQUEUES)
+        {
+          wqueue = (FAR struct kwork_wqueue_s *)&g_lpwork[i];
+        }
+      else
+#endif
+        {
+          break;
+        }
+
+      /* Copy the statistics with the queue locked so that the snapshot of
+       * each queue is consistent.
+       */
+
+      flags  = work_lock(wqueue);
+      sample = wqueue->stats;
+      work_unlock(wqueue, flags);
+
+      stats->queued     += sample.queued;
+      stats->executed   += sample.executed;
+      stats->cancelled  += sample.cancelled;
+      stats->stolen     += sample.stolen;
+      stats->depth      += sample.depth;
+      stats->totlatency += sample.totlatency;
+
+      if (sample.maxdepth > stats->maxdepth)
+        {
+          stats->maxdepth = sample.maxdepth;
+        }
+
+      if (sample.maxlatency > stats->maxlatency)
+        {
+          stats->maxlatency = sample.maxlatency;
+        }
+    }
+
+  /* No queue was found if the work queue ID is not valid */
+
+  return i > 0 ? OK : -EINVAL;
+}
+
+#endif /* CONFIG_SCHED_WORKQUEUE && CONFIG_SCHED_WORKSTATS */
@@ -43,10 +43,16 @@
 #include <nuttx/config.h>
 
 #include <sys/types.h>
+#include <stdint.h>
 #include <stdbool.h>
+#include <semaphore.h>
 #include <queue.h>
 
+#include <nuttx/irq.h>
 #include <nuttx/clock.h>
+#include <nuttx/spinlock.h>
+#include <nuttx/wdog.h>
+#include <nuttx/wqueue.h>
 
 #ifdef CONFIG_SCHED_WORKQUEUE
 
@@ -59,6 +65,22 @@
 #define HPWORKNAME "hpwork"
 #define LPWORKNAME "lpwork"
 
+/* The number of low priority work queues */
+
+#ifdef CONFIG_SCHED_LPWORKPERCPU
+#  define LPWORK_NQUEUES CONFIG_SMP_NCPUS
+#else
+#  define LPWORK_NQUEUES 1
+#endif
+
+/* The per-CPU queue that holds a work structure */
+
+#ifdef CONFIG_SCHED_LPWORKPERCPU
+#  define WORK_CPU(w) ((w)->cpu)
+#else
+#  define WORK_CPU(w) 0
+#endif
+
 /****************************************************************************
  * Public Type Definitions
  ****************************************************************************/
@@ -67,15 +89,37 @@
 struct kworker_s
 {
   pid_t             pid;    /* The task ID of the worker thread */
-  volatile bool     busy;   /* True: Worker is not available */
 };
 
-/* This structure defines the state of one kernel-mode work queue */
+/* This structure defines the state of one kernel-mode work queue.
+ *
+ * Work that is ready to run is kept in the FIFO 'q'.  Work queued with a
+ * non-zero delay is kept in 'delayed', ordered by the time that it becomes
+ * ready, and 'timer' is armed for the earliest of those times.  Idle worker
+ * threads wait on 'sem', which is posted once for each idle worker that is
+ * needed, either by work_queue() or by that timer; there is no polling.
+ *
+ * In the SMP case, the lists are protected by the per-queue spinlock so
+ * that CPUs using different queues do not contend for the critical
+ * section.
+ */
 
 struct kwork_wqueue_s
 {
-  systime_t         delay;     /* Delay between polling cycles (ticks) */
-  struct dq_queue_s q;         /* The queue of pending work */
+  struct dq_queue_s q;         /* The FIFO of work that is ready to run */
+  struct dq_queue_s delayed;   /* Delayed work, ordered by deadline */
+  struct wdog_s     timer;     /* Expires at the earliest deadline */
+  sem_t             sem;       /* Posted to wake up an idle worker */
+#ifdef CONFIG_SMP
+  spinlock_t        lock;      /* Protects the work queue */
+#endif
+  uint8_t           qid;       /* HPWORK or LPWORK */
+  uint8_t           cpu;       /* Index of the per-CPU queue */
+  uint8_t           nidle;     /* Number of idle workers not yet posted */
+  uint16_t          npending;  /* Number of work items queued */
+#ifdef CONFIG_SCHED_WORKSTATS
+  struct work_stats_s stats;   /* Queue statistics */
+#endif
   struct kworker_s  worker[1]; /* Describes a worker thread */
 };
 
@@ -86,21 +130,45 @@ struct kwork_wqueue_s
 #ifdef CONFIG_SCHED_HPWORK
 struct hp_wqueue_s
 {
-  systime_t         delay;     /* Delay between polling cycles (ticks) */
-  struct dq_queue_s q;         /* The queue of pending work */
+  struct dq_queue_s q;         /* The FIFO of work that is ready to run */
+  struct dq_queue_s delayed;   /* Delayed work, ordered by deadline */
+  struct wdog_s     timer;     /* Expires at the earliest deadline */
+  sem_t             sem;       /* Posted to wake up an idle worker */
+#ifdef CONFIG_SMP
+  spinlock_t        lock;      /* Protects the work queue */
+#endif
+  uint8_t           qid;       /* HPWORK or LPWORK */
+  uint8_t           cpu;       /* Index of the per-CPU queue */
+  uint8_t           nidle;     /* Number of idle workers not yet posted */
+  uint16_t          npending;  /* Number of work items queued */
+#ifdef CONFIG_SCHED_WORKSTATS
+  struct work_stats_s stats;   /* Queue statistics */
+#endif
   struct kworker_s  worker[1]; /* Describes the single high priority worker */
 };
 #endif
 
-/* This structure defines the state of one high-priority work queue.  This
+/* This structure defines the state of one low-priority work queue.  This
  * structure must be cast compatible with kwork_wqueue_s
  */
 
 #ifdef CONFIG_SCHED_LPWORK
 struct lp_wqueue_s
 {
-  systime_t         delay;  /* Delay between polling cycles (ticks) */
-  struct dq_queue_s q;      /* The queue of pending work */
+  struct dq_queue_s q;         /* The FIFO of work that is ready to run */
+  struct dq_queue_s delayed;   /* Delayed work, ordered by deadline */
+  struct wdog_s     timer;     /* Expires at the earliest deadline */
+  sem_t             sem;       /* Posted to wake up an idle worker */
+#ifdef CONFIG_SMP
+  spinlock_t        lock;      /* Protects the work queue */
+#endif
+  uint8_t           qid;       /* HPWORK or LPWORK */
+  uint8_t           cpu;       /* Index of the per-CPU queue */
+  uint8_t           nidle;     /* Number of idle workers not yet posted */
+  uint16_t          npending;  /* Number of work items queued */
+#ifdef CONFIG_SCHED_WORKSTATS
+  struct work_stats_s stats;   /* Queue statistics */
+#endif
 
   /* Describes each thread in the low priority queue's thread pool */
 
@@ -119,9 +187,11 @@ extern struct hp_wqueue_s g_hpwork;
 #endif
 
 #ifdef CONFIG_SCHED_LPWORK
-/* The state of the kernel mode, low priority work queue(s). */
+/* The state of the kernel mode, low priority work queue(s).  There is one
+ * queue per CPU with CONFIG_SCHED_LPWORKPERCPU.
+ */
 
-extern struct lp_wqueue_s g_lpwork;
+extern struct lp_wqueue_s g_lpwork[LPWORK_NQUEUES];
 #endif
 
 /****************************************************************************
@@ -166,6 +236,97 @@ int work_hpstart(void);
 int work_lpstart(void);
 #endif
 
+/****************************************************************************
+ * Name: work_initialize
+ *
+ * Description:
+ *   Initialize the state of one kernel-mode work queue.
+ *
+ * Input parameters:
+ *   wqueue - Describes the work queue to be initialized
+ *   size   - The size of the work queue structure
+ *   qid    - The work queue ID
+ *   cpu    - The index of the per-CPU queue
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void work_initialize(FAR struct kwork_wqueue_s *wqueue, size_t size,
+                     int qid, int cpu);
+
+/****************************************************************************
+ * Name: work_lock and work_unlock
+ *
+ * Description:
+ *   Get and release exclusive access to the lists of a work queue.  Lock
+ *   ordering:  The critical section may be held when the work queue lock
+ *   is taken, but the critical section must not be entered (including
+ *   implicitly, by clock_systimer() or wd_start() for example) while the
+ *   work queue lock is held.
+ *
+ ****************************************************************************/
+
+irqstate_t work_lock(FAR struct kwork_wqueue_s *wqueue);
+void work_unlock(FAR struct kwork_wqueue_s *wqueue, irqstate_t flags);
+
+/****************************************************************************
+ * Name: work_timer
+ *
+ * Description:
+ *   Arm the work queue timer for the deadline of the first delayed work,
+ *   or cancel the timer if there is no delayed work.  Must be called
+ *   without the work queue lock held.
+ *
+ * Input parameters:
+ *   wqueue - Describes the work queue
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void work_timer(FAR struct kwork_wqueue_s *wqueue);
+
+/****************************************************************************
+ * Name: work_wakeup
+ *
+ * Description:
+ *   Wake up one idle worker of the work queue.  With
+ *   CONFIG_SCHED_LPWORKPERCPU, if 'steal' is true and the low priority
+ *   queue has no idle worker, an idle worker of another CPU's queue is
+ *   awakened instead so that it may take the work.  Must be called
+ *   without the work queue lock held.
+ *
+ * Input parameters:
+ *   wqueue - Describes the work queue
+ *   steal  - True: Ready work on the queue may be taken by other CPUs
+ *
+ * Returned Value:
+ *   None
+ *
+ ****************************************************************************/
+
+void work_wakeup(FAR struct kwork_wqueue_s *wqueue, bool steal);
+
+/****************************************************************************
+ * Name: work_qcancel
+ *
+ * Description:
+ *   Remove work from the work queue that holds it, if it is queued.
+ *
+ * Input parameters:
+ *   qid    - The work queue ID
+ *   work   - The work to remove
+ *
+ * Returned Value:
+ *   True if the work was queued and has been removed.
+ *
+ ****************************************************************************/
+
+bool work_qcancel(int qid, FAR struct work_s *work);
+
 /****************************************************************************
  * Name: work_process
  *
@@ -175,17 +336,18 @@ int work_lpstart(void);
  *   part of the internal implementation of each work queue; it should not
  *   be called from application level logic.
  *
+ *   All work that is ready is performed, then the worker thread waits until
+ *   it is awakened for more work.
+ *
  * Input parameters:
  *   wqueue - Describes the work queue to be processed
- *   period - The polling period in clock ticks
- *   wndx   - The worker thread index
  *
  * Returned Value:
  *   None
  *
  ****************************************************************************/
 
-void work_process(FAR struct kwork_wqueue_s *wqueue, systime_t period, int wndx);
+void work_process(FAR struct kwork_wqueue_s *wqueue);
 
 #endif /* CONFIG_SCHED_WORKQUEUE */
 #endif /* __SCHED_WQUEUE_WQUEUE_H */
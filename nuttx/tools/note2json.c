@@ -0,0 +1,397 @@
+/****************************************************************************
+ * tools/note2json.c
+ *
+ *   Copyright (C) 2017 Gregory Nutt. All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in
+ *    the documentation and/or other materials provided with the
+ *    distribution.
+ * 3. Neither the name NuttX nor the names of its contributors may be
+ *    used to endorse or promote products derived from this software
+ *    without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS
+ * FOR A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT OWNER OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING,
+ * BUT NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS
+ * OF USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED
+ * AND ON ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT
+ * LIABILITY, OR TORT (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN
+ * ANY WAY OUT OF THE USE OF THIS SOFTWARE, EVEN IF ADVISED OF THE
+ * POSSIBILITY OF SUCH DAMAGE.
+ *
+ ****************************************************************************/
+
+/****************************************************************************
+ * Included Files
+ ****************************************************************************/
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <unistd.h>
+
+/****************************************************************************
+ * Pre-processor Definitions
+ ****************************************************************************/
+
+#define MAX_NOTE   256
+#define MAX_CPUS   32
+#define MAX_PIDS   65536
+#define NAME_SIZE  32
+
+/* A name escaped for JSON.  Each character takes at most 6 bytes (\u00XX) */
+
+#define JSON_NAME_SIZE (6 * NAME_SIZE)
+
+/* Note types.  These must agree with enum note_type_e in
+ * include/nuttx/sched_note.h
+ */
+
+#define NOTE_START           0
+#define NOTE_STOP            1
+#define NOTE_SUSPEND         2
+#define NOTE_RESUME          3
+#define NOTE_CPU_START       4
+#define NOTE_CPU_STARTED     5
+#define NOTE_CPU_PAUSE       6
+#define NOTE_CPU_PAUSED      7
+#define NOTE_CPU_RESUME      8
+#define NOTE_CPU_RESUMED     9
+#define NOTE_PREEMPT_LOCK    10
+#define NOTE_PREEMPT_UNLOCK  11
+#define NOTE_CSECTION_ENTER  12
+#define NOTE_CSECTION_LEAVE  13
+#define NOTE_SPINLOCK_LOCK   14
+#define NOTE_SPINLOCK_LOCKED 15
+#define NOTE_SPINLOCK_UNLOCK 16
+#define NOTE_SPINLOCK_ABORT  17
+#define NTYPES               18
+
+/****************************************************************************
+ * Private Data
+ ****************************************************************************/
+
+static const char *g_noteid[NTYPES] =
+{
+  "start", "stop", "suspend", "resume",
+  "cpu_start", "cpu_started", "cpu_pause", "cpu_paused", "cpu_resume",
+  "cpu_resumed", "preempt_lock", "preempt_unlock", "csection_enter",
+  "csection_leave", "spinlock_lock", "spinlock_locked", "spinlock_unlock",
+  "spinlock_abort"
+};
+
+static bool g_smp;                    /* Notes include the CPU number */
+static bool g_hires;                  /* Notes have sec/nsec time stamps */
+static unsigned long g_usecpertick = 10000;
+static char g_names[MAX_PIDS][NAME_SIZE];
+static int g_running[MAX_CPUS];       /* PID running on each CPU (or -1) */
+static bool g_first = true;
+
+/****************************************************************************
+ * Private Functions
+ ****************************************************************************/
+
+static void show_usage(const char *progname, int exitcode)
+{
+  fprintf(stderr, "USAGE: %s [-s] [-r] [-t <usec>] [-o <outfile>] <infile>\n",
+          progname);
+  fprintf(stderr, "       %s -h\n\n", progname);
+  fprintf(stderr, "Convert the binary note stream read from /dev/note into\n");
+  fprintf(stderr, "the JSON Trace Event Format (chrome://tracing, Perfetto)\n\n");
+  fprintf(stderr, "Where:\n");
+  fprintf(stderr, "  -s           : Notes include the CPU (CONFIG_SMP=y)\n");
+  fprintf(stderr, "  -r           : Notes have high resolution time stamps\n");
+  fprintf(stderr, "                 (CONFIG_SCHED_INSTRUMENTATION_HIRES=y)\n");
+  fprintf(stderr, "  -t <usec>    : Microseconds per system timer tick.\n");
+  fprintf(stderr, "                 Default: 10000\n");
+  fprintf(stderr, "  -o <outfile> : Send output to <outfile>.  Default: stdout\n");
+  fprintf(stderr, "  -h           : Show this message and exit\n");
+  exit(exitcode);
+}
+
+static uint32_t get32(const uint8_t *ptr)
+{
+  return (uint32_t)ptr[0] | (uint32_t)ptr[1] << 8 |
+         (uint32_t)ptr[2] << 16 | (uint32_t)ptr[3] << 24;
+}
+
+static void json_escape(char *dest, const char *src)
+{
+  unsigned char ch;
+
+  while ((ch = (unsigned char)*src++) != '\0')
+    {
+      if (ch == '"' || ch == '\\')
+        {
+          *dest++ = '\\';
+          *dest++ = (char)ch;
+        }
+      else if (ch < 0x20 || ch >= 0x7f)
+        {
+          sprintf(dest, "\\u%04x", ch);
+          dest += 6;
+        }
+      else
+        {
+          *dest++ = (char)ch;
+        }
+    }
+
+  *dest = '\0';
+}
+
+static const char *task_name(int pid)
+{
+  static char buffer[JSON_NAME_SIZE];
+
+  if (g_names[pid][0] != '\0')
+    {
+      /* Task names are arbitrary strings.  Escape them for JSON. */
+
+      json_escape(buffer, g_names[pid]);
+      return buffer;
+    }
+
+  snprintf(buffer, JSON_NAME_SIZE, "pid %d", pid);
+  return buffer;
+}
+
+static void emit(FILE *out, const char *fmt, ...)
+  __attribute__((format(printf, 2, 3)));
+
+static void emit(FILE *out, const char *fmt, ...)
+{
+  va_list ap;
+
+  fputs(g_first ? "\n  " : ",\n  ", out);
+  g_first = false;
+
+  va_start(ap, fmt);
+  vfprintf(out, fmt, ap);
+  va_end(ap);
+}
+
+static void emit_begin(FILE *out, double ts, int cpu, int pid)
+{
+  emit(out, "{\"name\":\"%s\",\"ph\":\"B\",\"ts\":%.3f,\"pid\":0,"
+       "\"tid\":%d,\"args\":{\"pid\":%d}}",
+       task_name(pid), ts, cpu, pid);
+  g_running[cpu] = pid;
+}
+
+static void emit_end(FILE *out, double ts, int cpu)
+{
+  if (g_running[cpu] >= 0)
+    {
+      emit(out, "{\"name\":\"%s\",\"ph\":\"E\",\"ts\":%.3f,\"pid\":0,"
+           "\"tid\":%d}",
+           task_name(g_running[cpu]), ts, cpu);
+      g_running[cpu] = -1;
+    }
+}
+
+static void emit_instant(FILE *out, double ts, int cpu, int pid,
+                         const char *name)
+{
+  emit(out, "{\"name\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,"
+       "\"pid\":0,\"tid\":%d,\"args\":{\"pid\":%d}}",
+       name, ts, cpu, pid);
+}
+
+/****************************************************************************
+ * Public Functions
+ ****************************************************************************/
+
+int main(int argc, char **argv)
+{
+  const char *outfile = NULL;
+  FILE *in;
+  FILE *out;
+  uint8_t note[MAX_NOTE];
+  unsigned int hdrlen;
+  unsigned int len;
+  unsigned int type;
+  double ts;
+  int maxcpu = 0;
+  int cpu;
+  int pid;
+  int ch;
+
+  while ((ch = getopt(argc, argv, ":srt:o:h")) > 0)
+    {
+      switch (ch)
+        {
+          case 's':
+            g_smp = true;
+            break;
+
+          case 'r':
+            g_hires = true;
+            break;
+
+          case 't':
+            g_usecpertick = strtoul(optarg, NULL, 0);
+            break;
+
+          case 'o':
+            outfile = optarg;
+            break;
+
+          case 'h':
+            show_usage(argv[0], EXIT_SUCCESS);
+
+          default:
+            fprintf(stderr, "ERROR: Unrecognized option\n");
+            show_usage(argv[0], EXIT_FAILURE);
+        }
+    }
+
+  if (optind != argc - 1)
+    {
+      fprintf(stderr, "ERROR: Missing <infile>\n");
+      show_usage(argv[0], EXIT_FAILURE);
+    }
+
+  in = fopen(argv[optind], "rb");
+  if (in == NULL)
+    {
+      fprintf(stderr, "ERROR: Failed to open %s\n", argv[optind]);
+      return EXIT_FAILURE;
+    }
+
+  out = stdout;
+  if (outfile != NULL)
+    {
+      out = fopen(outfile, "w");
+      if (out == NULL)
+        {
+          fprintf(stderr, "ERROR: Failed to open %s\n", outfile);
+          fclose(in);
+          return EXIT_FAILURE;
+        }
+    }
+
+  for (cpu = 0; cpu < MAX_CPUS; cpu++)
+    {
+      g_running[cpu] = -1;
+    }
+
+  /* The common note header is:  length, type, priority, [cpu,] pid[2],
+   * then either systime[4] or systime_sec[4] + systime_nsec[4].
+   */
+
+  hdrlen = 5 + (g_smp ? 1 : 0) + (g_hires ? 8 : 4);
+
+  fputs("{\"traceEvents\":[", out);
+
+  while ((ch = fgetc(in)) != EOF)
+    {
+      /* Read the rest of the note */
+
+      len = (unsigned int)ch;
+      if (len < hdrlen)
+        {
+          fprintf(stderr, "ERROR: Bad note length %u\n", len);
+          break;
+        }
+
+      note[0] = (uint8_t)len;
+      if (fread(&note[1], 1, len - 1, in) != len - 1)
+        {
+          fprintf(stderr, "ERROR: Truncated note\n");
+          break;
+        }
+
+      /* Decode the common header */
+
+      type = note[1];
+      cpu  = g_smp ? note[3] : 0;
+      pid  = (int)note[3 + (g_smp ? 1 : 0)] |
+             (int)note[4 + (g_smp ? 1 : 0)] << 8;
+
+      if (cpu >= MAX_CPUS)
+        {
+          fprintf(stderr, "ERROR: Bad CPU %d\n", cpu);
+          break;
+        }
+
+      if (cpu > maxcpu)
+        {
+          maxcpu = cpu;
+        }
+
+      if (g_hires)
+        {
+          ts = (double)get32(&note[hdrlen - 8]) * 1e6 +
+               (double)get32(&note[hdrlen - 4]) / 1e3;
+        }
+      else
+        {
+          ts = (double)get32(&note[hdrlen - 4]) * (double)g_usecpertick;
+        }
+
+      switch (type)
+        {
+          case NOTE_START:
+            if (len > hdrlen)
+              {
+                note[len - 1] = '\0';
+                strncpy(g_names[pid], (const char *)&note[hdrlen],
+                        NAME_SIZE - 1);
+              }
+
+            emit_instant(out, ts, cpu, pid, g_noteid[type]);
+            break;
+
+          case NOTE_STOP:
+          case NOTE_SUSPEND:
+            if (g_running[cpu] == pid)
+              {
+                emit_end(out, ts, cpu);
+              }
+            break;
+
+          case NOTE_RESUME:
+            emit_end(out, ts, cpu);
+            emit_begin(out, ts, cpu, pid);
+            break;
+
+          default:
+            emit_instant(out, ts, cpu, pid,
+                         type < NTYPES ? g_noteid[type] : "unknown");
+            break;
+        }
+    }
+
+  /* Name the per-CPU tracks */
+
+  for (cpu = 0; cpu <= maxcpu; cpu++)
+    {
+      emit(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,"
+           "\"tid\":%d,\"args\":{\"name\":\"CPU%d\"}}", cpu, cpu);
+    }
+
+  fputs("\n]}\n", out);
+
+  fclose(in);
+  if (out != stdout)
+    {
+      fclose(out);
+    }
+
+  return EXIT_SUCCESS;
+}